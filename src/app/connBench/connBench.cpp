@@ -0,0 +1,395 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // printf, fprintf, snprintf
+#include <stdlib.h>                                            // atoi, exit, calloc
+#include <string.h>                                            // strcmp, strstr, strerror, memmove
+#include <strings.h>                                           // strncasecmp
+#include <unistd.h>                                            // close, read, write
+#include <errno.h>                                             // errno
+#include <fcntl.h>                                             // fcntl, O_NONBLOCK
+#include <time.h>                                              // clock_gettime
+#include <netdb.h>                                             // gethostbyname
+#include <netinet/in.h>                                        // sockaddr_in
+#include <netinet/tcp.h>                                       // TCP_NODELAY
+#include <sys/socket.h>                                        // socket, connect
+#include <sys/epoll.h>                                         // epoll_*
+#include <sys/resource.h>                                      // setrlimit
+
+#include <vector>                                              // std::vector
+#include <algorithm>                                           // std::sort
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Connection scaling benchmark for the REST interface of the broker
+//
+// Opens N keep-alive connections to the broker and keeps them all busy, one request in flight per connection,
+// for a number of seconds. Reports connect errors, throughput, latency and, if the pid of the broker is given,
+// the number of threads and the memory (VmRSS) of the broker, idle (all connections open) and under load.
+//
+// Usage: connBench [-host <host>] [-port <port>] [-connections <n>] [-seconds <s>] [-path <url path>] [-pid <broker pid>]
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Connection -
+//
+typedef struct Connection
+{
+  int     fd;
+  char    buf[8192];
+  int     bufLen;
+  double  sentAt;
+} Connection;
+
+
+
+static const char*              host        = "localhost";
+static unsigned short           port        = 1026;
+static int                      connections = 10000;
+static int                      seconds     = 10;
+static const char*              path        = "/ngsi-ld/ex/v1/ping";
+static int                      brokerPid   = 0;
+static char                     request[1024];
+static int                      requestLen;
+static std::vector<float>       latencyV;    // Microseconds
+static unsigned long long       errors      = 0;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// now -
+//
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ((double) ts.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// brokerStatus - threads and VmRSS of the broker, from /proc/<pid>/status
+//
+static void brokerStatus(const char* when)
+{
+  char  procPath[64];
+  char  line[256];
+  FILE* fP;
+
+  if (brokerPid == 0)
+    return;
+
+  snprintf(procPath, sizeof(procPath), "/proc/%d/status", brokerPid);
+  if ((fP = fopen(procPath, "r")) == NULL)
+  {
+    fprintf(stderr, "unable to open %s: %s\n", procPath, strerror(errno));
+    return;
+  }
+
+  printf("Broker %-12s", when);
+  while (fgets(line, sizeof(line), fP) != NULL)
+  {
+    if ((strncmp(line, "Threads:", 8) == 0) || (strncmp(line, "VmRSS:", 6) == 0))
+    {
+      line[strlen(line) - 1] = 0;
+      printf("  %s", line);
+    }
+  }
+  printf("\n");
+
+  fclose(fP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// serverConnect -
+//
+static int serverConnect(struct sockaddr_in* serverP)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (fd == -1)
+    return -1;
+
+  if (connect(fd, (struct sockaddr*) serverP, sizeof(struct sockaddr_in)) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  return fd;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestSend -
+//
+static bool requestSend(Connection* cP)
+{
+  cP->bufLen = 0;
+  cP->sentAt = now();
+
+  return (write(cP->fd, request, requestLen) == requestLen);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// responseComplete - has the entire response been read?
+//
+// The broker always responds with a Content-Length header.
+//
+static bool responseComplete(Connection* cP)
+{
+  char* endOfHeaders = strstr(cP->buf, "\r\n\r\n");
+
+  if (endOfHeaders == NULL)
+    return false;
+
+  int   contentLength = 0;
+  char* lineP         = strstr(cP->buf, "\r\n");
+
+  while ((lineP != NULL) && (lineP < endOfHeaders))
+  {
+    lineP += 2;
+    if (strncasecmp(lineP, "Content-Length:", 15) == 0)
+    {
+      contentLength = atoi(&lineP[15]);
+      break;
+    }
+    lineP = strstr(lineP, "\r\n");
+  }
+
+  int headersLen = (endOfHeaders - cP->buf) + 4;
+
+  return (cP->bufLen >= headersLen + contentLength);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  for (int ix = 1; ix < argC - 1; ix += 2)
+  {
+    if      (strcmp(argV[ix], "-host")        == 0)  host        = argV[ix + 1];
+    else if (strcmp(argV[ix], "-port")        == 0)  port        = atoi(argV[ix + 1]);
+    else if (strcmp(argV[ix], "-connections") == 0)  connections = atoi(argV[ix + 1]);
+    else if (strcmp(argV[ix], "-seconds")     == 0)  seconds     = atoi(argV[ix + 1]);
+    else if (strcmp(argV[ix], "-path")        == 0)  path        = argV[ix + 1];
+    else if (strcmp(argV[ix], "-pid")         == 0)  brokerPid   = atoi(argV[ix + 1]);
+    else
+    {
+      fprintf(stderr, "Usage: %s [-host <host>] [-port <port>] [-connections <n>] [-seconds <s>] [-path <url path>] [-pid <broker pid>]\n", argV[0]);
+      exit(1);
+    }
+  }
+
+  //
+  // A file descriptor per connection
+  //
+  struct rlimit rl;
+  rl.rlim_cur = connections + 64;
+  rl.rlim_max = connections + 64;
+  if (setrlimit(RLIMIT_NOFILE, &rl) != 0)
+    fprintf(stderr, "unable to raise the max number of file descriptors to %d: %s (ulimit -n)\n", connections + 64, strerror(errno));
+
+  requestLen = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s:%d\r\nAccept: application/json\r\n\r\n", path, host, port);
+
+  struct hostent* heP = gethostbyname(host);
+  if (heP == NULL)
+  {
+    fprintf(stderr, "unable to find host '%s'\n", host);
+    exit(1);
+  }
+
+  struct sockaddr_in server;
+  bzero(&server, sizeof(server));
+  server.sin_family = AF_INET;
+  server.sin_port   = htons(port);
+  server.sin_addr   = *((struct in_addr*) heP->h_addr);
+
+  //
+  // Open all connections
+  //
+  Connection* connV   = (Connection*) calloc(connections, sizeof(Connection));
+  int         epollFd = epoll_create1(0);
+  int         opened  = 0;
+  double      start   = now();
+
+  if ((connV == NULL) || (epollFd == -1))
+  {
+    fprintf(stderr, "unable to allocate %d connections\n", connections);
+    exit(1);
+  }
+
+  for (int ix = 0; ix < connections; ix++)
+  {
+    int fd = serverConnect(&server);
+
+    if (fd == -1)
+    {
+      fprintf(stderr, "connect %d failed: %s\n", ix, strerror(errno));
+      break;
+    }
+
+    Connection*         cP = &connV[opened++];
+    struct epoll_event  event;
+
+    cP->fd         = fd;
+    event.events   = EPOLLIN;
+    event.data.ptr = cP;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+  }
+
+  printf("Connections: %d of %d open in %.2f seconds\n", opened, connections, now() - start);
+  if (opened == 0)
+    exit(1);
+
+  //
+  // Keep-alive connections are idle until used - give the broker a second to settle
+  //
+  sleep(1);
+  brokerStatus("idle:");
+
+  //
+  // Load - one request in flight per connection
+  //
+  for (int ix = 0; ix < opened; ix++)
+  {
+    if (requestSend(&connV[ix]) == false)
+      ++errors;
+  }
+
+  struct epoll_event  eventV[1024];
+  double              end         = now() + seconds;
+  int                 inFlight    = opened;
+  bool                statusShown = false;
+
+  start = now();
+  while (inFlight > 0)
+  {
+    int events = epoll_wait(epollFd, eventV, 1024, 1000);
+
+    if ((statusShown == false) && (now() > start + seconds / 2.0))
+    {
+      brokerStatus("under load:");
+      statusShown = true;
+    }
+
+    for (int eIx = 0; eIx < events; eIx++)
+    {
+      Connection* cP = (Connection*) eventV[eIx].data.ptr;
+      int         n  = read(cP->fd, &cP->buf[cP->bufLen], sizeof(cP->buf) - cP->bufLen - 1);
+
+      if (n <= 0)
+      {
+        if ((n == -1) && (errno == EAGAIN))
+          continue;
+
+        // Connection closed by the broker
+        ++errors;
+        --inFlight;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, cP->fd, NULL);
+        close(cP->fd);
+        cP->fd = -1;
+        continue;
+      }
+
+      cP->bufLen += n;
+      cP->buf[cP->bufLen] = 0;
+
+      if ((responseComplete(cP) == false) && (cP->bufLen < (int) sizeof(cP->buf) - 1))
+        continue;
+
+      double t = now();
+
+      if (strncmp(cP->buf, "HTTP/1.1 200", 12) != 0)
+        ++errors;
+
+      latencyV.push_back((t - cP->sentAt) * 1000000);
+
+      if (t >= end)
+        --inFlight;
+      else if (requestSend(cP) == false)
+      {
+        ++errors;
+        --inFlight;
+      }
+    }
+
+    if ((events == 0) && (now() > end + 10))
+    {
+      fprintf(stderr, "%d requests without response after 10 seconds\n", inFlight);
+      break;
+    }
+  }
+
+  double elapsed = now() - start;
+
+  //
+  // Report
+  //
+  if (latencyV.size() == 0)
+  {
+    printf("No responses\n");
+    exit(1);
+  }
+
+  std::sort(latencyV.begin(), latencyV.end());
+
+  size_t responses = latencyV.size();
+  printf("Requests:    %zu responses in %.2f seconds (%.0f requests/second), %llu errors\n", responses, elapsed, responses / elapsed, errors);
+  printf("Latency:     p50 %.0f us, p90 %.0f us, p99 %.0f us, max %.0f us\n",
+         latencyV[responses / 2], latencyV[responses * 9 / 10], latencyV[responses * 99 / 100], latencyV[responses - 1]);
+
+  for (int ix = 0; ix < opened; ix++)
+  {
+    if (connV[ix].fd != -1)
+      close(connV[ix].fd);
+  }
+
+  return 0;
+}
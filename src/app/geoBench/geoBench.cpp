@@ -0,0 +1,410 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // printf, fprintf
+#include <stdlib.h>                                            // atoi, exit, rand_r
+#include <math.h>                                              // sin, cos, asin, sqrt
+#include <time.h>                                              // clock_gettime
+
+#include <vector>                                              // std::vector
+#include <algorithm>                                           // std::sort
+
+#include "common/GeoCellIndex.h"                               // GeoCellIndex
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Micro-benchmark of geofence matching for the subscription cache:
+//
+//   A fleet of vehicles moves around and every position update is matched against all geofences
+//   (geo-subscriptions) - once checking each and every geofence (what the broker did before the spatial index),
+//   once checking only the candidates found in a GeoCellIndex (what subCacheMatch does now).
+//
+// Usage: geoBench [geofences] [updates]
+//
+// The geofences are circles ('near' with maxDistance) and rectangles ('coveredBy' a box) spread over
+// western Europe. Before measuring, both methods are run over a part of the updates and their results compared.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EARTH_RADIUS_METERS - same as in common/globals.h (not included here, to keep the benchmark free of the broker libs)
+//
+#define EARTH_RADIUS_METERS  6371000
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Region of the fleet and the geofences, degrees
+//
+#define REGION_MIN_LON  -10.0
+#define REGION_MAX_LON   30.0
+#define REGION_MIN_LAT   36.0
+#define REGION_MAX_LAT   60.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Geofence - a circle (radius > 0) or a rectangle
+//
+typedef struct Geofence
+{
+  double  lon;      // center of the circle / lower left corner of the rectangle
+  double  lat;
+  double  radius;   // meters, 0 for rectangles
+  double  width;    // degrees of longitude, rectangles only
+  double  height;   // degrees of latitude, rectangles only
+  double  minLon;   // bounding box
+  double  minLat;
+  double  maxLon;
+  double  maxLat;
+} Geofence;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Vehicle - position of a vehicle of the fleet
+//
+typedef struct Vehicle
+{
+  double  lon;
+  double  lat;
+} Vehicle;
+
+
+
+static unsigned int seed = 4711;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// rnd - uniform random number in [min, max]
+//
+static double rnd(double min, double max)
+{
+  return min + (max - min) * ((double) rand_r(&seed) / RAND_MAX);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nowNs -
+//
+static long long nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// haversine - great-circle distance in meters (same formula as in rest/GeoFilter.cpp)
+//
+static double haversine(double lon1, double lat1, double lon2, double lat2)
+{
+  double rLat1 = lat1 * M_PI / 180;
+  double rLat2 = lat2 * M_PI / 180;
+  double dLat  = rLat2 - rLat1;
+  double dLon  = (lon2 - lon1) * M_PI / 180;
+  double h     = sin(dLat / 2) * sin(dLat / 2) + cos(rLat1) * cos(rLat2) * sin(dLon / 2) * sin(dLon / 2);
+
+  return 2 * EARTH_RADIUS_METERS * asin(sqrt(fmin(1.0, h)));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geofenceCreate - random circle (50 m to 2 km) or rectangle (some 100 m to 5 km)
+//
+// The bounding box of a circle is computed like in GeoFilter::bboxGet
+//
+static void geofenceCreate(Geofence* gfP)
+{
+  gfP->lon = rnd(REGION_MIN_LON, REGION_MAX_LON);
+  gfP->lat = rnd(REGION_MIN_LAT, REGION_MAX_LAT);
+
+  if (rnd(0, 1) < 0.8)
+  {
+    double dLat;
+    double dLon;
+
+    gfP->radius = rnd(50, 2000);
+    gfP->width  = 0;
+    gfP->height = 0;
+
+    dLat = gfP->radius / EARTH_RADIUS_METERS * 180 / M_PI;
+    dLon = dLat / cos((fabs(gfP->lat) + dLat) * M_PI / 180);
+
+    gfP->minLon = gfP->lon - dLon;
+    gfP->maxLon = gfP->lon + dLon;
+    gfP->minLat = gfP->lat - dLat;
+    gfP->maxLat = gfP->lat + dLat;
+  }
+  else
+  {
+    gfP->radius = 0;
+    gfP->width  = rnd(0.001, 0.05);
+    gfP->height = rnd(0.001, 0.05);
+    gfP->minLon = gfP->lon;
+    gfP->maxLon = gfP->lon + gfP->width;
+    gfP->minLat = gfP->lat;
+    gfP->maxLat = gfP->lat + gfP->height;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geofenceMatch - the exact check
+//
+static inline bool geofenceMatch(const Geofence* gfP, const Vehicle* vP)
+{
+  if (gfP->radius > 0)
+    return haversine(gfP->lon, gfP->lat, vP->lon, vP->lat) <= gfP->radius;
+
+  return (vP->lon >= gfP->minLon) && (vP->lon <= gfP->maxLon) && (vP->lat >= gfP->minLat) && (vP->lat <= gfP->maxLat);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// linearMatch - each and every geofence is checked
+//
+static void linearMatch(const std::vector<Geofence>& geofenceV, const Vehicle* vP, std::vector<int>* matchV)
+{
+  for (unsigned int ix = 0; ix < geofenceV.size(); ix++)
+  {
+    if (geofenceMatch(&geofenceV[ix], vP))
+      matchV->push_back(ix);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexMatch - only the candidates of the spatial index are checked
+//
+static void indexMatch
+(
+  const GeoCellIndex<int>&      index,
+  const std::vector<Geofence>&  geofenceV,
+  const Vehicle*                vP,
+  std::vector<int>*             candidateV,
+  std::vector<int>*             matchV
+)
+{
+  candidateV->clear();
+  index.lookup(vP->lon, vP->lat, vP->lon, vP->lat, candidateV);
+
+  for (unsigned int ix = 0; ix < candidateV->size(); ix++)
+  {
+    int gfIx = (*candidateV)[ix];
+
+    if (geofenceMatch(&geofenceV[gfIx], vP))
+      matchV->push_back(gfIx);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// vehicleMove - some 10 to 30 meters in a random direction, staying in the region
+//
+static void vehicleMove(Vehicle* vP)
+{
+  double meters  = rnd(10, 30);
+  double angle   = rnd(0, 2 * M_PI);
+  double dLat    = meters * sin(angle) / EARTH_RADIUS_METERS * 180 / M_PI;
+  double dLon    = meters * cos(angle) / EARTH_RADIUS_METERS * 180 / M_PI / cos(vP->lat * M_PI / 180);
+
+  vP->lon = fmin(REGION_MAX_LON, fmax(REGION_MIN_LON, vP->lon + dLon));
+  vP->lat = fmin(REGION_MAX_LAT, fmax(REGION_MIN_LAT, vP->lat + dLat));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  int                    geofences = (argC > 1)? atoi(argV[1]) : 100000;
+  int                    updates   = (argC > 2)? atoi(argV[2]) : 100000;
+  int                    vehicles  = 1000;
+  std::vector<Geofence>  geofenceV(geofences);
+  std::vector<Vehicle>   vehicleV(vehicles);
+  GeoCellIndex<int>      index;
+  long long              start;
+
+  //
+  // Geofences and index
+  //
+  for (int ix = 0; ix < geofences; ix++)
+  {
+    geofenceCreate(&geofenceV[ix]);
+  }
+
+  start = nowNs();
+  for (int ix = 0; ix < geofences; ix++)
+  {
+    Geofence* gfP = &geofenceV[ix];
+
+    index.insert(ix, gfP->minLon, gfP->minLat, gfP->maxLon, gfP->maxLat);
+  }
+  long long insertNs = nowNs() - start;
+
+  printf("%d geofences, %d vehicles, %d position updates\n\n", geofences, vehicles, updates);
+  printf("Index build:       %8.1f ms (%6.1f ns/geofence)\n", (double) insertNs / 1000000, (double) insertNs / geofences);
+
+  //
+  // The fleet - half of the vehicles start inside a geofence, so there are matches
+  //
+  for (int ix = 0; ix < vehicles; ix++)
+  {
+    if (ix % 2 == 0)
+    {
+      Geofence* gfP = &geofenceV[rand_r(&seed) % geofences];
+
+      vehicleV[ix].lon = (gfP->radius > 0)? gfP->lon : gfP->lon + gfP->width / 2;
+      vehicleV[ix].lat = (gfP->radius > 0)? gfP->lat : gfP->lat + gfP->height / 2;
+    }
+    else
+    {
+      vehicleV[ix].lon = rnd(REGION_MIN_LON, REGION_MAX_LON);
+      vehicleV[ix].lat = rnd(REGION_MIN_LAT, REGION_MAX_LAT);
+    }
+  }
+
+  //
+  // The stream of updates - precomputed, so that both methods see the same positions
+  //
+  std::vector<Vehicle> updateV(updates);
+
+  for (int ix = 0; ix < updates; ix++)
+  {
+    Vehicle* vP = &vehicleV[ix % vehicles];
+
+    vehicleMove(vP);
+    updateV[ix] = *vP;
+  }
+
+  //
+  // Both methods must find exactly the same geofences
+  //
+  std::vector<int>  candidateV;
+  std::vector<int>  linearV;
+  std::vector<int>  indexV;
+  int               checks = (updates < 1000)? updates : 1000;
+
+  for (int ix = 0; ix < checks; ix++)
+  {
+    linearV.clear();
+    indexV.clear();
+
+    linearMatch(geofenceV, &updateV[ix], &linearV);
+    indexMatch(index, geofenceV, &updateV[ix], &candidateV, &indexV);
+
+    std::sort(indexV.begin(), indexV.end());
+
+    if (linearV != indexV)
+    {
+      printf("DIFF for update %d (%f, %f): %d geofences linear, %d indexed\n", ix, updateV[ix].lon, updateV[ix].lat, (int) linearV.size(), (int) indexV.size());
+      exit(1);
+    }
+  }
+
+  //
+  // Linear - the broker before the spatial index (only a part of the updates if there are many, it's slow)
+  //
+  int        linearUpdates = (updates < 1000)? updates : 1000;
+  long long  linearMatches = 0;
+
+  start = nowNs();
+  for (int ix = 0; ix < linearUpdates; ix++)
+  {
+    linearV.clear();
+    linearMatch(geofenceV, &updateV[ix], &linearV);
+    linearMatches += linearV.size();
+  }
+  long long linearNs = nowNs() - start;
+
+  //
+  // Indexed
+  //
+  long long  indexMatches = 0;
+  long long  candidates   = 0;
+
+  start = nowNs();
+  for (int ix = 0; ix < updates; ix++)
+  {
+    indexV.clear();
+    indexMatch(index, geofenceV, &updateV[ix], &candidateV, &indexV);
+    indexMatches += indexV.size();
+    candidates   += candidateV.size();
+  }
+  long long indexNs = nowNs() - start;
+
+  printf("Linear scan:       %8.1f us/update  (%d updates, %.2f matches/update, %d checks/update)\n",
+         (double) linearNs / linearUpdates / 1000, linearUpdates, (double) linearMatches / linearUpdates, geofences);
+  printf("Spatial index:     %8.1f us/update  (%d updates, %.2f matches/update, %.2f checks/update)\n",
+         (double) indexNs / updates / 1000, updates, (double) indexMatches / updates, (double) candidates / updates);
+  printf("Speedup:           %8.1f x\n", ((double) linearNs / linearUpdates) / ((double) indexNs / updates));
+
+  //
+  // Churn - subscriptions come and go
+  //
+  int churn = (geofences < 10000)? geofences : 10000;
+
+  start = nowNs();
+  for (int ix = 0; ix < churn; ix++)
+  {
+    Geofence* gfP = &geofenceV[ix];
+
+    index.remove(ix);
+    index.insert(ix, gfP->minLon, gfP->minLat, gfP->maxLon, gfP->maxLat);
+  }
+  long long churnNs = nowNs() - start;
+
+  printf("Remove + insert:   %8.1f ns/geofence\n", (double) churnNs / churn);
+
+  return 0;
+}
@@ -126,6 +126,7 @@ extern "C"
 #include "orionld/socketService/socketServiceInit.h"          // socketServiceInit
 #include "orionld/socketService/socketServiceRun.h"           // socketServiceRun
 #include "orionld/troe/pgConnectionPoolsFree.h"               // pgConnectionPoolsFree
+#include "orionld/troe/troeWriterRelease.h"                   // troeWriterRelease
 #include "orionld/troe/pgConnectionPoolsPresent.h"            // pgConnectionPoolsPresent
 
 using namespace orion;
@@ -184,10 +185,18 @@ int             subCacheInterval;
 char            notificationMode[64];
 int             notificationQueueSize;
 int             notificationThreadNum;
+int             notifInFlight;
+int             notifTenantQuota;
 bool            noCache;
 unsigned int    connectionMemory;
 unsigned int    maxConnections;
 unsigned int    reqPoolSize;
+int             httpWorkers;
+int             httpLoops;
+int             streamChunkSize;
+int             batchGroupSize;
+int             arenaRetain;
+int             mongocPoolSize;
 bool            simulatedNotification;
 bool            statCounters;
 bool            statSemWait;
@@ -204,6 +213,7 @@ bool            insecureNotif;
 bool            ngsiv1Autocast;
 int             contextDownloadAttempts;
 int             contextDownloadTimeout;
+int             contextCacheMaxSize;
 bool            troe;
 bool            disableFileLog;
 bool            lmtmp;
@@ -212,6 +222,12 @@ unsigned short  troePort;
 char            troeUser[256];
 char            troePwd[256];
 int             troePoolSize;
+int             troePoolTimeout;
+int             troeWriters;
+int             troeBatchSize;
+int             troeBatchDelay;
+int             troeQueueSize;
+bool            troeCopy;
 bool            socketService;
 unsigned short  socketServicePort;
 bool            forwarding;
@@ -232,6 +248,7 @@ bool            noswap;
 
 #define CTX_TMO_DESC           "Timeout in milliseconds for downloading of contexts"
 #define CTX_ATT_DESC           "Number of attempts for downloading of contexts"
+#define CTX_CACHE_SIZE_DESC    "Max number of contexts in the context cache, least recently used downloaded contexts are evicted (0: no limit)"
 #define FG_DESC                "don't start as daemon"
 #define LOCALIP_DESC           "IP to receive new connections"
 #define PORT_DESC              "port to receive new connections"
@@ -259,10 +276,18 @@ bool            noswap;
 #define CPR_FORWARD_LIMIT_DESC "maximum number of forwarded requests to Context Providers for a single client request"
 #define SUB_CACHE_IVAL_DESC    "interval in seconds between calls to Subscription Cache refresh (0: no refresh)"
 #define NOTIFICATION_MODE_DESC "notification mode (persistent|transient|threadpool:q:n)"
+#define NOTIF_IN_FLIGHT_DESC   "max number of concurrent notification requests per worker, in threadpool notification mode"
+#define NOTIF_TENANT_QUOTA_DESC "max number of queued notifications per tenant, in threadpool notification mode (0: no limit)"
 #define NO_CACHE               "disable subscription cache for lookups"
 #define CONN_MEMORY_DESC       "maximum memory size per connection (in kilobytes)"
 #define MAX_CONN_DESC          "maximum number of simultaneous connections"
 #define REQ_POOL_SIZE          "size of thread pool for incoming connections"
+#define HTTP_WORKERS_DESC      "number of request worker threads serving NGSI-LD requests read by event loops (0: a thread per connection)"
+#define HTTP_LOOPS_DESC        "number of event loops reading requests for the request workers (0: one per core)"
+#define STREAM_CHUNK_SIZE_DESC "size (in kilobytes) of the chunks that entity array responses are rendered and streamed in (0: no streaming)"
+#define BATCH_GROUP_SIZE_DESC  "number of entities per database write in batch create/upsert/update, payload parsed while read (0: one write, no streaming)"
+#define ARENA_RETAIN_DESC      "max size (in kilobytes) of the request buffers that each thread keeps for its next requests (0: none kept)"
+#define MONGOC_POOL_SIZE_DESC  "max number of clients in the pool of the mongo C driver (entity queries, batch writes, context cache)"
 #define SIMULATED_NOTIF_DESC   "simulate notifications instead of actual sending them (only for testing)"
 #define STAT_COUNTERS          "enable request/notification counters statistics"
 #define STAT_SEM_WAIT          "enable semaphore waiting time statistics"
@@ -286,6 +311,12 @@ bool            noswap;
 #define TROE_HOST_USER         "username for troe database db server"
 #define TROE_HOST_PWD          "password for troe database db server"
 #define TROE_POOL_DESC         "size of the connection pool for TRoE Postgres database connections"
+#define TROE_POOL_TMO_DESC     "max time (in milliseconds) to wait for a free TRoE Postgres connection (0: wait forever)"
+#define TROE_WRITERS_DESC      "number of TRoE writer threads (0: TRoE is written by the request threads)"
+#define TROE_BATCH_SIZE_DESC   "size (in kilobytes) of a batch of TRoE rows that makes the writers flush it"
+#define TROE_BATCH_DELAY_DESC  "max time (in milliseconds) a TRoE row waits for its batch to be flushed"
+#define TROE_QUEUE_SIZE_DESC   "max size (in kilobytes) of TRoE rows waiting for the writers, before requests must wait"
+#define TROE_COPY_DESC         "write TRoE rows using the binary COPY protocol instead of INSERT commands"
 #define SOCKET_SERVICE_DESC    "enable the socket service - accept connections via a normal TCP socket"
 #define SOCKET_SERVICE_PORT_DESC  "port to receive new socket service connections"
 #define FORWARDING_DESC        "turn on forwarding"
@@ -338,7 +369,15 @@ PaArgument paArgs[] =
   { "-connectionMemory",      &connectionMemory,        "CONN_MEMORY",               PaUInt,    PaOpt,  64,              0,      1024,             CONN_MEMORY_DESC         },
   { "-maxConnections",        &maxConnections,          "MAX_CONN",                  PaUInt,    PaOpt,  1020,            1,      PaNL,             MAX_CONN_DESC            },
   { "-reqPoolSize",           &reqPoolSize,             "TRQ_POOL_SIZE",             PaUInt,    PaOpt,  0,               0,      1024,             REQ_POOL_SIZE            },
+  { "-httpWorkers",           &httpWorkers,             "HTTP_WORKERS",              PaInt,     PaOpt,  0,               0,      1024,             HTTP_WORKERS_DESC        },
+  { "-httpLoops",             &httpLoops,               "HTTP_LOOPS",                PaInt,     PaOpt,  0,               0,      256,              HTTP_LOOPS_DESC          },
+  { "-streamChunkSize",       &streamChunkSize,         "STREAM_CHUNK_SIZE",         PaInt,     PaOpt,  0,               0,      1024,             STREAM_CHUNK_SIZE_DESC   },
+  { "-batchGroupSize",        &batchGroupSize,          "BATCH_GROUP_SIZE",          PaInt,     PaOpt,  0,               0,      100000,           BATCH_GROUP_SIZE_DESC    },
+  { "-arenaRetain",           &arenaRetain,             "ARENA_RETAIN",              PaInt,     PaOpt,  0,               0,      1048576,          ARENA_RETAIN_DESC        },
+  { "-mongocPoolSize",        &mongocPoolSize,          "MONGOC_POOL_SIZE",          PaInt,     PaOpt,  10,              1,      10000,            MONGOC_POOL_SIZE_DESC    },
   { "-notificationMode",      &notificationMode,        "NOTIF_MODE",                PaString,  PaOpt,  _i "transient",  PaNL,   PaNL,             NOTIFICATION_MODE_DESC   },
+  { "-notifInFlight",         &notifInFlight,           "NOTIF_IN_FLIGHT",           PaInt,     PaOpt,  1,               1,      1024,             NOTIF_IN_FLIGHT_DESC     },
+  { "-notifTenantQuota",      &notifTenantQuota,        "NOTIF_TENANT_QUOTA",        PaInt,     PaOpt,  0,               0,      PaNL,             NOTIF_TENANT_QUOTA_DESC  },
   { "-simulatedNotification", &simulatedNotification,   "DROP_NOTIF",                PaBool,    PaOpt,  false,           false,  true,             SIMULATED_NOTIF_DESC     },
   { "-statCounters",          &statCounters,            "STAT_COUNTERS",             PaBool,    PaOpt,  false,           false,  true,             STAT_COUNTERS            },
   { "-statSemWait",           &statSemWait,             "STAT_SEM_WAIT",             PaBool,    PaOpt,  false,           false,  true,             STAT_SEM_WAIT            },
@@ -355,6 +394,7 @@ PaArgument paArgs[] =
   { "-ngsiv1Autocast",        &ngsiv1Autocast,          "NGSIV1_AUTOCAST",           PaBool,    PaOpt,  false,           false,  true,             NGSIV1_AUTOCAST          },
   { "-ctxTimeout",            &contextDownloadTimeout,  "CONTEXT_DOWNLOAD_TIMEOUT",  PaInt,     PaOpt,  5000,            0,      20000,            CTX_TMO_DESC             },
   { "-ctxAttempts",           &contextDownloadAttempts, "CONTEXT_DOWNLOAD_ATTEMPTS", PaInt,     PaOpt,  3,               0,      100,              CTX_ATT_DESC             },
+  { "-ctxCacheSize",          &contextCacheMaxSize,     "CONTEXT_CACHE_SIZE",        PaInt,     PaOpt,  0,               0,      1000000,          CTX_CACHE_SIZE_DESC      },
   { "-troe",                  &troe,                    "TROE",                      PaBool,    PaOpt,  false,           false,  true,             TROE_DESC                },
   { "-lmtmp",                 &lmtmp,                   "TMP_TRACES",                PaBool,    PaHid,  true,            false,  true,             TMPTRACES_DESC           },
   { "-socketService",         &socketService,           "SOCKET_SERVICE",            PaBool,    PaHid,  false,           false,  true,             SOCKET_SERVICE_DESC      },
@@ -363,6 +403,12 @@ PaArgument paArgs[] =
   { "-troeUser",              troeUser,                 "TROE_USER",                 PaString,  PaOpt,  _i "postgres",   PaNL,   PaNL,             TROE_HOST_USER           },
   { "-troePwd",               troePwd,                  "TROE_PWD",                  PaString,  PaOpt,  _i "password",   PaNL,   PaNL,             TROE_HOST_PWD            },
   { "-troePoolSize",          &troePoolSize,            "TROE_POOL_SIZE",            PaInt,     PaOpt,  10,              0,      1000,             TROE_POOL_DESC           },
+  { "-troePoolTimeout",       &troePoolTimeout,         "TROE_POOL_TIMEOUT",         PaInt,     PaOpt,  5000,            0,      600000,           TROE_POOL_TMO_DESC       },
+  { "-troeWriters",           &troeWriters,             "TROE_WRITERS",              PaInt,     PaOpt,  0,               0,      100,              TROE_WRITERS_DESC        },
+  { "-troeBatchSize",         &troeBatchSize,           "TROE_BATCH_SIZE",           PaInt,     PaOpt,  1024,            1,      1048576,          TROE_BATCH_SIZE_DESC     },
+  { "-troeBatchDelay",        &troeBatchDelay,          "TROE_BATCH_DELAY",          PaInt,     PaOpt,  100,             0,      60000,            TROE_BATCH_DELAY_DESC    },
+  { "-troeQueueSize",         &troeQueueSize,           "TROE_QUEUE_SIZE",           PaInt,     PaOpt,  65536,           1,      16777216,         TROE_QUEUE_SIZE_DESC     },
+  { "-troeCopy",              &troeCopy,                "TROE_COPY",                 PaBool,    PaOpt,  false,           false,  true,             TROE_COPY_DESC           },
   { "-ssPort",                &socketServicePort,       "SOCKET_SERVICE_PORT",       PaUShort,  PaHid,  1027,            PaNL,   PaNL,             SOCKET_SERVICE_PORT_DESC },
   { "-forwarding",            &forwarding,              "FORWARDING",                PaBool,    PaOpt,  false,           false,  true,             FORWARDING_DESC          },
   { "-noNotifyFalseUpdate",   &noNotifyFalseUpdate,     "NO_NOTIFY_FALSE_UPDATE",    PaBool,    PaOpt,  false,           false,  true,             NO_NOTIFY_FALSE_UPDATE_DESC  },
@@ -561,6 +607,7 @@ void exitFunc(void)
   //
   if (troe)
   {
+    troeWriterRelease(troeWriters);
     pgConnectionPoolsPresent();
     pgConnectionPoolsFree();
   }
@@ -595,7 +642,7 @@ static void contextBrokerInit(std::string dbPrefix, bool multitenant)
   /* If we use a queue for notifications, start worker threads */
   if (strcmp(notificationMode, "threadpool") == 0)
   {
-    QueueNotifier*  pQNotifier = new QueueNotifier(notificationQueueSize, notificationThreadNum);
+    QueueNotifier*  pQNotifier = new QueueNotifier(notificationQueueSize, notificationThreadNum, notifInFlight, notifTenantQuota);
     int             rc         = pQNotifier->start();
 
     if (rc != 0)
@@ -920,6 +967,12 @@ int main(int argC, char* argV[])
     }
   }
 
+  if ((streamChunkSize > 0) && ((reqPoolSize != 0) || (httpWorkers > 0)))
+  {
+    LM_W(("-streamChunkSize is ignored when -reqPoolSize or -httpWorkers is used - responses are streamed only in thread-per-connection mode"));
+    streamChunkSize = 0;
+  }
+
   notificationModeParse(notificationMode, &notificationQueueSize, &notificationThreadNum); // This should be called before contextBrokerInit()
 
   LM_I(("Orion Context Broker is running"));
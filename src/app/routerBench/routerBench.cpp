@@ -0,0 +1,567 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // printf, fprintf
+#include <stdlib.h>                                            // atoi, exit
+#include <string.h>                                            // strcmp, strncmp, strstr, strcpy
+#include <stdint.h>                                            // uint32_t
+#include <time.h>                                              // clock_gettime
+
+#include "orionld/rest/OrionldRouteNode.h"                     // OrionldRouteNode
+#include "orionld/rest/orionldRouteInsert.h"                   // orionldRouteInsert
+#include "orionld/rest/orionldRouteMatch.h"                    // orionldRouteMatch
+#include "orionld/rest/OrionldNameTable.h"                     // OrionldNameTable, OrionldNameItem
+#include "orionld/rest/orionldNameTableBuild.h"                // orionldNameTableBuild
+#include "orionld/rest/orionldNameTableLookup.h"               // orionldNameTableLookup
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Micro-benchmark of the request dispatch of the broker:
+//
+//   - URL path -> service:    radix trie (orionldRouteMatch) vs the linear checksum lookup it replaced
+//   - URI param name -> mask:  perfect hash (orionldNameTableLookup) vs the strcmp chain it replaced
+//
+// Usage: routerBench [iterations]
+//
+// Before measuring, both implementations are run over all test inputs and their results compared.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORION_LD_SERVICE_PREFIX_LEN - strlen("/ngsi-ld/")
+//
+#define ORION_LD_SERVICE_PREFIX_LEN 9
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionLdRestService - the routing part of the broker's OrionLdRestService, as it was before the radix trie
+//
+// The router only handles pointers to OrionLdRestService, so it doesn't care about the contents.
+//
+struct OrionLdRestService
+{
+  const char*  url;
+  const char*  routine;
+  int          wildcards;
+  int          charsBeforeFirstWildcard;
+  int          charsBeforeFirstWildcardSum;
+  char         matchForSecondWildcard[16];
+  int          matchForSecondWildcardLen;
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ServiceVector - the services of one verb
+//
+typedef struct ServiceVector
+{
+  OrionLdRestService*  serviceV;
+  int                  services;
+  OrionldRouteNode*    routeTree;
+} ServiceVector;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// The services of the broker - same URL paths and order as in src/app/orionld/orionldRestServices.cpp
+//
+static OrionLdRestService getServiceV[] =
+{
+  { "/ngsi-ld/ex/v1/ping",                          "orionldGetPing"             },
+  { "/ngsi-ld/v1/entities/*",                       "orionldGetEntity"           },
+  { "/ngsi-ld/v1/entities",                         "orionldGetEntities"         },
+  { "/ngsi-ld/v1/types/*",                          "orionldGetEntityType"       },
+  { "/ngsi-ld/v1/types",                            "orionldGetEntityTypes"      },
+  { "/ngsi-ld/v1/attributes/*",                     "orionldGetEntityAttribute"  },
+  { "/ngsi-ld/v1/attributes",                       "orionldGetEntityAttributes" },
+  { "/ngsi-ld/v1/subscriptions/*",                  "orionldGetSubscription"     },
+  { "/ngsi-ld/v1/subscriptions",                    "orionldGetSubscriptions"    },
+  { "/ngsi-ld/v1/csourceRegistrations/*",           "orionldGetRegistration"     },
+  { "/ngsi-ld/v1/csourceRegistrations",             "orionldGetRegistrations"    },
+  { "/ngsi-ld/v1/jsonldContexts/*",                 "orionldGetContext"          },
+  { "/ngsi-ld/v1/jsonldContexts",                   "orionldGetContexts"         },
+  { "/ngsi-ld/v1/temporal/entities/*",              "orionldGetTemporalEntity"   },
+  { "/ngsi-ld/v1/temporal/entities",                "orionldGetTemporalEntities" },
+  { "/ngsi-ld/ex/v1/version",                       "orionldGetVersion"          },
+  { "/ngsi-ld/ex/v1/tenants",                       "orionldGetTenants"          },
+  { "/ngsi-ld/ex/v1/dbIndexes",                     "orionldGetDbIndexes"        }
+};
+
+static OrionLdRestService postServiceV[] =
+{
+  { "/ngsi-ld/v1/entities/*/attrs",                 "orionldPostEntity"           },
+  { "/ngsi-ld/v1/entities",                         "orionldPostEntities"         },
+  { "/ngsi-ld/ex/v1/notify",                        "orionldPostNotify"           },
+  { "/ngsi-ld/v1/entityOperations/create",          "orionldPostBatchCreate"      },
+  { "/ngsi-ld/v1/entityOperations/upsert",          "orionldPostBatchUpsert"      },
+  { "/ngsi-ld/v1/entityOperations/update",          "orionldPostBatchUpdate"      },
+  { "/ngsi-ld/v1/entityOperations/delete",          "orionldPostBatchDelete"      },
+  { "/ngsi-ld/v1/entityOperations/query",           "orionldPostQuery"            },
+  { "/ngsi-ld/v1/subscriptions",                    "orionldPostSubscriptions"    },
+  { "/ngsi-ld/v1/csourceRegistrations",             "orionldPostRegistrations"    },
+  { "/ngsi-ld/v1/temporal/entities/*/attrs",        "orionldNotImplemented"       },
+  { "/ngsi-ld/v1/temporal/entities",                "orionldPostTemporalEntities" },
+  { "/ngsi-ld/v1/temporal/entityOperations/query",  "orionldPostTemporalQuery"    },
+  { "/ngsi-ld/v1/jsonldContexts",                   "orionldPostContexts"         }
+};
+
+static OrionLdRestService patchServiceV[] =
+{
+  { "/ngsi-ld/v1/entities/*/attrs/*",               "orionldPatchAttribute"     },
+  { "/ngsi-ld/v1/entities/*/attrs",                 "orionldPatchEntity"        },
+  { "/ngsi-ld/v1/subscriptions/*",                  "orionldPatchSubscription"  },
+  { "/ngsi-ld/v1/csourceRegistrations/*",           "orionldPatchRegistration"  },
+  { "/ngsi-ld/v1/temporal/entities/*/attrs/*/*",    "orionldNotImplemented"     }
+};
+
+static OrionLdRestService deleteServiceV[] =
+{
+  { "/ngsi-ld/v1/entities/*/attrs/*",               "orionldDeleteAttribute"    },
+  { "/ngsi-ld/v1/entities/*",                       "orionldDeleteEntity"       },
+  { "/ngsi-ld/v1/subscriptions/*",                  "orionldDeleteSubscription" },
+  { "/ngsi-ld/v1/csourceRegistrations/*",           "orionldDeleteRegistration" },
+  { "/ngsi-ld/v1/jsonldContexts/*",                 "orionldDeleteContext"      },
+  { "/ngsi-ld/v1/temporal/entities/*/attrs/*/*",    "orionldNotImplemented"     },
+  { "/ngsi-ld/v1/temporal/entities/*/attrs/*",      "orionldNotImplemented"     },
+  { "/ngsi-ld/v1/temporal/entities/*",              "orionldNotImplemented"     }
+};
+
+#define VEC_SIZE(v) ((int) (sizeof(v) / sizeof(v[0])))
+
+static ServiceVector verbV[] =
+{
+  { getServiceV,    VEC_SIZE(getServiceV),    NULL },
+  { postServiceV,   VEC_SIZE(postServiceV),   NULL },
+  { patchServiceV,  VEC_SIZE(patchServiceV),  NULL },
+  { deleteServiceV, VEC_SIZE(deleteServiceV), NULL }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TestRequest - verb index in verbV and URL path
+//
+typedef struct TestRequest
+{
+  int          verb;
+  const char*  path;
+} TestRequest;
+
+static TestRequest requestV[] =
+{
+  { 0, "/ngsi-ld/v1/entities" },
+  { 0, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123" },
+  { 0, "/ngsi-ld/v1/subscriptions/urn:ngsi-ld:Subscription:S0001" },
+  { 0, "/ngsi-ld/v1/temporal/entities/urn:ngsi-ld:Vehicle:V0123" },
+  { 0, "/ngsi-ld/v1/temporal/entities" },
+  { 0, "/ngsi-ld/v1/types" },
+  { 0, "/ngsi-ld/ex/v1/version" },
+  { 0, "/ngsi-ld/v1/jsonldContexts/abcdef0123456789" },
+  { 1, "/ngsi-ld/v1/entities" },
+  { 1, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123/attrs" },
+  { 1, "/ngsi-ld/v1/entityOperations/upsert" },
+  { 1, "/ngsi-ld/v1/entityOperations/query" },
+  { 1, "/ngsi-ld/v1/temporal/entityOperations/query" },
+  { 1, "/ngsi-ld/ex/v1/notify" },
+  { 2, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123/attrs/speed" },
+  { 2, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123/attrs" },
+  { 2, "/ngsi-ld/v1/subscriptions/urn:ngsi-ld:Subscription:S0001" },
+  { 3, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123/attrs/speed" },
+  { 3, "/ngsi-ld/v1/entities/urn:ngsi-ld:Vehicle:V0123" },
+  { 3, "/ngsi-ld/v1/csourceRegistrations/urn:ngsi-ld:Registration:R0001" },
+  { 0, "/ngsi-ld/v1/no/such/service" },
+  { 3, "/ngsi-ld/v1/types/T1" }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// oldServicePrepare - the URL path analysis of restServicePrepare, before the radix trie
+//
+static void oldServicePrepare(OrionLdRestService* serviceP)
+{
+  int          ix            = ORION_LD_SERVICE_PREFIX_LEN - 1;
+  const char*  wildCardStart = NULL;
+  const char*  wildCardEnd   = NULL;
+
+  while (serviceP->url[++ix] != 0)
+  {
+    char c = serviceP->url[ix];
+
+    if (c == '*')
+    {
+      if (serviceP->wildcards == 0)
+        wildCardStart = &serviceP->url[ix + 1];
+      else if (serviceP->wildcards == 1)
+        wildCardEnd = &serviceP->url[ix];
+
+      serviceP->wildcards += 1;
+      continue;
+    }
+
+    if (serviceP->wildcards == 0)
+    {
+      ++serviceP->charsBeforeFirstWildcard;
+      serviceP->charsBeforeFirstWildcardSum += c;
+    }
+  }
+
+  if (serviceP->wildcards != 0)
+  {
+    if (wildCardEnd == NULL)
+      wildCardEnd = &serviceP->url[ix];
+
+    serviceP->matchForSecondWildcardLen = wildCardEnd - wildCardStart;
+    if (serviceP->matchForSecondWildcardLen != 0)
+      strncpy(serviceP->matchForSecondWildcard, wildCardStart, wildCardEnd - wildCardStart);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// oldServiceLookup - the linear checksum lookup of orionldServiceLookup, before the radix trie
+//
+#define MAX_CHARS_BEFORE_WILDCARD 34
+static OrionLdRestService* oldServiceLookup(ServiceVector* serviceV, char* urlPath, char** wildcard)
+{
+  int   cSumV[MAX_CHARS_BEFORE_WILDCARD];
+  char* url = &urlPath[ORION_LD_SERVICE_PREFIX_LEN];
+  int   ix  = 1;
+
+  cSumV[0] = url[0];
+  while ((url[ix] != 0) && (ix < MAX_CHARS_BEFORE_WILDCARD))
+  {
+    cSumV[ix] = cSumV[ix - 1] + url[ix];
+    ++ix;
+  }
+
+  while (url[ix] != 0)
+    ++ix;
+
+  int sLen = ix;
+
+  for (int serviceIx = 0; serviceIx < serviceV->services; serviceIx++)
+  {
+    OrionLdRestService* serviceP = &serviceV->serviceV[serviceIx];
+
+    if (serviceP->wildcards == 0)
+    {
+      if ((serviceP->charsBeforeFirstWildcard == sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[sLen - 1]))
+      {
+        if (strcmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], url) == 0)
+          return serviceP;
+      }
+    }
+    else if (serviceP->wildcards == 1)
+    {
+      if ((serviceP->charsBeforeFirstWildcard < sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1]))
+      {
+        if (strncmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], url, serviceP->charsBeforeFirstWildcard) == 0)
+        {
+          if (serviceP->matchForSecondWildcardLen != 0)
+          {
+            int endIx = sLen - serviceP->matchForSecondWildcardLen;
+
+            if (strncmp(&url[endIx], serviceP->matchForSecondWildcard, serviceP->matchForSecondWildcardLen) == 0)
+            {
+              wildcard[0] = &url[serviceP->charsBeforeFirstWildcard];
+              url[endIx]  = 0;
+              return serviceP;
+            }
+          }
+          else
+          {
+            wildcard[0] = &url[serviceP->charsBeforeFirstWildcard];
+            return serviceP;
+          }
+        }
+      }
+    }
+    else if ((serviceP->charsBeforeFirstWildcard < sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1]))
+    {
+      char* matchP;
+
+      if ((matchP = strstr(url, serviceP->matchForSecondWildcard)) != NULL)
+      {
+        wildcard[0] = &url[serviceP->charsBeforeFirstWildcard];
+        wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
+        *matchP     = 0;
+        return serviceP;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// URI parameters - the names accepted by orionldUriArgumentGet
+//
+static OrionldNameItem uriParamV[] =
+{
+  { "id",               1 << 2,  NULL }, { "type",             1 << 3,  NULL }, { "typePattern",      0,       NULL },
+  { "idPattern",        1 << 4,  NULL }, { "attrs",            1 << 5,  NULL }, { "offset",           1 << 1,  NULL },
+  { "limit",            1 << 0,  NULL }, { "options",          1 << 13, NULL }, { "geometry",         1 << 8,  NULL },
+  { "coordinates",      1 << 9,  NULL }, { "coords",           0,       NULL }, { "georel",           1 << 7,  NULL },
+  { "geoproperty",      1 << 10, NULL }, { "geometryProperty", 1 << 11, NULL }, { "count",            1 << 14, NULL },
+  { "q",                1 << 6,  NULL }, { "mq",               0,       NULL }, { "datasetId",        1 << 15, NULL },
+  { "deleteAll",        1 << 16, NULL }, { "timeproperty",     1 << 17, NULL }, { "timerel",          1 << 18, NULL },
+  { "timeAt",           1 << 19, NULL }, { "endTimeAt",        1 << 20, NULL }, { "lastN",            1 << 26, NULL },
+  { "details",          1 << 21, NULL }, { "prettyPrint",      1 << 22, NULL }, { "spaces",           1 << 23, NULL },
+  { "subscriptionId",   1 << 24, NULL }, { "location",         1 << 25, NULL }, { "url",              1 << 27, NULL },
+  { "reload",           1 << 28, NULL }, { "exist",            0,       NULL }, { "!exist",           1 << 29, NULL },
+  { "metadata",         0,       NULL }, { "orderBy",          0,       NULL }, { "collapse",         0,       NULL },
+  { "attributeFormat",  0,       NULL }, { "attributesFormat", 0,       NULL }, { "reset",            0,       NULL },
+  { "level",            0,       NULL }, { "entity::type",     0,       NULL }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// oldUriParamLookup - the strcmp chain of orionldUriArgumentGet, before the perfect hash (same order)
+//
+static OrionldNameItem* oldUriParamLookup(const char* key)
+{
+  for (int ix = 0; ix < VEC_SIZE(uriParamV); ix++)
+  {
+    if (strcmp(key, uriParamV[ix].name) == 0)
+      return &uriParamV[ix];
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// uriParamTestV - URI parameter names of typical requests
+//
+static const char* uriParamTestV[] =
+{
+  "type", "options", "limit", "q", "attrs", "id", "count", "offset", "georel", "geometry", "coordinates",
+  "timerel", "timeAt", "lastN", "prettyPrint", "datasetId", "details", "noSuchParam"
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nowNs -
+//
+static long long nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// routeCheck - both routers must agree on service and wildcards
+//
+static int routeCheck(void)
+{
+  int errors = 0;
+
+  for (int ix = 0; ix < VEC_SIZE(requestV); ix++)
+  {
+    char                 oldPath[256];
+    char                 newPath[256];
+    char*                oldWildcard[2] = { NULL, NULL };
+    char*                newWildcard[2] = { NULL, NULL };
+    ServiceVector*       serviceV       = &verbV[requestV[ix].verb];
+
+    strcpy(oldPath, requestV[ix].path);
+    strcpy(newPath, requestV[ix].path);
+
+    OrionLdRestService*  oldP = oldServiceLookup(serviceV, oldPath, oldWildcard);
+    OrionLdRestService*  newP = orionldRouteMatch(serviceV->routeTree, &newPath[ORION_LD_SERVICE_PREFIX_LEN], newWildcard, 2);
+    const char*          oldR = (oldP != NULL)? oldP->routine : "NONE";
+    const char*          newR = (newP != NULL)? newP->routine : "NONE";
+
+    bool ok = (strcmp(oldR, newR) == 0);
+    for (int wIx = 0; wIx < 2; wIx++)
+    {
+      if ((oldWildcard[wIx] == NULL) != (newWildcard[wIx] == NULL))
+        ok = false;
+      else if ((oldWildcard[wIx] != NULL) && (strcmp(oldWildcard[wIx], newWildcard[wIx]) != 0))
+        ok = false;
+    }
+
+    printf("%-4s %-65s %-28s %s%s%s\n", ok? "OK" : "DIFF", requestV[ix].path, newR,
+           (newWildcard[0] != NULL)? newWildcard[0] : "",
+           (newWildcard[1] != NULL)? " | " : "",
+           (newWildcard[1] != NULL)? newWildcard[1] : "");
+
+    if (ok == false)
+    {
+      printf("     old: %s %s %s\n", oldR, (oldWildcard[0] != NULL)? oldWildcard[0] : "", (oldWildcard[1] != NULL)? oldWildcard[1] : "");
+      ++errors;
+    }
+  }
+
+  return errors;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  int iterations = (argC > 1)? atoi(argV[1]) : 1000000;
+
+  for (int vIx = 0; vIx < VEC_SIZE(verbV); vIx++)
+  {
+    for (int sIx = 0; sIx < verbV[vIx].services; sIx++)
+    {
+      OrionLdRestService* serviceP = &verbV[vIx].serviceV[sIx];
+
+      oldServicePrepare(serviceP);
+      orionldRouteInsert(&verbV[vIx].routeTree, &serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], serviceP);
+    }
+  }
+
+  OrionldNameTable uriParamTable;
+  if (orionldNameTableBuild(&uriParamTable, uriParamV, VEC_SIZE(uriParamV)) == false)
+  {
+    fprintf(stderr, "unable to build the perfect hash table of URI parameters\n");
+    exit(1);
+  }
+  printf("URI param table: %d names in %d slots (seed %d)\n\n", VEC_SIZE(uriParamV), uriParamTable.slots, uriParamTable.seed);
+
+  int errors = routeCheck();
+
+  for (int ix = 0; ix < VEC_SIZE(uriParamTestV); ix++)
+  {
+    if (oldUriParamLookup(uriParamTestV[ix]) != orionldNameTableLookup(&uriParamTable, uriParamTestV[ix]))
+    {
+      printf("DIFF URI param '%s'\n", uriParamTestV[ix]);
+      ++errors;
+    }
+  }
+
+  if (errors != 0)
+  {
+    printf("\n%d differences between the old and the new dispatch\n", errors);
+    exit(1);
+  }
+
+  //
+  // Routing - the URL path is copied before each lookup, as both routers destroy it - same cost for both
+  //
+  long long  hits = 0;
+  char       path[256];
+  char*      wildcard[2];
+  long long  start;
+  long long  oldNs;
+  long long  newNs;
+
+  start = nowNs();
+  for (int it = 0; it < iterations; it++)
+  {
+    for (int ix = 0; ix < VEC_SIZE(requestV); ix++)
+    {
+      strcpy(path, requestV[ix].path);
+      hits += (oldServiceLookup(&verbV[requestV[ix].verb], path, wildcard) != NULL);
+    }
+  }
+  oldNs = nowNs() - start;
+
+  start = nowNs();
+  for (int it = 0; it < iterations; it++)
+  {
+    for (int ix = 0; ix < VEC_SIZE(requestV); ix++)
+    {
+      strcpy(path, requestV[ix].path);
+      hits += (orionldRouteMatch(verbV[requestV[ix].verb].routeTree, &path[ORION_LD_SERVICE_PREFIX_LEN], wildcard, 2) != NULL);
+    }
+  }
+  newNs = nowNs() - start;
+
+  long long lookups = (long long) iterations * VEC_SIZE(requestV);
+  printf("\nURL path lookup   (%lld lookups):  linear checksum %6.1f ns/lookup,  radix trie   %6.1f ns/lookup\n",
+         lookups, (double) oldNs / lookups, (double) newNs / lookups);
+
+  //
+  // URI parameters
+  //
+  uint32_t mask = 0;
+
+  start = nowNs();
+  for (int it = 0; it < iterations; it++)
+  {
+    for (int ix = 0; ix < VEC_SIZE(uriParamTestV); ix++)
+    {
+      OrionldNameItem* itemP = oldUriParamLookup(uriParamTestV[ix]);
+      if (itemP != NULL)
+        mask |= itemP->mask;
+    }
+  }
+  oldNs = nowNs() - start;
+
+  start = nowNs();
+  for (int it = 0; it < iterations; it++)
+  {
+    for (int ix = 0; ix < VEC_SIZE(uriParamTestV); ix++)
+    {
+      OrionldNameItem* itemP = orionldNameTableLookup(&uriParamTable, uriParamTestV[ix]);
+      if (itemP != NULL)
+        mask |= itemP->mask;
+    }
+  }
+  newNs = nowNs() - start;
+
+  lookups = (long long) iterations * VEC_SIZE(uriParamTestV);
+  printf("URI param lookup  (%lld lookups):  strcmp chain    %6.1f ns/lookup,  perfect hash %6.1f ns/lookup\n",
+         lookups, (double) oldNs / lookups, (double) newNs / lookups);
+
+  // Printing the accumulated results keeps the compiler from optimizing away the loops
+  printf("\n(hits: %lld, mask: 0x%x)\n", hits, mask);
+
+  return 0;
+}
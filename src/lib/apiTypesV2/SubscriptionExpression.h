@@ -28,6 +28,7 @@
 #include <string>
 
 #include "rest/StringFilter.h"
+#include "rest/GeoFilter.h"
 
 
 /* ****************************************************************************
@@ -55,6 +56,7 @@ struct SubscriptionExpression
 
   StringFilter              stringFilter;
   StringFilter              mdStringFilter;
+  GeoFilter                 geoFilter;       // georel+geometry+coords, compiled when entering the subscription cache
   bool                      isSet;
 };
 
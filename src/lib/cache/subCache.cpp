@@ -27,12 +27,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "logMsg/logMsg.h"
 #include "logMsg/traceLevels.h"
 
 #include "common/sem.h"
 #include "common/string.h"
+#include "common/GeoCellIndex.h"
 #include "apiTypesV2/HttpInfo.h"
 #include "apiTypesV2/Subscription.h"
 #include "mongoBackend/MongoGlobal.h"
@@ -133,6 +135,23 @@ entityId(_entityId), entityType(_entityType), isTypePattern(_isTypePattern)
 
 
 
+/* ****************************************************************************
+*
+* EntityInfo::idMatch -
+*/
+bool EntityInfo::idMatch(const std::string& id)
+{
+  if (isPattern)
+  {
+    // REGEX-comparison this->entityIdPattern VS id
+    return (regexec(&entityIdPattern, id.c_str(), 0, NULL, 0) == 0);
+  }
+
+  return (id == entityId);
+}
+
+
+
 /* ****************************************************************************
 *
 * EntityInfo::match -
@@ -144,22 +163,7 @@ bool EntityInfo::match
 )
 {
   bool matchedType = false;
-  bool matchedId   = false;
-
-  // Check id
-  if (isPattern)
-  {
-    // REGEX-comparison this->entityIdPattern VS id
-    matchedId =  (regexec(&entityIdPattern, id.c_str(), 0, NULL, 0) == 0);
-  }
-  else if (id == entityId)
-  {
-    matchedId =  true;
-  }
-  else
-  {
-    matchedId = false;
-  }
+  bool matchedId   = idMatch(id);
 
   // short-circuit, optimization
   if (matchedId)
@@ -224,13 +228,49 @@ typedef struct SubCache
 
 
 
+/* ****************************************************************************
+*
+* SubCacheTenantIndex -
+*
+* Index of the subscriptions of a tenant, so that subCacheMatch doesn't need to traverse the
+* entire list of subscriptions for each and every update.
+*
+* Every subscription is in exactly one of the buckets (possibly under more than one key):
+*   - byArea:        its geo-filter bounds the location of the entities (key: bounding box)
+*   - byEntityId:    all its EntityInfos have an exact entity id   (key: entity id)
+*   - byEntityType:  all its EntityInfos have an exact entity type (key: entity type)
+*   - byAttribute:   it has condition attributes                   (key: attribute name)
+*   - wildcard:      all the rest (id/type patterns and no condition attributes)
+*
+* byArea is a spatial index, so that an update of a moving entity only looks at the geo-subscriptions
+* whose area is close to the new location of the entity, instead of at each and every geo-subscription
+* of the tenant (think fleet tracking with thousands of geofences).
+*
+* The candidates found in the index are then checked by subMatch, just like before (and the geo-filter
+* by processSubscriptions). The vectors are kept in insertion order (cacheSeq).
+*/
+typedef std::vector<CachedSubscription*> CachedSubscriptionVector;
+
+typedef struct SubCacheTenantIndex
+{
+  GeoCellIndex<CachedSubscription*>           byArea;
+  map<std::string, CachedSubscriptionVector>  byEntityId;
+  map<std::string, CachedSubscriptionVector>  byEntityType;
+  map<std::string, CachedSubscriptionVector>  byAttribute;
+  CachedSubscriptionVector                    wildcard;
+} SubCacheTenantIndex;
+
+
+
 /* ****************************************************************************
 *
 * subCache -
 */
-static SubCache  subCache            = { NULL, NULL, 0, 0, 0, 0 };
-bool             subCacheActive      = false;
-bool             subCacheMultitenant = false;
+static SubCache                               subCache            = { NULL, NULL, 0, 0, 0, 0 };
+static map<std::string, SubCacheTenantIndex>  subCacheIndex;
+static int64_t                                subCacheSeq         = 0;
+bool                                          subCacheActive      = false;
+bool                                          subCacheMultitenant = false;
 
 
 
@@ -451,7 +491,15 @@ static bool subMatch
   {
     EntityInfo* eiP = cSubP->entityIdInfos[ix];
 
-    if (eiP->match(entityId, entityType))
+    if (entityType == NULL)
+    {
+      // Entity type not known - any type, also a type pattern, may match
+      if (eiP->idMatch(entityId))
+      {
+        return true;
+      }
+    }
+    else if (eiP->match(entityId, entityType))
     {
       return true;
     }
@@ -463,6 +511,216 @@ static bool subMatch
 
 
 
+/* ****************************************************************************
+*
+* indexTenant - the key of the tenant in the index
+*
+* Without multitenancy, the tenant doesn't take part in the matching (see subMatch), so all
+* subscriptions go to the same index. NULL and "" are the same tenant.
+*/
+static std::string indexTenant(const char* tenant)
+{
+  if ((subCacheMultitenant == false) || (tenant == NULL))
+  {
+    return "";
+  }
+
+  return tenant;
+}
+
+
+
+/* ****************************************************************************
+*
+* indexBucket - the bucket of a subscription, and its keys in the bucket
+*/
+static map<std::string, CachedSubscriptionVector>* indexBucket
+(
+  SubCacheTenantIndex*       tiP,
+  CachedSubscription*        cSubP,
+  std::vector<std::string>*  keyV
+)
+{
+  bool exactIds   = (cSubP->entityIdInfos.size() > 0);
+  bool exactTypes = (cSubP->entityIdInfos.size() > 0);
+
+  for (unsigned int ix = 0; ix < cSubP->entityIdInfos.size(); ++ix)
+  {
+    EntityInfo* eiP = cSubP->entityIdInfos[ix];
+
+    if (eiP->isPattern)
+    {
+      exactIds = false;
+    }
+
+    if ((eiP->isTypePattern) || (eiP->entityType == ""))
+    {
+      exactTypes = false;
+    }
+  }
+
+  map<std::string, CachedSubscriptionVector>* bucketP = NULL;
+
+  if (exactIds || exactTypes)
+  {
+    for (unsigned int ix = 0; ix < cSubP->entityIdInfos.size(); ++ix)
+    {
+      EntityInfo* eiP = cSubP->entityIdInfos[ix];
+
+      keyV->push_back(exactIds? eiP->entityId : eiP->entityType);
+    }
+
+    bucketP = exactIds? &tiP->byEntityId : &tiP->byEntityType;
+  }
+  else if (cSubP->notifyConditionV.size() > 0)
+  {
+    *keyV   = cSubP->notifyConditionV;
+    bucketP = &tiP->byAttribute;
+  }
+  else
+  {
+    return NULL;  // wildcard
+  }
+
+  // No duplicated keys
+  std::sort(keyV->begin(), keyV->end());
+  keyV->erase(std::unique(keyV->begin(), keyV->end()), keyV->end());
+
+  return bucketP;
+}
+
+
+
+/* ****************************************************************************
+*
+* subCacheIndexAdd -
+*/
+static void subCacheIndexAdd(CachedSubscription* cSubP)
+{
+  SubCacheTenantIndex*                         tiP = &subCacheIndex[indexTenant(cSubP->tenant)];
+  std::vector<std::string>                     keyV;
+  map<std::string, CachedSubscriptionVector>*  bucketP;
+  GeoFilterBox                                 bbox;
+
+  // 'disjoint' and 'near' without maxDistance have no box - they go to the other buckets
+  if (cSubP->expression.geoFilter.bboxGet(&bbox) == true)
+  {
+    tiP->byArea.insert(cSubP, bbox.minLon, bbox.minLat, bbox.maxLon, bbox.maxLat);
+    return;
+  }
+
+  bucketP = indexBucket(tiP, cSubP, &keyV);
+
+  if (bucketP == NULL)
+  {
+    tiP->wildcard.push_back(cSubP);
+    return;
+  }
+
+  for (unsigned int ix = 0; ix < keyV.size(); ++ix)
+  {
+    (*bucketP)[keyV[ix]].push_back(cSubP);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* subVectorRemove -
+*/
+static void subVectorRemove(CachedSubscriptionVector* subVecP, CachedSubscription* cSubP)
+{
+  CachedSubscriptionVector::iterator it = std::find(subVecP->begin(), subVecP->end(), cSubP);
+
+  if (it != subVecP->end())
+  {
+    subVecP->erase(it);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* subCacheIndexRemove -
+*/
+static void subCacheIndexRemove(CachedSubscription* cSubP)
+{
+  map<std::string, SubCacheTenantIndex>::iterator tIter = subCacheIndex.find(indexTenant(cSubP->tenant));
+
+  if (tIter == subCacheIndex.end())
+  {
+    return;
+  }
+
+  SubCacheTenantIndex*                         tiP = &tIter->second;
+  std::vector<std::string>                     keyV;
+  map<std::string, CachedSubscriptionVector>*  bucketP;
+
+  if (tiP->byArea.remove(cSubP) == true)
+  {
+    return;
+  }
+
+  bucketP = indexBucket(tiP, cSubP, &keyV);
+
+  if (bucketP == NULL)
+  {
+    subVectorRemove(&tiP->wildcard, cSubP);
+    return;
+  }
+
+  for (unsigned int ix = 0; ix < keyV.size(); ++ix)
+  {
+    map<std::string, CachedSubscriptionVector>::iterator kIter = bucketP->find(keyV[ix]);
+
+    if (kIter != bucketP->end())
+    {
+      subVectorRemove(&kIter->second, cSubP);
+
+      if (kIter->second.size() == 0)
+      {
+        bucketP->erase(kIter);
+      }
+    }
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* candidatesAdd -
+*/
+static void candidatesAdd
+(
+  map<std::string, CachedSubscriptionVector>*  bucketP,
+  const std::string&                           key,
+  CachedSubscriptionVector*                    candidatesP
+)
+{
+  map<std::string, CachedSubscriptionVector>::iterator it = bucketP->find(key);
+
+  if (it != bucketP->end())
+  {
+    candidatesP->insert(candidatesP->end(), it->second.begin(), it->second.end());
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* cacheSeqLess -
+*/
+static bool cacheSeqLess(const CachedSubscription* cSub1P, const CachedSubscription* cSub2P)
+{
+  return cSub1P->cacheSeq < cSub2P->cacheSeq;
+}
+
+
+
 /* ****************************************************************************
 *
 * subCacheMatch -
@@ -477,21 +735,9 @@ void subCacheMatch
   std::vector<CachedSubscription*>*  subVecP
 )
 {
-  CachedSubscription* cSubP = subCache.head;
-
-  while (cSubP != NULL)
-  {
-    std::vector<std::string> attrV;
-
-    attrV.push_back(attr);
-
-    if (subMatch(cSubP, tenant, servicePath, entityId, entityType, attrV))
-    {
-      subVecP->push_back(cSubP);
-    }
+  std::vector<std::string> attrV(1, attr);
 
-    cSubP = cSubP->next;
-  }
+  subCacheMatch(tenant, servicePath, entityId, entityType, attrV, NULL, subVecP);
 }
 
 
@@ -499,6 +745,12 @@ void subCacheMatch
 /* ****************************************************************************
 *
 * subCacheMatch -
+*
+* 'locationP' is the location of the entity after the update, for the spatial index of the
+* geo-subscriptions. An empty shape is an entity without location, that no geo-filter matches.
+* If the location isn't known (locationP == NULL), all geo-subscriptions are candidates.
+* Same for the entity type: if it isn't known (entityType == NULL), the entity type of the
+* subscriptions isn't checked at all, not even type patterns, and so, they may all match.
 */
 void subCacheMatch
 (
@@ -507,19 +759,65 @@ void subCacheMatch
   const char*                        entityId,
   const char*                        entityType,
   const std::vector<std::string>&    attrV,
+  const GeoFilterShape*              locationP,
   std::vector<CachedSubscription*>*  subVecP
 )
 {
-  CachedSubscription* cSubP = subCache.head;
+  map<std::string, SubCacheTenantIndex>::iterator tIter = subCacheIndex.find(indexTenant(tenant));
 
-  while (cSubP != NULL)
+  if (tIter == subCacheIndex.end())
+  {
+    return;
+  }
+
+  SubCacheTenantIndex*      tiP = &tIter->second;
+  CachedSubscriptionVector  candidates;
+
+  candidatesAdd(&tiP->byEntityId, entityId, &candidates);
+
+  if ((entityType == NULL) || (entityType[0] == 0))
   {
-    if (subMatch(cSubP, tenant, servicePath, entityId, entityType, attrV))
+    // No entity type - all subscriptions with an exact entity type match the type (see EntityInfo::match)
+    for (map<std::string, CachedSubscriptionVector>::iterator it = tiP->byEntityType.begin(); it != tiP->byEntityType.end(); ++it)
     {
-      subVecP->push_back(cSubP);
+      candidates.insert(candidates.end(), it->second.begin(), it->second.end());
     }
+  }
+  else
+  {
+    candidatesAdd(&tiP->byEntityType, entityType, &candidates);
+  }
 
-    cSubP = cSubP->next;
+  for (unsigned int ix = 0; ix < attrV.size(); ++ix)
+  {
+    candidatesAdd(&tiP->byAttribute, attrV[ix], &candidates);
+  }
+
+  candidates.insert(candidates.end(), tiP->wildcard.begin(), tiP->wildcard.end());
+
+  if (locationP == NULL)
+  {
+    tiP->byArea.all(&candidates);
+  }
+  else if ((locationP->pointV.size() > 0) || (locationP->lineV.size() > 0) || (locationP->polygonV.size() > 0))
+  {
+    const GeoFilterBox* bboxP = &locationP->bbox;
+
+    tiP->byArea.lookup(bboxP->minLon, bboxP->minLat, bboxP->maxLon, bboxP->maxLat, &candidates);
+  }
+
+  //
+  // Same order as the list of the cache, and no duplicates (a subscription may be found under more than one attribute)
+  //
+  std::sort(candidates.begin(), candidates.end(), cacheSeqLess);
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  for (unsigned int ix = 0; ix < candidates.size(); ++ix)
+  {
+    if (subMatch(candidates[ix], tenant, servicePath, entityId, entityType, attrV))
+    {
+      subVecP->push_back(candidates[ix]);
+    }
   }
 }
 
@@ -595,6 +893,8 @@ void subCacheDestroy(void)
 
   subCache.head  = NULL;
   subCache.tail  = NULL;
+
+  subCacheIndex.clear();
 }
 
 
@@ -680,15 +980,32 @@ void subCacheUpdateStatisticsIncrement(void)
 * calls this function.
 *
 * So, the subscription itself is untouched by this function, is it ONLY inserted
-* in the list (only the 'next' field is modified).
+* in the list (only the 'next' and 'cacheSeq' fields are modified, and the geo-filter
+* of the expression is compiled).
 *
 */
 void subCacheItemInsert(CachedSubscription* cSubP)
 {
-  cSubP->next = NULL;
+  cSubP->next     = NULL;
+  cSubP->cacheSeq = ++subCacheSeq;
+
+  //
+  // The geo-filter is compiled once, here, and evaluated in memory for every update (see processSubscriptions).
+  // If the compilation fails, the subscription stays in the cache without compiled geo-filter - processSubscriptions
+  // then tries with the strings, just like for a subscription that isn't in the cache
+  //
+  if ((cSubP->expression.georel != "") && (cSubP->expression.coords != "") && (cSubP->expression.geometry != ""))
+  {
+    std::string errorString;
+
+    if (cSubP->expression.geoFilter.fill(cSubP->expression.geometry, cSubP->expression.coords, cSubP->expression.georel, &errorString) == false)
+      LM_W(("Bad Input (invalid geo-filter for subscription '%s': %s)", cSubP->subscriptionId, errorString.c_str()));
+  }
 
   ++subCache.noOfInserts;
 
+  subCacheIndexAdd(cSubP);
+
   // First insertion?
   if ((subCache.head == NULL) && (subCache.tail == NULL))
   {
@@ -962,6 +1279,7 @@ int subCacheItemRemove(CachedSubscription* cSubP)
 
       ++subCache.noOfRemoves;
 
+      subCacheIndexRemove(cSubP);
       subCacheItemDestroy(cSubP);
       delete cSubP;
 
@@ -82,6 +82,7 @@ struct EntityInfo
   ~EntityInfo() { release(); }
 
   bool          match(const std::string& idPattern, const std::string& type);
+  bool          idMatch(const std::string& id);
   void          release(void);
 };
 
@@ -115,6 +116,7 @@ struct CachedSubscription
   ngsiv2::HttpInfo            httpInfo;
   double                      lastFailure;  // timestamp of last notification failure
   double                      lastSuccess;  // timestamp of last successful notification
+  int64_t                     cacheSeq;     // insertion order in the cache - matches are returned in this order
   struct CachedSubscription*  next;
 };
 
@@ -291,6 +293,7 @@ extern void subCacheMatch
   const char*                        entityId,
   const char*                        entityType,
   const std::vector<std::string>&    attrV,
+  const GeoFilterShape*              locationP,
   std::vector<CachedSubscription*>*  subVecP
 );
 
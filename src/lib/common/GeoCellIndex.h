@@ -0,0 +1,337 @@
+#ifndef SRC_LIB_COMMON_GEOCELLINDEX_H_
+#define SRC_LIB_COMMON_GEOCELLINDEX_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+#include <math.h>                                                // floor
+
+#include <map>                                                   // std::map
+#include <vector>                                                // std::vector
+#include <utility>                                               // std::pair
+
+
+
+/* ****************************************************************************
+*
+* GEO_CELL_INDEX_LEVELS - number of levels of the grid, level L has 2^L x 2^L cells
+*
+* The deepest level has cells of some 60 x 30 cm (at the equator) - smaller areas
+* than that (points, e.g.) simply stay in the deepest level.
+*/
+#define GEO_CELL_INDEX_LEVELS     27
+
+
+
+/* ****************************************************************************
+*
+* GEO_CELL_INDEX_MAX_CELLS - max number of cells looked up per level and lookup
+*
+* If the box of a lookup covers more cells than this in a level, all the occupied
+* cells of the level are scanned instead.
+*/
+#define GEO_CELL_INDEX_MAX_CELLS  64
+
+
+
+/* ****************************************************************************
+*
+* template class GeoCellIndex<> - spatial index of bounding boxes (in degrees of longitude/latitude)
+*
+* A multi-level grid over [-180, 180] x [-90, 90]: every item is stored once, in the deepest
+* level whose cells are bigger than the box of the item, and in the cell of that level
+* where the box has its lower-left corner. The box of an item thus spans at most 2x2 cells of
+* its level, so, a lookup only needs to visit, per level, the cells that overlap the box of the
+* lookup plus one cell to the left and one below.
+*
+* The items found in the cells are then checked against the box of the lookup, so lookup()
+* returns exactly the items whose box overlaps the box of the lookup (borders included) - the
+* caller does the exact geometric test on these candidates.
+*
+* Insertion and removal are a couple of map operations, a lookup is a handful of map lookups per
+* occupied level, no matter how many items there are in the index.
+*
+* The index is not thread-safe, it is protected by the same semaphore as its owner.
+*/
+template <typename Item>
+class GeoCellIndex
+{
+private:
+  struct Entry
+  {
+    double  minLon;
+    double  minLat;
+    double  maxLon;
+    double  maxLat;
+    Item    item;
+  };
+
+  typedef std::vector<Entry>                  EntryVector;
+  typedef std::map<uint64_t, EntryVector>     CellMap;
+  typedef std::pair<int, uint64_t>            CellRef;     // level and cell key
+
+  CellMap                  levelV[GEO_CELL_INDEX_LEVELS];
+  std::map<Item, CellRef>  itemMap;
+
+  static int       cellX(double lon, int level);
+  static int       cellY(double lat, int level);
+  static uint64_t  cellKey(int x, int y) { return ((uint64_t) x << 32) | (uint64_t) y; }
+  static void      cellLookup(const EntryVector& entryV, double minLon, double minLat, double maxLon, double maxLat, std::vector<Item>* itemV);
+
+public:
+  bool    insert(const Item& item, double minLon, double minLat, double maxLon, double maxLat);
+  bool    remove(const Item& item);
+  void    lookup(double minLon, double minLat, double maxLon, double maxLat, std::vector<Item>* itemV) const;
+  void    all(std::vector<Item>* itemV) const;
+  void    clear(void);
+  size_t  size(void) const { return itemMap.size(); }
+};
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::cellX - column of a longitude in a level, clamped to the grid
+*/
+template <typename Item>
+int GeoCellIndex<Item>::cellX(double lon, int level)
+{
+  int     cells = 1 << level;
+  double  x     = floor((lon + 180) / 360 * cells);
+
+  if (x < 0)
+    return 0;
+  if (x >= cells)
+    return cells - 1;
+
+  return (int) x;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::cellY - row of a latitude in a level, clamped to the grid
+*/
+template <typename Item>
+int GeoCellIndex<Item>::cellY(double lat, int level)
+{
+  int     cells = 1 << level;
+  double  y     = floor((lat + 90) / 180 * cells);
+
+  if (y < 0)
+    return 0;
+  if (y >= cells)
+    return cells - 1;
+
+  return (int) y;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::insert - returns false if the item is already in the index
+*/
+template <typename Item>
+bool GeoCellIndex<Item>::insert(const Item& item, double minLon, double minLat, double maxLon, double maxLat)
+{
+  if (itemMap.find(item) != itemMap.end())
+    return false;
+
+  //
+  // Deepest level with cells bigger than the box
+  //
+  double  width  = maxLon - minLon;
+  double  height = maxLat - minLat;
+  int     level  = GEO_CELL_INDEX_LEVELS - 1;
+
+  while ((level > 0) && ((width >= 360.0 / (1 << level)) || (height >= 180.0 / (1 << level))))
+  {
+    --level;
+  }
+
+  uint64_t  key   = cellKey(cellX(minLon, level), cellY(minLat, level));
+  Entry     entry = { minLon, minLat, maxLon, maxLat, item };
+
+  levelV[level][key].push_back(entry);
+  itemMap[item] = CellRef(level, key);
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::remove - returns false if the item isn't in the index
+*
+* The cell of the item is remembered at insertion, so the box is not needed to remove it.
+*/
+template <typename Item>
+bool GeoCellIndex<Item>::remove(const Item& item)
+{
+  typename std::map<Item, CellRef>::iterator iIter = itemMap.find(item);
+
+  if (iIter == itemMap.end())
+    return false;
+
+  CellMap*                    cellMapP = &levelV[iIter->second.first];
+  typename CellMap::iterator  cIter    = cellMapP->find(iIter->second.second);
+
+  itemMap.erase(iIter);
+
+  if (cIter == cellMapP->end())
+    return false;
+
+  EntryVector* entryVP = &cIter->second;
+
+  for (unsigned int ix = 0; ix < entryVP->size(); ++ix)
+  {
+    if ((*entryVP)[ix].item == item)
+    {
+      entryVP->erase(entryVP->begin() + ix);
+      break;
+    }
+  }
+
+  if (entryVP->size() == 0)
+    cellMapP->erase(cIter);
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::cellLookup - the entries of a cell whose box overlaps the box of the lookup
+*/
+template <typename Item>
+void GeoCellIndex<Item>::cellLookup
+(
+  const EntryVector&  entryV,
+  double              minLon,
+  double              minLat,
+  double              maxLon,
+  double              maxLat,
+  std::vector<Item>*  itemV
+)
+{
+  for (unsigned int ix = 0; ix < entryV.size(); ++ix)
+  {
+    const Entry* entryP = &entryV[ix];
+
+    if ((entryP->minLon <= maxLon) && (entryP->maxLon >= minLon) && (entryP->minLat <= maxLat) && (entryP->maxLat >= minLat))
+      itemV->push_back(entryP->item);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::lookup - all items whose box overlaps a box (a point is a box with no area)
+*
+* The items are added to 'itemV', in no particular order.
+*/
+template <typename Item>
+void GeoCellIndex<Item>::lookup(double minLon, double minLat, double maxLon, double maxLat, std::vector<Item>* itemV) const
+{
+  for (int level = 0; level < GEO_CELL_INDEX_LEVELS; ++level)
+  {
+    const CellMap* cellMapP = &levelV[level];
+
+    if (cellMapP->empty())
+      continue;
+
+    //
+    // An item of this level lies in the cell of its lower-left corner, or in the cell to the right/above of it.
+    // So, the cells to visit start one cell to the left and one cell below the box of the lookup
+    //
+    int  x0 = cellX(minLon, level) - 1;
+    int  y0 = cellY(minLat, level) - 1;
+    int  x1 = cellX(maxLon, level);
+    int  y1 = cellY(maxLat, level);
+
+    x0 = (x0 < 0)? 0 : x0;
+    y0 = (y0 < 0)? 0 : y0;
+
+    if ((uint64_t) (x1 - x0 + 1) * (uint64_t) (y1 - y0 + 1) > GEO_CELL_INDEX_MAX_CELLS)
+    {
+      for (typename CellMap::const_iterator cIter = cellMapP->begin(); cIter != cellMapP->end(); ++cIter)
+      {
+        cellLookup(cIter->second, minLon, minLat, maxLon, maxLat, itemV);
+      }
+
+      continue;
+    }
+
+    for (int x = x0; x <= x1; ++x)
+    {
+      for (int y = y0; y <= y1; ++y)
+      {
+        typename CellMap::const_iterator cIter = cellMapP->find(cellKey(x, y));
+
+        if (cIter != cellMapP->end())
+          cellLookup(cIter->second, minLon, minLat, maxLon, maxLat, itemV);
+      }
+    }
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::all - all items of the index, in no particular order
+*/
+template <typename Item>
+void GeoCellIndex<Item>::all(std::vector<Item>* itemV) const
+{
+  for (typename std::map<Item, CellRef>::const_iterator iIter = itemMap.begin(); iIter != itemMap.end(); ++iIter)
+  {
+    itemV->push_back(iIter->first);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoCellIndex<Item>::clear -
+*/
+template <typename Item>
+void GeoCellIndex<Item>::clear(void)
+{
+  for (int level = 0; level < GEO_CELL_INDEX_LEVELS; ++level)
+  {
+    levelV[level].clear();
+  }
+
+  itemMap.clear();
+}
+
+#endif  // SRC_LIB_COMMON_GEOCELLINDEX_H_
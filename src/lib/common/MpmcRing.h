@@ -0,0 +1,237 @@
+#ifndef SRC_LIB_COMMON_MPMCRING_H_
+#define SRC_LIB_COMMON_MPMCRING_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                              // size_t
+#include <stdint.h>                                              // intptr_t
+
+
+
+/* ****************************************************************************
+*
+* MPMC_RING_CACHE_LINE - padding between the producer and the consumer positions
+*/
+#define MPMC_RING_CACHE_LINE  64
+
+
+
+/* ****************************************************************************
+*
+* template class MpmcRing<> - bounded, lock-free, multi-producer multi-consumer ring buffer
+*
+* Every cell carries a sequence number that tells producers and consumers whether the cell
+* is free for the lap they are in. A producer claims a position with a CAS on 'enqueuePos',
+* writes the element and publishes it by bumping the sequence of the cell. Consumers do the
+* same on 'dequeuePos'. No thread ever waits for another one - a full (or empty) ring simply
+* makes try_push (or try_pop) return false.
+*
+* pop_batch claims up to 'max' consecutive published cells with one single CAS.
+*/
+template <typename Data>
+class MpmcRing
+{
+private:
+  struct Cell
+  {
+    size_t  sequence;
+    Data    data;
+  };
+
+  Cell*   buffer;
+  size_t  cells;
+  char    pad0[MPMC_RING_CACHE_LINE];
+  size_t  enqueuePos;
+  char    pad1[MPMC_RING_CACHE_LINE];
+  size_t  dequeuePos;
+  char    pad2[MPMC_RING_CACHE_LINE];
+
+  MpmcRing(const MpmcRing&);
+  MpmcRing& operator=(const MpmcRing&);
+
+public:
+  explicit MpmcRing(size_t sz);
+  ~MpmcRing();
+  bool    try_push(const Data& element);
+  bool    try_pop(Data* elementP);
+  size_t  pop_batch(Data* elementV, size_t max);
+  size_t  size() const;
+  size_t  capacity() const { return cells; }
+};
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::MpmcRing -
+*/
+template <typename Data>
+MpmcRing<Data>::MpmcRing(size_t sz): cells((sz == 0)? 1 : sz), enqueuePos(0), dequeuePos(0)
+{
+  buffer = new Cell[cells];
+
+  for (size_t ix = 0; ix < cells; ix++)
+  {
+    __atomic_store_n(&buffer[ix].sequence, ix, __ATOMIC_RELAXED);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::~MpmcRing -
+*/
+template <typename Data>
+MpmcRing<Data>::~MpmcRing()
+{
+  delete[] buffer;
+}
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::try_push - returns false if the ring is full
+*/
+template <typename Data>
+bool MpmcRing<Data>::try_push(const Data& element)
+{
+  size_t  pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  Cell*   cellP;
+
+  for (;;)
+  {
+    cellP = &buffer[pos % cells];
+
+    size_t    seq  = __atomic_load_n(&cellP->sequence, __ATOMIC_ACQUIRE);
+    intptr_t  diff = (intptr_t) seq - (intptr_t) pos;
+
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    }
+    else if (diff < 0)
+      return false;  // The cell still holds the element of the previous lap - full
+    else
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  }
+
+  cellP->data = element;
+  __atomic_store_n(&cellP->sequence, pos + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::try_pop - returns false if the ring is empty
+*/
+template <typename Data>
+bool MpmcRing<Data>::try_pop(Data* elementP)
+{
+  return pop_batch(elementP, 1) == 1;
+}
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::pop_batch - pop up to 'max' elements, returns the number of elements popped
+*
+* The first cell decides where the batch starts; the batch is then extended over the following
+* cells for as long as they are published for the same lap. The whole batch is claimed with a
+* single CAS on 'dequeuePos' - if the CAS fails, some other consumer got there first and we start over.
+*/
+template <typename Data>
+size_t MpmcRing<Data>::pop_batch(Data* elementV, size_t max)
+{
+  size_t  pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+  size_t  n;
+
+  if (max == 0)
+    return 0;
+
+  if (max > cells)
+    max = cells;
+
+  for (;;)
+  {
+    size_t    seq  = __atomic_load_n(&buffer[pos % cells].sequence, __ATOMIC_ACQUIRE);
+    intptr_t  diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+    if (diff < 0)
+      return 0;  // Nothing published in the first cell - empty
+
+    if (diff > 0)
+    {
+      pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+      continue;
+    }
+
+    n = 1;
+    while (n < max)
+    {
+      size_t nextPos = pos + n;
+
+      if (__atomic_load_n(&buffer[nextPos % cells].sequence, __ATOMIC_ACQUIRE) != nextPos + 1)
+        break;
+      ++n;
+    }
+
+    if (__atomic_compare_exchange_n(&dequeuePos, &pos, pos + n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      break;
+  }
+
+  for (size_t ix = 0; ix < n; ix++)
+  {
+    Cell* cellP = &buffer[(pos + ix) % cells];
+
+    elementV[ix] = cellP->data;
+    __atomic_store_n(&cellP->sequence, pos + ix + cells, __ATOMIC_RELEASE);
+  }
+
+  return n;
+}
+
+
+
+/* ****************************************************************************
+*
+* MpmcRing<Data>::size - approximate number of elements in the ring
+*/
+template <typename Data>
+size_t MpmcRing<Data>::size() const
+{
+  size_t  out = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+  size_t  in  = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+
+  return (in > out)? in - out : 0;
+}
+
+#endif  // SRC_LIB_COMMON_MPMCRING_H_
@@ -115,6 +115,14 @@
 
 
 
+/* ****************************************************************************
+*
+* BATCH_STREAM_PAYLOAD_MAX_SIZE - max size of a BATCH payload that is served while being read (-batchGroupSize)
+*/
+#define BATCH_STREAM_PAYLOAD_MAX_SIZE   (64 * 1024 * 1024) // 64 MB
+
+
+
 /* ****************************************************************************
 *
 * IP - 
@@ -34,6 +34,7 @@ extern "C"
 {
 #include "kbase/kMacros.h"                                         // K_FT
 #include "kalloc/kaAlloc.h"                                        // kaAlloc
+#include "kalloc/kaStrdup.h"                                       // kaStrdup
 #include "kjson/KjNode.h"                                          // KjNode, kjValueType
 #include "kjson/kjLookup.h"                                        // kjLookup
 #include "kjson/kjRender.h"                                        // kjFastRender
@@ -61,11 +62,14 @@ extern "C"
 
 #include "orionld/types/OrionldTenant.h"                           // OrionldTenant
 #include "orionld/types/AttributeType.h"                           // AttributeType
+#include "orionld/types/OrionldEntitiesBulk.h"                     // OrionldEntitiesBulk, OrionldBulkOp
 #include "orionld/common/orionldState.h"                           // orionldState
 #include "orionld/common/isSpecialSubAttribute.h"                  // isSpecialSubAttribute
 #include "orionld/common/dotForEq.h"                               // dotForEq
 #include "orionld/common/eqForDot.h"                               // eqForDot
 #include "orionld/common/tenantList.h"                             // tenant0
+#include "orionld/common/catalogDeltaAdd.h"                        // catalogDeltaAdd
+#include "orionld/common/catalogDeltaMerge.h"                      // catalogDeltaMerge
 #include "orionld/db/dbConfiguration.h"                            // dbDataFromKjTree
 #include "orionld/mongoCppLegacy/mongoCppLegacyDataToKjTree.h"     // mongoCppLegacyDataToKjTree
 #include "orionld/kjTree/kjSort.h"                                 // kjSort
@@ -1264,6 +1268,9 @@ static std::string servicePathSubscriptionRegex(const std::string& servicePath,
 /* ****************************************************************************
 *
 * addTriggeredSubscriptions_withCache
+*
+* The location of the entity (after the update) is used to look up the geo-subscriptions in the
+* spatial index of the subscription cache. The GeoJSON is parsed before taking the cache semaphore.
 */
 static bool addTriggeredSubscriptions_withCache
 (
@@ -1273,14 +1280,24 @@ static bool addTriggeredSubscriptions_withCache
   std::map<std::string, TriggeredSubscription*>& subs,
   std::string&                                   err,
   OrionldTenant*                                 tenantP,
-  const std::vector<std::string>&                servicePathV
+  const std::vector<std::string>&                servicePathV,
+  const BSONObj*                                 locationP
 )
 {
   std::string                       servicePath = (servicePathV.size() > 0)? servicePathV[0] : "";
   std::vector<CachedSubscription*>  subVec;
+  GeoFilterShape                    location;
+
+  // An invalid location is like no location at all - no geo-filter matches it
+  if ((locationP->isEmpty() == true) || (location.fill(locationP) == false))
+  {
+    location.pointV.clear();
+    location.lineV.clear();
+    location.polygonV.clear();
+  }
 
   cacheSemTake(__FUNCTION__, "match subs for notifications");
-  subCacheMatch(tenantP->tenant, servicePath.c_str(), entityId.c_str(), entityType.c_str(), modifiedAttrs, &subVec);
+  subCacheMatch(tenantP->tenant, servicePath.c_str(), entityId.c_str(), entityType.c_str(), modifiedAttrs, &location, &subVec);
 
   for (unsigned int ix = 0; ix < subVec.size(); ++ix)
   {
@@ -1334,6 +1351,11 @@ static bool addTriggeredSubscriptions_withCache
 
     subP->fillExpression(cSubP->expression.georel, cSubP->expression.geometry, cSubP->expression.coords);
 
+    if (cSubP->expression.geoFilter.isSet())
+    {
+      subP->geoFilterSet(&cSubP->expression.geoFilter);
+    }
+
     std::string errorString;
 
     if (!subP->stringFilterSet(&cSubP->expression.stringFilter, &errorString))
@@ -1792,6 +1814,9 @@ static bool addTriggeredSubscriptions_noCache
 /* ****************************************************************************
 *
 * addTriggeredSubscriptions -
+*
+* 'locationP' is the location (GeoJSON geometry) of the entity after the update, empty if the entity
+* has no location.
 */
 static bool addTriggeredSubscriptions
 (
@@ -1801,7 +1826,8 @@ static bool addTriggeredSubscriptions
   std::map<std::string, TriggeredSubscription*>& subs,
   std::string&                                   err,
   OrionldTenant*                                 tenantP,
-  const std::vector<std::string>&                servicePathV
+  const std::vector<std::string>&                servicePathV,
+  const BSONObj*                                 locationP
 )
 {
   extern bool noCache;
@@ -1812,7 +1838,7 @@ static bool addTriggeredSubscriptions
   }
   else
   {
-    return addTriggeredSubscriptions_withCache(entityId, entityType, modifiedAttrs, subs, err, tenantP, servicePathV);
+    return addTriggeredSubscriptions_withCache(entityId, entityType, modifiedAttrs, subs, err, tenantP, servicePathV, locationP);
   }
 }
 
@@ -2134,9 +2160,63 @@ static void setDateModifiedMetadata(ContextElementResponse* notifyCerP)
 
 
 
+/* ****************************************************************************
+*
+* geoFilterDbMatch - is the entity inside the area of the geo-filter of a subscription, according to the database?
+*
+* For the geo-filters that can't be evaluated in memory with the same result as mongo's 2dsphere index
+* (big shapes, shapes that cross the antimeridian - see GeoFilter::exact).
+* Note that this query doesn't check any other filtering condition, assuming they are already checked in other steps.
+*/
+static bool geoFilterDbMatch(TriggeredSubscription* tSubP, ContextElementResponse* notifyCerP, OrionldTenant* tenantP)
+{
+  Scope        geoScope;
+  std::string  filterErr;
+
+  if (geoScope.fill(V2, tSubP->expression.geometry, tSubP->expression.coords, tSubP->expression.georel, &filterErr) != 0)
+  {
+    LM_E(("Runtime Error (code cannot reach this point, error: %s)", filterErr.c_str()));
+    geoScope.release();
+    return false;
+  }
+
+  BSONObj areaFilter;
+  bool    ok = processAreaScopeV2(&geoScope, &areaFilter);
+
+  geoScope.release();
+
+  if (ok == false)
+  {
+    // Error in processAreaScopeV2 is interpreted as no-match (conservative approach)
+    return false;
+  }
+
+  std::string  keyId   = "_id." ENT_ENTITY_ID;
+  std::string  keyType = "_id." ENT_ENTITY_TYPE;
+  std::string  keySp   = "_id." ENT_SERVICE_PATH;
+  std::string  keyLoc  = ENT_LOCATION "." ENT_LOCATION_COORDS;
+  std::string  id      = notifyCerP->contextElement.entityId.id;
+  std::string  type    = notifyCerP->contextElement.entityId.type;
+  std::string  sp      = notifyCerP->contextElement.entityId.servicePath;
+  BSONObj      query   = BSON(keyId << id << keyType << type << keySp << sp << keyLoc << areaFilter);
+
+  unsigned long long n;
+  if (!collectionCount(tenantP->entities, query, &n, &filterErr))
+  {
+    // Error in database access is interpreted as no-match (conservative approach)
+    return false;
+  }
+
+  return (n > 0);
+}
+
+
+
 /* ****************************************************************************
 *
 * processSubscriptions - send a notification for each subscription in the map
+*
+* 'locationP' is the location (GeoJSON geometry) of the entity after the update - empty if the entity has no location.
 */
 static bool processSubscriptions
 (
@@ -2145,7 +2225,8 @@ static bool processSubscriptions
   std::string*                                   err,
   OrionldTenant*                                 tenantP,
   const char*                                    xauthToken,
-  const char*                                    fiwareCorrelator
+  const char*                                    fiwareCorrelator,
+  const BSONObj*                                 locationP
 )
 {
   bool ret = true;
@@ -2190,52 +2271,35 @@ static bool processSubscriptions
     }
 
     /* Check 3: expression (georel, which also uses geometry and coords)
-     * This should be always the last check, as it is the most expensive one, given that it interacts with DB
-     * (Issue #2396 should solve that) */
+     * The geo-filter is evaluated in memory, against the location of the entity after the update.
+     * Subscriptions that come from the subscription cache have their geo-filter already compiled.
+     * If the in-memory result may differ from mongo's (big shapes, antimeridian), the database is asked instead. */
     if ((tSubP->expression.georel != "") && (tSubP->expression.coords != "") && (tSubP->expression.geometry != ""))
     {
-      Scope        geoScope;
-      std::string  filterErr;
-
-      if (geoScope.fill(V2, tSubP->expression.geometry, tSubP->expression.coords, tSubP->expression.georel, &filterErr) != 0)
+      if (tSubP->geoFilterP == NULL)
       {
-        // This has been already checked at subscription creation/update parsing time. Thus, the code cannot reach
-        // this part.
-        //
-        // (Probably the whole if clause will disapear when the missing part of #1705 gets implemented,
-        // moving geo-stuff strings to a filter object in TriggeredSubscription class
+        GeoFilter    geoFilter;
+        std::string  filterErr;
 
-        LM_E(("Runtime Error (code cannot reach this point, error: %s)", filterErr.c_str()));
-        continue;
-      }
+        if (geoFilter.fill(tSubP->expression.geometry, tSubP->expression.coords, tSubP->expression.georel, &filterErr) == false)
+        {
+          // This has been already checked at subscription creation/update parsing time. Thus, the code cannot reach
+          // this part.
+          LM_E(("Runtime Error (code cannot reach this point, error: %s)", filterErr.c_str()));
+          continue;
+        }
 
-      BSONObj areaFilter;
-      if (!processAreaScopeV2(&geoScope, &areaFilter))
-      {
-        // Error in processAreaScopeV2 is interpreted as no-match (conservative approach)
-        continue;
+        tSubP->geoFilterSet(&geoFilter);
       }
 
-      // Look in the database of an entity that maches the geo-filters. Note that this query doesn't
-      // check any other filtering condition, assuming they are already checked in other steps.
-      std::string  keyId   = "_id." ENT_ENTITY_ID;
-      std::string  keyType = "_id." ENT_ENTITY_TYPE;
-      std::string  keySp   = "_id." ENT_SERVICE_PATH;
-      std::string  keyLoc  = ENT_LOCATION "." ENT_LOCATION_COORDS;
-      std::string  id      = notifyCerP->contextElement.entityId.id;
-      std::string  type    = notifyCerP->contextElement.entityId.type;
-      std::string  sp      = notifyCerP->contextElement.entityId.servicePath;
-      BSONObj      query   = BSON(keyId << id << keyType << type << keySp << sp << keyLoc << areaFilter);
-
-      unsigned long long n;
-      if (!collectionCount(tenantP->entities, query, &n, &filterErr))
+      if (tSubP->geoFilterP->exact(locationP) == true)
       {
-        // Error in database access is interpreted as no-match (conservative approach)
-        continue;
+        if (tSubP->geoFilterP->match(locationP) == false)
+        {
+          continue;
+        }
       }
-
-      // No result? Then no-match
-      if (n == 0)
+      else if (geoFilterDbMatch(tSubP, notifyCerP, tenantP) == false)
       {
         continue;
       }
@@ -2890,6 +2954,7 @@ static bool processContextAttributeVector
   ContextElementResponse*                         cerP,
   std::string*                                    currentLocAttrName,
   BSONObjBuilder*                                 geoJson,
+  const BSONObj*                                  currentGeoJsonP,
   mongo::Date_t*                                  dateExpiration,
   bool*                                           dateExpirationInPayload,
   OrionldTenant*                                  tenantP,
@@ -3030,6 +3095,16 @@ static bool processContextAttributeVector
     }
   }
 
+  /* Location after the update (same logic as in updateEntity) - for the geo-subscriptions */
+  BSONObj location;
+
+  if (currentLocAttrName->length() > 0)
+  {
+    BSONObj newGeoJson = geoJson->asTempObj();
+
+    location = (newGeoJson.nFields() > 0)? newGeoJson.getOwned() : *currentGeoJsonP;
+  }
+
   /* Add triggered subscriptions */
   std::string err;
 
@@ -3037,7 +3112,7 @@ static bool processContextAttributeVector
   {
     LM_W(("Notification loop detected for entity id <%s> type <%s>, skipping subscription triggering", entityId.c_str(), entityType.c_str()));
   }
-  else if (!addTriggeredSubscriptions(entityId, entityType, modifiedAttrs, subsToNotify, err, tenantP, servicePathV))
+  else if (!addTriggeredSubscriptions(entityId, entityType, modifiedAttrs, subsToNotify, err, tenantP, servicePathV, &location))
   {
     cerP->statusCode.fill(SccReceiverInternalError, err);
     oe->fill(SccReceiverInternalError, err, "InternalServerError");
@@ -3056,6 +3131,216 @@ static bool processContextAttributeVector
 
 
 
+/* ****************************************************************************
+*
+* catalogAttrsDeltaAdd - add 'n' to the entity catalog counters of all attributes of an "attrs" object
+*/
+static void catalogAttrsDeltaAdd(KjNode** deltaPP, const char* entityType, const BSONObj& attrs, int n)
+{
+  std::set<std::string> attrNames;
+
+  attrs.getFieldNames(attrNames);
+
+  for (std::set<std::string>::iterator i = attrNames.begin(); i != attrNames.end(); ++i)
+  {
+    BSONObj attr;
+
+    getObjectFieldF(&attr, &attrs, i->c_str());
+    catalogDeltaAdd(deltaPP, entityType, i->c_str(), getStringFieldF(&attr, ENT_ATTRS_TYPE), n);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* catalogUpdateDelta - the entity catalog delta of an entity update
+*
+* PARAMETERS
+*   attrs       - the "attrs" of the entity, before the update
+*   toSetObj    - the $set of the update: { attrs.A1: { ... }, ... } - for replace: { A1: { ... }, ... }, all the attributes
+*   toUnsetObj  - the $unset of the update: { attrs.A1: 1, ... }
+*   replace     - ActionTypeReplace
+*
+* An attribute whose type is changed by the update is one less of the old type and one more of the new type.
+*/
+static KjNode* catalogUpdateDelta(const char* entityType, const BSONObj& attrs, const BSONObj& toSetObj, const BSONObj& toUnsetObj, bool replace)
+{
+  KjNode* deltaP = NULL;
+
+  if (replace == true)
+  {
+    catalogAttrsDeltaAdd(&deltaP, entityType, attrs, -1);
+    catalogAttrsDeltaAdd(&deltaP, entityType, toSetObj, 1);
+
+    return deltaP;
+  }
+
+  std::set<std::string>  fieldNames;
+  const int              prefixLen = sizeof(ENT_ATTRS ".") - 1;
+
+  toSetObj.getFieldNames(fieldNames);
+  for (std::set<std::string>::iterator i = fieldNames.begin(); i != fieldNames.end(); ++i)
+  {
+    if (strncmp(i->c_str(), ENT_ATTRS ".", prefixLen) != 0)
+      continue;
+
+    const char*  attrName = &i->c_str()[prefixLen];
+    BSONObj      newAttr;
+    const char*  newType;
+
+    getObjectFieldF(&newAttr, &toSetObj, i->c_str());
+    newType = getStringFieldF(&newAttr, ENT_ATTRS_TYPE);
+
+    if (attrs.hasField(attrName))
+    {
+      BSONObj      oldAttr;
+      const char*  oldType;
+
+      getObjectFieldF(&oldAttr, &attrs, attrName);
+      oldType = getStringFieldF(&oldAttr, ENT_ATTRS_TYPE);
+
+      if (strcmp(oldType, newType) == 0)
+        continue;
+
+      catalogDeltaAdd(&deltaP, entityType, attrName, oldType, -1);
+    }
+
+    catalogDeltaAdd(&deltaP, entityType, attrName, newType, 1);
+  }
+
+  fieldNames.clear();
+  toUnsetObj.getFieldNames(fieldNames);
+  for (std::set<std::string>::iterator i = fieldNames.begin(); i != fieldNames.end(); ++i)
+  {
+    if (strncmp(i->c_str(), ENT_ATTRS ".", prefixLen) != 0)
+      continue;
+
+    const char* attrName = &i->c_str()[prefixLen];
+
+    if (attrs.hasField(attrName))
+    {
+      BSONObj oldAttr;
+
+      getObjectFieldF(&oldAttr, &attrs, attrName);
+      catalogDeltaAdd(&deltaP, entityType, attrName, getStringFieldF(&oldAttr, ENT_ATTRS_TYPE), -1);
+    }
+  }
+
+  return deltaP;
+}
+
+
+
+/* ****************************************************************************
+*
+* entitiesBulkAdd -
+*
+* BATCH operations (orionldState.entitiesBulkP set) don't write the entities one by one.
+* The write is appended to the bulk of the request, and mongoUpdateContext sends them all in one go (mongocEntitiesBulkWrite).
+* A NULL selectorP means an insert.
+* The entity catalog delta of the write is kept in the op - it counts only if the write succeeds.
+*/
+static void entitiesBulkAdd(const std::string& entityId, const BSONObj* selectorP, const BSONObj& doc, KjNode* catalogDeltaP)
+{
+  OrionldEntitiesBulk*  bulkP = orionldState.entitiesBulkP;
+  OrionldBulkOp*        opP   = (OrionldBulkOp*) kaAlloc(&orionldState.kalloc, sizeof(OrionldBulkOp));
+
+  opP->entityId  = kaStrdup(&orionldState.kalloc, entityId.c_str());
+  opP->selectorP = (selectorP == NULL)? NULL : bson_new_from_data((const uint8_t*) selectorP->objdata(), selectorP->objsize());
+  opP->docP      = bson_new_from_data((const uint8_t*) doc.objdata(), doc.objsize());
+  opP->error     = NULL;
+  opP->catalogP  = catalogDeltaP;
+  opP->notifyP   = NULL;
+  opP->next      = NULL;
+
+  if (bulkP->first == NULL)
+    bulkP->first = opP;
+  else
+    bulkP->last->next = opP;
+
+  bulkP->last  = opP;
+  bulkP->ops  += 1;
+}
+
+
+
+/* ****************************************************************************
+*
+* BulkNotification - the notifications of one entity write of a BATCH operation
+*/
+typedef struct BulkNotification
+{
+  std::map<std::string, TriggeredSubscription*>  subs;
+  ContextElementResponse*                        notifyCerP;
+  BSONObj                                        location;
+} BulkNotification;
+
+
+
+/* ****************************************************************************
+*
+* entitiesBulkNotificationAdd -
+*
+* The notifications of an entity write of a BATCH operation can't be sent until the bulk write is done, as the write may fail.
+* They are kept in the op of the write (the last op of the bulk) and sent by entitiesBulkNotify, after mongocEntitiesBulkWrite.
+* The op takes over the triggered subscriptions and notifyCerP.
+*/
+static void entitiesBulkNotificationAdd
+(
+  std::map<std::string, TriggeredSubscription*>&  subs,
+  ContextElementResponse*                         notifyCerP,
+  const BSONObj*                                  locationP
+)
+{
+  BulkNotification* bnP = new BulkNotification();
+
+  bnP->subs.swap(subs);
+  bnP->notifyCerP = notifyCerP;
+  bnP->location   = locationP->getOwned();
+
+  orionldState.entitiesBulkP->last->notifyP = bnP;
+}
+
+
+
+/* ****************************************************************************
+*
+* entitiesBulkNotify - send the notifications of the entity writes of a BATCH operation that made it to the database
+*/
+void entitiesBulkNotify
+(
+  OrionldEntitiesBulk*  bulkP,
+  OrionldTenant*        tenantP,
+  const char*           xauthToken,
+  const char*           fiwareCorrelator
+)
+{
+  for (OrionldBulkOp* opP = bulkP->first; opP != NULL; opP = opP->next)
+  {
+    BulkNotification* bnP = (BulkNotification*) opP->notifyP;
+
+    if (bnP == NULL)
+      continue;
+
+    if (opP->error == NULL)
+    {
+      std::string err;
+
+      processSubscriptions(bnP->subs, bnP->notifyCerP, &err, tenantP, xauthToken, fiwareCorrelator, &bnP->location);
+    }
+
+    releaseTriggeredSubscriptions(&bnP->subs);
+    bnP->notifyCerP->release();
+    delete bnP->notifyCerP;
+    delete bnP;
+
+    opP->notifyP = NULL;
+  }
+}
+
+
+
 /* ****************************************************************************
 *
 * createEntity -
@@ -3070,7 +3355,8 @@ static bool createEntity
   const std::vector<std::string>&  servicePathV,
   ApiVersion                       apiVersion,
   const char*                      fiwareCorrelator,
-  OrionError*                      oeP
+  OrionError*                      oeP,
+  BSONObj*                         locationP
 )
 {
   /* Actually we don't know if this is the first entity (thus, the collection is being created) or not. However, we can
@@ -3119,6 +3405,10 @@ static bool createEntity
 
   BSONObjBuilder    attrsToAdd;
   BSONArrayBuilder  attrNamesToAdd;
+  KjNode*           catalogDeltaP = NULL;
+  const char*       entityType    = ((eP->type == "") && (apiVersion == V2))? DEFAULT_ENTITY_TYPE : eP->type.c_str();
+
+  catalogDeltaAdd(&catalogDeltaP, entityType, NULL, NULL, 1);
 
   for (unsigned int ix = 0; ix < attrsV.size(); ++ix)
   {
@@ -3174,6 +3464,8 @@ static bool createEntity
 
     attrsToAdd.append(effectiveName, bsonAttr.obj());
     attrNamesToAdd.append(attrsV[ix]->name);
+
+    catalogDeltaAdd(&catalogDeltaP, entityType, effectiveName, attrType.c_str(), 1);
   }
 
   BSONObjBuilder bsonId;
@@ -3223,8 +3515,9 @@ static bool createEntity
   /* Add location information in the case it was found */
   if (locAttr.length() > 0)
   {
+    *locationP = geoJson.obj();
     insertedDoc.append(ENT_LOCATION, BSON(ENT_LOCATION_ATTRNAME << locAttr <<
-                                          ENT_LOCATION_COORDS   << geoJson.obj()));
+                                          ENT_LOCATION_COORDS   << *locationP));
   }
 
 
@@ -3249,12 +3542,16 @@ static bool createEntity
   }
 
 
-  if (!collectionInsert(tenantP->entities, insertedDoc.obj(), errDetail))
+  if (orionldState.entitiesBulkP != NULL)
+    entitiesBulkAdd(eP->id, NULL, insertedDoc.obj(), catalogDeltaP);
+  else if (!collectionInsert(tenantP->entities, insertedDoc.obj(), errDetail))
   {
     LM_E(("Internal Error (%s)", errDetail->c_str()));
     oeP->fill(SccReceiverInternalError, *errDetail, "InternalError");
     return false;
   }
+  else
+    catalogDeltaMerge(&orionldState.catalogDeltaP, catalogDeltaP);
 
   return true;
 }
@@ -3452,7 +3749,15 @@ static void updateEntity
   /* If the vector of Context Attributes is empty and the operation was DELETE, then delete the entity */
   if ((action == ActionTypeDelete) && (ceP->contextAttributeVector.size() == 0))
   {
-    removeEntity(entityId, entityType, cerP, tenantP, entitySPath, &(responseP->oe));
+    if (removeEntity(entityId, entityType, cerP, tenantP, entitySPath, &(responseP->oe)) == true)
+    {
+      BSONObj attrs;
+
+      getObjectFieldF(&attrs, bobP, ENT_ATTRS);
+      catalogDeltaAdd(&orionldState.catalogDeltaP, entityType.c_str(), NULL, NULL, -1);
+      catalogAttrsDeltaAdd(&orionldState.catalogDeltaP, entityType.c_str(), attrs, -1);
+    }
+
     responseP->contextElementResponseVector.push_back(cerP);
     return;
   }
@@ -3480,6 +3785,7 @@ static void updateEntity
   std::string     locAttr = "";
   BSONObj         currentGeoJson;
   BSONObjBuilder  geoJson;
+  BSONObj         finalGeoJson;    // Location after the update - for the geo-filters of the subscriptions
 
   if (bobP->hasField(ENT_LOCATION))
   {
@@ -3561,6 +3867,7 @@ static void updateEntity
                                      cerP,
                                      &locAttr,
                                      &geoJson,
+                                     &currentGeoJson,
                                      &currentDateExpiration,
                                      &dateExpirationInPayload,
                                      tenantP,
@@ -3622,7 +3929,7 @@ static void updateEntity
 
     // If processContextAttributeVector() didn't touched the geoJson, then we
     // use the existing object
-    BSONObj finalGeoJson = newGeoJson.nFields() > 0 ? newGeoJson : currentGeoJson;
+    finalGeoJson = newGeoJson.nFields() > 0 ? newGeoJson : currentGeoJson;
 
     toSet.append(ENT_LOCATION, BSON(ENT_LOCATION_ATTRNAME << locAttr <<
                                     ENT_LOCATION_COORDS   << finalGeoJson));
@@ -3732,7 +4039,12 @@ static void updateEntity
   query.append(servicePathString, fillQueryServicePath(servicePathV));
 
   std::string err;
-  if (!collectionUpdate(tenantP->entities, query.obj(), updatedEntityObj, false, &err))
+  BSONObj     queryObj      = query.obj();
+  KjNode*     catalogDeltaP = catalogUpdateDelta(entityType.c_str(), attrs, toSetObj, toUnsetObj, action == ActionTypeReplace);
+
+  if (orionldState.entitiesBulkP != NULL)
+    entitiesBulkAdd(entityId, &queryObj, updatedEntityObj, catalogDeltaP);
+  else if (!collectionUpdate(tenantP->entities, queryObj, updatedEntityObj, false, &err))
   {
     cerP->statusCode.fill(SccReceiverInternalError, err);
     responseP->oe.fill(SccReceiverInternalError, err, "InternalServerError");
@@ -3746,12 +4058,20 @@ static void updateEntity
 
     return;
   }
+  else
+    catalogDeltaMerge(&orionldState.catalogDeltaP, catalogDeltaP);
 
   /* Send notifications for each one of the ONCHANGE subscriptions accumulated by
-   * previous addTriggeredSubscriptions() invocations */
-  processSubscriptions(subsToNotify, notifyCerP, &err, tenantP, xauthToken, fiwareCorrelator);
-  notifyCerP->release();
-  delete notifyCerP;
+   * previous addTriggeredSubscriptions() invocations.
+   * For BATCH operations, not until the bulk write is done, and only if the write succeeds (entitiesBulkNotify) */
+  if ((orionldState.entitiesBulkP != NULL) && (subsToNotify.size() > 0))
+    entitiesBulkNotificationAdd(subsToNotify, notifyCerP, &finalGeoJson);
+  else
+  {
+    processSubscriptions(subsToNotify, notifyCerP, &err, tenantP, xauthToken, fiwareCorrelator, &finalGeoJson);
+    notifyCerP->release();
+    delete notifyCerP;
+  }
 
   //
   // processSubscriptions cleans up the triggered subscriptions; this call here to
@@ -3884,6 +4204,150 @@ static void setActionType(ContextElementResponse* notifyCerP, const std::string&
 
 
 
+/* ****************************************************************************
+*
+* entitiesQuery -
+*
+* Going through the list of found entities.
+* As ServicePath cannot be modified, inside this loop nothing will be done
+* about ServicePath (The ServicePath was present in the mongo query to obtain the list)
+*
+* FIXME P6: Once we allow for ServicePath to be modified, this loop must be looked at.
+*/
+static bool entitiesQuery(OrionldTenant* tenantP, const BSONObj& query, std::vector<BSONObj>* resultsP, std::string* errP)
+{
+  std::auto_ptr<DBClientCursor>  cursor;
+
+  TIME_STAT_MONGO_READ_WAIT_START();
+  DBClientBase* connection = getMongoConnection();
+
+  if (!collectionQuery(connection, tenantP->entities, query, &cursor, errP))
+  {
+    releaseMongoConnection(connection);
+    TIME_STAT_MONGO_READ_WAIT_STOP();
+    return false;
+  }
+  TIME_STAT_MONGO_READ_WAIT_STOP();
+
+  while (moreSafe(cursor))
+  {
+    BSONObj r;
+
+    if (!nextSafeOrErrorF(cursor, &r, errP))
+    {
+      LM_E(("Runtime Error (exception in nextSafe(): %s - query: %s)", errP->c_str(), query.toString().c_str()));
+      continue;
+    }
+
+    BSONElement idField = getFieldF(&r, "_id");
+
+    //
+    // BSONElement::eoo returns true if 'not found', i.e. the field "_id" doesn't exist in 'sub'
+    //
+    // Now, if 'getFieldF(r, "_id")' is not found, if we continue, calling embeddedObject() on it, then we get
+    // an exception and the broker crashes.
+    //
+    if (idField.eoo() == true)
+    {
+      std::string details = std::string("error retrieving _id field in doc: '") + r.toString() + "'";
+      alarmMgr.dbError(details);
+      continue;
+    }
+
+    //
+    // We need to use getOwned() here, otherwise we have empirically found that bad things may happen with long BSONObjs
+    // (see http://stackoverflow.com/questions/36917731/context-broker-crashing-with-certain-update-queries)
+    //
+    resultsP->push_back(r.getOwned());
+  }
+
+  releaseMongoConnection(connection);
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* entitiesPrefetch -
+*
+* Instead of one query per entity (processContextElement), all entities of a BATCH operation are looked up
+* in one single query: { "_id.id": { "$in": [ ID1, ID2, ... ] }, "_id.servicePath": ... }
+* The entity type (and ?!exist=entity::type) is matched later, in entitiesPrefetchMatch.
+*/
+bool entitiesPrefetch
+(
+  UpdateContextRequest*                requestP,
+  OrionldTenant*                       tenantP,
+  const std::vector<std::string>&      servicePathV,
+  EntitiesPrefetch*                    prefetchP,
+  std::string*                         errP
+)
+{
+  BSONObjBuilder        bob;
+  BSONArrayBuilder      ids;
+  std::vector<BSONObj>  results;
+
+  for (unsigned int ix = 0; ix < requestP->contextElementVector.size(); ++ix)
+  {
+    ids.append(requestP->contextElementVector[ix]->entityId.id);
+  }
+
+  bob.append("_id." ENT_ENTITY_ID, BSON("$in" << ids.arr()));
+  bob.append("_id." ENT_SERVICE_PATH, fillQueryServicePath(servicePathV));
+
+  if (entitiesQuery(tenantP, bob.obj(), &results, errP) == false)
+    return false;
+
+  for (unsigned int ix = 0; ix < results.size(); ++ix)
+  {
+    BSONObj idObj;
+
+    if (getObjectFieldF(&idObj, &results[ix], "_id") == false)
+      continue;
+
+    (*prefetchP)[getStringFieldF(&idObj, ENT_ENTITY_ID)].push_back(results[ix]);
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* entitiesPrefetchMatch - the prefetched entities that the query of processContextElement would have found
+*/
+static void entitiesPrefetchMatch(const EntitiesPrefetch* prefetchP, EntityId* enP, std::vector<BSONObj>* resultsP)
+{
+  EntitiesPrefetch::const_iterator iter = prefetchP->find(enP->id);
+
+  if (iter == prefetchP->end())
+    return;
+
+  bool noType = (orionldState.uriParams.notExists != NULL) && (strcmp(orionldState.uriParams.notExists, SCOPE_VALUE_ENTITY_TYPE) == 0);
+
+  for (unsigned int ix = 0; ix < iter->second.size(); ++ix)
+  {
+    const BSONObj*  rP = &iter->second[ix];
+    BSONObj         idObj;
+
+    if (getObjectFieldF(&idObj, rP, "_id") == false)
+      continue;
+
+    if ((enP->type != "") && (strcmp(getStringFieldF(&idObj, ENT_ENTITY_TYPE), enP->type.c_str()) != 0))
+      continue;
+
+    if ((noType == true) && (idObj.hasField(ENT_ENTITY_TYPE)))
+      continue;
+
+    resultsP->push_back(*rP);
+  }
+}
+
+
+
 /* ****************************************************************************
 *
 * processContextElement -
@@ -3902,7 +4366,8 @@ void processContextElement
   const char*                          fiwareCorrelator,
   const std::string&                   ngsiV2AttrsFormat,
   ApiVersion                           apiVersion,
-  Ngsiv2Flavour                        ngsiv2Flavour
+  Ngsiv2Flavour                        ngsiv2Flavour,
+  const EntitiesPrefetch*              prefetchP
 )
 {
   /* Check preconditions */
@@ -3941,8 +4406,7 @@ void processContextElement
     bob.appendElements(b);
   }
 
-  BSONObj                        query = bob.obj();
-  std::auto_ptr<DBClientCursor>  cursor;
+  BSONObj query = bob.obj();
 
   // Several checks related to NGSIv2
   if (apiVersion == V2)
@@ -3984,68 +4448,18 @@ void processContextElement
     }
   }
 
-  std::string err;
-
-  TIME_STAT_MONGO_READ_WAIT_START();
-  DBClientBase* connection = getMongoConnection();
+  std::string           err;
+  std::vector<BSONObj>  results;
 
-  if (!collectionQuery(connection, tenantP->entities, query, &cursor, &err))
+  if (prefetchP != NULL)
+    entitiesPrefetchMatch(prefetchP, enP, &results);
+  else if (entitiesQuery(tenantP, query, &results, &err) == false)
   {
-    releaseMongoConnection(connection);
-    TIME_STAT_MONGO_READ_WAIT_STOP();
     buildGeneralErrorResponse(ceP, NULL, responseP, SccReceiverInternalError, err);
     responseP->oe.fill(SccReceiverInternalError, err, "InternalServerError");
 
     return;
   }
-  TIME_STAT_MONGO_READ_WAIT_STOP();
-
-  //
-  // Going through the list of found entities.
-  // As ServicePath cannot be modified, inside this loop nothing will be done
-  // about ServicePath (The ServicePath was present in the mongo query to obtain the list)
-  //
-  // FIXME P6: Once we allow for ServicePath to be modified, this loop must be looked at.
-  //
-
-  std::vector<BSONObj> results;
-  unsigned int         docs = 0;
-
-  while (moreSafe(cursor))
-  {
-    BSONObj r;
-
-    if (!nextSafeOrErrorF(cursor, &r, &err))
-    {
-      LM_E(("Runtime Error (exception in nextSafe(): %s - query: %s)", err.c_str(), query.toString().c_str()));
-      continue;
-    }
-
-    docs++;
-
-    BSONElement idField = getFieldF(&r, "_id");
-
-    //
-    // BSONElement::eoo returns true if 'not found', i.e. the field "_id" doesn't exist in 'sub'
-    //
-    // Now, if 'getFieldF(r, "_id")' is not found, if we continue, calling embeddedObject() on it, then we get
-    // an exception and the broker crashes.
-    //
-    if (idField.eoo() == true)
-    {
-      std::string details = std::string("error retrieving _id field in doc: '") + r.toString() + "'";
-      alarmMgr.dbError(details);
-      continue;
-    }
-
-    //
-    // We need to use getOwned() here, otherwise we have empirically found that bad things may happen with long BSONObjs
-    // (see http://stackoverflow.com/questions/36917731/context-broker-crashing-with-certain-update-queries)
-    //
-    results.push_back(r.getOwned());
-  }
-
-  releaseMongoConnection(connection);
 
   // Used to accumulate error response information, checked at the end
   bool         attributeAlreadyExistsError = false;
@@ -4137,8 +4551,9 @@ void processContextElement
     {
       std::string  errReason;
       std::string  errDetail;
+      BSONObj      location;
 
-      if (!createEntity(enP, ceP->contextAttributeVector, orionldState.requestTime, &errDetail, tenantP, servicePathV, apiVersion, fiwareCorrelator, &(responseP->oe)))
+      if (!createEntity(enP, ceP->contextAttributeVector, orionldState.requestTime, &errDetail, tenantP, servicePathV, apiVersion, fiwareCorrelator, &(responseP->oe), &location))
       {
         LM_E(("Internal Error (createEntity failed)"));
         cerP->statusCode.fill(SccInvalidParameter, errDetail);
@@ -4163,7 +4578,8 @@ void processContextElement
                                        subsToNotify,
                                        err,
                                        tenantP,
-                                       servicePathV))
+                                       servicePathV,
+                                       &location))
         {
           releaseTriggeredSubscriptions(&subsToNotify);
           cerP->statusCode.fill(SccReceiverInternalError, err);
@@ -4194,10 +4610,18 @@ void processContextElement
         }
 
         notifyCerP->contextElement.entityId.servicePath = servicePathV.size() > 0? servicePathV[0] : "";
-        processSubscriptions(subsToNotify, notifyCerP, &errReason, tenantP, xauthToken, fiwareCorrelator);
 
-        notifyCerP->release();
-        delete notifyCerP;
+        // For BATCH operations, the notifications are sent after the bulk write, and only if the write succeeds (entitiesBulkNotify)
+        if ((orionldState.entitiesBulkP != NULL) && (subsToNotify.size() > 0))
+          entitiesBulkNotificationAdd(subsToNotify, notifyCerP, &location);
+        else
+        {
+          processSubscriptions(subsToNotify, notifyCerP, &errReason, tenantP, xauthToken, fiwareCorrelator, &location);
+
+          notifyCerP->release();
+          delete notifyCerP;
+        }
+
         releaseTriggeredSubscriptions(&subsToNotify);
       }
 
@@ -32,11 +32,50 @@
 #include "mongo/client/dbclient.h"
 
 #include "orionld/types/OrionldTenant.h"                           // OrionldTenant
+#include "orionld/types/OrionldEntitiesBulk.h"                     // OrionldEntitiesBulk
 #include "orionTypes/UpdateActionType.h"
+#include "ngsi10/UpdateContextRequest.h"
 #include "ngsi10/UpdateContextResponse.h"
 
 
 
+/* ****************************************************************************
+*
+* EntitiesPrefetch - the entities of a BATCH operation, found in the DB with one single query, key: entity id
+*/
+typedef std::map<std::string, std::vector<mongo::BSONObj> > EntitiesPrefetch;
+
+
+
+/* ****************************************************************************
+*
+* entitiesPrefetch -
+*/
+extern bool entitiesPrefetch
+(
+  UpdateContextRequest*                requestP,
+  OrionldTenant*                       tenantP,
+  const std::vector<std::string>&      servicePathV,
+  EntitiesPrefetch*                    prefetchP,
+  std::string*                         errP
+);
+
+
+
+/* ****************************************************************************
+*
+* entitiesBulkNotify -
+*/
+extern void entitiesBulkNotify
+(
+  OrionldEntitiesBulk*                 bulkP,
+  OrionldTenant*                       tenantP,
+  const char*                          xauthToken,
+  const char*                          fiwareCorrelator
+);
+
+
+
 /* ****************************************************************************
 *
 * processContextElement -
@@ -52,7 +91,8 @@ extern void processContextElement
   const char*                          fiwareCorrelator,
   const std::string&                   ngsiV2AttrsFormat,
   ApiVersion                           apiVersion       = V1,
-  Ngsiv2Flavour                        ngsiV2Flavour    = NGSIV2_NO_FLAVOUR
+  Ngsiv2Flavour                        ngsiV2Flavour    = NGSIV2_NO_FLAVOUR,
+  const EntitiesPrefetch*              prefetchP        = NULL
 );
 
 #endif  // SRC_LIB_MONGOBACKEND_MONGOCOMMONUPDATE_H_
@@ -59,6 +59,7 @@ TriggeredSubscription::TriggeredSubscription
   tenantP(&tenant0),
   stringFilterP(NULL),
   mdStringFilterP(NULL),
+  geoFilterP(NULL),
   blacklist(false)
 {
 }
@@ -87,6 +88,7 @@ TriggeredSubscription::TriggeredSubscription
   tenantP(&tenant0),
   stringFilterP(NULL),
   mdStringFilterP(NULL),
+  geoFilterP(NULL),
   blacklist(false)
 {
 }
@@ -110,6 +112,12 @@ TriggeredSubscription::~TriggeredSubscription()
     delete mdStringFilterP;
     mdStringFilterP = NULL;
   }
+
+  if (geoFilterP != NULL)
+  {
+    delete geoFilterP;
+    geoFilterP = NULL;
+  }
 }
 
 
@@ -174,3 +182,14 @@ bool TriggeredSubscription::mdStringFilterSet(StringFilter* _stringFilterP, std:
 
   return (mdStringFilterP == NULL)? false : true;
 }
+
+
+
+/* ****************************************************************************
+*
+* TriggeredSubscription::geoFilterSet -
+*/
+void TriggeredSubscription::geoFilterSet(const GeoFilter* _geoFilterP)
+{
+  geoFilterP = _geoFilterP->clone();
+}
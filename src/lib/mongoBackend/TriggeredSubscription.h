@@ -33,6 +33,7 @@
 #include "common/RenderFormat.h"
 #include "ngsi/StringList.h"
 #include "rest/StringFilter.h"
+#include "rest/GeoFilter.h"
 
 
 
@@ -62,6 +63,7 @@ class TriggeredSubscription
   OrionldTenant*            tenantP;
   StringFilter*             stringFilterP;
   StringFilter*             mdStringFilterP;
+  GeoFilter*                geoFilterP;
   bool                      blacklist;
   std::vector<std::string>  metadata;
 
@@ -90,6 +92,7 @@ class TriggeredSubscription
   void         fillExpression(const std::string& georel, const std::string& geometry, const std::string& coords);
   bool         stringFilterSet(StringFilter* _stringFilterP, std::string* errorStringP);
   bool         mdStringFilterSet(StringFilter* _stringFilterP, std::string* errorStringP);
+  void         geoFilterSet(const GeoFilter* _geoFilterP);
   std::string  toString(const std::string& delimiter);
 };
 
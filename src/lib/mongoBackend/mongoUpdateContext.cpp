@@ -38,15 +38,66 @@
 #include "ngsi/NotifyCondition.h"
 #include "rest/HttpStatusCode.h"
 
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/types/OrionldEntitiesBulk.h"                   // OrionldEntitiesBulk, OrionldBulkOp
+#include "orionld/mongoc/mongocEntitiesBulkWrite.h"              // mongocEntitiesBulkWrite
+#include "orionld/common/catalogDeltaMerge.h"                    // catalogDeltaMerge
+
 #include "mongoBackend/MongoGlobal.h"
 #include "mongoBackend/MongoCommonUpdate.h"
 #include "mongoBackend/mongoUpdateContext.h"
 
 
 
+/* ****************************************************************************
+*
+* bulkErrorsToResponse - the entity writes that failed in the bulk write are errors in the response
+*/
+static void bulkErrorsToResponse(OrionldEntitiesBulk* bulkP, UpdateContextResponse* responseP)
+{
+  for (OrionldBulkOp* opP = bulkP->first; opP != NULL; opP = opP->next)
+  {
+    if (opP->error == NULL)
+      continue;
+
+    for (unsigned int ix = 0; ix < responseP->contextElementResponseVector.size(); ++ix)
+    {
+      ContextElementResponse* cerP = responseP->contextElementResponseVector[ix];
+
+      if (cerP->contextElement.entityId.id == opP->entityId)
+      {
+        cerP->statusCode.fill(SccReceiverInternalError, opP->error);
+        break;
+      }
+    }
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* catalogDeltaCollect - the entity catalog deltas of the entity writes that made it to the database
+*/
+static void catalogDeltaCollect(OrionldEntitiesBulk* bulkP)
+{
+  for (OrionldBulkOp* opP = bulkP->first; opP != NULL; opP = opP->next)
+  {
+    if (opP->error == NULL)
+      catalogDeltaMerge(&orionldState.catalogDeltaP, opP->catalogP);
+  }
+}
+
+
+
 /* ****************************************************************************
 *
 * mongoUpdateContext - 
+*
+* For BATCH operations (orionldState.entitiesBulkP set):
+*   - all entities are looked up in the DB with one single query (entitiesPrefetch)
+*   - the entity inserts/updates are collected and sent to the DB in one single bulk write (mongocEntitiesBulkWrite)
+*   - the notifications are sent after the bulk write, for the entities whose write succeeded (entitiesBulkNotify)
 */
 HttpStatusCode mongoUpdateContext
 (
@@ -79,6 +130,19 @@ HttpStatusCode mongoUpdateContext
   }
   else
   {
+    EntitiesPrefetch   prefetch;
+    EntitiesPrefetch*  prefetchP = NULL;
+
+    if (orionldState.entitiesBulkP != NULL)
+    {
+      std::string err;
+
+      if (entitiesPrefetch(requestP, tenantP, servicePathV, &prefetch, &err) == true)
+        prefetchP = &prefetch;
+      else
+        LM_E(("Database Error (prefetching the entities of a batch operation: %s)", err.c_str()));  // One query per entity instead
+    }
+
     /* Process each ContextElement */
     for (unsigned int ix = 0; ix < requestP->contextElementVector.size(); ++ix)
     {
@@ -91,7 +155,17 @@ HttpStatusCode mongoUpdateContext
                             fiwareCorrelator,
                             ngsiV2AttrsFormat,
                             apiVersion,
-                            ngsiv2Flavour);
+                            ngsiv2Flavour,
+                            prefetchP);
+    }
+
+    if (orionldState.entitiesBulkP != NULL)
+    {
+      if (mongocEntitiesBulkWrite(orionldState.entitiesBulkP) == false)
+        bulkErrorsToResponse(orionldState.entitiesBulkP, responseP);
+
+      catalogDeltaCollect(orionldState.entitiesBulkP);
+      entitiesBulkNotify(orionldState.entitiesBulkP, tenantP, xauthToken, fiwareCorrelator);
     }
 
     /* Note that although individual processContextElements() invocations return ConnectionError, this
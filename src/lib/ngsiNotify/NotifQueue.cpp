@@ -0,0 +1,382 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                       // pthread_*
+#include <stdio.h>                                         // snprintf
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/limits.h"                                 // STRING_SIZE_FOR_INT
+#include "ngsiNotify/senderThread.h"                       // SenderThreadParams
+#include "ngsiNotify/NotifQueue.h"                         // Own interface
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::NotifQueue -
+*/
+NotifQueue::NotifQueue(size_t _subQueueSize, int _tenantQuota): subQueueSize(_subQueueSize), tenantQuota(_tenantQuota), subQueues(0), cursor(0), items(0), sleepers(0)
+{
+  pthread_rwlock_init(&mapLock, NULL);
+  pthread_mutex_init(&sleepMutex, NULL);
+  pthread_cond_init(&sleepCond, NULL);
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::~NotifQueue -
+*/
+NotifQueue::~NotifQueue()
+{
+  NotifQueueItem itemV[NOTIF_QUEUE_QUANTUM];
+  size_t         n;
+
+  while ((n = try_pop(itemV, NOTIF_QUEUE_QUANTUM)) > 0)
+  {
+    for (size_t ix = 0; ix < n; ix++)
+    {
+      for (unsigned int pIx = 0; pIx < itemV[ix]->size(); pIx++)
+      {
+        delete (*itemV[ix])[pIx];
+      }
+
+      delete itemV[ix];
+    }
+  }
+
+  for (int ix = 0; ix < subQueues; ix++)
+  {
+    delete subQueueV[ix];
+  }
+
+  for (std::map<std::string, int*>::iterator it = tenantMap.begin(); it != tenantMap.end(); ++it)
+  {
+    delete it->second;
+  }
+
+  pthread_cond_destroy(&sleepCond);
+  pthread_mutex_destroy(&sleepMutex);
+  pthread_rwlock_destroy(&mapLock);
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::subQueueGet - lookup the sub-queue of an endpoint, creating it if needed
+*
+* Sub-queues are never removed, and the slots of subQueueV are published before 'subQueues' is
+* incremented, so the workers can iterate over subQueueV[0 .. subQueues-1] without taking any lock.
+*/
+NotifSubQueue* NotifQueue::subQueueGet(const std::string& endpoint)
+{
+  std::map<std::string, NotifSubQueue*>::iterator  it;
+  NotifSubQueue*                                   subQueueP = NULL;
+
+  pthread_rwlock_rdlock(&mapLock);
+  it = subQueueMap.find(endpoint);
+  if (it != subQueueMap.end())
+    subQueueP = it->second;
+  pthread_rwlock_unlock(&mapLock);
+
+  if (subQueueP != NULL)
+    return subQueueP;
+
+  pthread_rwlock_wrlock(&mapLock);
+
+  it = subQueueMap.find(endpoint);
+  if (it != subQueueMap.end())
+    subQueueP = it->second;
+  else if (subQueues < NOTIF_QUEUE_MAX_SUBQUEUES - 1)
+  {
+    subQueueP = new NotifSubQueue(endpoint, subQueueSize, NOTIF_QUEUE_QUANTUM);
+
+    subQueueV[subQueues] = subQueueP;
+    subQueueMap[endpoint] = subQueueP;
+    __atomic_store_n(&subQueues, subQueues + 1, __ATOMIC_RELEASE);
+  }
+  else
+  {
+    // Out of sub-queues - the endpoint shares the overflow sub-queue with all other latecomers
+    it = subQueueMap.find(NOTIF_QUEUE_OVERFLOW_ENDPOINT);
+    if (it != subQueueMap.end())
+      subQueueP = it->second;
+    else
+    {
+      subQueueP = new NotifSubQueue(NOTIF_QUEUE_OVERFLOW_ENDPOINT, subQueueSize, NOTIF_QUEUE_QUANTUM);
+
+      subQueueV[subQueues] = subQueueP;
+      subQueueMap[NOTIF_QUEUE_OVERFLOW_ENDPOINT] = subQueueP;
+      __atomic_store_n(&subQueues, subQueues + 1, __ATOMIC_RELEASE);
+    }
+
+    subQueueMap[endpoint] = subQueueP;
+  }
+
+  pthread_rwlock_unlock(&mapLock);
+
+  return subQueueP;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::tenantCounterGet - lookup the counter of queued notifications of a tenant, creating it if needed
+*/
+int* NotifQueue::tenantCounterGet(const std::string& tenant)
+{
+  std::map<std::string, int*>::iterator  it;
+  int*                                   counterP = NULL;
+
+  pthread_rwlock_rdlock(&mapLock);
+  it = tenantMap.find(tenant);
+  if (it != tenantMap.end())
+    counterP = it->second;
+  pthread_rwlock_unlock(&mapLock);
+
+  if (counterP != NULL)
+    return counterP;
+
+  pthread_rwlock_wrlock(&mapLock);
+
+  it = tenantMap.find(tenant);
+  if (it != tenantMap.end())
+    counterP = it->second;
+  else
+  {
+    counterP          = new int(0);
+    tenantMap[tenant] = counterP;
+  }
+
+  pthread_rwlock_unlock(&mapLock);
+
+  return counterP;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::try_push - returns false if the sub-queue of the endpoint is full or the tenant is over its quota
+*
+* All notifications of an item go to the same subscription, i.e. to the same endpoint and tenant,
+* so the first one decides.
+*/
+bool NotifQueue::try_push(NotifQueueItem item)
+{
+  int              notifications  = item->size();
+  std::string      endpoint       = NOTIF_QUEUE_OVERFLOW_ENDPOINT;
+  std::string      tenant;
+  NotifSubQueue*   subQueueP;
+  int*             tenantCounterP = NULL;
+
+  if (notifications > 0)
+  {
+    SenderThreadParams*  paramsP = (*item)[0];
+    char                 portV[STRING_SIZE_FOR_INT];
+
+    snprintf(portV, sizeof(portV), "%d", paramsP->port);
+    endpoint = paramsP->ip + ":" + portV;
+    tenant   = paramsP->tenant;
+  }
+
+  subQueueP = subQueueGet(endpoint);
+
+  if (tenantQuota > 0)
+  {
+    tenantCounterP = tenantCounterGet(tenant);
+
+    int queued = __sync_add_and_fetch(tenantCounterP, notifications);
+
+    // An item larger than the quota is accepted if the tenant has nothing else in the queue
+    if ((queued > tenantQuota) && (queued != notifications))
+    {
+      __sync_fetch_and_sub(tenantCounterP, notifications);
+      __sync_fetch_and_add(&subQueueP->reject, notifications);
+      return false;
+    }
+  }
+
+  NotifQueueEntry entry = { item, tenantCounterP, notifications };
+
+  if (subQueueP->ring.try_push(entry) == false)
+  {
+    if (tenantCounterP != NULL)
+      __sync_fetch_and_sub(tenantCounterP, notifications);
+
+    __sync_fetch_and_add(&subQueueP->reject, notifications);
+    return false;
+  }
+
+  __sync_fetch_and_add(&subQueueP->in, notifications);
+  __sync_fetch_and_add(&items, 1);
+
+  //
+  // Both 'items' and 'sleepers' are modified with full barriers, so either we see the sleeper here,
+  // or the sleeper sees the new item before going to sleep (see NotifQueue::pop)
+  //
+  if (__sync_fetch_and_add(&sleepers, 0) > 0)
+  {
+    pthread_mutex_lock(&sleepMutex);
+    pthread_cond_signal(&sleepCond);
+    pthread_mutex_unlock(&sleepMutex);
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::try_pop - take up to 'max' items of the next non-empty sub-queue, without waiting
+*
+* The sub-queues are visited in round-robin, using a cursor shared by all workers, and at most
+* 'weight' items are taken from a sub-queue per visit.
+* Returns the number of items taken - zero if the queue is empty.
+*/
+size_t NotifQueue::try_pop(NotifQueueItem* itemV, size_t max)
+{
+  NotifQueueEntry  entryV[NOTIF_QUEUE_QUANTUM];
+  int              n;
+
+  if (max > NOTIF_QUEUE_QUANTUM)
+    max = NOTIF_QUEUE_QUANTUM;
+
+  if ((max == 0) || (__sync_fetch_and_add(&items, 0) == 0))
+    return 0;
+
+  n = __atomic_load_n(&subQueues, __ATOMIC_ACQUIRE);
+
+  for (int visit = 0; visit < n; visit++)
+  {
+    NotifSubQueue*  subQueueP = subQueueV[__sync_fetch_and_add(&cursor, 1) % n];
+    size_t          batch     = ((size_t) subQueueP->weight < max)? (size_t) subQueueP->weight : max;
+    size_t          popped    = subQueueP->ring.pop_batch(entryV, batch);
+
+    if (popped == 0)
+      continue;
+
+    for (size_t ix = 0; ix < popped; ix++)
+    {
+      itemV[ix] = entryV[ix].item;
+
+      if (entryV[ix].tenantCounterP != NULL)
+        __sync_fetch_and_sub(entryV[ix].tenantCounterP, entryV[ix].notifications);
+    }
+
+    __sync_fetch_and_sub(&items, (int) popped);
+    return popped;
+  }
+
+  return 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::pop - like try_pop, but waits until there is something to take
+*/
+size_t NotifQueue::pop(NotifQueueItem* itemV, size_t max)
+{
+  for (;;)
+  {
+    size_t n = try_pop(itemV, max);
+
+    if (n > 0)
+      return n;
+
+    pthread_mutex_lock(&sleepMutex);
+    __sync_fetch_and_add(&sleepers, 1);
+
+    if (__sync_fetch_and_add(&items, 0) == 0)
+      pthread_cond_wait(&sleepCond, &sleepMutex);
+
+    __sync_fetch_and_sub(&sleepers, 1);
+    pthread_mutex_unlock(&sleepMutex);
+  }
+
+  return 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::size - number of items in the queue, all sub-queues included
+*/
+size_t NotifQueue::size(void)
+{
+  int n = __sync_fetch_and_add(&items, 0);
+
+  return (n > 0)? (size_t) n : 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::subQueuesGet -
+*/
+void NotifQueue::subQueuesGet(std::vector<NotifSubQueueInfo>* infoV)
+{
+  int n = __atomic_load_n(&subQueues, __ATOMIC_ACQUIRE);
+
+  for (int ix = 0; ix < n; ix++)
+  {
+    NotifSubQueue*     subQueueP = subQueueV[ix];
+    NotifSubQueueInfo  info;
+
+    info.endpoint = subQueueP->endpoint;
+    info.size     = subQueueP->ring.size();
+    info.in       = __sync_fetch_and_add(&subQueueP->in, 0);
+    info.reject   = __sync_fetch_and_add(&subQueueP->reject, 0);
+
+    infoV->push_back(info);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue::statisticsReset -
+*/
+void NotifQueue::statisticsReset(void)
+{
+  int n = __atomic_load_n(&subQueues, __ATOMIC_ACQUIRE);
+
+  for (int ix = 0; ix < n; ix++)
+  {
+    __sync_fetch_and_and(&subQueueV[ix]->in, 0);
+    __sync_fetch_and_and(&subQueueV[ix]->reject, 0);
+  }
+}
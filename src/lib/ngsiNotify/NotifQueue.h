@@ -0,0 +1,169 @@
+#ifndef SRC_LIB_NGSINOTIFY_NOTIFQUEUE_H_
+#define SRC_LIB_NGSINOTIFY_NOTIFQUEUE_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/MpmcRing.h"
+#include "ngsiNotify/senderThread.h"
+
+
+
+/* ****************************************************************************
+*
+* NOTIF_QUEUE_QUANTUM - max number of queue items a worker takes from one sub-queue per round-robin visit
+*/
+#define NOTIF_QUEUE_QUANTUM  4
+
+
+
+/* ****************************************************************************
+*
+* NOTIF_QUEUE_MAX_SUBQUEUES - max number of sub-queues
+*
+* The last sub-queue is shared by all endpoints that arrive once all the others are taken.
+*/
+#define NOTIF_QUEUE_MAX_SUBQUEUES  1024
+
+
+
+/* ****************************************************************************
+*
+* NOTIF_QUEUE_OVERFLOW_ENDPOINT - name of the shared sub-queue
+*/
+#define NOTIF_QUEUE_OVERFLOW_ENDPOINT  "*"
+
+
+
+/* ****************************************************************************
+*
+* NotifQueueItem -
+*/
+typedef std::vector<SenderThreadParams*>* NotifQueueItem;
+
+
+
+/* ****************************************************************************
+*
+* NotifQueueEntry - what is actually stored in the rings
+*
+* The tenant counter travels with the item, so that the consumer side needs no lookup.
+*/
+typedef struct NotifQueueEntry
+{
+  NotifQueueItem  item;
+  int*            tenantCounterP;
+  int             notifications;
+} NotifQueueEntry;
+
+
+
+/* ****************************************************************************
+*
+* NotifSubQueue - one per endpoint (host:port)
+*/
+typedef struct NotifSubQueue
+{
+  std::string                endpoint;
+  int                        weight;   // max items taken per round-robin visit
+  MpmcRing<NotifQueueEntry>  ring;
+  int                        in;
+  int                        reject;
+
+  NotifSubQueue(const std::string& _endpoint, size_t size, int _weight): endpoint(_endpoint), weight(_weight), ring(size), in(0), reject(0) {}
+} NotifSubQueue;
+
+
+
+/* ****************************************************************************
+*
+* NotifSubQueueInfo - statistics of a sub-queue
+*/
+typedef struct NotifSubQueueInfo
+{
+  std::string  endpoint;
+  size_t       size;
+  int          in;
+  int          reject;
+} NotifSubQueueInfo;
+
+
+
+/* ****************************************************************************
+*
+* NotifQueue - the notification queue of the threadpool notification mode
+*
+* The queue is split in one bounded lock-free ring (sub-queue) per notification endpoint, each one of
+* 'subQueueSize' items. The workers serve the sub-queues in round-robin, taking at most 'weight' items
+* of a sub-queue per visit, so an endpoint with a huge backlog (or a slow receiver) can't starve the others.
+*
+* If 'tenantQuota' is non-zero, a tenant can't have more than that many notifications in the queue.
+*
+* The workers take no lock at all to dequeue. The producers take a read lock to find the sub-queue of the
+* endpoint (and the counter of the tenant), and a write lock only the first time an endpoint or a tenant is seen.
+* Workers that find the queue empty sleep on a condition variable that the producers only signal if
+* someone is sleeping.
+*/
+class NotifQueue
+{
+public:
+  NotifQueue(size_t _subQueueSize, int _tenantQuota);
+  ~NotifQueue();
+
+  bool    try_push(NotifQueueItem item);
+  size_t  pop(NotifQueueItem* itemV, size_t max);
+  size_t  try_pop(NotifQueueItem* itemV, size_t max);
+  size_t  size(void);
+
+  void    subQueuesGet(std::vector<NotifSubQueueInfo>* infoV);
+  void    statisticsReset(void);
+
+private:
+  NotifSubQueue*  subQueueGet(const std::string& endpoint);
+  int*            tenantCounterGet(const std::string& tenant);
+
+  size_t                        subQueueSize;
+  int                           tenantQuota;
+
+  NotifSubQueue*                subQueueV[NOTIF_QUEUE_MAX_SUBQUEUES];
+  int                           subQueues;
+  unsigned int                  cursor;
+  int                           items;
+
+  std::map<std::string, NotifSubQueue*>  subQueueMap;
+  std::map<std::string, int*>            tenantMap;
+  pthread_rwlock_t                       mapLock;
+
+  pthread_mutex_t               sleepMutex;
+  pthread_cond_t                sleepCond;
+  int                           sleepers;
+};
+
+#endif  // SRC_LIB_NGSINOTIFY_NOTIFQUEUE_H_
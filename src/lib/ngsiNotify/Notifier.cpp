@@ -29,6 +29,7 @@
 #include "logMsg/logMsg.h"
 #include "logMsg/traceLevels.h"
 
+#include "common/globals.h"
 #include "common/string.h"
 #include "common/statistics.h"
 #include "common/limits.h"
@@ -38,6 +39,7 @@
 #include "apiTypesV2/HttpInfo.h"
 #include "ngsi10/NotifyContextRequest.h"
 #include "ngsiNotify/senderThread.h"
+#include "ngsiNotify/senderPool.h"
 #include "rest/uriParamNames.h"
 #include "rest/httpHeaderAdd.h"
 
@@ -109,6 +111,12 @@ void Notifier::sendNotifyContextRequest
 
   if (!paramsV->empty()) // al least one param, an empty vector means an error occurred
   {
+    if (strcmp(notificationMode, "transient") == 0)
+    {
+      senderPoolPush(paramsV);
+      return;
+    }
+
     int ret = pthread_create(&tid, NULL, startSenderThread, paramsV);
 
     if (ret != 0)
@@ -186,6 +194,12 @@ void Notifier::sendNotifyContextAvailabilityRequest
     std::vector<SenderThreadParams*>* paramsV = new std::vector<SenderThreadParams*>;
     paramsV->push_back(params);
 
+    if (strcmp(notificationMode, "transient") == 0)
+    {
+      senderPoolPush(paramsV);
+      return;
+    }
+
     int ret = pthread_create(&tid, NULL, startSenderThread, paramsV);
     if (ret != 0)
     {
@@ -38,9 +38,10 @@
 *
 * QueueNotifier::Notifier -
 */
-QueueNotifier::QueueNotifier(size_t queueSize, int numThreads): queue(queueSize), workers(&queue, numThreads)
+QueueNotifier::QueueNotifier(size_t queueSize, int numThreads, int inFlight, int tenantQuota): queue(queueSize, tenantQuota), workers(&queue, numThreads, inFlight)
 {
   LM_T(LmtNotifier,("Setting up queue and threads for notifications"));
+  QueueStatistics::setNotifQueue(&queue);
 }
 
 
@@ -93,7 +94,7 @@ void QueueNotifier::sendNotifyContextRequest
   if (!enqueued)
   {
     QueueStatistics::incReject(notificationsNum);
-    LM_E(("Runtime Error (notification queue is full)"));
+    LM_E(("Runtime Error (notification queue is full, or tenant '%s' is over its quota)", tenant.c_str()));
     for (unsigned ix = 0; ix < paramsV->size(); ix++)
     {
       delete (*paramsV)[ix];
@@ -28,10 +28,10 @@
 #include "logMsg/logMsg.h"
 #include "logMsg/traceLevels.h"
 
-#include "common/SyncQOverflow.h"
 #include "common/RenderFormat.h"
 #include "ngsiNotify/Notifier.h"
 #include "ngsiNotify/senderThread.h"
+#include "ngsiNotify/NotifQueue.h"
 #include "ngsiNotify/QueueWorkers.h"
 
 
@@ -49,7 +49,7 @@
 class QueueNotifier : public Notifier
 {
 public:
-  QueueNotifier(size_t queueSize, int numThreads);
+  QueueNotifier(size_t queueSize, int numThreads, int inFlight = 1, int tenantQuota = 0);
 
   void sendNotifyContextRequest(NotifyContextRequest*            ncr,
                                 const ngsiv2::HttpInfo&          httpInfo,
@@ -63,8 +63,8 @@ public:
   int start();
 
 private:
- SyncQOverflow<std::vector<SenderThreadParams*>*>  queue;
- QueueWorkers                        workers;
+ NotifQueue    queue;
+ QueueWorkers  workers;
 
 };
 
@@ -40,6 +40,7 @@ volatile int QueueStatistics::noOfNotificationsQueueSentError;
 boost::mutex QueueStatistics::mtxTimeInQ;
 struct timespec QueueStatistics::timeInQ;
 size_t QueueStatistics::queueSize;
+NotifQueue* QueueStatistics::notifQueueP = NULL;
 
 /* ****************************************************************************
 *
@@ -166,6 +167,25 @@ size_t QueueStatistics::getQSize()
   return  queueSize;
 }
 
+/* ****************************************************************************
+*
+* setNotifQueue() -
+*/
+void QueueStatistics::setNotifQueue(NotifQueue* queueP)
+{
+  notifQueueP = queueP;
+}
+
+/* ****************************************************************************
+*
+* getSubQueues() -
+*/
+void QueueStatistics::getSubQueues(std::vector<NotifSubQueueInfo>* infoV)
+{
+  if (notifQueueP != NULL)
+    notifQueueP->subQueuesGet(infoV);
+}
+
 /* ****************************************************************************
 *
 * reset() -
@@ -178,6 +198,9 @@ void QueueStatistics::reset()
   __sync_fetch_and_and(&noOfNotificationsQueueSentOK, 0);
   __sync_fetch_and_and(&noOfNotificationsQueueSentError, 0);
 
+  if (notifQueueP != NULL)
+    notifQueueP->statisticsReset();
+
   boost::mutex::scoped_lock lock(mtxTimeInQ);
   timeInQ.tv_sec = 0;
   timeInQ.tv_nsec = 0;
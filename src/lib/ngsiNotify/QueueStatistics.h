@@ -32,8 +32,12 @@
 // A newer version of boost (>=1.53.0) or c++11 could provide better
 // alternatives to this implementation
 
+#include <vector>
+
 #include "boost/thread/mutex.hpp"
 
+#include "ngsiNotify/NotifQueue.h"
+
 class QueueStatistics
 {
 public:
@@ -117,6 +121,18 @@ public:
   */
   static size_t getQSize();
 
+  /* ****************************************************************************
+  *
+  * setNotifQueue - register the queue whose sub-queues are reported by getSubQueues
+  */
+  static void setNotifQueue(NotifQueue* queueP);
+
+  /* ****************************************************************************
+  *
+  * getSubQueues - depth and counters of each sub-queue (one per notification endpoint)
+  */
+  static void getSubQueues(std::vector<NotifSubQueueInfo>* infoV);
+
   /* ****************************************************************************
   *
   * reset() -
@@ -135,6 +151,7 @@ private:
    static boost::mutex    mtxTimeInQ;
    static struct timespec timeInQ;
    static size_t          queueSize;
+   static NotifQueue*     notifQueueP;
 
 };
 
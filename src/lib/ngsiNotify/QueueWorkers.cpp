@@ -23,6 +23,7 @@
 * Author: Orion dev team
 */
 #include <pthread.h>
+#include <deque>
 
 #include "logMsg/logMsg.h"
 #include "logMsg/traceLevels.h"
@@ -35,6 +36,7 @@
 #include "ngsi10/NotifyContextRequest.h"
 #include "rest/httpRequestSend.h"
 #include "ngsiNotify/QueueStatistics.h"
+#include "ngsiNotify/SenderEngine.h"
 #include "orionld/common/orionldState.h"
 #include "orionld/mqtt/mqttNotification.h"
 #include "ngsiNotify/QueueWorkers.h"
@@ -45,7 +47,7 @@
 *
 * workerFunc - prototype
 */
-static void* workerFunc(void* pSyncQ);
+static void* workerFunc(void* workersP);
 
 
 
@@ -58,7 +60,7 @@ int QueueWorkers::start()
   for (int i = 0; i < numberOfThreads; ++i)
   {
     pthread_t  tid;
-    int        rc = pthread_create(&tid, NULL, workerFunc, pQueue);
+    int        rc = pthread_create(&tid, NULL, workerFunc, this);
 
     if (rc != 0)
     {
@@ -74,19 +76,156 @@ int QueueWorkers::start()
 
 /* ****************************************************************************
 *
-* workerFunc -
+* workerDone - the notification has been sent (or has failed)
+*/
+static void workerDone(SenderThreadParams* params, int r)
+{
+  if (params->toFree != NULL)
+  {
+    free(params->toFree);
+    params->toFree = NULL;
+  }
+
+  if (!simulatedNotification)
+  {
+    //
+    // FIXME: ok and error counter should be incremented in the other notification modes (generalizing the concept, i.e.
+    // not as member of QueueStatistics:: which seems to be tied to just the threadpool notification mode)
+    //
+    char portV[STRING_SIZE_FOR_INT];
+    snprintf(portV, sizeof(portV), "%d", params->port);
+    std::string url = params->ip + ":" + portV + params->resource;
+
+    if (r == 0)
+    {
+      statisticsUpdate(NotifyContextSent, params->mimeType);
+      QueueStatistics::incSentOK();
+      alarmMgr.notificationErrorReset(url);
+
+      if (params->registration == false)
+      {
+        subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 0);
+      }
+    }
+    else
+    {
+      QueueStatistics::incSentError();
+      alarmMgr.notificationError(url, "notification failure for queue worker");
+
+      if (params->registration == false)
+      {
+        subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 1);
+      }
+    }
+  }
+
+  // Free params memory
+  delete params;
+}
+
+
+
+/* ****************************************************************************
+*
+* workerSend - send a notification taken from the queue
+*
+* HTTP notifications are handed over to the sender engine of the worker, to be sent concurrently
+* with the other notifications in flight, while MQTT notifications are sent before returning.
 */
-static void* workerFunc(void* pSyncQ)
+static void workerSend(SenderEngine* engineP, SenderThreadParams* params, size_t estimatedQSize)
 {
-  SyncQOverflow<std::vector<SenderThreadParams*>*>*  queue = (SyncQOverflow<std::vector<SenderThreadParams*>*> *) pSyncQ;
-  CURL*                                              curl;
+  struct timespec      now;
+  struct timespec      howlong;
+  char*                subscriptionId     = (char*) params->subscriptionId.c_str();
+  const char*          tenant             = params->tenant.c_str();
+  bool                 ngsildSubscription = false;
+  CachedSubscription*  subP               = subCacheItemLookup(tenant, subscriptionId);
+
+  if ((subP != NULL) && (subP->ldContext != ""))
+    ngsildSubscription = true;
+
+  QueueStatistics::incOut();
+  clock_gettime(CLOCK_REALTIME, &now);
+  clock_difftime(&now, &params->timeStamp, &howlong);
+  QueueStatistics::addTimeInQWithSize(&howlong, estimatedQSize);
+
+  // To avoid buffer size complaints from the compiler
+  // Delicate problem, as copies are made in both directions
+  // Seems like I have to avoid strncpy here :(
+  //
+  strcpy(transactionId, params->transactionId);
+
+  LM_T(LmtNotifier, ("worker sending '%s' message to: host='%s', port=%d, verb=%s, tenant='%s', service-path: '%s', xauthToken: '%s', path='%s', content-type: %s",
+                     params->protocol.c_str(),
+                     params->ip.c_str(),
+                     params->port,
+                     params->verb.c_str(),
+                     params->tenant.c_str(),
+                     params->servicePath.c_str(),
+                     params->xauthToken.c_str(),
+                     params->resource.c_str(),
+                     params->content_type.c_str()));
+
+  if (simulatedNotification)
+  {
+    LM_T(LmtNotifier, ("simulatedNotification is 'true', skipping outgoing request"));
+    __sync_fetch_and_add(&noOfSimulatedNotifications, 1);
+    workerDone(params, 0);
+  }
+  else if (params->protocol == "mqtt")  // Notification to be sent via MQTT broker
+  {
+    char* topic = (char*) params->resource.c_str();
+    int   r;
 
-  // Initialize curl context
-  curl = curl_easy_init();
+    r = mqttNotification(params->ip.c_str(),
+                         params->port,
+                         topic,
+                         params->content.c_str(),
+                         params->content_type.c_str(),
+                         params->mqttQoS,
+                         params->mqttUserName,
+                         params->mqttPassword,
+                         params->mqttVersion,
+                         params->xauthToken.c_str(),
+                         params->extraHeaders);
+    // FIXME: +subscriptionId
 
-  if (curl == NULL)
+    workerDone(params, r);
+  }
+  else // Send HTTP notification
   {
-    LM_E(("Runtime Error (curl_easy_init)"));
+    if (ngsildSubscription == false)
+      subscriptionId = NULL;
+
+    engineP->add(params, subscriptionId);  // Subscription ID as URL param
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* workerFunc -
+*
+* Each worker has up to 'maxInFlight' HTTP notifications in flight, using a SenderEngine (curl multi).
+* The connections to the receivers are kept open and reused, per host:port.
+* A worker blocks on the queue only when it has nothing in flight - else it takes more notifications
+* from the queue while there's room for them, and keeps moving its requests forward.
+*
+* An item of the queue is a vector of notifications (custom notifications have one per entity), so, an item may hold
+* more notifications than there is room for. The notifications of the popped items are kept in 'pending', in order,
+* and handed to the engine only while it isn't full. The queue is popped again only once 'pending' is empty.
+*/
+static void* workerFunc(void* workersP)
+{
+  QueueWorkers*   workers = (QueueWorkers*) workersP;
+  NotifQueue*     queue   = workers->queue();
+  SenderEngine    engine(workers->maxInFlight(), workerDone);
+  NotifQueueItem  itemV[NOTIF_QUEUE_QUANTUM];
+
+  if (engine.init() == false)
+  {
+    LM_E(("Runtime Error (unable to initialize the sender engine of a queue worker)"));
     pthread_exit(NULL);
   }
 
@@ -97,145 +236,43 @@ static void* workerFunc(void* pSyncQ)
   orionldState.kjson.stringAfterColon   = (char*) "";
   orionldState.kjson.nlString           = (char*) "";
 
+  std::deque<SenderThreadParams*>  pending;
+  size_t                           estimatedQSize = 0;
+
   for (;;)
   {
-    std::vector<SenderThreadParams*>* paramsV = queue->pop();
-    for (unsigned ix = 0; ix < paramsV->size(); ix++)
+    if (pending.empty() == true)
     {
-      struct timespec      now;
-      struct timespec      howlong;
-      size_t               estimatedQSize;
-      SenderThreadParams*  params             = (*paramsV)[ix];
-      char*                subscriptionId     = (char*) params->subscriptionId.c_str();
-      const char*          tenant             = params->tenant.c_str();
-      bool                 ngsildSubscription = false;
-      CachedSubscription*  subP               = subCacheItemLookup(tenant, subscriptionId);
-
-      if ((subP != NULL) && (subP->ldContext != ""))
-        ngsildSubscription = true;
-
-      QueueStatistics::incOut();
-      clock_gettime(CLOCK_REALTIME, &now);
-      clock_difftime(&now, &params->timeStamp, &howlong);
-      estimatedQSize = queue->size();
-      QueueStatistics::addTimeInQWithSize(&howlong, estimatedQSize);
-
-      // To avoid buffer size complaints from the compiler
-      // Delicate problem, as copies are made in both directions
-      // Seems like I have to avoid strncpy here :(
-      //
-      strcpy(transactionId, params->transactionId);
-
-      LM_T(LmtNotifier, ("worker sending '%s' message to: host='%s', port=%d, verb=%s, tenant='%s', service-path: '%s', xauthToken: '%s', path='%s', content-type: %s",
-                         params->protocol.c_str(),
-                         params->ip.c_str(),
-                         params->port,
-                         params->verb.c_str(),
-                         params->tenant.c_str(),
-                         params->servicePath.c_str(),
-                         params->xauthToken.c_str(),
-                         params->resource.c_str(),
-                         params->content_type.c_str()));
+      size_t items = 0;
+      size_t room  = workers->maxInFlight() - engine.inFlight();  // never more items than free transfer slots
 
-      int r = 0;
+      if (engine.inFlight() == 0)
+        items = queue->pop(itemV, room);
+      else if (engine.full() == false)
+        items = queue->try_pop(itemV, room);
 
-      if (simulatedNotification)
-      {
-        LM_T(LmtNotifier, ("simulatedNotification is 'true', skipping outgoing request"));
-        __sync_fetch_and_add(&noOfSimulatedNotifications, 1);
-      }
-      else if (params->protocol == "mqtt")  // Notification to be sent via MQTT broker
-      {
-        char* topic = (char*) params->resource.c_str();
-
-        r = mqttNotification(params->ip.c_str(),
-                             params->port,
-                             topic,
-                             params->content.c_str(),
-                             params->content_type.c_str(),
-                             params->mqttQoS,
-                             params->mqttUserName,
-                             params->mqttPassword,
-                             params->mqttVersion,
-                             params->xauthToken.c_str(),
-                             params->extraHeaders);
-        // FIXME: +subscriptionId
-      }
-      else // Send HTTP notification
-      {
-        std::string out;
-
-        if (ngsildSubscription == false)
-          subscriptionId = NULL;
-
-        r = httpRequestSendWithCurl(curl,
-                                    params->ip,
-                                    params->port,
-                                    params->protocol,
-                                    params->verb,
-                                    params->tenant.c_str(),
-                                    params->servicePath,
-                                    params->xauthToken.c_str(),
-                                    params->resource,
-                                    params->content_type,
-                                    params->content,
-                                    params->fiwareCorrelator,
-                                    params->renderFormat,
-                                    NOTIFICATION_WAIT_MODE,
-                                    &out,
-                                    params->extraHeaders,
-                                    "",
-                                    -1,
-                                    subscriptionId);  // Subscription ID as URL param
-      }
+      if (items > 0)
+        estimatedQSize = queue->size();
 
-      if (params->toFree != NULL)
+      for (size_t itemIx = 0; itemIx < items; itemIx++)
       {
-        free(params->toFree);
-        params->toFree = NULL;
-      }
+        std::vector<SenderThreadParams*>* paramsV = itemV[itemIx];
 
-      if (!simulatedNotification)
-      {
-        //
-        // FIXME: ok and error counter should be incremented in the other notification modes (generalizing the concept, i.e.
-        // not as member of QueueStatistics:: which seems to be tied to just the threadpool notification mode)
-        //
-        char portV[STRING_SIZE_FOR_INT];
-        snprintf(portV, sizeof(portV), "%d", params->port);
-        std::string url = params->ip + ":" + portV + params->resource;
-
-        if (r == 0)
-        {
-          statisticsUpdate(NotifyContextSent, params->mimeType);
-          QueueStatistics::incSentOK();
-          alarmMgr.notificationErrorReset(url);
-
-          if (params->registration == false)
-          {
-            subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 0);
-          }
-        }
-        else
-        {
-          QueueStatistics::incSentError();
-          alarmMgr.notificationError(url, "notification failure for queue worker");
-
-          if (params->registration == false)
-          {
-            subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 1);
-          }
-        }
-      }
+        pending.insert(pending.end(), paramsV->begin(), paramsV->end());
 
-      // Free params memory
-      delete params;
+        // Free params vector memory
+        delete paramsV;
+      }
     }
 
-    // Free params vector memory
-    delete paramsV;
+    while ((pending.empty() == false) && (engine.full() == false))
+    {
+      workerSend(&engine, pending.front(), estimatedQSize);
+      pending.pop_front();
+    }
 
-    // Reset curl for next iteration
-    curl_easy_reset(curl);
+    engine.perform(QUEUE_WORKER_POLL_TIME);
   }
+
+  return NULL;
 }
@@ -25,17 +25,28 @@
 * Author: Orion dev team
 */
 
-#include "common/SyncQOverflow.h"
+#include "ngsiNotify/NotifQueue.h"
 #include "ngsiNotify/senderThread.h"
 
+/* ****************************************************************************
+*
+* QUEUE_WORKER_POLL_TIME - milliseconds a worker with requests in flight waits for its connections before looking for more work
+*/
+#define QUEUE_WORKER_POLL_TIME  10
+
+
+
 class QueueWorkers
 {
 public:
-  QueueWorkers(SyncQOverflow<std::vector<SenderThreadParams*>*> *pQ, int numThreads): pQueue(pQ), numberOfThreads(numThreads) {}
+  QueueWorkers(NotifQueue *pQ, int numThreads, int _inFlight = 1): pQueue(pQ), numberOfThreads(numThreads), inFlight(_inFlight) {}
   int start();
+  NotifQueue* queue() { return pQueue; }
+  int maxInFlight() { return inFlight; }
 private:
-    SyncQOverflow<std::vector<SenderThreadParams*>*> *pQueue;
+    NotifQueue *pQueue;
     int numberOfThreads;
+    int inFlight;
 };
 
 #endif  // SRC_LIB_NGSINOTIFY_QUEUEWORKERS_H_
@@ -0,0 +1,268 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                        // strcpy
+#include <curl/curl.h>                                     // curl_multi_*, curl_easy_*
+
+#include <string>
+#include <vector>
+
+#include "logMsg/logMsg.h"                                 // LM_*
+#include "logMsg/traceLevels.h"                            // Lmt*
+
+#include "rest/httpRequestSend.h"                          // HttpRequest, httpRequestPrepare, httpRequestComplete
+#include "ngsiNotify/senderThread.h"                       // SenderThreadParams
+#include "ngsiNotify/SenderEngine.h"                       // Own interface
+
+
+
+/* ****************************************************************************
+*
+* SenderTransfer - a notification being sent, kept as private data of its curl handle
+*/
+typedef struct SenderTransfer
+{
+  CURL*                curl;
+  HttpRequest          req;
+  SenderThreadParams*  paramsP;
+} SenderTransfer;
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::SenderEngine -
+*/
+SenderEngine::SenderEngine(int _maxInFlight, SenderDoneFunction _doneFunction)
+{
+  multi         = NULL;
+  maxInFlight   = (_maxInFlight > 0)? _maxInFlight : 1;
+  transfers     = 0;
+  doneFunction  = _doneFunction;
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::~SenderEngine -
+*
+* Requests still in flight are lost - the engine lives as long as its thread.
+*/
+SenderEngine::~SenderEngine()
+{
+  for (unsigned int ix = 0; ix < handles.size(); ix++)
+  {
+    curl_easy_cleanup(handles[ix]);
+  }
+
+  if (multi != NULL)
+    curl_multi_cleanup(multi);
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::init -
+*/
+bool SenderEngine::init(void)
+{
+  multi = curl_multi_init();
+
+  if (multi == NULL)
+  {
+    LM_E(("Runtime Error (curl_multi_init)"));
+    return false;
+  }
+
+  // The connection cache of the multi handle - the connections kept open for reuse
+  curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long) maxInFlight);
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::handleGet -
+*/
+CURL* SenderEngine::handleGet(void)
+{
+  if (handles.empty())
+    return curl_easy_init();
+
+  CURL* curl = handles.back();
+
+  handles.pop_back();
+
+  return curl;
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::handleRelease -
+*/
+void SenderEngine::handleRelease(CURL* curl)
+{
+  curl_easy_reset(curl);
+  handles.push_back(curl);
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::add - start sending a notification
+*
+* If the request cannot be started, the notification is done (with an error) before returning.
+*/
+void SenderEngine::add(SenderThreadParams* paramsP, const char* subscriptionId)
+{
+  CURL* curl = handleGet();
+
+  strcpy(transactionId, paramsP->transactionId);
+
+  if (curl == NULL)
+  {
+    LM_E(("Runtime Error (curl_easy_init)"));
+    doneFunction(paramsP, -8);
+    return;
+  }
+
+  SenderTransfer*  transferP = new SenderTransfer;
+  int              r;
+
+  transferP->curl    = curl;
+  transferP->paramsP = paramsP;
+
+  r = httpRequestPrepare(curl,
+                         paramsP->ip,
+                         paramsP->port,
+                         paramsP->protocol,
+                         paramsP->verb,
+                         paramsP->tenant.c_str(),
+                         paramsP->servicePath,
+                         paramsP->xauthToken.c_str(),
+                         paramsP->resource,
+                         paramsP->content_type,
+                         paramsP->content,
+                         paramsP->fiwareCorrelator,
+                         paramsP->renderFormat,
+                         paramsP->extraHeaders,
+                         "",
+                         -1,
+                         subscriptionId,
+                         &transferP->req);
+
+  if (r != 0)
+  {
+    handleRelease(curl);
+    delete transferP;
+    doneFunction(paramsP, r);
+    return;
+  }
+
+  curl_easy_setopt(curl, CURLOPT_PRIVATE, transferP);
+
+  CURLMcode mc = curl_multi_add_handle(multi, curl);
+  if (mc != CURLM_OK)
+  {
+    std::string out;
+
+    LM_E(("Runtime Error (curl_multi_add_handle: %s)", curl_multi_strerror(mc)));
+    r = httpRequestComplete(&transferP->req, CURLE_FAILED_INIT, &out);
+
+    handleRelease(curl);
+    delete transferP;
+    doneFunction(paramsP, r);
+    return;
+  }
+
+  ++transfers;
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::completedCollect - finish the requests that libcurl is done with
+*/
+void SenderEngine::completedCollect(void)
+{
+  CURLMsg*  msgP;
+  int       msgsLeft;
+
+  while ((msgP = curl_multi_info_read(multi, &msgsLeft)) != NULL)
+  {
+    if (msgP->msg != CURLMSG_DONE)
+      continue;
+
+    SenderTransfer*  transferP = NULL;
+    CURLcode         res       = msgP->data.result;  // msgP is not valid after curl_multi_remove_handle
+    CURL*            curl      = msgP->easy_handle;
+    std::string      out;
+    int              r;
+
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**) &transferP);
+    curl_multi_remove_handle(multi, curl);
+    --transfers;
+
+    strcpy(transactionId, transferP->paramsP->transactionId);
+    r = httpRequestComplete(&transferP->req, res, &out);
+
+    handleRelease(curl);
+    doneFunction(transferP->paramsP, r);
+    delete transferP;
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine::perform - move the requests in flight forward
+*
+* Waits at most 'timeoutInMilliseconds' for activity on the connections.
+*/
+void SenderEngine::perform(int timeoutInMilliseconds)
+{
+  int running;
+
+  if (transfers == 0)
+    return;
+
+  curl_multi_perform(multi, &running);
+  completedCollect();
+
+  if (transfers == 0)
+    return;
+
+  curl_multi_wait(multi, NULL, 0, timeoutInMilliseconds, NULL);
+  curl_multi_perform(multi, &running);
+  completedCollect();
+}
@@ -0,0 +1,81 @@
+#ifndef SRC_LIB_NGSINOTIFY_SENDERENGINE_H_
+#define SRC_LIB_NGSINOTIFY_SENDERENGINE_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "rest/httpRequestSend.h"
+#include "ngsiNotify/senderThread.h"
+
+
+
+/* ****************************************************************************
+*
+* SenderDoneFunction - called for each notification once its request has finished
+*
+* 'r' is the return value of httpRequestPrepare or httpRequestComplete - 0 on success.
+* The function is in charge of the notification, i.e. of freeing 'paramsP'.
+*/
+typedef void (*SenderDoneFunction)(SenderThreadParams* paramsP, int r);
+
+
+
+/* ****************************************************************************
+*
+* SenderEngine - concurrent sending of HTTP notifications using a curl multi handle
+*
+* Up to 'maxInFlight' requests are performed at the same time, by the thread that calls perform().
+* The connections are kept in the connection cache of the multi handle and reused for
+* notifications to the same host:port, and the curl easy handles are reused as well.
+* An engine is not thread-safe - it must be used by one single thread.
+*/
+class SenderEngine
+{
+public:
+  SenderEngine(int _maxInFlight, SenderDoneFunction _doneFunction);
+  ~SenderEngine();
+
+  bool  init(void);
+  void  add(SenderThreadParams* paramsP, const char* subscriptionId);
+  void  perform(int timeoutInMilliseconds);
+  int   inFlight(void)  { return transfers;                }
+  bool  full(void)      { return transfers >= maxInFlight; }
+
+private:
+  CURL*  handleGet(void);
+  void   handleRelease(CURL* curl);
+  void   completedCollect(void);
+
+  CURLM*               multi;
+  int                  maxInFlight;
+  int                  transfers;
+  SenderDoneFunction   doneFunction;
+  std::vector<CURL*>   handles;
+};
+
+#endif  // SRC_LIB_NGSINOTIFY_SENDERENGINE_H_
@@ -0,0 +1,216 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                       // pthread_*
+#include <errno.h>                                         // ETIMEDOUT
+#include <string.h>                                        // strcpy
+#include <time.h>                                          // clock_gettime
+
+#include <deque>
+#include <vector>
+
+#include "logMsg/logMsg.h"                                 // LM_*
+#include "logMsg/traceLevels.h"                            // Lmt*
+
+#include "common/globals.h"                                // simulatedNotification
+#include "common/statistics.h"                             // noOfSimulatedNotifications
+#include "common/limits.h"                                 // STRING_SIZE_FOR_INT
+#include "alarmMgr/alarmMgr.h"                             // alarmMgr
+#include "ngsiNotify/senderThread.h"                       // SenderThreadParams, senderThreadResult
+#include "ngsiNotify/SenderEngine.h"                       // SenderEngine
+#include "ngsiNotify/senderPool.h"                         // Own interface
+
+
+
+/* ****************************************************************************
+*
+* The sender pool serves the notifications of the 'transient' notification mode.
+*
+* Instead of one thread per notification, the notifications are queued and sent by a small number of
+* sender threads, each of them with a SenderEngine, i.e. with up to SENDER_POOL_IN_FLIGHT concurrent requests
+* and a connection cache.
+* The sender threads are created on demand, when a notification is queued and no sender thread is waiting for work,
+* and they exit after SENDER_POOL_IDLE_TIME seconds without work.
+*
+* The queue has no size limit - just like before, with one thread per notification, no notification is ever dropped.
+*/
+static std::deque<SenderThreadParams*>  queue;
+static pthread_mutex_t                  poolMutex    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   poolCond     = PTHREAD_COND_INITIALIZER;
+static int                              threads      = 0;
+static int                              idleThreads  = 0;
+
+
+
+/* ****************************************************************************
+*
+* senderPoolSend -
+*/
+static void senderPoolSend(SenderEngine* engineP, SenderThreadParams* params)
+{
+  // To avoid buffer size complaints from the compiler
+  strcpy(transactionId, params->transactionId);
+
+  LM_T(LmtNotifier, ("sending to: host='%s', port=%d, verb=%s, tenant='%s', service-path: '%s', xauthToken: '%s', path='%s', content-type: %s",
+                     params->ip.c_str(),
+                     params->port,
+                     params->verb.c_str(),
+                     params->tenant.c_str(),
+                     params->servicePath.c_str(),
+                     params->xauthToken.c_str(),
+                     params->resource.c_str(),
+                     params->content_type.c_str()));
+
+  if (simulatedNotification)
+  {
+    char         portV[STRING_SIZE_FOR_INT];
+    std::string  url;
+
+    snprintf(portV, sizeof(portV), "%d", params->port);
+    url = params->ip + ":" + portV + params->resource;
+
+    LM_T(LmtNotifier, ("simulatedNotification is 'true', skipping outgoing request"));
+    __sync_fetch_and_add(&noOfSimulatedNotifications, 1);
+    alarmMgr.notificationError(url, "notification failure for sender-thread");
+
+    delete params;
+    return;
+  }
+
+  engineP->add(params, params->subscriptionId.c_str());  // Subscription ID as URL param
+}
+
+
+
+/* ****************************************************************************
+*
+* senderPoolThread -
+*/
+static void* senderPoolThread(void* p)
+{
+  SenderEngine                      engine(SENDER_POOL_IN_FLIGHT, senderThreadResult);
+  std::vector<SenderThreadParams*>  work;
+
+  if (engine.init() == false)
+  {
+    pthread_mutex_lock(&poolMutex);
+    --threads;
+    pthread_mutex_unlock(&poolMutex);
+
+    return NULL;
+  }
+
+  for (;;)
+  {
+    pthread_mutex_lock(&poolMutex);
+
+    //
+    // Nothing to do?  Wait for work, or exit after SENDER_POOL_IDLE_TIME seconds
+    //
+    while (queue.empty() && (engine.inFlight() == 0))
+    {
+      struct timespec  timeout;
+      int              rc;
+
+      clock_gettime(CLOCK_REALTIME, &timeout);
+      timeout.tv_sec += SENDER_POOL_IDLE_TIME;
+
+      ++idleThreads;
+      rc = pthread_cond_timedwait(&poolCond, &poolMutex, &timeout);
+      --idleThreads;
+
+      if ((rc == ETIMEDOUT) && queue.empty())
+      {
+        --threads;
+        pthread_mutex_unlock(&poolMutex);
+
+        return NULL;
+      }
+    }
+
+    //
+    // Take as many notifications as the engine has room for
+    //
+    int room = SENDER_POOL_IN_FLIGHT - engine.inFlight();
+
+    while ((room > 0) && !queue.empty())
+    {
+      work.push_back(queue.front());
+      queue.pop_front();
+      --room;
+    }
+
+    pthread_mutex_unlock(&poolMutex);
+
+    for (unsigned int ix = 0; ix < work.size(); ix++)
+    {
+      senderPoolSend(&engine, work[ix]);
+    }
+    work.clear();
+
+    engine.perform(SENDER_POOL_POLL_TIME);
+  }
+
+  return NULL;
+}
+
+
+
+/* ****************************************************************************
+*
+* senderPoolPush -
+*/
+void senderPoolPush(std::vector<SenderThreadParams*>* paramsV)
+{
+  pthread_mutex_lock(&poolMutex);
+
+  for (unsigned int ix = 0; ix < paramsV->size(); ix++)
+  {
+    queue.push_back((*paramsV)[ix]);
+  }
+
+  if (idleThreads > 0)
+    pthread_cond_signal(&poolCond);
+  else if (threads < SENDER_POOL_THREADS)
+  {
+    pthread_t       tid;
+    pthread_attr_t  attr;
+    int             ret;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    ret = pthread_create(&tid, &attr, senderPoolThread, NULL);
+    if (ret != 0)
+      LM_E(("Runtime Error (error creating sender thread: %d)", ret));
+    else
+      ++threads;
+
+    pthread_attr_destroy(&attr);
+  }
+
+  pthread_mutex_unlock(&poolMutex);
+
+  delete paramsV;
+}
@@ -0,0 +1,58 @@
+#ifndef SRC_LIB_NGSINOTIFY_SENDERPOOL_H_
+#define SRC_LIB_NGSINOTIFY_SENDERPOOL_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <vector>
+
+#include "ngsiNotify/senderThread.h"
+
+
+
+/* ****************************************************************************
+*
+* Sender pool tuning
+*
+* SENDER_POOL_THREADS     - max number of sender threads
+* SENDER_POOL_IN_FLIGHT   - max number of concurrent requests per sender thread
+* SENDER_POOL_IDLE_TIME   - seconds a sender thread without work waits before it exits
+* SENDER_POOL_POLL_TIME   - milliseconds a busy sender thread waits for its connections before looking for more work
+*/
+#define SENDER_POOL_THREADS      8
+#define SENDER_POOL_IN_FLIGHT   32
+#define SENDER_POOL_IDLE_TIME   30
+#define SENDER_POOL_POLL_TIME   10
+
+
+
+/* ****************************************************************************
+*
+* senderPoolPush - hand over notifications to the sender pool
+*
+* The pool takes ownership of the vector and its items.
+*/
+extern void senderPoolPush(std::vector<SenderThreadParams*>* paramsV);
+
+#endif  // SRC_LIB_NGSINOTIFY_SENDERPOOL_H_
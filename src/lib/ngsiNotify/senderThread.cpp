@@ -32,6 +32,50 @@
 
 
 
+/* ****************************************************************************
+*
+* senderThreadResult - account for the result of a sent notification and free its parameters
+*
+* 'r' is the return value of httpRequestSend - 0 on success.
+*/
+void senderThreadResult(SenderThreadParams* params, int r)
+{
+  if (params->toFree != NULL)
+  {
+    free(params->toFree);
+    params->toFree = NULL;
+  }
+
+  if (r == 0)
+  {
+    char         portV[STRING_SIZE_FOR_INT];
+    std::string  url;
+
+    snprintf(portV, sizeof(portV), "%d", params->port);
+    url = params->ip + ":" + portV + params->resource;
+
+    statisticsUpdate(NotifyContextSent, params->mimeType);
+    alarmMgr.notificationErrorReset(url);
+
+    if (params->registration == false)
+    {
+      subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 0);
+    }
+  }
+  else
+  {
+    if (params->registration == false)
+    {
+      subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 1);
+    }
+  }
+
+  /* Delete the parameters after using them */
+  delete params;
+}
+
+
+
 /* ****************************************************************************
 *
 * startSenderThread -
@@ -90,39 +134,17 @@ void* startSenderThread(void* p)
                           -1,
                           params->subscriptionId.c_str());  // Subscription ID as URL param
 
-      if (params->toFree != NULL)
-      {
-        free(params->toFree);
-        params->toFree = NULL;
-      }
-
-      if (r == 0)
-      {
-        statisticsUpdate(NotifyContextSent, params->mimeType);
-        alarmMgr.notificationErrorReset(url);
-
-        if (params->registration == false)
-        {
-          subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 0);
-        }
-      }
-      else
-      {
-        if (params->registration == false)
-        {
-          subCacheItemNotificationErrorStatus(params->tenant, params->subscriptionId, 1);
-        }
-      }
+      senderThreadResult(params, r);
     }
     else
     {
       LM_T(LmtNotifier, ("simulatedNotification is 'true', skipping outgoing request"));
       __sync_fetch_and_add(&noOfSimulatedNotifications, 1);
       alarmMgr.notificationError(url, "notification failure for sender-thread");
-    }
 
-    /* Delete the parameters after using them */
-    delete params;
+      /* Delete the parameters after using them */
+      delete params;
+    }
   }
 
   /* Delete the parameters vector after using it */
@@ -72,6 +72,14 @@ typedef struct SenderThreadParams
 
 
 
+/* ****************************************************************************
+*
+* senderThreadResult -
+*/
+extern void senderThreadResult(SenderThreadParams* params, int r);
+
+
+
 /* ****************************************************************************
 *
 * startSenderThread -
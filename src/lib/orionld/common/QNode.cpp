@@ -22,6 +22,13 @@
 *
 * Author: Ken Zangelin
 */
+#include <strings.h>                                           // bzero
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                    // kaAlloc
+}
+
 #include "orionld/common/orionldState.h"                       // Own orionldState
 #include "orionld/common/QNode.h"                              // Own interface
 
@@ -33,13 +40,20 @@
 //
 QNode* qNode(QNodeType type)
 {
+  if (orionldState.qNodeV == NULL)  // First QNode of the request - the vector is allocated on first use
+  {
+    orionldState.qNodeV = (QNode*) kaAlloc(&orionldState.kalloc, QNODE_SIZE * sizeof(QNode));
+    if (orionldState.qNodeV == NULL)
+      return NULL;
+  }
+
   if (orionldState.qNodeIx >= QNODE_SIZE)
     return NULL;
 
   QNode* nodeP = &orionldState.qNodeV[orionldState.qNodeIx++];
 
+  bzero(nodeP, sizeof(QNode));
   nodeP->type = type;
-  nodeP->next = NULL;
 
   return nodeP;
 }
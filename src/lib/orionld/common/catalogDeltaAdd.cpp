@@ -0,0 +1,134 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strchr
+#include <unistd.h>                                              // NULL
+
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjObject, kjInteger, kjChildAdd
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/dotForEq.h"                             // dotForEq
+#include "orionld/common/catalogDeltaAdd.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// childObjectGet - lookup the object 'name' in 'containerP' - create it if not found
+//
+// The names are copied - they often come from BSON objects and strings that don't live as long as the request
+//
+static KjNode* childObjectGet(KjNode* containerP, const char* name)
+{
+  KjNode* nodeP = kjLookup(containerP, name);
+
+  if (nodeP == NULL)
+  {
+    nodeP = kjObject(orionldState.kjsonP, kaStrdup(&orionldState.kalloc, name));
+    kjChildAdd(containerP, nodeP);
+  }
+
+  return nodeP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// counterAdd - add 'n' to the integer 'name' in 'containerP' - create it if not found
+//
+static void counterAdd(KjNode* containerP, const char* name, int n)
+{
+  KjNode* counterP = kjLookup(containerP, name);
+
+  if (counterP == NULL)
+    kjChildAdd(containerP, kjInteger(orionldState.kjsonP, kaStrdup(&orionldState.kalloc, name), n));
+  else
+    counterP->value.i += n;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// catalogDeltaAdd - add 'n' to a counter of an entity catalog delta
+//
+// The entity catalog keeps, per entity type, the number of entities and the number of attributes of each name and
+// attribute type (see mongocCatalog.h). The changes made by a request are accumulated in a delta, that looks like this:
+//   {
+//     "<entity type>": {
+//       "entities": 1,
+//       "attrs": {
+//         "<attr name, '.' replaced by '='>": { "<attr type, '.' replaced by '='>": 1 }
+//       }
+//     }
+//   }
+//
+// and that is sent to the database in one go (mongocCatalogUpdate) when the request has been served.
+//
+// PARAMETERS
+//   deltaPP     - the delta - created if *deltaPP is NULL (normally &orionldState.catalogDeltaP)
+//   entityType  - the entity type (expanded) - entities without type are not part of the catalog
+//   attrNameEq  - the attribute name (expanded, and with dots replaced by '='), or NULL for the entity counter
+//   attrType    - the type of the attribute
+//   n           - the number to add (negative for deletions)
+//
+void catalogDeltaAdd(KjNode** deltaPP, const char* entityType, const char* attrNameEq, const char* attrType, int n)
+{
+  if ((entityType == NULL) || (entityType[0] == 0) || (n == 0))
+    return;
+
+  if (*deltaPP == NULL)
+    *deltaPP = kjObject(orionldState.kjsonP, NULL);
+
+  KjNode* typeP = childObjectGet(*deltaPP, entityType);
+
+  if (attrNameEq == NULL)
+  {
+    counterAdd(typeP, "entities", n);
+    return;
+  }
+
+  if ((attrType == NULL) || (attrType[0] == 0))
+    return;
+
+  if (strchr(attrType, '.') != NULL)
+  {
+    char* attrTypeEq = kaStrdup(&orionldState.kalloc, attrType);
+
+    dotForEq(attrTypeEq);
+    attrType = attrTypeEq;
+  }
+
+  KjNode* attrsP = childObjectGet(typeP, "attrs");
+  KjNode* attrP  = childObjectGet(attrsP, attrNameEq);
+
+  counterAdd(attrP, attrType, n);
+}
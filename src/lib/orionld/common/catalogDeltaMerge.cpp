@@ -0,0 +1,70 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <unistd.h>                                              // NULL
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "orionld/common/catalogDeltaAdd.h"                      // catalogDeltaAdd
+#include "orionld/common/catalogDeltaMerge.h"                    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// catalogDeltaMerge - add all counters of the entity catalog delta 'fromP' to the delta '*toPP'
+//
+// Used for BATCH operations, where the delta of each entity is kept aside until the bulk write has told
+// whether the write of the entity made it to the database.
+//
+void catalogDeltaMerge(KjNode** toPP, KjNode* fromP)
+{
+  if (fromP == NULL)
+    return;
+
+  for (KjNode* typeP = fromP->value.firstChildP; typeP != NULL; typeP = typeP->next)
+  {
+    for (KjNode* fieldP = typeP->value.firstChildP; fieldP != NULL; fieldP = fieldP->next)
+    {
+      if (strcmp(fieldP->name, "entities") == 0)
+      {
+        catalogDeltaAdd(toPP, typeP->name, NULL, NULL, fieldP->value.i);
+        continue;
+      }
+
+      // "attrs"
+      for (KjNode* attrP = fieldP->value.firstChildP; attrP != NULL; attrP = attrP->next)
+      {
+        for (KjNode* attrTypeP = attrP->value.firstChildP; attrTypeP != NULL; attrTypeP = attrTypeP->next)
+        {
+          catalogDeltaAdd(toPP, typeP->name, attrP->name, attrTypeP->name, attrTypeP->value.i);
+        }
+      }
+    }
+  }
+}
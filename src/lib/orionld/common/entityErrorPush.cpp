@@ -26,7 +26,6 @@ extern "C"
 {
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjBuilder.h"                                     // kjString, kjObject, ...
-#include "kjson/kjLookup.h"                                      // kjLookup
 }
 
 #include "logMsg/logMsg.h"                                       // LM_*
@@ -34,6 +33,7 @@ extern "C"
 
 #include "orionld/common/orionldErrorResponse.h"                 // OrionldResponseErrorType
 #include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/entityErrorLookup.h"                    // entityErrorLookup
 #include "orionld/common/entityErrorPush.h"                      // Own interface
 
 
@@ -69,17 +69,9 @@ void entityErrorPush
   bool                      avoidDuplicate
 )
 {
-  if (avoidDuplicate == true)
-  {
-    // If the entity 'entityId' is present already, then don't add another one
-    for (KjNode* nodeP = errorsArrayP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
-    {
-      KjNode* entityIdP = kjLookup(nodeP, "entityId");
-
-      if ((entityIdP != NULL) && (strcmp(entityIdP->value.s, entityId) == 0))
-        return;
-    }
-  }
+  // If the entity 'entityId' is present already, then don't add another one
+  if ((avoidDuplicate == true) && (entityErrorLookup(errorsArrayP, entityId) != NULL))
+    return;
 
   KjNode* objP            = kjObject(orionldState.kjsonP, NULL);
   KjNode* eIdP            = kjString(orionldState.kjsonP,  "entityId", entityId);
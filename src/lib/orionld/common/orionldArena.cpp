@@ -0,0 +1,137 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // calloc, free
+#include <pthread.h>                                           // pthread_*
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/common/orionldArena.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Arena state
+//
+pthread_mutex_t         orionldArenaMutex = PTHREAD_MUTEX_INITIALIZER;
+OrionldArena*           orionldArenaList  = NULL;
+__thread OrionldArena*  orionldArenaP     = NULL;
+
+static pthread_key_t    arenaKey;
+static pthread_once_t   arenaKeyOnce      = PTHREAD_ONCE_INIT;
+static int              arenaSerial       = 0;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// blockListFree -
+//
+static void blockListFree(OrionldArenaBlock* blockP)
+{
+  while (blockP != NULL)
+  {
+    OrionldArenaBlock* next = blockP->next;
+
+    free(blockP);
+    blockP = next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// arenaDestroy - unlink the arena of an exiting thread and free it, with all its blocks
+//
+static void arenaDestroy(void* vP)
+{
+  OrionldArena* arenaP = (OrionldArena*) vP;
+
+  pthread_mutex_lock(&orionldArenaMutex);
+
+  OrionldArena** prevPP = &orionldArenaList;
+
+  while (*prevPP != NULL)
+  {
+    if (*prevPP == arenaP)
+    {
+      *prevPP = arenaP->next;
+      break;
+    }
+
+    prevPP = &(*prevPP)->next;
+  }
+
+  pthread_mutex_unlock(&orionldArenaMutex);
+
+  blockListFree(arenaP->usedList);
+  for (int ix = 0; ix < ORIONLD_ARENA_CLASSES; ix++)
+    blockListFree(arenaP->freeList[ix]);
+
+  free(arenaP);
+  orionldArenaP = NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// arenaKeyCreate - the key is only used for its destructor, that frees the arena when the thread exits
+//
+static void arenaKeyCreate(void)
+{
+  if (pthread_key_create(&arenaKey, arenaDestroy) != 0)
+    LM_X(1, ("Internal Error (unable to create the thread key for the arenas)"));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldArenaCreate -
+//
+OrionldArena* orionldArenaCreate(void)
+{
+  pthread_once(&arenaKeyOnce, arenaKeyCreate);
+
+  OrionldArena* arenaP = (OrionldArena*) calloc(1, sizeof(OrionldArena));
+
+  if (arenaP == NULL)
+    LM_X(1, ("Out of memory (unable to allocate the arena of a thread)"));
+
+  pthread_setspecific(arenaKey, arenaP);
+
+  pthread_mutex_lock(&orionldArenaMutex);
+  arenaP->id       = ++arenaSerial;
+  arenaP->next     = orionldArenaList;
+  orionldArenaList = arenaP;
+  pthread_mutex_unlock(&orionldArenaMutex);
+
+  orionldArenaP = arenaP;
+
+  return arenaP;
+}
@@ -0,0 +1,136 @@
+#ifndef SRC_LIB_ORIONLD_COMMON_ORIONLDARENA_H_
+#define SRC_LIB_ORIONLD_COMMON_ORIONLDARENA_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                            // size_t
+#include <pthread.h>                                           // pthread_mutex_t
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Thread Arenas
+//
+//   The buffers of a request that are too big for kalloc (response payloads, incoming payloads above STATIC_BUFFER_SIZE,
+//   TRoE SQL buffers, ...) are allocated from an arena that belongs to the thread serving the request (orionldArenaAlloc).
+//   All of them are released at the end of the request (orionldArenaRelease, called by requestFinish), not to the system
+//   but to the free lists of the arena, one list per size class (16k, 32k, 64k, ... 32M).
+//   The next request that needs a buffer of the same size class gets it from the free list, with no call to malloc.
+//
+//   What is kept in the free lists is trimmed every ORIONLD_ARENA_TRIM_INTERVAL requests, down to the maximum number of
+//   blocks of each size class that any request used in that interval (the high-water mark of the size class), and it is
+//   never allowed to grow above the limit of the CLI option -arenaRetain (KB per thread).
+//   With -arenaRetain 0 (the default), nothing is kept - every block is freed at the end of the request.
+//
+//   The arena of a thread is created on its first allocation and freed when the thread exits.
+//   The arenas are most useful with threads that live long: request workers (-httpWorkers), the thread pool (-reqPoolSize)
+//   or persistent connections.
+//
+//   All arenas are linked into a list (orionldArenaList), for their metrics to be shown by GET /ngsi-ld/ex/v1/version.
+//   The metrics are written only by the owner thread, using relaxed atomics, as they're read by the thread serving the version request.
+//
+#define ORIONLD_ARENA_MIN_SIZE       (16 * 1024)  // Size of the smallest size class
+#define ORIONLD_ARENA_CLASSES        12           // 16k, 32k, 64k, ... 32M - bigger blocks are always freed at the end of the request
+#define ORIONLD_ARENA_TRIM_INTERVAL  128          // Requests between two trims of the free lists
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldArenaBlock - the header of an arena block - the block data comes right after
+//
+typedef struct OrionldArenaBlock
+{
+  struct OrionldArenaBlock*  next;
+  size_t                     size;       // Size of the block data
+  long                       sizeClass;  // -1: bigger than the biggest size class
+} OrionldArenaBlock;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldArenaMetrics -
+//
+typedef struct OrionldArenaMetrics
+{
+  unsigned long long  requests;     // Requests released
+  unsigned long long  allocs;       // Calls to orionldArenaAlloc
+  unsigned long long  hits;         // Allocations served from a free list
+  unsigned long long  mallocs;      // Allocations that needed a call to malloc
+  unsigned long long  frees;        // Blocks freed (trimmed, bigger than the limit, or at thread exit)
+  long long           inUse;        // Bytes used by the current request
+  long long           retained;     // Bytes kept in the free lists
+  long long           maxRetained;  // Max of retained
+} OrionldArenaMetrics;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldArena -
+//
+typedef struct OrionldArena
+{
+  int                   id;                                  // Serial number - to tell the arenas apart in the metrics
+  OrionldArenaBlock*    usedList;                            // Blocks in use by the current request
+  OrionldArenaBlock*    freeList[ORIONLD_ARENA_CLASSES];     // Blocks kept between requests, per size class
+  int                   freeBlocks[ORIONLD_ARENA_CLASSES];   // Number of blocks in each free list
+  int                   usedBlocks[ORIONLD_ARENA_CLASSES];   // Number of blocks of each size class in use by the current request
+  int                   highWater[ORIONLD_ARENA_CLASSES];    // Max of usedBlocks since the last trim
+  int                   releases;                            // Requests since the last trim
+  OrionldArenaMetrics   metrics;
+  struct OrionldArena*  next;                                // Next in orionldArenaList
+} OrionldArena;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ARENA_METRIC_ADD/SET - update a metric of an arena - only to be used by the owner thread
+//
+#define ARENA_METRIC_ADD(arenaP, field, n) __atomic_store_n(&(arenaP)->metrics.field, (arenaP)->metrics.field + (n), __ATOMIC_RELAXED)
+#define ARENA_METRIC_SET(arenaP, field, v) __atomic_store_n(&(arenaP)->metrics.field, (v), __ATOMIC_RELAXED)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Arena state - orionldArenaList is protected by orionldArenaMutex
+//
+extern pthread_mutex_t          orionldArenaMutex;
+extern OrionldArena*            orionldArenaList;
+extern __thread OrionldArena*   orionldArenaP;      // The arena of the current thread - NULL until its first allocation
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldArenaCreate - create the arena of the current thread
+//
+extern OrionldArena* orionldArenaCreate(void);
+
+#endif  // SRC_LIB_ORIONLD_COMMON_ORIONLDARENA_H_
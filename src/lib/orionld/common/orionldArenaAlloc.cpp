@@ -0,0 +1,101 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // malloc
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/common/orionldArena.h"                       // OrionldArena, orionldArenaP, orionldArenaCreate
+#include "orionld/common/orionldArenaAlloc.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldArenaAlloc -
+//
+// The buffer is taken from the free list of its size class, if not empty, else allocated with malloc.
+// It must not be freed - it is released by orionldArenaRelease, at the end of the request (requestFinish).
+//
+char* orionldArenaAlloc(size_t size)
+{
+  OrionldArena*       arenaP     = (orionldArenaP != NULL)? orionldArenaP : orionldArenaCreate();
+  int                 sizeClass  = 0;
+  size_t              classSize  = ORIONLD_ARENA_MIN_SIZE;
+  OrionldArenaBlock*  blockP;
+
+  while ((classSize < size) && (sizeClass < ORIONLD_ARENA_CLASSES))
+  {
+    classSize *= 2;
+    ++sizeClass;
+  }
+
+  ARENA_METRIC_ADD(arenaP, allocs, 1);
+
+  if (sizeClass == ORIONLD_ARENA_CLASSES)  // Bigger than the biggest size class - allocated to size, never kept
+  {
+    sizeClass = -1;
+    classSize = size;
+    blockP    = (OrionldArenaBlock*) malloc(sizeof(OrionldArenaBlock) + classSize);
+    ARENA_METRIC_ADD(arenaP, mallocs, 1);
+  }
+  else if (arenaP->freeList[sizeClass] != NULL)
+  {
+    blockP = arenaP->freeList[sizeClass];
+    arenaP->freeList[sizeClass] = blockP->next;
+    --arenaP->freeBlocks[sizeClass];
+
+    ARENA_METRIC_ADD(arenaP, hits, 1);
+    ARENA_METRIC_ADD(arenaP, retained, -((long long) classSize));
+  }
+  else
+  {
+    blockP = (OrionldArenaBlock*) malloc(sizeof(OrionldArenaBlock) + classSize);
+    ARENA_METRIC_ADD(arenaP, mallocs, 1);
+  }
+
+  if (blockP == NULL)
+  {
+    LM_E(("Out of memory (unable to allocate %lu bytes in the arena of the thread)", classSize));
+    return NULL;
+  }
+
+  blockP->size      = classSize;
+  blockP->sizeClass = sizeClass;
+  blockP->next      = arenaP->usedList;
+  arenaP->usedList  = blockP;
+
+  if (sizeClass != -1)
+  {
+    ++arenaP->usedBlocks[sizeClass];
+
+    if (arenaP->usedBlocks[sizeClass] > arenaP->highWater[sizeClass])
+      arenaP->highWater[sizeClass] = arenaP->usedBlocks[sizeClass];
+  }
+
+  ARENA_METRIC_ADD(arenaP, inUse, (long long) classSize);
+
+  return (char*) &blockP[1];
+}
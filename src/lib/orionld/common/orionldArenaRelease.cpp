@@ -0,0 +1,107 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // free
+#include <strings.h>                                           // bzero
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/common/orionldState.h"                       // arenaRetain
+#include "orionld/common/orionldArena.h"                       // OrionldArena, orionldArenaP
+#include "orionld/common/orionldArenaRelease.h"                // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldArenaRelease -
+//
+// The blocks of the request go back to the free lists of their size class, as long as the arena stays within
+// the limit of -arenaRetain. The rest are freed.
+// Every ORIONLD_ARENA_TRIM_INTERVAL requests, the free lists are trimmed down to the high-water marks of the interval.
+//
+void orionldArenaRelease(void)
+{
+  OrionldArena* arenaP = orionldArenaP;
+
+  if (arenaP == NULL)  // Nothing has ever been allocated by this thread
+    return;
+
+  long long           retainMax = (long long) arenaRetain * 1024;
+  long long           retained  = arenaP->metrics.retained;
+  unsigned long long  frees     = 0;
+  OrionldArenaBlock*  blockP    = arenaP->usedList;
+
+  while (blockP != NULL)
+  {
+    OrionldArenaBlock* next = blockP->next;
+
+    if ((blockP->sizeClass == -1) || (retained + (long long) blockP->size > retainMax))
+    {
+      free(blockP);
+      ++frees;
+    }
+    else
+    {
+      blockP->next = arenaP->freeList[blockP->sizeClass];
+      arenaP->freeList[blockP->sizeClass] = blockP;
+      ++arenaP->freeBlocks[blockP->sizeClass];
+      retained += blockP->size;
+    }
+
+    blockP = next;
+  }
+
+  arenaP->usedList = NULL;
+  bzero(arenaP->usedBlocks, sizeof(arenaP->usedBlocks));
+
+  if (++arenaP->releases >= ORIONLD_ARENA_TRIM_INTERVAL)
+  {
+    for (int sizeClass = 0; sizeClass < ORIONLD_ARENA_CLASSES; sizeClass++)
+    {
+      while (arenaP->freeBlocks[sizeClass] > arenaP->highWater[sizeClass])
+      {
+        blockP = arenaP->freeList[sizeClass];
+        arenaP->freeList[sizeClass] = blockP->next;
+        --arenaP->freeBlocks[sizeClass];
+        retained -= blockP->size;
+
+        free(blockP);
+        ++frees;
+      }
+    }
+
+    bzero(arenaP->highWater, sizeof(arenaP->highWater));
+    arenaP->releases = 0;
+  }
+
+  ARENA_METRIC_ADD(arenaP, requests, 1);
+  ARENA_METRIC_ADD(arenaP, frees,    frees);
+  ARENA_METRIC_SET(arenaP, inUse,    0);
+  ARENA_METRIC_SET(arenaP, retained, retained);
+
+  if (retained > arenaP->metrics.maxRetained)
+    ARENA_METRIC_SET(arenaP, maxRetained, retained);
+}
@@ -87,8 +87,10 @@ void orionldErrorResponseCreate
   const char*               detail
 )
 {
+  orionldState.pd.type   = errorType;
   orionldState.pd.title  = (char*) title;
   orionldState.pd.detail = (char*) detail;
+  orionldState.pd.status = 0;  // The caller sets orionldState.httpStatusCode
 
   if ((title  != NULL) && (detail != NULL))
   {
@@ -22,7 +22,8 @@
 *
 * Author: Ken Zangelin
 */
-#include <string.h>                                              // strlen
+#include <string.h>                                              // strlen, memcpy
+#include <stddef.h>                                              // offsetof
 #include <semaphore.h>                                           // sem_t
 
 extern "C"
@@ -30,6 +31,7 @@ extern "C"
 #include "kbase/kTime.h"                                         // kTimeGet
 #include "kbase/kMacros.h"                                       // K_VEC_SIZE
 #include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
 #include "kjson/kjBufferCreate.h"                                // kjBufferCreate
 #include "kjson/kjFree.h"                                        // kjFree
 }
@@ -107,11 +109,7 @@ char              mongoServerVersion[32];
 //
 // Variables for Mongo C Driver
 //
-mongoc_collection_t*  mongoEntitiesCollectionP      = NULL;
-mongoc_collection_t*  mongoRegistrationsCollectionP = NULL;
-mongoc_collection_t*  mongoSubscriptionsCollectionP = NULL;
-mongoc_collection_t*  mongoContextsCollectionP      = NULL;  // The Context Cache module uses mongoc regardless
-sem_t                 mongoContextsSem;
+MongocClientPool      mongocClientPool;  // The Context Cache module uses mongoc regardless
 
 
 
@@ -123,10 +121,17 @@ void orionldStateInit(MHD_Connection* connection)
 {
   //
   // NOTE
-  //   About 'bzero(&orionldState, sizeof(orionldState))'
+  //   About 'bzero(&orionldState, ...)'
   //   This is NOT DONE by the operating system, so, it needs to be done here 'manually'
+  //   The kalloc buffer (the last field) needn't be reset - it is initialized by kaBufferInit
+  //   The cold parts of the state are allocated on first use (kaAlloc), so, all that is reset here is the pointers
+  //   The cold parts that are embedded (from 'pd' on) are initialized on first use as well, only a few counters/flags are reset here
   //
-  bzero(&orionldState, sizeof(orionldState));   // Performance: ~5 microseconds
+  bzero(&orionldState, offsetof(OrionldConnectionState, pd));
+
+  orionldState.prefixCache.index  = 0;
+  orionldState.prefixCache.items  = 0;
+  orionldState.batchStream.active = false;  // The rest of batchStream is reset by orionldMhdConnectionInit, if activated
 
   //
   // Creating kjson environment for KJson parse and render
@@ -139,11 +144,8 @@ void orionldStateInit(MHD_Connection* connection)
   orionldState.kjsonP                  = kjBufferCreate(&orionldState.kjson, &orionldState.kalloc);
   orionldState.requestNo               = requestNo;
   orionldState.servicePath             = (char*) "";
-  orionldState.errorAttributeArrayP    = orionldState.errorAttributeArray;
-  orionldState.errorAttributeArraySize = sizeof(orionldState.errorAttributeArray);
   orionldState.contextP                = orionldCoreContextP;
   orionldState.forwardAttrsCompacted   = true;
-  orionldState.delayedFreeVecSize      = sizeof(orionldState.delayedFreeVec) / sizeof(orionldState.delayedFreeVec[0]);
 
   orionldState.uriParams.spaces        = 2;
 
@@ -232,11 +234,6 @@ void orionldOutHeaderAdd(char* key, char* sValue, int iValue)
 //
 void orionldStateRelease(void)
 {
-  if (orionldState.errorAttributeArrayP != orionldState.errorAttributeArray)
-  {
-    free(orionldState.errorAttributeArrayP);
-    orionldState.errorAttributeArrayP = NULL;
-  }
 
 #if 0
   //
@@ -290,27 +287,21 @@ void orionldStateErrorAttributeAdd(const char* attributeName)
 
   //
   // Will the attribute name fit inside the error attribute string?
+  // If not, allocate a bigger one (the very first time, allocate it) - it's freed with the kalloc buffer of the request
   //
   if (orionldState.errorAttributeArrayUsed + len + 2 > orionldState.errorAttributeArraySize)
   {
-    if (orionldState.errorAttributeArrayP == orionldState.errorAttributeArray)
-    {
-      int size = sizeof(orionldState.errorAttributeArray) + growSize;
+    int   size = orionldState.errorAttributeArraySize + len + 2 + growSize;
+    char* newP = kaAlloc(&orionldState.kalloc, size);
 
-      orionldState.errorAttributeArrayP = (char*) malloc(size);
-      if (orionldState.errorAttributeArrayP == NULL)
-        LM_X(1, ("error allocating Error Attribute Array"));
+    if (newP == NULL)
+      LM_X(1, ("error allocating Error Attribute Array"));
 
-      strncpy(orionldState.errorAttributeArrayP, orionldState.errorAttributeArray, size);
-      orionldState.errorAttributeArraySize = size;
-    }
-    else
-    {
-      orionldState.errorAttributeArrayP = (char*) realloc(orionldState.errorAttributeArrayP, orionldState.errorAttributeArraySize + growSize);
-      if (orionldState.errorAttributeArrayP == NULL)
-        LM_X(1, ("error reallocating Error Attribute Array"));
-      orionldState.errorAttributeArraySize = orionldState.errorAttributeArraySize + growSize;
-    }
+    if (orionldState.errorAttributeArrayUsed > 0)
+      memcpy(newP, orionldState.errorAttributeArrayP, orionldState.errorAttributeArrayUsed + 1);
+
+    orionldState.errorAttributeArrayP    = newP;
+    orionldState.errorAttributeArraySize = size;
   }
 
   if (orionldState.errorAttributeArrayUsed == 0)
@@ -357,9 +348,23 @@ void orionldStateDelayedKjFreeEnqueue(KjNode* tree)  // Outdeffed
 //
 void orionldStateDelayedFreeEnqueue(void* allocatedBuffer)
 {
-  if (orionldState.delayedFreeVecIndex >= orionldState.delayedFreeVecSize - 1)
-    LM_X(1, ("DFREE: Internal Error (the size of orionldState.delayedFreeVec needs to be augmented (delayedFreeVecIndex=%d, delayedFreeVecSize=%d))",
-             orionldState.delayedFreeVecIndex, orionldState.delayedFreeVecSize));
+  //
+  // The vector is allocated on first use (32 slots) and doubled when full - it lives in the kalloc buffer of the request
+  //
+  if (orionldState.delayedFreeVecIndex >= orionldState.delayedFreeVecSize)
+  {
+    int     size = (orionldState.delayedFreeVecSize == 0)? 32 : orionldState.delayedFreeVecSize * 2;
+    void**  vecP = (void**) kaAlloc(&orionldState.kalloc, size * sizeof(void*));
+
+    if (vecP == NULL)
+      LM_X(1, ("DFREE: Out of memory (unable to allocate a delayed-free vector of %d slots)", size));
+
+    if (orionldState.delayedFreeVecIndex > 0)
+      memcpy(vecP, orionldState.delayedFreeVec, orionldState.delayedFreeVecIndex * sizeof(void*));
+
+    orionldState.delayedFreeVec     = vecP;
+    orionldState.delayedFreeVecSize = size;
+  }
 
   orionldState.delayedFreeVec[orionldState.delayedFreeVecIndex] = allocatedBuffer;
   ++orionldState.delayedFreeVecIndex;
@@ -375,9 +380,9 @@ void orionldStateDelayedFreeCancel(void* allocatedBuffer)
 {
   for (int ix = 0; ix < orionldState.delayedFreeVecIndex; ix++)
   {
-    if (orionldState.delayedFreeVec[orionldState.delayedFreeVecIndex] == allocatedBuffer)
+    if (orionldState.delayedFreeVec[ix] == allocatedBuffer)
     {
-      orionldState.delayedFreeVec[orionldState.delayedFreeVecIndex] = NULL;
+      orionldState.delayedFreeVec[ix] = NULL;
       return;
     }
   }
@@ -47,11 +47,14 @@ extern "C"
 #include "orionld/common/performance.h"                          // REQUEST_PERFORMANCE
 #include "orionld/common/QNode.h"                                // QNode
 #include "orionld/common/OrionldResponseBuffer.h"                // OrionldResponseBuffer
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClientPool
 #include "orionld/types/OrionldProblemDetails.h"                 // OrionldProblemDetails
 #include "orionld/types/OrionldGeoIndex.h"                       // OrionldGeoIndex
 #include "orionld/types/OrionldGeoJsonType.h"                    // OrionldGeoJsonType
 #include "orionld/types/OrionldPrefixCache.h"                    // OrionldPrefixCache
 #include "orionld/types/OrionldTenant.h"                         // OrionldTenant
+#include "orionld/types/OrionldBatchStream.h"                    // OrionldBatchStream
+#include "orionld/types/OrionldEntitiesBulk.h"                   // OrionldEntitiesBulk
 #include "orionld/troe/troe.h"                                   // TroeMode
 #include "orionld/context/OrionldContext.h"                      // OrionldContext
 
@@ -65,6 +68,14 @@ extern "C"
 
 
 
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_NOTIFICATION_INFO_MAX - maximum number of items in orionldState.notificationInfo
+//
+#define ORIONLD_NOTIFICATION_INFO_MAX 16
+
+
+
 // -----------------------------------------------------------------------------
 //
 // ORIONLD_VERSION -
@@ -109,6 +120,7 @@ typedef struct OrionldUriParamOptions
   bool noAttrDetail;   // Only NGSIv2
   bool upsert;         // Only NGSIv2
   bool sysAttrs;
+  bool temporalValues;  // Simplified temporal representation
 } OrionldUriParamOptions;
 
 
@@ -142,6 +154,7 @@ typedef struct OrionldUriParams
   char*     timerel;
   char*     timeAt;
   char*     endTimeAt;
+  int       lastN;
   bool      details;
   uint32_t  mask;
   bool      prettyPrint;
@@ -172,9 +185,6 @@ typedef struct OrionldNotificationInfo
   MimeType  mimeType;
   KjNode*   attrsForNotification;
   char*     reference;
-  int       fd;
-  bool      connected;
-  bool      allOK;
 } OrionldNotificationInfo;
 
 
@@ -226,6 +236,20 @@ typedef struct OrionldStateIn
 // It makes very little sense to send these variables to each and every function where they are to be used.
 // Much easier and faster to simply store them in a thread global struct.
 //
+// The struct is reset (bzero) by orionldStateInit for each and every request, so, it is kept small ("hot").
+// The bigger, seldom used parts ("cold") are only pointers in here, allocated with kaAlloc on first use in the request:
+//   - qNodeV                (QNODE_SIZE QNodes)          - qNode()
+//   - delayedFreeVec        (grows as needed)            - orionldStateDelayedFreeEnqueue()
+//   - errorAttributeArrayP  (grows as needed)            - orionldStateErrorAttributeAdd()
+// The cold parts that are embedded are placed last (from 'pd' on), and left out of the reset.
+// They are initialized on first use in the request:
+//   - pd                    - orionldErrorResponseCreate()
+//   - notificationInfo      - items up to notificationRecords
+//   - prefixCache           - orionldStateInit resets its two counters only
+//   - httpResponse          - before each orionldRequestSend()
+//   - batchStream           - orionldMhdConnectionInit(), only for the services with ORIONLD_SERVICE_OPTION_BATCH_GROUPS
+//   - kallocBuffer          - kaBufferInit()
+//
 typedef struct OrionldConnectionState
 {
   OrionldPhase            phase;
@@ -238,12 +262,12 @@ typedef struct OrionldConnectionState
   Kjson                   kjson;
   Kjson*                  kjsonP;
   KAlloc                  kalloc;
-  char                    kallocBuffer[8 * 1024];
   char*                   requestPayload;
   KjNode*                 requestTree;
   KjNode*                 responseTree;
   char*                   responsePayload;
   bool                    responsePayloadAllocated;
+  bool                    responseStreamed;  // orionldStateRelease is delayed until requestCompleted - the stream renders from the request state
   char*                   tenantName;
   OrionldTenant*          tenantP;
   char*                   servicePath;
@@ -254,6 +278,8 @@ typedef struct OrionldConnectionState
   char*                   preferHeader;
   char*                   authorizationHeader;
   OrionldContext*         contextP;
+  bool                    contextCacheReading;         // The request is a read section of the context cache (orionldContextCacheReadBegin)
+  int                     contextCachePhase;           // The phase of the read section, for orionldContextCacheReadEnd
   ApiVersion              apiVersion;
   int                     requestNo;
 
@@ -267,8 +293,7 @@ typedef struct OrionldConnectionState
   char*                   entityId;
   OrionldUriParamOptions  uriParamOptions;
   OrionldUriParams        uriParams;
-  char*                   errorAttributeArrayP;
-  char                    errorAttributeArray[512];
+  char*                   errorAttributeArrayP;   // Allocated on first use - see orionldStateErrorAttributeAdd
   int                     errorAttributeArrayUsed;
   int                     errorAttributeArraySize;
   OrionLdRestService*     serviceP;
@@ -285,8 +310,7 @@ typedef struct OrionldConnectionState
   KjNode*                 payloadContextNode;
   KjNode*                 payloadIdNode;
   KjNode*                 payloadTypeNode;
-  char                    contextId[256];
-  QNode                   qNodeV[QNODE_SIZE];
+  QNode*                  qNodeV;            // Allocated on first use - see qNode
   int                     qNodeIx;
   mongo::BSONObj*         qMongoFilterP;
   char*                   jsonBuf;           // Used by kjTreeFromBsonObj
@@ -301,9 +325,9 @@ typedef struct OrionldConnectionState
 #endif
 
   //
-  // Array of allocated buffers that are to be freed when the request thread ends
+  // Array of allocated buffers that are to be freed when the request thread ends - allocated on first use, grows as needed
   //
-  void*                   delayedFreeVec[1001];  // FIXME: try to make this number smaller ...
+  void**                  delayedFreeVec;
   int                     delayedFreeVecIndex;
   int                     delayedFreeVecSize;
 
@@ -313,25 +337,21 @@ typedef struct OrionldConnectionState
   void*                   delayedFreePointer;
 
   int                     notificationRecords;
-  OrionldNotificationInfo notificationInfo[16];
   bool                    notify;
-  OrionldPrefixCache      prefixCache;
-  OrionldResponseBuffer   httpResponse;
-
-  //
-  // MongoDB stuff - Context Cache uses mongoc regardless of which mongo client lib is in use
-  //
-  mongoc_uri_t*           mongoUri;
-  mongoc_client_t*        mongoClient;
-  mongoc_database_t*      mongoDatabase;
 
   //
   // Instructions for mongoBackend
   //
   KjNode*                 creDatesP;
   bool                    onlyCount;
+  OrionldEntitiesBulk*    entitiesBulkP;     // BATCH operations - entity writes are collected for one bulk write (mongocEntitiesBulkWrite)
   KjNode*                 datasets;
 
+  //
+  // Entity catalog - the changes the request makes to the counters of the catalog (catalogDeltaAdd), flushed by mongocCatalogUpdate
+  //
+  KjNode*                 catalogDeltaP;
+
   //
   // General Behavior
   //
@@ -349,7 +369,6 @@ typedef struct OrionldConnectionState
   KjNode*                 dbAttrWithDatasetsP;  // Used in TRoE for DELETE Attribute with ?deleteAll=true
   TroeMode                troeOpMode;           // Used in troePostEntities as both POST /entities and POST /temporal/entities use troePostEntities
 
-
   //
   // GeoJSON - help vars for the case:
   // - Accept: application/geo+json
@@ -378,9 +397,28 @@ typedef struct OrionldConnectionState
   char* correlator;
 
   //
-  // Error Handling
+  // Cold part - from here on, nothing is reset by orionldStateInit (see the reset boundary, offsetof(pd))
+  //
+
+  //
+  // Error Handling - written in its entirety by orionldErrorResponseCreate, before being read
   //
   OrionldProblemDetails   pd;
+
+  OrionldNotificationInfo notificationInfo[ORIONLD_NOTIFICATION_INFO_MAX];  // Items written before read - notificationRecords is the hot counter
+  OrionldPrefixCache      prefixCache;                                      // Only index+items are reset, the items are written before read
+  OrionldResponseBuffer   httpResponse;                                     // Initialized by each user, before orionldRequestSend
+
+  //
+  // BATCH operations with payload parsed while being read (CLI option -batchGroupSize)
+  // Only 'active' is reset for every request - the rest is reset when the stream is activated (orionldMhdConnectionInit)
+  //
+  OrionldBatchStream      batchStream;
+
+  //
+  // The kalloc buffer MUST be the last field - initialized by kaBufferInit
+  //
+  char                    kallocBuffer[8 * 1024];
 } OrionldConnectionState;
 
 
@@ -420,11 +458,16 @@ typedef struct Timestamps
   struct timespec troeEnd;                // End of            TRoE processing
   struct timespec requestPartEnd;         // End of            MHD-1-2-3 processing
   struct timespec requestCompletedStart;  // Start of          Request Completed
+  double          mongoConnectAccumulated;
+  int             getMongoConnectionCalls;
+  uint64_t        srMask;                 // Bit 'ix' set by PERFORMANCE_BEGIN(ix) - the samples taken in this request
+
+  //
+  // The samples are left out of the reset (offsetof(Timestamps, srStart)) - srMask tells which ones are valid
+  //
   struct timespec srStart[50];            // Start of          Service Routine Sample
   struct timespec srEnd[50];              // End of            Service Routine Sample
   char*           srDesc[50];             // Description for   Service Routine Sample
-  double          mongoConnectAccumulated;
-  int             getMongoConnectionCalls;
 } Timestamps;
 
 extern __thread Timestamps timestamps;
@@ -460,12 +503,26 @@ extern char              dbPwd[];                  // From orionld.cpp
 extern bool              multitenancy;             // From orionld.cpp
 extern int               contextDownloadAttempts;  // From orionld.cpp
 extern int               contextDownloadTimeout;   // From orionld.cpp
+extern int               contextCacheMaxSize;      // From orionld.cpp
 extern bool              troe;                     // From orionld.cpp
 extern char              troeHost[256];            // From orionld.cpp
 extern unsigned short    troePort;                 // From orionld.cpp
 extern char              troeUser[256];            // From orionld.cpp
 extern char              troePwd[256];             // From orionld.cpp
 extern int               troePoolSize;             // From orionld.cpp
+extern int               troePoolTimeout;          // From orionld.cpp
+extern int               troeWriters;              // From orionld.cpp
+extern int               troeBatchSize;            // From orionld.cpp
+extern int               troeBatchDelay;           // From orionld.cpp
+extern int               troeQueueSize;            // From orionld.cpp
+extern bool              troeCopy;                 // From orionld.cpp
+extern int               httpWorkers;              // From orionld.cpp
+extern int               httpLoops;                // From orionld.cpp
+extern int               streamChunkSize;          // From orionld.cpp
+extern int               batchGroupSize;           // From orionld.cpp
+extern int               arenaRetain;              // From orionld.cpp
+extern int               mongocPoolSize;           // From orionld.cpp
+extern int               writeConcern;             // From orionld.cpp
 extern char              pgPortString[16];
 extern bool              forwarding;               // From orionld.cpp
 extern const char*       orionldVersion;
@@ -482,10 +539,7 @@ extern char              mongoServerVersion[32];
 //
 // Global variables for Mongo C Driver
 //
-extern mongoc_collection_t*  mongoEntitiesCollectionP;
-extern mongoc_collection_t*  mongoRegistrationsCollectionP;
-extern mongoc_collection_t*  mongoContextsCollectionP;       // The Context Cache module uses mongoc regardless
-extern sem_t                 mongoContextsSem;
+extern MongocClientPool  mongocClientPool;                 // The Context Cache module uses mongoc regardless
 
 
 
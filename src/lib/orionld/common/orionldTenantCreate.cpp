@@ -34,6 +34,7 @@ extern "C"
 
 #include "orionld/db/dbConfiguration.h"                        // dbIdIndexCreate
 #include "orionld/troe/pgDatabasePrepare.h"                    // pgDatabasePrepare
+#include "orionld/mongoc/mongocCatalogInit.h"                  // mongocCatalogInit
 #include "orionld/types/OrionldTenant.h"                       // OrionldTenant
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/tenantList.h"                         // tenantList
@@ -76,6 +77,9 @@ OrionldTenant* orionldTenantCreate(const char* tenantName)
   if (idIndex == true)
     dbIdIndexCreate(tenantP);
 
+  if (mongocCatalogInit(tenantP) == false)
+    LM_E(("Database Error (unable to initialize the entity catalog of tenant '%s')", tenantP->tenant));
+
   // if TRoE is on, need to create the DB in postgres
   if (troe)
   {
@@ -56,6 +56,7 @@ do {                                      \
 //
 #define PERFORMANCE_BEGIN(ix, desc)       \
 do {                                      \
+  timestamps.srMask |= (1ULL << (ix));    \
   timestamps.srDesc[ix] = (char*) desc;   \
   kTimeGet(&timestamps.srStart[ix]);      \
 } while (0)
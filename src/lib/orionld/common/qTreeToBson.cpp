@@ -32,6 +32,34 @@
 
 
 
+// ----------------------------------------------------------------------------
+//
+// commaListAppend - append the values of a comma-list (A1==1,2,3) to a BSON array
+//
+static void commaListAppend(bson_t* arrayP, QNode* valueNodeP)
+{
+  char         keyBuf[16];
+  const char*  key;
+  uint32_t     ix = 0;
+
+  while (valueNodeP != NULL)
+  {
+    size_t keyLen = bson_uint32_to_string(ix, &key, keyBuf, sizeof(keyBuf));
+
+    if (valueNodeP->type == QNodeIntegerValue)
+      bson_append_int64(arrayP, key, keyLen, valueNodeP->value.i);
+    else if (valueNodeP->type == QNodeFloatValue)
+      bson_append_double(arrayP, key, keyLen, valueNodeP->value.f);
+    else if (valueNodeP->type == QNodeStringValue)
+      bson_append_utf8(arrayP, key, keyLen, valueNodeP->value.s, -1);
+
+    valueNodeP = valueNodeP->next;
+    ++ix;
+  }
+}
+
+
+
 // ----------------------------------------------------------------------------
 //
 // qTreeToBson -
@@ -41,15 +69,19 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
   if (treeP->type == QNodeOr)
   {
     // { "%or": [ { }, { }, ... { } ] }
-    bson_t orArrayBson;
+    bson_t    orArrayBson;
+    uint32_t  ix = 0;
 
     bson_append_array_begin(bsonP, "$or", 3, &orArrayBson);
 
     for (QNode* qNodeP = treeP->value.children; qNodeP != NULL; qNodeP = qNodeP->next)
     {
-      bson_t orItemBson;
+      bson_t       orItemBson;
+      char         keyBuf[16];
+      const char*  key;
+      size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
 
-      bson_append_document_begin(&orArrayBson, "", 0, &orItemBson);
+      bson_append_document_begin(&orArrayBson, key, keyLen, &orItemBson);
       if (qTreeToBson(qNodeP, &orItemBson, titleP, detailsP) == false)
         return false;
       bson_append_document_end(&orArrayBson, &orItemBson);
@@ -58,13 +90,26 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
   }
   else if (treeP->type == QNodeAnd)
   {
-    // { { }, { }, ... { } }
+    // { "$and": [ { }, { }, ... { } ] }
+    // Each item in a document of its own - A>1;A<5 would otherwise give the same key twice in one document
+    bson_t    andArrayBson;
+    uint32_t  ix = 0;
+
+    bson_append_array_begin(bsonP, "$and", 4, &andArrayBson);
 
     for (QNode* qNodeP = treeP->value.children; qNodeP != NULL; qNodeP = qNodeP->next)
     {
-      if (qTreeToBson(qNodeP, bsonP, titleP, detailsP) == false)
+      bson_t       andItemBson;
+      char         keyBuf[16];
+      const char*  key;
+      size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+
+      bson_append_document_begin(&andArrayBson, key, keyLen, &andItemBson);
+      if (qTreeToBson(qNodeP, &andItemBson, titleP, detailsP) == false)
         return false;
+      bson_append_document_end(&andArrayBson, &andItemBson);
     }
+    bson_append_array_end(bsonP, &andArrayBson);
   }
   else if ((treeP->type == QNodeGT) || (treeP->type == QNodeGE))
   {
@@ -82,7 +127,7 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
     else if (rightP->type == QNodeIntegerValue)
       bson_append_int64(&gtBson, op, opLen, rightP->value.i);
     else if (rightP->type == QNodeFloatValue)
-      bson_append_int64(&gtBson, op, opLen, rightP->value.f);
+      bson_append_double(&gtBson, op, opLen, rightP->value.f);
     else
     {
       *titleP   = (char*) "ngsi-ld query language: invalid token after GT";
@@ -108,7 +153,7 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
     else if (rightP->type == QNodeIntegerValue)
       bson_append_int64(&ltBson, op, opLen, rightP->value.i);
     else if (rightP->type == QNodeFloatValue)
-      bson_append_int64(&ltBson, op, opLen, rightP->value.f);
+      bson_append_double(&ltBson, op, opLen, rightP->value.f);
     else
     {
       *titleP   = (char*) "ngsi-ld query language: invalid token after LT";
@@ -171,17 +216,8 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
 
       bson_append_document_begin(bsonP, leftP->value.v, -1, &inBson);
 
-      bson_append_array_begin(&inBson, "$in", -1, &commaArrayBson);
-
-      for (QNode* valueNodeP = rightP->value.children; valueNodeP != NULL; valueNodeP = valueNodeP->next)
-      {
-        if (valueNodeP->type == QNodeIntegerValue)
-          bson_append_int32(&commaArrayBson, "0", 1, valueNodeP->value.i);
-        else if (valueNodeP->type == QNodeFloatValue)
-          bson_append_double(&commaArrayBson, "0", 1, valueNodeP->value.f);
-        else if (valueNodeP->type == QNodeStringValue)
-          bson_append_utf8(&commaArrayBson, "0", 1, valueNodeP->value.s, -1);
-      }
+      bson_append_array_begin(&inBson, "$in", 3, &commaArrayBson);
+      commaListAppend(&commaArrayBson, rightP->value.children);
       bson_append_array_end(&inBson, &commaArrayBson);
       bson_append_document_end(bsonP, &inBson);
     }
@@ -195,27 +231,71 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
   else if (treeP->type == QNodeNE)
   {
     //
-    // Instead of implementing all $ne, $nin, and reversed checks for ranges, etc,
-    // we simply change the operator from NE to EQ and add a "$not" before the expression.
-    // Should work.
-    // Not sure about efficiency though ...
+    // Extract from the Mongo Manual:
+    //   $ne selects the documents where the value of the field is not equal to the specified value.
+    //   This includes documents that do not contain the field.
     //
-    // Is:
-    //   { "P1": { "$ne": 12 } }
-    // faster than:
-    //   { "$not": { "P1": 12 } } ?
+    // So, an $exists is needed as well, and everything goes inside the object of the variable:
+    //   A1!=12       =>  { "A1": { "$exists": true, "$ne": 12 } }
+    //   A1!=12,13    =>  { "A1": { "$exists": true, "$nin": [ 12, 13 ] } }
+    //   A1!=12..24   =>  { "A1": { "$exists": true, "$not": { "$gte": 12, "$lte": 24 } } }
     //
-    bson_t notBson;
+    // A top-level "$not" is not accepted by mongo, that's why the negation is done per variable.
+    //
+    QNode*  leftP  = treeP->value.children;
+    QNode*  rightP = leftP->next;
+    bson_t  neBson;
 
-    treeP->type = QNodeEQ;  // QNodeNE => QNodeEQ
+    bson_append_document_begin(bsonP, leftP->value.v, -1, &neBson);
+    bson_append_bool(&neBson, "$exists", 7, true);
 
-    bson_init(&notBson);
-    bson_append_document_begin(bsonP, "$not", 4, &notBson);  // Preceding the expression with a negation
+    if      (rightP->type == QNodeIntegerValue)  bson_append_int64(&neBson,  "$ne", 3, rightP->value.i);
+    else if (rightP->type == QNodeFloatValue)    bson_append_double(&neBson, "$ne", 3, rightP->value.f);
+    else if (rightP->type == QNodeStringValue)   bson_append_utf8(&neBson,   "$ne", 3, rightP->value.s, -1);
+    else if (rightP->type == QNodeTrueValue)     bson_append_bool(&neBson,   "$ne", 3, true);
+    else if (rightP->type == QNodeFalseValue)    bson_append_bool(&neBson,   "$ne", 3, false);
+    else if (rightP->type == QNodeComma)
+    {
+      bson_t ninBson;
 
-    bool b = qTreeToBson(treeP, &notBson, titleP, detailsP);
-    bson_append_document_end(bsonP, &notBson);
-    if (b == false)
+      bson_append_array_begin(&neBson, "$nin", 4, &ninBson);
+      commaListAppend(&ninBson, rightP->value.children);
+      bson_append_array_end(&neBson, &ninBson);
+    }
+    else if (rightP->type == QNodeRange)
+    {
+      QNode*  lowerLimitNodeP = rightP->value.children;
+      QNode*  upperLimitNodeP = lowerLimitNodeP->next;
+      bson_t  notBson;
+
+      bson_append_document_begin(&neBson, "$not", 4, &notBson);
+
+      if (lowerLimitNodeP->type == QNodeIntegerValue)
+      {
+        bson_append_int64(&notBson, "$gte", 4, lowerLimitNodeP->value.i);
+        bson_append_int64(&notBson, "$lte", 4, upperLimitNodeP->value.i);
+      }
+      else if (lowerLimitNodeP->type == QNodeFloatValue)
+      {
+        bson_append_double(&notBson, "$gte", 4, lowerLimitNodeP->value.f);
+        bson_append_double(&notBson, "$lte", 4, upperLimitNodeP->value.f);
+      }
+      else if (lowerLimitNodeP->type == QNodeStringValue)
+      {
+        bson_append_utf8(&notBson, "$gte", 4, lowerLimitNodeP->value.s, -1);
+        bson_append_utf8(&notBson, "$lte", 4, upperLimitNodeP->value.s, -1);
+      }
+
+      bson_append_document_end(&neBson, &notBson);
+    }
+    else
+    {
+      *titleP   = (char*) "ngsi-ld query language: invalid token after NE";
+      *detailsP = (char*) qNodeType(rightP->type);
       return false;
+    }
+
+    bson_append_document_end(bsonP, &neBson);
   }
   else if (treeP->type == QNodeExists)
   {
@@ -235,7 +315,7 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
     bson_init(&notExistsBson);
     bson_append_document_begin(bsonP, leftP->value.v, -1, &notExistsBson);
     bson_append_bool(&notExistsBson, "$exists", 7, false);
-    bson_append_array_end(bsonP, &notExistsBson);
+    bson_append_document_end(bsonP, &notExistsBson);
   }
   else if (treeP->type == QNodeMatch)
   {
@@ -246,7 +326,7 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
     bson_init(&matchBson);
     bson_append_document_begin(bsonP, leftP->value.v, -1, &matchBson);
     bson_append_utf8(&matchBson, "$regex", 6, rightP->value.re, -1);
-    bson_append_array_end(bsonP, &matchBson);
+    bson_append_document_end(bsonP, &matchBson);
   }
   else if (treeP->type == QNodeNoMatch)
   {
@@ -261,15 +341,14 @@ bool qTreeToBson(QNode* treeP, bson_t* bsonP, char** titleP, char** detailsP)
     bson_append_document_begin(bsonP, leftP->value.v, -1, &notBson);
     bson_append_document_begin(&notBson, "$not", 4, &noMatchBson);
     bson_append_utf8(&noMatchBson, "$regex", 6, rightP->value.re, -1);
-    bson_append_array_end(&notBson, &noMatchBson);
-    bson_append_array_end(bsonP, &notBson);
+    bson_append_document_end(&notBson, &noMatchBson);
+    bson_append_document_end(bsonP, &notBson);
   }
   else
   {
-    printf("\n");
-    printf("***********************************************\n");
-    printf("Not Implemented: %s\n", qNodeType(treeP->type));
-    exit(1);
+    *titleP   = (char*) "ngsi-ld query language: not implemented";
+    *detailsP = (char*) qNodeType(treeP->type);
+    return false;
   }
 
   return true;
@@ -27,6 +27,7 @@
 */
 extern "C"
 {
+#include "kalloc/KAlloc.h"                         // KAlloc
 #include "khash/khash.h"                           // KHashTable
 #include "kjson/KjNode.h"                          // KjNode
 }
@@ -46,6 +47,7 @@ typedef struct OrionldContextHashTables
 
 
 struct OrionldContext;
+struct OrionldContextMemo;
 typedef struct OrionldContextArray
 {
   int                     items;
@@ -109,17 +111,20 @@ extern OrionldContextOrigin orionldOriginFromString(const char* s);
 //
 typedef struct OrionldContext
 {
-  char*                 id;
-  char*                 url;
-  char*                 parent;
-  KjNode*               tree;
-  bool                  coreContext;
-  double                createdAt;
-  double                usedAt;
-  int                   lookups;
-  bool                  keyValues;
-  OrionldContextInfo    context;
-  OrionldContextOrigin  origin;
+  char*                   id;
+  char*                   url;
+  char*                   parent;
+  KjNode*                 tree;
+  bool                    coreContext;
+  double                  createdAt;
+  double                  usedAt;
+  int                     lookups;
+  bool                    keyValues;
+  OrionldContextInfo      context;
+  OrionldContextOrigin    origin;
+  OrionldContextMemo*     memoP;        // Memo of expansions and compactions - see orionldContextMemo.h
+  KAlloc*                 kallocP;      // Where the context is allocated - see orionldContextCreate
+  struct OrionldContext*  retiredNext;  // Removed from the context cache, waiting to be freed - see orionldContextCacheIndex.cpp
 } OrionldContext;
 
 #endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXT_H_
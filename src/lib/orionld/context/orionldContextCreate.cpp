@@ -22,9 +22,12 @@
 *
 * Author: Ken Zangelin
 */
+#include <stdlib.h>                                              // malloc
+
 extern "C"
 {
 #include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
 #include "kalloc/kaStrdup.h"                                     // kaStrdup
 #include "kjson/kjClone.h"                                       // kjClone
 }
@@ -78,25 +81,69 @@ OrionldContextOrigin orionldOriginFromString(const char* s)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// EvictableContext - a context together with its own kalloc instance
+//
+// Downloaded contexts may be evicted from the context cache (CLI option -ctxCacheSize), and they're downloaded again
+// if needed. So, unlike all other contexts, that are allocated in the global kalloc instance and live for as long
+// as the broker, downloaded contexts are allocated in a kalloc instance of their own, that is freed with the
+// context (orionldContextFree).
+//
+// The context must be the first field - the whole thing is freed with free(contextP).
+//
+typedef struct EvictableContext
+{
+  OrionldContext  context;
+  KAlloc          kalloc;
+  char            kallocBuffer[4 * 1024];
+} EvictableContext;
+
+
+
 // -----------------------------------------------------------------------------
 //
 // orionldContextCreate -
 //
+// All the memory of the context (except its tree, that is kjCloned with malloc) is to be allocated using contextP->kallocP.
+//
 OrionldContext* orionldContextCreate(const char* url, OrionldContextOrigin origin, const char* id, KjNode* tree, bool keyValues)
 {
-  OrionldContext* contextP = (OrionldContext*) kaAlloc(&kalloc, sizeof(OrionldContext));
+  OrionldContext* contextP;
 
-  if (contextP == NULL)
-    LM_X(1, ("out of memory - trying to allocate a OrionldContext of %d bytes", sizeof(OrionldContext)));
+  if (origin == OrionldContextDownloaded)
+  {
+    EvictableContext* ecP = (EvictableContext*) malloc(sizeof(EvictableContext));
+
+    if (ecP == NULL)
+      LM_X(1, ("out of memory - trying to allocate a OrionldContext of %d bytes", sizeof(EvictableContext)));
+
+    kaBufferInit(&ecP->kalloc, ecP->kallocBuffer, sizeof(ecP->kallocBuffer), 16 * 1024, NULL, "Context KAlloc buffer");
+
+    contextP          = &ecP->context;
+    contextP->kallocP = &ecP->kalloc;
+  }
+  else
+  {
+    contextP = (OrionldContext*) kaAlloc(&kalloc, sizeof(OrionldContext));
+
+    if (contextP == NULL)
+      LM_X(1, ("out of memory - trying to allocate a OrionldContext of %d bytes", sizeof(OrionldContext)));
+
+    contextP->kallocP = &kalloc;
+  }
 
-  contextP->origin    = origin;
-  contextP->parent    = NULL;
+  contextP->origin      = origin;
+  contextP->parent      = NULL;
+  contextP->coreContext = false;
+  contextP->createdAt   = 0;
+  contextP->usedAt      = 0;
 
   // NULL URL means NOT to be saved - will live just inside the request-thread
   if (url != NULL)
   {
-    contextP->url   = kaStrdup(&kalloc, url);
-    contextP->id    = (id != NULL)? kaStrdup(&kalloc, id) : NULL;
+    contextP->url   = kaStrdup(contextP->kallocP, url);
+    contextP->id    = (id != NULL)? kaStrdup(contextP->kallocP, id) : NULL;
 
     //
     // If just a string, no clone needed
@@ -110,8 +157,10 @@ OrionldContext* orionldContextCreate(const char* url, OrionldContextOrigin origi
     contextP->id   = NULL;
   }
 
-  contextP->keyValues = keyValues;
-  contextP->lookups   = 0;
+  contextP->keyValues   = keyValues;
+  contextP->lookups     = 0;
+  contextP->memoP       = NULL;
+  contextP->retiredNext = NULL;
 
   return contextP;
 }
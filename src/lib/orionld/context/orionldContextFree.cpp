@@ -0,0 +1,69 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+
+extern "C"
+{
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjFree.h"                                        // kjFree
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // kalloc
+#include "orionld/context/OrionldContext.h"                      // OrionldContext
+#include "orionld/context/orionldContextMemo.h"                  // orionldContextMemoRelease
+#include "orionld/context/orionldContextFree.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextFree - free a context that is no longer reachable
+//
+// The memo and the tree (cloned by orionldContextCreate if the context has a URL) are always freed.
+// The rest of the context is freed only if it has a kalloc instance of its own (downloaded contexts - see orionldContextCreate).
+// Contexts allocated in the global kalloc instance can't be freed.
+//
+// Only the context itself is freed - not the contexts of its array.
+//
+void orionldContextFree(OrionldContext* contextP)
+{
+  LM_T(LmtContext, ("Freeing context '%s'", (contextP->url != NULL)? contextP->url : "no URL"));
+
+  orionldContextMemoRelease(contextP);
+
+  if ((contextP->url != NULL) && (contextP->tree != NULL) && (contextP->tree->type != KjString))
+    kjFree(contextP->tree);
+  contextP->tree = NULL;
+
+  if (contextP->kallocP != &kalloc)
+  {
+    kaBufferReset(contextP->kallocP, false);
+    free(contextP);  // The kalloc instance and its initial buffer are part of the same allocation
+  }
+}
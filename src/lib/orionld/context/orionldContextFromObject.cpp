@@ -119,14 +119,14 @@ OrionldContext* orionldContextFromObject
     return NULL;
   }
 
-  contextP->context.hash.nameHashTable  = khashTableCreate(&kalloc, hashCode, nameCompareFunction,  ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  contextP->context.hash.nameHashTable  = khashTableCreate(contextP->kallocP, hashCode, nameCompareFunction,  ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
   if (contextP->context.hash.nameHashTable == NULL)
   {
     LM_E(("khashTableCreate failed"));
     ok = false;
   }
 
-  contextP->context.hash.valueHashTable = khashTableCreate(&kalloc, hashCode, valueCompareFunction, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  contextP->context.hash.valueHashTable = khashTableCreate(contextP->kallocP, hashCode, valueCompareFunction, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
   if (contextP->context.hash.valueHashTable == NULL)
   {
     LM_E(("khashTableCreate failed"));
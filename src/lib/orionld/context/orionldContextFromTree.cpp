@@ -25,6 +25,7 @@
 extern "C"
 {
 #include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjFree.h"                                        // kjFree
 }
@@ -111,7 +112,7 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
 
 
     contextP->context.array.items     = itemsInArray;
-    contextP->context.array.vector    = (OrionldContext**) kaAlloc(&kalloc, itemsInArray * sizeof(OrionldContext*));
+    contextP->context.array.vector    = (OrionldContext**) kaAlloc(contextP->kallocP, itemsInArray * sizeof(OrionldContext*));
 
     int ix = 0;
     for (KjNode* ctxItemP = contextTreeP->value.firstChildP; ctxItemP != NULL; ctxItemP = ctxItemP->next)
@@ -145,8 +146,11 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
           url = orionldContextUrlGenerate(&id);
 
         contextP->context.array.vector[ix] = orionldContextFromTree(url, origin, id, ctxItemP, pdP);
-        if (contextP->context.array.vector[ix] != NULL)
-          contextP->context.array.vector[ix]->parent = contextP->id;
+        OrionldContext* childP = contextP->context.array.vector[ix];
+
+        // A copy of the parent id - the child may outlive its parent (if the parent is evicted from the context cache)
+        if ((childP != NULL) && (contextP->id != NULL))
+          childP->parent = kaStrdup(childP->kallocP, contextP->id);
       }
       else
         contextP->context.array.vector[ix] = cachedContextP;
@@ -174,7 +178,7 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
         contextP = orionldContextCreate(url, origin, id, contextTreeP, false);
 
         contextP->context.array.items     = 1;
-        contextP->context.array.vector    = (OrionldContext**) kaAlloc(&kalloc, 1 * sizeof(OrionldContext*));
+        contextP->context.array.vector    = (OrionldContext**) kaAlloc(contextP->kallocP, 1 * sizeof(OrionldContext*));
         contextP->context.array.vector[0] = orionldContextFromUrl(contextTreeP->value.s, NULL, pdP);
       }
 
@@ -56,9 +56,9 @@ bool orionldContextHashTablesFill(OrionldContext* contextP, KjNode* keyValueTree
 
   for (KjNode* kvP = keyValueTree->value.firstChildP; kvP != NULL; kvP = kvP->next)
   {
-    OrionldContextItem* hiP = (OrionldContextItem*) kaAlloc(&kalloc, sizeof(OrionldContextItem));
+    OrionldContextItem* hiP = (OrionldContextItem*) kaAlloc(contextP->kallocP, sizeof(OrionldContextItem));
 
-    hiP->name = kaStrdup(&kalloc, kvP->name);
+    hiP->name = kaStrdup(contextP->kallocP, kvP->name);
     hiP->type = NULL;
 
     if (kvP->type == KjString)
@@ -75,7 +75,7 @@ bool orionldContextHashTablesFill(OrionldContext* contextP, KjNode* keyValueTree
         if (strcmp(itemP->name, "@id") == 0)
           hiP->id = itemP->value.s;  // Will be allocated in pass II
         else if (strcmp(itemP->name, "@type") == 0)
-          hiP->type = kaStrdup(&kalloc, itemP->value.s);
+          hiP->type = kaStrdup(contextP->kallocP, itemP->value.s);
       }
     }
     else
@@ -103,7 +103,7 @@ bool orionldContextHashTablesFill(OrionldContext* contextP, KjNode* keyValueTree
 
   //
   // Second pass, to fix prefix expansion in the values, and to create the valueHashTable
-  // In this pass, the 'id' (value) is allocated on the global kalloc instance
+  // In this pass, the 'id' (value) is allocated on the kalloc instance of the context
   //
   for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
   {
@@ -120,7 +120,7 @@ bool orionldContextHashTablesFill(OrionldContext* contextP, KjNode* keyValueTree
       if (colonP != NULL)
         hashItemP->id = orionldContextPrefixExpand(contextP, hashItemP->id, colonP);
 
-      hashItemP->id = kaStrdup(&kalloc, hashItemP->id);
+      hashItemP->id = kaStrdup(contextP->kallocP, hashItemP->id);
       khashItemAdd(valueHashTableP, hashItemP->id, hashItemP);
 
       itemP = itemP->next;
@@ -31,6 +31,7 @@
 #include "orionld/context/OrionldContextItem.h"                  // OrionldContextItem
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP, orionldDefaultUrl, orionldDefaultUrlLen
 #include "orionld/context/orionldContextItemValueLookup.h"       // orionldContextItemValueLookup
+#include "orionld/context/orionldContextMemo.h"                  // orionldContextMemoLookup, orionldContextMemoInsert
 #include "orionld/context/orionldContextItemAliasLookup.h"       // Own Interface
 
 
@@ -61,12 +62,21 @@ char* orionldContextItemAliasLookup
   if (strncmp(longName, orionldDefaultUrl, orionldDefaultUrlLen) == 0)
     return (char*) &longName[orionldDefaultUrlLen];
 
-  // 2. Found in Core Context?
-  contextItemP = orionldContextItemValueLookup(orionldCoreContextP, longName);
+  // 2. Already looked up? (only names that are found are memoized) - without context, it's only the Core Context
+  OrionldContext* memoContextP = (contextP != NULL)? contextP : orionldCoreContextP;
 
-  // 3. If not, look in the provided context, unless it's the Core Context
-  if ((contextItemP == NULL) && (contextP != orionldCoreContextP))
-    contextItemP = orionldContextItemValueLookup(contextP, longName);
+  if (orionldContextMemoLookup(memoContextP, longName, true, &contextItemP) == false)
+  {
+    // 2.1. Found in Core Context?
+    contextItemP = orionldContextItemValueLookup(orionldCoreContextP, longName);
+
+    // 2.2. If not, look in the provided context, unless it's the Core Context
+    if ((contextItemP == NULL) && (contextP != orionldCoreContextP))
+      contextItemP = orionldContextItemValueLookup(contextP, longName);
+
+    if (contextItemP != NULL)
+      orionldContextMemoInsert(memoContextP, longName, true, contextItemP);
+  }
 
   // 4. If not found anywhere - return the long name
   if (contextItemP == NULL)
@@ -33,6 +33,7 @@
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
 #include "orionld/context/orionldContextPrefixExpand.h"          // orionldContextPrefixExpand
 #include "orionld/context/orionldContextItemLookup.h"            // orionldContextItemLookup
+#include "orionld/context/orionldContextMemo.h"                  // orionldContextMemoLookup, orionldContextMemoInsert
 #include "orionld/context/orionldContextItemExpand.h"            // Own interface
 
 
@@ -74,12 +75,19 @@ char* orionldContextItemExpand
   if ((colonP = strchr((char*) shortName, ':')) != NULL)
     return orionldContextPrefixExpand(contextP, shortName, colonP);
 
-  // 1. Lookup in Core Context
-  contextItemP = orionldContextItemLookup(orionldCoreContextP, shortName, NULL);
+  // 0. Already looked up? (only names that are found are memoized)
+  if (orionldContextMemoLookup(contextP, shortName, false, &contextItemP) == false)
+  {
+    // 1. Lookup in Core Context
+    contextItemP = orionldContextItemLookup(orionldCoreContextP, shortName, NULL);
+
+    // 2. Lookup in given context (unless it's the Core Context)
+    if ((contextItemP == NULL) && (contextP != orionldCoreContextP))
+      contextItemP = orionldContextItemLookup(contextP, shortName, NULL);
 
-  // 2. Lookup in given context (unless it's the Core Context)
-  if ((contextItemP == NULL) && (contextP != orionldCoreContextP))
-    contextItemP = orionldContextItemLookup(contextP, shortName, NULL);
+    if (contextItemP != NULL)
+      orionldContextMemoInsert(contextP, shortName, false, contextItemP);
+  }
 
   // 3. Use the Default URL (or not!)
   if (contextItemP == NULL)
@@ -0,0 +1,187 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, calloc, free
+#include <string.h>                                              // strcmp, strlen, memcpy
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/context/OrionldContext.h"                      // OrionldContext
+#include "orionld/context/OrionldContextItem.h"                  // OrionldContextItem
+#include "orionld/context/orionldContextMemo.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoHash - FNV-1a
+//
+static unsigned int memoHash(const char* name)
+{
+  unsigned int hash = 2166136261U;
+
+  while (*name != 0)
+  {
+    hash ^= (unsigned char) *name;
+    hash *= 16777619U;
+    ++name;
+  }
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoTable - the expansion or compaction table of the memo of a context
+//
+// If 'create' is set, the memo is created if it doesn't exist. If two threads create the memo
+// at the same time, the first one wins and the other one frees its memo.
+//
+static OrionldContextMemoItem** memoTable(OrionldContext* contextP, bool compaction, bool create)
+{
+  OrionldContextMemo* memoP = __atomic_load_n(&contextP->memoP, __ATOMIC_ACQUIRE);
+
+  if ((memoP == NULL) && (create == true))
+  {
+    OrionldContextMemo* newMemoP = (OrionldContextMemo*) calloc(1, sizeof(OrionldContextMemo));
+
+    if (newMemoP == NULL)
+      return NULL;
+
+    if (__atomic_compare_exchange_n(&contextP->memoP, &memoP, newMemoP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == true)
+      memoP = newMemoP;
+    else
+      free(newMemoP);  // memoP now points to the memo that won
+  }
+
+  if (memoP == NULL)
+    return NULL;
+
+  return (compaction == true)? memoP->compaction : memoP->expansion;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoLookup -
+//
+bool orionldContextMemoLookup(OrionldContext* contextP, const char* name, bool compaction, OrionldContextItem** itemPP)
+{
+  OrionldContextMemoItem** table = memoTable(contextP, compaction, false);
+
+  if (table == NULL)
+    return false;
+
+  unsigned int hash = memoHash(name);
+
+  for (int probe = 0; probe < ORIONLD_CONTEXT_MEMO_PROBES; probe++)
+  {
+    OrionldContextMemoItem* memoItemP = __atomic_load_n(&table[(hash + probe) & (ORIONLD_CONTEXT_MEMO_SLOTS - 1)], __ATOMIC_ACQUIRE);
+
+    if (memoItemP == NULL)
+      return false;
+
+    if (strcmp(memoItemP->key, name) == 0)
+    {
+      *itemPP = memoItemP->itemP;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoInsert -
+//
+// If all the slots to be probed for the name are taken, the name is simply not memoized.
+//
+void orionldContextMemoInsert(OrionldContext* contextP, const char* name, bool compaction, OrionldContextItem* itemP)
+{
+  if ((contextP->url == NULL) || (itemP == NULL))
+    return;
+
+  OrionldContextMemoItem** table = memoTable(contextP, compaction, true);
+
+  if (table == NULL)
+    return;
+
+  int                      nameLen   = strlen(name);
+  OrionldContextMemoItem*  memoItemP = (OrionldContextMemoItem*) malloc(sizeof(OrionldContextMemoItem) + nameLen + 1);
+
+  if (memoItemP == NULL)
+    return;
+
+  memoItemP->key   = (char*) &memoItemP[1];
+  memoItemP->itemP = itemP;
+  memcpy(memoItemP->key, name, nameLen + 1);
+
+  unsigned int hash = memoHash(name);
+
+  for (int probe = 0; probe < ORIONLD_CONTEXT_MEMO_PROBES; probe++)
+  {
+    OrionldContextMemoItem** slotP     = &table[(hash + probe) & (ORIONLD_CONTEXT_MEMO_SLOTS - 1)];
+    OrionldContextMemoItem*  expected  = NULL;
+
+    if (__atomic_compare_exchange_n(slotP, &expected, memoItemP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == true)
+      return;
+
+    if (strcmp(expected->key, name) == 0)  // Another thread got here first
+      break;
+  }
+
+  free(memoItemP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoRelease -
+//
+// Only to be called when no more lookups are possible - when the context is freed (orionldContextFree), or at shutdown
+//
+void orionldContextMemoRelease(OrionldContext* contextP)
+{
+  OrionldContextMemo* memoP = contextP->memoP;
+
+  if (memoP == NULL)
+    return;
+
+  for (int ix = 0; ix < ORIONLD_CONTEXT_MEMO_SLOTS; ix++)
+  {
+    free(memoP->expansion[ix]);
+    free(memoP->compaction[ix]);
+  }
+
+  free(memoP);
+  contextP->memoP = NULL;
+}
@@ -0,0 +1,117 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTMEMO_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTMEMO_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/context/OrionldContext.h"                      // OrionldContext
+#include "orionld/context/OrionldContextItem.h"                  // OrionldContextItem
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Context Memo
+//
+//   Each cached context has a memo of the results of its lookups - both expansions (short name to context item)
+//   and compactions (long name to context item).
+//   Only names that are found are memoized. Names that aren't found are unbounded (any junk in a request), and they'd
+//   fill up the tables, leaving no room for the names of the context. So, what's in the memo is bounded by the size of
+//   the context (plus the Core Context).
+//   The memo holds the final result of the lookup - Core Context first, then the context itself (and for array contexts,
+//   all the contexts of the array), so, a hit in the memo is a single probe.
+//
+//   Contexts never change once created. A context that is reloaded, deleted or evicted is removed from the context cache,
+//   and its memo is freed with it (orionldContextFree), once no request can reach the context. So, the items of the memo
+//   are never invalidated.
+//
+//   The memo is shared by all threads. Items are added with compare-and-swap and never removed, so, no semaphore is needed.
+//   Request-local contexts (without URL) have no memo.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_CONTEXT_MEMO_SLOTS - number of slots in each table of the memo (power of 2)
+//
+#define ORIONLD_CONTEXT_MEMO_SLOTS   512
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_CONTEXT_MEMO_PROBES - max number of slots probed for a name
+//
+#define ORIONLD_CONTEXT_MEMO_PROBES  8
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextMemoItem -
+//
+typedef struct OrionldContextMemoItem
+{
+  char*                key;    // points to right after the struct
+  OrionldContextItem*  itemP;
+} OrionldContextMemoItem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextMemo -
+//
+typedef struct OrionldContextMemo
+{
+  OrionldContextMemoItem*  expansion[ORIONLD_CONTEXT_MEMO_SLOTS];
+  OrionldContextMemoItem*  compaction[ORIONLD_CONTEXT_MEMO_SLOTS];
+} OrionldContextMemo;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoLookup - returns true if the name is in the memo, and the result of the lookup in *itemPP
+//
+extern bool orionldContextMemoLookup(OrionldContext* contextP, const char* name, bool compaction, OrionldContextItem** itemPP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoInsert -
+//
+extern void orionldContextMemoInsert(OrionldContext* contextP, const char* name, bool compaction, OrionldContextItem* itemP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextMemoRelease -
+//
+extern void orionldContextMemoRelease(OrionldContext* contextP);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTMEMO_H_
@@ -39,3 +39,8 @@ OrionldContext*   orionldContextCacheArray[100];  // When 100 is not enough, a r
 OrionldContext**  orionldContextCache         = orionldContextCacheArray;
 int               orionldContextCacheSlots    = 100;
 int               orionldContextCacheSlotIx   = 0;
+int               orionldContextCacheItems    = 0;
+
+OrionldContextCacheIndexItem*  orionldContextCacheIndex[ORIONLD_CONTEXT_CACHE_INDEX_SIZE];
+int                            orionldContextCacheReaders[2] = { 0, 0 };
+int                            orionldContextCachePhase      = 0;
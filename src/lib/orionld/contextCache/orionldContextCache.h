@@ -39,6 +39,38 @@
 
 
 
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_CONTEXT_CACHE_INDEX_SIZE - number of buckets of the url/id index of the context cache
+//
+#define ORIONLD_CONTEXT_CACHE_INDEX_SIZE   4096
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_CONTEXT_CACHE_DB - the database where the contexts of the context cache are persisted (collection 'contexts')
+//
+#define ORIONLD_CONTEXT_CACHE_DB   "orionld"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextCacheIndexItem - an item in a bucket of the url/id index of the context cache
+//
+// A context is in the index twice - once with its URL as key and once with its ID (if it has an ID).
+//
+typedef struct OrionldContextCacheIndexItem
+{
+  const char*                           key;
+  OrionldContext*                       contextP;
+  struct OrionldContextCacheIndexItem*  next;
+  struct OrionldContextCacheIndexItem*  retiredNext;  // Once removed from the index, waiting to be freed
+} OrionldContextCacheIndexItem;
+
+
+
 // -----------------------------------------------------------------------------
 //
 // orionldContextCache
@@ -48,5 +80,20 @@ extern OrionldContext*   orionldContextCacheArray[100];  // When 100 is not enou
 extern OrionldContext**  orionldContextCache;
 extern int               orionldContextCacheSlots;
 extern int               orionldContextCacheSlotIx;
+extern int               orionldContextCacheItems;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndex -
+//
+// The index is modified only with orionldContextCacheSem taken, while lookups don't take the semaphore.
+// Readers (lookups and entire requests) are instead counted per phase (orionldContextCacheReaders) and what is
+// removed from the cache is not freed until no reader can reach it (see orionldContextCacheIndex.cpp).
+//
+extern OrionldContextCacheIndexItem*  orionldContextCacheIndex[ORIONLD_CONTEXT_CACHE_INDEX_SIZE];
+extern int                            orionldContextCacheReaders[2];
+extern int                            orionldContextCachePhase;
 
 #endif  // SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHE_H_
@@ -26,15 +26,17 @@
 
 extern "C"
 {
-#include "kjson/kjFree.h"                                        // kjFree
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
 }
 
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/mongoc/mongocContextCacheDelete.h"             // mongocContextCacheDelete
 #include "orionld/context/OrionldContext.h"                      // OrionldContext
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexRemove, orionldContextCacheRetire
 #include "orionld/contextCache/orionldContextCacheDelete.h"      // Own interface
 
 
@@ -43,10 +45,17 @@ extern "C"
 //
 // contextCacheReleaseOne -
 //
-static void contextCacheReleaseOne(OrionldContext* contextP)
+static void contextCacheReleaseOne(int slotIx, OrionldContext** deletedV, int* deletedP)
 {
-  if (contextP->tree != NULL)
-    kjFree(contextP->tree);
+  OrionldContext* contextP = orionldContextCache[slotIx];
+
+  mongocContextCacheDelete(contextP->id);
+  orionldContextCacheIndexRemove(contextP);
+  orionldContextCache[slotIx] = NULL;
+  --orionldContextCacheItems;
+
+  deletedV[*deletedP] = contextP;
+  *deletedP += 1;
 }
 
 
@@ -55,12 +64,18 @@ static void contextCacheReleaseOne(OrionldContext* contextP)
 //
 // orionldContextCacheDelete -
 //
+// The deleted contexts are retired (freed once no reader can reach them) only after all of them have been removed from
+// the cache, as a deleted array context would otherwise keep its deleted children from being freed.
+//
 bool orionldContextCacheDelete(const char* id)
 {
-  bool found = false;
+  bool  found   = false;
+  int   deleted = 0;
 
   sem_wait(&orionldContextCacheSem);
 
+  OrionldContext** deletedV = (OrionldContext**) kaAlloc(&orionldState.kalloc, sizeof(OrionldContext*) * (orionldContextCacheSlotIx + 1));
+
   for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
   {
     if (orionldContextCache[ix] == NULL)
@@ -72,24 +87,21 @@ bool orionldContextCacheDelete(const char* id)
     //
     if ((orionldContextCache[ix]->id != NULL) && (strcmp(id, orionldContextCache[ix]->id) == 0))
     {
-      mongocContextCacheDelete(orionldContextCache[ix]->id);
-      contextCacheReleaseOne(orionldContextCache[ix]);
-      orionldContextCache[ix] = NULL;
+      contextCacheReleaseOne(ix, deletedV, &deleted);
       found = true;
     }
     else if ((orionldContextCache[ix]->url != NULL) && (strcmp(id, orionldContextCache[ix]->url) == 0))
     {
-      mongocContextCacheDelete(orionldContextCache[ix]->id);
-      contextCacheReleaseOne(orionldContextCache[ix]);
-      orionldContextCache[ix] = NULL;
+      contextCacheReleaseOne(ix, deletedV, &deleted);
       found = true;
     }
     else if ((orionldContextCache[ix]->origin != OrionldContextDownloaded) && (orionldContextCache[ix]->parent != NULL) && (strcmp(id, orionldContextCache[ix]->parent) == 0))
-    {
-      mongocContextCacheDelete(orionldContextCache[ix]->id);
-      contextCacheReleaseOne(orionldContextCache[ix]);
-      orionldContextCache[ix] = NULL;
-    }
+      contextCacheReleaseOne(ix, deletedV, &deleted);
+  }
+
+  for (int ix = 0; ix < deleted; ix++)
+  {
+    orionldContextCacheRetire(deletedV[ix]);
   }
 
   sem_post(&orionldContextCacheSem);
@@ -0,0 +1,472 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, free
+#include <string.h>                                              // strcmp
+#include <semaphore.h>                                           // sem_trywait, sem_post
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/context/OrionldContext.h"                      // OrionldContext
+#include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldContextFree.h"                  // orionldContextFree
+#include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Grace periods
+//
+// Lookups don't take the semaphore of the context cache, and requests keep pointers to contexts (and to their items)
+// for as long as the request lasts. So, what is removed from the context cache (items of the index and the contexts
+// themselves) can't be freed right away.
+//
+// Lookups and requests are 'read sections' (orionldContextCacheReadBegin/End).
+// The readers are counted per phase (orionldContextCacheReaders[2]) and a reader is counted in the phase that is current
+// when it enters (orionldContextCachePhase).
+//
+// What is removed from the cache is 'retired'. To free it, the phase is flipped and the retired items become 'waiting'.
+// A reader that enters after the flip can't reach any of the waiting items - they were unlinked before the flip.
+// So, once no reader is left in the old phase, the waiting items are freed.
+// The old phase empties in finite time - no new readers enter it - and the end of each read section is a reclamation
+// point (as well as any modification of the cache), so, retired items are always freed, also under steady load.
+//
+// The retired and waiting lists are only touched with orionldContextCacheSem taken.
+//
+static OrionldContextCacheIndexItem*  retiredItems    = NULL;  // Retired since the last flip
+static OrionldContext*                retiredContexts = NULL;
+static OrionldContextCacheIndexItem*  waitingItems    = NULL;  // Retired before the last flip, waiting for the readers of waitingPhase
+static OrionldContext*                waitingContexts = NULL;
+static int                            waitingPhase    = 0;
+static int                            retiredPending  = 0;     // Anything retired or waiting - read without the semaphore
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexHash - FNV-1a
+//
+unsigned int orionldContextCacheIndexHash(const char* key)
+{
+  unsigned int hash = 2166136261U;
+
+  while (*key != 0)
+  {
+    hash ^= (unsigned char) *key;
+    hash *= 16777619U;
+    ++key;
+  }
+
+  return hash % ORIONLD_CONTEXT_CACHE_INDEX_SIZE;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// itemListFree -
+//
+static void itemListFree(OrionldContextCacheIndexItem* itemP)
+{
+  while (itemP != NULL)
+  {
+    OrionldContextCacheIndexItem* next = itemP->retiredNext;
+
+    free(itemP);
+    itemP = next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextListFree -
+//
+static void contextListFree(OrionldContext* contextP)
+{
+  while (contextP != NULL)
+  {
+    OrionldContext* next = contextP->retiredNext;
+
+    orionldContextFree(contextP);
+    contextP = next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retiredReclaim - free what is no longer reachable and start a new grace period if anything is retired
+//
+// orionldContextCacheSem must be taken.
+//
+static void retiredReclaim(void)
+{
+  if ((waitingItems != NULL) || (waitingContexts != NULL))
+  {
+    if (__atomic_load_n(&orionldContextCacheReaders[waitingPhase], __ATOMIC_SEQ_CST) != 0)
+      return;
+
+    itemListFree(waitingItems);
+    contextListFree(waitingContexts);
+    waitingItems    = NULL;
+    waitingContexts = NULL;
+  }
+
+  if ((retiredItems != NULL) || (retiredContexts != NULL))
+  {
+    // Flip the phase - the retired items wait for the readers of the current phase to finish
+    waitingItems    = retiredItems;
+    waitingContexts = retiredContexts;
+    retiredItems    = NULL;
+    retiredContexts = NULL;
+    waitingPhase    = orionldContextCachePhase;
+
+    __atomic_store_n(&orionldContextCachePhase, 1 - waitingPhase, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&orionldContextCacheReaders[waitingPhase], __ATOMIC_SEQ_CST) == 0)
+    {
+      itemListFree(waitingItems);
+      contextListFree(waitingContexts);
+      waitingItems    = NULL;
+      waitingContexts = NULL;
+    }
+  }
+
+  __atomic_store_n(&retiredPending, ((waitingItems != NULL) || (waitingContexts != NULL))? 1 : 0, __ATOMIC_SEQ_CST);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReadBegin - start a read section, returns the phase to be passed to orionldContextCacheReadEnd
+//
+// After being counted, the reader makes sure the phase hasn't been flipped in the meantime.
+// If it has, the reader may have been counted in the old phase without the flip seeing it, and has to retry.
+//
+int orionldContextCacheReadBegin(void)
+{
+  while (1)
+  {
+    int phase = __atomic_load_n(&orionldContextCachePhase, __ATOMIC_SEQ_CST);
+
+    __atomic_add_fetch(&orionldContextCacheReaders[phase], 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&orionldContextCachePhase, __ATOMIC_SEQ_CST) == phase)
+      return phase;
+
+    __atomic_sub_fetch(&orionldContextCacheReaders[phase], 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReadEnd - end a read section, and reclaim what's retired, if possible
+//
+// If the semaphore is busy, whoever has it will reclaim (modifications), or, the end of a later read section will.
+//
+void orionldContextCacheReadEnd(int phase)
+{
+  __atomic_sub_fetch(&orionldContextCacheReaders[phase], 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&retiredPending, __ATOMIC_SEQ_CST) == 0)
+    return;
+
+  if (sem_trywait(&orionldContextCacheSem) == 0)
+  {
+    retiredReclaim();
+    sem_post(&orionldContextCacheSem);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextCached -
+//
+static bool contextCached(OrionldContext* contextP)
+{
+  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
+  {
+    if (orionldContextCache[ix] == contextP)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// arrayReferences - does the array context 'arrayP' (or any array context inside it) reference 'contextP'?
+//
+static bool arrayReferences(OrionldContext* arrayP, OrionldContext* contextP)
+{
+  if (arrayP->keyValues == true)
+    return false;
+
+  for (int ix = 0; ix < arrayP->context.array.items; ix++)
+  {
+    OrionldContext* childP = arrayP->context.array.vector[ix];
+
+    if (childP == NULL)
+      continue;
+
+    if ((childP == contextP) || (arrayReferences(childP, contextP) == true))
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReferenced - is the context part of any array context in the cache?
+//
+// Array contexts point to the contexts of the array, and so do their memos (to items of those contexts).
+//
+// orionldContextCacheSem must be taken.
+//
+bool orionldContextCacheReferenced(OrionldContext* contextP)
+{
+  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
+  {
+    OrionldContext* cachedP = orionldContextCache[ix];
+
+    if ((cachedP != NULL) && (cachedP != contextP) && (arrayReferences(cachedP, contextP) == true))
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextRetired - is the context already waiting to be freed?
+//
+static bool contextRetired(OrionldContext* contextP)
+{
+  for (OrionldContext* retiredP = retiredContexts; retiredP != NULL; retiredP = retiredP->retiredNext)
+  {
+    if (retiredP == contextP)
+      return true;
+  }
+
+  for (OrionldContext* retiredP = waitingContexts; retiredP != NULL; retiredP = retiredP->retiredNext)
+  {
+    if (retiredP == contextP)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextRetire -
+//
+// The contexts of an array context that are not in the cache themselves (inline contexts of the array) belong
+// to the array context and are retired with it.
+//
+static void contextRetire(OrionldContext* contextP)
+{
+  if (contextRetired(contextP) == true)  // E.g. the children of an array context that is deleted together with its children
+    return;
+
+  contextP->retiredNext = retiredContexts;
+  retiredContexts       = contextP;
+
+  if (contextP->keyValues == true)
+    return;
+
+  for (int ix = 0; ix < contextP->context.array.items; ix++)
+  {
+    OrionldContext* childP = contextP->context.array.vector[ix];
+
+    if ((childP == NULL) || (childP == orionldCoreContextP) || (contextCached(childP) == true) || (orionldContextCacheReferenced(childP) == true))
+      continue;
+
+    contextRetire(childP);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheRetire - free a context that has been removed from the cache, once no reader can reach it
+//
+// A context that is still referenced by an array context in the cache is not freed.
+// orionldContextCacheSem must be taken, and the context must already be removed from the cache (and its index).
+//
+void orionldContextCacheRetire(OrionldContext* contextP)
+{
+  if (orionldContextCacheReferenced(contextP) == true)
+    LM_T(LmtContext, ("Context '%s' is part of an array context in the cache - not freed", contextP->url));
+  else
+    contextRetire(contextP);
+
+  retiredReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexItemAdd -
+//
+// The item is fully initialized before it is published, so a concurrent lookup sees either
+// the old bucket or the new one.
+//
+static void indexItemAdd(const char* key, OrionldContext* contextP)
+{
+  unsigned int                   bucket = orionldContextCacheIndexHash(key);
+  OrionldContextCacheIndexItem*  itemP  = (OrionldContextCacheIndexItem*) malloc(sizeof(OrionldContextCacheIndexItem));
+
+  if (itemP == NULL)
+    LM_X(1, ("Out of memory (allocating an item for the context cache index)"));
+
+  itemP->key         = key;
+  itemP->contextP    = contextP;
+  itemP->next        = orionldContextCacheIndex[bucket];
+  itemP->retiredNext = NULL;
+
+  __atomic_store_n(&orionldContextCacheIndex[bucket], itemP, __ATOMIC_RELEASE);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexItemRemove -
+//
+// The unlinked item keeps its 'next' pointer, so that an ongoing lookup that is looking at the item can continue.
+//
+static void indexItemRemove(const char* key, OrionldContext* contextP)
+{
+  unsigned int                    bucket = orionldContextCacheIndexHash(key);
+  OrionldContextCacheIndexItem**  prevP  = &orionldContextCacheIndex[bucket];
+  OrionldContextCacheIndexItem*   itemP  = *prevP;
+
+  while (itemP != NULL)
+  {
+    if (itemP->contextP == contextP)
+    {
+      __atomic_store_n(prevP, itemP->next, __ATOMIC_SEQ_CST);  // Must be visible before the phase flip
+
+      itemP->retiredNext = retiredItems;
+      retiredItems       = itemP;
+      return;
+    }
+
+    prevP = &itemP->next;
+    itemP = itemP->next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexAdd -
+//
+void orionldContextCacheIndexAdd(OrionldContext* contextP)
+{
+  if (contextP->url != NULL)
+    indexItemAdd(contextP->url, contextP);
+
+  if ((contextP->id != NULL) && ((contextP->url == NULL) || (strcmp(contextP->id, contextP->url) != 0)))
+    indexItemAdd(contextP->id, contextP);
+
+  retiredReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRemove -
+//
+void orionldContextCacheIndexRemove(OrionldContext* contextP)
+{
+  if (contextP->url != NULL)
+    indexItemRemove(contextP->url, contextP);
+
+  if ((contextP->id != NULL) && ((contextP->url == NULL) || (strcmp(contextP->id, contextP->url) != 0)))
+    indexItemRemove(contextP->id, contextP);
+
+  retiredReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRelease -
+//
+// Called at shutdown, when no more lookups are possible
+//
+void orionldContextCacheIndexRelease(void)
+{
+  for (int bucket = 0; bucket < ORIONLD_CONTEXT_CACHE_INDEX_SIZE; bucket++)
+  {
+    OrionldContextCacheIndexItem* itemP = orionldContextCacheIndex[bucket];
+
+    while (itemP != NULL)
+    {
+      OrionldContextCacheIndexItem* next = itemP->next;
+
+      free(itemP);
+      itemP = next;
+    }
+
+    orionldContextCacheIndex[bucket] = NULL;
+  }
+
+  itemListFree(retiredItems);
+  itemListFree(waitingItems);
+  contextListFree(retiredContexts);
+  contextListFree(waitingContexts);
+
+  retiredItems    = NULL;
+  waitingItems    = NULL;
+  retiredContexts = NULL;
+  waitingContexts = NULL;
+}
@@ -0,0 +1,94 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
+#define SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/context/OrionldContext.h"                      // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexHash -
+//
+extern unsigned int orionldContextCacheIndexHash(const char* key);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexAdd - add a context to the index (orionldContextCacheSem must be taken)
+//
+extern void orionldContextCacheIndexAdd(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRemove - remove a context from the index (orionldContextCacheSem must be taken)
+//
+extern void orionldContextCacheIndexRemove(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReadBegin - start a read section (a lookup, or a request), returns the phase of the reader
+//
+extern int orionldContextCacheReadBegin(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReadEnd - end a read section started with orionldContextCacheReadBegin
+//
+extern void orionldContextCacheReadEnd(int phase);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheReferenced - is the context part of any array context in the cache? (orionldContextCacheSem must be taken)
+//
+extern bool orionldContextCacheReferenced(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheRetire - free a context removed from the cache, once no reader can reach it (orionldContextCacheSem must be taken)
+//
+extern void orionldContextCacheRetire(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRelease -
+//
+extern void orionldContextCacheIndexRelease(void);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
@@ -26,6 +26,7 @@
 
 extern "C"
 {
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjLookup.h"                                      // kjLookup
 #include "kjson/kjBuilder.h"                                     // kjChildRemove
@@ -35,7 +36,7 @@ extern "C"
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
 #include "orionld/types/OrionldProblemDetails.h"                 // OrionldProblemDetails
-#include "orionld/common/orionldState.h"                         // dbHost, mongoContextsCollectionP, coreContextUrl
+#include "orionld/common/orionldState.h"                         // dbHost, coreContextUrl
 #include "orionld/mongoc/mongocInit.h"                           // mongocInit
 #include "orionld/mongoc/mongocContextCacheGet.h"                // mongocContextCacheGet
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
@@ -84,7 +85,7 @@ void dbContextToCache(KjNode* dbContextP, KjNode* atContextP, bool keyValues, bo
   }
 
   if (parentNodeP != NULL)
-    contextP->parent = parentNodeP->value.s;
+    contextP->parent = kaStrdup(contextP->kallocP, parentNodeP->value.s);
 }
 
 
@@ -96,11 +97,12 @@ void dbContextToCache(KjNode* dbContextP, KjNode* atContextP, bool keyValues, bo
 void orionldContextCacheInit(void)
 {
   bzero(&orionldContextCacheArray, sizeof(orionldContextCacheArray));
+  bzero(&orionldContextCacheIndex, sizeof(orionldContextCacheIndex));
 
   if (sem_init(&orionldContextCacheSem, 0, 1) == -1)
     LM_X(1, ("Runtime Error (error initializing semaphore for orionld context list; %s)", strerror(errno)));
 
-  mongocInit(dbHost, "orionld");  // If mongocInit fails, an exit is issued
+  mongocInit(dbHost);  // If mongocInit fails, an exit is issued
 
   //
   // Retrieve the context cache from the database and populate the context cache in RAM
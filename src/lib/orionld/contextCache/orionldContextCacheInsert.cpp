@@ -34,7 +34,9 @@
 #include "orionld/serviceRoutines/orionldPostSubscriptions.h"    // orionldPostSubscriptions
 #include "orionld/serviceRoutines/orionldPostRegistrations.h"    // orionldPostRegistrations
 #include "orionld/context/OrionldContext.h"                      // OrionldContext
+#include "orionld/mongoc/mongocContextCacheDelete.h"             // mongocContextCacheDelete
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexAdd, orionldContextCacheIndexRemove, ...
 #include "orionld/contextCache/orionldContextCacheInsert.h"      // Own interface
 
 
@@ -61,6 +63,67 @@ const char* originName(OrionldContextOrigin origin)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// contextCacheEvict - remove the least recently used downloaded context from the cache
+//
+// Only downloaded contexts are evicted - they can be downloaded again if needed, and they are allocated in a kalloc
+// instance of their own (see orionldContextCreate), so they can be freed.
+// Contexts that are part of an array context in the cache are not evicted - the array context points to them.
+//
+// The evicted context is removed from the cache and from the DB, and freed once no ongoing request can reach it
+// (orionldContextCacheRetire).
+//
+// The context that was just inserted ('insertedP') is not evicted.
+//
+// orionldContextCacheSem must be taken.
+//
+static bool contextCacheEvict(OrionldContext* insertedP)
+{
+  int lruIx = -1;
+
+  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
+  {
+    OrionldContext* contextP = orionldContextCache[ix];
+
+    if ((contextP == NULL) || (contextP == insertedP) || (contextP->kallocP == &kalloc) || (contextP->coreContext == true))
+      continue;
+
+    if (lruIx != -1)
+    {
+      OrionldContext* lruP = orionldContextCache[lruIx];
+
+      if ((contextP->usedAt > lruP->usedAt) || ((contextP->usedAt == lruP->usedAt) && (contextP->lookups >= lruP->lookups)))
+        continue;
+    }
+
+    if (orionldContextCacheReferenced(contextP) == true)
+      continue;
+
+    lruIx = ix;
+  }
+
+  if (lruIx == -1)
+    return false;
+
+  OrionldContext* contextP = orionldContextCache[lruIx];
+
+  LM_T(LmtContext, ("Evicting context '%s' from the context cache", contextP->url));
+
+  if (contextP->id != NULL)
+    mongocContextCacheDelete(contextP->id);
+
+  orionldContextCacheIndexRemove(contextP);
+  orionldContextCache[lruIx] = NULL;
+  --orionldContextCacheItems;
+
+  orionldContextCacheRetire(contextP);
+
+  return true;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // orionldContextCacheInsert -
@@ -129,5 +192,17 @@ void orionldContextCacheInsert(OrionldContext* contextP)
   }
 
   orionldContextCache[slotNo] = contextP;
+  orionldContextCacheIndexAdd(contextP);
+  ++orionldContextCacheItems;
+
+  if (contextCacheMaxSize > 0)
+  {
+    while (orionldContextCacheItems > contextCacheMaxSize)
+    {
+      if (contextCacheEvict(contextP) == false)
+        break;
+    }
+  }
+
   sem_post(&orionldContextCacheSem);
 }
@@ -30,6 +30,7 @@
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/context/OrionldContext.h"                      // OrionldContext
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexHash
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // Own interface
 
 
@@ -38,28 +39,34 @@
 //
 // orionldContextCacheLookup -
 //
+// The semaphore of the context cache is not taken - see orionldContextCacheIndex.cpp
+// The lookup is a read section of its own, for callers that aren't inside a request (that is a read section).
+//
 OrionldContext* orionldContextCacheLookup(const char* url)
 {
-  OrionldContext* contextP = NULL;
+  OrionldContext*                contextP = NULL;
+  unsigned int                   bucket   = orionldContextCacheIndexHash(url);
+  int                            phase    = orionldContextCacheReadBegin();
+  OrionldContextCacheIndexItem*  itemP    = __atomic_load_n(&orionldContextCacheIndex[bucket], __ATOMIC_ACQUIRE);
 
-  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
+  while (itemP != NULL)
   {
-    if (orionldContextCache[ix] == NULL)
-      continue;
-
-    if (strcmp(url, orionldContextCache[ix]->url) == 0)
-      contextP = orionldContextCache[ix];
-
-    if ((orionldContextCache[ix]->id != NULL) && (strcmp(url, orionldContextCache[ix]->id) == 0))
-      contextP = orionldContextCache[ix];
-
-    if (contextP != NULL)
+    if (strcmp(url, itemP->key) == 0)
     {
-      contextP->usedAt   = orionldState.requestTime;
-      contextP->lookups += 1;
-      return contextP;
+      contextP = itemP->contextP;
+      break;
     }
+
+    itemP = __atomic_load_n(&itemP->next, __ATOMIC_ACQUIRE);
   }
 
-  return NULL;
+  if (contextP != NULL)
+  {
+    contextP->usedAt   = orionldState.requestTime;
+    contextP->lookups += 1;
+  }
+
+  orionldContextCacheReadEnd(phase);
+
+  return contextP;
 }
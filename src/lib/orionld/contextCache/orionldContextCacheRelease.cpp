@@ -32,7 +32,9 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "orionld/context/orionldContextMemo.h"                  // orionldContextMemoRelease
 #include "orionld/contextCache/orionldContextCache.h"            // orionldContextCache, orionldContextCacheSlotIx
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexRelease
 #include "orionld/contextCache/orionldContextCacheRelease.h"     // Own interface
 
 
@@ -53,5 +55,9 @@ void orionldContextCacheRelease(void)
       kjFree(orionldContextCache[ix]->tree);
       orionldContextCache[ix]->tree = NULL;
     }
+
+    orionldContextMemoRelease(orionldContextCache[ix]);
   }
+
+  orionldContextCacheIndexRelease();
 }
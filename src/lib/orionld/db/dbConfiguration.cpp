@@ -44,7 +44,6 @@ DbEntitiesAttributeLookupFunction         dbEntitiesAttributeLookup;
 DbEntityAttributeInstanceLookupFunction   dbEntityAttributeInstanceLookup;
 DbEntityAttributeWithDatasetsLookup       dbEntityAttributeWithDatasetsLookup;
 DbEntityAttributesDeleteFunction          dbEntityAttributesDelete;
-DbEntityTypeGet                           dbEntityTypeGet;
 DbEntityUpdateFunction                    dbEntityUpdate;
 DbEntityFieldReplaceFunction              dbEntityFieldReplace;
 DbEntityFieldDeleteFunction               dbEntityFieldDelete;
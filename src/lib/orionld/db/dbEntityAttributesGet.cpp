@@ -26,11 +26,9 @@
 
 extern "C"
 {
-#include "kalloc/kaStrdup.h"                                      // kaStrdup
 #include "kjson/KjNode.h"                                         // KjNode
 #include "kjson/kjBuilder.h"                                      // kjArray, kjObject
 #include "kjson/kjLookup.h"                                       // kjLookup
-#include "kjson/kjClone.h"                                        // kjClone
 #include "kjson/kjRender.h"                                       // kjFastRender
 }
 
@@ -41,12 +39,11 @@ extern "C"
 #include "orionld/common/orionldState.h"                          // orionldState
 #include "orionld/common/uuidGenerate.h"                          // uuidGenerate
 #include "orionld/common/orionldErrorResponse.h"                  // orionldErrorResponseCreate
-#include "orionld/common/eqForDot.h"                              // eqForDot
-#include "orionld/common/dotForEq.h"                              // dotForEq
 #include "orionld/context/orionldContextItemAliasLookup.h"        // orionldContextItemAliasLookup
 #include "orionld/kjTree/kjStringValueLookupInArray.h"            // kjStringValueLookupInArray
 #include "orionld/kjTree/kjStringArraySortedInsert.h"             // kjStringArraySortedInsert
-#include "orionld/db/dbConfiguration.h"                           // dbEntityAttributesFromRegistrationsGet, dbEntitiesGet
+#include "orionld/db/dbConfiguration.h"                           // dbEntityTypesFromRegistrationsGet
+#include "orionld/mongoc/mongocCatalogGet.h"                      // mongocCatalogGet
 #include "orionld/db/dbEntityAttributesGet.h"                     // Own interface
 
 
@@ -81,58 +78,35 @@ static KjNode* getEntityAttributesResponse(KjNode* sortedArrayP)
 //
 // PARAMETERS
 // - outArray: The result of the operation
-// - local:    The output from dbEntitiesGet(attrNames), which is an array of the attrNames field of matching entities, e.g.:
+// - catalogP: The output from mongocCatalogGet(NULL), which is an array of the entity types of the entity catalog, e.g.:
 //               [
-//                 { "attrNames": ["https://uri.etsi.org/ngsi-ld/default-context/P1","https://uri.etsi.org/ngsi-ld/default-context/P2"] },
-//                 { "attrNames": ["https://uri.etsi.org/ngsi-ld/default-context/P2","https://uri.etsi.org/ngsi-ld/default-context/R1"] },
+//                 { "_id": "https://uri.etsi.org/ngsi-ld/default-context/T1", "entities": 2, "attrs": { "https://uri.etsi.org/ngsi-ld/default-context/P1": { "Property": 2 } } },
+//                 { "_id": "https://uri.etsi.org/ngsi-ld/default-context/T2", "entities": 1, "attrs": { "https://uri.etsi.org/ngsi-ld/default-context/R1": { "Relationship": 1 } } }
 //               ]
 //
-// What we need to do now is to extract all "attrNames" from the objects in the array and
+// What we need to do now is to extract all attribute names from the "attrs" of the objects in the array and
 // - loop over the attribute names
 // - lookup the alias
 // - sorted insert into a new array - the output array (first lookup to we have no duplicates)
 //
-static void localAttrNamesExtract(KjNode* outArray, KjNode* local)
+static void localAttrNamesExtract(KjNode* outArray, KjNode* catalogP)
 {
-  for (KjNode* objP = local->value.firstChildP; objP != NULL; objP = objP->next)
+  for (KjNode* catalogTypeP = catalogP->value.firstChildP; catalogTypeP != NULL; catalogTypeP = catalogTypeP->next)
   {
-    KjNode* attrNamesP = kjLookup(objP, "attrNames");
+    KjNode* attrsP = kjLookup(catalogTypeP, "attrs");
 
-    if (attrNamesP == NULL)
-    {
-      LM_E(("Database Error (entity:attrNames not present in DB)"));
+    if (attrsP == NULL)
       continue;
-    }
 
-    if (attrNamesP->type != KjArray)
+    for (KjNode* attrP = attrsP->value.firstChildP; attrP != NULL; attrP = attrP->next)
     {
-      LM_E(("Database Error (entity:attrNames present but not an Array: '%s')", kjValueType(attrNamesP->type)));
-      continue;
-    }
-
-    KjNode* aP = attrNamesP->value.firstChildP;
-    KjNode* next;
+      char* attrName = orionldContextItemAliasLookup(orionldState.contextP, attrP->name, NULL, NULL);
 
-    while (aP != NULL)
-    {
-      next = aP->next;
-
-      if (aP->type != KjString)
+      if (kjStringValueLookupInArray(outArray, attrName) == NULL)
       {
-        LM_E(("Database Error (entity:attrNames item is not a String (it is of type '%s')", kjValueType(aP->type)));
-        aP = next;
-        continue;
+        KjNode* attrNameNodeP = kjString(orionldState.kjsonP, NULL, attrName);
+        kjStringArraySortedInsert(outArray, attrNameNodeP);
       }
-
-      aP->value.s = orionldContextItemAliasLookup(orionldState.contextP, aP->value.s, NULL, NULL);
-
-      if (kjStringValueLookupInArray(outArray, aP->value.s) == NULL)
-      {
-        kjChildRemove(objP, aP);
-        kjStringArraySortedInsert(outArray, aP);
-      }
-
-      aP = next;
     }
   }
 }
@@ -202,17 +176,12 @@ static void remoteAttrNamesExtract(KjNode* outArray, KjNode* remote)
 static KjNode* dbEntityAttributesGetWithoutDetails(OrionldProblemDetails* pdP)
 {
   //
-  // GET local attributes - i.e. from the "entities" collection
+  // GET local attributes - i.e. from the entity catalog
   //
-  KjNode* localEntityArray;
-  char*   fields[1] = { (char*) "attrNames" };
-
-  localEntityArray = dbEntitiesGet(fields, 1);
-
+  KjNode* catalogP = mongocCatalogGet(NULL);
   KjNode* outArray = kjArray(orionldState.kjsonP, "attributeList");
 
-  if (localEntityArray != NULL)
-    localAttrNamesExtract(outArray, localEntityArray);
+  localAttrNamesExtract(outArray, catalogP);
 
   //
   // GET external attributes - i.e. from the "registrations" collection
@@ -227,76 +196,41 @@ static KjNode* dbEntityAttributesGetWithoutDetails(OrionldProblemDetails* pdP)
 
 
 
-// -----------------------------------------------------------------------------
-//
-// entityDataExtract -
-//
-bool entityDataExtract(KjNode* _idNodeP, char** entityIdPP, char** entityTypePP)
-{
-  if (_idNodeP == NULL)
-    return false;
-
-  if (_idNodeP->type != KjObject)
-    return false;
-
-  KjNode* idNodeP   = kjLookup(_idNodeP, "id");
-  KjNode* typeNodeP = kjLookup(_idNodeP, "type");
-
-  if ((idNodeP == NULL) || (typeNodeP == NULL))
-    return false;
-
-  if ((idNodeP->type != KjString) || (typeNodeP->type != KjString))
-    return false;
-
-  *entityIdPP   = idNodeP->value.s;
-  *entityTypePP = orionldContextItemAliasLookup(orionldState.contextP, typeNodeP->value.s, NULL, NULL);
-
-  return true;
-}
-
-
-
 // -----------------------------------------------------------------------------
 //
 // attributeInfoAdd -
 //
 // PARAMETERS
 //   arrayAttributeP:     pointer to the attribute info in the output array
-//   aP:                  the attribute to be appended to arrayAttributeP
-//   entityType:          the type of the entity that aP belongs to
+//   attrTypesP:          the attribute types of the attribute, with their counters, e.g. { "Property": 12 }
+//   entityType:          the type of the entities that have the attribute
 //
 //
-// 1. Lookup attributeCount and increment
-// 2. Lookup attributeTypes and make sure 'attributeType' is present - if not, add
+// 1. Lookup attributeCount and increment with the counters of the attribute types
+// 2. Lookup attributeTypes and make sure each attribute type is present - if not, add
 // 3. Lookup typeNames and make sure 'entityType' is present - if not, add
 //
-static void attributeInfoAdd(KjNode* arrayAttributeP, KjNode* aP, char* entityType)
+static void attributeInfoAdd(KjNode* arrayAttributeP, KjNode* attrTypesP, char* entityType)
 {
   KjNode*     countP        = kjLookup(arrayAttributeP, "attributeCount");
-  KjNode*     attrTypesP    = kjLookup(arrayAttributeP, "attributeTypes");
+  KjNode*     attrTypeListP = kjLookup(arrayAttributeP, "attributeTypes");
   KjNode*     typeNamesP    = kjLookup(arrayAttributeP, "typeNames");
 
-  KjNode*     attrTypeNodeP = kjLookup(aP, "type");
-
-  if ((countP == NULL) || (attrTypesP == NULL) || (typeNamesP == NULL))
+  if ((countP == NULL) || (attrTypeListP == NULL) || (typeNamesP == NULL))
   {
-    LM_E(("Internal Error (missing field: countP:%p, attrTypesP:%p, typeNamesP:%p", countP, attrTypesP, typeNamesP));
+    LM_E(("Internal Error (missing field: countP:%p, attrTypeListP:%p, typeNamesP:%p", countP, attrTypeListP, typeNamesP));
     return;
   }
 
-  if (attrTypeNodeP == NULL)
+  for (KjNode* attrTypeP = attrTypesP->value.firstChildP; attrTypeP != NULL; attrTypeP = attrTypeP->next)
   {
-    LM_E(("Internal Error (attribute type not found)"));
-    return;
-  }
-  const char* attributeType = attrTypeNodeP->value.s;
-
-  countP->value.i += 1;
+    countP->value.i += attrTypeP->value.i;
 
-  if (kjStringValueLookupInArray(attrTypesP, attributeType) == NULL)
-  {
-    KjNode* typeItemP = kjString(orionldState.kjsonP, NULL, attributeType);
-    kjChildAdd(attrTypesP, typeItemP);
+    if (kjStringValueLookupInArray(attrTypeListP, attrTypeP->name) == NULL)
+    {
+      KjNode* typeItemP = kjString(orionldState.kjsonP, NULL, attrTypeP->name);
+      kjChildAdd(attrTypeListP, typeItemP);
+    }
   }
 
   if (kjStringValueLookupInArray(typeNamesP, entityType) == NULL)
@@ -312,15 +246,12 @@ static void attributeInfoAdd(KjNode* arrayAttributeP, KjNode* aP, char* entityTy
 //
 // attributeCreate -
 //
-static KjNode* attributeCreate(KjNode* attrV, KjNode* aP, char* entityType)
+static KjNode* attributeCreate(KjNode* attrV, const char* attrLongName)
 {
-  KjNode*       attrTypeNodeP    = kjLookup(aP, "type");
-  const char*   attributeType    = (attrTypeNodeP != NULL)? attrTypeNodeP->value.s : NULL;
-  const char*   attrLongName     = aP->name;
   KjNode*       entityAttrP      = kjObject(orionldState.kjsonP, attrLongName);  // Saving long name of attr as name of the object
   KjNode*       idP              = kjString(orionldState.kjsonP,  "id", attrLongName);
   KjNode*       typeP            = kjString(orionldState.kjsonP,  "type", "Attribute");
-  KjNode*       attributeCountP  = kjInteger(orionldState.kjsonP, "attributeCount", 1);
+  KjNode*       attributeCountP  = kjInteger(orionldState.kjsonP, "attributeCount", 0);
   KjNode*       attributeTypesP  = kjArray(orionldState.kjsonP,   "attributeTypes");
   KjNode*       typeNamesP       = kjArray(orionldState.kjsonP,   "typeNames");
   char*         attrShortName    = orionldContextItemAliasLookup(orionldState.contextP, attrLongName, NULL, NULL);
@@ -344,15 +275,6 @@ static KjNode* attributeCreate(KjNode* attrV, KjNode* aP, char* entityType)
     kjChildAdd(entityAttrP, attributeNameNodeP);
   }
 
-  KjNode* entityTypeP = kjString(orionldState.kjsonP, NULL, entityType);
-  kjChildAdd(typeNamesP, entityTypeP);
-
-  if (attributeType != NULL)
-  {
-    KjNode* attributeTypeP = kjString(orionldState.kjsonP, NULL, attributeType);
-    kjChildAdd(attributeTypesP, attributeTypeP);
-  }
-
   // Finally, add the entityAttr to the attribute array
   kjChildAdd(attrV, entityAttrP);
 
@@ -365,7 +287,7 @@ static KjNode* attributeCreate(KjNode* attrV, KjNode* aP, char* entityType)
 //
 // attributeLookup -
 //
-static KjNode* attributeLookup(KjNode* attrV, char* attrLongName)
+static KjNode* attributeLookup(KjNode* attrV, const char* attrLongName)
 {
   for (KjNode* attrObjectP = attrV->value.firstChildP; attrObjectP != NULL; attrObjectP = attrObjectP->next)
   {
@@ -395,40 +317,20 @@ static KjNode* attributeLookup(KjNode* attrV, char* attrLongName)
 //   { ... }
 // ]
 //
-// The output from dbEntitiesGet looks like this;
+// The output from mongocCatalogGet looks like this:
 // [
-//     {
-//         "_id": {
-//             "id": "urn:ngsi-ld:entities:E0",
-//             "servicePath": "/",
-//             "type": "https://uri.etsi.org/ngsi-ld/default-context/T"
-//         },
-//         "attrs": {
-//             "https://uri=etsi=org/ngsi-ld/default-context/P1": {
-//                 "creDate": 1619103030.209846,
-//                 "mdNames": [],
-//                 "modDate": 1619103030.209846,
-//                 "type": "Property",
-//                 "value": 1
-//             },
-//             "https://uri=etsi=org/ngsi-ld/default-context/P2": {
-//                 "creDate": 1619103030.209846,
-//                 "mdNames": [],
-//                 "modDate": 1619103030.209846,
-//                 "type": "Property",
-//                 "value": 1
-//             },
-//             "https://uri=etsi=org/ngsi-ld/default-context/R1": {
-//                 "creDate": 1619103030.209846,
-//                 "mdNames": [],
-//                 "modDate": 1619103030.209846,
-//                 "type": "Relationship",
-//                 "value": "urn:ngsu-ld:entities:E1"
-//             }
-//         }
+//   {
+//     "_id":      "https://uri.etsi.org/ngsi-ld/default-context/T",
+//     "entities": 2,
+//     "attrs": {
+//       "https://uri.etsi.org/ngsi-ld/default-context/P1": { "Property": 2 },
+//       "https://uri.etsi.org/ngsi-ld/default-context/R1": { "Relationship": 1 }
 //     }
+//   }
 // ]
 //
+// The counters of the attribute types are summed up to make up the attributeCount.
+//
 //
 // WARNING
 //   This first implementation will perform a single query to get ALL the info in one go -
@@ -447,81 +349,44 @@ static KjNode* attributeLookup(KjNode* attrV, char* attrLongName)
 static KjNode* dbEntityAttributesGetWithDetails(OrionldProblemDetails* pdP, char* attributeName)
 {
   //
-  // GET local attributes - i.e. from the "entities" collection
-  //
-  KjNode* localEntityArray;
-  char*   fields[2] = { (char*) "_id", (char*) "attrs" };
-
-  localEntityArray = dbEntitiesGet(fields, 2);
-
-  if (localEntityArray == NULL)
-  {
-    if (attributeName == NULL)  // GET /attributes?details=true
-    {
-      KjNode* empty = kjArray(orionldState.kjsonP, NULL);
-      return empty;
-    }
-    else
-    {
-      orionldProblemDetailsFill(pdP, OrionldResourceNotFound, "Attribute Not Found", attributeName, 404);
-      orionldErrorResponseCreate(pdP->type, pdP->title, pdP->detail);
-      return orionldState.responseTree;
-    }
-  }
-
-
-  //
-  // The attributes are stored in mongo with all dots replaced for '=', so ...
+  // GET local attributes - i.e. from the entity catalog
   //
-  char* attributeNameEq = NULL;
+  KjNode* catalogP = mongocCatalogGet(NULL);
+  KjNode* attrV    = kjArray(orionldState.kjsonP, NULL);
 
-  if (attributeName != NULL)
-  {
-    attributeNameEq = kaStrdup(&orionldState.kalloc, attributeName);
-    dotForEq(attributeNameEq);
-  }
-
-  // Looping over output from dbEntitiesGet
-  KjNode* attrV = kjArray(orionldState.kjsonP, NULL);
-  for (KjNode* entityP = localEntityArray->value.firstChildP; entityP != NULL; entityP = entityP->next)
+  for (KjNode* catalogTypeP = catalogP->value.firstChildP; catalogTypeP != NULL; catalogTypeP = catalogTypeP->next)
   {
-    KjNode* _idNode   = kjLookup(entityP, "_id");
-    KjNode* attrsNode = kjLookup(entityP, "attrs");
-    char*   entityId;
-    char*   entityType;
+    KjNode* _idNode   = kjLookup(catalogTypeP, "_id");
+    KjNode* attrsNode = kjLookup(catalogTypeP, "attrs");
 
-    if (attrsNode == NULL)                     // "attrs" not even there
+    if ((_idNode == NULL) || (_idNode->type != KjString))
       continue;
-    if (attrsNode->type != KjObject)           // "attrs" is of wrong type - bug in DB!!!
-      continue;
-    if (attrsNode->value.firstChildP == NULL)  // "attrs" there but empty
+    if (attrsNode == NULL)                     // No attributes for this entity type
       continue;
 
-    if ((_idNode == NULL) || (entityDataExtract(_idNode, &entityId, &entityType) == false))
-      continue;
+    char* entityType = orionldContextItemAliasLookup(orionldState.contextP, _idNode->value.s, NULL, NULL);
 
     for (KjNode* aP = attrsNode->value.firstChildP; aP != NULL; aP = aP->next)
     {
       //
       // For GET /attributes/{attributeName}, one single attribute is considered
       //
-      if ((attributeNameEq != NULL) && (strcmp(aP->name, attributeNameEq) != 0))
+      if ((attributeName != NULL) && (strcmp(aP->name, attributeName) != 0))
         continue;
 
       //
       // Lookup the attribute in the current output
       // Not there?  Create it
       //
-      eqForDot(aP->name);
       KjNode* arrayAttributeP = attributeLookup(attrV, aP->name);
       if (arrayAttributeP == NULL)
-        arrayAttributeP = attributeCreate(attrV, aP, entityType);
-      else
-        attributeInfoAdd(arrayAttributeP, aP, entityType);
+        arrayAttributeP = attributeCreate(attrV, aP->name);
+
+      attributeInfoAdd(arrayAttributeP, aP, entityType);
     }
   }
 
-  if (attributeNameEq != NULL)
+  if (attributeName != NULL)
   {
     if (attrV->value.firstChildP == NULL)
     {
@@ -42,82 +42,74 @@ extern "C"
 #include "orionld/context/orionldContextItemAliasLookup.h"        // orionldContextItemAliasLookup
 #include "orionld/kjTree/kjStringValueLookupInArray.h"            // kjStringValueLookupInArray
 #include "orionld/kjTree/kjStringArraySortedInsert.h"             // kjStringArraySortedInsert
-#include "orionld/db/dbConfiguration.h"                           // dbEntityTypesFromRegistrationsGet, dbEntitiesGet
+#include "orionld/db/dbConfiguration.h"                           // dbEntityTypesFromRegistrationsGet
+#include "orionld/mongoc/mongocCatalogGet.h"                      // mongocCatalogGet
 #include "orionld/db/dbEntityTypesGet.h"                          // Own interface
 
 
 
 // -----------------------------------------------------------------------------
 //
-// typesExtract -
+// localTypesGet - the local entity types, from the entity catalog
 //
-static KjNode* typesExtract(KjNode* array)
+// Without details, an array of the aliases of the entity types is returned.
+// With details, an array of objects, with the FQN of the entity type, its alias and the aliases of its attributes:
+//   { "id": "https://uri.etsi.org/ngsi-ld/default-context/T", "typeName": "T", "attributeNames": [ "P1", "R1" ] }
+//
+// The entity types of the catalog are unique, so, no duplicates need to be removed.
+// NULL is returned if there are no local entity types.
+//
+static KjNode* localTypesGet(bool details)
 {
+  KjNode* catalogP = mongocCatalogGet(NULL);
+
+  if (catalogP->value.firstChildP == NULL)
+    return NULL;
+
   KjNode* typeArray = kjArray(orionldState.kjsonP, NULL);
 
-  for (KjNode* entityP = array->value.firstChildP; entityP != NULL; entityP = entityP->next)
+  for (KjNode* catalogTypeP = catalogP->value.firstChildP; catalogTypeP != NULL; catalogTypeP = catalogTypeP->next)
   {
-    KjNode* idP   = entityP->value.firstChildP;  // The entities has a single child '_id'
-    KjNode* typeP = kjLookup(idP, "type");
+    KjNode* _idP = kjLookup(catalogTypeP, "_id");
 
-    if (typeP != NULL)
+    if ((_idP == NULL) || (_idP->type != KjString))
     {
-      kjChildAdd(typeArray, typeP);  // OK to break tree, as idP is one level up and its next pointer is still intact
-      typeP->value.s = orionldContextItemAliasLookup(orionldState.contextP, typeP->value.s, NULL, NULL);
+      LM_E(("Database Error (entity catalog document without _id)"));
+      continue;
     }
-  }
-
-  return typeArray;
-}
 
+    char* typeName = orionldContextItemAliasLookup(orionldState.contextP, _idP->value.s, NULL, NULL);
 
-
-// -----------------------------------------------------------------------------
-//
-// typesAndAttributesExtractFromEntities -
-//
-static KjNode* typesAndAttributesExtractFromEntities(KjNode* array)
-{
-  KjNode* typeArray = kjArray(orionldState.kjsonP, NULL);
-
-  for (KjNode* entityP = array->value.firstChildP; entityP != NULL; entityP = entityP->next)
-  {
-    KjNode* nodeResponseP = kjObject(orionldState.kjsonP, NULL);
-    KjNode* _idP          = kjLookup(entityP, "_id");
-    KjNode* typeP         = kjLookup(_idP, "type");
-    KjNode* attributesP   = kjLookup(entityP, "attrNames");
-
-    if (typeP != NULL)
+    if (details == false)
     {
-      char*   typeName       = orionldContextItemAliasLookup(orionldState.contextP, typeP->value.s, NULL, NULL);
-      KjNode* typeIdNodeP    = kjString(orionldState.kjsonP, "id", typeP->value.s);
-      KjNode* typeNameNodeP  = kjString(orionldState.kjsonP, "typeName", typeName);
+      KjNode* typeNameNodeP = kjString(orionldState.kjsonP, NULL, typeName);
 
-      kjChildAdd(nodeResponseP, typeIdNodeP);
-      kjChildAdd(nodeResponseP, typeNameNodeP);
+      kjChildAdd(typeArray, typeNameNodeP);
+      continue;
     }
 
-    if (attributesP != NULL)
-    {
-      KjNode* attributeNamesNodeListP = kjArray(orionldState.kjsonP,  "attributeNames");
-      KjNode* nodeP                   = attributesP->value.firstChildP;
-      KjNode* next;
+    KjNode* nodeResponseP           = kjObject(orionldState.kjsonP, NULL);
+    KjNode* typeIdNodeP             = kjString(orionldState.kjsonP, "id", _idP->value.s);
+    KjNode* typeNameNodeP           = kjString(orionldState.kjsonP, "typeName", typeName);
+    KjNode* attributeNamesNodeListP = kjArray(orionldState.kjsonP,  "attributeNames");
+    KjNode* attrsP                  = kjLookup(catalogTypeP, "attrs");
 
-      while (nodeP != NULL)
+    if (attrsP != NULL)
+    {
+      for (KjNode* attrP = attrsP->value.firstChildP; attrP != NULL; attrP = attrP->next)
       {
-        next = nodeP->next;
-
-        KjNode* cloneP = kjClone(orionldState.kjsonP, nodeP);
+        char*   attrName      = orionldContextItemAliasLookup(orionldState.contextP, attrP->name, NULL, NULL);
+        KjNode* attrNameNodeP = kjString(orionldState.kjsonP, NULL, attrName);
 
-        cloneP->value.s = orionldContextItemAliasLookup(orionldState.contextP, cloneP->value.s, NULL, NULL);
-        kjStringArraySortedInsert(attributeNamesNodeListP, cloneP);
-        nodeP = next;
+        kjStringArraySortedInsert(attributeNamesNodeListP, attrNameNodeP);
       }
-
-      kjChildAdd(nodeResponseP, attributeNamesNodeListP);
     }
 
-    kjChildAdd(typeArray, nodeResponseP);  // OK to break tree
+    kjChildAdd(nodeResponseP, typeIdNodeP);
+    kjChildAdd(nodeResponseP, typeNameNodeP);
+    kjChildAdd(nodeResponseP, attributeNamesNodeListP);
+
+    kjChildAdd(typeArray, nodeResponseP);
   }
 
   return typeArray;
@@ -314,29 +306,12 @@ KjNode* dbEntityTypesGet(OrionldProblemDetails* pdP, bool details)
 {
   KjNode*  local;
   KjNode*  remote;
-  char*    fields[2];
   KjNode*  arrayP = NULL;
 
-  fields[0] = (char*) "_id";
-
   //
-  // GET local types - i.e. from the "entities" collection
+  // GET local types - i.e. from the entity catalog
   //
-  if (details == false)
-    local  = dbEntitiesGet(fields, 1);
-  else
-  {
-    fields[1] = (char*) "attrNames";
-    local  = dbEntitiesGet(fields, 2);
-  }
-
-  if (local != NULL)
-  {
-    if (details == false)
-      local = typesExtract(local);
-    else
-      local = typesAndAttributesExtractFromEntities(local);
-  }
+  local = localTypesGet(details);
 
   //
   // GET remote types - i.e. from the "registrations" collection
@@ -347,63 +322,6 @@ KjNode* dbEntityTypesGet(OrionldProblemDetails* pdP, bool details)
     remote = typesAndAttributesExtractFromRegistrations(remote);
 
 
-  //
-  // Fix duplicates in 'local'
-  //
-  if (local != NULL)
-  {
-    //
-    // If 'details' is not on - just remove the duplicates
-    //
-    KjNode* typeP = local->value.firstChildP;
-    KjNode* next;
-
-    while (typeP)
-    {
-      next = typeP->next;
-
-      //
-      // Search for the same name AFTER 'typeP' in the string array - if found, remove 'typeP' from the array + merge if details are on
-      //
-      if (details == false)
-      {
-        char* typeName = typeP->value.s;
-        for (KjNode* nodeP = typeP->next; nodeP != NULL; nodeP = nodeP->next)
-        {
-          if (strcmp(nodeP->value.s, typeName) == 0)
-          {
-            kjChildRemove(local, typeP);
-            break;
-          }
-        }
-      }
-      else
-      {
-        KjNode* idP = kjLookup(typeP, "id");
-
-        if (idP == NULL)
-          LM_RE(NULL, ("Internal Error (no 'id' in type object)"));
-
-        for (KjNode* nodeP = typeP->next; nodeP != NULL; nodeP = nodeP->next)
-        {
-          KjNode* nodeIdP = kjLookup(nodeP, "id");
-
-          if (nodeIdP == NULL)
-            LM_RE(NULL, ("Internal Error (no 'id' in type object)"));
-
-          if (strcmp(idP->value.s, nodeIdP->value.s) == 0)
-          {
-            detailTypeMerge(typeP, nodeP);
-            kjChildRemove(local, typeP);
-          }
-        }
-      }
-
-      typeP = next;
-    }
-  }
-
-
   //
   // Fix duplicates in 'remote'
   //
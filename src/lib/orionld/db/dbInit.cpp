@@ -34,7 +34,6 @@
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntitiesAttributeLookup.h"  // mongoCppLegacyEntitiesAttributeLookup
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityAttributeWithDatasetsLookup.h"  // mongoCppLegacyEntityAttributeWithDatasetsLookup
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityAttributesDelete.h"   // mongoCppLegacyEntityAttributesDelete
-#include "orionld/mongoCppLegacy/mongoCppLegacyEntityTypeGet.h"            // mongoCppLegacyEntityTypeGet
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityFieldReplace.h"       // mongoCppLegacyEntityFieldReplace
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityFieldDelete.h"        // mongoCppLegacyEntityFieldDelete
 #include "orionld/mongoCppLegacy/mongoCppLegacyDataToKjTree.h"             // mongoCppLegacyDataToKjTree
@@ -56,7 +55,6 @@
 #include "orionld/mongoCppLegacy/mongoCppLegacyGeoIndexCreate.h"           // mongoCppLegacyGeoIndexCreate
 #include "orionld/mongoCppLegacy/mongoCppLegacyIdIndexCreate.h"            // mongoCppLegacyIdIndexCreate
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityRetrieve.h"           // mongoCppLegacyEntityRetrieve
-#include "orionld/mongoCppLegacy/mongoCppLegacyEntitiesQuery.h"            // mongoCppLegacyEntitiesQuery
 #include "orionld/mongoCppLegacy/mongoCppLegacyDatasetGet.h"               // mongoCppLegacyDatasetGet
 #include "orionld/mongoCppLegacy/mongoCppLegacyTenantExists.h"             // mongoCppLegacyTenantExists
 
@@ -66,6 +64,10 @@
 #include "orionld/mongoc/mongocEntityLookup.h"                             // mongocEntityLookup
 #include "orionld/mongoc/mongocKjTreeFromBson.h"                           // mongocKjTreeFromBson
 #endif
+
+#include "orionld/mongoc/mongocEntitiesQuery.h"                            // mongocEntitiesQuery
+#include "orionld/mongoc/mongocCatalogInit.h"                              // mongocCatalogInit
+#include "orionld/common/tenantList.h"                                     // tenant0
 #include "orionld/db/dbInit.h"                                             // Own interface
 
 
@@ -88,7 +90,6 @@ void dbInit(const char* dbHost, const char* dbName)
   dbEntityAttributeWithDatasetsLookup      = mongoCppLegacyEntityAttributeWithDatasetsLookup;
   dbEntitiesAttributeLookup                = mongoCppLegacyEntitiesAttributeLookup;
   dbEntityAttributesDelete                 = mongoCppLegacyEntityAttributesDelete;
-  dbEntityTypeGet                          = mongoCppLegacyEntityTypeGet;
   dbEntityUpdate                           = mongoCppLegacyEntityUpdate;
   dbEntityFieldReplace                     = mongoCppLegacyEntityFieldReplace;
   dbEntityFieldDelete                      = mongoCppLegacyEntityFieldDelete;
@@ -110,7 +111,7 @@ void dbInit(const char* dbHost, const char* dbName)
   dbEntityTypesFromRegistrationsGet        = mongoCppLegacyEntityTypesFromRegistrationsGet;
   dbGeoIndexCreate                         = mongoCppLegacyGeoIndexCreate;
   dbIdIndexCreate                          = mongoCppLegacyIdIndexCreate;
-  dbEntitiesQuery                          = mongoCppLegacyEntitiesQuery;
+  dbEntitiesQuery                          = mongocEntitiesQuery;  // mongoc also for the legacy driver - no NGSIv2 objects
   dbDatasetGet                             = mongoCppLegacyDatasetGet;
   dbTenantExists                           = mongoCppLegacyTenantExists;
 
@@ -137,12 +138,18 @@ void dbInit(const char* dbHost, const char* dbName)
   dbEntityTypesFromRegistrationsGet        = NULL;  // FIXME: Implement mongocEntityTypesFromRegistrationsGet
   dbGeoIndexCreate                         = NULL;  // FIXME: Implement mongocGeoIndexCreate
   dbIdIndexCreate                          = NULL;  // FIXME: Implement mongocIdIndexCreate
-  dbEntitiesQuery                          = NULL;  // FIXME: Implement mongocEntitiesQuery
+  dbEntitiesQuery                          = mongocEntitiesQuery;
   dbEntityFieldReplace                     = NULL;  // FIXME: Implement mongocEntityFieldReplace
 
-  mongocInit(dbHost, dbName);
+  mongocInit(dbHost);
 
 #else
   #error Please define either DB_DRIVER_MONGO_CPP_LEGACY or DB_DRIVER_MONGOC in src/lib/orionld/db/dbConfiguration.h
 #endif
+
+  //
+  // The entity catalog of the default tenant - the rest of the tenants get theirs in orionldTenantCreate
+  //
+  if (mongocCatalogInit(&tenant0) == false)
+    LM_E(("Database Error (unable to initialize the entity catalog of the default tenant)"));
 }
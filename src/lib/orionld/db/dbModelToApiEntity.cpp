@@ -0,0 +1,359 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjObject, kjChildAdd
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/numberToDate.h"                         // numberToDate
+#include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/context/orionldContextItemAliasLookup.h"       // orionldContextItemAliasLookup
+#include "orionld/db/dbModelToApiEntity.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timestampToString - DB timestamps are floating point seconds since the epoch, the API uses ISO8601 strings
+//
+static void timestampToString(KjNode* nodeP)
+{
+  double timestamp;
+
+  if (nodeP->type == KjFloat)
+    timestamp = nodeP->value.f;
+  else if (nodeP->type == KjInt)
+    timestamp = nodeP->value.i;
+  else
+    return;
+
+  char* dateBuf = kaAlloc(&orionldState.kalloc, 64);
+
+  if (numberToDate(timestamp, dateBuf, 64) == false)
+  {
+    LM_E(("Database Error (numberToDate failed)"));
+    return;
+  }
+
+  nodeP->type    = KjString;
+  nodeP->value.s = dateBuf;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aliasFromDbName - the name of an attribute/sub-attribute in the DB is the long name with dots replaced by '='
+//
+static char* aliasFromDbName(const char* dbName, bool* valueMayBeCompactedP)
+{
+  char* longName = kaStrdup(&orionldState.kalloc, dbName);
+
+  eqForDot(longName);
+  return orionldContextItemAliasLookup(orionldState.contextP, longName, valueMayBeCompactedP, NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// valueCompact - compact the value of an attribute whose @context says "@type": "@vocab"
+//
+static void valueCompact(KjNode* valueP)
+{
+  if (valueP->type == KjString)
+    valueP->value.s = orionldContextItemAliasLookup(orionldState.contextP, valueP->value.s, NULL, NULL);
+  else if (valueP->type == KjArray)
+  {
+    for (KjNode* itemP = valueP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+    {
+      if (itemP->type == KjString)
+        itemP->value.s = orionldContextItemAliasLookup(orionldState.contextP, itemP->value.s, NULL, NULL);
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// dbModelToApiSubAttribute -
+//
+// - observedAt and unitCode are stored as { "value": X } but presented as X (observedAt as ISO8601 string)
+// - The "object" of a Relationship is stored as "value"
+//
+static KjNode* dbModelToApiSubAttribute(KjNode* dbMdP, bool sysAttrs)
+{
+  dbMdP->name = aliasFromDbName(dbMdP->name, NULL);
+
+  if ((strcmp(dbMdP->name, "observedAt") == 0) || (strcmp(dbMdP->name, "unitCode") == 0))
+  {
+    if ((dbMdP->type == KjObject) && (dbMdP->value.firstChildP != NULL))
+    {
+      KjNode* valueP = dbMdP->value.firstChildP;
+
+      dbMdP->type      = valueP->type;
+      dbMdP->value     = valueP->value;
+      dbMdP->lastChild = valueP->lastChild;
+    }
+
+    if (dbMdP->name[0] == 'o')
+      timestampToString(dbMdP);
+
+    return dbMdP;
+  }
+
+  if (dbMdP->type != KjObject)
+    return dbMdP;
+
+  KjNode* mdP     = kjObject(orionldState.kjsonP, dbMdP->name);
+  KjNode* typeP   = NULL;
+  KjNode* valueP  = NULL;
+  KjNode* nodeP   = dbMdP->value.firstChildP;
+  KjNode* next;
+
+  while (nodeP != NULL)
+  {
+    next = nodeP->next;
+
+    if (strcmp(nodeP->name, "type") == 0)
+    {
+      typeP = nodeP;
+      kjChildAdd(mdP, nodeP);
+    }
+    else if (strcmp(nodeP->name, "value") == 0)
+    {
+      valueP = nodeP;
+      kjChildAdd(mdP, nodeP);
+    }
+    else if ((strcmp(nodeP->name, "createdAt") == 0) || (strcmp(nodeP->name, "modifiedAt") == 0))
+    {
+      if (sysAttrs == true)
+      {
+        timestampToString(nodeP);
+        kjChildAdd(mdP, nodeP);
+      }
+    }
+    else
+      kjChildAdd(mdP, nodeP);
+
+    nodeP = next;
+  }
+
+  if ((typeP != NULL) && (valueP != NULL) && (typeP->type == KjString) && (strcmp(typeP->value.s, "Relationship") == 0))
+    valueP->name = (char*) "object";
+
+  return mdP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// dbModelToApiAttribute -
+//
+// 1. The name is the long name with '=' for dots - compacted according to the @context of the request
+// 2. The "object" of a Relationship is stored as "value"
+// 3. creDate/modDate are presented as createdAt/modifiedAt (ISO8601) if sysAttrs - else removed
+// 4. mdNames is removed
+// 5. The sub-attributes, in "md", are moved one level up
+// 6. keyValues: the attribute is replaced by its value
+//
+static KjNode* dbModelToApiAttribute(KjNode* dbAttrP, bool sysAttrs, bool keyValues)
+{
+  bool     valueMayBeCompacted = false;
+  char*    alias               = aliasFromDbName(dbAttrP->name, &valueMayBeCompacted);
+  KjNode*  attrP               = kjObject(orionldState.kjsonP, alias);
+  KjNode*  typeP               = NULL;
+  KjNode*  valueP              = NULL;
+  KjNode*  mdsP                = NULL;
+  KjNode*  nodeP               = dbAttrP->value.firstChildP;
+  KjNode*  next;
+
+  while (nodeP != NULL)
+  {
+    next = nodeP->next;
+
+    if (strcmp(nodeP->name, "type") == 0)
+    {
+      typeP = nodeP;
+      kjChildAdd(attrP, nodeP);
+    }
+    else if (strcmp(nodeP->name, "value") == 0)
+    {
+      valueP = nodeP;
+      kjChildAdd(attrP, nodeP);
+    }
+    else if (strcmp(nodeP->name, "creDate") == 0)
+    {
+      if (sysAttrs == true)
+      {
+        nodeP->name = (char*) "createdAt";
+        timestampToString(nodeP);
+        kjChildAdd(attrP, nodeP);
+      }
+    }
+    else if (strcmp(nodeP->name, "modDate") == 0)
+    {
+      if (sysAttrs == true)
+      {
+        nodeP->name = (char*) "modifiedAt";
+        timestampToString(nodeP);
+        kjChildAdd(attrP, nodeP);
+      }
+    }
+    else if (strcmp(nodeP->name, "md") == 0)
+      mdsP = nodeP;
+    else if (strcmp(nodeP->name, "mdNames") != 0)
+      kjChildAdd(attrP, nodeP);
+
+    nodeP = next;
+  }
+
+  if (valueP == NULL)
+  {
+    LM_E(("Database Error (the attribute '%s' has no value)", alias));
+    return (keyValues == true)? NULL : attrP;
+  }
+
+  if (valueMayBeCompacted == true)
+    valueCompact(valueP);
+
+  if (keyValues == true)
+  {
+    valueP->name = alias;
+    return valueP;
+  }
+
+  if ((typeP != NULL) && (typeP->type == KjString) && (strcmp(typeP->value.s, "Relationship") == 0))
+    valueP->name = (char*) "object";
+
+  if (mdsP != NULL)
+  {
+    nodeP = mdsP->value.firstChildP;
+
+    while (nodeP != NULL)
+    {
+      next = nodeP->next;
+      kjChildAdd(attrP, dbModelToApiSubAttribute(nodeP, sysAttrs));
+      nodeP = next;
+    }
+  }
+
+  return attrP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// dbModelToApiEntity -
+//
+KjNode* dbModelToApiEntity(KjNode* dbEntityP, bool sysAttrs, bool keyValues)
+{
+  KjNode* _idP     = NULL;
+  KjNode* attrsP   = NULL;
+  KjNode* creDateP = NULL;
+  KjNode* modDateP = NULL;
+
+  for (KjNode* nodeP = dbEntityP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
+  {
+    if      (strcmp(nodeP->name, "_id")     == 0) _idP     = nodeP;
+    else if (strcmp(nodeP->name, "attrs")   == 0) attrsP   = nodeP;
+    else if (strcmp(nodeP->name, "creDate") == 0) creDateP = nodeP;
+    else if (strcmp(nodeP->name, "modDate") == 0) modDateP = nodeP;
+  }
+
+  if (_idP == NULL)
+  {
+    LM_E(("Database Error (the field '_id' is missing)"));
+    return NULL;
+  }
+
+  KjNode* idP   = NULL;
+  KjNode* typeP = NULL;
+
+  for (KjNode* nodeP = _idP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
+  {
+    if      (strcmp(nodeP->name, "id")   == 0) idP   = nodeP;
+    else if (strcmp(nodeP->name, "type") == 0) typeP = nodeP;
+  }
+
+  if ((idP == NULL) || (typeP == NULL))
+  {
+    LM_E(("Database Error (the field '_id.id' or '_id.type' is missing)"));
+    return NULL;
+  }
+
+  KjNode* entityP = kjObject(orionldState.kjsonP, NULL);
+
+  kjChildAdd(entityP, idP);
+  typeP->value.s = orionldContextItemAliasLookup(orionldState.contextP, typeP->value.s, NULL, NULL);
+  kjChildAdd(entityP, typeP);
+
+  if (sysAttrs == true)
+  {
+    if (creDateP != NULL)
+    {
+      creDateP->name = (char*) "createdAt";
+      timestampToString(creDateP);
+      kjChildAdd(entityP, creDateP);
+    }
+
+    if (modDateP != NULL)
+    {
+      modDateP->name = (char*) "modifiedAt";
+      timestampToString(modDateP);
+      kjChildAdd(entityP, modDateP);
+    }
+  }
+
+  if (attrsP != NULL)
+  {
+    KjNode* dbAttrP = attrsP->value.firstChildP;
+    KjNode* next;
+
+    while (dbAttrP != NULL)
+    {
+      KjNode* attrP;
+
+      next = dbAttrP->next;
+      if ((attrP = dbModelToApiAttribute(dbAttrP, sysAttrs, keyValues)) != NULL)
+        kjChildAdd(entityP, attrP);
+      dbAttrP = next;
+    }
+  }
+
+  return entityP;
+}
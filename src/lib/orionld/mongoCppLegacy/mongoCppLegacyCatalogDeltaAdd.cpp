@@ -0,0 +1,65 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "mongo/client/dbclient.h"                             // mongo legacy driver
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/catalogDeltaAdd.h"                    // catalogDeltaAdd
+#include "orionld/mongoCppLegacy/mongoCppLegacyCatalogDeltaAdd.h"  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongoCppLegacyCatalogDeltaAdd - add 'n' to the entity catalog counters of an entity, as stored in the database
+//
+// PARAMETERS
+//   dbEntity   - the entity, or a projection of it: { "_id": { "type": "T" }, "attrs": { "A1": { "type": "Property" }, ... } }
+//   entityToo  - false if only the attributes are counted (deletion of attributes)
+//   n          - 1 or -1
+//
+void mongoCppLegacyCatalogDeltaAdd(const mongo::BSONObj& dbEntity, bool entityToo, int n)
+{
+  mongo::BSONObj  idObj      = dbEntity.getObjectField("_id");
+  const char*     entityType = idObj.getStringField("type");
+
+  if (entityToo == true)
+    catalogDeltaAdd(&orionldState.catalogDeltaP, entityType, NULL, NULL, n);
+
+  mongo::BSONObj          attrsObj = dbEntity.getObjectField("attrs");
+  mongo::BSONObjIterator  attrIter(attrsObj);
+
+  while (attrIter.more())
+  {
+    mongo::BSONElement attr = attrIter.next();
+
+    if (attr.type() != mongo::Object)
+      continue;
+
+    catalogDeltaAdd(&orionldState.catalogDeltaP, entityType, attr.fieldName(), attr.embeddedObject().getStringField("type"), n);
+  }
+}
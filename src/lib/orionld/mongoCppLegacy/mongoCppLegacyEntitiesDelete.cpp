@@ -33,14 +33,58 @@ extern "C"
 #include "logMsg/logMsg.h"                                            // LM_*
 #include "logMsg/traceLevels.h"                                       // Lmt*
 
-#include "orionld/common/orionldState.h"                              // orionldState, dbName, mongoEntitiesCollectionP
+#include "orionld/common/orionldState.h"                              // orionldState, dbName
 
 #include "mongoBackend/MongoGlobal.h"                                 // getMongoConnection, releaseMongoConnection, ...
+#include "mongoBackend/connectionOperations.h"                        // runCollectionCommand
+#include "mongoBackend/dbConstants.h"                                 // COL_ENTITIES
 #include "orionld/db/dbConfiguration.h"                               // dbDataToKjTree, dbDataFromKjTree
+#include "orionld/mongoCppLegacy/mongoCppLegacyCatalogDeltaAdd.h"     // mongoCppLegacyCatalogDeltaAdd
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntitiesDelete.h"      // Own interface
 
 
 
+// -----------------------------------------------------------------------------
+//
+// catalogDeltaOfEntities - subtract the entities that are about to be deleted from the entity catalog
+//
+// Only the entity types and the attribute types are needed, so, instead of reading the entire entities,
+// an aggregation gives back a projection of them, with the same layout as the entity in the database:
+//   { "_id": { "type": "T" }, "attrs": { "A1": { "type": "Property" }, ... } }
+//
+static void catalogDeltaOfEntities(mongo::BSONArray& idArray, int entities)
+{
+  mongo::BSONObj  attrTypes = BSON("$arrayToObject" << BSON("$map" << BSON("input" << BSON("$objectToArray" << "$attrs") <<
+                                                                           "in"    << BSON("k" << "$$this.k" << "v" << BSON("type" << "$$this.v.type")))));
+  mongo::BSONArray  pipeline = BSON_ARRAY(BSON("$match"   << BSON("_id.id" << BSON("$in" << idArray))) <<
+                                          BSON("$project" << BSON("_id.type" << 1 << "attrs" << attrTypes)));
+  mongo::BSONObj    command  = BSON("aggregate" << COL_ENTITIES <<
+                                    "cursor"    << BSON("batchSize" << entities) <<
+                                    "pipeline"  << pipeline);
+  mongo::BSONObj    result;
+  std::string       err;
+
+  if (runCollectionCommand(orionldState.tenantP->mongoDbName, command, &result, &err) == false)
+  {
+    LM_E(("Database Error (entity types and attributes of entities to be deleted: %s)", err.c_str()));
+    return;
+  }
+
+  mongo::BSONObj          cursorObj  = result.getObjectField("cursor");
+  mongo::BSONObj          firstBatch = cursorObj.getObjectField("firstBatch");
+  mongo::BSONObjIterator  iter(firstBatch);
+
+  while (iter.more())
+  {
+    mongo::BSONElement entity = iter.next();
+
+    if (entity.type() == mongo::Object)
+      mongoCppLegacyCatalogDeltaAdd(entity.embeddedObject(), true, -1);
+  }
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // mongoCppLegacyEntitiesDelete -
@@ -51,6 +95,8 @@ bool mongoCppLegacyEntitiesDelete(KjNode* entityIdsArray)
   mongo::BulkOperationBuilder  bulk         = connectionP->initializeUnorderedBulkOp(orionldState.tenantP->entities);
   const mongo::WriteConcern    writeConcern;
   mongo::WriteResult           writeResults;
+  mongo::BSONArrayBuilder      idArray;
+  int                          entities     = 0;
 
   for (KjNode* idNodeP = entityIdsArray->value.firstChildP; idNodeP != NULL; idNodeP = idNodeP->next)
   {
@@ -58,8 +104,20 @@ bool mongoCppLegacyEntitiesDelete(KjNode* entityIdsArray)
 
     filterObj.append("_id.id", idNodeP->value.s);
     bulk.find(filterObj.obj()).remove();
+
+    idArray.append(idNodeP->value.s);
+    ++entities;
   }
 
+  if (entities == 0)
+  {
+    releaseMongoConnection(connectionP);
+    return true;
+  }
+
+  mongo::BSONArray ids = idArray.arr();
+  catalogDeltaOfEntities(ids, entities);
+
   bulk.execute(&writeConcern, &writeResults);
   releaseMongoConnection(connectionP);
 
@@ -34,8 +34,10 @@ extern "C"
 
 #include "orionld/common/orionldState.h"                         // orionldState
 
-#include "mongoBackend/MongoGlobal.h"                            // getMongoConnection, releaseMongoConnection, ...
+#include "mongoBackend/connectionOperations.h"                   // runCollectionCommand
+#include "mongoBackend/dbConstants.h"                            // COL_ENTITIES
 #include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/mongoCppLegacy/mongoCppLegacyCatalogDeltaAdd.h"  // mongoCppLegacyCatalogDeltaAdd
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityAttributesDelete.h"  // Own interface
 
 
@@ -44,24 +46,31 @@ extern "C"
 //
 // mongoCppLegacyEntityAttributesDelete -
 //
+// The update is done with findAndModify, asking for the types of the entity and of the removed attributes,
+// as they were before the update, so that they can be subtracted from the entity catalog.
+//
 // Mongo Shell Example:
-//   db.entities.update({"_id.id": "urn:ngsi-ld:entities:E1"},
-//                      {"$unset": { "attrs.https://uri=etsi=org/ngsi-ld/default-context/P1": 1, "attrs.https://uri=etsi=org/ngsi-ld/default-context/P2": 1 }})
-//                      {"$pull":  { "attrNames": { "$in": [ "attrs.https://uri=etsi=org/ngsi-ld/default-context/P1", "attrs.https://uri=etsi=org/ngsi-ld/default-context/P2" ] }}}
+//   db.runCommand({ findAndModify: "entities",
+//                   query:  { "_id.id": "urn:ngsi-ld:entities:E1" },
+//                   update: { "$unset": { "attrs.https://uri=etsi=org/ngsi-ld/default-context/P1": 1, "attrs.https://uri=etsi=org/ngsi-ld/default-context/P2": 1 },
+//                             "$pull":  { "attrNames": { "$in": [ "https://uri.etsi.org/ngsi-ld/default-context/P1", "https://uri.etsi.org/ngsi-ld/default-context/P2" ] }}},
+//                   fields: { "_id.type": 1, "attrs.https://uri=etsi=org/ngsi-ld/default-context/P1.type": 1, "attrs.https://uri=etsi=org/ngsi-ld/default-context/P2.type": 1 }})
 //
 bool mongoCppLegacyEntityAttributesDelete(const char* entityId, char** attrNameV, int vecSize)
 {
   mongo::BSONObjBuilder    filter;
-  mongo::BSONObjBuilder    command;
+  mongo::BSONObjBuilder    update;
   mongo::BSONObjBuilder    unset;
   mongo::BSONObjBuilder    pull;
   mongo::BSONObjBuilder    pullIn;
   mongo::BSONArrayBuilder  pullInVec;
+  mongo::BSONObjBuilder    fields;
 
   //
   // Entity ID
   //
   filter.append("_id.id", entityId);
+  fields.append("_id.type", 1);
 
   //
   // Attributes to remove from 'attrs', using $unset
@@ -70,33 +79,44 @@ bool mongoCppLegacyEntityAttributesDelete(const char* entityId, char** attrNameV
   for (int ix = 0; ix < vecSize; ix++)
   {
     int   attrNameLen   = strlen(attrNameV[ix]);
-    int   mongoPathLen  = 6  + attrNameLen + 1;  // 6  == strlen("attrs."),     1 == zero-termination
+    int   mongoPathLen  = 6  + attrNameLen + 5 + 1;  // 6  == strlen("attrs."), 5 == strlen(".type"), 1 == zero-termination
     char* mongoPath     = (char*) kaAlloc(&orionldState.kalloc, mongoPathLen);
 
     snprintf(mongoPath, mongoPathLen, "attrs.%s", attrNameV[ix]);
     unset.append(mongoPath, 1);
 
+    strcpy(&mongoPath[6 + attrNameLen], ".type");
+    fields.append(mongoPath, 1);
+
     eqForDot(attrNameV[ix]);
     pullInVec.append(attrNameV[ix]);
   }
 
   pullIn.append("$in", pullInVec.arr());
   pull.append("attrNames", pullIn.obj());
-  command.append("$unset", unset.obj());
-  command.append("$pull",  pull.obj());
+  update.append("$unset", unset.obj());
+  update.append("$pull",  pull.obj());
 
   //
   // Updating database
   //
-  // semTake()
-  mongo::DBClientBase*    connectionP = getMongoConnection();
-  mongo::BSONObj          commandObj  = command.obj();
-  mongo::Query            query(filter.obj());
+  mongo::BSONObj  result;
+  std::string     err;
+  mongo::BSONObj  command = BSON("findAndModify" << COL_ENTITIES <<
+                                 "query"         << filter.obj() <<
+                                 "update"        << update.obj() <<
+                                 "fields"        << fields.obj());
+
+  if (runCollectionCommand(orionldState.tenantP->mongoDbName, command, &result, &err) == false)
+  {
+    LM_E(("Database Error (deleting attributes of entity '%s': %s)", entityId, err.c_str()));
+    return false;
+  }
 
-  connectionP->update(orionldState.tenantP->entities, query, commandObj, true, false);
+  mongo::BSONElement value = result.getField("value");
 
-  releaseMongoConnection(connectionP);
-  // semGive()
+  if (value.type() == mongo::Object)
+    mongoCppLegacyCatalogDeltaAdd(value.embeddedObject(), false, -1);
 
   return true;
 }
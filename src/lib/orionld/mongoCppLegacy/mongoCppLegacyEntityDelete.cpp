@@ -29,7 +29,9 @@
 
 #include "orionld/common/orionldState.h"                              // orionldState
 
-#include "mongoBackend/MongoGlobal.h"                                 // getMongoConnection, releaseMongoConnection, ...
+#include "mongoBackend/connectionOperations.h"                        // runCollectionCommand
+#include "mongoBackend/dbConstants.h"                                 // COL_ENTITIES
+#include "orionld/mongoCppLegacy/mongoCppLegacyCatalogDeltaAdd.h"     // mongoCppLegacyCatalogDeltaAdd
 #include "orionld/mongoCppLegacy/mongoCppLegacyEntityDelete.h"        // Own interface
 
 
@@ -38,24 +40,31 @@
 //
 // mongoCppLegacyEntityDelete -
 //
+// The entity is removed with findAndModify, that gives back the removed entity - its type and attributes are
+// subtracted from the entity catalog.
+//
+// Mongo Shell Example:
+//   db.runCommand({ findAndModify: "entities", query: { "_id.id": "urn:ngsi-ld:entities:E1" }, remove: true, fields: { "_id": 1, "attrs": 1 } })
+//
 bool mongoCppLegacyEntityDelete(const char* entityId)
 {
-  bool operationStatus;
-
-  //
-  // Populate filter
-  //
-  mongo::BSONObjBuilder  filter;
-  filter.append("_id.id", entityId);
+  mongo::BSONObj  result;
+  std::string     err;
+  mongo::BSONObj  command = BSON("findAndModify" << COL_ENTITIES <<
+                                 "query"         << BSON("_id.id" << entityId) <<
+                                 "remove"        << true <<
+                                 "fields"        << BSON("_id" << 1 << "attrs" << 1));
 
-  mongo::DBClientBase*                  connectionP = getMongoConnection();
-  std::auto_ptr<mongo::DBClientCursor>  cursorP;
-  mongo::Query                          query(filter.obj());
+  if (runCollectionCommand(orionldState.tenantP->mongoDbName, command, &result, &err) == false)
+  {
+    LM_E(("Database Error (deleting entity '%s': %s)", entityId, err.c_str()));
+    return false;
+  }
 
-  connectionP->remove(orionldState.tenantP->entities, query, true);
-  operationStatus = (connectionP->isFailed() == true)? false : true;
+  mongo::BSONElement value = result.getField("value");
 
-  releaseMongoConnection(connectionP);
+  if (value.type() == mongo::Object)
+    mongoCppLegacyCatalogDeltaAdd(value.embeddedObject(), true, -1);
 
-  return operationStatus;
+  return true;
 }
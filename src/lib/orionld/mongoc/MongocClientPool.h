@@ -0,0 +1,101 @@
+#ifndef SRC_LIB_ORIONLD_MONGOC_MONGOCCLIENTPOOL_H_
+#define SRC_LIB_ORIONLD_MONGOC_MONGOCCLIENTPOOL_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                             // pthread_mutex_t
+#include <mongoc/mongoc.h>                                       // mongoc_client_pool_t, mongoc_client_t, mongoc_collection_t
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MongocCollection - a collection handle of a pooled client
+//
+typedef struct MongocCollection
+{
+  char*                     dbName;       // Name of the database (one database per tenant)
+  char*                     name;         // Name of the collection
+  mongoc_collection_t*      collectionP;  // Handle of the collection - only to be used by the thread that popped the client
+  struct MongocCollection*  next;
+} MongocCollection;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MongocClient - a client of the pool, with the collection handles it has used so far
+//
+// mongoc_client_pool_push doesn't destroy the clients (as long as the min size of the pool isn't set), so, a client
+// and its collection handles live as long as the pool.
+//
+typedef struct MongocClient
+{
+  mongoc_client_t*   clientP;
+  MongocCollection*  collections;
+} MongocClient;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MongocClientPoolMetrics -
+//
+// All counters are updated with atomic operations, by any thread, without any lock.
+// Times are in microseconds.
+//
+typedef struct MongocClientPoolMetrics
+{
+  long long  pops;          // Number of clients handed out
+  long long  waits;         // Number of times a thread had to wait for a client to be pushed back to the pool
+  long long  waitTime;      // Accumulated time spent waiting
+  long long  maxWaitTime;   // Longest wait
+  long long  inUse;         // Number of clients currently handed out
+  long long  maxInUse;      // Max number of clients handed out at the same time
+} MongocClientPoolMetrics;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MongocClientPool - the pool of mongoc clients, shared by all threads
+//
+// A mongoc_client_t is not thread-safe, a thread pops a client from the pool (mongocClientPop), uses it and its
+// collection handles (mongocCollectionGet) and pushes it back to the pool (mongocClientPush) when done.
+//
+// The pool creates its clients on demand, up to 'size' clients. clientV has one item per client created so far,
+// to find the collection handles of a popped client. Items are only added (under 'mutex') - never removed or modified.
+//
+typedef struct MongocClientPool
+{
+  mongoc_client_pool_t*     poolP;
+  int                       size;         // Max number of clients in the pool
+  MongocClient*             clientV;      // Allocated array of 'size' clients
+  int                       clients;      // Number of clients in clientV
+  pthread_mutex_t           mutex;        // Protects the addition of new clients to clientV
+  MongocClientPoolMetrics   metrics;
+} MongocClientPool;
+
+#endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCCLIENTPOOL_H_
@@ -0,0 +1,55 @@
+#ifndef SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOG_H_
+#define SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOG_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+// -----------------------------------------------------------------------------
+//
+// The entity catalog - one collection per tenant, with the entity types, their attribute names and the counters of both
+//
+// One document per entity type:
+//   {
+//     "_id":      "<entity type>",
+//     "entities": <number of entities of the type>,
+//     "attrs": {
+//       "<attr name, '.' replaced by '='>": {
+//         "<attr type, '.' replaced by '='>": <number of attributes of the name and attribute type, in entities of the type>
+//       }
+//     }
+//   }
+//
+// plus one document, CATALOG_MARKER, that says the catalog has been built from the "entities" collection.
+// A tenant whose catalog lacks the marker gets its catalog rebuilt from scratch at startup (mongocCatalogInit).
+//
+// The counters are updated with $inc, once per request (mongocCatalogUpdate), and a counter that reaches zero is left in the
+// document - readers (mongocCatalogGet) skip zero counters.
+//
+#define CATALOG_COLLECTION  "catalog"
+#define CATALOG_MARKER      "@catalog"
+
+#endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOG_H_
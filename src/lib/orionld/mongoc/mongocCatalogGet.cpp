@@ -0,0 +1,162 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <unistd.h>                                              // NULL
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjArray, kjChildAdd, kjChildRemove
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/performance.h"                          // PERFORMANCE
+#include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
+#include "orionld/mongoc/mongocCatalog.h"                        // CATALOG_COLLECTION, CATALOG_MARKER
+#include "orionld/mongoc/mongocCatalogGet.h"                     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// catalogTypeClean - remove the zero counters of a catalog document and put back the dots in the names
+//
+// Returns false if there are no entities of the type.
+//
+static bool catalogTypeClean(KjNode* typeP)
+{
+  KjNode* entitiesP = kjLookup(typeP, "entities");
+  KjNode* attrsP    = kjLookup(typeP, "attrs");
+
+  if ((entitiesP == NULL) || (entitiesP->type != KjInt) || (entitiesP->value.i <= 0))
+    return false;
+
+  if (attrsP == NULL)
+    return true;
+
+  KjNode* attrP = attrsP->value.firstChildP;
+  while (attrP != NULL)
+  {
+    KjNode* nextAttrP = attrP->next;
+    KjNode* attrTypeP = attrP->value.firstChildP;
+
+    while (attrTypeP != NULL)
+    {
+      KjNode* nextAttrTypeP = attrTypeP->next;
+
+      if ((attrTypeP->type != KjInt) || (attrTypeP->value.i <= 0))
+        kjChildRemove(attrP, attrTypeP);
+      else
+        eqForDot(attrTypeP->name);
+
+      attrTypeP = nextAttrTypeP;
+    }
+
+    if (attrP->value.firstChildP == NULL)
+      kjChildRemove(attrsP, attrP);
+    else
+      eqForDot(attrP->name);
+
+    attrP = nextAttrP;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocCatalogGet - the entity catalog of the tenant of the request - all entity types or only one of them
+//
+// Returns an array of catalog documents (see mongocCatalog.h), with the names of attributes and attribute types
+// as they were before being stored in the database ('=' replaced back to '.').
+// Entity types without entities, and attribute types without attributes, are not included.
+//
+KjNode* mongocCatalogGet(const char* entityType)
+{
+  bson_t                filter;
+  const bson_t*         bsonP;
+  bson_error_t          mongoError;
+  KjNode*               typeArray = kjArray(orionldState.kjsonP, NULL);
+  MongocClient*         clientP;
+  mongoc_collection_t*  collectionP;
+  mongoc_cursor_t*      cursorP;
+
+  bson_init(&filter);
+
+  if (entityType != NULL)
+    bson_append_utf8(&filter, "_id", 3, entityType, -1);
+  else
+  {
+    bson_t ne;
+
+    bson_append_document_begin(&filter, "_id", 3, &ne);
+    bson_append_utf8(&ne, "$ne", 3, CATALOG_MARKER, -1);
+    bson_append_document_end(&filter, &ne);
+  }
+
+  clientP     = mongocClientPop();
+  collectionP = mongocCollectionGet(clientP, orionldState.tenantP->mongoDbName, CATALOG_COLLECTION);
+
+  PERFORMANCE(dbStart);
+  cursorP = mongoc_collection_find_with_opts(collectionP, &filter, NULL, NULL);
+
+  while (mongoc_cursor_next(cursorP, &bsonP))
+  {
+    char*    title;
+    char*    detail;
+    KjNode*  typeP = mongocKjTreeFromBson(bsonP, &title, &detail);
+
+    if (typeP == NULL)
+    {
+      LM_E(("Database Error (parsing a document of the entity catalog: %s: %s)", title, detail));
+      continue;
+    }
+
+    if (catalogTypeClean(typeP) == true)
+      kjChildAdd(typeArray, typeP);
+  }
+
+  if (mongoc_cursor_error(cursorP, &mongoError))
+    LM_E(("Database Error (reading the entity catalog: %s)", mongoError.message));
+
+  PERFORMANCE(dbEnd);
+
+  mongoc_cursor_destroy(cursorP);
+  mongocClientPush(clientP);
+  bson_destroy(&filter);
+
+  return typeArray;
+}
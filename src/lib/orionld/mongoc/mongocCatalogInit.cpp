@@ -0,0 +1,205 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strlen
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/catalogDeltaAdd.h"                      // catalogDeltaAdd
+#include "orionld/types/OrionldTenant.h"                         // OrionldTenant
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
+#include "orionld/mongoc/mongocCatalog.h"                        // CATALOG_COLLECTION, CATALOG_MARKER
+#include "orionld/mongoc/mongocCatalogUpdate.h"                  // mongocCatalogUpdate
+#include "orionld/mongoc/mongocCatalogInit.h"                    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Aggregations on the "entities" collection, to count the entities per type and the attributes per type/name/attribute-type
+//
+static const char* entitiesPerType =
+  "{ \"pipeline\": ["
+  "  { \"$group\": { \"_id\": \"$_id.type\", \"entities\": { \"$sum\": 1 } } }"
+  "] }";
+
+static const char* attributesPerType =
+  "{ \"pipeline\": ["
+  "  { \"$project\": { \"_id\": 0, \"type\": \"$_id.type\", \"attrs\": { \"$objectToArray\": \"$attrs\" } } },"
+  "  { \"$unwind\": \"$attrs\" },"
+  "  { \"$group\": { \"_id\": { \"type\": \"$type\", \"attr\": \"$attrs.k\", \"attrType\": \"$attrs.v.type\" }, \"n\": { \"$sum\": 1 } } }"
+  "] }";
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aggregate - run one of the aggregations and add its counters to the delta
+//
+static bool aggregate(mongoc_collection_t* entitiesP, const char* pipelineJson, KjNode** deltaPP)
+{
+  bson_error_t      mongoError;
+  bson_t*           pipelineP = bson_new_from_json((const uint8_t*) pipelineJson, strlen(pipelineJson), &mongoError);
+  bson_t            opts;
+  const bson_t*     bsonP;
+  mongoc_cursor_t*  cursorP;
+  bool              ok = true;
+
+  if (pipelineP == NULL)
+    LM_RE(false, ("Internal Error (invalid aggregation pipeline: %s)", mongoError.message));
+
+  bson_init(&opts);
+  bson_append_bool(&opts, "allowDiskUse", 12, true);
+
+  cursorP = mongoc_collection_aggregate(entitiesP, MONGOC_QUERY_NONE, pipelineP, &opts, NULL);
+
+  while (mongoc_cursor_next(cursorP, &bsonP))
+  {
+    char*    title;
+    char*    detail;
+    KjNode*  resultP = mongocKjTreeFromBson(bsonP, &title, &detail);
+
+    if (resultP == NULL)
+    {
+      LM_E(("Database Error (parsing an aggregation result: %s: %s)", title, detail));
+      continue;
+    }
+
+    KjNode* idP = kjLookup(resultP, "_id");
+    KjNode* nP  = kjLookup(resultP, "entities");
+
+    if (nP != NULL)  // { "_id": "<entity type>", "entities": N }
+    {
+      if ((idP != NULL) && (idP->type == KjString) && (nP->type == KjInt))
+        catalogDeltaAdd(deltaPP, idP->value.s, NULL, NULL, nP->value.i);
+    }
+    else if ((idP != NULL) && (idP->type == KjObject) && ((nP = kjLookup(resultP, "n")) != NULL) && (nP->type == KjInt))
+    {
+      // { "_id": { "type": "<entity type>", "attr": "<attr name>", "attrType": "<attr type>" }, "n": N }
+      KjNode* typeP     = kjLookup(idP, "type");
+      KjNode* attrP     = kjLookup(idP, "attr");
+      KjNode* attrTypeP = kjLookup(idP, "attrType");
+
+      if ((typeP != NULL) && (typeP->type == KjString) && (attrP != NULL) && (attrTypeP != NULL) && (attrTypeP->type == KjString))
+        catalogDeltaAdd(deltaPP, typeP->value.s, attrP->value.s, attrTypeP->value.s, nP->value.i);
+    }
+  }
+
+  if (mongoc_cursor_error(cursorP, &mongoError))
+  {
+    LM_E(("Database Error (aggregating the entities: %s)", mongoError.message));
+    ok = false;
+  }
+
+  mongoc_cursor_destroy(cursorP);
+  bson_destroy(&opts);
+  bson_destroy(pipelineP);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocCatalogInit - make sure the entity catalog of a tenant exists - rebuild it from the entities if it doesn't
+//
+// The catalog is complete if it has the marker document. If not (database of an older broker, or a crash in the middle
+// of a rebuild), the catalog is thrown away and rebuilt from the "entities" collection, with two aggregations, and finally
+// the marker is inserted.
+//
+// Called at startup for every tenant, before the broker accepts requests, and when a new tenant is created (empty).
+//
+bool mongocCatalogInit(OrionldTenant* tenantP)
+{
+  MongocClient*         clientP     = mongocClientPop();
+  mongoc_collection_t*  catalogP    = mongocCollectionGet(clientP, tenantP->mongoDbName, CATALOG_COLLECTION);
+  mongoc_collection_t*  entitiesP   = mongocCollectionGet(clientP, tenantP->mongoDbName, "entities");
+  KjNode*               deltaP      = NULL;
+  bson_error_t          mongoError;
+  bson_t                filter;
+  int64_t               markers;
+
+  bson_init(&filter);
+  bson_append_utf8(&filter, "_id", 3, CATALOG_MARKER, -1);
+
+  markers = mongoc_collection_count_documents(catalogP, &filter, NULL, NULL, NULL, &mongoError);
+  if (markers != 0)
+  {
+    if (markers < 0)
+      LM_E(("Database Error (looking up the entity catalog of tenant '%s': %s)", tenantP->mongoDbName, mongoError.message));
+
+    bson_destroy(&filter);
+    mongocClientPush(clientP);
+    return markers > 0;
+  }
+
+  LM_K(("Rebuilding the entity catalog of the database '%s'", tenantP->mongoDbName));
+
+  bool ok = aggregate(entitiesP, entitiesPerType, &deltaP) && aggregate(entitiesP, attributesPerType, &deltaP);
+
+  if (ok == true)
+  {
+    bson_t all;
+
+    bson_init(&all);
+    ok = mongoc_collection_delete_many(catalogP, &all, NULL, NULL, &mongoError);
+    if (ok == false)
+      LM_E(("Database Error (emptying the entity catalog of tenant '%s': %s)", tenantP->mongoDbName, mongoError.message));
+    bson_destroy(&all);
+  }
+
+  mongocClientPush(clientP);  // mongocCatalogUpdate pops a client of its own
+
+  if ((ok == true) && (deltaP != NULL))
+    ok = mongocCatalogUpdate(tenantP, deltaP);
+
+  if (ok == true)
+  {
+    clientP  = mongocClientPop();
+    catalogP = mongocCollectionGet(clientP, tenantP->mongoDbName, CATALOG_COLLECTION);
+
+    ok = mongoc_collection_insert_one(catalogP, &filter, NULL, NULL, &mongoError);
+    if (ok == false)
+      LM_E(("Database Error (inserting the marker of the entity catalog of tenant '%s': %s)", tenantP->mongoDbName, mongoError.message));
+
+    mongocClientPush(clientP);
+  }
+
+  bson_destroy(&filter);
+
+  return ok;
+}
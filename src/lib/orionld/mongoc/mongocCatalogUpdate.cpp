@@ -0,0 +1,185 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // orionldState, writeConcern
+#include "orionld/common/performance.h"                          // PERFORMANCE
+#include "orionld/types/OrionldTenant.h"                         // OrionldTenant
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocCatalog.h"                        // CATALOG_COLLECTION
+#include "orionld/mongoc/mongocCatalogUpdate.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// incAppend - the $inc of the counters of one entity type of the delta
+//
+// Returns the number of counters in the $inc - the counters that are zero are left out.
+//
+static int incAppend(bson_t* updateP, KjNode* typeP)
+{
+  bson_t  inc;
+  char    path[1024];
+  int     counters = 0;
+
+  bson_append_document_begin(updateP, "$inc", 4, &inc);
+
+  for (KjNode* fieldP = typeP->value.firstChildP; fieldP != NULL; fieldP = fieldP->next)
+  {
+    if (strcmp(fieldP->name, "entities") == 0)
+    {
+      if (fieldP->value.i != 0)
+      {
+        bson_append_int64(&inc, "entities", 8, fieldP->value.i);
+        ++counters;
+      }
+
+      continue;
+    }
+
+    // "attrs"
+    for (KjNode* attrP = fieldP->value.firstChildP; attrP != NULL; attrP = attrP->next)
+    {
+      for (KjNode* attrTypeP = attrP->value.firstChildP; attrTypeP != NULL; attrTypeP = attrTypeP->next)
+      {
+        if (attrTypeP->value.i == 0)
+          continue;
+
+        snprintf(path, sizeof(path), "attrs.%s.%s", attrP->name, attrTypeP->name);
+        bson_append_int64(&inc, path, -1, attrTypeP->value.i);
+        ++counters;
+      }
+    }
+  }
+
+  bson_append_document_end(updateP, &inc);
+
+  return counters;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocCatalogUpdate - add the counters of an entity catalog delta to the catalog of a tenant
+//
+// One upsert per entity type of the delta, all of them in one single unordered bulk write:
+//   filter: { "_id": "<entity type>" }
+//   update: { "$inc": { "entities": <n>, "attrs.<attr>.<attr type>": <n>, ... } }
+//
+// The delta is the sum of all changes of the request (see catalogDeltaAdd), so the catalog costs one round trip
+// to the database per request, no matter how many entities the request created, modified or deleted.
+//
+bool mongocCatalogUpdate(OrionldTenant* tenantP, KjNode* deltaP)
+{
+  MongocClient*             clientP;
+  mongoc_collection_t*      collectionP;
+  mongoc_bulk_operation_t*  bulkOpP;
+  bson_t                    opts;
+  bson_t                    upsertOpts;
+  bson_t                    reply;
+  bson_error_t              mongoError;
+  int                       ops = 0;
+  bool                      ok  = true;
+
+  bson_init(&opts);
+  bson_append_bool(&opts, "ordered", 7, false);
+
+  if (writeConcern == 0)
+  {
+    mongoc_write_concern_t* wcP = mongoc_write_concern_new();
+
+    mongoc_write_concern_set_w(wcP, MONGOC_WRITE_CONCERN_W_UNACKNOWLEDGED);
+    mongoc_write_concern_append(wcP, &opts);
+    mongoc_write_concern_destroy(wcP);
+  }
+
+  bson_init(&upsertOpts);
+  bson_append_bool(&upsertOpts, "upsert", 6, true);
+
+  clientP     = mongocClientPop();
+  collectionP = mongocCollectionGet(clientP, tenantP->mongoDbName, CATALOG_COLLECTION);
+  bulkOpP     = mongoc_collection_create_bulk_operation_with_opts(collectionP, &opts);
+
+  for (KjNode* typeP = deltaP->value.firstChildP; typeP != NULL; typeP = typeP->next)
+  {
+    bson_t filter;
+    bson_t update;
+
+    bson_init(&filter);
+    bson_init(&update);
+
+    bson_append_utf8(&filter, "_id", 3, typeP->name, -1);
+
+    if (incAppend(&update, typeP) > 0)
+    {
+      if (mongoc_bulk_operation_update_one_with_opts(bulkOpP, &filter, &update, &upsertOpts, &mongoError) == true)
+        ++ops;
+      else
+      {
+        LM_E(("Database Error (updating the entity catalog for type '%s': %s)", typeP->name, mongoError.message));
+        ok = false;
+      }
+    }
+
+    bson_destroy(&filter);
+    bson_destroy(&update);
+  }
+
+  if (ops > 0)
+  {
+    PERFORMANCE(dbStart);
+
+    if (mongoc_bulk_operation_execute(bulkOpP, &reply, &mongoError) == 0)
+    {
+      LM_E(("Database Error (updating the entity catalog of tenant '%s': %s)", tenantP->tenant, mongoError.message));
+      ok = false;
+    }
+
+    PERFORMANCE(dbEnd);
+    bson_destroy(&reply);
+  }
+
+  mongoc_bulk_operation_destroy(bulkOpP);
+  mongocClientPush(clientP);
+
+  bson_destroy(&upsertOpts);
+  bson_destroy(&opts);
+
+  return ok;
+}
@@ -1,5 +1,5 @@
-#ifndef SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITYTYPEGET_H_
-#define SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITYTYPEGET_H_
+#ifndef SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOGUPDATE_H_
+#define SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOGUPDATE_H_
 
 /*
 *
@@ -25,20 +25,19 @@
 *
 * Author: Ken Zangelin
 */
-
 extern "C"
 {
 #include "kjson/KjNode.h"                                        // KjNode
 }
 
-#include "orionld/types/OrionldProblemDetails.h"                 // OrionldProblemDetails
+#include "orionld/types/OrionldTenant.h"                         // OrionldTenant
 
 
 
 // -----------------------------------------------------------------------------
 //
-// mongoCppLegacyEntityLookup -
+// mongocCatalogUpdate - add the counters of an entity catalog delta to the catalog of a tenant
 //
-extern KjNode* mongoCppLegacyEntityTypeGet(OrionldProblemDetails* pdP, const char* typeLongName, int* noOfEntitiesP);
+extern bool mongocCatalogUpdate(OrionldTenant* tenantP, KjNode* deltaP);
 
-#endif  // SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITYTYPEGET_H_
+#endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCCATALOGUPDATE_H_
@@ -0,0 +1,128 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <time.h>                                                // clock_gettime, struct timespec
+#include <pthread.h>                                             // pthread_mutex_lock, pthread_mutex_unlock
+#include <mongoc/mongoc.h>                                       // mongoc_client_pool_pop, mongoc_client_pool_try_pop
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // mongocClientPool
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClientPool, MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// metricMax - atomically raise *maxP to 'value', if 'value' is greater
+//
+static void metricMax(long long* maxP, long long value)
+{
+  long long current = __atomic_load_n(maxP, __ATOMIC_RELAXED);
+
+  while (value > current)
+  {
+    if (__atomic_compare_exchange_n(maxP, &current, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == true)
+      break;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// clientLookup - find the item of a client in mongocClientPool.clientV
+//
+static MongocClient* clientLookup(mongoc_client_t* clientP, int clients)
+{
+  for (int ix = 0; ix < clients; ix++)
+  {
+    if (mongocClientPool.clientV[ix].clientP == clientP)
+      return &mongocClientPool.clientV[ix];
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocClientPop -
+//
+// The common case, an idle client available in the pool, doesn't touch the clock.
+// The first time a client is popped, it is added to mongocClientPool.clientV.
+//
+MongocClient* mongocClientPop(void)
+{
+  mongoc_client_t* clientP = mongoc_client_pool_try_pop(mongocClientPool.poolP);
+
+  if (clientP == NULL)
+  {
+    struct timespec start;
+    struct timespec now;
+
+    __atomic_add_fetch(&mongocClientPool.metrics.waits, 1, __ATOMIC_RELAXED);
+    clock_gettime(CLOCK_REALTIME, &start);
+
+    clientP = mongoc_client_pool_pop(mongocClientPool.poolP);
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    long long waitTime = (now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+
+    __atomic_add_fetch(&mongocClientPool.metrics.waitTime, waitTime, __ATOMIC_RELAXED);
+    metricMax(&mongocClientPool.metrics.maxWaitTime, waitTime);
+  }
+
+  __atomic_add_fetch(&mongocClientPool.metrics.pops, 1, __ATOMIC_RELAXED);
+  metricMax(&mongocClientPool.metrics.maxInUse, __atomic_add_fetch(&mongocClientPool.metrics.inUse, 1, __ATOMIC_RELAXED));
+
+  MongocClient* mcP = clientLookup(clientP, __atomic_load_n(&mongocClientPool.clients, __ATOMIC_ACQUIRE));
+
+  if (mcP != NULL)
+    return mcP;
+
+  //
+  // First time for this client - add it to clientV
+  // The pool never creates more than mongocClientPool.size clients, so, there is always room in clientV
+  //
+  pthread_mutex_lock(&mongocClientPool.mutex);
+
+  int clients = mongocClientPool.clients;
+
+  mcP              = &mongocClientPool.clientV[clients];
+  mcP->clientP     = clientP;
+  mcP->collections = NULL;
+
+  __atomic_store_n(&mongocClientPool.clients, clients + 1, __ATOMIC_RELEASE);
+
+  pthread_mutex_unlock(&mongocClientPool.mutex);
+
+  LM_T(LmtMongo, ("New mongoc client in the pool (%d clients)", clients + 1));
+
+  return mcP;
+}
@@ -0,0 +1,61 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, strdup
+#include <stdlib.h>                                              // malloc
+#include <mongoc/mongoc.h>                                       // mongoc_client_get_collection
+
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient, MongocCollection
+#include "orionld/mongoc/mongocCollectionGet.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocCollectionGet -
+//
+// The collection handles are kept in the client, for the next time the client is popped, by any thread.
+// Only the thread that has popped the client touches its list of collections, so, no lock is needed.
+//
+mongoc_collection_t* mongocCollectionGet(MongocClient* clientP, const char* dbName, const char* collectionName)
+{
+  for (MongocCollection* mcP = clientP->collections; mcP != NULL; mcP = mcP->next)
+  {
+    if ((strcmp(mcP->name, collectionName) == 0) && (strcmp(mcP->dbName, dbName) == 0))
+      return mcP->collectionP;
+  }
+
+  mongoc_collection_t* collectionP = mongoc_client_get_collection(clientP->clientP, dbName, collectionName);
+
+  MongocCollection* mcP = (MongocCollection*) malloc(sizeof(MongocCollection));
+
+  mcP->dbName      = strdup(dbName);
+  mcP->name        = strdup(collectionName);
+  mcP->collectionP = collectionP;
+  mcP->next        = clientP->collections;
+
+  clientP->collections = mcP;
+
+  return collectionP;
+}
@@ -36,9 +36,13 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "orionld/common/orionldState.h"                         // mongoContextsSem
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
 #include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
-#include "orionld/contextCache/orionldContextCache.h"            // Own interface
+#include "orionld/contextCache/orionldContextCache.h"            // Own interface, ORIONLD_CONTEXT_CACHE_DB
 
 
 
@@ -54,9 +58,10 @@ KjNode* mongocContextCacheGet(void)
   bson_t*           query        = bson_new();       // Empty - to find all the contexts in the DB
   KjNode*           contextArray = kjArray(orionldState.kjsonP, NULL);
 
-  sem_wait(&mongoContextsSem);
+  MongocClient*         clientP     = mongocClientPop();
+  mongoc_collection_t*  collectionP = mongocCollectionGet(clientP, ORIONLD_CONTEXT_CACHE_DB, "contexts");
 
-  cursor = mongoc_collection_find_with_opts(mongoContextsCollectionP, query, NULL, NULL);
+  cursor = mongoc_collection_find_with_opts(collectionP, query, NULL, NULL);
 
   int matches = 0;
   while (mongoc_cursor_next(cursor, &bsonContextP))
@@ -74,10 +79,10 @@ KjNode* mongocContextCacheGet(void)
     kjChildAdd(contextArray, contextNodeP);
     ++matches;
   }
-  sem_post(&mongoContextsSem);
 
   bson_destroy(query);
   mongoc_cursor_destroy(cursor);
+  mongocClientPush(clientP);
 
 
   return contextArray;
@@ -32,7 +32,11 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "orionld/common/orionldState.h"                         // mongoContextsSem, mongoContextsCollectionP
+#include "orionld/contextCache/orionldContextCache.h"            // ORIONLD_CONTEXT_CACHE_DB
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
 #include "orionld/mongoc/mongocKjTreeToBson.h"                   // mongocKjTreeToBson
 #include "orionld/mongoc/mongocContextCachePersist.h"            // Own interface
 
@@ -48,12 +52,12 @@ void mongocContextCachePersist(KjNode* contextObject)
 
   mongocKjTreeToBson(contextObject, &bson);
 
-  sem_wait(&mongoContextsSem);
+  MongocClient*         clientP     = mongocClientPop();
+  mongoc_collection_t*  collectionP = mongocCollectionGet(clientP, ORIONLD_CONTEXT_CACHE_DB, "contexts");
+  bson_error_t          mcError;
+  bool                  r           = mongoc_collection_insert_one(collectionP, &bson, NULL, NULL, &mcError);
 
-  bson_error_t  mcError;
-  bool          r = mongoc_collection_insert_one(mongoContextsCollectionP, &bson, NULL, NULL, &mcError);
-
-  sem_post(&mongoContextsSem);
+  mongocClientPush(clientP);
 
   if (r == false)
     LM_E(("Database Error (persisting context: %s)", mcError.message));
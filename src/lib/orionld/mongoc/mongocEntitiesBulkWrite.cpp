@@ -0,0 +1,200 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // orionldState, writeConcern
+#include "orionld/common/performance.h"                          // PERFORMANCE
+#include "orionld/types/OrionldEntitiesBulk.h"                   // OrionldEntitiesBulk, OrionldBulkOp
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocEntitiesBulkWrite.h"              // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bulkOpError -
+//
+static void bulkOpError(OrionldEntitiesBulk* bulkP, OrionldBulkOp* opP, const char* error)
+{
+  if (opP->error != NULL)
+    return;
+
+  opP->error = kaStrdup(&orionldState.kalloc, error);
+  bulkP->errors += 1;
+
+  LM_E(("Database Error (bulk write of entity '%s': %s)", opP->entityId, error));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// writeErrorsExtract - map the items of "writeErrors" in the reply back to their ops
+//
+// The reply of an unordered bulk write has one item per failed write in "writeErrors":
+//   { "index": <index of the write in the bulk>, "code": <int>, "errmsg": <string> }
+//
+// Returns false if the reply has no "writeErrors" (the bulk write failed as a whole).
+//
+static bool writeErrorsExtract(OrionldEntitiesBulk* bulkP, OrionldBulkOp** opV, int opsInBulk, const bson_t* replyP)
+{
+  bson_iter_t  iter;
+  bson_iter_t  errorsIter;
+  bool         found = false;
+
+  if ((bson_iter_init_find(&iter, replyP, "writeErrors") == false) || (BSON_ITER_HOLDS_ARRAY(&iter) == false))
+    return false;
+
+  if (bson_iter_recurse(&iter, &errorsIter) == false)
+    return false;
+
+  while (bson_iter_next(&errorsIter))
+  {
+    bson_iter_t  itemIter;
+    int          index  = -1;
+    const char*  errmsg = "write error";
+
+    if ((BSON_ITER_HOLDS_DOCUMENT(&errorsIter) == false) || (bson_iter_recurse(&errorsIter, &itemIter) == false))
+      continue;
+
+    while (bson_iter_next(&itemIter))
+    {
+      const char* key = bson_iter_key(&itemIter);
+
+      if ((strcmp(key, "index") == 0) && (BSON_ITER_HOLDS_INT32(&itemIter)))
+        index = bson_iter_int32(&itemIter);
+      else if ((strcmp(key, "errmsg") == 0) && (BSON_ITER_HOLDS_UTF8(&itemIter)))
+        errmsg = bson_iter_utf8(&itemIter, NULL);
+    }
+
+    if ((index >= 0) && (index < opsInBulk))
+    {
+      bulkOpError(bulkP, opV[index], errmsg);
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocEntitiesBulkWrite -
+//
+// One round trip to the database for all entities of a BATCH operation, instead of one insert/update per entity.
+// The bulk is unordered - a failing write doesn't stop the rest of the writes, and mongo may perform the writes in parallel.
+//
+bool mongocEntitiesBulkWrite(OrionldEntitiesBulk* bulkP)
+{
+  if (bulkP->ops == 0)
+    return true;
+
+  OrionldBulkOp**           opV       = (OrionldBulkOp**) kaAlloc(&orionldState.kalloc, bulkP->ops * sizeof(OrionldBulkOp*));
+  int                       opsInBulk = 0;
+  MongocClient*             clientP;
+  mongoc_collection_t*      collectionP;
+  mongoc_bulk_operation_t*  bulkOpP;
+  bson_t                    opts;
+  bson_t                    reply;
+  bson_error_t              mongoError;
+
+  bson_init(&opts);
+  bson_append_bool(&opts, "ordered", 7, false);
+
+  if (writeConcern == 0)
+  {
+    mongoc_write_concern_t* wcP = mongoc_write_concern_new();
+
+    mongoc_write_concern_set_w(wcP, MONGOC_WRITE_CONCERN_W_UNACKNOWLEDGED);
+    mongoc_write_concern_append(wcP, &opts);
+    mongoc_write_concern_destroy(wcP);
+  }
+
+  clientP     = mongocClientPop();
+  collectionP = mongocCollectionGet(clientP, orionldState.tenantP->mongoDbName, "entities");
+  bulkOpP     = mongoc_collection_create_bulk_operation_with_opts(collectionP, &opts);
+
+  for (OrionldBulkOp* opP = bulkP->first; opP != NULL; opP = opP->next)
+  {
+    bool ok;
+
+    if (opP->selectorP == NULL)
+      ok = mongoc_bulk_operation_insert_with_opts(bulkOpP, opP->docP, NULL, &mongoError);
+    else
+      ok = mongoc_bulk_operation_update_one_with_opts(bulkOpP, opP->selectorP, opP->docP, NULL, &mongoError);
+
+    if (ok == false)  // Not part of the bulk - doesn't get an index
+      bulkOpError(bulkP, opP, mongoError.message);
+    else
+      opV[opsInBulk++] = opP;
+  }
+
+  if (opsInBulk > 0)
+  {
+    PERFORMANCE(dbStart);
+
+    if (mongoc_bulk_operation_execute(bulkOpP, &reply, &mongoError) == 0)
+    {
+      if (writeErrorsExtract(bulkP, opV, opsInBulk, &reply) == false)
+      {
+        // No info on individual writes - all of them are considered failed
+        for (int ix = 0; ix < opsInBulk; ix++)
+          bulkOpError(bulkP, opV[ix], mongoError.message);
+      }
+    }
+
+    PERFORMANCE(dbEnd);
+    bson_destroy(&reply);
+  }
+
+  mongoc_bulk_operation_destroy(bulkOpP);
+  mongocClientPush(clientP);
+
+  bson_destroy(&opts);
+
+  for (OrionldBulkOp* opP = bulkP->first; opP != NULL; opP = opP->next)
+  {
+    if (opP->selectorP != NULL)
+      bson_destroy(opP->selectorP);
+    bson_destroy(opP->docP);
+  }
+
+  return bulkP->errors == 0;
+}
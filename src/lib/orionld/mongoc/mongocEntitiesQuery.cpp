@@ -0,0 +1,581 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, strncmp
+#include <stdlib.h>                                              // atoi
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                        // kjLookup
+#include "kjson/kjBuilder.h"                                     // kjArray, kjChildAdd
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/QNode.h"                                // QNode
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
+#include "orionld/common/performance.h"                          // PERFORMANCE
+#include "orionld/common/qTreeToBson.h"                          // qTreeToBson
+#include "orionld/common/dotForEq.h"                             // dotForEq
+#include "orionld/common/SCOMPARE.h"                             // SCOMPAREx
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
+#include "orionld/mongoc/mongocEntitiesQuery.h"                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityInfoToBson - { "_id.id": ID, "_id.type": TYPE } or { "_id.id": { "$regex": PATTERN }, ... }
+//
+static void entityInfoToBson(bson_t* bsonP, KjNode* entityP)
+{
+  for (KjNode* nodeP = entityP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
+  {
+    if ((strcmp(nodeP->name, "id") == 0) || (strcmp(nodeP->name, "@id") == 0))
+      bson_append_utf8(bsonP, "_id.id", 6, nodeP->value.s, -1);
+    else if ((strcmp(nodeP->name, "type") == 0) || (strcmp(nodeP->name, "@type") == 0))
+      bson_append_utf8(bsonP, "_id.type", 8, nodeP->value.s, -1);
+    else if (strcmp(nodeP->name, "idPattern") == 0)
+    {
+      if (strcmp(nodeP->value.s, ".*") != 0)  // ".*" matches everything - no need to filter
+      {
+        bson_t regex;
+
+        bson_append_document_begin(bsonP, "_id.id", 6, &regex);
+        bson_append_utf8(&regex, "$regex", 6, nodeP->value.s, -1);
+        bson_append_document_end(bsonP, &regex);
+      }
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityInfoArrayFilter -
+//
+// One single EntityInfo goes straight into the filter, more than one needs an "$or"
+//
+static void entityInfoArrayFilter(bson_t* filterP, KjNode* entityInfoArrayP)
+{
+  KjNode* firstP = entityInfoArrayP->value.firstChildP;
+
+  if (firstP->next == NULL)
+  {
+    entityInfoToBson(filterP, firstP);
+    return;
+  }
+
+  bson_t    orArray;
+  uint32_t  ix = 0;
+
+  bson_append_array_begin(filterP, "$or", 3, &orArray);
+
+  for (KjNode* entityP = firstP; entityP != NULL; entityP = entityP->next)
+  {
+    bson_t       item;
+    char         keyBuf[16];
+    const char*  key;
+    size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+
+    bson_append_document_begin(&orArray, key, keyLen, &item);
+    entityInfoToBson(&item, entityP);
+    bson_append_document_end(&orArray, &item);
+  }
+
+  bson_append_array_end(filterP, &orArray);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// attrsFilter -
+//
+// Filter:      { "attrNames": { "$in": [ "A1", "A2" ] } }
+// Projection:  { "attrs.A1": 1, "attrs.A2": 1 }   - in the database, the dots of the attribute names are replaced with '='
+//
+static void attrsFilter(bson_t* filterP, bson_t* projectionP, KjNode* attrsP)
+{
+  bson_t    inObject;
+  bson_t    inArray;
+  uint32_t  ix = 0;
+
+  bson_append_document_begin(filterP, "attrNames", 9, &inObject);
+  bson_append_array_begin(&inObject, "$in", 3, &inArray);
+
+  for (KjNode* attrP = attrsP->value.firstChildP; attrP != NULL; attrP = attrP->next)
+  {
+    char         keyBuf[16];
+    const char*  key;
+    size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+    char         path[512];
+    char*        eqName = kaStrdup(&orionldState.kalloc, attrP->value.s);
+
+    bson_append_utf8(&inArray, key, keyLen, attrP->value.s, -1);
+
+    dotForEq(eqName);
+    snprintf(path, sizeof(path), "attrs.%s", eqName);
+    bson_append_int32(projectionP, path, -1, 1);
+  }
+
+  bson_append_array_end(&inObject, &inArray);
+  bson_append_document_end(filterP, &inObject);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// coordinatesAppend - KjNode coordinates array to BSON array (numbers and arrays only)
+//
+static void coordinatesAppend(bson_t* parentP, const char* name, int nameLen, KjNode* arrayP)
+{
+  bson_t    array;
+  uint32_t  ix = 0;
+
+  bson_append_array_begin(parentP, name, nameLen, &array);
+
+  for (KjNode* itemP = arrayP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+  {
+    char         keyBuf[16];
+    const char*  key;
+    size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+
+    if (itemP->type == KjFloat)
+      bson_append_double(&array, key, keyLen, itemP->value.f);
+    else if (itemP->type == KjInt)
+      bson_append_double(&array, key, keyLen, (double) itemP->value.i);
+    else if (itemP->type == KjArray)
+      coordinatesAppend(&array, key, keyLen, itemP);
+  }
+
+  bson_append_array_end(parentP, &array);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geometryAppend - { "$geometry": { "type": <geometry>, "coordinates": [ ... ] } }
+//
+static void geometryAppend(bson_t* parentP, const char* geometry, KjNode* coordsP)
+{
+  bson_t geometryObject;
+
+  bson_append_document_begin(parentP, "$geometry", 9, &geometryObject);
+  bson_append_utf8(&geometryObject, "type", 4, geometry, -1);
+  coordinatesAppend(&geometryObject, "coordinates", 11, coordsP);
+  bson_append_document_end(parentP, &geometryObject);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoqFilter -
+//
+// Mongo operators per georel:
+//   near        => { "attrs.P.value": { "$nearSphere": { "$geometry": {}, "$minDistance": X, "$maxDistance": Y } } }
+//   within      => { "attrs.P.value": { "$geoWithin": { "$geometry": {} } } }
+//   intersects  => { "attrs.P.value": { "$geoIntersects": { "$geometry": {} } } }
+//   disjoint    => { "attrs.P.value": { "$not": { "$geoIntersects": { "$geometry": {} } } } }
+//   overlaps    => intersects + { "attrs.P.value.type": <geometry> }
+//   equals      => { "attrs.P.value": { "type": <geometry>, "coordinates": [] } }
+//
+static bool geoqFilter(bson_t* filterP, KjNode* geoqP)
+{
+  KjNode*      geometryP    = NULL;
+  KjNode*      georelP      = NULL;
+  KjNode*      coordsP      = NULL;
+  const char*  geoproperty  = "location";
+
+  for (KjNode* nodeP = geoqP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
+  {
+    if (strcmp(nodeP->name, "geometry") == 0)
+      geometryP = nodeP;
+    else if (strcmp(nodeP->name, "georel") == 0)
+      georelP = nodeP;
+    else if (strcmp(nodeP->name, "coordinates") == 0)
+      coordsP = nodeP;
+    else if (strcmp(nodeP->name, "geoproperty") == 0)
+      geoproperty = nodeP->value.s;
+  }
+
+  if ((geometryP == NULL) || (georelP == NULL) || (coordsP == NULL) || (coordsP->type != KjArray))
+  {
+    orionldErrorResponseCreate(OrionldBadRequestData, "Invalid geo-query", "geometry, georel and coordinates are mandatory");
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  char*   georel   = georelP->value.s;
+  char*   geometry = geometryP->value.s;
+  char    path[512];
+  bson_t  geoObject;
+
+  snprintf(path, sizeof(path), "attrs.%s.value", geoproperty);
+
+  if (SCOMPARE5(georel, 'n', 'e', 'a', 'r', ';'))
+  {
+    char* distance    = &georel[5];
+    char* maxDistance = (strncmp(distance, "maxDistance==", 13) == 0)? &distance[13] : NULL;
+    char* minDistance = (strncmp(distance, "minDistance==", 13) == 0)? &distance[13] : NULL;
+    bson_t nearObject;
+
+    if ((maxDistance == NULL) && (minDistance == NULL))
+    {
+      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid georel", "no distance for 'near' georel");
+      orionldState.httpStatusCode = 400;
+      return false;
+    }
+
+    bson_append_document_begin(filterP, path, -1, &geoObject);
+    bson_append_document_begin(&geoObject, "$nearSphere", 11, &nearObject);
+    geometryAppend(&nearObject, geometry, coordsP);
+    if (minDistance != NULL)
+      bson_append_int32(&nearObject, "$minDistance", 12, atoi(minDistance));
+    if (maxDistance != NULL)
+      bson_append_int32(&nearObject, "$maxDistance", 12, atoi(maxDistance));
+    bson_append_document_end(&geoObject, &nearObject);
+    bson_append_document_end(filterP, &geoObject);
+  }
+  else if (SCOMPARE7(georel, 'w', 'i', 't', 'h', 'i', 'n', 0))
+  {
+    bson_t withinObject;
+
+    bson_append_document_begin(filterP, path, -1, &geoObject);
+    bson_append_document_begin(&geoObject, "$geoWithin", 10, &withinObject);
+    geometryAppend(&withinObject, geometry, coordsP);
+    bson_append_document_end(&geoObject, &withinObject);
+    bson_append_document_end(filterP, &geoObject);
+  }
+  else if ((SCOMPARE11(georel, 'i', 'n', 't', 'e', 'r', 's', 'e', 'c', 't', 's', 0)) || (SCOMPARE9(georel, 'o', 'v', 'e', 'r', 'l', 'a', 'p', 's', 0)))
+  {
+    bson_t intersectsObject;
+
+    bson_append_document_begin(filterP, path, -1, &geoObject);
+    bson_append_document_begin(&geoObject, "$geoIntersects", 14, &intersectsObject);
+    geometryAppend(&intersectsObject, geometry, coordsP);
+    bson_append_document_end(&geoObject, &intersectsObject);
+    bson_append_document_end(filterP, &geoObject);
+
+    if (georel[0] == 'o')  // overlaps - must also be of the same geometry
+    {
+      snprintf(path, sizeof(path), "attrs.%s.value.type", geoproperty);
+      bson_append_utf8(filterP, path, -1, geometry, -1);
+    }
+  }
+  else if (SCOMPARE9(georel, 'd', 'i', 's', 'j', 'o', 'i', 'n', 't', 0))
+  {
+    bson_t notObject;
+    bson_t intersectsObject;
+
+    bson_append_document_begin(filterP, path, -1, &geoObject);
+    bson_append_document_begin(&geoObject, "$not", 4, &notObject);
+    bson_append_document_begin(&notObject, "$geoIntersects", 14, &intersectsObject);
+    geometryAppend(&intersectsObject, geometry, coordsP);
+    bson_append_document_end(&notObject, &intersectsObject);
+    bson_append_document_end(&geoObject, &notObject);
+    bson_append_document_end(filterP, &geoObject);
+  }
+  else if (SCOMPARE7(georel, 'e', 'q', 'u', 'a', 'l', 's', 0))
+  {
+    bson_append_document_begin(filterP, path, -1, &geoObject);
+    bson_append_utf8(&geoObject, "type", 4, geometry, -1);
+    coordinatesAppend(&geoObject, "coordinates", 11, coordsP);
+    bson_append_document_end(filterP, &geoObject);
+  }
+  else
+  {
+    orionldErrorResponseCreate(OrionldBadRequestData, "Invalid georel", georel);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoqIsNear -
+//
+static bool geoqIsNear(KjNode* geoqP)
+{
+  if (geoqP == NULL)
+    return false;
+
+  KjNode* georelP = kjLookup(geoqP, "georel");
+
+  return ((georelP != NULL) && (georelP->type == KjString) && (strncmp(georelP->value.s, "near;", 5) == 0));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entitiesCount -
+//
+// mongoc_collection_count_documents runs an aggregation ($match) and $nearSphere is not allowed inside $match.
+// For 'near' queries the hits are counted by iterating over a cursor that only projects _id.
+//
+static int64_t entitiesCount(mongoc_collection_t* collectionP, bson_t* filterP, bool near, bson_error_t* errorP)
+{
+  if (near == false)
+    return mongoc_collection_count_documents(collectionP, filterP, NULL, NULL, NULL, errorP);
+
+  bson_t            opts;
+  bson_t            projection;
+  const bson_t*     docP;
+  mongoc_cursor_t*  cursorP;
+  int64_t           count = 0;
+
+  bson_init(&opts);
+  bson_append_document_begin(&opts, "projection", 10, &projection);
+  bson_append_int32(&projection, "_id", 3, 1);
+  bson_append_document_end(&opts, &projection);
+
+  cursorP = mongoc_collection_find_with_opts(collectionP, filterP, &opts, NULL);
+
+  while (mongoc_cursor_next(cursorP, &docP))
+    ++count;
+
+  if (mongoc_cursor_error(cursorP, errorP))
+    count = -1;
+
+  mongoc_cursor_destroy(cursorP);
+  bson_destroy(&opts);
+
+  return count;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// filterCompose - { "$and": [ <entity info part>, <attrs part>, <q part>, <geo part> ] }
+//
+// Each part of the filter is built in a document of its own and the non-empty parts are AND-ed with "$and".
+// Appending all parts to one and the same document would give duplicated keys ("$or" from the entity info and from q,
+// or the same attribute in q and in the geo-query), and what mongo does with duplicated keys is undefined.
+// Without any filter at all, the filter stays empty - mongo doesn't accept an empty "$and".
+//
+static void filterCompose(bson_t* filterP, bson_t** partV, int parts)
+{
+  bson_t    andArray;
+  uint32_t  ix = 0;
+  int       nonEmpty = 0;
+
+  for (int partIx = 0; partIx < parts; partIx++)
+  {
+    if (bson_empty(partV[partIx]) == false)
+      ++nonEmpty;
+  }
+
+  if (nonEmpty == 0)
+    return;
+
+  bson_append_array_begin(filterP, "$and", 4, &andArray);
+
+  for (int partIx = 0; partIx < parts; partIx++)
+  {
+    if (bson_empty(partV[partIx]) == true)
+      continue;
+
+    char         keyBuf[16];
+    const char*  key;
+    size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+
+    bson_append_document(&andArray, key, keyLen, partV[partIx]);
+  }
+
+  bson_append_array_end(filterP, &andArray);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocEntitiesQuery -
+//
+// The filter is built directly from the KjNode trees (as POST Query and GET /entities have them after checking the input)
+// and the documents from the cursor are converted directly to KjNode trees - no NGSIv2 objects involved.
+//
+// The returned entities are in the database model, to be converted to API entities by the caller.
+//
+KjNode* mongocEntitiesQuery(KjNode* entityInfoArrayP, KjNode* attrsP, QNode* qP, KjNode* geoqP, int limit, int offset, int* countP)
+{
+  bson_t  filter;
+  bson_t  entityInfoPart;
+  bson_t  attrsPart;
+  bson_t  qPart;
+  bson_t  geoPart;
+  bson_t* partV[4] = { &entityInfoPart, &attrsPart, &qPart, &geoPart };
+  bson_t  opts;
+  bson_t  projection;
+  bson_t  sort;
+  char*   title;
+  char*   detail;
+
+  bson_init(&filter);
+  bson_init(&entityInfoPart);
+  bson_init(&attrsPart);
+  bson_init(&qPart);
+  bson_init(&geoPart);
+  bson_init(&projection);
+
+  if ((entityInfoArrayP != NULL) && (entityInfoArrayP->value.firstChildP != NULL))
+    entityInfoArrayFilter(&entityInfoPart, entityInfoArrayP);
+
+  if ((attrsP != NULL) && (attrsP->value.firstChildP != NULL))
+  {
+    //
+    // With 'attrs', only the matching attributes are to be returned, plus everything else except the other attributes
+    //
+    bson_append_int32(&projection, "_id",       3, 1);
+    bson_append_int32(&projection, "attrNames", 9, 1);
+    bson_append_int32(&projection, "creDate",   7, 1);
+    bson_append_int32(&projection, "modDate",   7, 1);
+    attrsFilter(&attrsPart, &projection, attrsP);
+  }
+
+  bool ok = true;
+
+  if ((qP != NULL) && (qTreeToBson(qP, &qPart, &title, &detail) == false))
+  {
+    LM_W(("Bad Input (qTreeToBson: %s: %s)", title, detail));
+    orionldErrorResponseCreate(OrionldBadRequestData, title, detail);
+    orionldState.httpStatusCode = 400;
+    ok = false;
+  }
+  else if ((geoqP != NULL) && (geoqFilter(&geoPart, geoqP) == false))
+    ok = false;
+
+  if (ok == true)
+    filterCompose(&filter, partV, 4);
+
+  for (int ix = 0; ix < 4; ix++)
+    bson_destroy(partV[ix]);
+
+  if (ok == false)
+  {
+    bson_destroy(&filter);
+    bson_destroy(&projection);
+    return NULL;
+  }
+
+  KjNode*               entityArray = kjArray(orionldState.kjsonP, NULL);
+  MongocClient*         clientP;
+  mongoc_collection_t*  collectionP;
+  bson_error_t          mongoError;
+
+  clientP     = mongocClientPop();
+  collectionP = mongocCollectionGet(clientP, orionldState.tenantP->mongoDbName, "entities");
+
+  PERFORMANCE(dbStart);
+
+  //
+  // Count asked for ?
+  //
+  if (countP != NULL)
+  {
+    int64_t count = entitiesCount(collectionP, &filter, geoqIsNear(geoqP), &mongoError);
+
+    if (count < 0)
+    {
+      LM_E(("Database Error (counting entities: %s)", mongoError.message));
+      entityArray = NULL;
+      limit       = 0;  // Just to avoid performing the query
+    }
+    else
+      *countP = (int) count;
+  }
+
+  if (limit != 0)
+  {
+    const bson_t*     docP;
+    mongoc_cursor_t*  cursorP;
+
+    bson_init(&opts);
+    bson_append_document_begin(&opts, "sort", 4, &sort);
+    bson_append_int32(&sort, "creDate", 7, 1);
+    bson_append_document_end(&opts, &sort);
+    bson_append_int32(&opts, "limit", 5, limit);
+    if (offset > 0)
+      bson_append_int32(&opts, "skip", 4, offset);
+    if (bson_empty(&projection) == false)
+      bson_append_document(&opts, "projection", 10, &projection);
+
+    cursorP = mongoc_collection_find_with_opts(collectionP, &filter, &opts, NULL);
+
+    while (mongoc_cursor_next(cursorP, &docP))
+    {
+      KjNode* entityP = mongocKjTreeFromBson(docP, &title, &detail);
+
+      if (entityP == NULL)
+      {
+        LM_E(("Database Error (%s: %s)", title, detail));
+        continue;
+      }
+
+      kjChildAdd(entityArray, entityP);
+    }
+
+    if (mongoc_cursor_error(cursorP, &mongoError))
+    {
+      LM_E(("Database Error (%s)", mongoError.message));
+      entityArray = NULL;
+    }
+
+    mongoc_cursor_destroy(cursorP);
+    bson_destroy(&opts);
+  }
+
+  PERFORMANCE(dbEnd);
+
+  mongocClientPush(clientP);
+
+  bson_destroy(&filter);
+  bson_destroy(&projection);
+
+  if (entityArray == NULL)
+  {
+    orionldErrorResponseCreate(OrionldInternalError, "Database Error", "error querying entities");
+    orionldState.httpStatusCode = 500;
+  }
+
+  return entityArray;
+}
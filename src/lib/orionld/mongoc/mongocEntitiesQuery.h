@@ -1,9 +1,9 @@
-#ifndef SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITIESQUERY_H_
-#define SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITIESQUERY_H_
+#ifndef SRC_LIB_ORIONLD_MONGOC_MONGOCENTITIESQUERY_H_
+#define SRC_LIB_ORIONLD_MONGOC_MONGOCENTITIESQUERY_H_
 
 /*
 *
-* Copyright 2019 FIWARE Foundation e.V.
+* Copyright 2021 FIWARE Foundation e.V.
 *
 * This file is part of Orion-LD Context Broker.
 *
@@ -37,8 +37,10 @@ extern "C"
 
 // -----------------------------------------------------------------------------
 //
-// mongoCppLegacyEntitiesQuery -
+// mongocEntitiesQuery -
 //
-extern KjNode* mongoCppLegacyEntitiesQuery(KjNode* entityInfoArrayP, KjNode* attrsP, QNode* qP, KjNode* geoqP, int limit, int offset, int* countP);
+// Returns an array of entities, in database model, or NULL on error (orionldState.pd/httpStatusCode are set).
+//
+extern KjNode* mongocEntitiesQuery(KjNode* entityInfoArrayP, KjNode* attrsP, QNode* qP, KjNode* geoqP, int limit, int offset, int* countP);
 
-#endif  // SRC_LIB_ORIONLD_MONGOCPPLEGACY_MONGOCPPLEGACYENTITIESQUERY_H_
+#endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCENTITIESQUERY_H_
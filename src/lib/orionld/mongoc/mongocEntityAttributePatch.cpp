@@ -0,0 +1,278 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, strncpy
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "common/globals.h"                                      // parse8601Time
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/performance.h"                          // PERFORMANCE
+#include "orionld/common/dotForEq.h"                             // dotForEq
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
+#include "orionld/mongoc/mongocEntityAttributePatch.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// valueAppend - KjNode value to BSON, the way mongoBackend stores attribute values
+//
+// - all numbers are stored as doubles
+// - the dots in the names of object members are replaced by '='
+//
+static void valueAppend(bson_t* parentP, const char* name, int nameLen, KjNode* valueP)
+{
+  if      (valueP->type == KjString)   bson_append_utf8(parentP, name, nameLen, valueP->value.s, -1);
+  else if (valueP->type == KjInt)      bson_append_double(parentP, name, nameLen, (double) valueP->value.i);
+  else if (valueP->type == KjFloat)    bson_append_double(parentP, name, nameLen, valueP->value.f);
+  else if (valueP->type == KjBoolean)  bson_append_bool(parentP, name, nameLen, valueP->value.b);
+  else if (valueP->type == KjNull)     bson_append_null(parentP, name, nameLen);
+  else if (valueP->type == KjObject)
+  {
+    bson_t object;
+
+    bson_append_document_begin(parentP, name, nameLen, &object);
+    for (KjNode* memberP = valueP->value.firstChildP; memberP != NULL; memberP = memberP->next)
+    {
+      char eqName[256];
+
+      strncpy(eqName, memberP->name, sizeof(eqName) - 1);
+      eqName[sizeof(eqName) - 1] = 0;
+      dotForEq(eqName);
+      valueAppend(&object, eqName, -1, memberP);
+    }
+    bson_append_document_end(parentP, &object);
+  }
+  else if (valueP->type == KjArray)
+  {
+    bson_t    array;
+    uint32_t  ix = 0;
+
+    bson_append_array_begin(parentP, name, nameLen, &array);
+    for (KjNode* itemP = valueP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+    {
+      char         keyBuf[16];
+      const char*  key;
+      size_t       keyLen = bson_uint32_to_string(ix++, &key, keyBuf, sizeof(keyBuf));
+
+      valueAppend(&array, key, keyLen, itemP);
+    }
+    bson_append_array_end(parentP, &array);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subAttributeAppend - the fields of "attrs.<attr>.md.<sub-attr>"
+//
+// observedAt and unitCode are stored as { "value": X } and are set as a whole.
+// The rest of the sub-attributes are stored as { "createdAt": T, "modifiedAt": T, "type": X, "value": Y }, and
+// their fields are set one by one, so that the createdAt of an already existing sub-attribute is kept -
+// "$min" only sets the createdAt if it isn't there already (any existing createdAt is older than the request).
+//
+// Members of unexpected JSON types are not appended - the caller has already checked the sub-attribute.
+//
+static void subAttributeAppend(bson_t* setP, bson_t* minP, const char* path, KjNode* saP)
+{
+  char fieldPath[1024];
+
+  if ((strcmp(saP->name, "observedAt") == 0) || (strcmp(saP->name, "unitCode") == 0))
+  {
+    bson_t md;
+
+    if (saP->type != KjString)
+      return;
+
+    bson_append_document_begin(setP, path, -1, &md);
+    if (strcmp(saP->name, "observedAt") == 0)
+      bson_append_double(&md, "value", 5, parse8601Time(saP->value.s));
+    else
+      bson_append_utf8(&md, "value", 5, saP->value.s, -1);
+    bson_append_document_end(setP, &md);
+    return;
+  }
+
+  if (saP->type != KjObject)
+    return;
+
+  snprintf(fieldPath, sizeof(fieldPath), "%s.createdAt", path);
+  bson_append_double(minP, fieldPath, -1, orionldState.requestTime);
+  snprintf(fieldPath, sizeof(fieldPath), "%s.modifiedAt", path);
+  bson_append_double(setP, fieldPath, -1, orionldState.requestTime);
+
+  for (KjNode* memberP = saP->value.firstChildP; memberP != NULL; memberP = memberP->next)
+  {
+    if (strcmp(memberP->name, "type") == 0)
+    {
+      if (memberP->type != KjString)
+        continue;
+
+      snprintf(fieldPath, sizeof(fieldPath), "%s.type", path);
+      bson_append_utf8(setP, fieldPath, -1, memberP->value.s, -1);
+    }
+    else if ((strcmp(memberP->name, "value") == 0) || (strcmp(memberP->name, "object") == 0))
+    {
+      snprintf(fieldPath, sizeof(fieldPath), "%s.value", path);
+      valueAppend(setP, fieldPath, -1, memberP);
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocEntityAttributePatch -
+//
+// filter: { "_id.id": <entityId>, "attrs.<attr>.type": <attrType> }
+// update: {
+//   "$set": {
+//     "attrs.<attr>.value":            <value, or object for Relationships>,
+//     "attrs.<attr>.modDate":          <now>,
+//     "attrs.<attr>.md.<sub-attr>.*":  <type, value and modifiedAt of the sub-attribute>,
+//     "modDate":                       <now>,
+//     "lastCorrelator":                <correlator>
+//   },
+//   "$min":      { "attrs.<attr>.md.<sub-attr>.createdAt": <now> },
+//   "$addToSet": { "attrs.<attr>.mdNames": { "$each": [ <sub-attr names> ] } }
+// }
+//
+// The sub-attributes that are not part of the patch are left untouched.
+//
+bool mongocEntityAttributePatch(const char* entityId, const char* attrNameEq, const char* attrType, KjNode* attrP, int64_t* matchedP)
+{
+  char      path[1024];
+  bson_t    filter;
+  bson_t    update;
+  bson_t    set;
+  bson_t    min;
+  bson_t    addToSet;
+  bson_t    mdNames;
+  bson_t    each;
+  uint32_t  mdIx = 0;
+
+  bson_init(&filter);
+  bson_init(&update);
+  bson_init(&mdNames);
+  bson_init(&min);
+
+  bson_append_utf8(&filter, "_id.id", 6, entityId, -1);
+  snprintf(path, sizeof(path), "attrs.%s.type", attrNameEq);
+  bson_append_utf8(&filter, path, -1, attrType, -1);
+
+  bson_append_document_begin(&update, "$set", 4, &set);
+
+  for (KjNode* memberP = attrP->value.firstChildP; memberP != NULL; memberP = memberP->next)
+  {
+    if (strcmp(memberP->name, "type") == 0)
+      continue;
+
+    if ((strcmp(memberP->name, "value") == 0) || (strcmp(memberP->name, "object") == 0))
+    {
+      snprintf(path, sizeof(path), "attrs.%s.value", attrNameEq);
+      valueAppend(&set, path, -1, memberP);
+    }
+    else  // Sub-attribute
+    {
+      char         eqName[256];
+      char         keyBuf[16];
+      const char*  key;
+      size_t       keyLen = bson_uint32_to_string(mdIx++, &key, keyBuf, sizeof(keyBuf));
+
+      strncpy(eqName, memberP->name, sizeof(eqName) - 1);
+      eqName[sizeof(eqName) - 1] = 0;
+      dotForEq(eqName);
+
+      snprintf(path, sizeof(path), "attrs.%s.md.%s", attrNameEq, eqName);
+      subAttributeAppend(&set, &min, path, memberP);
+      bson_append_utf8(&mdNames, key, keyLen, memberP->name, -1);
+    }
+  }
+
+  snprintf(path, sizeof(path), "attrs.%s.modDate", attrNameEq);
+  bson_append_double(&set, path, -1, orionldState.requestTime);
+  bson_append_double(&set, "modDate", 7, orionldState.requestTime);
+  bson_append_utf8(&set, "lastCorrelator", 14, (orionldState.correlator != NULL)? orionldState.correlator : "", -1);
+  bson_append_document_end(&update, &set);
+
+  if (bson_empty(&min) == false)
+    bson_append_document(&update, "$min", 4, &min);
+
+  if (mdIx > 0)
+  {
+    bson_append_document_begin(&update, "$addToSet", 9, &addToSet);
+    snprintf(path, sizeof(path), "attrs.%s.mdNames", attrNameEq);
+    bson_append_document_begin(&addToSet, path, -1, &each);
+    bson_append_array(&each, "$each", 5, &mdNames);
+    bson_append_document_end(&addToSet, &each);
+    bson_append_document_end(&update, &addToSet);
+  }
+
+  MongocClient*         clientP;
+  mongoc_collection_t*  collectionP;
+  bson_t                reply;
+  bson_error_t          mongoError;
+  bool                  ok;
+
+  clientP     = mongocClientPop();
+  collectionP = mongocCollectionGet(clientP, orionldState.tenantP->mongoDbName, "entities");
+
+  PERFORMANCE(dbStart);
+  ok = mongoc_collection_update_one(collectionP, &filter, &update, NULL, &reply, &mongoError);
+  PERFORMANCE(dbEnd);
+
+  if (ok == true)
+  {
+    bson_iter_t iter;
+
+    *matchedP = 0;
+    if (bson_iter_init_find(&iter, &reply, "matchedCount"))
+      *matchedP = bson_iter_as_int64(&iter);
+  }
+  else
+    LM_E(("Database Error (updating attribute '%s' of entity '%s': %s)", attrNameEq, entityId, mongoError.message));
+
+  bson_destroy(&reply);
+  mongocClientPush(clientP);
+
+  bson_destroy(&filter);
+  bson_destroy(&update);
+  bson_destroy(&mdNames);
+  bson_destroy(&min);
+
+  return ok;
+}
@@ -0,0 +1,49 @@
+#ifndef SRC_LIB_ORIONLD_MONGOC_MONGOCENTITYATTRIBUTEPATCH_H_
+#define SRC_LIB_ORIONLD_MONGOC_MONGOCENTITYATTRIBUTEPATCH_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // int64_t
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocEntityAttributePatch -
+//
+// Partial update of one attribute of an entity, with one single targeted update - the entity is not read.
+// 'attrP' is the incoming attribute (API format) - its sub-attribute names must be expanded already.
+//
+// Returns false on database error.
+// *matchedP is set to 0 if the entity isn't found, or the entity has no attribute 'attrNameEq' of type 'attrType'.
+//
+extern bool mongocEntityAttributePatch(const char* entityId, const char* attrNameEq, const char* attrType, KjNode* attrP, int64_t* matchedP);
+
+#endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCENTITYATTRIBUTEPATCH_H_
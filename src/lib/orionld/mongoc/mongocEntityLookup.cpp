@@ -32,8 +32,12 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "orionld/common/orionldState.h"                         // orionldState, mongoEntitiesCollectionP
+#include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/db/dbConfiguration.h"                          // dbDataToKjTree
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClient
+#include "orionld/mongoc/mongocClientPop.h"                      // mongocClientPop
+#include "orionld/mongoc/mongocClientPush.h"                     // mongocClientPush
+#include "orionld/mongoc/mongocCollectionGet.h"                  // mongocCollectionGet
 #include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
 #include "orionld/mongoc/mongocEntityLookup.h"                   // Own interface
 
@@ -56,15 +60,20 @@ KjNode* mongocEntityLookup(const char* entityId)
   //
   // Create the filter for the query
   //
+  bson_init(&mongoFilter);
   bson_append_utf8(&mongoFilter, "_id.id", 6, entityId, -1);
 
   //
   // Run the query
   //
-  // semTake(&mongoEntitiesSem);
-  if ((mongoCursorP = mongoc_collection_find_with_opts(mongoEntitiesCollectionP, &mongoFilter, NULL, NULL)) == NULL)
+  MongocClient*         clientP     = mongocClientPop();
+  mongoc_collection_t*  collectionP = mongocCollectionGet(clientP, orionldState.tenantP->mongoDbName, "entities");
+
+  if ((mongoCursorP = mongoc_collection_find_with_opts(collectionP, &mongoFilter, NULL, NULL)) == NULL)
   {
     LM_E(("Internal Error (mongoc_collection_find_with_opts ERROR)"));
+    mongocClientPush(clientP);
+    bson_destroy(&mongoFilter);
     return NULL;
   }
 
@@ -77,11 +86,11 @@ KjNode* mongocEntityLookup(const char* entityId)
   if (mongoc_cursor_error(mongoCursorP, &mongoError))
   {
     LM_E(("Internal Error (DB Error '%s')", mongoError.message));
-    return NULL;
+    entityNodeP = NULL;
   }
 
   mongoc_cursor_destroy(mongoCursorP);
-  // semGive(&mongoEntitiesSem);
+  mongocClientPush(clientP);
   bson_destroy(&mongoFilter);
 
   return entityNodeP;
@@ -22,13 +22,16 @@
 *
 * Author: Ken Zangelin
 */
-#include <semaphore.h>                                           // sem_init
+#include <stdlib.h>                                              // calloc
+#include <pthread.h>                                             // pthread_mutex_init
 #include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
 
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldState.h"                         // mongocClientPool, mongocPoolSize
+#include "orionld/mongoc/MongocClientPool.h"                     // MongocClientPool, MongocClient
+#include "orionld/mongoc/mongocInit.h"                           // Own interface
 
 
 
@@ -36,10 +39,18 @@
 //
 // mongocInit -
 //
-void mongocInit(const char* dbHost, const char* dbName)
+// A mongoc_client_t is not thread-safe - all mongoc clients are taken from a pool (mongocClientPool) of at most
+// mongocPoolSize clients, that is shared by all threads (see mongocClientPop).
+// mongocInit may be called more than once (context cache + DB_DRIVER_MONGOC) - the pool is created only once
+//
+void mongocInit(const char* dbHost)
 {
-  bson_error_t mongoError;
-  char         mongoUri[512];
+  bson_error_t   mongoError;
+  char           mongoUri[512];
+  mongoc_uri_t*  uriP;
+
+  if (mongocClientPool.poolP != NULL)
+    return;
 
   snprintf(mongoUri, sizeof(mongoUri), "mongodb://%s", dbHost);
 
@@ -51,55 +62,27 @@ void mongocInit(const char* dbHost, const char* dbName)
   //
   // Safely create a MongoDB URI object from the given string
   //
-  orionldState.mongoUri = mongoc_uri_new_with_error(mongoUri, &mongoError);
-  if (orionldState.mongoUri == NULL)
-    LM_X(1, ("mongoc_uri_new_with_error(%s): %s", orionldState.mongoUri, mongoError.message));
-
-  //
-  // Create a new client instance
-  //
-  orionldState.mongoClient = mongoc_client_new_from_uri(orionldState.mongoUri);
-  if (orionldState.mongoClient == NULL)
-    LM_X(1, ("mongoc_client_new_from_uri failed"));
+  uriP = mongoc_uri_new_with_error(mongoUri, &mongoError);
+  if (uriP == NULL)
+    LM_X(1, ("mongoc_uri_new_with_error(%s): %s", mongoUri, mongoError.message));
 
   //
-  // Register the application name (to get tracking possibilities in the profile logs on the server)
+  // Create the pool of clients - the pool keeps a copy of the URI
   //
-  mongoc_client_set_appname(orionldState.mongoClient, "orionld");
+  mongocClientPool.poolP = mongoc_client_pool_new(uriP);
+  mongoc_uri_destroy(uriP);
 
-  //
-  // Get a handle on the database
-  //
-  orionldState.mongoDatabase = mongoc_client_get_database(orionldState.mongoClient, dbName);
-  if (orionldState.mongoDatabase == NULL)
-    LM_X(1, ("DB: mongoc_client_get_database FAILED"));
+  if (mongocClientPool.poolP == NULL)
+    LM_X(1, ("mongoc_client_pool_new failed"));
 
   //
-  // Get a handle on the collections
+  // Register the application name (to get tracking possibilities in the profile logs on the server)
   //
-#ifdef DB_DRIVER_MONGOC
-  mongoEntitiesCollectionP = mongoc_client_get_collection(orionldState.mongoClient, dbName, "entities");
-  if (mongoEntitiesCollectionP == NULL)
-    LM_X(1, ("mongoc_client_get_collection(%s, 'entities') failed", dbName));
-
-  mongoSubscriptionsCollectionP = mongoc_client_get_collection(orionldState.mongoClient, dbName, "subscriptions");
-  if (mongoSubscriptionsCollectionP == NULL)
-    LM_X(1, ("mongoc_client_get_collection(%s, 'regiatrations') failed", dbName));
-
-  mongoRegistrationsCollectionP = mongoc_client_get_collection(orionldState.mongoClient, dbName, "registrations");
-  if (mongoRegistrationsCollectionP == NULL)
-    LM_X(1, ("mongoc_client_get_collection(%s, 'regiatrations') failed", dbName));
-#endif
-
-  // The Context Cache module uses mongoc regardless
-  mongoContextsCollectionP = mongoc_client_get_collection(orionldState.mongoClient, dbName, "contexts");
-  if (mongoContextsCollectionP == NULL)
-    LM_X(1, ("mongoc_client_get_collection(%s, 'contexts') failed", dbName));
+  mongoc_client_pool_set_appname(mongocClientPool.poolP, "orionld");
+  mongoc_client_pool_max_size(mongocClientPool.poolP, mongocPoolSize);
 
-
-  //
-  // For now, there will be a single connection to the 'contexts' collection on DB 'orionld'.
-  // A semaphore is needed
-  //
-  sem_init(&mongoContextsSem, 0, 1);  // 0: shared between threads of the same process. 1: free to be taken
+  mongocClientPool.size    = mongocPoolSize;
+  mongocClientPool.clientV = (MongocClient*) calloc(mongocPoolSize, sizeof(MongocClient));
+  mongocClientPool.clients = 0;
+  pthread_mutex_init(&mongocClientPool.mutex, NULL);
 }
@@ -32,6 +32,6 @@
 //
 // mongocInit -
 //
-extern void mongocInit(const char* dbHost, const char* dbName);
+extern void mongocInit(const char* dbHost);
 
 #endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCINIT_H_
@@ -26,9 +26,9 @@
 
 extern "C"
 {
+#include "kalloc/kaStrdup.h"                                   // kaStrdup
 #include "kjson/KjNode.h"                                      // KjNode
-#include "kjson/kjParse.h"                                     // kjParse
-#include "kjson/kjClone.h"                                     // kjClone
+#include "kjson/kjBuilder.h"                                   // kjObject, kjArray, kjString, kjChildAdd, ...
 }
 
 #include "logMsg/logMsg.h"                                     // LM_*
@@ -39,41 +39,104 @@ extern "C"
 
 
 
+// -----------------------------------------------------------------------------
+//
+// kjTreeFromBsonIter - add all items of a BSON document/array (iterator) to a KjNode container
+//
+// The names of the fields (bson_iter_key) point inside the BSON buffer and that buffer is freed/reused
+// as soon as the mongoc cursor advances, so, names are copied into the request allocator.
+// String values are copied by kjString.
+//
+static bool kjTreeFromBsonIter(bson_iter_t* iterP, KjNode* containerP, bool inArray, char** titleP, char** detailsP)
+{
+  while (bson_iter_next(iterP))
+  {
+    const char*  name  = (inArray == true)? NULL : kaStrdup(&orionldState.kalloc, bson_iter_key(iterP));
+    bson_type_t  type  = bson_iter_type(iterP);
+    KjNode*      nodeP = NULL;
+
+    if (type == BSON_TYPE_UTF8)
+      nodeP = kjString(orionldState.kjsonP, name, bson_iter_utf8(iterP, NULL));
+    else if (type == BSON_TYPE_DOUBLE)
+      nodeP = kjFloat(orionldState.kjsonP, name, bson_iter_double(iterP));
+    else if (type == BSON_TYPE_INT32)
+      nodeP = kjInteger(orionldState.kjsonP, name, bson_iter_int32(iterP));
+    else if (type == BSON_TYPE_INT64)
+      nodeP = kjInteger(orionldState.kjsonP, name, bson_iter_int64(iterP));
+    else if (type == BSON_TYPE_BOOL)
+      nodeP = kjBoolean(orionldState.kjsonP, name, bson_iter_bool(iterP));
+    else if (type == BSON_TYPE_NULL)
+      nodeP = kjNull(orionldState.kjsonP, name);
+    else if ((type == BSON_TYPE_DOCUMENT) || (type == BSON_TYPE_ARRAY))
+    {
+      bson_iter_t  childIter;
+      bool         isArray = (type == BSON_TYPE_ARRAY);
+
+      nodeP = (isArray == true)? kjArray(orionldState.kjsonP, name) : kjObject(orionldState.kjsonP, name);
+
+      if (bson_iter_recurse(iterP, &childIter) == false)
+      {
+        *titleP   = (char*) "Internal Error";
+        *detailsP = (char*) "unable to recurse into BSON container";
+        return false;
+      }
+
+      if (kjTreeFromBsonIter(&childIter, nodeP, isArray, titleP, detailsP) == false)
+        return false;
+    }
+    else if (type == BSON_TYPE_SYMBOL)  // mongocKjTreeToBson stores strings as symbols
+    {
+      uint32_t     len;
+      const char*  symbol = bson_iter_symbol(iterP, &len);
+
+      nodeP = kjString(orionldState.kjsonP, name, symbol);
+    }
+    else if (type == BSON_TYPE_OID)
+    {
+      char oidString[25];
+
+      bson_oid_to_string(bson_iter_oid(iterP), oidString);
+      nodeP = kjString(orionldState.kjsonP, name, oidString);
+    }
+    else if (type == BSON_TYPE_DATE_TIME)  // Milliseconds since the epoch - Orion-LD uses floating point seconds
+      nodeP = kjFloat(orionldState.kjsonP, name, ((double) bson_iter_date_time(iterP)) / 1000);
+    else
+    {
+      LM_W(("Database Warning (unsupported BSON type %d for field '%s' - skipped)", type, bson_iter_key(iterP)));
+      continue;
+    }
+
+    kjChildAdd(containerP, nodeP);
+  }
+
+  return true;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // mongocKjTreeFromBson -
 //
+// The BSON document is traversed directly and the KjNode tree is built on the way - no JSON text in between.
+//
 KjNode* mongocKjTreeFromBson(const void* dataP, char** titleP, char** detailsP)
 {
-  const bson_t*  bsonP  = (const bson_t*) dataP;
-  char*          json;
-  KjNode*        treeP = NULL;
-
-#if 0
-  // FIXME: Real implementation - avoiding the extra step going via JSON
-#else
-  if ((json = bson_as_json(bsonP, NULL)) == NULL)
+  const bson_t*  bsonP = (const bson_t*) dataP;
+  bson_iter_t    iter;
+  KjNode*        treeP;
+
+  if (bson_iter_init(&iter, bsonP) == false)
   {
     *titleP   = (char*) "Internal Error";
-    *detailsP = (char*) "Error creating JSON from BSON";
+    *detailsP = (char*) "Error initializing BSON iterator";
+    return NULL;
   }
-  else
-  {
-    treeP = kjParse(orionldState.kjsonP, json);
-    if (treeP == NULL)
-    {
-      *titleP   = (char*) "Internal Error";
-      *detailsP = (char*) "Error parsing JSON output from bson_as_json";
-    }
 
-    //
-    // Cloning the tree, so that I can free the string 'json'
-    // FIXME: Not optimal for performance - would be better to delay the free to after the request and not clone the tree
-    //
-    treeP = kjClone(orionldState.kjsonP, treeP);
+  treeP = kjObject(orionldState.kjsonP, NULL);
+
+  if (kjTreeFromBsonIter(&iter, treeP, false, titleP, detailsP) == false)
+    return NULL;
 
-    bson_free(json);
-  }
-#endif
   return treeP;
 }
@@ -27,6 +27,8 @@
 */
 #include "rest/ConnectionInfo.h"
 
+#include "orionld/rest/OrionldRouteNode.h"                     // OrionldRouteNode
+
 
 
 // -----------------------------------------------------------------------------
@@ -51,9 +53,8 @@ typedef bool (*OrionldTroeRoutine)(void);
 //
 // This struct is a simplified OrionLdRestService.
 // To create an OrionLd service, all that is needed is the URL and the service routine.
-// In the initialization stage, the URL is parsed and data is taken out of it to make
-// the URL parse (service routine lookup) faster.
-// A lot faster actually, as string comparisons are avoided and instead integers are compared.
+// In the initialization stage, the URL is inserted in a radix trie (one per verb) that makes
+// the URL parse (service routine lookup) a single walk over the incoming URL path.
 //
 // The info extracted from this initialization stage, plus the url and service routine, is
 // stored in the "real" OrionLdRestService struct, which is used during lookup of URL->service-routine.
@@ -104,6 +105,7 @@ typedef struct OrionLdRestServiceSimplifiedVector
 #define ORIONLD_SERVICE_OPTION_CLONE_PAYLOAD                         (1 << 4)
 #define ORIONLD_SERVICE_OPTION_NO_CONTEXT_NEEDED                     (1 << 6)
 #define ORIONLD_SERVICE_OPTION_NO_CONTEXT_TYPE_CHECK                 (1 << 7)
+#define ORIONLD_SERVICE_OPTION_BATCH_GROUPS                          (1 << 8)
 
 
 
@@ -137,6 +139,7 @@ typedef struct OrionLdRestServiceSimplifiedVector
 #define ORIONLD_URIPARAM_SPACES               (1 << 23)
 #define ORIONLD_URIPARAM_SUBSCRIPTION_ID      (1 << 24)
 #define ORIONLD_URIPARAM_LOCATION             (1 << 25)
+#define ORIONLD_URIPARAM_LASTN                (1 << 26)
 #define ORIONLD_URIPARAM_URL                  (1 << 27)
 #define ORIONLD_URIPARAM_RELOAD               (1 << 28)
 #define ORIONLD_URIPARAM_NOTEXISTS            (1 << 29)
@@ -146,10 +149,7 @@ typedef struct OrionLdRestServiceSimplifiedVector
 //
 // OrionLdRestService -
 //
-// NOTE
-//   The initial string '/ngsi-ld/' doesn't count in the four charsBefore fields.
-//   That the URL starts with that string will be made sure before we get as far as to
-//   lookup a URL.
+// The URL path is looked up in the radix trie of the verb (OrionLdRestServiceVector::routeTree), not here.
 //
 typedef struct OrionLdRestService
 {
@@ -157,12 +157,6 @@ typedef struct OrionLdRestService
   OrionldServiceRoutine  serviceRoutine;                // Function pointer to service routine
   OrionldTroeRoutine     troeRoutine;                   // Function pointer to routines that saves temporal values
   int                    wildcards;                     // Number of wildcards in URL: 0, 1, or 2
-  int                    charsBeforeFirstWildcard;      // E.g. 9 for [/ngsi-ld/v1/]entities/*
-  int                    charsBeforeFirstWildcardSum;   // -"-  'e' + 'n' + 't' + 'i' + 't' + 'i' + 'e' + 's'
-  int                    charsBeforeSecondWildcard;     // E.g. 5 for [/ngsi-ld/v1]/entities/*/attrs/*
-  int                    charsBeforeSecondWildcardSum;  // -"- 'a' + 't' + 't' + 'r' + 's' - used to find start of wildcard no 2
-  char                   matchForSecondWildcard[16];    // E.g. "/attrs/" for [/ngsi-ld/v1]/entities/*/attrs/*
-  int                    matchForSecondWildcardLen;     // strlen of last path to match
   uint32_t               options;                       // Peculiarities of this type of requests (bitmask)
   uint32_t               uriParams;                     // Supported URI parameters (bitmask)
 } OrionLdRestService;
@@ -177,6 +171,7 @@ typedef struct OrionLdRestServiceVector
 {
   OrionLdRestService*  serviceV;
   int                  services;
+  OrionldRouteNode*    routeTree;  // Radix trie of the URL paths of the services (without the initial "/ngsi-ld/")
 } OrionLdRestServiceVector;
 
 #endif  // SRC_LIB_ORIONLD_REST_ORIONLDRESTSERVICE_H_
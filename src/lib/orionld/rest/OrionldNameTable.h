@@ -0,0 +1,69 @@
+#ifndef SRC_LIB_ORIONLD_REST_ORIONLDNAMETABLE_H_
+#define SRC_LIB_ORIONLD_REST_ORIONLDNAMETABLE_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                            // uint32_t
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldNameSetter - function that takes care of the value of a URI parameter or an HTTP header
+//
+// Returns false if the value is invalid - the error response is then already set.
+//
+typedef bool (*OrionldNameSetter)(const char* value);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldNameItem - a known name (URI parameter or HTTP header)
+//
+typedef struct OrionldNameItem
+{
+  const char*        name;
+  uint32_t           mask;    // ORIONLD_URIPARAM_* bit to set if the setter succeeds (0 for HTTP headers)
+  OrionldNameSetter  setter;
+} OrionldNameItem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldNameTable - perfect hash table of names
+//
+// The table is built once, at startup, by orionldNameTableBuild, which searches for a seed of the hash function
+// that puts every name in a slot of its own. A lookup is then one hash of the name and one strcmp.
+//
+typedef struct OrionldNameTable
+{
+  unsigned int       seed;    // Seed of the hash function
+  unsigned int       slots;   // Size of slotV - always a power of two
+  OrionldNameItem**  slotV;   // NULL for empty slots
+} OrionldNameTable;
+
+#endif  // SRC_LIB_ORIONLD_REST_ORIONLDNAMETABLE_H_
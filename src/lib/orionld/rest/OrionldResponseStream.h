@@ -0,0 +1,75 @@
+#ifndef SRC_LIB_ORIONLD_REST_ORIONLDRESPONSESTREAM_H_
+#define SRC_LIB_ORIONLD_REST_ORIONLDRESPONSESTREAM_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                            // size_t
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Streamed responses
+//
+//   With CLI option -streamChunkSize, an entity array response isn't rendered into a buffer of its own full size before
+//   it is sent. Instead, the items of the array are rendered, one chunk at a time, when MHD asks for more payload data
+//   to send (MHD_create_response_from_callback), and the response is sent using chunked transfer-encoding.
+//
+//   The chunk buffer is of fixed size (-streamChunkSize kilobytes) and it is reused for every chunk.
+//   It only grows if a single item of the array doesn't fit in it.
+//   What is saved is the render buffer of the size of the entire response, and its sizing pass, and the first bytes go
+//   out as soon as the first chunk is rendered.
+//   The memory of the response is NOT bounded, though - the array of entities to be rendered (orionldState.responseTree)
+//   is still entirely in memory, as built by the service routine from the complete result set of the query.
+//
+//   The array items live in the kalloc buffer of the request (and in buffers of orionldState.delayedFreeVec), that are
+//   released by requestCompleted, after the response is sent (see orionldState.responseStreamed).
+//   This only holds in thread-per-connection mode, so, responses are not streamed if -reqPoolSize or -httpWorkers is used.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldResponseStream -
+//
+typedef struct OrionldResponseStream
+{
+  KjNode*  nextItemP;  // Next item of the array to be rendered (NULL when all items have been rendered)
+  bool     started;    // The opening '[' has been rendered
+  bool     comma;      // An item has been rendered - the next one needs a comma in front of it
+  bool     ended;      // The closing ']' has been rendered
+  char*    buf;        // The chunk buffer
+  size_t   bufSize;    // Size of the chunk buffer
+  size_t   bufLen;     // Number of bytes rendered in the chunk buffer
+  size_t   bufIx;      // Number of bytes of the chunk buffer already handed over to MHD
+} OrionldResponseStream;
+
+#endif  // SRC_LIB_ORIONLD_REST_ORIONLDRESPONSESTREAM_H_
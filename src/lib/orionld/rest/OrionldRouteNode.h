@@ -0,0 +1,52 @@
+#ifndef SRC_LIB_ORIONLD_REST_ORIONLDROUTENODE_H_
+#define SRC_LIB_ORIONLD_REST_ORIONLDROUTENODE_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+struct OrionLdRestService;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldRouteNode - node in the radix trie of URL paths of one verb
+//
+// A node is either a literal node, with a non-empty label, or a wildcard node ('*' in the URL path
+// of the service), whose label is NULL.
+// The literal children of a node are kept in a linked list and start with different characters, so at most
+// one of them can match the continuation of an incoming URL path.
+// A node that ends the URL path of a service points to the service.
+//
+typedef struct OrionldRouteNode
+{
+  char*                       label;      // Literal characters of the node - NULL for wildcard nodes
+  int                         labelLen;   // strlen(label)
+  struct OrionldRouteNode*    literalP;   // First literal child
+  struct OrionldRouteNode*    nextP;      // Next sibling in the list of literal children of the parent
+  struct OrionldRouteNode*    wildcardP;  // Wildcard child
+  struct OrionLdRestService*  serviceP;   // Service whose URL path ends in this node
+} OrionldRouteNode;
+
+#endif  // SRC_LIB_ORIONLD_REST_ORIONLDROUTENODE_H_
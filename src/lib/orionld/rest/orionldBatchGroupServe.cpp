@@ -0,0 +1,400 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // snprintf
+
+extern "C"
+{
+#include "kbase/kMacros.h"                                     // K_VEC_SIZE
+#include "kalloc/kaStrdup.h"                                   // kaStrdup
+#include "kalloc/kaBufferInit.h"                               // kaBufferInit
+#include "kalloc/kaBufferReset.h"                              // kaBufferReset
+#include "kjson/KjNode.h"                                      // KjNode
+#include "kjson/kjBuilder.h"                                   // kjArray, kjObject, kjString, kjInteger, kjChildAdd
+#include "kjson/kjLookup.h"                                    // kjLookup
+#include "kjson/kjClone.h"                                     // kjClone
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+#include "orionld/common/orionldState.h"                       // orionldState, batchGroupSize
+#include "orionld/common/orionldErrorResponse.h"               // orionldErrorResponseCreate
+#include "orionld/common/numberToDate.h"                       // numberToDate
+#include "orionld/db/dbConfiguration.h"                        // dbGeoIndexCreate
+#include "orionld/db/dbGeoIndexLookup.h"                       // dbGeoIndexLookup
+#include "orionld/mongoc/mongocCatalogUpdate.h"                // mongocCatalogUpdate
+#include "orionld/types/OrionldBatchStream.h"                  // OrionldBatchStream
+#include "orionld/rest/OrionLdRestService.h"                   // OrionLdRestService
+#include "orionld/rest/orionldBatchGroupServe.h"               // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// arrayConcat - move all items of 'fromP' to the end of 'toP'
+//
+static void arrayConcat(KjNode* toP, KjNode* fromP)
+{
+  if (fromP == NULL)
+    return;
+
+  KjNode* itemP = fromP->value.firstChildP;
+
+  while (itemP != NULL)
+  {
+    KjNode* next = itemP->next;
+
+    kjChildAdd(toP, itemP);
+    itemP = next;
+  }
+
+  fromP->value.firstChildP = NULL;
+  fromP->lastChild         = NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringsCopy - copy all string values of a tree to the kalloc buffer of the request
+//
+// The entities of a group that is served while the payload is being read live in an allocation buffer of their own, that is
+// reset once the group has been served. The results of the group (built by the service routine in the kalloc buffer of the
+// request) may point to strings of the entities (e.g. the entity ids) and are kept until the response is sent.
+//
+static void stringsCopy(KjNode* nodeP)
+{
+  if (nodeP == NULL)
+    return;
+
+  if (nodeP->type == KjString)
+    nodeP->value.s = kaStrdup(&orionldState.kalloc, nodeP->value.s);
+  else if ((nodeP->type == KjObject) || (nodeP->type == KjArray))
+  {
+    for (KjNode* childP = nodeP->value.firstChildP; childP != NULL; childP = childP->next)
+      stringsCopy(childP);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupCut - cut the first 'size' entities off the array 'entityArrayP', into an array of their own
+//
+static KjNode* groupCut(KjNode* entityArrayP, int size)
+{
+  KjNode* groupP = kjArray(orionldState.kjsonP, NULL);
+  KjNode* lastP  = entityArrayP->value.firstChildP;
+
+  for (int ix = 1; (ix < size) && (lastP->next != NULL); ix++)
+    lastP = lastP->next;
+
+  groupP->value.firstChildP       = entityArrayP->value.firstChildP;
+  groupP->lastChild               = lastP;
+  entityArrayP->value.firstChildP = lastP->next;
+  lastP->next                     = NULL;
+
+  if (entityArrayP->value.firstChildP == NULL)
+    entityArrayP->lastChild = NULL;
+
+  return groupP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupEntityIds - the entity ids of a group, as { "id": "X" } items, like entitySuccessPush makes them
+//
+// A service routine that responds 204 gives no list of the entities that succeeded - it's all of them.
+// The ids are extracted (and copied) before the service routine is called, as it modifies the entities.
+//
+static KjNode* groupEntityIds(KjNode* groupP)
+{
+  KjNode* idArrayP = kjArray(orionldState.kjsonP, NULL);
+
+  for (KjNode* entityP = groupP->value.firstChildP; entityP != NULL; entityP = entityP->next)
+  {
+    KjNode* idP = kjLookup(entityP, "id");
+
+    if (idP == NULL)
+      idP = kjLookup(entityP, "@id");
+
+    if ((idP != NULL) && (idP->type == KjString))
+      kjChildAdd(idArrayP, kjString(orionldState.kjsonP, "id", kaStrdup(&orionldState.kalloc, idP->value.s)));
+  }
+
+  return idArrayP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupErrorsPush - one item in the "errors" array for each entity of a group, all with the same problem details
+//
+static void groupErrorsPush(KjNode* errorsArrayP, KjNode* idArrayP, const char* entityId, KjNode* problemP, int status)
+{
+  KjNode* idP = (idArrayP != NULL)? idArrayP->value.firstChildP : NULL;
+
+  while ((idP != NULL) || (entityId != NULL))
+  {
+    KjNode* itemP  = kjObject(orionldState.kjsonP, NULL);
+    KjNode* errorP = kjClone(orionldState.kjsonP, problemP);
+
+    errorP->name = (char*) "error";
+    if (kjLookup(errorP, "status") == NULL)
+      kjChildAdd(errorP, kjInteger(orionldState.kjsonP, "status", status));
+
+    kjChildAdd(itemP, kjString(orionldState.kjsonP, "entityId", (idP != NULL)? idP->value.s : entityId));
+    kjChildAdd(itemP, errorP);
+    kjChildAdd(errorsArrayP, itemP);
+
+    if (idP != NULL)
+      idP = idP->next;
+    else
+      entityId = NULL;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupServeFinish - what orionldMhdConnectionTreat does after the service routine, for one group
+//
+// The entity catalog and the geo-indexes are updated and the TRoE routine is called - group by group, as the entities of a
+// group may be released before the next group is served.
+//
+static void groupServeFinish(bool ok)
+{
+  if (orionldState.catalogDeltaP != NULL)
+  {
+    mongocCatalogUpdate(orionldState.tenantP, orionldState.catalogDeltaP);
+    orionldState.catalogDeltaP = NULL;
+  }
+
+  if (ok == false)
+    return;
+
+  for (int ix = 0; ix < orionldState.geoAttrs; ix++)
+  {
+    if (dbGeoIndexLookup(orionldState.tenantP->tenant, orionldState.geoAttrV[ix]->name) == NULL)
+      dbGeoIndexCreate(orionldState.tenantP, orionldState.geoAttrV[ix]->name);
+  }
+
+  if ((orionldState.serviceP->troeRoutine != NULL) && (orionldState.noDbUpdate == false))
+  {
+    if (orionldState.troeError == true)
+      LM_E(("Internal Error (something went wrong during TRoE processing)"));
+    else if ((orionldState.requestTree != NULL) && (orionldState.requestTree->value.firstChildP != NULL))
+    {
+      numberToDate(orionldState.requestTime, orionldState.requestTimeString, sizeof(orionldState.requestTimeString));
+      orionldState.serviceP->troeRoutine();
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupServe - call the service routine for one group and add its results to those of the previous groups
+//
+static void groupServe(ConnectionInfo* ciP, OrionldBatchStream* bsP, KjNode* groupP)
+{
+  KjNode* idArrayP = groupEntityIds(groupP);
+
+  orionldState.requestTree    = groupP;
+  orionldState.responseTree   = NULL;
+  orionldState.batchEntities  = NULL;
+  orionldState.duplicateArray = NULL;
+  orionldState.noDbUpdate     = false;
+  orionldState.troeError      = false;
+  orionldState.httpStatusCode = 200;
+
+  bool ok = orionldState.serviceP->serviceRoutine(ciP);
+
+  ++bsP->groups;
+
+  if (bsP->kallocBuffer != NULL)
+    stringsCopy(orionldState.responseTree);
+
+  if (ok == false)
+  {
+    //
+    // The entities of the group aren't in the database - the rest of the groups are served anyway.
+    // The error of the service routine is the error of every entity of the group.
+    //
+    LM_W(("BATCH operation failed for group %d (%d)", bsP->groups, orionldState.httpStatusCode));
+    if (orionldState.responseTree == NULL)
+      orionldErrorResponseCreate(OrionldInternalError, "Unknown Error", "The reason for this error is unknown");
+
+    groupErrorsPush(bsP->errorsP, idArrayP, NULL, orionldState.responseTree, (orionldState.httpStatusCode >= 400)? orionldState.httpStatusCode : 400);
+    bsP->notCreated = true;
+    bsP->notUpdated = true;
+  }
+  else if (orionldState.httpStatusCode == 201)  // All entities of the group created - array of entity ids
+  {
+    arrayConcat(bsP->successP, orionldState.responseTree);
+    bsP->notUpdated = true;
+  }
+  else if (orionldState.httpStatusCode == 204)  // All entities of the group updated - no payload body
+  {
+    arrayConcat(bsP->successP, idArrayP);
+    bsP->notCreated = true;
+  }
+  else  // 207 - the success and errors arrays of the group
+  {
+    arrayConcat(bsP->successP, kjLookup(orionldState.responseTree, "success"));
+    arrayConcat(bsP->errorsP,  kjLookup(orionldState.responseTree, "errors"));
+    bsP->notCreated = true;
+    bsP->notUpdated = true;
+  }
+
+  groupServeFinish(ok);
+
+  //
+  // Nothing of the group is kept - the geo-attributes point into the entities of the group
+  //
+  orionldState.geoAttrs       = 0;
+  orionldState.geoAttrMax     = K_VEC_SIZE(orionldState.geoAttr);
+  orionldState.geoAttrV       = orionldState.geoAttr;
+  orionldState.requestTree    = NULL;
+  orionldState.responseTree   = NULL;
+  orionldState.batchEntities  = NULL;
+  orionldState.duplicateArray = NULL;
+  orionldState.httpStatusCode = 200;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldBatchGroupServe -
+//
+// BATCH Create/Upsert/Update of many entities means one huge call to mongoUpdateContext, with all the entities converted into
+// mongoBackend's UpdateContextRequest at the same time.
+// With CLI option -batchGroupSize, the entity array is instead cut in groups of -batchGroupSize entities and the service routine
+// is called once per group. Each group is validated, expanded and written to the database (and to TRoE) before the next one
+// is started.
+//
+// This function is called:
+//   - by orionldBatchStreamFeed, for every group of entities, while the payload is still being read ('last' == false)
+//   - by orionldBatchStreamEnd, for the last group, once the payload has been read ('last' == true)
+//   - by orionldMhdConnectionTreat, with all the entities, if the payload wasn't parsed while being read ('last' == true)
+//
+// The entities of a group that has been read while the payload was arriving are released once the group has been served.
+//
+// The results of all groups are merged into one single response:
+//   - 201 if all groups responded 201 (all entities created)  - the entity ids as payload body
+//   - 204 if all groups responded 204 (all entities updated)  - no payload body
+//   - 207 otherwise, with the "success" and "errors" arrays of all groups
+// If the service routine fails for a group, the error goes to the "errors" array, for each entity of the group.
+// If the payload turns out to be broken once some groups have been written, the entities that have been read but not served,
+// and the rest of the payload, also go to the "errors" array.
+//
+// An entity that is present more than once in the batch is treated as in a batch of its own for every group it's in,
+// the groups being served in order.
+//
+bool orionldBatchGroupServe(ConnectionInfo* ciP, KjNode* entityArrayP, bool last)
+{
+  OrionldBatchStream* bsP = &orionldState.batchStream;
+
+  if ((entityArrayP == NULL) || (entityArrayP->type != KjArray))
+    return orionldState.serviceP->serviceRoutine(ciP);  // Let the service routine deal with the error
+
+  if (bsP->successP == NULL)
+  {
+    bsP->successP = kjArray(orionldState.kjsonP, "success");
+    bsP->errorsP  = kjArray(orionldState.kjsonP, "errors");
+  }
+
+  while (entityArrayP->value.firstChildP != NULL)
+  {
+    KjNode* groupP = groupCut(entityArrayP, batchGroupSize);
+
+    if (bsP->error == NULL)
+      groupServe(ciP, bsP, groupP);
+    else
+    {
+      orionldErrorResponseCreate(OrionldInvalidRequest, "JSON Parse Error", bsP->error);
+      groupErrorsPush(bsP->errorsP, groupEntityIds(groupP), NULL, orionldState.responseTree, 400);
+      orionldState.responseTree = NULL;
+    }
+
+    //
+    // Release the entities of the group, if read while the payload was arriving
+    //
+    if (bsP->kallocBuffer != NULL)
+    {
+      kaBufferReset(&bsP->kalloc, false);
+      kaBufferInit(&bsP->kalloc, bsP->kallocBuffer, BATCH_GROUP_KALLOC_SIZE, BATCH_GROUP_KALLOC_SIZE, NULL, "Batch group KAlloc buffer");
+    }
+  }
+
+  if (last == false)
+    return true;
+
+  if (bsP->error != NULL)  // The part of the payload that couldn't be parsed
+  {
+    char entity[64];
+
+    snprintf(entity, sizeof(entity), "entity %d of the payload", bsP->total + 1);
+    orionldErrorResponseCreate(OrionldInvalidRequest, "JSON Parse Error", bsP->error);
+    groupErrorsPush(bsP->errorsP, NULL, kaStrdup(&orionldState.kalloc, entity), orionldState.responseTree, 400);
+    bsP->notCreated = true;
+    bsP->notUpdated = true;
+  }
+
+  //
+  // The TRoE routine has been called for every group - orionldMhdConnectionTreat mustn't call it again
+  //
+  orionldState.requestTree   = NULL;
+  orionldState.batchEntities = NULL;
+
+  if ((bsP->errorsP->value.firstChildP == NULL) && (bsP->notCreated == false))
+  {
+    orionldState.httpStatusCode = 201;
+    orionldState.responseTree   = bsP->successP;
+  }
+  else if ((bsP->errorsP->value.firstChildP == NULL) && (bsP->notUpdated == false))
+  {
+    orionldState.httpStatusCode = 204;
+    orionldState.responseTree   = NULL;
+  }
+  else
+  {
+    orionldState.httpStatusCode = 207;
+    orionldState.responseTree   = kjObject(orionldState.kjsonP, NULL);
+
+    kjChildAdd(orionldState.responseTree, bsP->successP);
+    kjChildAdd(orionldState.responseTree, bsP->errorsP);
+  }
+
+  return true;
+}
@@ -0,0 +1,87 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/orionldErrorResponse.h"               // orionldErrorResponseCreate
+#include "orionld/types/OrionldBatchStream.h"                  // OrionldBatchStream
+#include "orionld/rest/orionldBatchGroupServe.h"               // orionldBatchGroupServe
+#include "orionld/rest/orionldBatchStreamRelease.h"            // orionldBatchStreamRelease
+#include "orionld/rest/orionldBatchStreamEnd.h"                // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldBatchStreamEnd -
+//
+// Called by orionldMhdConnectionTreat instead of the service routine - the payload has already been parsed, by
+// orionldBatchStreamFeed, and all complete groups of entities have been served.
+// The last group is served and the response is composed (orionldBatchGroupServe).
+//
+// The errors are the same as those of payloadParseAndExtractSpecialFields, as long as no group has been served.
+// Once entities have been written, a broken payload gives a 207 response, see orionldBatchGroupServe.
+//
+bool orionldBatchStreamEnd(ConnectionInfo* ciP)
+{
+  OrionldBatchStream* bsP = &orionldState.batchStream;
+  bool                ok  = false;
+
+  if ((bsP->started == false) && (bsP->error == NULL))
+  {
+    orionldErrorResponseCreate(OrionldInvalidRequest, "payload missing", NULL);
+    orionldState.httpStatusCode = 400;
+  }
+  else if (((bsP->error != NULL) || (bsP->ended == false)) && (bsP->groups == 0))
+  {
+    LM_W(("Bad Input (JSON Parse Error: %s)", (bsP->error != NULL)? bsP->error : "incomplete toplevel array"));
+    orionldErrorResponseCreate(OrionldInvalidRequest, "JSON Parse Error", (bsP->error != NULL)? bsP->error : "Incomplete toplevel array");
+    orionldState.httpStatusCode = 400;
+  }
+  else if (bsP->total == 0)
+  {
+    orionldErrorResponseCreate(OrionldInvalidRequest, "Invalid Payload Body", "Empty Array");
+    orionldState.httpStatusCode = 400;
+  }
+  else
+  {
+    if ((bsP->error == NULL) && (bsP->ended == false))
+      bsP->error = (char*) "Incomplete toplevel array";
+
+    ok = orionldBatchGroupServe(ciP, bsP->arrayP, true);
+  }
+
+  // The payload has been read and served in its entirety - the buffers are no longer needed
+  orionldBatchStreamRelease();
+
+  return ok;
+}
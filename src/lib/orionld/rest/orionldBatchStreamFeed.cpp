@@ -0,0 +1,271 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // memcpy, memmove
+#include <stdlib.h>                                            // malloc, realloc
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                     // KAlloc
+#include "kalloc/kaAlloc.h"                                    // kaAlloc
+#include "kalloc/kaStrdup.h"                                   // kaStrdup
+#include "kalloc/kaBufferInit.h"                               // kaBufferInit
+#include "kjson/KjNode.h"                                      // KjNode
+#include "kjson/kjBuilder.h"                                   // kjArray, kjChildAdd
+#include "kjson/kjParse.h"                                     // kjParse
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+#include "orionld/common/orionldState.h"                       // orionldState, batchGroupSize
+#include "orionld/types/OrionldBatchStream.h"                  // OrionldBatchStream
+#include "orionld/rest/orionldMhdConnectionTreat.h"            // orionldMhdConnectionPrepare
+#include "orionld/rest/orionldBatchGroupServe.h"               // orionldBatchGroupServe
+#include "orionld/rest/orionldBatchStreamFeed.h"               // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// kallocSwap - swap the allocation buffer of the request with the one of the group being read
+//
+// The allocation buffer of the request is orionldState.kalloc, and orionldState.kjsonP allocates from it.
+// With the two swapped, kjParse allocates the entity from the allocation buffer of the group.
+//
+static void kallocSwap(OrionldBatchStream* bsP)
+{
+  KAlloc kalloc = orionldState.kalloc;
+
+  orionldState.kalloc = bsP->kalloc;
+  bsP->kalloc         = kalloc;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityParse - parse the entity found in buf[start] to buf[end] and add it to the group being read
+//
+// The text of the entity is copied to the allocation buffer of the group before it is parsed, as kjParse parses in-place
+// and the strings of the resulting tree point into the text.
+// Both the text and the tree are released once the group has been served (orionldBatchGroupServe resets bsP->kalloc).
+//
+static void entityParse(OrionldBatchStream* bsP, int start, int end)
+{
+  if (bsP->kallocBuffer == NULL)
+  {
+    bsP->kallocBuffer = (char*) malloc(BATCH_GROUP_KALLOC_SIZE);
+    if (bsP->kallocBuffer == NULL)
+    {
+      LM_E(("Internal Error (unable to allocate %d bytes for the entities of a batch group)", BATCH_GROUP_KALLOC_SIZE));
+      bsP->error = (char*) "Out of memory";
+      return;
+    }
+
+    kaBufferInit(&bsP->kalloc, bsP->kallocBuffer, BATCH_GROUP_KALLOC_SIZE, BATCH_GROUP_KALLOC_SIZE, NULL, "Batch group KAlloc buffer");
+  }
+
+  int      len  = end - start + 1;
+  char*    text;
+  KjNode*  entityP;
+
+  kallocSwap(bsP);
+  text = kaAlloc(&orionldState.kalloc, len + 1);
+  memcpy(text, &bsP->buf[start], len);
+  text[len] = 0;
+  entityP = kjParse(orionldState.kjsonP, text);
+  kallocSwap(bsP);
+
+  if (entityP == NULL)
+  {
+    bsP->error = kaStrdup(&orionldState.kalloc, orionldState.kjsonP->errorString);
+    return;
+  }
+
+  kjChildAdd(bsP->arrayP, entityP);
+  ++bsP->entities;
+  ++bsP->total;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldBatchStreamFeed -
+//
+// Called by orionldMhdConnectionPayloadRead for every chunk of payload data that MHD delivers.
+//
+// On the first chunk, the request is checked (URI parameters, tenant, Accept header, @context) - all the HTTP headers have
+// been received by then.
+//
+// The toplevel array is scanned, keeping track of JSON strings and nesting level, to find where each entity starts and ends.
+// As soon as an entity has been read in its entirety, it is parsed and added to orionldState.batchStream.arrayP.
+// As soon as -batchGroupSize entities have been read, the group is served (validated, expanded and written to the database)
+// and released, while the rest of the payload is still arriving. The last group is served by orionldBatchStreamEnd.
+//
+// Only the entity that is being read is kept in the buffer - the buffer never grows beyond the size of the biggest entity
+// (plus the size of a chunk). The buffer is grown with realloc, not in the kalloc buffer of the request, so the replaced
+// buffers aren't kept until the end of the request. It is freed by orionldBatchStreamRelease.
+//
+// Errors are saved in orionldState.batchStream.error and reported by orionldBatchStreamEnd, once the payload has been read.
+// No more groups are served after an error.
+//
+void orionldBatchStreamFeed(ConnectionInfo* ciP, const char* data, int dataLen)
+{
+  OrionldBatchStream* bsP = &orionldState.batchStream;
+
+  if (bsP->prepared == false)
+  {
+    if (orionldMhdConnectionPrepare(ciP) == false)
+      return;  // The error response is ready - the payload is just eaten
+  }
+
+  if ((bsP->error != NULL) || (orionldState.httpStatusCode != 200))
+    return;  // The rest of the payload is just eaten
+
+  if (bsP->arrayP == NULL)
+    bsP->arrayP = kjArray(orionldState.kjsonP, NULL);
+
+  //
+  // Append the chunk to the buffer - reallocating a bigger buffer if needed
+  //
+  if (bsP->bufLen + dataLen + 1 > bsP->bufSize)
+  {
+    int   size = (2 * bsP->bufSize > bsP->bufLen + dataLen + 1)? 2 * bsP->bufSize : bsP->bufLen + dataLen + 1;
+    char* buf  = (char*) realloc(bsP->buf, size);
+
+    if (buf == NULL)
+    {
+      LM_E(("Internal Error (unable to allocate %d bytes for the batch payload)", size));
+      bsP->error = (char*) "Out of memory";
+      return;
+    }
+
+    bsP->buf     = buf;
+    bsP->bufSize = size;
+  }
+
+  memcpy(&bsP->buf[bsP->bufLen], data, dataLen);
+  bsP->bufLen += dataLen;
+
+  //
+  // Scan the new data
+  // An entity that is still being read always starts at buf[0] (see the end of this function)
+  //
+  int entityStart = (bsP->depth >= 2)? 0 : -1;
+
+  for (int ix = bsP->scanIx; ix < bsP->bufLen; ix++)
+  {
+    char c = bsP->buf[ix];
+
+    if (bsP->inString == true)
+    {
+      if (bsP->escaped == true)
+        bsP->escaped = false;
+      else if (c == '\\')
+        bsP->escaped = true;
+      else if (c == '"')
+        bsP->inString = false;
+
+      continue;
+    }
+
+    if (bsP->depth >= 2)  // Inside an entity
+    {
+      if (c == '"')
+        bsP->inString = true;
+      else if ((c == '{') || (c == '['))
+        ++bsP->depth;
+      else if ((c == '}') || (c == ']'))
+      {
+        --bsP->depth;
+
+        if (bsP->depth == 1)
+        {
+          entityParse(bsP, entityStart, ix);
+          if (bsP->error != NULL)
+            return;
+
+          if (bsP->entities >= batchGroupSize)
+          {
+            orionldBatchGroupServe(ciP, bsP->arrayP, false);
+            bsP->entities = 0;
+          }
+
+          entityStart      = -1;
+          bsP->afterEntity = true;
+        }
+      }
+
+      continue;
+    }
+
+    if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
+      continue;
+
+    if (bsP->depth == 0)  // Outside the toplevel array
+    {
+      if ((c != '[') || (bsP->started == true))
+      {
+        bsP->error = (char*) ((bsP->started == true)? "Unexpected data after the toplevel array" : "The payload data must be a JSON Array");
+        return;
+      }
+
+      bsP->started = true;
+      bsP->depth   = 1;
+    }
+    else if ((c == '{') && (bsP->afterEntity == false))  // Between entities - start of the next one
+    {
+      entityStart = ix;
+      bsP->depth  = 2;
+    }
+    else if ((c == ',') && (bsP->afterEntity == true))
+      bsP->afterEntity = false;
+    else if ((c == ']') && ((bsP->afterEntity == true) || (bsP->total == 0)))
+    {
+      bsP->depth = 0;
+      bsP->ended = true;
+    }
+    else
+    {
+      bsP->error = (char*) ((c == '{')? "Missing comma between entities" : "The items of the toplevel array must be JSON Objects");
+      return;
+    }
+  }
+
+  //
+  // Keep only the entity that is still being read, if any, moving it to the start of the buffer
+  //
+  if (entityStart == -1)
+    bsP->bufLen = 0;
+  else if (entityStart > 0)
+  {
+    memmove(bsP->buf, &bsP->buf[entityStart], bsP->bufLen - entityStart);
+    bsP->bufLen -= entityStart;
+  }
+
+  bsP->scanIx = bsP->bufLen;
+}
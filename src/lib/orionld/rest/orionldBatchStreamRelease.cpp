@@ -0,0 +1,61 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // free
+
+extern "C"
+{
+#include "kalloc/kaBufferReset.h"                              // kaBufferReset
+}
+
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/types/OrionldBatchStream.h"                  // OrionldBatchStream
+#include "orionld/rest/orionldBatchStreamRelease.h"            // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldBatchStreamRelease -
+//
+// Called by orionldBatchStreamEnd once the payload has been read and served, and by requestFinish, in case the request never
+// got that far (e.g. an aborted upload).
+//
+void orionldBatchStreamRelease(void)
+{
+  OrionldBatchStream* bsP = &orionldState.batchStream;
+
+  if (bsP->buf != NULL)
+  {
+    free(bsP->buf);
+    bsP->buf = NULL;
+  }
+
+  if (bsP->kallocBuffer != NULL)
+  {
+    kaBufferReset(&bsP->kalloc, false);
+    free(bsP->kallocBuffer);
+    bsP->kallocBuffer = NULL;
+  }
+}
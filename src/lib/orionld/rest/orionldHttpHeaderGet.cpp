@@ -0,0 +1,178 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <microhttpd.h>                                        // MHD
+
+extern "C"
+{
+#include "kbase/kMacros.h"                                     // K_VEC_SIZE
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "common/wsStrip.h"                                    // wsStrip
+#include "common/MimeType.h"                                   // MimeType
+#include "orionld/common/orionldErrorResponse.h"               // OrionldBadRequestData, ...
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/rest/OrionldNameTable.h"                     // OrionldNameTable, OrionldNameItem
+#include "orionld/rest/orionldNameTableBuild.h"                // orionldNameTableBuild
+#include "orionld/rest/orionldNameTableLookup.h"               // orionldNameTableLookup
+#include "orionld/rest/orionldHttpHeaderGet.h"                 // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contentTypeParse - from orionldMhdConnectionInit.cpp
+//
+extern MimeType contentTypeParse(const char* contentType, char** charsetP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// strSplit -
+//
+static int strSplit(char* s, char delimiter, char** outV, int outMaxItems)
+{
+  if (s == NULL)
+    return 0;
+
+  if (*s == 0)
+    return 0;
+
+  int   outIx = 0;
+  char* start = s;
+
+  //
+  // Loop over 's':
+  // - Search for the delimiter
+  // - zero-terminate
+  // - assign and
+  // - continue
+  //
+  while (*s != 0)
+  {
+    if (*s == delimiter)
+    {
+      *s = 0;
+      outV[outIx] = wsStrip(start);
+      start = &s[1];
+
+      // Check that the scope starts with a slash, etc ...
+      // if (scopeCheck(outV[outIx]) == false) ...
+
+      if (++outIx > outMaxItems)
+        return -1;
+    }
+
+    ++s;
+  }
+
+  outV[outIx] = wsStrip(start);
+
+  ++outIx;
+
+  return outIx;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// HTTP header setters
+//
+static bool attrsFormatSet(const char* value)  { orionldState.attrsFormat     = (char*) value;                 return true; }  // FIXME: This header name needs to change for NGSI-LD
+static bool xAuthTokenSet(const char* value)   { orionldState.xAuthToken      = (char*) value;                 return true; }
+static bool correlatorSet(const char* value)   { orionldState.correlator      = (char*) value;                 return true; }
+static bool contentTypeSet(const char* value)  { orionldState.in.contentType  = contentTypeParse(value, NULL);  return true; }
+
+static bool scopeSet(const char* value)
+{
+  orionldState.scopes = strSplit((char*) value, ',', orionldState.scopeV, K_VEC_SIZE(orionldState.scopeV));
+
+  if (orionldState.scopes == -1)
+  {
+    LM_W(("Bad Input (too many scopes)"));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for HTTP header /NGSILD-Scope/", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpHeaderV - the HTTP headers taken care of by orionldHttpHeaderGet
+//
+// Any other header is ignored here (most of them are taken care of by httpHeaderGet, in rest.cpp)
+//
+static OrionldNameItem httpHeaderV[] =
+{
+  { "NGSILD-Scope",       0, scopeSet       },
+  { "Ngsiv2-AttrsFormat", 0, attrsFormatSet },
+  { "X-Auth-Token",       0, xAuthTokenSet  },
+  { "Fiware-Correlator",  0, correlatorSet  },
+  { "Content-Type",       0, contentTypeSet }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpHeaderTable -
+//
+static OrionldNameTable httpHeaderTable;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldHttpHeaderInit -
+//
+void orionldHttpHeaderInit(void)
+{
+  if (orionldNameTableBuild(&httpHeaderTable, httpHeaderV, K_VEC_SIZE(httpHeaderV)) == false)
+    LM_X(1, ("Unable to build the perfect hash table for HTTP headers"));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldHttpHeaderGet -
+//
+MHD_Result orionldHttpHeaderGet(void* cbDataP, MHD_ValueKind kind, const char* key, const char* value)
+{
+  OrionldNameItem* itemP = orionldNameTableLookup(&httpHeaderTable, key);
+
+  if (itemP != NULL)
+    itemP->setter(value);
+
+  return MHD_YES;
+}
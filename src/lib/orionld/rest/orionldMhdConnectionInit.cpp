@@ -22,12 +22,11 @@
 *
 * Author: Ken Zangelin
 */
-#include <string.h>                                              // strlen
+#include <string.h>                                              // strlen, strcmp, strstr, bzero
 #include <microhttpd.h>                                          // MHD
 
 extern "C"
 {
-#include "kbase/kMacros.h"                                       // K_FT, K_VEC_SIZE
 #include "kbase/kTime.h"                                         // kTimeGet, kTimeDiff
 }
 
@@ -36,6 +35,7 @@ extern "C"
 
 #include "common/wsStrip.h"                                      // wsStrip
 #include "common/MimeType.h"                                     // mimeTypeParse
+#include "common/limits.h"                                       // BATCH_STREAM_PAYLOAD_MAX_SIZE
 #include "rest/Verb.h"                                           // Verb
 #include "rest/ConnectionInfo.h"                                 // ConnectionInfo
 #include "orionld/common/orionldErrorResponse.h"                 // OrionldBadRequestData, ...
@@ -43,11 +43,13 @@ extern "C"
 #include "orionld/common/performance.h"                          // REQUEST_PERFORMANCE
 #include "orionld/common/tenantList.h"                           // tenant0
 #include "orionld/serviceRoutines/orionldBadVerb.h"              // orionldBadVerb
-#include "orionld/payloadCheck/pcheckUri.h"                      // pcheckUri
 #include "orionld/rest/orionldServiceInit.h"                     // orionldRestServiceV
 #include "orionld/rest/orionldServiceLookup.h"                   // orionldServiceLookup
 #include "orionld/rest/temporaryErrorPayloads.h"                 // Temporary Error Payloads
 #include "orionld/rest/OrionLdRestService.h"                     // ORIONLD_URIPARAM_LIMIT, ...
+#include "orionld/rest/orionldUriArgumentGet.h"                  // orionldUriArgumentGet
+#include "orionld/rest/orionldHttpHeaderGet.h"                   // orionldHttpHeaderGet
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheReadBegin
 #include "orionld/rest/orionldMhdConnectionInit.h"               // Own interface
 
 
@@ -171,107 +173,6 @@ static void ipAddressAndPort(void)
 
 
 
-// -----------------------------------------------------------------------------
-//
-// optionsParse -
-//
-static void optionsParse(const char* options)
-{
-  char* optionStart = (char*) options;
-  char* cP          = (char*) options;
-
-  while (1)
-  {
-    if ((*cP == ',') || (*cP == 0))  // Found the end of an option
-    {
-      bool done  = (*cP == 0);
-      char saved = *cP;
-
-      *cP = 0;  // Zero-terminate
-
-      if      (strcmp(optionStart, "update")        == 0)  orionldState.uriParamOptions.update        = true;
-      else if (strcmp(optionStart, "replace")       == 0)  orionldState.uriParamOptions.replace       = true;
-      else if (strcmp(optionStart, "noOverwrite")   == 0)  orionldState.uriParamOptions.noOverwrite   = true;
-      else if (strcmp(optionStart, "keyValues")     == 0)  orionldState.uriParamOptions.keyValues     = true;
-      else if (strcmp(optionStart, "sysAttrs")      == 0)  orionldState.uriParamOptions.sysAttrs      = true;
-      else if (strcmp(optionStart, "append")        == 0)  orionldState.uriParamOptions.append        = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "count")         == 0)  orionldState.uriParams.count               = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "values")        == 0)  orionldState.uriParamOptions.values        = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "unique")        == 0)  orionldState.uriParamOptions.uniqueValues  = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "dateCreated")   == 0)  orionldState.uriParamOptions.dateCreated   = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "dateModified")  == 0)  orionldState.uriParamOptions.dateModified  = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "noAttrDetail")  == 0)  orionldState.uriParamOptions.noAttrDetail  = true;  // NGSIv2 compatibility
-      else if (strcmp(optionStart, "upsert")        == 0)  orionldState.uriParamOptions.upsert        = true;  // NGSIv2 compatibility
-      else
-      {
-        LM_W(("Unknown 'options' value: %s", optionStart));
-        orionldState.httpStatusCode = 400;
-        orionldErrorResponseCreate(OrionldBadRequestData, "Unknown value for 'options' URI parameter", optionStart);
-        return;
-      }
-
-      if (done == true)
-        break;
-
-      *cP = saved;
-      optionStart = &cP[1];
-    }
-
-    ++cP;
-  }
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// strSplit -
-//
-static int strSplit(char* s, char delimiter, char** outV, int outMaxItems)
-{
-  if (s == NULL)
-    return 0;
-
-  if (*s == 0)
-    return 0;
-
-  int   outIx = 0;
-  char* start = s;
-
-  //
-  // Loop over 's':
-  // - Search for the delimiter
-  // - zero-terminate
-  // - assign and
-  // - continue
-  //
-  while (*s != 0)
-  {
-    if (*s == delimiter)
-    {
-      *s = 0;
-      outV[outIx] = wsStrip(start);
-      start = &s[1];
-
-      // Check that the scope starts with a slash, etc ...
-      // if (scopeCheck(outV[outIx]) == false) ...
-
-      if (++outIx > outMaxItems)
-        return -1;
-    }
-
-    ++s;
-  }
-
-  outV[outIx] = wsStrip(start);
-
-  ++outIx;
-
-  return outIx;
-}
-
-
-
 /* ****************************************************************************
 *
 * contentTypeParse -
@@ -306,361 +207,6 @@ MimeType contentTypeParse(const char* contentType, char** charsetP)
 
 
 
-// -----------------------------------------------------------------------------
-//
-// orionldHttpHeaderGet -
-//
-static MHD_Result orionldHttpHeaderGet(void* cbDataP, MHD_ValueKind kind, const char* key, const char* value)
-{
-  LM_TMP(("KZ: Header '%s' = '%s', orionldState.httpStatusCode == %d", key, value, orionldState.httpStatusCode));
-  if (strcmp(key, "NGSILD-Scope") == 0)
-  {
-    orionldState.scopes = strSplit((char*) value, ',', orionldState.scopeV, K_VEC_SIZE(orionldState.scopeV));
-    if (orionldState.scopes == -1)
-    {
-      LM_W(("Bad Input (too many scopes)"));
-      orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for HTTP header /NGSILD-Scope/", value);
-      orionldState.httpStatusCode = 400;
-    }
-  }
-  else if (strcmp(key, "Ngsiv2-AttrsFormat") == 0)  // FIXME: This header name needs to change for NGSI-LD
-  {
-    orionldState.attrsFormat = (char*) value;
-  }
-  else if (strcmp(key, "X-Auth-Token") == 0)
-  {
-    orionldState.xAuthToken = (char*) value;
-  }
-  else if (strcmp(key, "Fiware-Correlator") == 0)
-  {
-    orionldState.correlator = (char*) value;
-  }
-  else if (strcmp(key, "Content-Type") == 0)
-  {
-    orionldState.in.contentType = contentTypeParse(value, NULL);
-  }
-  LM_TMP(("KZ: Header '%s' = '%s', orionldState.httpStatusCode == %d", key, value, orionldState.httpStatusCode));
-
-  return MHD_YES;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// orionldUriArgumentGet -
-//
-MHD_Result orionldUriArgumentGet(void* cbDataP, MHD_ValueKind kind, const char* key, const char* value)
-{
-  LM_TMP(("KZ: key: '%s', value: '%s'", key, value));
-  if ((value == NULL) || (*value == 0))
-  {
-    char errorString[256];
-
-    LM_TMP(("KZ: Setting  orionldState.httpStatusCode  to 400"));
-    snprintf(errorString, sizeof(errorString) - 1, "Empty right-hand-side for URI param /%s/", key);
-    orionldErrorResponseCreate(OrionldBadRequestData, "Error in URI param", errorString);
-    orionldState.httpStatusCode = 400;
-
-    return MHD_YES;
-  }
-
-  if (strcmp(key, "id") == 0)
-  {
-    orionldState.uriParams.id = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_IDLIST;
-  }
-  else if (strcmp(key, "type") == 0)
-  {
-    orionldState.uriParams.type = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_TYPELIST;
-  }
-  else if (strcmp(key, "typePattern") == 0)
-  {
-    orionldState.uriParams.typePattern = (char*) value;
-  }
-  else if (strcmp(key, "idPattern") == 0)
-  {
-    orionldState.uriParams.idPattern = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_IDPATTERN;
-  }
-  else if (strcmp(key, "attrs") == 0)
-  {
-    orionldState.uriParams.attrs = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_ATTRS;
-  }
-  else if (strcmp(key, "offset") == 0)
-  {
-    if (value[0] == '-')
-    {
-      LM_W(("Bad Input (negative value for /offset/ URI param)"));
-      orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /offset/", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.offset = atoi(value);
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_OFFSET;
-  }
-  else if (strcmp(key, "limit") == 0)
-  {
-    if (value[0] == '-')
-    {
-      LM_W(("Bad Input (negative value for /limit/ URI param)"));
-      orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /limit/", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.limit = atoi(value);
-
-    if (orionldState.uriParams.limit > 1000)
-    {
-      LM_W(("Bad Input (too big value for /limit/ URI param: %d - max allowed is 1000)", orionldState.uriParams.limit));
-      orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /limit/ (valid range: 0-1000)", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_LIMIT;
-  }
-  else if (strcmp(key, "options") == 0)
-  {
-    orionldState.uriParams.options = (char*) value;
-    optionsParse(value);
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_OPTIONS;
-  }
-  else if (strcmp(key, "geometry") == 0)
-  {
-    orionldState.uriParams.geometry = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_GEOMETRY;
-  }
-  else if (strcmp(key, "coordinates") == 0)
-  {
-    orionldState.uriParams.coordinates = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_COORDINATES;
-  }
-  else if (strcmp(key, "coords") == 0)  // Only NGSIv1/v2
-  {
-    orionldState.uriParams.coordinates = (char*) value;
-  }
-  else if (strcmp(key, "georel") == 0)
-  {
-    orionldState.uriParams.georel = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_GEOREL;
-  }
-  else if (strcmp(key, "geoproperty") == 0)
-  {
-    orionldState.uriParams.geoproperty = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_GEOPROPERTY;
-  }
-  else if (strcmp(key, "geometryProperty") == 0)
-  {
-    orionldState.uriParams.geometryProperty = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_GEOMETRYPROPERTY;
-  }
-  else if (strcmp(key, "count") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.count = true;
-    else if (strcmp(value, "false") != 0)
-    {
-      LM_W(("Bad Input (invalid value for URI parameter 'count': %s)", value));
-      orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /count/", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_COUNT;
-  }
-  else if (strcmp(key, "q") == 0)
-  {
-    orionldState.uriParams.q = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_Q;
-  }
-  else if (strcmp(key, "mq") == 0)
-  {
-    orionldState.uriParams.mq = (char*) value;
-  }
-  else if (strcmp(key, "datasetId") == 0)
-  {
-    char* detail;
-
-    if (pcheckUri((char*) value, true, &detail) == false)
-    {
-      orionldErrorResponseCreate(OrionldBadRequestData, "Not a URI", value);  // FIXME: Include 'detail' and name (datasetId)
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.datasetId = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_DATASETID;
-  }
-  else if (strcmp(key, "deleteAll") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.deleteAll = true;
-    else if (strcmp(value, "false") == 0)
-      orionldState.uriParams.deleteAll = false;
-    else
-    {
-      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for uri parameter 'deleteAll'", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_DELETEALL;
-  }
-  else if (strcmp(key, "timeproperty") == 0)
-  {
-    orionldState.uriParams.timeproperty = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_TIMEPROPERTY;
-  }
-  else if (strcmp(key, "timerel") == 0)
-  {
-    // FIXME: Check the value of timerel
-    orionldState.uriParams.timerel = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_TIMEREL;
-  }
-  else if (strcmp(key, "timeAt") == 0)
-  {
-    // FIXME: Check the value
-    orionldState.uriParams.timeAt = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_TIMEAT;
-  }
-  else if (strcmp(key, "endTimeAt") == 0)
-  {
-    // FIXME: Check the value
-    orionldState.uriParams.endTimeAt = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_ENDTIMEAT;
-  }
-  else if (strcmp(key, "details") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.details = true;
-    else if (strcmp(value, "false") == 0)
-      orionldState.uriParams.details = false;
-    else if (strcmp(value, "on") == 0)
-      orionldState.uriParams.details = true;
-    else
-    {
-      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for uri parameter 'details'", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_DETAILS;
-  }
-  else if (strcmp(key, "prettyPrint") == 0)
-  {
-    if (strcmp(value, "yes") == 0)
-      orionldState.uriParams.prettyPrint = true;
-    else if (strcmp(value, "no") == 0)
-      orionldState.uriParams.prettyPrint = false;
-    else
-    {
-      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for uri parameter 'prettyPrint'", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_PRETTYPRINT;
-  }
-  else if (strcmp(key, "spaces") == 0)
-  {
-    orionldState.uriParams.spaces = atoi(value);
-    orionldState.uriParams.mask  |= ORIONLD_URIPARAM_SPACES;
-  }
-  else if (strcmp(key, "subscriptionId") == 0)
-  {
-    orionldState.uriParams.subscriptionId  = (char*) value;
-    orionldState.uriParams.mask           |= ORIONLD_URIPARAM_SUBSCRIPTION_ID;
-  }
-  else if (strcmp(key, "location") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.location = true;
-    else if (strcmp(value, "false") == 0)
-      orionldState.uriParams.location = false;
-    else
-    {
-      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for uri parameter 'location'", value);
-      orionldState.httpStatusCode = 400;
-      return MHD_YES;
-    }
-
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_LOCATION;
-  }
-  else if (strcmp(key, "url") == 0)
-  {
-    orionldState.uriParams.url   = (char*) value;
-    orionldState.uriParams.mask |= ORIONLD_URIPARAM_URL;
-  }
-  else if (strcmp(key, "reload") == 0)
-  {
-    orionldState.uriParams.reload = true;
-    orionldState.uriParams.mask  |= ORIONLD_URIPARAM_RELOAD;
-  }
-  else if (strcmp(key, "exist") == 0)
-  {
-    orionldState.uriParams.exists = (char*) value;
-  }
-  else if (strcmp(key, "!exist") == 0)
-  {
-    orionldState.uriParams.notExists = (char*) value;
-    orionldState.uriParams.mask  |= ORIONLD_URIPARAM_NOTEXISTS;
-  }
-  else if (strcmp(key, "metadata") == 0)
-  {
-    orionldState.uriParams.metadata = (char*) value;
-  }
-  else if (strcmp(key, "orderBy") == 0)
-  {
-    orionldState.uriParams.orderBy = (char*) value;
-  }
-  else if (strcmp(key, "collapse") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.collapse = true;
-  }
-  //
-  // FIXME: attributeFormat AND attributesFormat ???
-  //
-  else if (strcmp(key, "attributeFormat") == 0)
-  {
-    orionldState.uriParams.attributeFormat = (char*) value;
-  }
-  else if (strcmp(key, "attributesFormat") == 0)
-  {
-    orionldState.uriParams.attributeFormat = (char*) value;
-  }
-  else if (strcmp(key, "reset") == 0)
-  {
-    if (strcmp(value, "true") == 0)
-      orionldState.uriParams.reset = true;
-  }
-  else if (strcmp(key, "level") == 0)
-  {
-    orionldState.uriParams.level = (char*) value;
-  }
-  else if (strcmp(key, "entity::type") == 0)
-  {
-    orionldState.uriParams.type = (char*) value;
-  }
-  else
-  {
-    LM_W(("Bad Input (unknown URI parameter: '%s')", key));
-    orionldState.httpStatusCode = 400;
-    orionldErrorResponseCreate(OrionldBadRequestData, "Unknown URI parameter", key);
-    return MHD_YES;
-  }
-
-  return MHD_YES;
-}
-
-
-
 // -----------------------------------------------------------------------------
 //
 // serviceLookup - lookup the Service
@@ -741,8 +287,9 @@ MHD_Result orionldMhdConnectionInit
 
   //
   // 1. Prepare connectionInfo
+  //    With request workers, the ConnectionInfo has already been created by the event loop (orionldRequestWorkerConnectionInit)
   //
-  ConnectionInfo* ciP = new ConnectionInfo();
+  ConnectionInfo* ciP = (*con_cls != NULL)? (ConnectionInfo*) *con_cls : new ConnectionInfo();
 
   // Remember ciP for consequent connection callbacks from MHD
   *con_cls = ciP;
@@ -754,6 +301,13 @@ MHD_Result orionldMhdConnectionInit
   orionldState.ciP         = ciP;
   orionldState.httpVersion = (char*) version;
 
+  //
+  // The contexts that the request gets from the context cache must not be freed until the request has finished
+  // The read section ends in requestFinish
+  //
+  orionldState.contextCachePhase   = orionldContextCacheReadBegin();
+  orionldState.contextCacheReading = true;
+
   LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
   // IP Address and port of caller
   ipAddressAndPort();
@@ -908,8 +462,26 @@ MHD_Result orionldMhdConnectionInit
   }
 
   LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
+  //
+  // The payload of BATCH Create/Upsert/Update is parsed while being read, entity by entity, if so requested (-batchGroupSize).
+  // Not with request workers, as then the payload is read by an event loop, that reads many requests at a time.
+  //
+  if ((batchGroupSize > 0) && ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_BATCH_GROUPS) != 0) && (httpWorkers == 0))
+  {
+    bzero(&orionldState.batchStream, sizeof(orionldState.batchStream));  // Not reset by orionldStateInit
+    orionldState.batchStream.active = true;
+  }
+
   // Check payload too big
-  if (ciP->httpHeaders.contentLength > 2000000)
+  // Batch payloads that are served while being read are never kept in memory - only the group of entities being read
+  if ((orionldState.batchStream.active == true) && (ciP->httpHeaders.contentLength > BATCH_STREAM_PAYLOAD_MAX_SIZE))
+  {
+    orionldState.batchStream.active = false;
+    orionldState.responsePayload    = (char*) payloadTooLargePayload;
+    orionldState.httpStatusCode     = 400;
+    return MHD_YES;
+  }
+  else if ((orionldState.batchStream.active == false) && (ciP->httpHeaders.contentLength > 2000000))
   {
     orionldState.responsePayload = (char*) payloadTooLargePayload;
     orionldState.httpStatusCode  = 400;
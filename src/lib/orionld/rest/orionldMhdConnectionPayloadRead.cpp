@@ -32,7 +32,9 @@ extern "C"
 
 #include "rest/ConnectionInfo.h"                               // ConnectionInfo
 
-#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/orionldState.h"                       // orionldState, httpWorkers
+#include "orionld/common/orionldArenaAlloc.h"                  // orionldArenaAlloc
+#include "orionld/rest/orionldBatchStreamFeed.h"               // orionldBatchStreamFeed
 #include "orionld/rest/orionldMhdConnectionPayloadRead.h"      // Own interface
 
 
@@ -58,6 +60,16 @@ MHD_Result orionldMhdConnectionPayloadRead
 {
   size_t  dataLen = *upload_data_size;
 
+  //
+  // BATCH payloads with -batchGroupSize are parsed and served while being read - the payload isn't kept
+  //
+  if (orionldState.batchStream.active == true)
+  {
+    orionldBatchStreamFeed(ciP, upload_data, dataLen);
+    *upload_data_size = 0;
+    return MHD_YES;
+  }
+
   //
   // If the HTTP header says the request is bigger than our PAYLOAD_MAX_SIZE,
   // just silently "eat" the entire message.
@@ -87,16 +99,32 @@ MHD_Result orionldMhdConnectionPayloadRead
   // FIXME P1: This could be done in "Part I" instead, saving an "if" for each "Part II" call
   //           Once we *really* look to scratch some efficiency, this change should be made.
   //
+  // With request workers, the payload is read by an event loop that reads many requests at a time - static_buffer can't be used,
+  // and neither can the arena of the thread, as the payload is released by the request worker.
+  // Otherwise, a payload too big for static_buffer is taken from the arena of the thread, and released at the end of the request.
+  //
   if (ciP->payloadSize == 0)  // First call with payload
   {
-    if (ciP->httpHeaders.contentLength > STATIC_BUFFER_SIZE)
+    if (httpWorkers > 0)
+    {
+      size_t size = (ciP->httpHeaders.contentLength > STATIC_BUFFER_SIZE)? ciP->httpHeaders.contentLength : STATIC_BUFFER_SIZE;
+
+      ciP->payload = (char*) malloc(size + 1);
+      if (ciP->payload == NULL)
+      {
+        LM_E(("Out of memory!!!"));
+        return MHD_NO;
+      }
+    }
+    else if (ciP->httpHeaders.contentLength > STATIC_BUFFER_SIZE)
     {
-      ciP->payload = (char*) malloc(ciP->httpHeaders.contentLength + 1);
+      ciP->payload = orionldArenaAlloc(ciP->httpHeaders.contentLength + 1);
       if (ciP->payload == NULL)
       {
         LM_E(("Out of memory!!!"));
         return MHD_NO;
       }
+      ciP->payloadInArena = true;
     }
     else
       ciP->payload = static_buffer;
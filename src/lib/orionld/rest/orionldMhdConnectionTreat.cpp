@@ -64,8 +64,10 @@ extern "C"
 #include "orionld/common/numberToDate.h"                         // numberToDate
 #include "orionld/common/performance.h"                          // PERFORMANCE
 #include "orionld/common/tenantList.h"                           // tenant0
+#include "orionld/common/orionldArenaAlloc.h"                    // orionldArenaAlloc
 #include "orionld/db/dbConfiguration.h"                          // dbGeoIndexCreate
 #include "orionld/db/dbGeoIndexLookup.h"                         // dbGeoIndexLookup
+#include "orionld/mongoc/mongocCatalogUpdate.h"                  // mongocCatalogUpdate
 #include "orionld/kjTree/kjGeojsonEntityTransform.h"             // kjGeojsonEntityTransform
 #include "orionld/kjTree/kjGeojsonEntitiesTransform.h"           // kjGeojsonEntitiesTransform
 #include "orionld/payloadCheck/pcheckName.h"                     // pcheckName
@@ -79,6 +81,9 @@ extern "C"
 #include "orionld/rest/OrionLdRestService.h"                     // ORIONLD_URIPARAM_LIMIT, ...
 #include "orionld/rest/uriParamName.h"                           // uriParamName
 #include "orionld/rest/temporaryErrorPayloads.h"                 // Temporary Error Payloads
+#include "orionld/rest/orionldResponseStreamReply.h"             // orionldResponseStreamReply
+#include "orionld/rest/orionldBatchStreamEnd.h"                  // orionldBatchStreamEnd
+#include "orionld/rest/orionldBatchGroupServe.h"                 // orionldBatchGroupServe
 #include "orionld/rest/orionldMhdConnectionTreat.h"              // Own Interface
 
 
@@ -648,62 +653,10 @@ bool uriParamSupport(uint32_t supported, uint32_t given, char** detailP)
 
 // -----------------------------------------------------------------------------
 //
-// orionldMhdConnectionTreat -
-//
-// The @context is completely taken care of here in this function.
-// Service routines will only use the @context for lookups, everything else is done here, once and for all
+// uriParamsAndTenantCheck - the checks of the request that come before the payload
 //
-// What does this function do?
-//
-//   First of all, this is a callback function, it is called by MHD (libmicrohttpd) when MHD has received an entire
-//   request, with HTTP Headers, URI parameters and ALL the payload.
-//
-//   Actually, that is not entirely true. The callback function for MHD is set to 'connectionTreat', from lib/rest/rest.cpp,
-//   and 'connectionTreat' has been programmer to call this function when the entire request has been read.
-//
-//
-//   01. Check for predected error
-//   02. Look up the Service
-//   03. Check for empty payload for POST/PATCH/PUT
-//   04. Parse the payload
-//   05. Check for empty payload ( {}, [] )
-//   06. Lookup "@context" member, remove it from the request tree - same with "entity::id" and "entity::type" if the request type needs it
-//       - orionldState.payloadContextTree    (KjNode*)
-//       - orionldState.payloadEntityIdTree   (KjNode*)
-//       - orionldState.payloadEntityTypeTree (KjNode*)
-//   07. Check for HTTP Link header
-//   08. Make sure Context-Type is consistent with HTTP Link Header and Payload Context
-//   09. Make sure @context member is valid
-//   10. Check the Accept header and decide output MIME-type
-//   11. Make sure the HTTP Header "Link" is valid
-//   12. Check the @context in HTTP Header
-//   13. if (Link):     orionldState.contextP = orionldContextFromUrl()
-//   14. if (@context): orionldState.contextP orionldContextFromTree()
-//   15. if (@context != SimpleString): Create OrionldContext with 13|14
-//   16. if (@context != SimpleString): Insert context in context cache
-//   17. Call the SERVICE ROUTINE
-//   18. If the service routine failed (returned FALSE), but no HTTP status ERROR code is set, the HTTP status code defaults to 400
-//   19. Check for existing responseTree, in case of httpStatusCode >= 400 (except for 405)
-//   20. If (orionldState.acceptNgsild): Add orionldState.payloadContextTree to orionldState.responseTree
-//   21. If (orionldState.acceptNgsi):   Set HTTP Header "Link" to orionldState.contextP->url
-//   22. Render response tree
-//   23. IF accept == app/json, add the Link HTTP header
-//   24. REPLY
-//   25. Cleanup
-//   26. DONE
-//
-MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
+static bool uriParamsAndTenantCheck(void)
 {
-  bool     contextToBeCashed    = false;
-  bool     serviceRoutineResult = false;
-
-  LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
-  //
-  // Predetected Error from orionldMhdConnectionInit?
-  //
-  if (orionldState.httpStatusCode != 200)
-    goto respond;
-
   //
   // Any URI param given but not supported?
   //
@@ -713,7 +666,7 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
     LM_W(("Bad Input (unsupported URI parameter: %s)", detail));
     orionldErrorResponseCreate(OrionldBadRequestData, "Unsupported URI parameter", detail);
     orionldState.httpStatusCode = 400;
-    goto respond;
+    return false;
   }
 
   //
@@ -742,7 +695,7 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
           LM_W(("Bad Input (non-existing tenant: '%s')", orionldState.tenantName));
           orionldErrorResponseCreate(OrionldNonExistingTenant, "No such tenant", orionldState.tenantName);
           orionldState.httpStatusCode = 404;
-          goto respond;
+          return false;
         }
         else
         {
@@ -757,45 +710,27 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
   else
     orionldState.tenantP = &tenant0;  // No tenant give - default tenant used
 
-  //
-  // 03. Check for empty payload for POST/PATCH/PUT
-  //
-  if (((orionldState.verb == POST) || (orionldState.verb == PATCH) || (orionldState.verb == PUT)) && (payloadEmptyCheck(ciP) == false))
-    goto respond;
-
-
-  //
-  // Save a copy of the incoming payload before it is destroyed during kjParse AND
-  // parse the payload, and check for empty payload, also, find @context in payload and check it's OK
-  //
-  if (ciP->payload != NULL)
-  {
-    if ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_CLONE_PAYLOAD) == 0)
-      orionldState.requestPayload = ciP->payload;
-    else
-      orionldState.requestPayload = kaStrdup(&orionldState.kalloc, ciP->payload);
+  return true;
+}
 
-    if (payloadParseAndExtractSpecialFields(ciP, &contextToBeCashed) == false)
-      goto respond;
-  }
 
-  //
-  // 05. Check the Content-Type
-  //
-  if ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_NO_CONTEXT_TYPE_CHECK) == 0)
-  {
-    if (contentTypeCheck(ciP) == false)
-      goto respond;
-  }
 
+// -----------------------------------------------------------------------------
+//
+// contextCheck - the Accept header and the @context of the request (Link header or inline context)
+//
+// Sets orionldState.contextP and orionldState.link
+//
+static bool contextCheck(ConnectionInfo* ciP)
+{
   //
-  // 06. Check the Accept header and ...
+  // Check the Accept header and ...
   //
   if (acceptHeaderExtractAndCheck(ciP) == false)
-    goto respond;
+    return false;
 
   //
-  // 07. Check the @context in HTTP Header, if present
+  // Check the @context in HTTP Header, if present
   //
   // NOTE: orionldState.link is set by httpHeaderGet() in rest.cpp, called by orionldMhdConnectionInit()
   //
@@ -804,7 +739,7 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
   if ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_NO_CONTEXT_NEEDED) == 0)
   {
     if ((orionldState.linkHttpHeaderPresent == true) && (linkHeaderCheck(ciP) == false))
-      goto respond;
+      return false;
 
     //
     // Treat inline context
@@ -830,8 +765,7 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
         LM_W(("Bad Input (invalid context - %s: %s)", pd.title, pd.detail));
         orionldErrorResponseFromProblemDetails(&pd);
         orionldState.httpStatusCode = (HttpStatusCode) pd.status;
-
-        goto respond;
+        return false;
       }
 
       if (pd.status == 200)  // got an array with only Core Context
@@ -842,8 +776,7 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
         LM_W(("Bad Input? (%s: %s (type == %d, status = %d))", pd.title, pd.detail, pd.type, pd.status));
         orionldErrorResponseFromProblemDetails(&pd);
         orionldState.httpStatusCode = (HttpStatusCode) pd.status;
-
-        goto respond;
+        return false;
       }
     }
   }
@@ -853,6 +786,142 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
 
   orionldState.link = orionldState.contextP->url;
 
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldMhdConnectionPrepare - everything that orionldMhdConnectionTreat does before calling the service routine, except the payload
+//
+// For BATCH payloads that are served while being read (-batchGroupSize), orionldBatchStreamFeed calls this function on the
+// first chunk of payload, as the service routine is called before the entire payload has been read.
+// All the HTTP headers have been received at that point - MHD delivers them before the first chunk of payload.
+// The toplevel of a BATCH payload is an array - there is no inline context and no Content-Type check to be done.
+//
+bool orionldMhdConnectionPrepare(ConnectionInfo* ciP)
+{
+  orionldState.batchStream.prepared = true;
+
+  if (uriParamsAndTenantCheck() == false)
+    return false;
+
+  return contextCheck(ciP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldMhdConnectionTreat -
+//
+// The @context is completely taken care of here in this function.
+// Service routines will only use the @context for lookups, everything else is done here, once and for all
+//
+// What does this function do?
+//
+//   First of all, this is a callback function, it is called by MHD (libmicrohttpd) when MHD has received an entire
+//   request, with HTTP Headers, URI parameters and ALL the payload.
+//
+//   Actually, that is not entirely true. The callback function for MHD is set to 'connectionTreat', from lib/rest/rest.cpp,
+//   and 'connectionTreat' has been programmer to call this function when the entire request has been read.
+//
+//
+//   01. Check for predected error
+//   02. Look up the Service
+//   03. Check for empty payload for POST/PATCH/PUT
+//   04. Parse the payload
+//   05. Check for empty payload ( {}, [] )
+//   06. Lookup "@context" member, remove it from the request tree - same with "entity::id" and "entity::type" if the request type needs it
+//       - orionldState.payloadContextTree    (KjNode*)
+//       - orionldState.payloadEntityIdTree   (KjNode*)
+//       - orionldState.payloadEntityTypeTree (KjNode*)
+//   07. Check for HTTP Link header
+//   08. Make sure Context-Type is consistent with HTTP Link Header and Payload Context
+//   09. Make sure @context member is valid
+//   10. Check the Accept header and decide output MIME-type
+//   11. Make sure the HTTP Header "Link" is valid
+//   12. Check the @context in HTTP Header
+//   13. if (Link):     orionldState.contextP = orionldContextFromUrl()
+//   14. if (@context): orionldState.contextP orionldContextFromTree()
+//   15. if (@context != SimpleString): Create OrionldContext with 13|14
+//   16. if (@context != SimpleString): Insert context in context cache
+//   17. Call the SERVICE ROUTINE
+//   18. If the service routine failed (returned FALSE), but no HTTP status ERROR code is set, the HTTP status code defaults to 400
+//   19. Check for existing responseTree, in case of httpStatusCode >= 400 (except for 405)
+//   20. If (orionldState.acceptNgsild): Add orionldState.payloadContextTree to orionldState.responseTree
+//   21. If (orionldState.acceptNgsi):   Set HTTP Header "Link" to orionldState.contextP->url
+//   22. Render response tree
+//   23. IF accept == app/json, add the Link HTTP header
+//   24. REPLY
+//   25. Cleanup
+//   26. DONE
+//
+MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
+{
+  bool     contextToBeCashed    = false;
+  bool     serviceRoutineResult = false;
+
+  LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
+  //
+  // Predetected Error from orionldMhdConnectionInit?
+  //
+  if (orionldState.httpStatusCode != 200)
+    goto respond;
+
+  //
+  // A BATCH payload that is served while being read (-batchGroupSize) has been prepared by orionldBatchStreamFeed already,
+  // unless there was no payload at all.
+  // The payload has been parsed (and ciP->payload is NULL) - orionldBatchStreamEnd takes care of the payload errors.
+  //
+  if (orionldState.batchStream.active == true)
+  {
+    if ((orionldState.batchStream.prepared == false) && (orionldMhdConnectionPrepare(ciP) == false))
+      goto respond;
+  }
+  else
+  {
+    if (uriParamsAndTenantCheck() == false)
+      goto respond;
+
+    //
+    // 03. Check for empty payload for POST/PATCH/PUT
+    //
+    if (((orionldState.verb == POST) || (orionldState.verb == PATCH) || (orionldState.verb == PUT)) && (payloadEmptyCheck(ciP) == false))
+      goto respond;
+
+    //
+    // Save a copy of the incoming payload before it is destroyed during kjParse AND
+    // parse the payload, and check for empty payload, also, find @context in payload and check it's OK
+    //
+    if (ciP->payload != NULL)
+    {
+      if ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_CLONE_PAYLOAD) == 0)
+        orionldState.requestPayload = ciP->payload;
+      else
+        orionldState.requestPayload = kaStrdup(&orionldState.kalloc, ciP->payload);
+
+      if (payloadParseAndExtractSpecialFields(ciP, &contextToBeCashed) == false)
+        goto respond;
+    }
+
+    //
+    // 05. Check the Content-Type
+    //
+    if ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_NO_CONTEXT_TYPE_CHECK) == 0)
+    {
+      if (contentTypeCheck(ciP) == false)
+        goto respond;
+    }
+
+    //
+    // 06. Check the Accept header and the @context (HTTP Header or payload)
+    //
+    if (contextCheck(ciP) == false)
+      goto respond;
+  }
+
 
   // -----------------------------------------------------------------------------
   //
@@ -860,10 +929,25 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
   //
   PERFORMANCE(serviceRoutineStart);
   LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
-  serviceRoutineResult = orionldState.serviceP->serviceRoutine(ciP);
+  if (orionldState.batchStream.active == true)
+    serviceRoutineResult = orionldBatchStreamEnd(ciP);  // Serves the last group of entities
+  else if ((batchGroupSize > 0) && ((orionldState.serviceP->options & ORIONLD_SERVICE_OPTION_BATCH_GROUPS) != 0))
+    serviceRoutineResult = orionldBatchGroupServe(ciP, orionldState.requestTree, true);
+  else
+    serviceRoutineResult = orionldState.serviceP->serviceRoutine(ciP);
   LM_TMP(("KZ: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
   PERFORMANCE(serviceRoutineEnd);
 
+  //
+  // The entity catalog is updated before responding, so that a GET /types right after the response includes the changes.
+  // Also if the service routine failed - it may have written part of the entities of a batch operation.
+  //
+  if (orionldState.catalogDeltaP != NULL)
+  {
+    mongocCatalogUpdate(orionldState.tenantP, orionldState.catalogDeltaP);
+    orionldState.catalogDeltaP = NULL;
+  }
+
   //
   // If the service routine failed (returned FALSE), but no HTTP status ERROR code is set,
   // the HTTP status code defaults to 400
@@ -945,6 +1029,8 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
   //
   // Is there a KJSON response tree to render?
   //
+  bool streamed = false;
+
   if (orionldState.responseTree != NULL)
   {
     //
@@ -980,49 +1066,68 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
 
 
     //
-    // Smart allocation of the response buffer
-    //
-    // If there is room in the current kalloc biffer (no extra malloc needed), then use it.
-    // If not, then it's better to do a separate call to malloc, as:
-    //   - the rest of the kalloc buffer isn't thrown away
-    //   - the entire logic of kalloc is avoided (not much, but still ...)
+    // Non-empty entity arrays are streamed if so requested (CLI option -streamChunkSize).
+    // Rendered chunk by chunk while being sent, instead of into one buffer of the size of the entire response.
     //
-    unsigned int responsePayloadSize;
-
-    if (orionldState.uriParams.prettyPrint == false)
-      responsePayloadSize = kjFastRenderSize(orionldState.responseTree);
-    else
-      responsePayloadSize = kjRenderSize(orionldState.kjsonP, orionldState.responseTree);
-
-    if (responsePayloadSize < orionldState.kalloc.bytesLeft + 8)
-      orionldState.responsePayload = kaAlloc(&orionldState.kalloc, responsePayloadSize);
+    if ((streamChunkSize > 0)                                   &&
+        (orionldState.httpStatusCode == 200)                    &&
+        (orionldState.uriParams.prettyPrint == false)           &&
+        (orionldState.responseTree->type == KjArray)            &&
+        (orionldState.responseTree->value.firstChildP != NULL)  &&
+        (orionldResponseStreamReply(ciP, orionldState.responseTree) == true))
+    {
+      streamed                      = true;
+      orionldState.responseStreamed = true;
+    }
     else
     {
-      orionldState.responsePayload = (char*) malloc(responsePayloadSize);
+      //
+      // Smart allocation of the response buffer
+      //
+      // If there is room in the current kalloc biffer (no extra malloc needed), then use it.
+      // If not, then it's better to take it from the arena of the thread, as:
+      //   - the rest of the kalloc buffer isn't thrown away
+      //   - the entire logic of kalloc is avoided (not much, but still ...)
+      //   - the arena may have a buffer of the right size kept from a previous request (no malloc at all)
+      //
+      unsigned int responsePayloadSize;
+
+      if (orionldState.uriParams.prettyPrint == false)
+        responsePayloadSize = kjFastRenderSize(orionldState.responseTree);
+      else
+        responsePayloadSize = kjRenderSize(orionldState.kjsonP, orionldState.responseTree);
 
-      if (orionldState.responsePayload == NULL)
+      if (responsePayloadSize < orionldState.kalloc.bytesLeft + 8)
+        orionldState.responsePayload = kaAlloc(&orionldState.kalloc, responsePayloadSize);
+      else
       {
-        LM_E(("Out of memory"));
-        orionldState.responsePayload = (char*) "{ \"error\": \"Out of memory\"}";
+        orionldState.responsePayload = orionldArenaAlloc(responsePayloadSize);
+
+        if (orionldState.responsePayload == NULL)
+        {
+          LM_E(("Out of memory"));
+          orionldState.responsePayload = (char*) "{ \"error\": \"Out of memory\"}";
+        }
       }
+
+      if (orionldState.uriParams.prettyPrint == false)
+        kjFastRender(orionldState.responseTree, orionldState.responsePayload);
       else
-        orionldStateDelayedFreeEnqueue(orionldState.responsePayload);
+        kjRender(orionldState.kjsonP, orionldState.responseTree, orionldState.responsePayload, responsePayloadSize);
     }
 
-    if (orionldState.uriParams.prettyPrint == false)
-      kjFastRender(orionldState.responseTree, orionldState.responsePayload);
-    else
-      kjRender(orionldState.kjsonP, orionldState.responseTree, orionldState.responsePayload, responsePayloadSize);
-
     PERFORMANCE(renderEnd);
   }
 
   PERFORMANCE(restReplyStart);
 
-  if (orionldState.responsePayload != NULL)
-    restReply(ciP, orionldState.responsePayload);    // orionldState.responsePayload freed and NULLed by restReply()
-  else
-    restReply(ciP, "");
+  if (streamed == false)  // A streamed response has already been queued, by orionldResponseStreamReply
+  {
+    if (orionldState.responsePayload != NULL)
+      restReply(ciP, orionldState.responsePayload);    // orionldState.responsePayload freed and NULLed by restReply()
+    else
+      restReply(ciP, "");
+  }
 
   PERFORMANCE(restReplyEnd);
 
@@ -1061,8 +1166,11 @@ MHD_Result orionldMhdConnectionTreat(ConnectionInfo* ciP)
 
   //
   // Cleanup
+  // A streamed response is rendered as it is sent - after this function returns - so, for streamed responses,
+  // the request state is released by requestCompleted instead
   //
-  orionldStateRelease();
+  if (streamed == false)
+    orionldStateRelease();
 
   PERFORMANCE(requestPartEnd);
 
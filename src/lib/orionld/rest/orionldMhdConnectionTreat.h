@@ -29,6 +29,14 @@
 
 
 
+/* ****************************************************************************
+*
+* orionldMhdConnectionPrepare - the checks of orionldMhdConnectionTreat that need no payload
+*/
+extern bool orionldMhdConnectionPrepare(ConnectionInfo* ciP);
+
+
+
 /* ****************************************************************************
 *
 * orionldMhdConnectionTreat - 
@@ -0,0 +1,50 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/rest/orionldNameHash.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldNameHash -
+//
+// The seed is mixed into the offset basis of FNV-1a, and the high bits are folded into the low bits at the end,
+// as only the low bits are used for the slot index.
+//
+unsigned int orionldNameHash(const char* name, unsigned int seed, unsigned int slots)
+{
+  unsigned int hash = 2166136261U ^ (seed * 16777619U);
+
+  while (*name != 0)
+  {
+    hash ^= (unsigned char) *name;
+    hash *= 16777619U;
+    ++name;
+  }
+
+  hash ^= hash >> 16;
+
+  return hash & (slots - 1);
+}
@@ -0,0 +1,118 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // calloc, free
+#include <string.h>                                            // strcmp, bzero
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/rest/OrionldNameTable.h"                     // OrionldNameTable, OrionldNameItem
+#include "orionld/rest/orionldNameHash.h"                      // orionldNameHash
+#include "orionld/rest/orionldNameTableBuild.h"                // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NAME_TABLE_SEEDS      - number of seeds tried for each size of the table
+// NAME_TABLE_SLOTS_MAX  - max size of the table
+//
+#define NAME_TABLE_SEEDS      4096
+#define NAME_TABLE_SLOTS_MAX  4096
+
+
+
+// -----------------------------------------------------------------------------
+//
+// seedTry - place all items in the slots, using 'seed' - false on the first collision
+//
+static bool seedTry(OrionldNameItem** slotV, unsigned int slots, unsigned int seed, OrionldNameItem* itemV, int items)
+{
+  bzero(slotV, slots * sizeof(OrionldNameItem*));
+
+  for (int ix = 0; ix < items; ix++)
+  {
+    unsigned int slot = orionldNameHash(itemV[ix].name, seed, slots);
+
+    if (slotV[slot] != NULL)
+      return false;
+
+    slotV[slot] = &itemV[ix];
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldNameTableBuild -
+//
+// Starting with a table twice the number of items (rounded up to a power of two), a number of seeds are tried.
+// If none of them gives a perfect hash, the size of the table is doubled.
+// For the fifty-odd URI parameters, a table of 256 or 512 slots is normally found after a few hundred tries.
+//
+bool orionldNameTableBuild(OrionldNameTable* tableP, OrionldNameItem* itemV, int items)
+{
+  unsigned int slots = 1;
+
+  while (slots < (unsigned int) (2 * items))
+    slots <<= 1;
+
+  for (int ix = 0; ix < items; ix++)
+  {
+    for (int ix2 = ix + 1; ix2 < items; ix2++)
+    {
+      if (strcmp(itemV[ix].name, itemV[ix2].name) == 0)
+        LM_RE(false, ("Internal Error (duplicated name in perfect hash table: '%s')", itemV[ix].name));
+    }
+  }
+
+  for (; slots <= NAME_TABLE_SLOTS_MAX; slots <<= 1)
+  {
+    OrionldNameItem** slotV = (OrionldNameItem**) calloc(slots, sizeof(OrionldNameItem*));
+
+    if (slotV == NULL)
+      LM_RE(false, ("Out of memory (allocating a perfect hash table of %d slots)", slots));
+
+    for (unsigned int seed = 0; seed < NAME_TABLE_SEEDS; seed++)
+    {
+      if (seedTry(slotV, slots, seed, itemV, items) == true)
+      {
+        tableP->seed  = seed;
+        tableP->slots = slots;
+        tableP->slotV = slotV;
+
+        LM_T(LmtUriParams, ("Perfect hash table for %d names: %d slots, seed %d", items, slots, seed));
+        return true;
+      }
+    }
+
+    free(slotV);
+  }
+
+  LM_RE(false, ("Internal Error (no perfect hash found for %d names)", items));
+}
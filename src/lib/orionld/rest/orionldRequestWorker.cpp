@@ -0,0 +1,111 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                           // pthread_*
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "rest/mhd.h"                                          // MHD_resume_connection
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+#include "rest/rest.h"                                         // requestFinish
+
+#include "orionld/rest/orionldMhdConnectionInit.h"             // orionldMhdConnectionInit
+#include "orionld/rest/orionldMhdConnectionTreat.h"            // orionldMhdConnectionTreat
+#include "orionld/rest/orionldRequestWorker.h"                 // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Request worker state
+//
+pthread_mutex_t              orionldRequestWorkerMutex   = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t               orionldRequestWorkerCond    = PTHREAD_COND_INITIALIZER;
+ConnectionInfo*              orionldRequestQueueFirst    = NULL;
+ConnectionInfo*              orionldRequestQueueLast     = NULL;
+OrionldRequestWorkerMetrics  orionldRequestWorkerMetrics;
+pthread_t*                   orionldRequestWorkerThreadV = NULL;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestServe -
+//
+// The connection is suspended, so the request is all ours, until the connection is resumed.
+// After that, MHD may call requestCompleted for the connection any time, but MHD no longer has a reference to ciP
+// (its con_cls was NULLed when the request was handed over to the workers), so ciP is still all ours.
+// The response has already been copied by MHD (restReply), so ciP and the request state can be released in parallel
+// with MHD sending the response.
+//
+static void requestServe(ConnectionInfo* ciP)
+{
+  MHD_Connection*  connection = ciP->connection;
+  void*            conCls     = ciP;
+
+  orionldMhdConnectionInit(connection, ciP->url, ciP->method, ciP->version, &conCls);
+  orionldMhdConnectionTreat(ciP);  // The response is queued (restReply)
+
+  MHD_resume_connection(connection);
+
+  requestFinish(ciP);  // Notifications, statistics and cleanup - ciP is deleted
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRequestWorker -
+//
+void* orionldRequestWorker(void* vP)
+{
+  while (1)
+  {
+    pthread_mutex_lock(&orionldRequestWorkerMutex);
+
+    while (orionldRequestQueueFirst == NULL)
+      pthread_cond_wait(&orionldRequestWorkerCond, &orionldRequestWorkerMutex);
+
+    ConnectionInfo* ciP = orionldRequestQueueFirst;
+
+    orionldRequestQueueFirst = ciP->workerNextP;
+    if (orionldRequestQueueFirst == NULL)
+      orionldRequestQueueLast = NULL;
+
+    orionldRequestWorkerMetrics.queued -= 1;
+    orionldRequestWorkerMetrics.busy   += 1;
+
+    pthread_mutex_unlock(&orionldRequestWorkerMutex);
+
+    requestServe(ciP);
+
+    pthread_mutex_lock(&orionldRequestWorkerMutex);
+    orionldRequestWorkerMetrics.requests += 1;
+    orionldRequestWorkerMetrics.busy     -= 1;
+    pthread_mutex_unlock(&orionldRequestWorkerMutex);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef SRC_LIB_ORIONLD_REST_ORIONLDREQUESTWORKER_H_
+#define SRC_LIB_ORIONLD_REST_ORIONLDREQUESTWORKER_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                           // pthread_t, pthread_mutex_t, pthread_cond_t
+
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Request Workers
+//
+//   With request workers (CLI option -httpWorkers), the REST interface runs a number of epoll event loops (-httpLoops)
+//   that read the requests, and a fixed pool of request worker threads that serve them.
+//
+//   An event loop reads a request and suspends its connection (MHD_suspend_connection). The request is then queued for the workers.
+//   A worker serves it (orionldMhdConnectionInit + orionldMhdConnectionTreat) with its own orionldState, that stays warm from one
+//   request to the next, queues the response and resumes the connection, for the event loop to send the response.
+//   Last, the worker does what requestCompleted does in thread-per-connection mode (notifications, statistics, cleanup).
+//
+//   NGSIv2 requests are not handed over to the workers, they are served by the event loops, just like with -reqPoolSize.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldRequestWorkerMetrics -
+//
+typedef struct OrionldRequestWorkerMetrics
+{
+  unsigned long long  requests;   // Requests served by the workers
+  long long           queued;     // Requests waiting for a worker right now
+  long long           maxQueued;  // Max of queued
+  long long           busy;       // Workers serving a request right now
+} OrionldRequestWorkerMetrics;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Request worker state - all protected by orionldRequestWorkerMutex
+//
+extern pthread_mutex_t              orionldRequestWorkerMutex;
+extern pthread_cond_t               orionldRequestWorkerCond;   // Signaled when a request is queued
+extern ConnectionInfo*              orionldRequestQueueFirst;
+extern ConnectionInfo*              orionldRequestQueueLast;
+extern OrionldRequestWorkerMetrics  orionldRequestWorkerMetrics;
+extern pthread_t*                   orionldRequestWorkerThreadV;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRequestWorker - the request worker thread
+//
+extern void* orionldRequestWorker(void* vP);
+
+#endif  // SRC_LIB_ORIONLD_REST_ORIONLDREQUESTWORKER_H_
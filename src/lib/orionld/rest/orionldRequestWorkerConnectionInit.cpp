@@ -0,0 +1,67 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // atoi
+
+#include "rest/mhd.h"                                          // MHD_lookup_connection_value
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+
+#include "orionld/rest/orionldRequestWorkerConnectionInit.h"   // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRequestWorkerConnectionInit -
+//
+// The event loop only creates the ConnectionInfo - all the rest of orionldMhdConnectionInit is done by the request worker.
+// Nothing of orionldState is touched here, as the event loop thread reads many requests at a time.
+//
+// The payload is read before the request is handed over, so orionldMhdConnectionPayloadRead needs the Content-Length already.
+//
+MHD_Result orionldRequestWorkerConnectionInit
+(
+  MHD_Connection*  connection,
+  const char*      url,
+  const char*      method,
+  const char*      version,
+  void**           con_cls
+)
+{
+  ConnectionInfo* ciP = new ConnectionInfo();
+
+  ciP->connection = connection;
+  ciP->url        = url;
+  ciP->method     = method;
+  ciP->version    = version;
+
+  const char* contentLength = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Content-Length");
+
+  if (contentLength != NULL)
+    ciP->httpHeaders.contentLength = atoi(contentLength);
+
+  *con_cls = ciP;
+
+  return MHD_YES;
+}
@@ -0,0 +1,69 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                           // pthread_*
+
+#include "rest/mhd.h"                                          // MHD_suspend_connection
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+
+#include "orionld/rest/orionldRequestWorker.h"                 // orionldRequestWorkerMutex, orionldRequestQueueFirst, ...
+#include "orionld/rest/orionldRequestWorkerEnqueue.h"          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRequestWorkerEnqueue -
+//
+// The entire request has been read by the event loop.
+// The connection is suspended until the request worker has queued the response.
+//
+// From here on, ciP belongs to the request worker - it may even be deleted before this function returns.
+// The caller has already NULLed the con_cls of MHD, so MHD (requestCompleted) never touches ciP again.
+// The request worker always queues a response (restReply) before resuming the connection, so MHD doesn't call
+// the access handler for this request again.
+//
+MHD_Result orionldRequestWorkerEnqueue(ConnectionInfo* ciP)
+{
+  ciP->workerNextP = NULL;
+
+  MHD_suspend_connection(ciP->connection);
+
+  pthread_mutex_lock(&orionldRequestWorkerMutex);
+
+  if (orionldRequestQueueLast == NULL)
+    orionldRequestQueueFirst = ciP;
+  else
+    orionldRequestQueueLast->workerNextP = ciP;
+  orionldRequestQueueLast = ciP;
+
+  orionldRequestWorkerMetrics.queued += 1;
+  if (orionldRequestWorkerMetrics.queued > orionldRequestWorkerMetrics.maxQueued)
+    orionldRequestWorkerMetrics.maxQueued = orionldRequestWorkerMetrics.queued;
+
+  pthread_cond_signal(&orionldRequestWorkerCond);
+  pthread_mutex_unlock(&orionldRequestWorkerMutex);
+
+  return MHD_YES;
+}
@@ -0,0 +1,190 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // malloc, realloc, free
+#include <string.h>                                            // memcpy, strlen
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+#include "kjson/kjRender.h"                                    // kjFastRender
+#include "kjson/kjRenderSize.h"                                // kjFastRenderSize
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "rest/ConnectionInfo.h"                               // ConnectionInfo
+#include "rest/mhd.h"                                          // MHD_CONTENT_READER_END_OF_STREAM, ...
+#include "rest/restReply.h"                                    // restReplyStream
+#include "orionld/common/orionldState.h"                       // streamChunkSize
+#include "orionld/rest/OrionldResponseStream.h"                // OrionldResponseStream
+#include "orionld/rest/orionldResponseStreamReply.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// streamFill - render the next chunk of the array into the chunk buffer
+//
+// As many items as fit are rendered into the chunk buffer.
+// An item that doesn't fit in an empty chunk buffer makes the buffer grow, to the size of that item.
+//
+static bool streamFill(OrionldResponseStream* sP)
+{
+  sP->bufLen = 0;
+  sP->bufIx  = 0;
+
+  if (sP->started == false)
+  {
+    sP->buf[sP->bufLen++] = '[';
+    sP->started           = true;
+  }
+
+  while (sP->nextItemP != NULL)
+  {
+    KjNode* itemP    = sP->nextItemP;
+    size_t  itemSize = kjFastRenderSize(itemP) + 2;  // Room for the comma before the item and the zero-termination after it
+
+    if (sP->bufLen + itemSize > sP->bufSize)
+    {
+      if (sP->bufLen > 0)
+        return true;  // The chunk is full - the item goes in the next one
+
+      char* buf = (char*) realloc(sP->buf, itemSize);
+
+      if (buf == NULL)
+      {
+        LM_E(("Out of memory (unable to grow the response chunk buffer to %d bytes)", (int) itemSize));
+        return false;
+      }
+
+      sP->buf     = buf;
+      sP->bufSize = itemSize;
+    }
+
+    if (sP->comma == true)
+      sP->buf[sP->bufLen++] = ',';
+
+    kjFastRender(itemP, &sP->buf[sP->bufLen]);
+    sP->bufLen   += strlen(&sP->buf[sP->bufLen]);
+    sP->nextItemP = itemP->next;
+    sP->comma     = true;
+  }
+
+  if (sP->bufLen < sP->bufSize)
+  {
+    sP->buf[sP->bufLen++] = ']';
+    sP->ended             = true;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// streamRead - MHD_ContentReaderCallback, called by MHD when it's ready to send more of the response
+//
+static ssize_t streamRead(void* cls, uint64_t pos, char* buf, size_t max)
+{
+  OrionldResponseStream* sP      = (OrionldResponseStream*) cls;
+  size_t                 written = 0;
+
+  while (written < max)
+  {
+    if (sP->bufIx == sP->bufLen)
+    {
+      if (sP->ended == true)
+        break;
+
+      if (streamFill(sP) == false)
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+
+    size_t bytes = sP->bufLen - sP->bufIx;
+
+    if (bytes > max - written)
+      bytes = max - written;
+
+    memcpy(&buf[written], &sP->buf[sP->bufIx], bytes);
+    written   += bytes;
+    sP->bufIx += bytes;
+  }
+
+  if (written == 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  return written;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// streamRelease - MHD_ContentReaderFreeCallback, called by MHD when the response is destroyed
+//
+static void streamRelease(void* cls)
+{
+  OrionldResponseStream* sP = (OrionldResponseStream*) cls;
+
+  free(sP->buf);
+  free(sP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldResponseStreamReply -
+//
+// The response is queued right away - nothing is rendered until MHD asks for the first chunk.
+// If false is returned, nothing has been queued and the response must be sent the normal way (restReply).
+//
+bool orionldResponseStreamReply(ConnectionInfo* ciP, KjNode* arrayP)
+{
+  OrionldResponseStream* sP = (OrionldResponseStream*) calloc(1, sizeof(OrionldResponseStream));
+
+  if (sP == NULL)
+    return false;
+
+  sP->bufSize   = streamChunkSize * 1024;
+  sP->buf       = (char*) malloc(sP->bufSize);
+  sP->nextItemP = arrayP->value.firstChildP;
+
+  if (sP->buf == NULL)
+  {
+    free(sP);
+    return false;
+  }
+
+  if (restReplyStream(ciP, sP->bufSize, streamRead, sP, streamRelease) == false)
+  {
+    streamRelease(sP);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,147 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // calloc
+#include <string.h>                                            // strndup
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/rest/OrionldRouteNode.h"                     // OrionldRouteNode
+#include "orionld/rest/orionldRouteInsert.h"                   // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// routeNodeCreate -
+//
+static OrionldRouteNode* routeNodeCreate(const char* label, int labelLen)
+{
+  OrionldRouteNode* nodeP = (OrionldRouteNode*) calloc(1, sizeof(OrionldRouteNode));
+
+  if (nodeP == NULL)
+    LM_X(1, ("Out of memory (allocating a node for the URL path trie)"));
+
+  if (label != NULL)
+  {
+    nodeP->label    = strndup(label, labelLen);
+    nodeP->labelLen = labelLen;
+
+    if (nodeP->label == NULL)
+      LM_X(1, ("Out of memory (allocating the label of a node for the URL path trie)"));
+  }
+
+  return nodeP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// routeNodeSplit - split the label of a literal node in two, after 'len' characters
+//
+// The node keeps the first part of the label, a new (and only) child gets the rest of the label,
+// along with all children and the service of the node.
+//
+static void routeNodeSplit(OrionldRouteNode* nodeP, int len)
+{
+  OrionldRouteNode* tailP = routeNodeCreate(&nodeP->label[len], nodeP->labelLen - len);
+
+  tailP->literalP  = nodeP->literalP;
+  tailP->wildcardP = nodeP->wildcardP;
+  tailP->serviceP  = nodeP->serviceP;
+
+  nodeP->literalP  = tailP;
+  nodeP->wildcardP = NULL;
+  nodeP->serviceP  = NULL;
+
+  nodeP->label[len] = 0;
+  nodeP->labelLen   = len;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRouteInsert -
+//
+// Every '*' in the path becomes a wildcard node, and every piece of path in between becomes one or more literal nodes.
+// Two consecutive wildcards ("**") are not supported.
+//
+void orionldRouteInsert(OrionldRouteNode** rootPP, const char* path, struct OrionLdRestService* serviceP)
+{
+  if (*rootPP == NULL)
+    *rootPP = routeNodeCreate("", 0);
+
+  OrionldRouteNode* nodeP = *rootPP;
+
+  while (*path != 0)
+  {
+    if (*path == '*')
+    {
+      if (nodeP->wildcardP == NULL)
+        nodeP->wildcardP = routeNodeCreate(NULL, 0);
+
+      nodeP = nodeP->wildcardP;
+      ++path;
+      continue;
+    }
+
+    // The literal piece of the path, up to the next wildcard
+    int len = 0;
+    while ((path[len] != 0) && (path[len] != '*'))
+      ++len;
+
+    // Look up the literal child that starts with the same character
+    OrionldRouteNode* childP = nodeP->literalP;
+    while ((childP != NULL) && (childP->label[0] != *path))
+      childP = childP->nextP;
+
+    if (childP == NULL)
+    {
+      childP          = routeNodeCreate(path, len);
+      childP->nextP   = nodeP->literalP;
+      nodeP->literalP = childP;
+
+      nodeP  = childP;
+      path  += len;
+      continue;
+    }
+
+    // Length of the common prefix of the piece of path and the label of the child
+    int common = 1;
+    while ((common < len) && (common < childP->labelLen) && (path[common] == childP->label[common]))
+      ++common;
+
+    if (common < childP->labelLen)
+      routeNodeSplit(childP, common);
+
+    nodeP  = childP;
+    path  += common;
+  }
+
+  if (nodeP->serviceP == NULL)
+    nodeP->serviceP = serviceP;
+}
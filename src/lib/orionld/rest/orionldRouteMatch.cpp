@@ -0,0 +1,237 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strchr
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/rest/OrionldRouteNode.h"                     // OrionldRouteNode
+#include "orionld/rest/orionldRouteMatch.h"                    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ROUTE_CAPTURES_MAX - max number of wildcards in the URL path of a service
+//
+#define ROUTE_CAPTURES_MAX 8
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RouteCapture - the part of the incoming URL path that matched a wildcard
+//
+// 'end' points to the character after the wildcard, NULL if the wildcard ends the URL path.
+//
+typedef struct RouteCapture
+{
+  char* start;
+  char* end;
+} RouteCapture;
+
+
+
+static struct OrionLdRestService* childrenMatch(OrionldRouteNode* nodeP, char* path, RouteCapture* captureV, int captureIx, int* capturesP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// literalChild - the literal child of a node that starts with the character 'c'
+//
+static inline OrionldRouteNode* literalChild(OrionldRouteNode* nodeP, char c)
+{
+  for (OrionldRouteNode* childP = nodeP->literalP; childP != NULL; childP = childP->nextP)
+  {
+    if (childP->label[0] == c)
+      return childP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// labelMatch - does the path start with the label of the node?
+//
+// The first character has already been matched by literalChild. Labels are short, an inline loop is faster than strncmp.
+// A path that is shorter than the label fails on its terminating zero.
+//
+static inline bool labelMatch(OrionldRouteNode* nodeP, const char* path)
+{
+  for (int ix = 1; ix < nodeP->labelLen; ix++)
+  {
+    if (path[ix] != nodeP->label[ix])
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wildcardMatch - match a non-empty part of the path against a wildcard node
+//
+// The shortest capture that lets the rest of the path match wins, e.g. for "entities/*/attrs/*", the first wildcard
+// ends at the first "/attrs/" that is followed by a non-empty attribute name.
+// Only if no literal continuation matches, the wildcard swallows the rest of the path - if the wildcard ends a service path.
+// So, the most specific service wins, no matter the order in which the services were inserted in the trie.
+//
+static struct OrionLdRestService* wildcardMatch(OrionldRouteNode* nodeP, char* path, RouteCapture* captureV, int captureIx, int* capturesP)
+{
+  if (nodeP->literalP != NULL)
+  {
+    //
+    // Most wildcards have a single literal continuation (typically starting with '/') - strchr finds its candidates
+    //
+    OrionldRouteNode* onlyChildP = (nodeP->literalP->nextP == NULL)? nodeP->literalP : NULL;
+
+    for (char* endP = &path[1]; *endP != 0; ++endP)
+    {
+      OrionldRouteNode* childP;
+
+      if (onlyChildP != NULL)
+      {
+        if ((endP = strchr(endP, onlyChildP->label[0])) == NULL)
+          break;
+        childP = onlyChildP;
+      }
+      else if ((childP = literalChild(nodeP, *endP)) == NULL)
+        continue;
+
+      if (labelMatch(childP, endP) == false)
+        continue;
+
+      struct OrionLdRestService* serviceP = childrenMatch(childP, &endP[childP->labelLen], captureV, captureIx + 1, capturesP);
+
+      if (serviceP != NULL)
+      {
+        if (captureIx < ROUTE_CAPTURES_MAX)
+        {
+          captureV[captureIx].start = path;
+          captureV[captureIx].end   = endP;
+        }
+
+        return serviceP;
+      }
+    }
+  }
+
+  if (nodeP->serviceP != NULL)
+  {
+    if (captureIx < ROUTE_CAPTURES_MAX)
+    {
+      captureV[captureIx].start = path;
+      captureV[captureIx].end   = NULL;
+    }
+
+    *capturesP = captureIx + 1;
+  }
+
+  return nodeP->serviceP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// childrenMatch - match what is left of the path against the children of a node
+//
+// The literal child is tried before the wildcard child.
+// As long as there is no wildcard child to fall back on, no backtracking is needed and the trie is descended in a loop.
+//
+static struct OrionLdRestService* childrenMatch(OrionldRouteNode* nodeP, char* path, RouteCapture* captureV, int captureIx, int* capturesP)
+{
+  while (*path != 0)
+  {
+    OrionldRouteNode* childP = literalChild(nodeP, *path);
+
+    if ((childP != NULL) && (labelMatch(childP, path) == true))
+    {
+      if (nodeP->wildcardP == NULL)
+      {
+        nodeP  = childP;
+        path  += childP->labelLen;
+        continue;
+      }
+
+      struct OrionLdRestService* serviceP = childrenMatch(childP, &path[childP->labelLen], captureV, captureIx, capturesP);
+
+      if (serviceP != NULL)
+        return serviceP;
+    }
+
+    if (nodeP->wildcardP != NULL)
+      return wildcardMatch(nodeP->wildcardP, path, captureV, captureIx, capturesP);
+
+    return NULL;
+  }
+
+  if (nodeP->serviceP != NULL)
+    *capturesP = captureIx;
+
+  return nodeP->serviceP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRouteMatch -
+//
+struct OrionLdRestService* orionldRouteMatch(OrionldRouteNode* rootP, char* path, char** wildcardV, int wildcardMax)
+{
+  if (rootP == NULL)
+    return NULL;
+
+  RouteCapture                captureV[ROUTE_CAPTURES_MAX];
+  int                         captures = 0;
+  struct OrionLdRestService*  serviceP = childrenMatch(rootP, path, captureV, 0, &captures);
+
+  if (serviceP == NULL)
+    return NULL;
+
+  if (captures > ROUTE_CAPTURES_MAX)
+    captures = ROUTE_CAPTURES_MAX;
+
+  //
+  // Extract the wildcards - destroying the incoming URL path by zero-terminating them
+  //
+  for (int ix = 0; ix < captures; ix++)
+  {
+    if (captureV[ix].end != NULL)
+      *captureV[ix].end = 0;
+
+    if (ix < wildcardMax)
+      wildcardV[ix] = captureV[ix].start;
+  }
+
+  return serviceP;
+}
@@ -0,0 +1,43 @@
+#ifndef SRC_LIB_ORIONLD_REST_ORIONLDROUTEMATCH_H_
+#define SRC_LIB_ORIONLD_REST_ORIONLDROUTEMATCH_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/rest/OrionldRouteNode.h"                     // OrionldRouteNode
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldRouteMatch - find the service of an incoming URL path in a radix trie
+//
+// 'path' is the incoming URL path, without the initial "/ngsi-ld/".
+// On success, the wildcards of the URL path are zero-terminated inside 'path' and pointed to by
+// wildcardV[0] ... wildcardV[wildcardMax - 1]. Wildcards beyond 'wildcardMax' aren't extracted.
+// If there's no match, 'path' is left untouched.
+//
+extern struct OrionLdRestService* orionldRouteMatch(OrionldRouteNode* rootP, char* path, char** wildcardV, int wildcardMax);
+
+#endif  // SRC_LIB_ORIONLD_REST_ORIONLDROUTEMATCH_H_
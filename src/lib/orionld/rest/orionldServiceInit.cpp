@@ -49,6 +49,9 @@ extern "C"
 #include "orionld/context/orionldContextInit.h"                      // orionldContextInit
 #include "orionld/rest/OrionLdRestService.h"                         // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
 #include "orionld/rest/temporaryErrorPayloads.h"                     // Temporary Error Payloads
+#include "orionld/rest/orionldRouteInsert.h"                         // orionldRouteInsert
+#include "orionld/rest/orionldUriArgumentGet.h"                      // orionldUriArgumentInit
+#include "orionld/rest/orionldHttpHeaderGet.h"                       // orionldHttpHeaderInit
 #include "orionld/serviceRoutines/orionldPostEntities.h"             // orionldPostEntities
 #include "orionld/serviceRoutines/orionldPostEntity.h"               // orionldPostEntity
 #include "orionld/serviceRoutines/orionldGetEntities.h"              // orionldGetEntities
@@ -79,6 +82,8 @@ extern "C"
 #include "orionld/serviceRoutines/orionldGetEntityAttributes.h"      // orionldGetEntityAttributes
 #include "orionld/serviceRoutines/orionldGetEntityAttribute.h"       // orionldGetEntityAttribute
 #include "orionld/serviceRoutines/orionldPostTemporalEntities.h"     // orionldPostTemporalEntities
+#include "orionld/serviceRoutines/orionldGetTemporalEntities.h"      // orionldGetTemporalEntities
+#include "orionld/serviceRoutines/orionldGetTemporalEntity.h"        // orionldGetTemporalEntity
 #include "orionld/serviceRoutines/orionldGetContexts.h"              // orionldGetContexts
 #include "orionld/serviceRoutines/orionldGetContext.h"               // orionldGetContext
 #include "orionld/serviceRoutines/orionldPostContexts.h"             // orionldPostContexts
@@ -166,52 +171,11 @@ static void restServicePrepare(OrionLdRestService* serviceP, OrionLdRestServiceS
   serviceP->url             = (char*) simpleServiceP->url;
   serviceP->serviceRoutine  = simpleServiceP->serviceRoutine;
 
-  // 2. Loop over the URL Path, count wildcards, charsBeforeFirstWildcard, etc
-  int    ix            = ORION_LD_SERVICE_PREFIX_LEN - 1;
-  char*  wildCardStart = NULL;
-  char*  wildCardEnd   = NULL;
-
-  while (serviceP->url[++ix] != 0)
+  // 2. Count the wildcards of the URL Path (the URL path is inserted in the radix trie of its verb by orionldServiceInit)
+  for (char* cP = &serviceP->url[ORION_LD_SERVICE_PREFIX_LEN]; *cP != 0; ++cP)
   {
-    char c = serviceP->url[ix];
-
-    if (c == '*')
-    {
-      if (serviceP->wildcards == 0)
-        wildCardStart = &serviceP->url[ix + 1];
-      else if (serviceP->wildcards == 1)
-        wildCardEnd = &serviceP->url[ix];
-
+    if (*cP == '*')
       serviceP->wildcards += 1;
-      continue;
-    }
-
-    if (serviceP->wildcards == 0)
-    {
-      ++serviceP->charsBeforeFirstWildcard;
-      serviceP->charsBeforeFirstWildcardSum += c;
-    }
-    else if (serviceP->wildcards == 1)
-    {
-      ++serviceP->charsBeforeSecondWildcard;
-      serviceP->charsBeforeSecondWildcardSum += c;
-    }
-  }
-
-  if (serviceP->wildcards != 0)
-  {
-    if (wildCardEnd == NULL)  // If only one '*', make wildCardEnd point to end of URL
-      wildCardEnd = &serviceP->url[ix];
-
-    serviceP->matchForSecondWildcardLen = wildCardEnd - wildCardStart;
-
-    if (serviceP->matchForSecondWildcardLen < 0)
-      LM_X(1, ("Negative length of matchForSecondWildcard - not possible. SW bug"));
-    if (serviceP->matchForSecondWildcardLen > (int) sizeof(serviceP->matchForSecondWildcard))
-      LM_X(1, ("Too big matchForSecondWildcard - not possible. SW bug"));
-
-    if (serviceP->matchForSecondWildcardLen != 0)
-      strncpy(serviceP->matchForSecondWildcard, wildCardStart, wildCardEnd - wildCardStart);
   }
 
   //
@@ -364,16 +328,19 @@ static void restServicePrepare(OrionLdRestService* serviceP, OrionLdRestServiceS
   {
     serviceP->options    = 0;  // Tenant will be created if necessary
     serviceP->options   |= ORIONLD_SERVICE_OPTION_DONT_ADD_CONTEXT_TO_RESPONSE_PAYLOAD;
+    serviceP->options   |= ORIONLD_SERVICE_OPTION_BATCH_GROUPS;
   }
   else if (serviceP->serviceRoutine == orionldPostBatchUpdate)
   {
     serviceP->options   |= ORIONLD_SERVICE_OPTION_DONT_ADD_CONTEXT_TO_RESPONSE_PAYLOAD;
+    serviceP->options   |= ORIONLD_SERVICE_OPTION_BATCH_GROUPS;
     serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
   }
   else if (serviceP->serviceRoutine == orionldPostBatchUpsert)
   {
     serviceP->options    = 0;  // Tenant will be created if necessary
     serviceP->options   |= ORIONLD_SERVICE_OPTION_DONT_ADD_CONTEXT_TO_RESPONSE_PAYLOAD;
+    serviceP->options   |= ORIONLD_SERVICE_OPTION_BATCH_GROUPS;
 
     serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
   }
@@ -406,6 +373,32 @@ static void restServicePrepare(OrionLdRestService* serviceP, OrionLdRestServiceS
 
     serviceP->options |= ORIONLD_SERVICE_OPTION_PREFETCH_ID_AND_TYPE;
   }
+  else if (serviceP->serviceRoutine == orionldGetTemporalEntities)
+  {
+    serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LIMIT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_OFFSET;
+    serviceP->uriParams |= ORIONLD_URIPARAM_COUNT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_IDLIST;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TYPELIST;
+    serviceP->uriParams |= ORIONLD_URIPARAM_IDPATTERN;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ATTRS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEPROPERTY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEREL;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ENDTIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LASTN;
+  }
+  else if (serviceP->serviceRoutine == orionldGetTemporalEntity)
+  {
+    serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ATTRS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEPROPERTY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEREL;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ENDTIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LASTN;
+  }
   else if (serviceP->serviceRoutine == orionldGetVersion)
   {
     serviceP->options  = 0;  // Tenant is Ignored
@@ -520,11 +513,21 @@ void orionldServiceInit(OrionLdRestServiceSimplifiedVector* restServiceVV, int v
 
     for (sIx = 0; sIx < services; sIx++)
     {
-      restServicePrepare(&orionldRestServiceV[svIx].serviceV[sIx], &restServiceVV[svIx].serviceV[sIx]);
+      OrionLdRestService* serviceP = &orionldRestServiceV[svIx].serviceV[sIx];
+
+      restServicePrepare(serviceP, &restServiceVV[svIx].serviceV[sIx]);
+      orionldRouteInsert(&orionldRestServiceV[svIx].routeTree, &serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], serviceP);
     }
   }
 
 
+  //
+  // Build the perfect hash tables for URI parameters and HTTP headers
+  //
+  orionldUriArgumentInit();
+  orionldHttpHeaderInit();
+
+
   //
   // Initialize the KBASE library
   // This call redirects all log messahes from the K-libs to the brokers log file.
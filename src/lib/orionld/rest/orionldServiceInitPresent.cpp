@@ -60,12 +60,7 @@ void orionldServiceInitPresent(void)
       printf("  %s %s\n", verbName((Verb) svIx), serviceP->url);
       printf("  Service routine at:           %p\n", serviceP->serviceRoutine);
       printf("  Wildcards:                    %d\n", serviceP->wildcards);
-      printf("  charsBeforeFirstWildcard:     %d\n", serviceP->charsBeforeFirstWildcard);
-      printf("  charsBeforeFirstWildcardSum:  %d\n", serviceP->charsBeforeFirstWildcardSum);
-      printf("  charsBeforeSecondWildcard:    %d\n", serviceP->charsBeforeSecondWildcard);
-      printf("  charsBeforeSecondWildcardSum: %d\n", serviceP->charsBeforeSecondWildcardSum);
-      printf("  matchForSecondWildcard:       %s\n", serviceP->matchForSecondWildcard);
-      printf("  matchForSecondWildcardLen:    %d\n", serviceP->matchForSecondWildcardLen);
+      printf("  Supported URI params:         0x%x\n", serviceP->uriParams);
       printf("\n");
     }
   }
@@ -22,59 +22,21 @@
 *
 * Author: Ken Zangelin
 */
+extern "C"
+{
+#include "kbase/kMacros.h"                                     // K_VEC_SIZE
+}
+
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/rest/OrionLdRestService.h"                   // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
+#include "orionld/rest/orionldRouteMatch.h"                    // orionldRouteMatch
 #include "orionld/rest/orionldServiceLookup.h"                 // Own interface
 
 
 
-// -----------------------------------------------------------------------------
-//
-// requestPrepare -
-//
-// The cSumV values are interesting only for URL paths without wildcard of just uptil the first wildcard
-// The longest URL path without/before first wildcard is "/ngsi-ld/v1/csourceRegistrations/".
-// The initial part ("/ngsi-ld/") doesn't count, so ... 34 chars is all we need for the cSumV.
-//
-// strlen("/ngsi-ld/v1/temporal/entityOperations/query") == 43
-// strlen("/ngsi-ld/")                                   == 9   (ORION_LD_SERVICE_PREFIX_LEN)
-//
-//   43 - 9 == 34
-//
-#define MAX_CHARS_BEFORE_WILDCARD 34
-static void requestPrepare(char* url, int* cSumV, int* cSumsP, int* sLenP)
-{
-  // First of all, skip the first 9 characters in the URL path ("/ngsi-ld/")
-  url = &url[ORION_LD_SERVICE_PREFIX_LEN];
-  *cSumsP = 0;
-
-  // Initialize counters with the first byte, then skip the first byte for the loop
-  cSumV[0] = url[0];
-
-  int sLen;
-  int ix   = 1;
-
-  while ((url[ix] != 0) && (ix < MAX_CHARS_BEFORE_WILDCARD))
-  {
-    cSumV[ix]  = cSumV[ix - 1] + url[ix];
-    ++ix;
-  }
-  *cSumsP = ix;
-
-  while (url[ix] != 0)
-  {
-    ++ix;
-  }
-
-  sLen   = ix;
-  *sLenP = sLen;
-}
-
-
-
 // -----------------------------------------------------------------------------
 //
 // orionldServiceLookup -
@@ -82,88 +44,12 @@ static void requestPrepare(char* url, int* cSumV, int* cSumsP, int* sLenP)
 // The Verb must be a valid verb before calling this function (GET | POST | DELETE).
 // This is assured by the function orionldMhdConnectionTreat()
 //
+// The URL path is looked up in the radix trie of the verb, built by orionldServiceInit.
+// That the URL path starts with "/ngsi-ld/" has been made sure before getting here.
+//
 OrionLdRestService* orionldServiceLookup(OrionLdRestServiceVector* serviceV)
 {
-  int serviceIx = 0;
-  int cSumV[MAX_CHARS_BEFORE_WILDCARD];
-  int cSums;
-  int sLen;
-
-  requestPrepare(orionldState.urlPath, cSumV, &cSums, &sLen);
-
-  while (serviceIx < serviceV->services)
-  {
-    OrionLdRestService* serviceP = &serviceV->serviceV[serviceIx];
-
-    if (serviceP->wildcards == 0)
-    {
-      if (serviceP->charsBeforeFirstWildcard == sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[sLen - 1])
-        {
-          if (strcmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &orionldState.urlPath[ORION_LD_SERVICE_PREFIX_LEN]) == 0)
-          {
-            return serviceP;
-          }
-        }
-      }
-    }
-    else if (serviceP->wildcards == 1)
-    {
-      if (serviceP->charsBeforeFirstWildcard < sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1])
-        {
-          if (strncmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &orionldState.urlPath[ORION_LD_SERVICE_PREFIX_LEN], serviceP->charsBeforeFirstWildcard) == 0)
-          {
-            // Ending the same?
-            if (serviceP->matchForSecondWildcardLen != 0)  // An ending to match
-            {
-              int indexOfIncomingUrlPath = ORION_LD_SERVICE_PREFIX_LEN + sLen - serviceP->matchForSecondWildcardLen;
-
-              if (strncmp(&orionldState.urlPath[indexOfIncomingUrlPath], serviceP->matchForSecondWildcard, serviceP->matchForSecondWildcardLen) == 0)
-              {
-                orionldState.wildcard[0] = &orionldState.urlPath[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
-
-                // Destroying the incoming URL path, to extract the wildcard string
-                orionldState.urlPath[sLen - serviceP->matchForSecondWildcardLen + ORION_LD_SERVICE_PREFIX_LEN] = 0;
-                return serviceP;
-              }
-            }
-            else
-            {
-              orionldState.wildcard[0] = &orionldState.urlPath[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
-              return serviceP;
-            }
-          }
-        }
-      }
-    }
-    else
-    {
-      if (serviceP->charsBeforeFirstWildcard < sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1])
-        {
-          char* matchP;
-          if ((matchP = strstr(&orionldState.urlPath[ORION_LD_SERVICE_PREFIX_LEN], serviceP->matchForSecondWildcard)) != NULL)
-          {
-            {
-              orionldState.wildcard[0] = &orionldState.urlPath[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
-              orionldState.wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
-
-              // Destroying the incoming URL path, to extract first wildcard string
-              *matchP = 0;
-
-              return serviceP;
-            }
-          }
-        }
-      }
-    }
-
-    ++serviceIx;
-  }
+  char* path = &orionldState.urlPath[ORION_LD_SERVICE_PREFIX_LEN];
 
-  return NULL;
+  return orionldRouteMatch(serviceV->routeTree, path, orionldState.wildcard, K_VEC_SIZE(orionldState.wildcard));
 }
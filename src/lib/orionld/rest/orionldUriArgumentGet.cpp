@@ -0,0 +1,388 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // snprintf
+#include <string.h>                                            // strcmp, strlen, strspn
+#include <stdlib.h>                                            // atoi
+#include <microhttpd.h>                                        // MHD
+
+extern "C"
+{
+#include "kbase/kMacros.h"                                     // K_VEC_SIZE
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/common/orionldErrorResponse.h"               // OrionldBadRequestData, ...
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/payloadCheck/pcheckUri.h"                    // pcheckUri
+#include "orionld/rest/OrionLdRestService.h"                   // ORIONLD_URIPARAM_LIMIT, ...
+#include "orionld/rest/OrionldNameTable.h"                     // OrionldNameTable, OrionldNameItem
+#include "orionld/rest/orionldNameTableBuild.h"                // orionldNameTableBuild
+#include "orionld/rest/orionldNameTableLookup.h"               // orionldNameTableLookup
+#include "orionld/rest/orionldUriArgumentGet.h"                // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// optionsParse -
+//
+static void optionsParse(const char* options)
+{
+  char* optionStart = (char*) options;
+  char* cP          = (char*) options;
+
+  while (1)
+  {
+    if ((*cP == ',') || (*cP == 0))  // Found the end of an option
+    {
+      bool done  = (*cP == 0);
+      char saved = *cP;
+
+      *cP = 0;  // Zero-terminate
+
+      if      (strcmp(optionStart, "update")        == 0)  orionldState.uriParamOptions.update        = true;
+      else if (strcmp(optionStart, "replace")       == 0)  orionldState.uriParamOptions.replace       = true;
+      else if (strcmp(optionStart, "noOverwrite")   == 0)  orionldState.uriParamOptions.noOverwrite   = true;
+      else if (strcmp(optionStart, "keyValues")     == 0)  orionldState.uriParamOptions.keyValues     = true;
+      else if (strcmp(optionStart, "sysAttrs")      == 0)  orionldState.uriParamOptions.sysAttrs      = true;
+      else if (strcmp(optionStart, "append")        == 0)  orionldState.uriParamOptions.append        = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "count")         == 0)  orionldState.uriParams.count               = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "values")        == 0)  orionldState.uriParamOptions.values        = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "unique")        == 0)  orionldState.uriParamOptions.uniqueValues  = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "dateCreated")   == 0)  orionldState.uriParamOptions.dateCreated   = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "dateModified")  == 0)  orionldState.uriParamOptions.dateModified  = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "noAttrDetail")  == 0)  orionldState.uriParamOptions.noAttrDetail  = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "upsert")        == 0)  orionldState.uriParamOptions.upsert        = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "temporalValues") == 0) orionldState.uriParamOptions.temporalValues = true;
+      else
+      {
+        LM_W(("Unknown 'options' value: %s", optionStart));
+        orionldState.httpStatusCode = 400;
+        orionldErrorResponseCreate(OrionldBadRequestData, "Unknown value for 'options' URI parameter", optionStart);
+        return;
+      }
+
+      if (done == true)
+        break;
+
+      *cP = saved;
+      optionStart = &cP[1];
+    }
+
+    ++cP;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// trueOrFalse - parse a "true"/"false" URI param value - false if the value is invalid
+//
+static bool trueOrFalse(const char* name, const char* value, bool* boolP)
+{
+  if (strcmp(value, "true") == 0)
+    *boolP = true;
+  else if (strcmp(value, "false") == 0)
+    *boolP = false;
+  else
+  {
+    char title[128];
+
+    snprintf(title, sizeof(title), "Invalid value for uri parameter '%s'", name);
+    orionldErrorResponseCreate(OrionldBadRequestData, title, value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// URI parameter setters
+//
+// One per URI parameter. A setter returns false if the value is invalid (after setting the error response), and then
+// the ORIONLD_URIPARAM_* bit of the URI parameter is not set.
+//
+static bool idSet(const char* value)                { orionldState.uriParams.id               = (char*) value; return true; }
+static bool typeSet(const char* value)              { orionldState.uriParams.type             = (char*) value; return true; }
+static bool typePatternSet(const char* value)       { orionldState.uriParams.typePattern      = (char*) value; return true; }
+static bool idPatternSet(const char* value)         { orionldState.uriParams.idPattern        = (char*) value; return true; }
+static bool attrsSet(const char* value)             { orionldState.uriParams.attrs            = (char*) value; return true; }
+static bool geometrySet(const char* value)          { orionldState.uriParams.geometry         = (char*) value; return true; }
+static bool coordinatesSet(const char* value)       { orionldState.uriParams.coordinates      = (char*) value; return true; }
+static bool georelSet(const char* value)            { orionldState.uriParams.georel           = (char*) value; return true; }
+static bool geopropertySet(const char* value)       { orionldState.uriParams.geoproperty      = (char*) value; return true; }
+static bool geometryPropertySet(const char* value)  { orionldState.uriParams.geometryProperty = (char*) value; return true; }
+static bool qSet(const char* value)                 { orionldState.uriParams.q                = (char*) value; return true; }
+static bool mqSet(const char* value)                { orionldState.uriParams.mq               = (char*) value; return true; }
+static bool timepropertySet(const char* value)      { orionldState.uriParams.timeproperty     = (char*) value; return true; }
+static bool timerelSet(const char* value)           { orionldState.uriParams.timerel          = (char*) value; return true; }  // FIXME: Check the value
+static bool timeAtSet(const char* value)            { orionldState.uriParams.timeAt           = (char*) value; return true; }  // FIXME: Check the value
+static bool endTimeAtSet(const char* value)         { orionldState.uriParams.endTimeAt        = (char*) value; return true; }  // FIXME: Check the value
+static bool subscriptionIdSet(const char* value)    { orionldState.uriParams.subscriptionId   = (char*) value; return true; }
+static bool urlSet(const char* value)               { orionldState.uriParams.url              = (char*) value; return true; }
+static bool existSet(const char* value)             { orionldState.uriParams.exists           = (char*) value; return true; }
+static bool notExistSet(const char* value)          { orionldState.uriParams.notExists        = (char*) value; return true; }
+static bool metadataSet(const char* value)          { orionldState.uriParams.metadata         = (char*) value; return true; }
+static bool orderBySet(const char* value)           { orionldState.uriParams.orderBy          = (char*) value; return true; }
+static bool attributeFormatSet(const char* value)   { orionldState.uriParams.attributeFormat  = (char*) value; return true; }
+static bool levelSet(const char* value)             { orionldState.uriParams.level            = (char*) value; return true; }
+static bool spacesSet(const char* value)            { orionldState.uriParams.spaces           = atoi(value);   return true; }
+static bool reloadSet(const char* value)            { orionldState.uriParams.reload           = true;          return true; }
+static bool collapseSet(const char* value)          { if (strcmp(value, "true") == 0) orionldState.uriParams.collapse = true; return true; }
+static bool resetSet(const char* value)             { if (strcmp(value, "true") == 0) orionldState.uriParams.reset    = true; return true; }
+static bool deleteAllSet(const char* value)         { return trueOrFalse("deleteAll", value, &orionldState.uriParams.deleteAll); }
+static bool locationSet(const char* value)          { return trueOrFalse("location",  value, &orionldState.uriParams.location);  }
+
+static bool optionsSet(const char* value)
+{
+  orionldState.uriParams.options = (char*) value;
+  optionsParse(value);  // The error response is set by optionsParse - the mask bit is set anyway
+
+  return true;
+}
+
+static bool offsetSet(const char* value)
+{
+  if (value[0] == '-')
+  {
+    LM_W(("Bad Input (negative value for /offset/ URI param)"));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /offset/", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  orionldState.uriParams.offset = atoi(value);
+  return true;
+}
+
+static bool limitSet(const char* value)
+{
+  if (value[0] == '-')
+  {
+    LM_W(("Bad Input (negative value for /limit/ URI param)"));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /limit/", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  orionldState.uriParams.limit = atoi(value);
+
+  if (orionldState.uriParams.limit > 1000)
+  {
+    LM_W(("Bad Input (too big value for /limit/ URI param: %d - max allowed is 1000)", orionldState.uriParams.limit));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /limit/ (valid range: 0-1000)", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+static bool countSet(const char* value)
+{
+  if (strcmp(value, "true") == 0)
+    orionldState.uriParams.count = true;
+  else if (strcmp(value, "false") != 0)
+  {
+    LM_W(("Bad Input (invalid value for URI parameter 'count': %s)", value));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /count/", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+static bool datasetIdSet(const char* value)
+{
+  char* detail;
+
+  if (pcheckUri((char*) value, true, &detail) == false)
+  {
+    orionldErrorResponseCreate(OrionldBadRequestData, "Not a URI", value);  // FIXME: Include 'detail' and name (datasetId)
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  orionldState.uriParams.datasetId = (char*) value;
+  return true;
+}
+
+static bool lastNSet(const char* value)
+{
+  orionldState.uriParams.lastN = atoi(value);
+
+  if ((orionldState.uriParams.lastN <= 0) || (strspn(value, "0123456789") != strlen(value)))
+  {
+    LM_W(("Bad Input (invalid value for /lastN/ URI param: %s)", value));
+    orionldErrorResponseCreate(OrionldBadRequestData, "Bad value for URI parameter /lastN/ (must be a positive integer)", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+static bool detailsSet(const char* value)
+{
+  if (strcmp(value, "on") == 0)
+  {
+    orionldState.uriParams.details = true;
+    return true;
+  }
+
+  return trueOrFalse("details", value, &orionldState.uriParams.details);
+}
+
+static bool prettyPrintSet(const char* value)
+{
+  if (strcmp(value, "yes") == 0)
+    orionldState.uriParams.prettyPrint = true;
+  else if (strcmp(value, "no") == 0)
+    orionldState.uriParams.prettyPrint = false;
+  else
+  {
+    orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for uri parameter 'prettyPrint'", value);
+    orionldState.httpStatusCode = 400;
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// uriParamV - all URI parameters known to the broker
+//
+// A mask of zero means the URI parameter is accepted by all services (NGSIv2 compatibility).
+//
+static OrionldNameItem uriParamV[] =
+{
+  { "id",               ORIONLD_URIPARAM_IDLIST,           idSet               },
+  { "type",             ORIONLD_URIPARAM_TYPELIST,         typeSet             },
+  { "typePattern",      0,                                 typePatternSet      },
+  { "idPattern",        ORIONLD_URIPARAM_IDPATTERN,        idPatternSet        },
+  { "attrs",            ORIONLD_URIPARAM_ATTRS,            attrsSet            },
+  { "offset",           ORIONLD_URIPARAM_OFFSET,           offsetSet           },
+  { "limit",            ORIONLD_URIPARAM_LIMIT,            limitSet            },
+  { "options",          ORIONLD_URIPARAM_OPTIONS,          optionsSet          },
+  { "geometry",         ORIONLD_URIPARAM_GEOMETRY,         geometrySet         },
+  { "coordinates",      ORIONLD_URIPARAM_COORDINATES,      coordinatesSet      },
+  { "coords",           0,                                 coordinatesSet      },  // Only NGSIv1/v2
+  { "georel",           ORIONLD_URIPARAM_GEOREL,           georelSet           },
+  { "geoproperty",      ORIONLD_URIPARAM_GEOPROPERTY,      geopropertySet      },
+  { "geometryProperty", ORIONLD_URIPARAM_GEOMETRYPROPERTY, geometryPropertySet },
+  { "count",            ORIONLD_URIPARAM_COUNT,            countSet            },
+  { "q",                ORIONLD_URIPARAM_Q,                qSet                },
+  { "mq",               0,                                 mqSet               },
+  { "datasetId",        ORIONLD_URIPARAM_DATASETID,        datasetIdSet        },
+  { "deleteAll",        ORIONLD_URIPARAM_DELETEALL,        deleteAllSet        },
+  { "timeproperty",     ORIONLD_URIPARAM_TIMEPROPERTY,     timepropertySet     },
+  { "timerel",          ORIONLD_URIPARAM_TIMEREL,          timerelSet          },
+  { "timeAt",           ORIONLD_URIPARAM_TIMEAT,           timeAtSet           },
+  { "endTimeAt",        ORIONLD_URIPARAM_ENDTIMEAT,        endTimeAtSet        },
+  { "lastN",            ORIONLD_URIPARAM_LASTN,            lastNSet            },
+  { "details",          ORIONLD_URIPARAM_DETAILS,          detailsSet          },
+  { "prettyPrint",      ORIONLD_URIPARAM_PRETTYPRINT,      prettyPrintSet      },
+  { "spaces",           ORIONLD_URIPARAM_SPACES,           spacesSet           },
+  { "subscriptionId",   ORIONLD_URIPARAM_SUBSCRIPTION_ID,  subscriptionIdSet   },
+  { "location",         ORIONLD_URIPARAM_LOCATION,         locationSet         },
+  { "url",              ORIONLD_URIPARAM_URL,              urlSet              },
+  { "reload",           ORIONLD_URIPARAM_RELOAD,           reloadSet           },
+  { "exist",            0,                                 existSet            },
+  { "!exist",           ORIONLD_URIPARAM_NOTEXISTS,        notExistSet         },
+  { "metadata",         0,                                 metadataSet         },
+  { "orderBy",          0,                                 orderBySet          },
+  { "collapse",         0,                                 collapseSet         },
+  { "attributeFormat",  0,                                 attributeFormatSet  },  // FIXME: attributeFormat AND attributesFormat ???
+  { "attributesFormat", 0,                                 attributeFormatSet  },
+  { "reset",            0,                                 resetSet            },
+  { "level",            0,                                 levelSet            },
+  { "entity::type",     0,                                 typeSet             }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// uriParamTable -
+//
+static OrionldNameTable uriParamTable;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldUriArgumentInit -
+//
+void orionldUriArgumentInit(void)
+{
+  if (orionldNameTableBuild(&uriParamTable, uriParamV, K_VEC_SIZE(uriParamV)) == false)
+    LM_X(1, ("Unable to build the perfect hash table for URI parameters"));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldUriArgumentGet -
+//
+MHD_Result orionldUriArgumentGet(void* cbDataP, MHD_ValueKind kind, const char* key, const char* value)
+{
+  if ((value == NULL) || (*value == 0))
+  {
+    char errorString[256];
+
+    snprintf(errorString, sizeof(errorString) - 1, "Empty right-hand-side for URI param /%s/", key);
+    orionldErrorResponseCreate(OrionldBadRequestData, "Error in URI param", errorString);
+    orionldState.httpStatusCode = 400;
+
+    return MHD_YES;
+  }
+
+  OrionldNameItem* itemP = orionldNameTableLookup(&uriParamTable, key);
+
+  if (itemP == NULL)
+  {
+    LM_W(("Bad Input (unknown URI parameter: '%s')", key));
+    orionldState.httpStatusCode = 400;
+    orionldErrorResponseCreate(OrionldBadRequestData, "Unknown URI parameter", key);
+    return MHD_YES;
+  }
+
+  if (itemP->setter(value) == true)
+    orionldState.uriParams.mask |= itemP->mask;
+
+  return MHD_YES;
+}
@@ -55,6 +55,7 @@ const char* uriParamName(uint32_t bit)
   case ORIONLD_URIPARAM_TIMEREL:             return "timerel";
   case ORIONLD_URIPARAM_TIMEAT:              return "timeAt";
   case ORIONLD_URIPARAM_ENDTIMEAT:           return "endTimeAt";
+  case ORIONLD_URIPARAM_LASTN:               return "lastN";
   case ORIONLD_URIPARAM_DETAILS:             return "details";
   case ORIONLD_URIPARAM_PRETTYPRINT:         return "prettyPrint";
   case ORIONLD_URIPARAM_SPACES:              return "spaces";
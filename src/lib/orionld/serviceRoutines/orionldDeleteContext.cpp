@@ -35,10 +35,10 @@ extern "C"
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
 #include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
-#include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
 #include "orionld/contextCache/orionldContextCacheDelete.h"      // orionldContextCacheDelete
 #include "orionld/contextCache/orionldContextCacheInsert.h"      // orionldContextCacheInsert
+#include "orionld/contextCache/orionldContextCacheRemove.h"      // orionldContextCacheRemove
 #include "orionld/serviceRoutines/orionldDeleteContext.h"        // Own Interface
 
 
@@ -74,18 +74,7 @@ bool orionldDeleteContext(ConnectionInfo* ciP)
     //
     // Remove old context from cache (and keep a pointer to) the old context
     //
-    bool done = false;
-    for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
-    {
-      if (orionldContextCache[ix] == oldContextP)
-      {
-        orionldContextCache[ix] = NULL;
-        done = true;
-        break;
-      }
-    }
-
-    if (done == false)
+    if (orionldContextCacheRemove(oldContextP) == false)
     {
       LM_E(("Context Cache Error (context to be reloaded not found in cache)"));  // orionldContextCacheLookup found it though ... ???
       orionldErrorResponseCreate(OrionldInternalError, "Context Cache Error", "context to be reloaded not found in cache");
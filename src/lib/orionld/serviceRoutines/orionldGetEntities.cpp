@@ -30,30 +30,29 @@ extern "C"
 #include "kbase/kMacros.h"                                     // K_FT
 #include "kbase/kStringSplit.h"                                // kStringSplit
 #include "kbase/kTime.h"                                       // kTimeGet
+#include "kalloc/kaAlloc.h"                                    // kaAlloc
 #include "kalloc/kaStrdup.h"                                   // kaStrdup
 #include "kjson/kjBuilder.h"                                   // kjArray, kjChildAdd, ...
 #include "kjson/kjLookup.h"                                    // kjLookup
-#include "kjson/kjRender.h"                                    // kjFastRender
+#include "kjson/kjParse.h"                                     // kjParse
 }
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "rest/ConnectionInfo.h"                               // ConnectionInfo
-#include "ngsi10/QueryContextRequest.h"                        // QueryContextRequest
-#include "ngsi10/QueryContextResponse.h"                       // QueryContextResponse
-#include "mongoBackend/mongoQueryContext.h"                    // mongoQueryContext
 
 #include "orionld/common/SCOMPARE.h"                           // SCOMPAREx
 #include "orionld/common/qLex.h"                               // qLex
 #include "orionld/common/qParse.h"                             // qParse
-#include "orionld/common/qTreeToBsonObj.h"                     // qTreeToBsonObj
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/orionldErrorResponse.h"               // orionldErrorResponseCreate
 #include "orionld/common/performance.h"                        // PERFORMANCE
 #include "orionld/common/dotForEq.h"                           // dotForEq
 #include "orionld/payloadCheck/pcheckUri.h"                    // pcheckUri
-#include "orionld/kjTree/kjTreeFromQueryContextResponse.h"     // kjTreeFromQueryContextResponse
+#include "orionld/payloadCheck/pcheckGeoQ.h"                   // pcheckGeoQ
+#include "orionld/db/dbConfiguration.h"                        // dbEntitiesQuery, dbEntitiesAttributeLookup
+#include "orionld/db/dbModelToApiEntity.h"                     // dbModelToApiEntity
 #include "orionld/context/orionldCoreContext.h"                // orionldDefaultUrl
 #include "orionld/context/orionldContextItemExpand.h"          // orionldContextItemExpand
 #include "orionld/context/orionldAttributeExpand.h"            // orionldAttributeExpand
@@ -62,14 +61,6 @@ extern "C"
 
 
 
-// -----------------------------------------------------------------------------
-//
-// FIXME - put dmodelEntity in its own module (perhaps even its own library ...)
-//
-extern KjNode* dmodelEntity(KjNode* dbEntityP, bool sysAttrs, OrionldProblemDetails* pdP);
-
-
-
 // ----------------------------------------------------------------------------
 //
 // geoPropertyInAttrs -
@@ -87,6 +78,26 @@ static bool geoPropertyInAttrs(char** attrsV, int attrsCount, const char* geoPro
 
 
 
+// ----------------------------------------------------------------------------
+//
+// entityInfoAdd - add an item { "id"|"idPattern": X, "type": T } to the array of EntityInfo for dbEntitiesQuery
+//
+static void entityInfoAdd(KjNode* entityInfoArrayP, const char* idField, char* id, char* type)
+{
+  KjNode* entityInfoP = kjObject(orionldState.kjsonP, NULL);
+
+  if (id != NULL)
+    kjChildAdd(entityInfoP, kjString(orionldState.kjsonP, idField, id));
+
+  if (type != NULL)
+    kjChildAdd(entityInfoP, kjString(orionldState.kjsonP, "type", type));
+
+  if (entityInfoP->value.firstChildP != NULL)
+    kjChildAdd(entityInfoArrayP, entityInfoP);
+}
+
+
+
 // ----------------------------------------------------------------------------
 //
 // orionldGetEntities -
@@ -118,6 +129,9 @@ static bool geoPropertyInAttrs(char** attrsV, int attrsCount, const char* geoPro
 // Note that the pagination params (limit, offset) make no sense when returning a single entity.
 // 'attrs' is a different deal though. 'attrs' will filter the attributes to be returned.
 //
+// The URI params are turned into the same KjNode trees that POST Query uses (entity info array, attrs array, Q-tree and geoQ)
+// and the query is performed via dbEntitiesQuery. The entities in the DB model are then converted into API entities.
+//
 bool orionldGetEntities(ConnectionInfo* ciP)
 {
   char*                 id             = orionldState.uriParams.id;
@@ -130,10 +144,8 @@ bool orionldGetEntities(ConnectionInfo* ciP)
   char*                 georel         = orionldState.uriParams.georel;
   char*                 coordinates    = orionldState.uriParams.coordinates;
 
-  char*                 idString       = (id != NULL)? id      : idPattern;
-  const char*           isIdPattern    = (id != NULL)? "false" : "true";
-  bool                  isTypePattern  = (type != NULL)? false   : true;
-  EntityId*             entityIdP;
+  char*                 idString       = (id != NULL)? id   : idPattern;
+  const char*           idField        = (id != NULL)? "id" : "idPattern";
   char*                 typeExpanded   = NULL;
   char*                 detail;
   char*                 idVector[32];    // Is 32 a good limit?
@@ -141,12 +153,10 @@ bool orionldGetEntities(ConnectionInfo* ciP)
   int                   idVecItems     = (int) sizeof(idVector) / sizeof(idVector[0]);
   int                   typeVecItems   = (int) sizeof(typeVector) / sizeof(typeVector[0]);
   bool                  keyValues      = orionldState.uriParamOptions.keyValues;
-  QueryContextRequest   mongoRequest;
-  QueryContextResponse  mongoResponse;
-
-  LM_TMP(("KZ2: geometry:    '%s'", geometry));
-  LM_TMP(("KZ2: georel:      '%s'", georel));
-  LM_TMP(("KZ2: coordinates: '%s'", orionldState.uriParams.coordinates));
+  KjNode*               entityInfoArrayP;
+  KjNode*               attrsP         = NULL;
+  QNode*                qTree          = NULL;
+  KjNode*               geoqP          = NULL;
 
   //
   // FIXME: Move all this to orionldMhdConnectionInit()
@@ -278,48 +288,45 @@ bool orionldGetEntities(ConnectionInfo* ciP)
       return false;
     }
 
-    Scope*       scopeP = new Scope(SCOPE_TYPE_LOCATION, "");
-    std::string  errorString;
-
     //
-    // In APIv2, the vector is a string without [], in NGSI-LD, [] are present. Must remove ...
+    // In NGSI-LD the coordinates are a JSON Array (with []) - they are parsed into a KjNode tree and the geoQ
+    // is built exactly like the one of POST Query
     //
-    if (coordinates[0] == '[')
+    if (coordinates[0] != '[')
     {
-      ++coordinates;
+      int   len    = strlen(coordinates) + 3;
+      char* buffer = kaAlloc(&orionldState.kalloc, len);
 
-      int len = strlen(coordinates);
-      if (coordinates[len - 1] == ']')
-        coordinates[len - 1] = 0;
+      snprintf(buffer, len, "[%s]", coordinates);
+      coordinates = buffer;
     }
 
-    if (scopeP->fill(orionldState.apiVersion, geometry, coordinates, georel, &errorString) != 0)
-    {
-      scopeP->release();
-      delete scopeP;
+    KjNode* coordsP = kjParse(orionldState.kjsonP, coordinates);
 
-      LM_E(("Geo: Scope::fill failed"));
-      orionldErrorResponseCreate(OrionldInternalError, "Invalid Geometry", errorString.c_str());
+    if ((coordsP == NULL) || (coordsP->type != KjArray))
+    {
+      LM_W(("Bad Input (invalid value for URI parameter 'coordinates')"));
+      orionldErrorResponseCreate(OrionldBadRequestData, "Invalid value for URI parameter /coordinates/", orionldState.uriParams.coordinates);
       orionldState.httpStatusCode = SccBadRequest;
       return false;
     }
 
-    LM_E(("Geo: Scope::fill OK"));
-    mongoRequest.restriction.scopeVector.push_back(scopeP);
-  }
+    geoqP         = kjObject(orionldState.kjsonP, NULL);
+    coordsP->name = (char*) "coordinates";
 
-  if (idString == NULL)
-  {
-    idString    = (char*) ".*";
-    isIdPattern = (char*) "true";
+    kjChildAdd(geoqP, kjString(orionldState.kjsonP, "geometry", geometry));
+    kjChildAdd(geoqP, coordsP);
+    kjChildAdd(geoqP, kjString(orionldState.kjsonP, "georel", georel));
+
+    if (orionldState.uriParams.geoproperty != NULL)
+      kjChildAdd(geoqP, kjString(orionldState.kjsonP, "geoproperty", orionldState.uriParams.geoproperty));
+
+    if (pcheckGeoQ(geoqP, false) == false)  // Don't change coordinates from array to string
+      return false;
   }
 
   if (type == NULL)  // No type given - match all types
-  {
-    type          = (char*) ".*";
-    isTypePattern = true;
     typeVecItems  = 0;  // Just to avoid entering the "if (typeVecItems == 1)"
-  }
   else
     typeVecItems = kStringSplit(type, ',', (char**) typeVector, typeVecItems);
 
@@ -356,16 +363,15 @@ bool orionldGetEntities(ConnectionInfo* ciP)
     //   I always expand ...
     //
     type = orionldContextItemExpand(orionldState.contextP, type, true, NULL);  // entity type
-
-    isTypePattern = false;  // Just in case ...
   }
 
+  entityInfoArrayP = kjArray(orionldState.kjsonP, NULL);
+
   if (idVecItems > 1)  // A list of Entity IDs
   {
     for (int ix = 0; ix < idVecItems; ix++)
     {
-      entityIdP = new EntityId(idVector[ix], type, "false", isTypePattern);
-      mongoRequest.entityIdVector.push_back(entityIdP);
+      entityInfoAdd(entityInfoArrayP, "id", idVector[ix], type);
     }
   }
   else if (typeVecItems > 1)  // A list of Entity Types
@@ -377,15 +383,11 @@ bool orionldGetEntities(ConnectionInfo* ciP)
       else
         typeExpanded = typeVector[ix];
 
-      entityIdP = new EntityId(idString, typeExpanded, isIdPattern, false);
-      mongoRequest.entityIdVector.push_back(entityIdP);
+      entityInfoAdd(entityInfoArrayP, idField, idString, typeExpanded);
     }
   }
   else  // Definitely no lists in EntityId id/type
-  {
-    entityIdP = new EntityId(idString, type, isIdPattern, isTypePattern);
-    mongoRequest.entityIdVector.push_back(entityIdP);
-  }
+    entityInfoAdd(entityInfoArrayP, idField, idString, type);
 
   char* attrsV[100];
   int   attrsCount = 0;
@@ -395,6 +397,7 @@ bool orionldGetEntities(ConnectionInfo* ciP)
     attrsCount = (int) sizeof(attrsV) / sizeof(attrsV[0]);
 
     attrsCount = kStringSplit(attrs, ',', (char**) attrsV, attrsCount);
+    attrsP     = kjArray(orionldState.kjsonP, NULL);
 
     for (int ix = 0; ix < attrsCount; ix++)
     {
@@ -405,7 +408,7 @@ bool orionldGetEntities(ConnectionInfo* ciP)
         attrsV[ix] = orionldAttributeExpand(orionldState.contextP, attrsV[ix], true, NULL);
       }
 
-      mongoRequest.attributeList.push_back(attrsV[ix]);
+      kjChildAdd(attrsP, kjString(orionldState.kjsonP, NULL, attrsV[ix]));
     }
   }
 
@@ -414,13 +417,11 @@ bool orionldGetEntities(ConnectionInfo* ciP)
     char*  title;
     char*  detail;
     QNode* lexList;
-    QNode* qTree;
 
     if ((lexList = qLex(q, &title, &detail)) == NULL)
     {
       LM_W(("Bad Input (qLex: %s: %s)", title, detail));
       orionldErrorResponseCreate(OrionldBadRequestData, title, detail);
-      mongoRequest.release();
       return false;
     }
 
@@ -428,59 +429,34 @@ bool orionldGetEntities(ConnectionInfo* ciP)
     {
       LM_W(("Bad Input (qParse: %s: %s)", title, detail));
       orionldErrorResponseCreate(OrionldBadRequestData, title, detail);
-      mongoRequest.release();
       return false;
     }
-
-
-    //
-    // FIXME: this part about Q-Filter depends on the database and must be moved to
-    //        the DB layer
-    //
-    orionldState.qMongoFilterP = new mongo::BSONObj;
-
-    mongo::BSONObjBuilder objBuilder;
-    if (qTreeToBsonObj(qTree, &objBuilder, &title, &detail) == false)
-    {
-      LM_W(("Bad Input (qTreeToBsonObj: %s: %s)", title, detail));
-      orionldErrorResponseCreate(OrionldBadRequestData, title, detail);
-      mongoRequest.release();
-      return false;
-    }
-
-    *orionldState.qMongoFilterP = objBuilder.obj();
   }
 
+  int      count  = 0;
+  int*     countP = (orionldState.uriParams.count == true)? &count : NULL;
+  KjNode*  dbEntityArray;
 
   //
-  // Call mongoBackend
+  // If count is asked for and limit == 0 - just the count query is performed
   //
-  long long   count;
-  long long*  countP = (orionldState.uriParams.count == true)? &count : NULL;
+  dbEntityArray = dbEntitiesQuery(entityInfoArrayP, attrsP, qTree, geoqP, orionldState.uriParams.limit, orionldState.uriParams.offset, countP);
+  if (dbEntityArray == NULL)
+    return false;  // dbEntitiesQuery has filled in the error response
 
   //
-  // Special case:
-  // If count is asked for and limit == 0 - just do the count query
+  // Transform the entities of the database model into NGSI-LD API entities
   //
-  if ((countP != NULL) && (orionldState.uriParams.limit == 0))
-    orionldState.onlyCount = true;
-
-  PERFORMANCE(mongoBackendStart);
-  std::vector<std::string>  servicePathV;
-  orionldState.httpStatusCode = mongoQueryContext(&mongoRequest,
-                                                  &mongoResponse,
-                                                  orionldState.tenantP,
-                                                  servicePathV,
-                                                  countP,
-                                                  orionldState.apiVersion);
-  PERFORMANCE(mongoBackendEnd);
+  orionldState.httpStatusCode = SccOk;
+  orionldState.responseTree   = kjArray(orionldState.kjsonP, NULL);
 
-  //
-  // Transform QueryContextResponse to KJ-Tree
-  //
-  orionldState.httpStatusCode = SccOk;  // FIXME: What about the response from mongoQueryContext???
+  for (KjNode* dbEntityP = dbEntityArray->value.firstChildP; dbEntityP != NULL; dbEntityP = dbEntityP->next)
+  {
+    KjNode* entityP = dbModelToApiEntity(dbEntityP, orionldState.uriParamOptions.sysAttrs, keyValues);
 
-  orionldState.responseTree = kjTreeFromQueryContextResponse(false, NULL, keyValues, &mongoResponse);
+    if (entityP != NULL)
+      kjChildAdd(orionldState.responseTree, entityP);
+  }
 
   //
   // Work-around for Accept: application/geo+json
@@ -559,8 +535,7 @@ bool orionldGetEntities(ConnectionInfo* ciP)
         // Transform the Database model into a "valid" NGSI-LD tree
         for (KjNode* dbEntityP = dbEntityArray->value.firstChildP; dbEntityP != NULL; dbEntityP = dbEntityP->next)
         {
-          OrionldProblemDetails pd;
-          KjNode*               entityP = dmodelEntity(dbEntityP, false, &pd);
+          KjNode* entityP = dbModelToApiEntity(dbEntityP, false, false);
 
           if (entityP != NULL)
             kjChildAdd(orionldState.geoPropertyNodes, entityP);
@@ -576,12 +551,10 @@ bool orionldGetEntities(ConnectionInfo* ciP)
   if (countP != NULL)
   {
     char cV[32];
-    snprintf(cV, sizeof(cV), "%llu", *countP);
+    snprintf(cV, sizeof(cV), "%d", *countP);
     ciP->httpHeader.push_back("NGSILD-Results-Count");
     ciP->httpHeaderValue.push_back(cV);
   }
 
-  mongoRequest.release();
-
   return true;
 }
@@ -36,45 +36,24 @@ extern "C"
 
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
-#include "orionld/types/OrionldProblemDetails.h"                 // OrionldProblemDetails
 #include "orionld/rest/OrionLdRestService.h"                     // OrionLdRestService
-#include "orionld/db/dbConfiguration.h"                          // dbEntityTypeGet
+#include "orionld/mongoc/mongocCatalogGet.h"                     // mongocCatalogGet
 #include "orionld/context/orionldContextItemExpand.h"            // orionldContextItemExpand
 #include "orionld/context/orionldContextItemAliasLookup.h"       // orionldContextItemAliasLookup
-#include "orionld/kjTree/kjStringValueLookupInArray.h"           // kjStringValueLookupInArray
 #include "orionld/serviceRoutines/orionldGetEntityType.h"        // Own Interface
 
 
 
-// -----------------------------------------------------------------------------
-//
-// kjAttrIdLookup - match a value for 'id' field in object array
-//
-static KjNode* kjAttrIdLookup(KjNode* arrayP, const char* attrName)
-{
-  for (KjNode* attrP = arrayP->value.firstChildP; attrP != NULL; attrP = attrP->next)
-  {
-    KjNode* idNodeP = kjLookup(attrP, "id");
-    if ((idNodeP == NULL) || (idNodeP->type != KjString))
-      continue;
-
-    if (strcmp(idNodeP->value.s, attrName) == 0)
-      return attrP;
-  }
-
-  return NULL;
-}
-
-
-
 // ----------------------------------------------------------------------------
 //
 // outAttrCreate -
 //
-static void outAttrCreate(KjNode* attributeDetailsNodeP, const char* attrName, const char* attrType)
+// 'attrTypesP' is the object of attribute types of the attribute, from the entity catalog:
+//   { "Property": 12, "Relationship": 1 }
+//
+static void outAttrCreate(KjNode* attributeDetailsNodeP, const char* attrName, KjNode* attrTypesP)
 {
   char*   attrNameAlias       = orionldContextItemAliasLookup(orionldState.contextP, attrName, NULL, NULL);
-  char*   attrTypeAlias       = orionldContextItemAliasLookup(orionldState.contextP, attrType, NULL, NULL);
 
   KjNode* attrObjectP         = kjObject(orionldState.kjsonP, NULL);
   KjNode* idNodeP             = kjString(orionldState.kjsonP, "id", attrName);
@@ -82,9 +61,13 @@ static void outAttrCreate(KjNode* attributeDetailsNodeP, const char* attrName, c
   KjNode* attributeNameNodeP  = kjString(orionldState.kjsonP, "attributeName", attrNameAlias);
   KjNode* attributeTypesNodeP = kjArray(orionldState.kjsonP,  "attributeTypes");
 
-  KjNode* attrTypeAliasNodeP  = kjString(orionldState.kjsonP, NULL, attrTypeAlias);
+  for (KjNode* attrTypeP = attrTypesP->value.firstChildP; attrTypeP != NULL; attrTypeP = attrTypeP->next)
+  {
+    char*   attrTypeAlias      = orionldContextItemAliasLookup(orionldState.contextP, attrTypeP->name, NULL, NULL);
+    KjNode* attrTypeAliasNodeP = kjString(orionldState.kjsonP, NULL, attrTypeAlias);
 
-  kjChildAdd(attributeTypesNodeP, attrTypeAliasNodeP);
+    kjChildAdd(attributeTypesNodeP, attrTypeAliasNodeP);
+  }
 
   kjChildAdd(attrObjectP, idNodeP);
   kjChildAdd(attrObjectP, typeNodeP);
@@ -96,30 +79,6 @@ static void outAttrCreate(KjNode* attributeDetailsNodeP, const char* attrName, c
 
 
 
-// ----------------------------------------------------------------------------
-//
-// outAttrInfoAdd -
-//
-static void outAttrInfoAdd(KjNode* outAttrP, const char* attrType)
-{
-  KjNode* attributeTypesNodeP = kjLookup(outAttrP, "attributeTypes");
-
-  if (attributeTypesNodeP == NULL)
-    return;
-
-  //
-  // Is attrType already present in attributeTypesNodeP?
-  // If not, add it
-  //
-  if (kjStringValueLookupInArray(attributeTypesNodeP, attrType) == NULL)
-  {
-    KjNode* attrTypeNodeP = kjString(orionldState.kjsonP, NULL, attrType);
-    kjChildAdd(attributeTypesNodeP, attrTypeNodeP);
-  }
-}
-
-
-
 // ----------------------------------------------------------------------------
 //
 // orionldGetEntityType -
@@ -128,47 +87,29 @@ static void outAttrInfoAdd(KjNode* outAttrP, const char* attrType)
 //
 bool orionldGetEntityType(ConnectionInfo* ciP)
 {
-  OrionldProblemDetails  pd;
-  int                    entities;
-  char*                  typeExpanded = orionldContextItemExpand(orionldState.contextP, orionldState.wildcard[0], true, NULL);
-  char*                  typeAlias    = orionldContextItemAliasLookup(orionldState.contextP, typeExpanded, NULL, NULL);
-  KjNode*                entityTypeV;
+  char*    typeExpanded = orionldContextItemExpand(orionldState.contextP, orionldState.wildcard[0], true, NULL);
+  char*    typeAlias    = orionldContextItemAliasLookup(orionldState.contextP, typeExpanded, NULL, NULL);
+  KjNode*  catalogP     = mongocCatalogGet(typeExpanded);
+  KjNode*  typeP        = catalogP->value.firstChildP;
 
-  entityTypeV = dbEntityTypeGet(&pd, typeExpanded, &entities);
-
-  if (entityTypeV == NULL)
+  if (typeP == NULL)
   {
-    // dbEntityTypeGet has filled in 'pd'
-    return false;
-  }
-  else if (entities == 0)
-  {
-    LM_E(("dbEntityTypeGet: no entities found"));
+    LM_E(("mongocCatalogGet: no entities found"));
     orionldErrorResponseCreate(OrionldResourceNotFound, "Entity Type Not Found", typeExpanded);
     orionldState.httpStatusCode = 404;
     return false;
   }
 
   //
-  // The output  from dbEntityTypeGet is as follows:
-  // [
-  //   {
-  //     "https://uri.etsi.org/ngsi-ld/default-context/P1": "Property",
-  //     "https://uri.etsi.org/ngsi-ld/default-context/R1": "Relationship"
-  //   },
-  //   {
-  //     "https://uri.etsi.org/ngsi-ld/default-context/P2": "Property",
-  //     "https://uri.etsi.org/ngsi-ld/default-context/R2": "Relationship"
-  //   },
-  //   {
-  //     "https://uri.etsi.org/ngsi-ld/default-context/P1": "Property",
-  //     "https://uri.etsi.org/ngsi-ld/default-context/P2": "Property",
-  //     "https://uri.etsi.org/ngsi-ld/default-context/R1": "Relationship",
-  //     "https://uri.etsi.org/ngsi-ld/default-context/R2": "Relationship"
+  // The entity catalog has one document per entity type:
+  // {
+  //   "_id":      "https://uri.etsi.org/ngsi-ld/default-context/T",
+  //   "entities": 27,
+  //   "attrs": {
+  //     "https://uri.etsi.org/ngsi-ld/default-context/P1": { "Property": 27 },
+  //     "https://uri.etsi.org/ngsi-ld/default-context/R1": { "Relationship": 3 }
   //   }
-  // ]
-  //
-  // So, now we need to loop over the objects (attribute lists) and populate the output object with it
+  // }
   //
   // The output object looks like this:
   // {
@@ -189,12 +130,15 @@ bool orionldGetEntityType(ConnectionInfo* ciP)
   //   ]
   // }
   //
+  KjNode* entitiesP = kjLookup(typeP, "entities");
+  KjNode* attrsP    = kjLookup(typeP, "attrs");
+
   orionldState.responseTree = kjObject(orionldState.kjsonP, NULL);
 
   KjNode* idNodeP               = kjString(orionldState.kjsonP, "id", typeExpanded);
   KjNode* typeNodeP             = kjString(orionldState.kjsonP, "type", "EntityTypeInformation");
   KjNode* typeNameNodeP         = kjString(orionldState.kjsonP, "typeName", typeAlias);
-  KjNode* entityCountNodeP      = kjInteger(orionldState.kjsonP, "entityCount", entities);
+  KjNode* entityCountNodeP      = kjInteger(orionldState.kjsonP, "entityCount", entitiesP->value.i);
   KjNode* attributeDetailsNodeP = kjArray(orionldState.kjsonP, "attributeDetails");
 
   kjChildAdd(orionldState.responseTree, idNodeP);
@@ -204,20 +148,13 @@ bool orionldGetEntityType(ConnectionInfo* ciP)
   kjChildAdd(orionldState.responseTree, attributeDetailsNodeP);
 
   //
-  // Now populate 'attributeDetailsNodeP' with the info from 'entityTypeV'
+  // Now populate 'attributeDetailsNodeP' with the attributes of the catalog document
   //
-  for (KjNode* dbEntityP = entityTypeV->value.firstChildP; dbEntityP != NULL; dbEntityP = dbEntityP->next)
+  if (attrsP != NULL)
   {
-    // Loop over all attrs of entityP
-    for (KjNode* dbAttrP = dbEntityP->value.firstChildP; dbAttrP != NULL; dbAttrP = dbAttrP->next)
+    for (KjNode* attrP = attrsP->value.firstChildP; attrP != NULL; attrP = attrP->next)
     {
-      // Attr already present in attributeDetailsNodeP?
-      KjNode* outAttrP = kjAttrIdLookup(attributeDetailsNodeP, dbAttrP->name);
-
-      if (outAttrP == NULL)
-        outAttrCreate(attributeDetailsNodeP, dbAttrP->name, dbAttrP->value.s);
-      else
-        outAttrInfoAdd(outAttrP, dbAttrP->value.s);
+      outAttrCreate(attributeDetailsNodeP, attrP->name, attrP);
     }
   }
 
@@ -22,12 +22,24 @@
 *
 * Author: Ken Zangelin
 */
-#include "logMsg/logMsg.h"
+#include <stdio.h>                                               // snprintf
 
-#include "rest/ConnectionInfo.h"
-#include "orionld/common/orionldState.h"                         // orionldState
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "rest/ConnectionInfo.h"                                 // ConnectionInfo
+#include "rest/httpHeaderAdd.h"                                  // httpHeaderAdd
+#include "orionld/common/orionldState.h"                         // orionldState, troe
 #include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
 #include "orionld/rest/OrionLdRestService.h"                     // OrionLdRestService
+#include "orionld/troe/TemporalQuery.h"                          // TemporalQuery
+#include "orionld/troe/temporalQueryFromUriParams.h"             // temporalQueryFromUriParams
+#include "orionld/troe/pgTemporalQuery.h"                        // pgTemporalQuery
 #include "orionld/serviceRoutines/orionldGetTemporalEntities.h"  // Own Interface
 
 
@@ -36,11 +48,50 @@
 //
 // orionldGetTemporalEntities -
 //
+// The temporal representation of entities is read from the TRoE database - see pgTemporalQuery
+//
+// URI params:
+// - id, idPattern, type
+// - attrs
+// - timerel, timeAt, endTimeAt, timeproperty
+// - lastN
+// - limit, offset, count
+// - options=temporalValues,sysAttrs
+//
 bool orionldGetTemporalEntities(ConnectionInfo* ciP)
 {
-  orionldState.httpStatusCode = 501;
-  orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
+  if (troe == false)
+  {
+    orionldState.httpStatusCode = 501;
+    orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
+
+    orionldErrorResponseCreate(OrionldOperationNotSupported, "Temporal Representation of Entities is not enabled (CLI option -troe)", orionldState.serviceP->url);
+    return false;
+  }
+
+  TemporalQuery tq;
+  int           count = 0;
+
+  if (temporalQueryFromUriParams(&tq, NULL) == false)
+    return false;
+
+  KjNode* entityArrayP = pgTemporalQuery(&tq, &count);
+
+  if (entityArrayP == NULL)
+  {
+    orionldState.httpStatusCode = 500;
+    orionldErrorResponseCreate(OrionldInternalError, "Database Error", "querying the TRoE database");
+    return false;
+  }
+
+  if (tq.count == true)
+  {
+    char number[16];
+
+    snprintf(number, sizeof(number), "%d", count);
+    httpHeaderAdd(ciP, "NGSILD-Results-Count", number);
+  }
 
-  orionldErrorResponseCreate(OrionldOperationNotSupported, "Not Implemented in Orion-LD, please use Mintaka for this operation", orionldState.serviceP->url);
-  return false;
+  orionldState.responseTree = entityArrayP;
+  return true;
 }
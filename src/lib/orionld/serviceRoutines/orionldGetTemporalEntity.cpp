@@ -22,12 +22,21 @@
 *
 * Author: Ken Zangelin
 */
-#include "logMsg/logMsg.h"
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "rest/ConnectionInfo.h"
-#include "orionld/common/orionldState.h"                         // orionldState
+#include "rest/ConnectionInfo.h"                                 // ConnectionInfo
+#include "orionld/common/orionldState.h"                         // orionldState, troe
 #include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
 #include "orionld/rest/OrionLdRestService.h"                     // OrionLdRestService
+#include "orionld/troe/TemporalQuery.h"                          // TemporalQuery
+#include "orionld/troe/temporalQueryFromUriParams.h"             // temporalQueryFromUriParams
+#include "orionld/troe/pgTemporalQuery.h"                        // pgTemporalQuery
 #include "orionld/serviceRoutines/orionldGetTemporalEntity.h"    // Own Interface
 
 
@@ -36,11 +45,46 @@
 //
 // orionldGetTemporalEntity -
 //
+// The temporal representation of the entity is read from the TRoE database - see pgTemporalQuery
+//
 bool orionldGetTemporalEntity(ConnectionInfo* ciP)
 {
-  orionldState.httpStatusCode = 501;
-  orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
+  if (troe == false)
+  {
+    orionldState.httpStatusCode = 501;
+    orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
+
+    orionldErrorResponseCreate(OrionldOperationNotSupported, "Temporal Representation of Entities is not enabled (CLI option -troe)", orionldState.serviceP->url);
+    return false;
+  }
+
+  TemporalQuery tq;
+
+  if (temporalQueryFromUriParams(&tq, orionldState.wildcard[0]) == false)
+    return false;
+
+  tq.offset = 0;
+  tq.limit  = 1;
+  tq.count  = false;
+
+  KjNode* entityArrayP = pgTemporalQuery(&tq, NULL);
+
+  if (entityArrayP == NULL)
+  {
+    orionldState.httpStatusCode = 500;
+    orionldErrorResponseCreate(OrionldInternalError, "Database Error", "querying the TRoE database");
+    return false;
+  }
+
+  if (entityArrayP->value.firstChildP == NULL)
+  {
+    orionldState.httpStatusCode = 404;
+    orionldErrorResponseCreate(OrionldResourceNotFound, "Entity Not Found", orionldState.wildcard[0]);
+    return false;
+  }
+
+  orionldState.responseTree       = entityArrayP->value.firstChildP;
+  orionldState.responseTree->next = NULL;
 
-  orionldErrorResponseCreate(OrionldOperationNotSupported, "Not Implemented in Orion-LD, please use Mintaka for this operation", orionldState.serviceP->url);
-  return false;
+  return true;
 }
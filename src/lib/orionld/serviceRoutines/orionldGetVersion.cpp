@@ -51,14 +51,45 @@ extern "C"
 #include "serviceRoutines/versionTreat.h"                      // versionGet
 #include "cache/subCache.h"                                    // subCacheItems
 #include "orionld/common/pqHeader.h"                           // Postgres header
-#include "orionld/common/orionldState.h"                       // orionldState, orionldVersion
+#include "orionld/common/orionldState.h"                       // orionldState, orionldVersion, mongocClientPool
 #include "orionld/common/branchName.h"                         // ORIONLD_BRANCH
 #include "orionld/troe/pgConnectionGet.h"                      // pgConnectionGet
 #include "orionld/troe/pgConnectionRelease.h"                  // pgConnectionRelease
+#include "orionld/troe/troeWriter.h"                           // troeWriterMetrics, troeWriterMutex
+#include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool, PgConnectionPoolMetrics
+#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster, pgConnectionPoolIndex
+#include "orionld/rest/orionldRequestWorker.h"                 // orionldRequestWorkerMetrics, orionldRequestWorkerMutex
+#include "orionld/common/orionldArena.h"                       // OrionldArena, orionldArenaList, orionldArenaMutex
 #include "orionld/serviceRoutines/orionldGetVersion.h"         // Own Interface
 
 
 
+// ----------------------------------------------------------------------------
+//
+// pgPoolMetricsAdd - add the metrics of one connection pool to the accumulated metrics of all pools
+//
+static void pgPoolMetricsAdd(PgConnectionPoolMetrics* totalP, int* sizeP, PgConnectionPool* poolP)
+{
+  PgConnectionPoolMetrics* mP = &poolP->metrics;
+
+  *sizeP             += poolP->items;
+  totalP->gets       += __atomic_load_n(&mP->gets,        __ATOMIC_RELAXED);
+  totalP->waits      += __atomic_load_n(&mP->waits,       __ATOMIC_RELAXED);
+  totalP->timeouts   += __atomic_load_n(&mP->timeouts,    __ATOMIC_RELAXED);
+  totalP->waitTime   += __atomic_load_n(&mP->waitTime,    __ATOMIC_RELAXED);
+  totalP->connects   += __atomic_load_n(&mP->connects,    __ATOMIC_RELAXED);
+  totalP->reconnects += __atomic_load_n(&mP->reconnects,  __ATOMIC_RELAXED);
+  totalP->errors     += __atomic_load_n(&mP->errors,      __ATOMIC_RELAXED);
+  totalP->inUse      += __atomic_load_n(&mP->inUse,       __ATOMIC_RELAXED);
+  totalP->maxInUse   += __atomic_load_n(&mP->maxInUse,    __ATOMIC_RELAXED);
+
+  long long maxWaitTime = __atomic_load_n(&mP->maxWaitTime, __ATOMIC_RELAXED);
+  if (maxWaitTime > totalP->maxWaitTime)
+    totalP->maxWaitTime = maxWaitTime;
+}
+
+
+
 // ----------------------------------------------------------------------------
 //
 // mhdVersionGet -
@@ -170,6 +201,30 @@ bool orionldGetVersion(ConnectionInfo* ciP)
   nodeP = kjString(orionldState.kjsonP, "mongodb server version", mongoServerVersion);
   kjChildAdd(orionldState.responseTree, nodeP);
 
+  //
+  // Mongo C Driver client pool
+  //
+  KjNode* mongocPoolP = kjObject(orionldState.kjsonP, "mongoc client pool");
+
+  nodeP = kjInteger(orionldState.kjsonP, "size", mongocClientPool.size);
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "clients", __atomic_load_n(&mongocClientPool.clients, __ATOMIC_ACQUIRE));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "in use", __atomic_load_n(&mongocClientPool.metrics.inUse, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "max in use", __atomic_load_n(&mongocClientPool.metrics.maxInUse, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "pops", __atomic_load_n(&mongocClientPool.metrics.pops, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "waits", __atomic_load_n(&mongocClientPool.metrics.waits, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "wait time (us)", __atomic_load_n(&mongocClientPool.metrics.waitTime, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+  nodeP = kjInteger(orionldState.kjsonP, "max wait time (us)", __atomic_load_n(&mongocClientPool.metrics.maxWaitTime, __ATOMIC_RELAXED));
+  kjChildAdd(mongocPoolP, nodeP);
+
+  kjChildAdd(orionldState.responseTree, mongocPoolP);
+
 
   // Libs needed by the "direct libs"
   nodeP = kjString(orionldState.kjsonP, "boost version", BOOST_LIB_VERSION);
@@ -208,8 +263,163 @@ bool orionldGetVersion(ConnectionInfo* ciP)
 
     nodeP = kjString(orionldState.kjsonP, "postgres server version", pgServerVersionString);
     kjChildAdd(orionldState.responseTree, nodeP);
+
+    //
+    // Postgres Connection Pools - accumulated over all pools (one per tenant)
+    // Pools are never removed while the broker runs, so the index can be traversed without locking it
+    //
+    PgConnectionPoolMetrics  pools      = {};
+    int                      poolSize   = 0;
+    int                      noOfPools  = 0;
+
+    if (pgPoolMaster != NULL)
+    {
+      pgPoolMetricsAdd(&pools, &poolSize, pgPoolMaster);
+      ++noOfPools;
+    }
+
+    for (int ix = 0; ix < PG_CONNECTION_POOL_INDEX_SIZE; ix++)
+    {
+      PgConnectionPool* poolP = __atomic_load_n(&pgConnectionPoolIndex[ix], __ATOMIC_ACQUIRE);
+
+      while (poolP != NULL)
+      {
+        pgPoolMetricsAdd(&pools, &poolSize, poolP);
+        ++noOfPools;
+        poolP = poolP->next;
+      }
+    }
+
+    KjNode* poolsP = kjObject(orionldState.kjsonP, "postgres connection pools");
+
+    nodeP = kjInteger(orionldState.kjsonP, "pools", noOfPools);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "connections", poolSize);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "in use", pools.inUse);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "max in use", pools.maxInUse);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "gets", pools.gets);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "waits", pools.waits);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "timeouts", pools.timeouts);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "wait time (us)", pools.waitTime);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "max wait time (us)", pools.maxWaitTime);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "connects", pools.connects);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "reconnects", pools.reconnects);
+    kjChildAdd(poolsP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "connect errors", pools.errors);
+    kjChildAdd(poolsP, nodeP);
+
+    kjChildAdd(orionldState.responseTree, poolsP);
+
+    //
+    // TRoE Writers
+    //
+    if (troeWriters > 0)
+    {
+      TroeWriterMetrics metrics;
+
+      pthread_mutex_lock(&troeWriterMutex);
+      metrics = troeWriterMetrics;
+      pthread_mutex_unlock(&troeWriterMutex);
+
+      KjNode* writersP = kjObject(orionldState.kjsonP, "troe writers");
+
+      nodeP = kjInteger(orionldState.kjsonP, "threads", troeWriters);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "requests", metrics.requests);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "batches", metrics.batches);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "statements", metrics.statements);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "bytes", metrics.bytes);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "errors", metrics.errors);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "waits", metrics.waits);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "queued bytes", metrics.queuedBytes);
+      kjChildAdd(writersP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "max queued bytes", metrics.maxQueuedBytes);
+      kjChildAdd(writersP, nodeP);
+
+      kjChildAdd(orionldState.responseTree, writersP);
+    }
+  }
+
+
+  //
+  // Request Workers
+  //
+  if (httpWorkers > 0)
+  {
+    OrionldRequestWorkerMetrics metrics;
+
+    pthread_mutex_lock(&orionldRequestWorkerMutex);
+    metrics = orionldRequestWorkerMetrics;
+    pthread_mutex_unlock(&orionldRequestWorkerMutex);
+
+    KjNode* workersP = kjObject(orionldState.kjsonP, "request workers");
+
+    nodeP = kjInteger(orionldState.kjsonP, "threads", httpWorkers);
+    kjChildAdd(workersP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "requests", metrics.requests);
+    kjChildAdd(workersP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "busy", metrics.busy);
+    kjChildAdd(workersP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "queued", metrics.queued);
+    kjChildAdd(workersP, nodeP);
+    nodeP = kjInteger(orionldState.kjsonP, "max queued", metrics.maxQueued);
+    kjChildAdd(workersP, nodeP);
+
+    kjChildAdd(orionldState.responseTree, workersP);
   }
 
+  //
+  // Thread Arenas - one item per thread
+  //
+  if (arenaRetain > 0)
+  {
+    KjNode* arenasP = kjArray(orionldState.kjsonP, "thread arenas");
+
+    pthread_mutex_lock(&orionldArenaMutex);
+    for (OrionldArena* arenaP = orionldArenaList; arenaP != NULL; arenaP = arenaP->next)
+    {
+      KjNode* arenaNodeP = kjObject(orionldState.kjsonP, NULL);
+
+      nodeP = kjInteger(orionldState.kjsonP, "thread", arenaP->id);
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "requests", __atomic_load_n(&arenaP->metrics.requests, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "allocs", __atomic_load_n(&arenaP->metrics.allocs, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "hits", __atomic_load_n(&arenaP->metrics.hits, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "mallocs", __atomic_load_n(&arenaP->metrics.mallocs, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "frees", __atomic_load_n(&arenaP->metrics.frees, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "in use", __atomic_load_n(&arenaP->metrics.inUse, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "retained", __atomic_load_n(&arenaP->metrics.retained, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+      nodeP = kjInteger(orionldState.kjsonP, "max retained", __atomic_load_n(&arenaP->metrics.maxRetained, __ATOMIC_RELAXED));
+      kjChildAdd(arenaNodeP, nodeP);
+
+      kjChildAdd(arenasP, arenaNodeP);
+    }
+    pthread_mutex_unlock(&orionldArenaMutex);
+
+    kjChildAdd(orionldState.responseTree, arenasP);
+  }
 
   // Branch
   nodeP = kjString(orionldState.kjsonP, "branch", ORIONLD_BRANCH);
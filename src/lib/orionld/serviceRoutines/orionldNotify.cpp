@@ -22,9 +22,11 @@
 *
 * Author: Ken Zangelin
 */
-#include <string.h>                                              // strlen
-#include <sys/uio.h>                                             // writev
-#include <sys/select.h>                                          // select
+#include <string.h>                                              // strlen, strcpy
+#include <errno.h>                                               // errno
+#include <unistd.h>                                              // close, read
+#include <poll.h>                                                // poll
+#include <sys/uio.h>                                             // struct iovec, writev
 
 extern "C"
 {
@@ -32,6 +34,7 @@ extern "C"
 #include "kjson/kjRender.h"                                      // kjFastRender
 #include "kjson/kjBuilder.h"                                     // kjObject, kjArray, kjString, kjChildAdd, ...
 #include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
 }
 
 #include "logMsg/logMsg.h"
@@ -40,8 +43,8 @@ extern "C"
 #include "orionld/common/orionldState.h"                         // orionldState, coreContextUrl
 #include "orionld/common/numberToDate.h"                         // numberToDate
 #include "orionld/common/uuidGenerate.h"                         // uuidGenerate
-#include "orionld/common/orionldServerConnect.h"                 // orionldServerConnect
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/common/orionldServerConnect.h"                 // orionldServerConnect
 #include "orionld/serviceRoutines/orionldNotify.h"               // Own interface
 
 
@@ -76,49 +79,105 @@ static void ipPortAndRest(char* ipport, char** ipP, unsigned short* portP, char*
     rest = &colon[1];
   }
 
+  rest = strchr(rest, '/');
+
+  if ((colon == NULL) && (rest != NULL))
+  {
+    // No port - the host ends where the URL-PATH starts, and that slash must stay
+    int   hostLen = rest - ip;
+    char* host    = kaAlloc(&orionldState.kalloc, hostLen + 1);
+
+    strncpy(host, ip, hostLen);
+    host[hostLen] = 0;
+    ip            = host;
+  }
+
   *ipP   = ip;
   *portP = portNo;
+  *restP = (rest != NULL)? rest : (char*) "/";
+}
 
-  rest = strchr(rest, '/');
-  *restP = rest;
+
+
+// -----------------------------------------------------------------------------
+//
+// dataPayloadRender - render the item of the "data" array of a notification
+//
+// The buffer is allocated (in the kalloc of the request) with the exact size from the render-size pass.
+//
+static char* dataPayloadRender(KjNode* attrsForNotification)
+{
+  char* payload = kaAlloc(&orionldState.kalloc, kjFastRenderSize(attrsForNotification));
+
+  kjFastRender(attrsForNotification, payload);
+
+  return payload;
 }
 
 
 
 // -----------------------------------------------------------------------------
 //
-// responseTreat -
+// notificationResponsesAwait - wait for the responses of the receivers, with a timeout, and close the connections
 //
-static void responseTreat(OrionldNotificationInfo* niP, char* buf, int bufLen)
+static void notificationResponsesAwait(int* fdV, int fds)
 {
-  int    nb             = read(niP->fd, buf, bufLen);
-  char*  firstLine      = NULL;
-  char*  endOfFirstLine = NULL;
+  struct pollfd  pollV[ORIONLD_NOTIFICATION_INFO_MAX];
+  int            pending   = 0;
+  int            timeoutMs = 5000;
 
-  if (nb == -1)
+  for (int ix = 0; ix < fds; ix++)
   {
-    LM_E(("Internal Error (error reading from notification endpoint: %s)", strerror(errno)));
-    return;
-  }
+    if (fdV[ix] == -1)
+      continue;
 
-  //
-  //
-  //
-  firstLine      = buf;
-  endOfFirstLine = strchr(firstLine, '\n');
+    pollV[pending].fd      = fdV[ix];
+    pollV[pending].events  = POLLIN;
+    pollV[pending].revents = 0;
+    ++pending;
+  }
 
-  if (endOfFirstLine == NULL)
+  while (pending > 0)
   {
-    LM_E(("Internal Error (unable to find end of first line from notification endpoint: %s)", strerror(errno)));
-    return;
-  }
+    int fdsReady = poll(pollV, pending, timeoutMs);
+
+    if (fdsReady <= 0)
+    {
+      if (fdsReady == 0)
+        LM_W(("Timeout awaiting the response of %d notification receiver(s)", pending));
+      else
+        LM_E(("poll: %s", strerror(errno)));
+      break;
+    }
 
-  *endOfFirstLine = 0;
+    for (int ix = 0; ix < pending; ix++)
+    {
+      if (pollV[ix].revents == 0)
+        continue;
 
-  //
-  // FIXME: Read the rest of the message, using select
-  //
-  niP->allOK = true;
+      char buf[256];
+      int  nb = read(pollV[ix].fd, buf, sizeof(buf) - 1);
+
+      if (nb > 0)
+      {
+        buf[nb] = 0;
+        if (strncmp(buf, "HTTP/1.1 2", 10) != 0)
+          LM_W(("Notification not accepted by the receiver: %s", buf));
+      }
+
+      close(pollV[ix].fd);
+
+      // Out of the poll vector
+      pollV[ix] = pollV[pending - 1];
+      --pending;
+      --ix;
+    }
+  }
+
+  for (int ix = 0; ix < pending; ix++)
+  {
+    close(pollV[ix].fd);
+  }
 }
 
 
@@ -135,37 +194,21 @@ static void responseTreat(OrionldNotificationInfo* niP, char* buf, int bufLen)
 //
 // All attribute names and the entity type are assumed to be already aliased according to the context
 //
+// All notifications are sent before awaiting any response, so the request thread waits for the slowest
+// receiver only, not for the sum of them all.
+//
+// The body of a notification is sent in three parts:
+//   1. {"id": "urn:ngsi-ld:Notification:X", "type": "Notification", "subscriptionId": S, "notifiedAt": T, "data": [
+//   2. the entity (attrsForNotification)
+//   3. ]}
+// Part 1 is rendered after the HTTP headers, in the same buffer.
+// Part 2 is rendered only once for all subscriptions notifying the same 'attrsForNotification', and shared.
+//
 void orionldNotify(void)
 {
-  //
-  // Preparing the HTTP headers which will be pretty much the same for all notifications
-  // What differs is Content-Length, Content-Type, and the Request header
-  //
-  char  requestHeader[128];
-  char  contentLenHeader[32];
-  char* lenP                    = &contentLenHeader[16];
-  char* contentTypeHeaderJson   = (char*) "Content-Type: application/json\r\n";
-  char* contentTypeHeaderJsonLd = (char*) "Content-Type: application/ld+json\r\n";
-  char* userAgentHeader         = (char*) "User-Agent: orionld\r\n\r\n";  // Double newline - must be the last HTTP header
-  int   payloadLen              = 10000;
-  char* payload                 = (char*) malloc(payloadLen + 1);
-
-  if (payload == NULL)
-    LM_X(1, ("Unable to allocate room for notification!"));
-
-  strcpy(contentLenHeader, "Content-Length: 0");  // Can't modify inside static strings, so need a char-vec on the stack for contentLenHeader
-
-  //
-  // struct iovec
-  // {
-  //   void  *iov_base;    /* Starting address */
-  //   size_t iov_len;     /* Number of bytes to transfer */
-  // };
-  //
-  int           contentLength;
-  struct iovec  ioVec[6]        = { { requestHeader, 0 }, { contentLenHeader, 0 }, { contentTypeHeaderJson, 32 }, { userAgentHeader, 23 }, { payload, 0 } };
-  int           ioVecLen        = 5;
-  char          requestTimeV[64];
+  char*  dataPayloadV[ORIONLD_NOTIFICATION_INFO_MAX];
+  int    fdV[ORIONLD_NOTIFICATION_INFO_MAX];
+  char   requestTimeV[64];
 
   if (numberToDate(orionldState.requestTime, requestTimeV, sizeof(requestTimeV)) == false)
   {
@@ -181,6 +224,26 @@ void orionldNotify(void)
     char*                     rest;
     KjNode*                   notificationTree;
     char                      notificationId[80];
+    char*                     dataPayloadP = NULL;
+
+    dataPayloadV[ix] = NULL;
+    fdV[ix]          = -1;
+
+    //
+    // Same entity as an earlier notification? Then its rendered payload is shared
+    //
+    for (int prevIx = 0; prevIx < ix; prevIx++)
+    {
+      if (orionldState.notificationInfo[prevIx].attrsForNotification == niP->attrsForNotification)
+      {
+        dataPayloadP = dataPayloadV[prevIx];
+        break;
+      }
+    }
+
+    if (dataPayloadP == NULL)
+      dataPayloadP = dataPayloadRender(niP->attrsForNotification);
+    dataPayloadV[ix] = dataPayloadP;
 
     notificationTree = kjObject(orionldState.kjsonP, NULL);
 
@@ -188,21 +251,11 @@ void orionldNotify(void)
     uuidGenerate(&notificationId[25], sizeof(notificationId) - 25, false);
 
     ipPortAndRest(niP->reference, &ip, &port, &rest);
-    snprintf(requestHeader, sizeof(requestHeader), "POST %s HTTP/1.1\r\n", rest);
+
+    const char* linkUrl = NULL;
 
     if (niP->mimeType == JSONLD)
     {
-      //
-      // For better tput, I could maintain not one ioVec but TWO.
-      // One for "application/json" and another one for "application/ld+json"
-      //
-
-      //
-      // Overwrite contentTypeHeaderJson in ioVec[2]
-      //
-      ioVec[2].iov_base = contentTypeHeaderJsonLd;
-      ioVec[2].iov_len  = 35;
-
       // Add @context to payload
       if ((orionldState.contextP == NULL) || (orionldState.contextP == orionldCoreContextP))
       {
@@ -211,32 +264,25 @@ void orionldNotify(void)
         kjChildAdd(notificationTree, contextStringNodeP);
       }
       else if (orionldState.contextP->tree != NULL)
-        kjChildAdd(notificationTree, orionldState.contextP->tree);
+      {
+        //
+        // A shallow copy of the context tree, not to modify the 'next' pointer of the tree of the context
+        //
+        KjNode* contextNodeP = (KjNode*) kaAlloc(&orionldState.kalloc, sizeof(KjNode));
+
+        *contextNodeP      = *orionldState.contextP->tree;
+        contextNodeP->name = (char*) "@context";
+        contextNodeP->next = NULL;
+        kjChildAdd(notificationTree, contextNodeP);
+      }
       else
         LM_E(("Internal Error (context has no tree ...)"));
     }
     else
-    {
-      //
-      // Add Link HTTP header
-      //
-      ioVecLen = 6;
-
-      // Move down PAYLOAD
-      ioVec[5].iov_base = ioVec[4].iov_base;
-      ioVec[5].iov_len  = ioVec[4].iov_len;
-
-      // Move down userAgentHeader - must be the last as it contains the double \r\n
-      ioVec[4].iov_base = ioVec[3].iov_base;
-      ioVec[4].iov_len  = ioVec[3].iov_len;
-
-      // Now ioVec[3] is free for the Link header
-      ioVec[3].iov_base = orionldState.contextP->url;
-      ioVec[3].iov_len  = strlen(orionldState.contextP->url);
-    }
+      linkUrl = ((orionldState.contextP == NULL) || (orionldState.contextP->url == NULL))? coreContextUrl : orionldState.contextP->url;
 
     //
-    // Fix payload
+    // Start of the payload
     //
     // The entity id/type + attribute list go into an object inside a vector called data.
     // In the case of POST /entities/*/attrs, as there is only ONE entity, there will be only ONE item in the data vector
@@ -252,127 +298,75 @@ void orionldNotify(void)
     KjNode* typeNodeP            = kjString(orionldState.kjsonP, "type", "Notification");
     KjNode* subscriptionIdNodeP  = kjString(orionldState.kjsonP, "subscriptionId", niP->subscriptionId);
     KjNode* notifiedAtNodeP      = kjString(orionldState.kjsonP, "notifiedAt", requestTimeV);
-    KjNode* dataNodeP            = kjArray(orionldState.kjsonP,  "data");
 
     kjChildAdd(notificationTree, idNodeP);
     kjChildAdd(notificationTree, typeNodeP);
     kjChildAdd(notificationTree, subscriptionIdNodeP);
     kjChildAdd(notificationTree, notifiedAtNodeP);
-    kjChildAdd(notificationTree, dataNodeP);
-    kjChildAdd(dataNodeP, niP->attrsForNotification);
-
-    int renderedSize = kjFastRenderSize(notificationTree);
 
-    if (renderedSize > payloadLen)
-    {
-      LM_W(("No Room in the notification buffer"));
-      strncpy(payload, "{\"error\": \"Implementation problem in Orion-LD - the notification buffer size needs a smarter allocation algorithm\"}", payloadLen);
-    }
-    else
-      kjFastRender(notificationTree, payload);
-
-    int sizeLeftForLen = 16;  // sizeof(contentLenHeader) - 16
-    contentLength = strlen(payload);
-    snprintf(lenP, sizeLeftForLen, "%d\r\n", contentLength);  // Writing Content-Length inside contentLenHeader
-
-    ioVec[0].iov_len = strlen(requestHeader);
-    ioVec[1].iov_len = strlen(contentLenHeader);
-    ioVec[4].iov_len = contentLength;
+    //
+    // The HTTP headers and the start of the payload, in one buffer
+    //
+    int   bodyStartSize = kjFastRenderSize(notificationTree) + 16;  // 16: room for replacing the closing '}' with ',"data":['
+    int   headSize      = 512 + strlen(rest) + strlen(ip) + ((linkUrl != NULL)? strlen(linkUrl) : 0) + bodyStartSize;
+    char* headBuf       = kaAlloc(&orionldState.kalloc, headSize);
 
     //
-    // Data ready to send
+    // The payload start is rendered first, after room for the HTTP headers, as Content-Length is needed for the headers
     //
-    niP->fd = orionldServerConnect(ip, port);
+    char* bodyStart   = &headBuf[headSize - bodyStartSize];
+    int   headersSize = bodyStart - headBuf;
 
-    if (niP->fd == -1)
-    {
-      niP->connected = false;
-      LM_E(("Internal Error (unable to connent to server for notification for subscription '%s': %s)", niP->subscriptionId, strerror(errno)));
-      continue;
-    }
+    kjFastRender(notificationTree, bodyStart);
 
-    niP->connected = true;
+    int bodyStartLen = strlen(bodyStart);
 
-    if (writev(niP->fd, ioVec, ioVecLen) == -1)
-    {
-      close(niP->fd);
+    // Replace the closing '}' with the start of the "data" array
+    strcpy(&bodyStart[bodyStartLen - 1], ",\"data\":[");
+    bodyStartLen += 8;
 
-      niP->fd        = -1;
-      niP->connected = false;
+    int dataPayloadLen = strlen(dataPayloadP);
+    int contentLength  = bodyStartLen + dataPayloadLen + 2;  // 2: the trailer "]}"
+    int headersLen;
 
-      LM_E(("Internal Error (unable to send to server for notification for subscription '%s'): %s", niP->subscriptionId, strerror(errno)));
-      continue;
-    }
-  }
+    if (linkUrl != NULL)
+      headersLen = snprintf(headBuf, headersSize, "POST %s HTTP/1.1\r\nHost: %s:%d\r\nContent-Length: %d\r\nContent-Type: application/json\r\n"
+                            "Link: <%s>; rel=\"http://www.w3.org/ns/json-ld#context\"; type=\"application/ld+json\"\r\nUser-Agent: orionld\r\n\r\n",
+                            rest, ip, port, contentLength, linkUrl);
+    else
+      headersLen = snprintf(headBuf, headersSize, "POST %s HTTP/1.1\r\nHost: %s:%d\r\nContent-Length: %d\r\nContent-Type: application/ld+json\r\nUser-Agent: orionld\r\n\r\n",
+                            rest, ip, port, contentLength);
 
-  //
-  // Receive responses
-  //
-  int             fds;
-  fd_set          rFds;
-  int             fdMax      = 0;
-  int             startTime  = time(NULL);
-  struct timeval  tv         = { 1, 0 };
+    struct iovec ioVec[4] =
+    {
+      { headBuf,            (size_t) headersLen     },
+      { bodyStart,          (size_t) bodyStartLen   },
+      { dataPayloadP,       (size_t) dataPayloadLen },
+      { (char*) "]}",       2                       }
+    };
 
-  while (1)
-  {
     //
-    // Set File Descriptors for the select
+    // Data ready to send
     //
-    FD_ZERO(&rFds);
-    for (int ix = 0; ix < orionldState.notificationRecords; ix++)
-    {
-      OrionldNotificationInfo*  niP = &orionldState.notificationInfo[ix];
-
-      if ((niP->fd != -1) && (niP->connected == true))
-      {
-        FD_SET(niP->fd, &rFds);
-        fdMax = MAX(fdMax, niP->fd);
-      }
+    int fd = orionldServerConnect(ip, port);
 
-      niP->allOK = false;  // Set to 'true' once the response of the notification is received
+    if (fd == -1)
+    {
+      LM_E(("Unable to connect to notification receiver %s:%d for subscription %s", ip, port, niP->subscriptionId));
+      continue;
     }
 
-    fds = select(1, &rFds, NULL, NULL, &tv);
-    if ((fds == -1) && (errno != EINTR))
-      LM_X(1, ("select error: %s\n", strerror(errno)));
-    else if (fds > 0)
-    {
-      for (int ix = 0; ix < orionldState.notificationRecords; ix++)
-      {
-        OrionldNotificationInfo*  niP = &orionldState.notificationInfo[ix];
+    int nb = writev(fd, ioVec, 4);
 
-        if (FD_ISSET(niP->fd, &rFds))
-          responseTreat(niP, payload, payloadLen);  // We reuse the allocated buffer 'payload'
-      }
+    if (nb != headersLen + contentLength)
+    {
+      LM_E(("Unable to send notification for subscription %s to %s:%d (written %d of %d bytes)", niP->subscriptionId, ip, port, nb, headersLen + contentLength));
+      close(fd);
+      continue;
     }
 
-    //
-    // Timeout after 10 seconds
-    //
-    // FIXME: calling time() might be avoided by inspecting 'tv'
-    //
-    if (time(NULL) > startTime + 10)
-      break;
+    fdV[ix] = fd;
   }
 
-  free(payload);
-
-  //
-  // Close file descriptors and set lastFailure/lastSuccess
-  //
-  for (int ix = 0; ix < orionldState.notificationRecords; ix++)
-  {
-    OrionldNotificationInfo*  niP = &orionldState.notificationInfo[ix];
-
-    if (niP->fd != -1)
-      close(niP->fd);
-
-#if 0
-    if (niP->allOK == true)
-      dbSubscriptionLastSuccessSet(niP->subscriptionId);
-    else
-      dbSubscriptionLastFailureSet(niP->subscriptionId);
-#endif
-  }
+  notificationResponsesAwait(fdV, orionldState.notificationRecords);
 }
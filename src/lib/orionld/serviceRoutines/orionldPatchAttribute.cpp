@@ -27,6 +27,7 @@
 
 extern "C"
 {
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
 #include "kalloc/kaStrdup.h"                                     // kaStrdup
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjLookup.h"                                      // kjLookup
@@ -37,6 +38,9 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "common/globals.h"                                      // noCache, parse8601Time
+#include "common/sem.h"                                          // cacheSemTake, cacheSemGive
+#include "cache/subCache.h"                                      // CachedSubscription, subCacheMatch
 #include "rest/ConnectionInfo.h"                                 // ConnectionInfo
 #include "ngsi/ContextElement.h"                                 // ContextElement
 #include "mongoBackend/mongoUpdateContext.h"                     // mongoUpdateContext
@@ -49,6 +53,7 @@ extern "C"
 #include "orionld/common/dotForEq.h"                             // dotForEq
 #include "orionld/common/eqForDot.h"                             // eqForDot
 #include "orionld/common/tenantList.h"                           // tenant0
+#include "orionld/common/isSpecialSubAttribute.h"                // isSpecialSubAttribute
 #include "orionld/types/OrionldProblemDetails.h"                 // OrionldProblemDetails
 #include "orionld/payloadCheck/pcheckUri.h"                      // pcheckUri
 #include "orionld/payloadCheck/pcheckAttribute.h"                // pcheckAttribute
@@ -61,6 +66,7 @@ extern "C"
 #include "orionld/kjTree/kjTreeRegistrationInfoExtract.h"        // kjTreeRegistrationInfoExtract
 #include "orionld/kjTree/kjTreeToCompoundValue.h"                // kjTreeToCompoundValue
 #include "orionld/mongoBackend/mongoEntityExists.h"              // mongoEntityExists
+#include "orionld/mongoc/mongocEntityAttributePatch.h"           // mongocEntityAttributePatch
 #include "orionld/db/dbConfiguration.h"                          // dbRegistrationLookup
 #include "orionld/serviceRoutines/orionldPatchAttribute.h"       // Own Interface
 
@@ -440,6 +446,11 @@ static bool orionldForwardPatchAttribute
   }
   headerV[header].type = HttpHeaderNone;
 
+  orionldState.httpResponse.buf       = NULL;  // orionldRequestSend allocates
+  orionldState.httpResponse.size      = 0;
+  orionldState.httpResponse.used      = 0;
+  orionldState.httpResponse.allocated = false;
+
   if (orionldState.linkHttpHeaderPresent)
   {
     char link[512];
@@ -577,6 +588,207 @@ bool kjAttributeToNgsiContextAttribute(ContextAttribute* caP, KjNode* inAttribut
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subscriptionsMayMatch -
+//
+// The entity type isn't known without reading the entity, so, it is passed as NULL to subCacheMatch, and all
+// subscriptions on entity types or type patterns are possible matches.
+// Without subscription cache, the subscriptions are in the database only, and we assume they may match.
+//
+static bool subscriptionsMayMatch(const char* entityId, const char* attrNameExpanded)
+{
+  if (noCache == true)
+    return true;
+
+  std::vector<CachedSubscription*> subV;
+
+  cacheSemTake(__FUNCTION__, "match subs for PATCH attribute");
+  subCacheMatch(orionldState.tenantP->tenant, "/", entityId, NULL, attrNameExpanded, &subV);
+  cacheSemGive(__FUNCTION__, "match subs for PATCH attribute");
+
+  return subV.size() > 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subAttributeDirect - is the sub-attribute simple enough to be patched by patchAttributeDirect?
+//
+// Only sub-attributes with a string 'type' and nothing but a 'value' (Property) or a URI 'object' (Relationship)
+// are patched directly. Anything else (missing or faulty members, nested sub-attributes) is left for the regular path,
+// that gives the appropriate error.
+//
+static bool subAttributeDirect(KjNode* saP)
+{
+  KjNode* typeP   = NULL;
+  KjNode* valueP  = NULL;
+  KjNode* objectP = NULL;
+  char*   detail;
+
+  for (KjNode* memberP = saP->value.firstChildP; memberP != NULL; memberP = memberP->next)
+  {
+    if      ((strcmp(memberP->name, "type") == 0)   && (typeP == NULL))    typeP   = memberP;
+    else if ((strcmp(memberP->name, "value") == 0)  && (valueP == NULL))   valueP  = memberP;
+    else if ((strcmp(memberP->name, "object") == 0) && (objectP == NULL))  objectP = memberP;
+    else
+      return false;
+  }
+
+  if ((typeP == NULL) || (typeP->type != KjString))
+    return false;
+
+  if (strcmp(typeP->value.s, "Property") == 0)
+    return (valueP != NULL) && (objectP == NULL);
+
+  if (strcmp(typeP->value.s, "Relationship") == 0)
+    return (valueP == NULL) && (objectP != NULL) && (objectP->type == KjString) && (pcheckUri(objectP->value.s, true, &detail) == true);
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// patchAttributeDirect -
+//
+// Patches the attribute in the database with one single targeted update (mongocEntityAttributePatch), without reading
+// the entity first and without mongoBackend - if nothing needs the current state of the entity:
+//   - the attribute type is known from the payload (type, or 'value' for Property and 'object' for Relationship)
+//     GeoProperties are left for mongoBackend, as it also maintains the 'location' field of the entity
+//   - the sub-attributes are simple Properties/Relationships (subAttributeDirect), observedAt or unitCode
+//   - the attribute passes the same pcheckAttribute check as in the regular path
+//   - no subscription may match (the notifications need the entire entity)
+//
+// The attribute type is part of the filter of the update. If nothing matches (the entity or the attribute doesn't exist,
+// or the attribute type is a different one), false is returned and the request goes through the regular path, that
+// reads the attribute and gives the appropriate error.
+//
+// Returns true if the request has been served.
+//
+static bool patchAttributeDirect(KjNode* inAttribute, char* entityId, char* attrNameExpanded, char* attrNameExpandedEq)
+{
+  KjNode*      inType = kjLookup(inAttribute, "type");
+  const char*  attrType;
+  char*        detail;
+
+  if (inType != NULL)
+  {
+    if (inType->type != KjString)
+      return false;
+    attrType = inType->value.s;
+  }
+  else
+    attrType = (kjLookup(inAttribute, "object") != NULL)? "Relationship" : "Property";
+
+  bool relationship = (strcmp(attrType, "Relationship") == 0);
+
+  if ((relationship == false) && (strcmp(attrType, "Property") != 0))
+    return false;
+
+  int subAttrs = 0;
+  for (KjNode* memberP = inAttribute->value.firstChildP; memberP != NULL; memberP = memberP->next)
+  {
+    AttributeType aType;
+
+    if (memberP == inType)
+      continue;
+    else if (strcmp(memberP->name, "value") == 0)
+    {
+      if (relationship == true)
+        return false;
+    }
+    else if (strcmp(memberP->name, "object") == 0)
+    {
+      if ((relationship == false) || (memberP->type != KjString) || (pcheckUri(memberP->value.s, true, &detail) == false))
+        return false;
+    }
+    else if (strcmp(memberP->name, "observedAt") == 0)
+    {
+      if ((memberP->type != KjString) || (parse8601Time(memberP->value.s) == -1))
+        return false;
+    }
+    else if (strcmp(memberP->name, "unitCode") == 0)
+    {
+      if (memberP->type != KjString)
+        return false;
+    }
+    else if ((memberP->type != KjObject) || (isSpecialSubAttribute(memberP->name, &aType, NULL) == true) || (subAttributeDirect(memberP) == false))
+      return false;
+    else
+      ++subAttrs;
+  }
+
+  if (subscriptionsMayMatch(entityId, attrNameExpanded) == true)
+    return false;
+
+  //
+  // Expand all sub-attributes - keeping the short names, in case the regular path is to be taken after all
+  //
+  char** shortNameV = (subAttrs > 0)? (char**) kaAlloc(&orionldState.kalloc, subAttrs * sizeof(char*)) : NULL;
+  int    saIx       = 0;
+
+  for (KjNode* saP = inAttribute->value.firstChildP; saP != NULL; saP = saP->next)
+  {
+    if ((saP == inType) || (saP->type != KjObject) || (strcmp(saP->name, "value") == 0))
+      continue;
+
+    shortNameV[saIx++] = saP->name;
+    saP->name = orionldSubAttributeExpand(orionldState.contextP, saP->name, true, NULL);
+  }
+
+  int64_t matched = 0;
+
+  //
+  // Same check as in the regular path - if it fails, the regular path is taken, to give the error in the same order
+  // (404 if the attribute doesn't exist, else 400)
+  //
+  if (pcheckAttribute(inAttribute, (char*) attrType, false, &detail) == true)
+  {
+    if (mongocEntityAttributePatch(entityId, attrNameExpandedEq, attrType, inAttribute, &matched) == false)
+    {
+      orionldState.httpStatusCode = 500;
+      orionldErrorResponseCreate(OrionldInternalError, "Database Error", "updating attribute");
+      return true;
+    }
+  }
+
+  if (matched == 0)
+  {
+    saIx = 0;
+    for (KjNode* saP = inAttribute->value.firstChildP; saP != NULL; saP = saP->next)
+    {
+      if ((saP == inType) || (saP->type != KjObject) || (strcmp(saP->name, "value") == 0))
+        continue;
+      saP->name = shortNameV[saIx++];
+    }
+
+    return false;
+  }
+
+  //
+  // Save the incoming tree for TRoE - same as in the regular path
+  //
+  if (troe)
+  {
+    KjNode* troeTree = kjClone(orionldState.kjsonP, inAttribute);
+
+    troeTree->name = attrNameExpanded;
+
+    if (inType == NULL)
+      kjChildAdd(troeTree, kjString(orionldState.kjsonP, "type", attrType));
+
+    orionldState.requestTree = troeTree;
+  }
+
+  orionldState.httpStatusCode = 204;
+  return true;
+}
+
+
+
 // ----------------------------------------------------------------------------
 //
 // orionldPatchAttribute -
@@ -584,6 +796,7 @@ bool kjAttributeToNgsiContextAttribute(ContextAttribute* caP, KjNode* inAttribut
 // 1.  Check wildcards for validity (entity ID + attribute name) + remove ev. builtins from payload body
 // 2.  Query registrations and forward message if found
 // 3.  Lookup 'datasetId' in inAttribute - if found, enter datasetId function
+// 3.1 Try to patch the attribute with one single targeted DB update (patchAttributeDirect)
 // 4.  GET the attribute from the DB (dbAttribute)
 // 5.  404 if not found in DB
 // 6.  Extract type and createdAt from dbAttribute
@@ -704,6 +917,12 @@ bool orionldPatchAttribute(ConnectionInfo* ciP)
     return orionldPatchAttributeWithDatasetId(inAttribute, entityId, attrName, attrNameExpandedEq, datasetIdP->value.s);
   }
 
+  //
+  // 3.1 Partial update in one single DB operation, if possible
+  //
+  if (patchAttributeDirect(inAttribute, entityId, attrNameExpanded, attrNameExpandedEq) == true)
+    return (orionldState.httpStatusCode == 204);
+
   //
   // 4. GET the attribute from the DB (dbAttribute)
   // 5. 404 if not found in DB
@@ -56,6 +56,7 @@ extern "C"
 #include "orionld/common/CHECK.h"                              // ARRAY_CHECK
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/entityErrorPush.h"                    // entityErrorPush
+#include "orionld/common/entityErrorLookup.h"                  // entityErrorLookup
 #include "orionld/common/entityIdCheck.h"                      // entityIdCheck
 #include "orionld/common/entityTypeCheck.h"                    // entityTypeCheck
 #include "orionld/common/entityIdAndTypeGet.h"                 // entityIdAndTypeGet
@@ -270,8 +271,11 @@ bool orionldPostBatchCreate(ConnectionInfo* ciP)
   {
     UpdateContextResponse    mongoResponse;
     std::vector<std::string> servicePathV;
+    OrionldEntitiesBulk      entitiesBulk = { NULL, NULL, 0, 0 };
+
     servicePathV.push_back("/");
 
+    orionldState.entitiesBulkP  = &entitiesBulk;  // All entities are written to the DB in one single bulk write
     orionldState.httpStatusCode = mongoUpdateContext(&mongoRequest,
                                                      &mongoResponse,
                                                      orionldState.tenantP,
@@ -281,6 +285,7 @@ bool orionldPostBatchCreate(ConnectionInfo* ciP)
                                                      orionldState.attrsFormat,
                                                      orionldState.apiVersion,
                                                      NGSIV2_NO_FLAVOUR);
+    orionldState.entitiesBulkP  = NULL;
 
     if (orionldState.httpStatusCode == 200)
     {
@@ -292,6 +297,14 @@ bool orionldPostBatchCreate(ConnectionInfo* ciP)
 
         if (mongoResponse.contextElementResponseVector.vec[ix]->statusCode.code == SccOk)
           entitySuccessPush(successArrayP, entityId);
+        else if (mongoResponse.contextElementResponseVector.vec[ix]->statusCode.code == SccReceiverInternalError)
+          entityErrorPush(errorsArrayP,
+                          entityId,
+                          OrionldInternalError,
+                          "Database Error",
+                          mongoResponse.contextElementResponseVector.vec[ix]->statusCode.details.c_str(),
+                          500,
+                          false);
         else
           entityErrorPush(errorsArrayP,
                           entityId,
@@ -306,7 +319,7 @@ bool orionldPostBatchCreate(ConnectionInfo* ciP)
       {
         const char* entityId = mongoRequest.contextElementVector.vec[ix]->entityId.id.c_str();
 
-        if (kjStringValueLookupInArray(successArrayP, entityId) == NULL)
+        if ((kjStringValueLookupInArray(successArrayP, entityId) == NULL) && (entityErrorLookup(errorsArrayP, entityId) == NULL))
           entitySuccessPush(successArrayP, entityId);
       }
     }
@@ -289,9 +289,12 @@ bool orionldPostBatchUpdate(ConnectionInfo* ciP)
 
   UpdateContextResponse    mongoResponse;
   std::vector<std::string> servicePathV;
+  OrionldEntitiesBulk      entitiesBulk = { NULL, NULL, 0, 0 };
+
   servicePathV.push_back("/");
 
   PERFORMANCE(mongoBackendStart);
+  orionldState.entitiesBulkP  = &entitiesBulk;  // All entities are written to the DB in one single bulk write
   orionldState.httpStatusCode = mongoUpdateContext(&mongoRequest,
                                                    &mongoResponse,
                                                    orionldState.tenantP,
@@ -301,6 +304,7 @@ bool orionldPostBatchUpdate(ConnectionInfo* ciP)
                                                    orionldState.attrsFormat,
                                                    orionldState.apiVersion,
                                                    NGSIV2_NO_FLAVOUR);
+  orionldState.entitiesBulkP  = NULL;
   PERFORMANCE(mongoBackendEnd);
 
   if (orionldState.httpStatusCode == SccOk)
@@ -56,6 +56,7 @@ extern "C"
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/entitySuccessPush.h"                  // entitySuccessPush
 #include "orionld/common/entityErrorPush.h"                    // entityErrorPush
+#include "orionld/common/entityErrorLookup.h"                  // entityErrorLookup
 #include "orionld/common/entityIdCheck.h"                      // entityIdCheck
 #include "orionld/common/entityTypeCheck.h"                    // entityTypeCheck
 #include "orionld/common/entityIdAndTypeGet.h"                 // entityIdAndTypeGet
@@ -387,8 +388,11 @@ bool orionldPostBatchUpsert(ConnectionInfo* ciP)
   //
   UpdateContextResponse    mongoResponse;
   std::vector<std::string> servicePathV;
+  OrionldEntitiesBulk      entitiesBulk = { NULL, NULL, 0, 0 };
+
   servicePathV.push_back("/");
 
+  orionldState.entitiesBulkP  = &entitiesBulk;  // All entities are written to the DB in one single bulk write
   orionldState.httpStatusCode = mongoUpdateContext(&mongoRequest,
                                                    &mongoResponse,
                                                    orionldState.tenantP,
@@ -398,6 +402,7 @@ bool orionldPostBatchUpsert(ConnectionInfo* ciP)
                                                    orionldState.attrsFormat,
                                                    orionldState.apiVersion,
                                                    NGSIV2_NO_FLAVOUR);
+  orionldState.entitiesBulkP  = NULL;
 
   //
   // Now check orionldState.errorAttributeArray to see whether any attribute failed to be updated
@@ -421,6 +426,14 @@ bool orionldPostBatchUpsert(ConnectionInfo* ciP)
         else
           entitySuccessPush(updatedArrayP, entityId);
       }
+      else if (mongoResponse.contextElementResponseVector.vec[ix]->statusCode.code == SccReceiverInternalError)
+        entityErrorPush(errorsArrayP,
+                        entityId,
+                        OrionldInternalError,
+                        "Database Error",
+                        mongoResponse.contextElementResponseVector.vec[ix]->statusCode.details.c_str(),
+                        500,
+                        false);
       else
         entityErrorPush(errorsArrayP,
                         entityId,
@@ -435,6 +448,9 @@ bool orionldPostBatchUpsert(ConnectionInfo* ciP)
     {
       const char* entityId = mongoRequest.contextElementVector.vec[ix]->entityId.id.c_str();
 
+      if (entityErrorLookup(errorsArrayP, entityId) != NULL)
+        continue;
+
       // Creation or Update?
       KjNode* dbEntityP = entityLookupInDb(idTypeAndCreDateFromDb, entityId);
 
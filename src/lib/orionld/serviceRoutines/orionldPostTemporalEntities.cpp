@@ -146,9 +146,12 @@ bool orionldPostTemporalEntities(ConnectionInfo* ciP)
     return true;
   }
 
-  LM_E(("troePostEntities failed (%s: %s)", orionldState.pd.title, orionldState.pd.detail));
-  orionldErrorResponseCreate(orionldState.pd.type, orionldState.pd.title, orionldState.pd.detail);
-  orionldState.httpStatusCode = orionldState.pd.type;
+  //
+  // troePostEntities doesn't create any error response (orionldState.pd isn't set) - it is done here
+  //
+  LM_E(("troePostEntities failed"));
+  orionldErrorResponseCreate(OrionldInternalError, "Database Error", "writing to the TRoE database");
+  orionldState.httpStatusCode = 500;
 
   return false;
 }
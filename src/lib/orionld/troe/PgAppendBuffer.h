@@ -36,9 +36,10 @@ typedef struct PgAppendBuffer
 {
   char*  buf;        // The SQL buffer
   int    bufSize;    // The total size of the SQL buffer
-  bool   allocated;  // if true: PgAppendBuffer::buf needs to be freed when reallocating
   int    currentIx;  // Current index in the buffer
   int    values;
+  bool   copy;       // Binary COPY rows (troeCopy) instead of SQL VALUES - see pgCopy.h
+  int    copyStart;  // Index of the first binary COPY row (after the "INSERT INTO" start and its zero-termination)
 } PgAppendBuffer;
 
 #endif  // SRC_LIB_ORIONLD_TROE_PGAPPENDBUFFER_H_
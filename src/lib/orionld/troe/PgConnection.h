@@ -29,15 +29,22 @@
 
 
 
+struct PgConnectionPool;
+
+
+
 // -----------------------------------------------------------------------------
 //
 // PgConnection -
 //
 typedef struct PgConnection
 {
-  bool    busy;          // In use or free
-  PGconn* connectionP;   // the postgres connection
-  int     uses;          // Number of times the connection has been used
+  bool                      busy;          // In use or free
+  PGconn*                   connectionP;   // the postgres connection - NULL until first used
+  int                       uses;          // Number of times the connection has been used
+  unsigned int              ix;            // Index of the connection inside its pool
+  unsigned int              nextFree;      // Free-list link: index+1 of the next idle connection (0: end of list)
+  struct PgConnectionPool*  poolP;         // The pool the connection belongs to
 } PgConnection;
 
 #endif  // SRC_LIB_ORIONLD_TROE_PGCONNECTION_H_
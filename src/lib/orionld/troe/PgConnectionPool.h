@@ -25,6 +25,7 @@
 *
 * Author: Ken Zangelin
 */
+#include <stdint.h>                                            // uint64_t
 #include <semaphore.h>                                         // sem_t
 
 #include "orionld/troe/PgConnection.h"                         // PgConnection
@@ -33,16 +34,57 @@
 
 // -----------------------------------------------------------------------------
 //
-// PgConnectionPool -
+// PG_CONNECTION_POOL_INDEX_SIZE - number of buckets in the hash index of connection pools
+//
+#define PG_CONNECTION_POOL_INDEX_SIZE 256
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PgConnectionPoolMetrics -
+//
+// All counters are updated with atomic operations, by any thread, without any lock.
+// Times are in microseconds.
+//
+typedef struct PgConnectionPoolMetrics
+{
+  long long  gets;          // Number of connections handed out
+  long long  waits;         // Number of times a request had to wait for a connection to be released
+  long long  timeouts;      // Number of waits that timed out
+  long long  waitTime;      // Accumulated time spent waiting
+  long long  maxWaitTime;   // Longest wait
+  long long  connects;      // Number of connections established (including reconnects)
+  long long  reconnects;    // Number of broken connections that were reset or reconnected
+  long long  errors;        // Number of failed connection attempts
+  long long  inUse;         // Number of connections currently handed out
+  long long  maxInUse;      // Max number of connections handed out at the same time
+} PgConnectionPoolMetrics;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PgConnectionPool - pool of connections to one database (one tenant)
+//
+// The idle connections are kept in a lock-free stack (freeList), that links the connections by their index in
+// connectionV. The head of the stack is a 64 bit word with the index+1 of the first idle connection in its low
+// 32 bits and a counter in its high 32 bits, incremented on every change, to avoid the ABA problem.
+//
+// queueSem counts the idle connections in the free-list. A thread that wants a connection first takes the semaphore
+// (waiting, at most troePoolTimeout milliseconds, if the pool is exhausted) and only then pops a connection from
+// the free-list - that pop can never find the list empty. The semaphore is posted when the connection is released.
 //
 typedef struct PgConnectionPool
 {
   char*                     db;           // Name of the database
-  sem_t                     queueSem;     // Counting semaphore - size same as number of connections in the pool
-  sem_t                     poolSem;      // Binary semaphore - grants rights to modify the pool
+  unsigned int              bucket;       // Hash bucket of the pool in pgConnectionPoolIndex
+  sem_t                     queueSem;     // Counting semaphore - number of idle connections in the pool
+  uint64_t                  freeList;     // Head of the stack of idle connections: ABA counter | index+1
   int                       items;        // Number of connections in the pool
-  PgConnection**            connectionV;  // Allocated array of PgConnection pointers
-  struct PgConnectionPool*  next;         // Connection Pools are stored in a linked list
+  PgConnection*             connectionV;  // Allocated array of connections (connected to postgres on first use)
+  PgConnectionPoolMetrics   metrics;      // Wait-time and utilisation metrics
+  struct PgConnectionPool*  next;         // Next pool in the same hash bucket
 } PgConnectionPool;
 
 #endif  // SRC_LIB_ORIONLD_TROE_PGCONNECTIONPOOL_H_
@@ -0,0 +1,71 @@
+#ifndef SRC_LIB_ORIONLD_TROE_TEMPORALQUERY_H_
+#define SRC_LIB_ORIONLD_TROE_TEMPORALQUERY_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+// -----------------------------------------------------------------------------
+//
+// TemporalTimeRel - the 'timerel' of a temporal query
+//
+typedef enum TemporalTimeRel
+{
+  TemporalTimeRelNone,
+  TemporalTimeRelBefore,
+  TemporalTimeRelAfter,
+  TemporalTimeRelBetween
+} TemporalTimeRel;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TemporalQuery - a temporal query, its entity ids, types and attribute names already expanded
+//
+// The vectors and strings are allocated in orionldState.kalloc
+//
+typedef struct TemporalQuery
+{
+  char**           idV;
+  int              ids;
+  char*            idPattern;
+  char**           typeV;
+  int              types;
+  char**           attrV;
+  int              attrs;
+
+  TemporalTimeRel  timerel;
+  double           timeAt;          // Seconds since the epoch
+  double           endTimeAt;       // Only for TemporalTimeRelBetween
+  const char*      timeColumn;      // "observedAt" or "ts" (modifiedAt, createdAt)
+
+  int              lastN;           // 0: all instances
+  int              offset;          // Entity pagination
+  int              limit;           // Entity pagination
+  bool             count;           // Count the matching entities (for NGSILD-Results-Count)
+  bool             temporalValues;  // Simplified temporal representation
+  bool             sysAttrs;        // Add modifiedAt to each instance
+} TemporalQuery;
+
+#endif  // SRC_LIB_ORIONLD_TROE_TEMPORALQUERY_H_
@@ -23,12 +23,12 @@
 * Author: Ken Zangelin
 */
 #include <string.h>                                            // strlen, strncpy
-#include <stdlib.h>                                            // malloc
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/orionldArenaAlloc.h"                  // orionldArenaAlloc
 #include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 #include "orionld/troe/pgAppend.h"                             // Own interface
 
@@ -50,28 +50,28 @@ void pgAppend(PgAppendBuffer* pgBufP, const char* tail, int tailLen)
 
     pgBufP->bufSize += 4 * 1024;  // Add 4k every time
 
-    if (pgBufP->bufSize < 16 * 1024)  // Use kaAlloc for smaller buffers
-    {
+    if ((pgBufP->bufSize < 16 * 1024) && (pgBufP->currentIx + tailLen < pgBufP->bufSize))  // Use kaAlloc for smaller buffers
       pgBufP->buf = kaAlloc(&orionldState.kalloc, pgBufP->bufSize);
-      strncpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
-      oldBuffer = NULL;  // Must not be freed
-    }
     else
     {
-      if (pgBufP->bufSize > 32 * 1024)
-        pgBufP->bufSize += 12 * 1024;  // Add an additional 12k if buffer > 32k (16k in total: 4+12)
+      //
+      // Bigger buffers are taken from the arena of the thread, doubling the size, as the arena has size classes
+      // of the powers of two, and keeps the buffers from one request to the next.
+      // The old buffer is either kaAlloced or in the arena as well - both are released at the end of the request
+      //
+      int newSize = 16 * 1024;
 
-      // If already allocated, we can realloc. else, allocate and copy
-      if (pgBufP->allocated == true)
-        pgBufP->buf = (char*) realloc(pgBufP->buf, pgBufP->bufSize);
-      else
-      {
-        pgBufP->buf = (char*) malloc(pgBufP->bufSize);
-        strncpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
-      }
+      while (newSize <= pgBufP->currentIx + tailLen)
+        newSize *= 2;
 
-      pgBufP->allocated = true;
+      pgBufP->bufSize = newSize;
+      pgBufP->buf     = orionldArenaAlloc(newSize);
+
+      if (pgBufP->buf == NULL)
+        LM_X(1, ("Out of memory (unable to allocate %d bytes for a TRoE SQL buffer)", newSize));
     }
+
+    strncpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
   }
 
   strncpy(&pgBufP->buf[pgBufP->currentIx], tail, tailLen);
@@ -42,7 +42,8 @@ void pgAppendInit(PgAppendBuffer* pgBufP, int initSize)
   pgBufP->buf        = (char*) kaAlloc(&orionldState.kalloc, initSize);
   pgBufP->buf[0]     = 0;
   pgBufP->bufSize    = initSize;
-  pgBufP->allocated  = false;
   pgBufP->currentIx  = 0;
   pgBufP->values     = 0;
+  pgBufP->copy       = troeCopy;
+  pgBufP->copyStart  = 0;
 }
@@ -35,9 +35,11 @@ extern "C"
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/orionldArenaAlloc.h"                  // orionldArenaAlloc
 #include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgQuotedString.h"                       // pgQuotedString
+#include "orionld/troe/pgCopy.h"                               // pgCopy*
 #include "orionld/troe/kjGeoPointExtract.h"                    // kjGeoPointExtract
 #include "orionld/troe/kjGeoMultiPointExtract.h"               // kjGeoMultiPointExtract
 #include "orionld/troe/kjGeoLineStringExtract.h"               // kjGeoLineStringExtract
@@ -48,6 +50,62 @@ extern "C"
 
 
 
+// -----------------------------------------------------------------------------
+//
+// pgAttributeCopyAppend - binary COPY row for the attributes table - same fields in the same order as pgAttributeAppend
+//
+static void pgAttributeCopyAppend
+(
+  PgAppendBuffer*  attributesBufferP,
+  const char*      instanceId,
+  const char*      attributeName,
+  const char*      opMode,
+  const char*      entityId,
+  char*            type,
+  char*            observedAt,
+  bool             subProperties,
+  char*            unitCode,
+  char*            datasetId,
+  KjNode*          valueNodeP,
+  char*            object
+)
+{
+  bool deleted = (strcmp(opMode, "Delete") == 0);
+
+  if ((deleted == false) && (strcmp(type, "Relationship") != 0) && ((valueNodeP == NULL) || (valueNodeP->type == KjNull)))
+  {
+    LM_W(("TROE: To Be Implemented"));
+    return;
+  }
+
+  pgCopyRowStart(attributesBufferP, 21);
+  pgCopyText(attributesBufferP, instanceId);
+  pgCopyText(attributesBufferP, attributeName);
+  pgCopyText(attributesBufferP, opMode);
+  pgCopyText(attributesBufferP, entityId);
+
+  if (deleted == true)
+  {
+    pgCopyNull(attributesBufferP);  // observedAt
+    pgCopyNull(attributesBufferP);  // subProperties
+    pgCopyNull(attributesBufferP);  // unitCode
+    pgCopyText(attributesBufferP, datasetId);
+    pgCopyValue(attributesBufferP, NULL, NULL, NULL);
+  }
+  else
+  {
+    pgCopyIsoTimestamp(attributesBufferP, observedAt);
+    pgCopyBool(attributesBufferP, subProperties);
+    pgCopyText(attributesBufferP, unitCode);
+    pgCopyText(attributesBufferP, datasetId);
+    pgCopyValue(attributesBufferP, type, valueNodeP, object);
+  }
+
+  pgCopyTimestamp(attributesBufferP, orionldState.requestTime);
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pgAttributeAppend -
@@ -77,6 +135,8 @@ extern "C"
 // This function appends a new ('', '', '', ...) for the VALUES of attributesBuffer
 // It also calls pgSubAttributeBuild for any sub-attributes
 //
+// With -troeCopy, the same fields are appended as a binary COPY row instead (pgAttributeCopyAppend)
+//
 void pgAttributeAppend
 (
   PgAppendBuffer*  attributesBufferP,
@@ -93,6 +153,15 @@ void pgAttributeAppend
   char*            object
 )
 {
+  if (attributesBufferP->copy == true)
+  {
+    if (datasetId == NULL)
+      datasetId = (char*) "None";
+
+    pgAttributeCopyAppend(attributesBufferP, instanceId, attributeName, opMode, entityId, type, observedAt, subProperties, unitCode, datasetId, valueNodeP, object);
+    return;
+  }
+
   char        localBuf[2 * 1024];
   int         bufSize = sizeof(localBuf);
   char*       buf     = localBuf;
@@ -127,7 +196,8 @@ void pgAttributeAppend
 
     if (point == false)
     {
-      coordsString = (char*) malloc(10 * 1024);
+      // Both buffers are released at the end of the request, with all buffers of the arena of the thread
+      coordsString = orionldArenaAlloc(10 * 1024);
       if (coordsString == NULL)
       {
         LM_E(("error allocating 10k for geo property coordinates"));
@@ -135,18 +205,13 @@ void pgAttributeAppend
       }
       coordsStringLen = 10 * 1024;
 
-      buf = (char*) malloc(11 * 1024);
+      buf = orionldArenaAlloc(11 * 1024);
       if (buf == NULL)
       {
         LM_E(("error allocating 10k for geo property buffer"));
-        free(coordsString);
         return;
       }
       bufSize = 11 * 1024;
-
-      // Free the two allocated buffers afterwards
-      orionldStateDelayedFreeEnqueue(coordsString);
-      orionldStateDelayedFreeEnqueue(buf);
     }
 
     if (point == true)
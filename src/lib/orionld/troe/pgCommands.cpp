@@ -27,12 +27,15 @@
 
 #include "orionld/common/pqHeader.h"                           // Postgres header
 #include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 #include "orionld/troe/PgConnection.h"                         // PgConnection
 #include "orionld/troe/pgConnectionGet.h"                      // pgConnectionGet
 #include "orionld/troe/pgConnectionRelease.h"                  // pgConnectionRelease
 #include "orionld/troe/pgTransactionBegin.h"                   // pgTransactionBegin
 #include "orionld/troe/pgTransactionRollback.h"                // pgTransactionRollback
 #include "orionld/troe/pgTransactionCommit.h"                  // pgTransactionCommit
+#include "orionld/troe/pgCopyExec.h"                           // pgCopyExec
+#include "orionld/troe/troeWriterEnqueue.h"                    // troeWriterEnqueue
 #include "orionld/troe/pgCommands.h"                           // Own interface
 
 
@@ -41,8 +44,19 @@
 //
 // pgCommands -
 //
-void pgCommands(char* sql[], int commands)
+// With TRoE writer threads, the commands are handed over to the writers and executed later, batched with
+// the commands of other requests (see troeWriter.h)
+//
+// Buffers of binary COPY rows (-troeCopy) are sent using the COPY protocol, the rest of them as SQL commands
+//
+void pgCommands(PgAppendBuffer* bufferV[], int buffers)
 {
+  if (troeWriters > 0)
+  {
+    troeWriterEnqueue(orionldState.tenantP->troeDbName, bufferV, buffers);
+    return;
+  }
+
   PgConnection* connectionP = pgConnectionGet(orionldState.tenantP->troeDbName);
 
   if ((connectionP == NULL) || (connectionP->connectionP == NULL))
@@ -54,10 +68,25 @@ void pgCommands(char* sql[], int commands)
     LM_RVE(("pgTransactionBegin failed"));
   }
 
-  for (int ix = 0; ix < commands; ix++)
+  for (int ix = 0; ix < buffers; ix++)
   {
-    // LM_TMP(("SQL: %s;", sql[ix]));
-    PGresult* res = PQexec(connectionP->connectionP, sql[ix]);
+    PgAppendBuffer* bufP = bufferV[ix];
+
+    if (bufP->copy == true)
+    {
+      if (pgCopyExec(connectionP->connectionP, bufP->buf, &bufP->buf[bufP->copyStart], bufP->currentIx - bufP->copyStart) == false)
+      {
+        if (pgTransactionRollback(connectionP->connectionP) == false)
+          LM_E(("Database Error (pgTransactionRollback failed too)"));
+        pgConnectionRelease(connectionP);
+        return;
+      }
+
+      continue;
+    }
+
+    // LM_TMP(("SQL: %s;", bufP->buf));
+    PGresult* res = PQexec(connectionP->connectionP, bufP->buf);
     if (res == NULL)
     {
       LM_E(("Database Error (%s)", PQresStatus(PQresultStatus(res))));
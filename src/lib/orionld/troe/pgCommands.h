@@ -25,6 +25,7 @@
 *
 * Author: Ken Zangelin
 */
+#include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 
 
 
@@ -32,6 +33,6 @@
 //
 // pgCommands -
 //
-extern void pgCommands(char* sql[], int commands);
+extern void pgCommands(PgAppendBuffer* bufferV[], int buffers);
 
 #endif  // SRC_LIB_ORIONLD_TROE_PGCOMMANDS_H_
@@ -0,0 +1,88 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                            // uint64_t
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // Lmt*
+
+#include "orionld/troe/PgConnection.h"                         // PgConnection
+#include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
+#include "orionld/troe/pgConnectionFreeList.h"                 // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// FREE_LIST_IX - index+1 of the first connection in the free-list (0: empty list)
+// FREE_LIST_TAG - ABA counter of the free-list head
+//
+#define FREE_LIST_IX(head)   ((unsigned int) ((head) & 0xFFFFFFFF))
+#define FREE_LIST_TAG(head)  ((head) >> 32)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionFreeListPop -
+//
+// The counter in the high bits of the head makes the compare-and-swap fail if, between the load of the head and the
+// CAS, the first connection was popped and pushed back again (with a different 'nextFree').
+// Connections are never freed while the broker runs, so reading 'nextFree' of a connection that has just been
+// popped by another thread is harmless - the CAS fails and the loop starts over.
+//
+PgConnection* pgConnectionFreeListPop(PgConnectionPool* poolP)
+{
+  uint64_t head = __atomic_load_n(&poolP->freeList, __ATOMIC_ACQUIRE);
+
+  while (FREE_LIST_IX(head) != 0)
+  {
+    PgConnection*  cP      = &poolP->connectionV[FREE_LIST_IX(head) - 1];
+    unsigned int   next    = __atomic_load_n(&cP->nextFree, __ATOMIC_RELAXED);
+    uint64_t       newHead = ((FREE_LIST_TAG(head) + 1) << 32) | next;
+
+    if (__atomic_compare_exchange_n(&poolP->freeList, &head, newHead, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == true)
+      return cP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionFreeListPush -
+//
+void pgConnectionFreeListPush(PgConnectionPool* poolP, PgConnection* cP)
+{
+  uint64_t head = __atomic_load_n(&poolP->freeList, __ATOMIC_ACQUIRE);
+  uint64_t newHead;
+
+  do
+  {
+    __atomic_store_n(&cP->nextFree, FREE_LIST_IX(head), __ATOMIC_RELAXED);
+    newHead = ((FREE_LIST_TAG(head) + 1) << 32) | (cP->ix + 1);
+  } while (__atomic_compare_exchange_n(&poolP->freeList, &head, newHead, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == false);
+}
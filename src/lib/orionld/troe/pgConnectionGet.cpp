@@ -22,14 +22,19 @@
 *
 * Author: Ken Zangelin
 */
+#include <errno.h>                                             // errno, EINTR
+#include <time.h>                                              // clock_gettime, struct timespec
+#include <semaphore.h>                                         // sem_trywait, sem_wait, sem_timedwait, sem_post
+
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
-#include "orionld/common/orionldState.h"                       // troeHost, pgPortString, troeUser, troePwd
+#include "orionld/common/orionldState.h"                       // dbName, troePoolTimeout
 #include "orionld/troe/pgConnect.h"                            // pgConnect
 #include "orionld/troe/PgConnection.h"                         // PgConnection
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
 #include "orionld/troe/pgConnectionPoolGet.h"                  // pgConnectionPoolGet
+#include "orionld/troe/pgConnectionFreeList.h"                 // pgConnectionFreeListPop, pgConnectionFreeListPush
 #include "orionld/troe/pgConnectionGet.h"                      // Own interface
 
 
@@ -57,10 +62,128 @@ static char* wsTrim(char* s)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// metricMax - atomically raise *maxP to 'value', if 'value' is greater
+//
+static void metricMax(long long* maxP, long long value)
+{
+  long long current = __atomic_load_n(maxP, __ATOMIC_RELAXED);
+
+  while (value > current)
+  {
+    if (__atomic_compare_exchange_n(maxP, &current, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == true)
+      break;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotAwait - take a slot of the pool's counting semaphore, waiting at most troePoolTimeout milliseconds
+//
+// The common case, an idle connection available, doesn't touch the clock.
+//
+static bool slotAwait(PgConnectionPool* poolP)
+{
+  if (sem_trywait(&poolP->queueSem) == 0)
+    return true;
+
+  struct timespec start;
+  struct timespec now;
+  int             r;
+
+  __atomic_add_fetch(&poolP->metrics.waits, 1, __ATOMIC_RELAXED);
+  clock_gettime(CLOCK_REALTIME, &start);
+
+  if (troePoolTimeout == 0)
+  {
+    while (((r = sem_wait(&poolP->queueSem)) == -1) && (errno == EINTR))
+      ;
+  }
+  else
+  {
+    struct timespec deadline = start;
+
+    deadline.tv_sec  += troePoolTimeout / 1000;
+    deadline.tv_nsec += (troePoolTimeout % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec  += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+    while (((r = sem_timedwait(&poolP->queueSem, &deadline)) == -1) && (errno == EINTR))
+      ;
+  }
+
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  long long waitTime = (now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+
+  __atomic_add_fetch(&poolP->metrics.waitTime, waitTime, __ATOMIC_RELAXED);
+  metricMax(&poolP->metrics.maxWaitTime, waitTime);
+
+  if (r == -1)
+  {
+    __atomic_add_fetch(&poolP->metrics.timeouts, 1, __ATOMIC_RELAXED);
+    LM_E(("Database Error (no free postgres connection for db '%s' after %d milliseconds - all %d connections in use)",
+          (poolP->db != NULL)? poolP->db : "postgres", troePoolTimeout, poolP->items));
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// connectionCheck - make sure the connection is connected and healthy
+//
+// A virgin connection is connected.
+// A connection whose status is CONNECTION_BAD (server restarted, network problems, ...) is first reset and,
+// if that doesn't help, closed and connected again.
+//
+static bool connectionCheck(PgConnectionPool* poolP, PgConnection* cP)
+{
+  if (cP->connectionP != NULL)
+  {
+    if (PQstatus(cP->connectionP) == CONNECTION_OK)
+      return true;
+
+    LM_W(("Broken connection to postgres db '%s' - reconnecting", (poolP->db != NULL)? poolP->db : "postgres"));
+    __atomic_add_fetch(&poolP->metrics.reconnects, 1, __ATOMIC_RELAXED);
+
+    PQreset(cP->connectionP);
+    if (PQstatus(cP->connectionP) == CONNECTION_OK)
+      return true;
+
+    PQfinish(cP->connectionP);
+    cP->connectionP = NULL;
+  }
+
+  cP->connectionP = pgConnect(poolP->db);
+  if (cP->connectionP == NULL)
+  {
+    __atomic_add_fetch(&poolP->metrics.errors, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+
+  __atomic_add_fetch(&poolP->metrics.connects, 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pgConnectionGet -
 //
+// Taking a slot of the counting semaphore guarantees that the free-list of the pool has an idle connection for us,
+// so, the pop can't fail. The slot is given back by pgConnectionRelease (or here, if the connection can't be established).
+//
 PgConnection* pgConnectionGet(const char* db)
 {
   char* _db = (char*) db;
@@ -77,90 +200,35 @@ PgConnection* pgConnectionGet(const char* db)
   if (_db != NULL)
     _db = wsTrim(_db);
 
-  // FIXME: Need a semaphore to protect the list of pools
   PgConnectionPool* poolP = pgConnectionPoolGet(_db);  // pgConnectionPoolGet creates the pool if it doesn't already exist
 
   if (poolP == NULL)
     LM_RE(NULL, ("unable to obtain a connection pool reference"));
 
-  // Await a free slot in the pool
-  sem_wait(&poolP->queueSem);
-
-  // Await the right to modify the pool
-  sem_wait(&poolP->poolSem);
+  if (slotAwait(poolP) == false)
+    return NULL;
 
-  // Search for a free but already connected PgConnection in the pool
-  for (int ix = 0; ix < poolP->items; ix++)
+  PgConnection* cP = pgConnectionFreeListPop(poolP);
+  if (cP == NULL)
   {
-    PgConnection* cP = poolP->connectionV[ix];
-
-    if ((cP == NULL) || (cP->busy == true))
-      continue;
-
-    if (cP->connectionP != NULL)
-    {
-      // Great - found a free and already connected item - let's use it !
-      cP->busy = true;
-
-      sem_post(&poolP->poolSem);
-      sem_post(&poolP->queueSem);
-
-      cP->uses += 1;
-      return cP;
-    }
+    sem_post(&poolP->queueSem);
+    LM_RE(NULL, ("Internal Error (bug in postgres connection pool logic - free-list empty)"));
   }
 
-  //
-  // No already connected item was found - just look for an unused item and connect it to postgres
-  //
-  PgConnection* cP = NULL;
-  for (int ix = 0; ix < poolP->items; ix++)
+  if (connectionCheck(poolP, cP) == false)
   {
-    if (poolP->connectionV[ix] == NULL)
-    {
-      //
-      // We found a completely unused slot - need to allocate
-      // Pity doing this with the semaphore taken ...
-      // But, there's no other choice as the slot must be marked as 'busy' before the sem can be released
-      //
-      poolP->connectionV[ix] = (PgConnection*) calloc(1, sizeof(PgConnection));
-      if (poolP->connectionV[ix] == NULL)
-      {
-        sem_post(&poolP->poolSem);
-        sem_post(&poolP->queueSem);
-        LM_RE(NULL, ("Out of memory (unable to allocate room for a Postgres Connection - %d bytes)", sizeof(PgConnection)));
-      }
-
-      cP = poolP->connectionV[ix];
-      break;
-    }
-    else if (poolP->connectionV[ix]->busy == false)
-    {
-      cP = poolP->connectionV[ix];
-      break;
-    }
+    pgConnectionFreeListPush(poolP, cP);
+    sem_post(&poolP->queueSem);
+    LM_RE(NULL, ("Database Error (unable to connect to postgres(%s))", _db));
   }
 
+  cP->busy  = true;
+  cP->uses += 1;
 
-  if (cP != NULL)
-    cP->busy = true;  // Now the pool item 'cP' is ours - after this we can let go of the semaphore
-
-  sem_post(&poolP->poolSem);
-  sem_post(&poolP->queueSem);
-
-  if (cP == NULL)
-    LM_RE(NULL, ("Internal Error (bug in postgres connection pool logic)"));
+  long long inUse = __atomic_add_fetch(&poolP->metrics.inUse, 1, __ATOMIC_RELAXED);
 
-  if (cP->connectionP == NULL)  // Virgin connection
-  {
-    cP->connectionP = pgConnect(_db);
-    if (cP->connectionP == NULL)
-    {
-      cP->busy = false;  // So the slot can be used again!
-      LM_RE(NULL, ("Database Error (unable to connect to postgres(%s))", _db));
-    }
-  }
+  metricMax(&poolP->metrics.maxInUse, inUse);
+  __atomic_add_fetch(&poolP->metrics.gets, 1, __ATOMIC_RELAXED);
 
-  cP->uses += 1;
   return cP;
 }
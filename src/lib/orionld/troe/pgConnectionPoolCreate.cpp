@@ -22,14 +22,16 @@
 *
 * Author: Ken Zangelin
 */
-#include <stdlib.h>                                            // malloc, free
+#include <stdlib.h>                                            // malloc, calloc, free
 #include <string.h>                                            // strdup
 #include <semaphore.h>                                         // sem_init
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
+#include "orionld/troe/PgConnection.h"                         // PgConnection
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
+#include "orionld/troe/pgConnectionPoolHash.h"                 // pgConnectionPoolHash
 #include "orionld/troe/pgConnectionPoolCreate.h"               // Own interface
 
 
@@ -38,14 +40,17 @@
 //
 // pgConnectionPoolCreate -
 //
+// All 'poolSize' connections are allocated here, linked in the free-list, but not connected to postgres.
+// That is done by pgConnectionGet, the first time each connection is used.
+//
 PgConnectionPool* pgConnectionPoolCreate(const char* db, int poolSize)
 {
-  PgConnectionPool* poolP = (PgConnectionPool*) malloc(sizeof(PgConnectionPool));
+  PgConnectionPool* poolP = (PgConnectionPool*) calloc(1, sizeof(PgConnectionPool));
 
   if (poolP == NULL)
     LM_RE(NULL, ("Out of memory (unable to allocate room for a postgres connection pool)"));
 
-  poolP->connectionV = (PgConnection**) calloc(poolSize, sizeof(PgConnection*));
+  poolP->connectionV = (PgConnection*) calloc(poolSize, sizeof(PgConnection));
   if (poolP->connectionV == NULL)
   {
     free(poolP);
@@ -63,14 +68,27 @@ PgConnectionPool* pgConnectionPoolCreate(const char* db, int poolSize)
       LM_E(("Out of memory (unable to allocate room for the DB-name of a postgres connection pool)"));
       return NULL;
     }
+
+    poolP->bucket = pgConnectionPoolHash(db);
   }
   else
     poolP->db = NULL;
 
-  sem_init(&poolP->queueSem, 0, poolSize);  // Counting semaphore - there's a free slot
-  sem_init(&poolP->poolSem,  0, 1);         // Binary semaphore - the pool is yours to modify
+  //
+  // Link all connections in the free-list - connection 0 first
+  //
+  for (int ix = 0; ix < poolSize; ix++)
+  {
+    poolP->connectionV[ix].ix       = ix;
+    poolP->connectionV[ix].nextFree = (ix + 1 < poolSize)? ix + 2 : 0;
+    poolP->connectionV[ix].poolP    = poolP;
+  }
+  poolP->freeList = (poolSize > 0)? 1 : 0;
+
+  sem_init(&poolP->queueSem, 0, poolSize);  // Counting semaphore - number of idle connections
 
   poolP->items = poolSize;
+  poolP->next  = NULL;
 
   return poolP;
 }
@@ -40,16 +40,11 @@
 void pgConnectionPoolFree(PgConnectionPool* poolP)
 {
   sem_destroy(&poolP->queueSem);
-  sem_destroy(&poolP->poolSem);
 
   for (int ix = 0; ix < poolP->items; ix++)
   {
-    if (poolP->connectionV[ix] != NULL)
-    {
-      if (poolP->connectionV[ix]->connectionP != NULL)
-        PQfinish(poolP->connectionV[ix]->connectionP);
-      free(poolP->connectionV[ix]);
-    }
+    if (poolP->connectionV[ix].connectionP != NULL)
+      PQfinish(poolP->connectionV[ix].connectionP);
   }
 
   free(poolP->db);
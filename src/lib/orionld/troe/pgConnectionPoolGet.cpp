@@ -23,45 +23,79 @@
 * Author: Ken Zangelin
 */
 #include <string.h>                                            // strcmp
+#include <pthread.h>                                           // pthread_mutex_lock, pthread_mutex_unlock
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
-#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster
+#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster, pgConnectionPoolIndex, pgConnectionPoolMutex
+#include "orionld/troe/pgConnectionPoolHash.h"                 // pgConnectionPoolHash
 #include "orionld/troe/pgConnectionPoolCreate.h"               // pgConnectionPoolCreate
 #include "orionld/troe/pgConnectionPoolInsert.h"               // pgConnectionPoolInsert
 #include "orionld/troe/pgConnectionPoolGet.h"                  // Own interface
 
 
 
+// -----------------------------------------------------------------------------
+//
+// pgConnectionPoolLookup -
+//
+static PgConnectionPool* pgConnectionPoolLookup(const char* db, unsigned int bucket)
+{
+  PgConnectionPool* poolP = __atomic_load_n(&pgConnectionPoolIndex[bucket], __ATOMIC_ACQUIRE);
+
+  while (poolP != NULL)
+  {
+    if (strcmp(poolP->db, db) == 0)
+      return poolP;
+
+    poolP = poolP->next;
+  }
+
+  return NULL;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pgConnectionPoolGet -
 //
+// The lookup is lock-free.
+// Only if the pool doesn't exist, the mutex is taken, the lookup is repeated (another thread may have created the pool
+// while we waited for the mutex), and the pool is created.
+//
 PgConnectionPool* pgConnectionPoolGet(char* db)
 {
   //
-  // The default db, name NULL, has its pool as the very first pool in the pool list
+  // The default db, name NULL, has its pool outside the index
   //
   if (db == NULL)
     return pgPoolMaster;
 
-  PgConnectionPool* poolP = pgPoolMaster->next;
+  unsigned int      bucket = pgConnectionPoolHash(db);
+  PgConnectionPool* poolP  = pgConnectionPoolLookup(db, bucket);
 
-  while (poolP != NULL)
+  if (poolP != NULL)
+    return poolP;
+
+  pthread_mutex_lock(&pgConnectionPoolMutex);
+
+  poolP = pgConnectionPoolLookup(db, bucket);
+  if (poolP == NULL)
   {
-    if (strcmp(poolP->db, db) == 0)
-      return poolP;
+    poolP = pgConnectionPoolCreate(db, pgPoolMaster->items);
+    if (poolP == NULL)
+    {
+      pthread_mutex_unlock(&pgConnectionPoolMutex);
+      LM_RE(NULL, ("Database Error (unable to create connection pool for db '%s')", db));
+    }
 
-    poolP = poolP->next;
+    pgConnectionPoolInsert(poolP);
   }
 
-  // No pool found, will have to create a new one
-  poolP = pgConnectionPoolCreate(db, pgPoolMaster->items);
-  if (poolP == NULL)
-    LM_RE(NULL, ("Database Error (unable to create connection pool for db '%s')", db));
+  pthread_mutex_unlock(&pgConnectionPoolMutex);
 
-  pgConnectionPoolInsert(poolP);
   return poolP;
 }
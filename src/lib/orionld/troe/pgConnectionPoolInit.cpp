@@ -25,7 +25,7 @@
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
-#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster
+#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster, pgConnectionPoolIndex
 #include "orionld/troe/pgConnectionPoolCreate.h"               // pgConnectionPoolCreate
 #include "orionld/troe/pgConnectionPoolInit.h"                 // Own interface
 
@@ -42,6 +42,8 @@ bool pgConnectionPoolInit(int poolSize)
   if (pgPoolMaster == NULL)
     LM_RE(false, ("Database Error (unable to create initial connection pool)"));
 
-  pgPoolMaster->next = NULL;
+  for (int ix = 0; ix < PG_CONNECTION_POOL_INDEX_SIZE; ix++)
+    pgConnectionPoolIndex[ix] = NULL;
+
   return true;
 }
@@ -23,7 +23,7 @@
 * Author: Ken Zangelin
 */
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
-#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster
+#include "orionld/troe/pgConnectionPools.h"                    // pgConnectionPoolIndex
 #include "orionld/troe/pgConnectionPoolInsert.h"               // Own interface
 
 
@@ -32,13 +32,15 @@
 //
 // pgConnectionPoolInsert -
 //
-// The linked list of connection pools will always have the NULL database as its first pool
-// So, insertions are done on pgPoolMaster->next.
-// New pools are inserted in the beginning of the list, so we don't need to maintain a pointer
-// to the last item in the linked list.
+// The pool of the NULL database is pgPoolMaster and never enters the index.
+// All other pools are inserted first in the chain of their hash bucket.
+// The pool is fully initialized before it is published, so a concurrent lock-free lookup sees either
+// the old chain or the new one.
+//
+// Must be called with pgConnectionPoolMutex taken.
 //
 void pgConnectionPoolInsert(PgConnectionPool* poolP)
 {
-  poolP->next        = pgPoolMaster->next;
-  pgPoolMaster->next = poolP;
+  poolP->next = pgConnectionPoolIndex[poolP->bucket];
+  __atomic_store_n(&pgConnectionPoolIndex[poolP->bucket], poolP, __ATOMIC_RELEASE);
 }
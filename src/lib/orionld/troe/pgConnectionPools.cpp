@@ -22,6 +22,8 @@
 *
 * Author: Ken Zangelin
 */
+#include <pthread.h>                                           // pthread_mutex_t
+
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
@@ -35,3 +37,19 @@
 // pgPoolMaster -
 //
 PgConnectionPool* pgPoolMaster = NULL;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionPoolIndex -
+//
+PgConnectionPool* pgConnectionPoolIndex[PG_CONNECTION_POOL_INDEX_SIZE];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionPoolMutex -
+//
+pthread_mutex_t pgConnectionPoolMutex = PTHREAD_MUTEX_INITIALIZER;
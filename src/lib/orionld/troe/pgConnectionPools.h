@@ -25,14 +25,35 @@
 *
 * Author: Ken Zangelin
 */
-#include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
+#include <pthread.h>                                           // pthread_mutex_t
+
+#include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool, PG_CONNECTION_POOL_INDEX_SIZE
 
 
 
 // -----------------------------------------------------------------------------
 //
-// pgPoolMaster -
+// pgPoolMaster - the pool of the NULL database (the "default" postgres database)
 //
 extern PgConnectionPool* pgPoolMaster;
 
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionPoolIndex - hash index of the pools of all other databases (tenants)
+//
+// Lookups are lock-free - pools are never removed from the index until the broker exits.
+// New pools are published with an atomic store, under pgConnectionPoolMutex.
+//
+extern PgConnectionPool* pgConnectionPoolIndex[PG_CONNECTION_POOL_INDEX_SIZE];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgConnectionPoolMutex - serializes the creation of new pools
+//
+extern pthread_mutex_t pgConnectionPoolMutex;
+
 #endif  // SRC_LIB_ORIONLD_TROE_PGCONNECTIONPOOLS_H_
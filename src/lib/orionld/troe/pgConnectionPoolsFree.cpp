@@ -26,7 +26,7 @@
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
-#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster
+#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster, pgConnectionPoolIndex
 #include "orionld/troe/pgConnectionPoolFree.h"                 // pgConnectionPoolFree
 #include "orionld/troe/pgConnectionPoolsFree.h"                // Own interface
 
@@ -38,13 +38,24 @@
 //
 void pgConnectionPoolsFree(void)
 {
-  PgConnectionPool* poolP = pgPoolMaster;
-
-  while (poolP != NULL)
+  for (int ix = 0; ix < PG_CONNECTION_POOL_INDEX_SIZE; ix++)
   {
-    PgConnectionPool* next = poolP->next;
+    PgConnectionPool* poolP = pgConnectionPoolIndex[ix];
+
+    while (poolP != NULL)
+    {
+      PgConnectionPool* next = poolP->next;
+
+      pgConnectionPoolFree(poolP);
+      poolP = next;
+    }
 
-    pgConnectionPoolFree(poolP);
-    poolP = next;
+    pgConnectionPoolIndex[ix] = NULL;
+  }
+
+  if (pgPoolMaster != NULL)
+  {
+    pgConnectionPoolFree(pgPoolMaster);
+    pgPoolMaster = NULL;
   }
 }
@@ -32,7 +32,7 @@ extern "C"
 
 #include "orionld/troe/PgConnection.h"                         // PgConnection
 #include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
-#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster
+#include "orionld/troe/pgConnectionPools.h"                    // pgPoolMaster, pgConnectionPoolIndex
 
 
 
@@ -44,13 +44,17 @@ static void pgConnectionPoolPresent(PgConnectionPool* poolP)
 {
   LM_TMP(("PGPOOL: Postgres Connection Pool for DB '%s'", poolP->db));
   LM_TMP(("PGPOOL:   Size of pool:   %d", poolP->items));
+  LM_TMP(("PGPOOL:   In use:         %lld (max %lld)", poolP->metrics.inUse, poolP->metrics.maxInUse));
+  LM_TMP(("PGPOOL:   Gets:           %lld", poolP->metrics.gets));
+  LM_TMP(("PGPOOL:   Waits:          %lld (%lld timeouts)", poolP->metrics.waits, poolP->metrics.timeouts));
+  LM_TMP(("PGPOOL:   Reconnects:     %lld", poolP->metrics.reconnects));
 
   for (int ix = 0; ix < poolP->items; ix++)
   {
-    if (poolP->connectionV[ix] == NULL)
-      continue;
+    PgConnection* cP = &poolP->connectionV[ix];
 
-    PgConnection* cP = poolP->connectionV[ix];
+    if (cP->connectionP == NULL)
+      continue;
 
     LM_TMP(("PGPOOL:  Connection %d:", ix));
     LM_TMP(("PGPOOL:    busy:       %s", K_FT(cP->busy)));
@@ -68,11 +72,17 @@ static void pgConnectionPoolPresent(PgConnectionPool* poolP)
 //
 void pgConnectionPoolsPresent(void)
 {
-  PgConnectionPool* poolP = pgPoolMaster;
+  if (pgPoolMaster != NULL)
+    pgConnectionPoolPresent(pgPoolMaster);
 
-  while (poolP != NULL)
+  for (int ix = 0; ix < PG_CONNECTION_POOL_INDEX_SIZE; ix++)
   {
-    pgConnectionPoolPresent(poolP);
-    poolP = poolP->next;
+    PgConnectionPool* poolP = pgConnectionPoolIndex[ix];
+
+    while (poolP != NULL)
+    {
+      pgConnectionPoolPresent(poolP);
+      poolP = poolP->next;
+    }
   }
 }
@@ -22,7 +22,12 @@
 *
 * Author: Ken Zangelin
 */
+#include <semaphore.h>                                         // sem_post
+
 #include "orionld/troe/PgConnection.h"                         // PgConnection
+#include "orionld/troe/PgConnectionPool.h"                     // PgConnectionPool
+#include "orionld/troe/pgConnectionFreeList.h"                 // pgConnectionFreeListPush
+#include "orionld/troe/pgConnectionRelease.h"                  // Own interface
 
 
 
@@ -30,8 +35,17 @@
 //
 // pgConnectionRelease - release a connection to a postgres database
 //
+// The connection goes back to the free-list of its pool before the pool's semaphore is posted, so that
+// a thread waking up from the semaphore is sure to find it there.
+// Broken connections are returned as well - pgConnectionGet reconnects them on their next use.
+//
 void pgConnectionRelease(PgConnection* connectionP)
 {
-  // Return the connection to its pool
+  PgConnectionPool* poolP = connectionP->poolP;
+
   connectionP->busy = false;
+  __atomic_sub_fetch(&poolP->metrics.inUse, 1, __ATOMIC_RELAXED);
+
+  pgConnectionFreeListPush(poolP, connectionP);
+  sem_post(&poolP->queueSem);
 }
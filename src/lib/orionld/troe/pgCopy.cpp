@@ -0,0 +1,539 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strlen, memcpy, strcmp
+#include <stdint.h>                                              // int16_t, int32_t, int64_t, uint32_t
+#include <endian.h>                                              // htobe16, htobe32, htobe64
+#include <string>                                                // std::string
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+#include "kjson/kjRenderSize.h"                                  // kjFastRenderSize
+#include "kjson/kjRender.h"                                      // kjFastRender
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "common/globals.h"                                      // parse8601Time
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldArenaAlloc.h"                    // orionldArenaAlloc
+#include "orionld/troe/PgAppendBuffer.h"                         // PgAppendBuffer
+#include "orionld/troe/kjGeoPointExtract.h"                      // kjGeoPointExtract
+#include "orionld/troe/pgCopy.h"                                 // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// POSTGRES_EPOCH - 2000-01-01T00:00:00Z - TIMESTAMP is microseconds since then
+//
+#define POSTGRES_EPOCH  946684800
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EWKB geometry types and flags
+//
+#define EWKB_POINT             1
+#define EWKB_LINESTRING        2
+#define EWKB_POLYGON           3
+#define EWKB_MULTIPOINT        4
+#define EWKB_MULTILINESTRING   5
+#define EWKB_MULTIPOLYGON      6
+#define EWKB_Z                 0x80000000
+#define EWKB_SRID              0x20000000
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyAppend - like pgAppend, but binary
+//
+static void pgCopyAppend(PgAppendBuffer* pgBufP, const void* data, int dataLen)
+{
+  if (pgBufP->copyStart == 0)  // First binary data - keep the zero-terminated "INSERT INTO" start
+  {
+    pgBufP->copyStart = pgBufP->currentIx + 1;
+    pgBufP->currentIx = pgBufP->copyStart;
+  }
+
+  if (pgBufP->currentIx + dataLen >= pgBufP->bufSize)
+  {
+    int newSize = pgBufP->bufSize * 2;
+
+    while (pgBufP->currentIx + dataLen >= newSize)
+      newSize *= 2;
+
+    //
+    // The new buffer is released at the end of the request, with all buffers of the arena of the thread.
+    // The old one is either kaAlloced or in the arena as well - so, no realloc here
+    //
+    char* newBuf = orionldArenaAlloc(newSize);
+
+    if (newBuf == NULL)
+      LM_X(1, ("Out of memory (unable to allocate %d bytes for TRoE COPY rows)", newSize));
+
+    memcpy(newBuf, pgBufP->buf, pgBufP->currentIx);
+
+    pgBufP->buf     = newBuf;
+    pgBufP->bufSize = newSize;
+  }
+
+  memcpy(&pgBufP->buf[pgBufP->currentIx], data, dataLen);
+  pgBufP->currentIx += dataLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyInt16 -
+//
+static inline void pgCopyInt16(PgAppendBuffer* pgBufP, int16_t i)
+{
+  uint16_t be = htobe16((uint16_t) i);
+  pgCopyAppend(pgBufP, &be, sizeof(be));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyInt32 -
+//
+static inline void pgCopyInt32(PgAppendBuffer* pgBufP, int32_t i)
+{
+  uint32_t be = htobe32((uint32_t) i);
+  pgCopyAppend(pgBufP, &be, sizeof(be));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyRowStart -
+//
+void pgCopyRowStart(PgAppendBuffer* pgBufP, int16_t fields)
+{
+  pgCopyInt16(pgBufP, fields);
+  pgBufP->values += 1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyNull -
+//
+void pgCopyNull(PgAppendBuffer* pgBufP)
+{
+  pgCopyInt32(pgBufP, -1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyText -
+//
+void pgCopyText(PgAppendBuffer* pgBufP, const char* s)
+{
+  if (s == NULL)
+  {
+    pgCopyNull(pgBufP);
+    return;
+  }
+
+  int sLen = strlen(s);
+
+  pgCopyInt32(pgBufP, sLen);
+  pgCopyAppend(pgBufP, s, sLen);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyBool -
+//
+void pgCopyBool(PgAppendBuffer* pgBufP, bool b)
+{
+  char c = (b == true)? 1 : 0;
+
+  pgCopyInt32(pgBufP, 1);
+  pgCopyAppend(pgBufP, &c, 1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyFloat8 -
+//
+void pgCopyFloat8(PgAppendBuffer* pgBufP, double f)
+{
+  uint64_t u;
+
+  memcpy(&u, &f, sizeof(u));
+  u = htobe64(u);
+
+  pgCopyInt32(pgBufP, 8);
+  pgCopyAppend(pgBufP, &u, sizeof(u));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTimestamp -
+//
+void pgCopyTimestamp(PgAppendBuffer* pgBufP, double t)
+{
+  int64_t  usecs = (int64_t) ((t - POSTGRES_EPOCH) * 1000000 + ((t >= POSTGRES_EPOCH)? 0.5 : -0.5));
+  uint64_t be    = htobe64((uint64_t) usecs);
+
+  pgCopyInt32(pgBufP, 8);
+  pgCopyAppend(pgBufP, &be, sizeof(be));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyIsoTimestamp -
+//
+void pgCopyIsoTimestamp(PgAppendBuffer* pgBufP, const char* iso8601)
+{
+  double t = (iso8601 != NULL)? parse8601Time(iso8601) : -1;
+
+  if (t == -1)
+    pgCopyNull(pgBufP);
+  else
+    pgCopyTimestamp(pgBufP, t);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyJsonb - version 1 of the JSONB binary format is a '1' followed by the JSON text
+//
+void pgCopyJsonb(PgAppendBuffer* pgBufP, KjNode* valueP)
+{
+  int   renderedValueSize = kjFastRenderSize(valueP);
+  char* renderedValue     = kaAlloc(&orionldState.kalloc, renderedValueSize + 1);
+  char  version           = 1;
+
+  kjFastRender(valueP, renderedValue);
+
+  int renderedValueLen = strlen(renderedValue);
+
+  pgCopyInt32(pgBufP, renderedValueLen + 1);
+  pgCopyAppend(pgBufP, &version, 1);
+  pgCopyAppend(pgBufP, renderedValue, renderedValueLen);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbHeader - byte order (little endian), geometry type and, for the top-level geometry, the SRID
+//
+static void ewkbHeader(PgAppendBuffer* pgBufP, uint32_t geometryType, bool topLevel)
+{
+  char      byteOrder = 1;
+  uint32_t  type      = geometryType | EWKB_Z | ((topLevel == true)? EWKB_SRID : 0);
+  uint32_t  srid      = 4326;
+
+  pgCopyAppend(pgBufP, &byteOrder, 1);
+  pgCopyAppend(pgBufP, &type, sizeof(type));  // WKB byte order 1: host (little endian) order
+
+  if (topLevel == true)
+    pgCopyAppend(pgBufP, &srid, sizeof(srid));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbCount - number of items in an array
+//
+static void ewkbCount(PgAppendBuffer* pgBufP, KjNode* arrayP)
+{
+  uint32_t items = 0;
+
+  for (KjNode* itemP = arrayP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+    ++items;
+
+  pgCopyAppend(pgBufP, &items, sizeof(items));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbPoint - the three doubles of a point (altitude 0 if not present)
+//
+static bool ewkbPoint(PgAppendBuffer* pgBufP, KjNode* pointP)
+{
+  double xyz[3] = { 0, 0, 0 };
+
+  if (pointP->type != KjArray)
+    return false;
+
+  if (kjGeoPointExtract(pointP, &xyz[0], &xyz[1], &xyz[2]) == false)
+    return false;
+
+  pgCopyAppend(pgBufP, xyz, sizeof(xyz));
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbPoints - a count followed by the points (LineString, ring of a Polygon)
+//
+static bool ewkbPoints(PgAppendBuffer* pgBufP, KjNode* pointArrayP)
+{
+  if (pointArrayP->type != KjArray)
+    return false;
+
+  ewkbCount(pgBufP, pointArrayP);
+
+  for (KjNode* pointP = pointArrayP->value.firstChildP; pointP != NULL; pointP = pointP->next)
+  {
+    if (ewkbPoint(pgBufP, pointP) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbRings - a count followed by the rings of a Polygon
+//
+static bool ewkbRings(PgAppendBuffer* pgBufP, KjNode* ringArrayP)
+{
+  if (ringArrayP->type != KjArray)
+    return false;
+
+  ewkbCount(pgBufP, ringArrayP);
+
+  for (KjNode* ringP = ringArrayP->value.firstChildP; ringP != NULL; ringP = ringP->next)
+  {
+    if (ewkbPoints(pgBufP, ringP) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ewkbMulti - a count followed by the geometries of a Multi-geometry
+//
+static bool ewkbMulti(PgAppendBuffer* pgBufP, KjNode* coordinatesP, uint32_t itemType)
+{
+  ewkbCount(pgBufP, coordinatesP);
+
+  for (KjNode* itemP = coordinatesP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+  {
+    bool ok;
+
+    ewkbHeader(pgBufP, itemType, false);
+
+    if      (itemType == EWKB_POINT)       ok = ewkbPoint(pgBufP, itemP);
+    else if (itemType == EWKB_LINESTRING)  ok = ewkbPoints(pgBufP, itemP);
+    else                                   ok = ewkbRings(pgBufP, itemP);
+
+    if (ok == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyGeo -
+//
+// The length of the field is known only once the EWKB has been written - it is filled in afterwards
+//
+bool pgCopyGeo(PgAppendBuffer* pgBufP, KjNode* geometryP)
+{
+  KjNode* typeNodeP        = kjLookup(geometryP, "type");
+  KjNode* coordinatesNodeP = kjLookup(geometryP, "coordinates");
+
+  if ((typeNodeP == NULL) || (typeNodeP->type != KjString) || (coordinatesNodeP == NULL) || (coordinatesNodeP->type != KjArray))
+  {
+    pgCopyNull(pgBufP);
+    LM_RE(false, ("Invalid GeoJSON geometry for TRoE"));
+  }
+
+  pgCopyInt32(pgBufP, 0);  // Placeholder for the length
+
+  int         lengthIx = pgBufP->currentIx - 4;
+  const char* geoType  = typeNodeP->value.s;
+  bool        ok;
+
+  if (strcmp(geoType, "Point") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_POINT, true);
+    ok = ewkbPoint(pgBufP, coordinatesNodeP);
+  }
+  else if (strcmp(geoType, "LineString") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_LINESTRING, true);
+    ok = ewkbPoints(pgBufP, coordinatesNodeP);
+  }
+  else if (strcmp(geoType, "Polygon") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_POLYGON, true);
+    ok = ewkbRings(pgBufP, coordinatesNodeP);
+  }
+  else if (strcmp(geoType, "MultiPoint") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_MULTIPOINT, true);
+    ok = ewkbMulti(pgBufP, coordinatesNodeP, EWKB_POINT);
+  }
+  else if (strcmp(geoType, "MultiLineString") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_MULTILINESTRING, true);
+    ok = ewkbMulti(pgBufP, coordinatesNodeP, EWKB_LINESTRING);
+  }
+  else if (strcmp(geoType, "MultiPolygon") == 0)
+  {
+    ewkbHeader(pgBufP, EWKB_MULTIPOLYGON, true);
+    ok = ewkbMulti(pgBufP, coordinatesNodeP, EWKB_POLYGON);
+  }
+  else
+    ok = false;
+
+  if (ok == false)
+  {
+    // Make it a NULL field
+    pgBufP->currentIx = lengthIx;
+    pgCopyNull(pgBufP);
+    LM_RE(false, ("Invalid GeoJSON geometry '%s' for TRoE", geoType));
+  }
+
+  uint32_t be = htobe32((uint32_t) (pgBufP->currentIx - lengthIx - 4));
+  memcpy(&pgBufP->buf[lengthIx], &be, sizeof(be));
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValue -
+//
+//   valueType, text, boolean, number, datetime, compound,
+//   geoPoint, geoMultiPoint, geoPolygon, geoMultiPolygon, geoLineString, geoMultiLineString
+//
+void pgCopyValue(PgAppendBuffer* pgBufP, const char* attrType, KjNode* valueNodeP, const char* object)
+{
+  const char*  valueType = NULL;
+  int          geoIx     = -1;  // Index of the geo field, 0-5
+
+  if (attrType == NULL)
+    valueType = NULL;
+  else if (strcmp(attrType, "Relationship") == 0)
+    valueType = "Relationship";
+  else if (strcmp(attrType, "GeoProperty") == 0)
+  {
+    KjNode*      geoTypeNodeP = kjLookup(valueNodeP, "type");
+    const char*  geoType      = ((geoTypeNodeP != NULL) && (geoTypeNodeP->type == KjString))? geoTypeNodeP->value.s : "";
+
+    if      (strcmp(geoType, "Point")           == 0) { valueType = "GeoPoint";           geoIx = 0; }
+    else if (strcmp(geoType, "MultiPoint")      == 0) { valueType = "GeoMultiPoint";      geoIx = 1; }
+    else if (strcmp(geoType, "Polygon")         == 0) { valueType = "GeoPolygon";         geoIx = 2; }
+    else if (strcmp(geoType, "MultiPolygon")    == 0) { valueType = "GeoMultiPolygon";    geoIx = 3; }
+    else if (strcmp(geoType, "LineString")      == 0) { valueType = "GeoLineString";      geoIx = 4; }
+    else if (strcmp(geoType, "MultiLineString") == 0) { valueType = "GeoMultiLineString"; geoIx = 5; }
+  }
+  else if (valueNodeP != NULL)
+  {
+    if      (valueNodeP->type == KjString)   valueType = "String";
+    else if (valueNodeP->type == KjBoolean)  valueType = "Boolean";
+    else if (valueNodeP->type == KjInt)      valueType = "Number";
+    else if (valueNodeP->type == KjFloat)    valueType = "Number";
+    else if (valueNodeP->type == KjArray)    valueType = "Compound";
+    else if (valueNodeP->type == KjObject)   valueType = "Compound";
+  }
+
+  pgCopyText(pgBufP, valueType);
+
+  // text
+  if ((valueType != NULL) && (strcmp(valueType, "Relationship") == 0))
+    pgCopyText(pgBufP, object);
+  else if ((valueType != NULL) && (strcmp(valueType, "String") == 0))
+    pgCopyText(pgBufP, valueNodeP->value.s);
+  else
+    pgCopyNull(pgBufP);
+
+  // boolean
+  if ((valueType != NULL) && (strcmp(valueType, "Boolean") == 0))
+    pgCopyBool(pgBufP, valueNodeP->value.b);
+  else
+    pgCopyNull(pgBufP);
+
+  // number
+  if ((valueType != NULL) && (strcmp(valueType, "Number") == 0))
+    pgCopyFloat8(pgBufP, (valueNodeP->type == KjInt)? (double) valueNodeP->value.i : valueNodeP->value.f);
+  else
+    pgCopyNull(pgBufP);
+
+  // datetime - not used by TRoE (as in the SQL VALUES)
+  pgCopyNull(pgBufP);
+
+  // compound
+  if ((valueType != NULL) && (strcmp(valueType, "Compound") == 0))
+    pgCopyJsonb(pgBufP, valueNodeP);
+  else
+    pgCopyNull(pgBufP);
+
+  // The six geo fields
+  for (int ix = 0; ix < 6; ix++)
+  {
+    if (ix == geoIx)
+      pgCopyGeo(pgBufP, valueNodeP);
+    else
+      pgCopyNull(pgBufP);
+  }
+}
@@ -0,0 +1,135 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGCOPY_H_
+#define SRC_LIB_ORIONLD_TROE_PGCOPY_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // int16_t
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "orionld/troe/PgAppendBuffer.h"                         // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Binary COPY rows
+//
+//   With -troeCopy, the rows of the TRoE tables are not rendered as SQL VALUES but in the binary format
+//   of the postgres COPY protocol. They are sent with PQputCopyData (see pgCopyExec).
+//
+//   The PgAppendBuffer still starts with its "INSERT INTO table(columns) VALUES " (from PgTableDefinitions.h),
+//   that gives pgCopyExec the table and the order of the columns, while the binary rows start at copyStart.
+//
+//   Each row is the number of fields (int16) followed by each field as its length (int32, -1 for NULL) and its value.
+//   All integers in network byte order.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyRowStart - start a new row of 'fields' fields
+//
+extern void pgCopyRowStart(PgAppendBuffer* pgBufP, int16_t fields);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyNull -
+//
+extern void pgCopyNull(PgAppendBuffer* pgBufP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyText - TEXT, VARCHAR and ENUM fields (the binary format of an ENUM is its label) - NULL for null
+//
+extern void pgCopyText(PgAppendBuffer* pgBufP, const char* s);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyBool -
+//
+extern void pgCopyBool(PgAppendBuffer* pgBufP, bool b);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyFloat8 -
+//
+extern void pgCopyFloat8(PgAppendBuffer* pgBufP, double f);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTimestamp - TIMESTAMP field from seconds since the epoch
+//
+extern void pgCopyTimestamp(PgAppendBuffer* pgBufP, double t);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyIsoTimestamp - TIMESTAMP field from an ISO8601 string - NULL (or invalid) for null
+//
+extern void pgCopyIsoTimestamp(PgAppendBuffer* pgBufP, const char* iso8601);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyJsonb - JSONB field from a KjNode tree
+//
+extern void pgCopyJsonb(PgAppendBuffer* pgBufP, KjNode* valueP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyGeo - GEOGRAPHY field, as EWKB (with Z and SRID 4326), from a GeoJSON geometry
+//
+extern bool pgCopyGeo(PgAppendBuffer* pgBufP, KjNode* geometryP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValue - the twelve value fields (valueType ... geoMultiLineString) of attributes and subAttributes
+//
+// A NULL attrType gives twelve NULL fields (a deleted attribute)
+//
+extern void pgCopyValue(PgAppendBuffer* pgBufP, const char* attrType, KjNode* valueNodeP, const char* object);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGCOPY_H_
@@ -0,0 +1,121 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+#include <string.h>                                              // strstr, strlen, strncmp
+#include <stdint.h>                                              // uint16_t
+#include <endian.h>                                              // htobe16
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/troe/pgCopyExec.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyHeader - signature, flags field (int32 0) and header extension length (int32 0)
+//
+static const char pgCopyHeader[19] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0', 0, 0, 0, 0, 0, 0, 0, 0 };
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyCommand - "COPY table(columns) FROM STDIN (FORMAT binary)" out of "INSERT INTO table(columns) VALUES "
+//
+static bool pgCopyCommand(const char* insertStart, char* command, int commandSize)
+{
+  const char* tableStart = "INSERT INTO ";
+  int         tableLen   = strlen(tableStart);
+  const char* valuesP    = strstr(insertStart, " VALUES ");
+
+  if ((strncmp(insertStart, tableStart, tableLen) != 0) || (valuesP == NULL))
+    LM_RE(false, ("Internal Error (not a TRoE INSERT command: '%s')", insertStart));
+
+  int len = snprintf(command, commandSize, "COPY %.*s FROM STDIN (FORMAT binary)", (int) (valuesP - &insertStart[tableLen]), &insertStart[tableLen]);
+
+  if (len >= commandSize)
+    LM_RE(false, ("Internal Error (COPY command too long)"));
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyExec -
+//
+bool pgCopyExec(PGconn* connectionP, const char* insertStart, const char* rows, int rowsLen)
+{
+  char       command[1024];
+  uint16_t   trailer = htobe16((uint16_t) -1);
+  PGresult*  res;
+  bool       ok      = true;
+
+  if (pgCopyCommand(insertStart, command, sizeof(command)) == false)
+    return false;
+
+  res = PQexec(connectionP, command);
+  if ((res == NULL) || (PQresultStatus(res) != PGRES_COPY_IN))
+  {
+    LM_E(("Database Error (%s: %s)", (res == NULL)? "no result" : PQresStatus(PQresultStatus(res)), PQerrorMessage(connectionP)));
+    if (res != NULL)
+      PQclear(res);
+    return false;
+  }
+  PQclear(res);
+
+  if ((PQputCopyData(connectionP, pgCopyHeader, sizeof(pgCopyHeader))    != 1) ||
+      (PQputCopyData(connectionP, rows, rowsLen)                         != 1) ||
+      (PQputCopyData(connectionP, (const char*) &trailer, sizeof(trailer)) != 1))
+  {
+    LM_E(("Database Error (PQputCopyData: %s)", PQerrorMessage(connectionP)));
+    PQputCopyEnd(connectionP, "TRoE COPY aborted");
+    ok = false;
+  }
+  else if (PQputCopyEnd(connectionP, NULL) != 1)
+  {
+    LM_E(("Database Error (PQputCopyEnd: %s)", PQerrorMessage(connectionP)));
+    ok = false;
+  }
+
+  // Drain all results - the COPY is finished only after PQgetResult returns NULL
+  while ((res = PQgetResult(connectionP)) != NULL)
+  {
+    if (PQresultStatus(res) != PGRES_COMMAND_OK)
+    {
+      if (ok == true)
+        LM_E(("Database Error (COPY: %s: %s)", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res)));
+      ok = false;
+    }
+
+    PQclear(res);
+  }
+
+  return ok;
+}
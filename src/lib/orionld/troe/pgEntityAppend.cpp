@@ -27,6 +27,7 @@
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
+#include "orionld/troe/pgCopy.h"                               // pgCopyRowStart, pgCopyText, pgCopyTimestamp
 #include "orionld/troe/pgEntityAppend.h"                       // pgEntityAppend
 
 
@@ -43,6 +44,17 @@
 //
 void pgEntityAppend(PgAppendBuffer* entitiesBufferP, const char* opMode, const char* entityId, const char* entityType, const char* instanceId)
 {
+  if (entitiesBufferP->copy == true)
+  {
+    pgCopyRowStart(entitiesBufferP, 5);
+    pgCopyText(entitiesBufferP, instanceId);
+    pgCopyTimestamp(entitiesBufferP, orionldState.requestTime);
+    pgCopyText(entitiesBufferP, opMode);
+    pgCopyText(entitiesBufferP, entityId);
+    pgCopyText(entitiesBufferP, entityType);
+    return;
+  }
+
   char         buf[1024];
   const char*  comma = (entitiesBufferP->values != 0)? "," : "";
 
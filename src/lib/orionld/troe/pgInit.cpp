@@ -29,7 +29,7 @@
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/common/pqHeader.h"                           // Postgres header
-#include "orionld/common/orionldState.h"                       // troePort
+#include "orionld/common/orionldState.h"                       // troePort, troePoolSize
 #include "orionld/troe/pgConnectionPoolInit.h"                 // pgConnectionPoolInit
 #include "orionld/troe/pgDatabasePrepare.h"                    // pgDatabasePrepare
 #include "orionld/troe/pgInit.h"                               // Own interface
@@ -44,7 +44,7 @@ bool pgInit(const char* dbPrefix)
 {
   snprintf(pgPortString, sizeof(pgPortString), "%d", troePort);
 
-  if (pgConnectionPoolInit(10) == false)
+  if (pgConnectionPoolInit((troePoolSize > 0)? troePoolSize : 10) == false)
     LM_RE(false, ("error initializing the postgres connection pools"));
 
   bool b = pgDatabasePrepare(dbPrefix);
@@ -41,6 +41,7 @@ extern "C"
 #include "orionld/troe/PgAppendBuffer.h"                       // PgAppendBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgQuotedString.h"                       // pgQuotedString
+#include "orionld/troe/pgCopy.h"                               // pgCopy*
 #include "orionld/troe/pgObservedAtExtract.h"                  // pgObservedAtExtract
 #include "orionld/troe/kjGeoPointExtract.h"                    // kjGeoPointExtract
 #include "orionld/troe/kjGeoMultiPointExtract.h"               // kjGeoMultiPointExtract
@@ -52,6 +53,39 @@ extern "C"
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subAttributeCopyAppend - binary COPY row for the subAttributes table - same fields in the same order as subAttributeAppend
+//
+static void subAttributeCopyAppend
+(
+  PgAppendBuffer*  subAttributesBufferP,
+  const char*      instanceId,
+  const char*      subAttributeName,
+  const char*      entityId,
+  const char*      attrInstanceId,
+  const char*      attrDatasetId,
+  const char*      type,
+  const char*      observedAt,
+  const char*      unitCode,
+  KjNode*          valueNodeP,
+  const char*      object
+)
+{
+  pgCopyRowStart(subAttributesBufferP, 20);
+  pgCopyText(subAttributesBufferP, instanceId);
+  pgCopyText(subAttributesBufferP, subAttributeName);
+  pgCopyText(subAttributesBufferP, entityId);
+  pgCopyText(subAttributesBufferP, attrInstanceId);
+  pgCopyText(subAttributesBufferP, (attrDatasetId == NULL)? "None" : attrDatasetId);
+  pgCopyIsoTimestamp(subAttributesBufferP, observedAt);
+  pgCopyText(subAttributesBufferP, unitCode);
+  pgCopyValue(subAttributesBufferP, type, valueNodeP, object);
+  pgCopyTimestamp(subAttributesBufferP, orionldState.requestTime);
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // subAttributeAppend -
@@ -80,6 +114,8 @@ extern "C"
 //
 // This function appends a new ('', '', '', ...) for the VALUES of subAttributesBuffer
 //
+// With -troeCopy, the same fields are appended as a binary COPY row instead (subAttributeCopyAppend)
+//
 static void subAttributeAppend
 (
   PgAppendBuffer*  subAttributesBufferP,
@@ -95,6 +131,12 @@ static void subAttributeAppend
   const char*      object
 )
 {
+  if (subAttributesBufferP->copy == true)
+  {
+    subAttributeCopyAppend(subAttributesBufferP, instanceId, subAttributeName, entityId, attrInstanceId, attrDatasetId, type, observedAt, unitCode, valueNodeP, object);
+    return;
+  }
+
   int         bufSize = 20480;
   char*       buf     = kaAlloc(&orionldState.kalloc, bufSize);
   const char* comma   = (subAttributesBufferP->values != 0)? "," : "";
@@ -0,0 +1,740 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+#include <stdlib.h>                                              // strtod, strtoll, qsort, bsearch
+#include <string.h>                                              // strcmp, strncmp, strlen, strpbrk
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjObject, kjArray, kjString, kjChildAdd, ...
+#include "kjson/kjLookup.h"                                      // kjLookup
+#include "kjson/kjParse.h"                                       // kjParse
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/context/orionldContextItemAliasLookup.h"       // orionldContextItemAliasLookup
+#include "orionld/troe/PgAppendBuffer.h"                         // PgAppendBuffer
+#include "orionld/troe/pgAppendInit.h"                           // pgAppendInit
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/PgConnection.h"                           // PgConnection
+#include "orionld/troe/pgConnectionGet.h"                        // pgConnectionGet
+#include "orionld/troe/pgConnectionRelease.h"                    // pgConnectionRelease
+#include "orionld/troe/pgTransactionBegin.h"                     // pgTransactionBegin
+#include "orionld/troe/pgTransactionCommit.h"                    // pgTransactionCommit
+#include "orionld/troe/pgTransactionRollback.h"                  // pgTransactionRollback
+#include "orionld/troe/TemporalQuery.h"                          // TemporalQuery
+#include "orionld/troe/pgTemporalQuery.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TEMPORAL_FETCH_SIZE - number of attribute instances per FETCH from the server-side cursor
+//
+#define TEMPORAL_FETCH_SIZE  1000
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SQL fragments for the value of an attribute/sub-attribute - six consecutive columns
+//
+#define ISO8601_FORMAT  "'YYYY-MM-DD\"T\"HH24:MI:SS.MS\"Z\"'"
+
+#define VALUE_COLUMNS                                                                                     \
+  "valueType, text, boolean, number, compound::text, "                                                    \
+  "ST_AsGeoJSON(COALESCE(geoPoint, geoMultiPoint, geoPolygon, geoMultiPolygon, geoLineString, geoMultiLineString))"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Columns of the attribute instance cursor
+//
+#define A_ENTITY_ID       0
+#define A_ID              1
+#define A_DATASET_ID      2
+#define A_INSTANCE_ID     3
+#define A_VALUE           4   // Six columns - VALUE_COLUMNS
+#define A_OBSERVED_AT     10
+#define A_UNIT_CODE       11
+#define A_TS              12
+#define A_SUB_PROPERTIES  13
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Columns of the sub-attribute query
+//
+#define S_ATTR_INSTANCE_ID  0
+#define S_ID                1
+#define S_VALUE             2   // Six columns - VALUE_COLUMNS
+#define S_OBSERVED_AT       8
+#define S_UNIT_CODE         9
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PgParams - the string parameters of a query - all user input is sent as parameters, never inside the SQL
+//
+typedef struct PgParams
+{
+  const char*  valueV[8];
+  int          count;
+} PgParams;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SubAttrOwner - an attribute instance that has sub-attributes
+//
+typedef struct SubAttrOwner
+{
+  char*    instanceId;
+  KjNode*  instanceP;
+} SubAttrOwner;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// paramAdd - add a parameter and append its placeholder ($N) to the SQL
+//
+static void paramAdd(PgAppendBuffer* sqlP, PgParams* paramsP, const char* value, const char* cast)
+{
+  char placeholder[32];
+
+  paramsP->valueV[paramsP->count++] = value;
+
+  snprintf(placeholder, sizeof(placeholder), "$%d%s", paramsP->count, (cast != NULL)? cast : "");
+  pgAppend(sqlP, placeholder, 0);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// textArray - a postgres text[] literal out of a vector of strings: {"a","b"}
+//
+static char* textArray(char** vector, int items)
+{
+  int size = 3;
+
+  for (int ix = 0; ix < items; ix++)
+    size += 2 * strlen(vector[ix]) + 3;  // Worst case: all chars escaped, plus quotes and comma
+
+  char* array = kaAlloc(&orionldState.kalloc, size);
+  char* outP  = array;
+
+  *outP++ = '{';
+  for (int ix = 0; ix < items; ix++)
+  {
+    if (ix != 0)
+      *outP++ = ',';
+
+    *outP++ = '"';
+    for (char* cP = vector[ix]; *cP != 0; ++cP)
+    {
+      if ((*cP == '"') || (*cP == '\\'))
+        *outP++ = '\\';
+      *outP++ = *cP;
+    }
+    *outP++ = '"';
+  }
+  *outP++ = '}';
+  *outP   = 0;
+
+  return array;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeConditionAppend - the timerel pushdown - the times are numbers (parsed by temporalQueryFromUriParams), safe to inline
+//
+// The TRoE timestamps are UTC (TIMESTAMP without time zone)
+//
+static void timeConditionAppend(PgAppendBuffer* sqlP, TemporalQuery* tqP, const char* alias)
+{
+  char condition[256];
+
+  if (tqP->timerel == TemporalTimeRelBefore)
+    snprintf(condition, sizeof(condition), " AND %s.%s < (to_timestamp(%.6f) AT TIME ZONE 'UTC')", alias, tqP->timeColumn, tqP->timeAt);
+  else if (tqP->timerel == TemporalTimeRelAfter)
+    snprintf(condition, sizeof(condition), " AND %s.%s > (to_timestamp(%.6f) AT TIME ZONE 'UTC')", alias, tqP->timeColumn, tqP->timeAt);
+  else if (tqP->timerel == TemporalTimeRelBetween)
+    snprintf(condition, sizeof(condition), " AND %s.%s >= (to_timestamp(%.6f) AT TIME ZONE 'UTC') AND %s.%s < (to_timestamp(%.6f) AT TIME ZONE 'UTC')",
+             alias, tqP->timeColumn, tqP->timeAt, alias, tqP->timeColumn, tqP->endTimeAt);
+  else
+    return;
+
+  pgAppend(sqlP, condition, 0);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityConditionsAppend - the WHERE of the entity selection
+//
+static void entityConditionsAppend(PgAppendBuffer* sqlP, PgParams* paramsP, TemporalQuery* tqP)
+{
+  pgAppend(sqlP, " WHERE e.type IS NOT NULL", 0);  // The Delete records have no entity type
+
+  if (tqP->ids > 0)
+  {
+    pgAppend(sqlP, " AND e.id = ANY(", 0);
+    paramAdd(sqlP, paramsP, textArray(tqP->idV, tqP->ids), "::text[]");
+    pgAppend(sqlP, ")", 0);
+  }
+
+  if (tqP->types > 0)
+  {
+    pgAppend(sqlP, " AND e.type = ANY(", 0);
+    paramAdd(sqlP, paramsP, textArray(tqP->typeV, tqP->types), "::text[]");
+    pgAppend(sqlP, ")", 0);
+  }
+
+  if (tqP->idPattern != NULL)
+  {
+    pgAppend(sqlP, " AND e.id ~ ", 0);
+    paramAdd(sqlP, paramsP, tqP->idPattern, NULL);
+  }
+
+  // Only entities with matching attribute instances
+  if ((tqP->attrs > 0) || (tqP->timerel != TemporalTimeRelNone))
+  {
+    pgAppend(sqlP, " AND EXISTS (SELECT 1 FROM attributes a WHERE a.entityId = e.id AND a.opMode != 'Delete'", 0);
+
+    if (tqP->attrs > 0)
+    {
+      pgAppend(sqlP, " AND a.id = ANY(", 0);
+      paramAdd(sqlP, paramsP, textArray(tqP->attrV, tqP->attrs), "::text[]");
+      pgAppend(sqlP, ")", 0);
+    }
+
+    timeConditionAppend(sqlP, tqP, "a");
+    pgAppend(sqlP, ")", 0);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// queryExec -
+//
+static PGresult* queryExec(PGconn* connectionP, const char* sql, PgParams* paramsP, ExecStatusType expected)
+{
+  PGresult* res = PQexecParams(connectionP, sql, paramsP->count, NULL, paramsP->valueV, NULL, NULL, 0);
+
+  if (res == NULL)
+    LM_RE(NULL, ("Database Error (PQexecParams: %s)", PQerrorMessage(connectionP)));
+
+  if (PQresultStatus(res) != expected)
+  {
+    LM_E(("Database Error (%s: %s)", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res)));
+    LM_E(("Database Error (SQL: %s)", sql));
+    PQclear(res);
+    return NULL;
+  }
+
+  return res;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aliasLookup - compact an expanded name, the result lives in kalloc (or the context)
+//
+static char* aliasLookup(const char* longName)
+{
+  char* name = kaStrdup(&orionldState.kalloc, longName);
+
+  return orionldContextItemAliasLookup(orionldState.contextP, name, NULL, NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// temporalEntities - the entities of the page (id and type), ordered by entity id
+//
+static KjNode* temporalEntities(PGconn* connectionP, TemporalQuery* tqP, int* countP)
+{
+  PgAppendBuffer  sql;
+  PgParams        params = { { NULL }, 0 };
+  char            pagination[64];
+
+  pgAppendInit(&sql, 2 * 1024);
+  pgAppend(&sql, "SELECT id, type FROM (SELECT DISTINCT ON (e.id) e.id, e.type FROM entities e", 0);
+  entityConditionsAppend(&sql, &params, tqP);
+  snprintf(pagination, sizeof(pagination), " ORDER BY e.id, e.ts DESC) AS latest ORDER BY id LIMIT %d OFFSET %d", tqP->limit, tqP->offset);
+  pgAppend(&sql, pagination, 0);
+
+  PGresult* res = queryExec(connectionP, sql.buf, &params, PGRES_TUPLES_OK);
+  if (res == NULL)
+    return NULL;
+
+  KjNode* entityArrayP = kjArray(orionldState.kjsonP, NULL);
+  int     rows         = PQntuples(res);
+
+  for (int row = 0; row < rows; row++)
+  {
+    KjNode* entityP = kjObject(orionldState.kjsonP, NULL);
+
+    kjChildAdd(entityP, kjString(orionldState.kjsonP, "id",   kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, 0))));
+    kjChildAdd(entityP, kjString(orionldState.kjsonP, "type", aliasLookup(PQgetvalue(res, row, 1))));
+    kjChildAdd(entityArrayP, entityP);
+  }
+  PQclear(res);
+
+  if ((countP != NULL) && (tqP->count == true))
+  {
+    PgAppendBuffer  countSql;
+    PgParams        countParams = { { NULL }, 0 };
+
+    pgAppendInit(&countSql, 2 * 1024);
+    pgAppend(&countSql, "SELECT count(DISTINCT e.id) FROM entities e", 0);
+    entityConditionsAppend(&countSql, &countParams, tqP);
+
+    res = queryExec(connectionP, countSql.buf, &countParams, PGRES_TUPLES_OK);
+    if (res == NULL)
+      return NULL;
+
+    *countP = atoi(PQgetvalue(res, 0, 0));
+    PQclear(res);
+  }
+
+  return entityArrayP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// valueNode - the "value" (or "object") of an instance, from the six VALUE_COLUMNS starting at 'col'
+//
+// Also returns the NGSI-LD type of the attribute (Property, Relationship or GeoProperty)
+//
+static KjNode* valueNode(PGresult* res, int row, int col, const char** attrTypeP)
+{
+  if (PQgetisnull(res, row, col))
+    return NULL;
+
+  const char* valueType = PQgetvalue(res, row, col);
+  KjNode*     valueP    = NULL;
+
+  *attrTypeP = "Property";
+
+  if (strcmp(valueType, "Relationship") == 0)
+  {
+    *attrTypeP = "Relationship";
+    valueP     = kjString(orionldState.kjsonP, "object", kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, col + 1)));
+  }
+  else if (strcmp(valueType, "String") == 0)
+    valueP = kjString(orionldState.kjsonP, "value", kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, col + 1)));
+  else if (strcmp(valueType, "Boolean") == 0)
+    valueP = kjBoolean(orionldState.kjsonP, "value", PQgetvalue(res, row, col + 2)[0] == 't');
+  else if (strcmp(valueType, "Number") == 0)
+  {
+    const char* number = PQgetvalue(res, row, col + 3);
+
+    if (strpbrk(number, ".eEnN") == NULL)  // No decimals, no exponent, no NaN
+      valueP = kjInteger(orionldState.kjsonP, "value", strtoll(number, NULL, 10));
+    else
+      valueP = kjFloat(orionldState.kjsonP, "value", strtod(number, NULL));
+  }
+  else if ((strcmp(valueType, "Compound") == 0) || (strncmp(valueType, "Geo", 3) == 0))
+  {
+    int   textCol = (valueType[0] == 'C')? col + 4 : col + 5;
+    char* json    = kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, textCol));
+
+    valueP = kjParse(orionldState.kjsonP, json);
+    if (valueP == NULL)
+      LM_RE(NULL, ("Database Error (invalid JSON in TRoE %s value: '%s')", valueType, PQgetvalue(res, row, textCol)));
+
+    valueP->name = (char*) "value";
+
+    if (valueType[0] == 'G')
+      *attrTypeP = "GeoProperty";
+  }
+
+  return valueP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringAdd - add a string member from a column, unless it's NULL
+//
+static void stringAdd(KjNode* containerP, const char* name, PGresult* res, int row, int col)
+{
+  if (PQgetisnull(res, row, col))
+    return;
+
+  kjChildAdd(containerP, kjString(orionldState.kjsonP, name, kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, col))));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ownerCompare - for qsort/bsearch of SubAttrOwner
+//
+static int ownerCompare(const void* a, const void* b)
+{
+  return strcmp(((const SubAttrOwner*) a)->instanceId, ((const SubAttrOwner*) b)->instanceId);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subAttributesAdd - add the sub-attributes of the instances of one FETCH
+//
+static bool subAttributesAdd(PGconn* connectionP, SubAttrOwner* ownerV, int owners)
+{
+  char**    instanceIdV = (char**) kaAlloc(&orionldState.kalloc, owners * sizeof(char*));
+  PgParams  params      = { { NULL }, 0 };
+
+  for (int ix = 0; ix < owners; ix++)
+    instanceIdV[ix] = ownerV[ix].instanceId;
+
+  params.valueV[params.count++] = textArray(instanceIdV, owners);
+
+  PGresult* res = queryExec(connectionP,
+                            "SELECT attrInstanceId, id, " VALUE_COLUMNS ", to_char(observedAt, " ISO8601_FORMAT "), unitCode "
+                            "FROM subAttributes WHERE attrInstanceId = ANY($1::text[])",
+                            &params,
+                            PGRES_TUPLES_OK);
+  if (res == NULL)
+    return false;
+
+  qsort(ownerV, owners, sizeof(SubAttrOwner), ownerCompare);
+
+  int rows = PQntuples(res);
+  for (int row = 0; row < rows; row++)
+  {
+    SubAttrOwner  key     = { PQgetvalue(res, row, S_ATTR_INSTANCE_ID), NULL };
+    SubAttrOwner* ownerP  = (SubAttrOwner*) bsearch(&key, ownerV, owners, sizeof(SubAttrOwner), ownerCompare);
+    const char*   subType = NULL;
+
+    if (ownerP == NULL)
+      continue;
+
+    KjNode* valueP = valueNode(res, row, S_VALUE, &subType);
+    if (valueP == NULL)
+      continue;
+
+    KjNode* subAttrP = kjObject(orionldState.kjsonP, aliasLookup(PQgetvalue(res, row, S_ID)));
+
+    kjChildAdd(subAttrP, kjString(orionldState.kjsonP, "type", subType));
+    kjChildAdd(subAttrP, valueP);
+    stringAdd(subAttrP, "observedAt", res, row, S_OBSERVED_AT);
+    stringAdd(subAttrP, "unitCode",   res, row, S_UNIT_CODE);
+
+    kjChildAdd(ownerP->instanceP, subAttrP);
+  }
+
+  PQclear(res);
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityFind - the entities and the attribute instances come in the same order (ORDER BY entity id)
+//
+static KjNode* entityFind(KjNode* entityArrayP, KjNode* currentP, const char* entityId)
+{
+  for (KjNode* entityP = currentP; entityP != NULL; entityP = entityP->next)
+  {
+    if (strcmp(entityP->value.firstChildP->value.s, entityId) == 0)
+      return entityP;
+  }
+
+  for (KjNode* entityP = entityArrayP->value.firstChildP; entityP != currentP; entityP = entityP->next)
+  {
+    if (strcmp(entityP->value.firstChildP->value.s, entityId) == 0)
+      return entityP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// attributeContainer - the array of instances (or the simplified object) of an attribute of an entity
+//
+static KjNode* attributeContainer(KjNode* entityP, const char* attrLongName, const char* attrType, bool temporalValues)
+{
+  char*   attrName = aliasLookup(attrLongName);
+  KjNode* attrP    = kjLookup(entityP, attrName);
+
+  if (attrP != NULL)
+    return attrP;
+
+  if (temporalValues == false)
+    attrP = kjArray(orionldState.kjsonP, attrName);
+  else
+  {
+    attrP = kjObject(orionldState.kjsonP, attrName);
+    kjChildAdd(attrP, kjString(orionldState.kjsonP, "type", attrType));
+    kjChildAdd(attrP, kjArray(orionldState.kjsonP, (strcmp(attrType, "Relationship") == 0)? "objects" : "values"));
+  }
+
+  kjChildAdd(entityP, attrP);
+  return attrP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// instancesFetch - FETCH from the cursor until it is exhausted, adding the instances to the entities
+//
+static bool instancesFetch(PGconn* connectionP, TemporalQuery* tqP, KjNode* entityArrayP)
+{
+  PgParams      noParams  = { { NULL }, 0 };
+  KjNode*       entityP   = entityArrayP->value.firstChildP;
+  SubAttrOwner  ownerV[TEMPORAL_FETCH_SIZE];
+  char          fetch[64];
+
+  snprintf(fetch, sizeof(fetch), "FETCH %d FROM troeTemporalCursor", TEMPORAL_FETCH_SIZE);
+
+  while (1)
+  {
+    PGresult* res = queryExec(connectionP, fetch, &noParams, PGRES_TUPLES_OK);
+
+    if (res == NULL)
+      return false;
+
+    int rows   = PQntuples(res);
+    int owners = 0;
+
+    for (int row = 0; row < rows; row++)
+    {
+      const char* attrType = NULL;
+      KjNode*     valueP   = valueNode(res, row, A_VALUE, &attrType);
+
+      if (valueP == NULL)
+        continue;
+
+      entityP = entityFind(entityArrayP, entityP, PQgetvalue(res, row, A_ENTITY_ID));
+      if (entityP == NULL)  // Can't happen - the cursor is limited to the entities of the page
+      {
+        entityP = entityArrayP->value.firstChildP;
+        continue;
+      }
+
+      KjNode* attrP = attributeContainer(entityP, PQgetvalue(res, row, A_ID), attrType, tqP->temporalValues);
+
+      if (tqP->temporalValues == true)
+      {
+        // [ value, time ]
+        int     timeCol = (strcmp(tqP->timeColumn, "ts") == 0)? A_TS : A_OBSERVED_AT;
+        KjNode* pairP   = kjArray(orionldState.kjsonP, NULL);
+
+        valueP->name = NULL;
+        kjChildAdd(pairP, valueP);
+
+        if (PQgetisnull(res, row, timeCol))
+          kjChildAdd(pairP, kjNull(orionldState.kjsonP, NULL));
+        else
+          kjChildAdd(pairP, kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, timeCol))));
+
+        kjChildAdd(attrP->value.firstChildP->next, pairP);
+        continue;
+      }
+
+      KjNode* instanceP = kjObject(orionldState.kjsonP, NULL);
+
+      kjChildAdd(instanceP, kjString(orionldState.kjsonP, "type", attrType));
+      kjChildAdd(instanceP, valueP);
+      stringAdd(instanceP, "observedAt", res, row, A_OBSERVED_AT);
+      stringAdd(instanceP, "unitCode",   res, row, A_UNIT_CODE);
+      stringAdd(instanceP, "instanceId", res, row, A_INSTANCE_ID);
+
+      if (strcmp(PQgetvalue(res, row, A_DATASET_ID), "None") != 0)
+        stringAdd(instanceP, "datasetId", res, row, A_DATASET_ID);
+
+      if (tqP->sysAttrs == true)
+        stringAdd(instanceP, "modifiedAt", res, row, A_TS);
+
+      kjChildAdd(attrP, instanceP);
+
+      if ((PQgetisnull(res, row, A_SUB_PROPERTIES) == false) && (PQgetvalue(res, row, A_SUB_PROPERTIES)[0] == 't'))
+      {
+        ownerV[owners].instanceId = kaStrdup(&orionldState.kalloc, PQgetvalue(res, row, A_INSTANCE_ID));
+        ownerV[owners].instanceP  = instanceP;
+        ++owners;
+      }
+    }
+
+    PQclear(res);
+
+    if ((owners > 0) && (subAttributesAdd(connectionP, ownerV, owners) == false))
+      return false;
+
+    if (rows < TEMPORAL_FETCH_SIZE)
+      break;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// instancesCursorDeclare - the server-side cursor over the attribute instances of the entities of the page
+//
+// lastN is pushed down to postgres as a window function - only the last N instances of each attribute
+// (and datasetId) are ever sent back to the broker.
+//
+static bool instancesCursorDeclare(PGconn* connectionP, TemporalQuery* tqP, KjNode* entityArrayP)
+{
+  PgAppendBuffer  sql;
+  PgParams        params = { { NULL }, 0 };
+  char            buf[512];
+  int             entities = 0;
+
+  for (KjNode* entityP = entityArrayP->value.firstChildP; entityP != NULL; entityP = entityP->next)
+    ++entities;
+
+  char** entityIdV = (char**) kaAlloc(&orionldState.kalloc, entities * sizeof(char*));
+  int    ix        = 0;
+
+  for (KjNode* entityP = entityArrayP->value.firstChildP; entityP != NULL; entityP = entityP->next)
+    entityIdV[ix++] = entityP->value.firstChildP->value.s;
+
+  pgAppendInit(&sql, 4 * 1024);
+  pgAppend(&sql, "DECLARE troeTemporalCursor NO SCROLL CURSOR FOR ", 0);
+  pgAppend(&sql, "SELECT entityId, id, datasetId, instanceId, " VALUE_COLUMNS ", ", 0);
+  pgAppend(&sql, "to_char(observedAt, " ISO8601_FORMAT "), unitCode, to_char(ts, " ISO8601_FORMAT "), subProperties ", 0);
+  pgAppend(&sql, "FROM (SELECT a.*", 0);
+
+  if (tqP->lastN > 0)
+  {
+    snprintf(buf, sizeof(buf), ", row_number() OVER (PARTITION BY a.entityId, a.id, a.datasetId ORDER BY a.%s DESC NULLS LAST, a.ts DESC) AS troeRowNo", tqP->timeColumn);
+    pgAppend(&sql, buf, 0);
+  }
+
+  pgAppend(&sql, " FROM attributes a WHERE a.opMode != 'Delete' AND a.entityId = ANY(", 0);
+  paramAdd(&sql, &params, textArray(entityIdV, entities), "::text[]");
+  pgAppend(&sql, ")", 0);
+
+  if (tqP->attrs > 0)
+  {
+    pgAppend(&sql, " AND a.id = ANY(", 0);
+    paramAdd(&sql, &params, textArray(tqP->attrV, tqP->attrs), "::text[]");
+    pgAppend(&sql, ")", 0);
+  }
+
+  timeConditionAppend(&sql, tqP, "a");
+  pgAppend(&sql, ") AS instances", 0);
+
+  if (tqP->lastN > 0)
+  {
+    snprintf(buf, sizeof(buf), " WHERE troeRowNo <= %d", tqP->lastN);
+    pgAppend(&sql, buf, 0);
+  }
+
+  snprintf(buf, sizeof(buf), " ORDER BY entityId, id, datasetId, %s, ts", tqP->timeColumn);
+  pgAppend(&sql, buf, 0);
+
+  PGresult* res = queryExec(connectionP, sql.buf, &params, PGRES_COMMAND_OK);
+  if (res == NULL)
+    return false;
+
+  PQclear(res);
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalQuery -
+//
+// 1. Select the entities of the page (with timerel and attrs pushed down as an EXISTS on the attributes table)
+// 2. Declare a server-side cursor over the attribute instances of those entities (timerel and lastN pushed down)
+// 3. FETCH the instances in chunks, grouping them per entity and attribute, adding the sub-attributes of each chunk
+//
+// All in a single (read-only) transaction - a cursor lives only inside its transaction
+//
+KjNode* pgTemporalQuery(TemporalQuery* tqP, int* countP)
+{
+  PgConnection* connectionP = pgConnectionGet(orionldState.tenantP->troeDbName);
+
+  if ((connectionP == NULL) || (connectionP->connectionP == NULL))
+    LM_RE(NULL, ("Database Error (no connection to postgres)"));
+
+  if (pgTransactionBegin(connectionP->connectionP) != true)
+  {
+    pgConnectionRelease(connectionP);
+    LM_RE(NULL, ("Database Error (pgTransactionBegin failed)"));
+  }
+
+  KjNode* entityArrayP = temporalEntities(connectionP->connectionP, tqP, countP);
+  bool    ok           = (entityArrayP != NULL);
+
+  if ((ok == true) && (entityArrayP->value.firstChildP != NULL))
+  {
+    ok = instancesCursorDeclare(connectionP->connectionP, tqP, entityArrayP);
+
+    if (ok == true)
+      ok = instancesFetch(connectionP->connectionP, tqP, entityArrayP);
+  }
+
+  if (ok == true)
+  {
+    if (pgTransactionCommit(connectionP->connectionP) != true)  // Closes the cursor
+      LM_E(("Database Error (pgTransactionCommit failed)"));
+  }
+  else if (pgTransactionRollback(connectionP->connectionP) != true)
+    LM_E(("Database Error (pgTransactionRollback failed)"));
+
+  pgConnectionRelease(connectionP);
+
+  return (ok == true)? entityArrayP : NULL;
+}
@@ -0,0 +1,240 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <strings.h>                                             // bzero
+#include <string>                                                // std::string - for parse8601Time
+
+extern "C"
+{
+#include "kbase/kStringSplit.h"                                  // kStringSplit
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "common/globals.h"                                      // parse8601Time
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
+#include "orionld/payloadCheck/pcheckUri.h"                      // pcheckUri
+#include "orionld/context/orionldContextItemExpand.h"            // orionldContextItemExpand
+#include "orionld/context/orionldAttributeExpand.h"              // orionldAttributeExpand
+#include "orionld/troe/TemporalQuery.h"                          // TemporalQuery
+#include "orionld/troe/temporalQueryFromUriParams.h"             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TEMPORAL_LIST_MAX - max number of items in the id, type and attrs lists
+//
+#define TEMPORAL_LIST_MAX 100
+
+
+
+// -----------------------------------------------------------------------------
+//
+// badInput -
+//
+static bool badInput(const char* title, const char* detail)
+{
+  LM_W(("Bad Input (%s: %s)", title, detail));
+  orionldErrorResponseCreate(OrionldBadRequestData, title, detail);
+  orionldState.httpStatusCode = 400;
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// listSplit - split a comma-separated list into a vector allocated in orionldState.kalloc
+//
+static char** listSplit(char* list, int* itemsP)
+{
+  char* itemV[TEMPORAL_LIST_MAX];
+  int   items = kStringSplit(list, ',', itemV, TEMPORAL_LIST_MAX);
+
+  if (items <= 0)
+  {
+    *itemsP = 0;
+    return NULL;
+  }
+
+  char** vector = (char**) kaAlloc(&orionldState.kalloc, items * sizeof(char*));
+
+  for (int ix = 0; ix < items; ix++)
+    vector[ix] = itemV[ix];
+
+  *itemsP = items;
+  return vector;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeParse - ISO8601 string to seconds since the epoch
+//
+static bool timeParse(const char* paramName, const char* value, double* tP)
+{
+  if ((value == NULL) || (*value == 0))
+    return badInput("Missing URI parameter", paramName);
+
+  *tP = parse8601Time(value);
+
+  if (*tP == -1)
+    return badInput("Invalid ISO8601 DateTime for URI parameter", paramName);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// temporalQueryFromUriParams -
+//
+bool temporalQueryFromUriParams(TemporalQuery* tqP, char* entityId)
+{
+  char* detail;
+
+  bzero(tqP, sizeof(TemporalQuery));
+
+  tqP->lastN          = orionldState.uriParams.lastN;
+  tqP->offset         = orionldState.uriParams.offset;
+  tqP->limit          = orionldState.uriParams.limit;
+  tqP->count          = orionldState.uriParams.count;
+  tqP->temporalValues = orionldState.uriParamOptions.temporalValues;
+  tqP->sysAttrs       = orionldState.uriParamOptions.sysAttrs;
+
+  //
+  // Entity ids - either the one of the URL path or the 'id' URI param
+  //
+  if (entityId != NULL)
+  {
+    if (pcheckUri(entityId, true, &detail) == false)
+      return badInput("Invalid Entity ID", "Not a URL nor a URN");
+
+    tqP->idV    = (char**) kaAlloc(&orionldState.kalloc, sizeof(char*));
+    tqP->idV[0] = entityId;
+    tqP->ids    = 1;
+  }
+  else
+  {
+    char* id   = orionldState.uriParams.id;
+    char* type = orionldState.uriParams.type;
+
+    if ((id != NULL) && (*id != 0))
+    {
+      tqP->idV = listSplit(id, &tqP->ids);
+
+      for (int ix = 0; ix < tqP->ids; ix++)
+      {
+        if (pcheckUri(tqP->idV[ix], true, &detail) == false)
+          return badInput("Invalid Entity ID", "Not a URL nor a URN");
+      }
+    }
+
+    tqP->idPattern = orionldState.uriParams.idPattern;
+
+    if ((type != NULL) && (*type != 0))
+    {
+      tqP->typeV = listSplit(type, &tqP->types);
+
+      for (int ix = 0; ix < tqP->types; ix++)
+        tqP->typeV[ix] = orionldContextItemExpand(orionldState.contextP, tqP->typeV[ix], true, NULL);
+    }
+  }
+
+  if ((orionldState.uriParams.attrs != NULL) && (*orionldState.uriParams.attrs != 0))
+  {
+    tqP->attrV = listSplit(orionldState.uriParams.attrs, &tqP->attrs);
+
+    for (int ix = 0; ix < tqP->attrs; ix++)
+    {
+      if ((strcmp(tqP->attrV[ix], "location")         != 0) &&
+          (strcmp(tqP->attrV[ix], "observationSpace") != 0) &&
+          (strcmp(tqP->attrV[ix], "operationSpace")   != 0))
+      {
+        tqP->attrV[ix] = orionldAttributeExpand(orionldState.contextP, tqP->attrV[ix], true, NULL);
+      }
+    }
+  }
+
+  if ((entityId == NULL) && (tqP->ids == 0) && (tqP->idPattern == NULL) && (tqP->types == 0) && (tqP->attrs == 0))
+    return badInput("Too broad query", "Need at least one of: entity-id, entity-type, attribute-list");
+
+  //
+  // timeproperty - observedAt is the default.
+  // createdAt and modifiedAt are both the 'ts' of the instance (each instance is created once and never modified)
+  //
+  const char* timeproperty = orionldState.uriParams.timeproperty;
+
+  if ((timeproperty == NULL) || (strcmp(timeproperty, "observedAt") == 0))
+    tqP->timeColumn = "observedAt";
+  else if ((strcmp(timeproperty, "modifiedAt") == 0) || (strcmp(timeproperty, "createdAt") == 0))
+    tqP->timeColumn = "ts";
+  else
+    return badInput("Invalid value for URI parameter /timeproperty/", timeproperty);
+
+  //
+  // timerel, timeAt, endTimeAt
+  //
+  const char* timerel = orionldState.uriParams.timerel;
+
+  if (timerel == NULL)
+  {
+    if ((orionldState.uriParams.timeAt != NULL) || (orionldState.uriParams.endTimeAt != NULL))
+      return badInput("Missing URI parameter", "timerel");
+
+    tqP->timerel = TemporalTimeRelNone;
+  }
+  else
+  {
+    if      (strcmp(timerel, "before")  == 0)  tqP->timerel = TemporalTimeRelBefore;
+    else if (strcmp(timerel, "after")   == 0)  tqP->timerel = TemporalTimeRelAfter;
+    else if (strcmp(timerel, "between") == 0)  tqP->timerel = TemporalTimeRelBetween;
+    else
+      return badInput("Invalid value for URI parameter /timerel/", timerel);
+
+    if (timeParse("timeAt", orionldState.uriParams.timeAt, &tqP->timeAt) == false)
+      return false;
+
+    if (tqP->timerel == TemporalTimeRelBetween)
+    {
+      if (timeParse("endTimeAt", orionldState.uriParams.endTimeAt, &tqP->endTimeAt) == false)
+        return false;
+
+      if (tqP->endTimeAt <= tqP->timeAt)
+        return badInput("Invalid time interval", "endTimeAt must be after timeAt");
+    }
+    else if (orionldState.uriParams.endTimeAt != NULL)
+      return badInput("URI parameter /endTimeAt/ is only valid with timerel=between", orionldState.uriParams.endTimeAt);
+  }
+
+  return true;
+}
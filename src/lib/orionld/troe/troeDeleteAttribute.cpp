@@ -114,7 +114,7 @@ bool troeDeleteAttribute(void)
 
   if (attributesBuffer.values > 0)
   {
-    char* sqlV[1] = { attributesBuffer.buf };
+    PgAppendBuffer* sqlV[1] = { &attributesBuffer };
 
     pgCommands(sqlV, 1);
   }
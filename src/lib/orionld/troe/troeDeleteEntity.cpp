@@ -56,7 +56,7 @@ bool troeDeleteEntity(void)
 
   if (entitiesBuffer.values > 0)
   {
-    char* sqlV[1]  = { entitiesBuffer.buf };
+    PgAppendBuffer* sqlV[1]  = { &entitiesBuffer };
 
     pgCommands(sqlV, 1);
   }
@@ -27,6 +27,7 @@
 
 #include "orionld/common/orionldState.h"                       // dbName
 #include "orionld/troe/pgInit.h"                               // pgInit
+#include "orionld/troe/troeWriterInit.h"                       // troeWriterInit
 #include "orionld/troe/troeInit.h"                             // Own interface
 
 
@@ -40,5 +41,8 @@ bool troeInit(void)
   if (pgInit(dbName) == false)
     LM_RE(false, ("Basic Postgres Problem - Temporal Representation of Entities is not possible"));
 
+  if ((troeWriters > 0) && (troeWriterInit(troeWriters) == false))
+    LM_RE(false, ("Unable to start the TRoE writer threads"));
+
   return true;
 }
@@ -80,11 +80,11 @@ bool troePatchAttribute(void)
 
   pgAttributeBuild(&attributes, "Update", entityId, orionldState.requestTree, &subAttributes);
 
-  char* sqlV[2];
-  int   sqlIx = 0;
+  PgAppendBuffer* sqlV[2];
+  int             sqlIx = 0;
 
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
+  if (attributes.values    > 0) sqlV[sqlIx++] = &attributes;
+  if (subAttributes.values > 0) sqlV[sqlIx++] = &subAttributes;
 
   if (sqlIx > 0)
     pgCommands(sqlV, sqlIx);
@@ -68,12 +68,12 @@ bool troePostBatchCreate(void)
     pgEntityBuild(&entities, "Create", entityP, NULL, NULL, &attributes, &subAttributes);
   }
 
-  char* sqlV[3];
-  int   sqlIx = 0;
+  PgAppendBuffer* sqlV[3];
+  int             sqlIx = 0;
 
-  if (entities.values      > 0) sqlV[sqlIx++] = entities.buf;
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
+  if (entities.values      > 0) sqlV[sqlIx++] = &entities;
+  if (attributes.values    > 0) sqlV[sqlIx++] = &attributes;
+  if (subAttributes.values > 0) sqlV[sqlIx++] = &subAttributes;
 
   if (sqlIx > 0)
     pgCommands(sqlV, sqlIx);
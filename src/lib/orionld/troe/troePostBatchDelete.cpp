@@ -60,7 +60,7 @@ bool troePostBatchDelete(void)
 
   if (entitiesBuffer.values > 0)
   {
-    char* sqlV[1]  = { entitiesBuffer.buf };
+    PgAppendBuffer* sqlV[1]  = { &entitiesBuffer };
     pgCommands(sqlV, 1);
   }
 
@@ -84,11 +84,11 @@ bool troePostEntity(void)
 
   pgAttributesBuild(&attributesBuffer, orionldState.requestTree, entityId, opMode, &subAttributesBuffer);
 
-  char* sqlV[2];
-  int   sqlIx = 0;
+  PgAppendBuffer* sqlV[2];
+  int             sqlIx = 0;
 
-  if (attributesBuffer.values    > 0) sqlV[sqlIx++] = attributesBuffer.buf;
-  if (subAttributesBuffer.values > 0) sqlV[sqlIx++] = subAttributesBuffer.buf;
+  if (attributesBuffer.values    > 0) sqlV[sqlIx++] = &attributesBuffer;
+  if (subAttributesBuffer.values > 0) sqlV[sqlIx++] = &subAttributesBuffer;
 
   if (sqlIx > 0)
     pgCommands(sqlV, sqlIx);
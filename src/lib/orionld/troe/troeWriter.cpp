@@ -0,0 +1,277 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+#include <string.h>                                              // strlen
+#include <time.h>                                                // clock_gettime, timespec
+#include <pthread.h>                                             // pthread_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // troeBatchSize, troeBatchDelay, troeCopy
+#include "orionld/troe/PgConnection.h"                           // PgConnection
+#include "orionld/troe/pgConnectionGet.h"                        // pgConnectionGet
+#include "orionld/troe/pgConnectionRelease.h"                    // pgConnectionRelease
+#include "orionld/troe/pgTransactionBegin.h"                     // pgTransactionBegin
+#include "orionld/troe/pgTransactionRollback.h"                  // pgTransactionRollback
+#include "orionld/troe/pgTransactionCommit.h"                    // pgTransactionCommit
+#include "orionld/troe/pgCopyExec.h"                             // pgCopyExec
+#include "orionld/troe/troeWriter.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Writer state
+//
+pthread_mutex_t    troeWriterMutex    = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t     troeWriterWorkCond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t     troeWriterRoomCond = PTHREAD_COND_INITIALIZER;
+TroeBatch*         troeBatchList      = NULL;
+TroeWriterMetrics  troeWriterMetrics;
+bool               troeWriterStop     = false;
+pthread_t*         troeWriterThreadV  = NULL;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterNow -
+//
+double troeWriterNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchReady - returns true if the batch is to be flushed now
+//
+static bool batchReady(TroeBatch* batchP, double now)
+{
+  if (troeWriterStop == true)
+    return true;
+
+  if (batchP->bytes >= troeBatchSize * 1024)
+    return true;
+
+  if (now - batchP->firstAt >= ((double) troeBatchDelay) / 1000)
+    return true;
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchExec -
+//
+// With -troeCopy, the buffer is the zero-terminated "INSERT INTO" part followed by binary COPY rows
+//
+static bool batchExec(PGconn* connectionP, TroeSqlBuffer* sqlP, int* statementsP)
+{
+  if (sqlP->len == 0)
+    return true;
+
+  if (troeCopy == true)
+  {
+    int copyStart = strlen(sqlP->buf) + 1;
+
+    if (pgCopyExec(connectionP, sqlP->buf, &sqlP->buf[copyStart], sqlP->len - copyStart) == false)
+      return false;
+
+    *statementsP += 1;
+    return true;
+  }
+
+  PGresult* res = PQexec(connectionP, sqlP->buf);
+
+  if (res == NULL)
+  {
+    LM_E(("Database Error (PQexec: %s)", PQerrorMessage(connectionP)));
+    return false;
+  }
+
+  if (PQresultStatus(res) != PGRES_COMMAND_OK)
+  {
+    LM_E(("Database Error (%s: %s)", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res)));
+    PQclear(res);
+    return false;
+  }
+
+  PQclear(res);
+  *statementsP += 1;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchFlush - write all rows of a batch in a single transaction
+//
+static bool batchFlush(TroeBatch* batchP, int* statementsP)
+{
+  PgConnection* connectionP = pgConnectionGet(batchP->dbName);
+
+  if ((connectionP == NULL) || (connectionP->connectionP == NULL))
+    LM_RE(false, ("Database Error (no connection to postgres for TRoE database '%s')", batchP->dbName));
+
+  if (pgTransactionBegin(connectionP->connectionP) != true)
+  {
+    pgConnectionRelease(connectionP);
+    LM_RE(false, ("Database Error (pgTransactionBegin failed)"));
+  }
+
+  if ((batchExec(connectionP->connectionP, &batchP->entities,      statementsP) == false) ||
+      (batchExec(connectionP->connectionP, &batchP->attributes,    statementsP) == false) ||
+      (batchExec(connectionP->connectionP, &batchP->subAttributes, statementsP) == false))
+  {
+    if (pgTransactionRollback(connectionP->connectionP) == false)
+      LM_E(("Database Error (pgTransactionRollback failed too)"));
+
+    pgConnectionRelease(connectionP);
+    return false;
+  }
+
+  bool ok = pgTransactionCommit(connectionP->connectionP);
+
+  if (ok == false)
+    LM_E(("Database Error (pgTransactionCommit failed)"));
+
+  pgConnectionRelease(connectionP);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchFree -
+//
+static void batchFree(TroeBatch* batchP)
+{
+  free(batchP->entities.buf);
+  free(batchP->attributes.buf);
+  free(batchP->subAttributes.buf);
+  free(batchP->dbName);
+  free(batchP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriter -
+//
+// Takes the first batch that is ready to be flushed out of the list and writes it to postgres.
+// While the batch is being written, new rows for the same database start a new batch.
+// When stopping, all pending batches are flushed before the thread exits.
+//
+void* troeWriter(void* vP)
+{
+  pthread_mutex_lock(&troeWriterMutex);
+
+  while (true)
+  {
+    double      now      = troeWriterNow();
+    double      deadline = 0;
+    TroeBatch*  prevP    = NULL;
+    TroeBatch*  batchP   = troeBatchList;
+
+    while (batchP != NULL)
+    {
+      if (batchReady(batchP, now) == true)
+        break;
+
+      double batchDeadline = batchP->firstAt + ((double) troeBatchDelay) / 1000;
+      if ((deadline == 0) || (batchDeadline < deadline))
+        deadline = batchDeadline;
+
+      prevP  = batchP;
+      batchP = batchP->next;
+    }
+
+    if (batchP != NULL)
+    {
+      if (prevP == NULL)
+        troeBatchList = batchP->next;
+      else
+        prevP->next = batchP->next;
+
+      pthread_mutex_unlock(&troeWriterMutex);
+
+      int   statements = 0;
+      bool  ok         = batchFlush(batchP, &statements);
+
+      pthread_mutex_lock(&troeWriterMutex);
+
+      troeWriterMetrics.batches     += 1;
+      troeWriterMetrics.statements  += statements;
+      troeWriterMetrics.queuedBytes -= batchP->bytes;
+
+      if (ok == true)
+        troeWriterMetrics.bytes += batchP->bytes;
+      else
+      {
+        troeWriterMetrics.errors += 1;
+        LM_E(("Database Error (TRoE batch of %d requests for database '%s' lost)", batchP->requests, batchP->dbName));
+      }
+
+      pthread_cond_broadcast(&troeWriterRoomCond);
+      batchFree(batchP);
+      continue;
+    }
+
+    if (troeWriterStop == true)  // and nothing left to flush
+      break;
+
+    if (troeBatchList == NULL)
+      pthread_cond_wait(&troeWriterWorkCond, &troeWriterMutex);
+    else
+    {
+      struct timespec ts;
+
+      ts.tv_sec  = (time_t) deadline;
+      ts.tv_nsec = (long) ((deadline - ts.tv_sec) * 1000000000);
+
+      pthread_cond_timedwait(&troeWriterWorkCond, &troeWriterMutex, &ts);
+    }
+  }
+
+  pthread_mutex_unlock(&troeWriterMutex);
+
+  return NULL;
+}
@@ -0,0 +1,124 @@
+#ifndef SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
+#define SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <pthread.h>                                             // pthread_t, pthread_mutex_t, pthread_cond_t
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TRoE Writers
+//
+//   With writer threads (CLI option -troeWriters), the TRoE routines don't execute their SQL commands on
+//   the request thread. pgCommands hands the INSERTs over to troeWriterEnqueue, that merges the rows into
+//   a batch per tenant database (one multi-row INSERT per table).
+//   A batch is flushed by one of the writer threads - in a single transaction - when it reaches
+//   -troeBatchSize kilobytes or when its first row has waited -troeBatchDelay milliseconds.
+//
+//   If more than -troeQueueSize kilobytes are waiting to be written, request threads wait (backpressure).
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeSqlBuffer - a multi-row INSERT, growing with the rows
+//
+typedef struct TroeSqlBuffer
+{
+  char*  buf;
+  int    size;
+  int    len;
+} TroeSqlBuffer;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeBatch - the rows waiting to be written to a tenant database
+//
+typedef struct TroeBatch
+{
+  char*              dbName;
+  TroeSqlBuffer      entities;
+  TroeSqlBuffer      attributes;
+  TroeSqlBuffer      subAttributes;
+  int                bytes;          // Size of the rows in the batch
+  int                requests;       // Number of requests whose rows are in the batch
+  double             firstAt;        // When the first row was added
+  struct TroeBatch*  next;
+} TroeBatch;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeWriterMetrics -
+//
+typedef struct TroeWriterMetrics
+{
+  unsigned long long  requests;        // Requests handed over to the writers
+  unsigned long long  batches;         // Batches flushed
+  unsigned long long  statements;      // INSERT statements executed
+  unsigned long long  bytes;           // Bytes of rows flushed
+  unsigned long long  errors;          // Batches that failed (their rows are lost)
+  unsigned long long  waits;           // Times a request thread had to wait for room in the queue
+  long long           queuedBytes;     // Bytes of rows waiting to be written (or being written) right now
+  long long           maxQueuedBytes;  // Max of queuedBytes
+} TroeWriterMetrics;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Writer state - all protected by troeWriterMutex
+//
+extern pthread_mutex_t    troeWriterMutex;
+extern pthread_cond_t     troeWriterWorkCond;   // Signaled when there's a batch to flush
+extern pthread_cond_t     troeWriterRoomCond;   // Signaled when bytes have been flushed
+extern TroeBatch*         troeBatchList;
+extern TroeWriterMetrics  troeWriterMetrics;
+extern bool               troeWriterStop;
+extern pthread_t*         troeWriterThreadV;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterNow -
+//
+extern double troeWriterNow(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriter - the writer thread
+//
+extern void* troeWriter(void* vP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
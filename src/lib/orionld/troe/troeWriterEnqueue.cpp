@@ -0,0 +1,200 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, realloc, calloc
+#include <string.h>                                              // strncmp, strcmp, strlen, strdup, memcpy
+#include <pthread.h>                                             // pthread_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/orionldState.h"                         // troeQueueSize, troeBatchSize
+#include "orionld/troe/PgAppendBuffer.h"                         // PgAppendBuffer
+#include "orionld/troe/PgTableDefinitions.h"                     // PG_ENTITY_INSERT_START, PG_ATTRIBUTE_INSERT_START, ...
+#include "orionld/troe/troeWriter.h"                             // TroeBatch, troeBatchList, troeWriterMutex, ...
+#include "orionld/troe/troeWriterEnqueue.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sqlAppend - append the rows of an INSERT to the multi-row INSERT of the batch
+//
+// The first rows of the batch come with the "INSERT INTO table(...) VALUES " part.
+// For the rest of them, only their rows are appended, comma-separated.
+//
+// Binary COPY rows (-troeCopy) are appended as is, after the zero-terminated "INSERT INTO" part (see pgCopy.h)
+//
+static int sqlAppend(TroeSqlBuffer* sqlP, const char* start, int startLen, const char* rows, int rowsLen, bool copy)
+{
+  int separatorLen = (copy == true)? 0 : 1;
+  int needed       = sqlP->len + ((sqlP->len == 0)? startLen + 1 : separatorLen) + rowsLen + 1;
+
+  if (needed > sqlP->size)
+  {
+    int newSize = (sqlP->size == 0)? 4 * 1024 : sqlP->size;
+
+    while (newSize < needed)
+      newSize *= 2;
+
+    char* newBuf = (char*) realloc(sqlP->buf, newSize);
+    if (newBuf == NULL)
+      LM_RE(0, ("Out of memory (unable to allocate %d bytes for a TRoE batch)", newSize));
+
+    sqlP->buf  = newBuf;
+    sqlP->size = newSize;
+  }
+
+  if (sqlP->len == 0)
+  {
+    memcpy(sqlP->buf, start, startLen);
+    sqlP->len = startLen;
+
+    if (copy == true)
+      sqlP->buf[sqlP->len++] = 0;
+  }
+  else if (copy == false)
+    sqlP->buf[sqlP->len++] = ',';
+
+  memcpy(&sqlP->buf[sqlP->len], rows, rowsLen);
+  sqlP->len += rowsLen;
+  sqlP->buf[sqlP->len] = 0;
+
+  return rowsLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchLookup - find the batch of a database, or create it
+//
+static TroeBatch* batchLookup(const char* dbName)
+{
+  TroeBatch* lastP = NULL;
+
+  for (TroeBatch* batchP = troeBatchList; batchP != NULL; batchP = batchP->next)
+  {
+    if (strcmp(batchP->dbName, dbName) == 0)
+      return batchP;
+
+    lastP = batchP;
+  }
+
+  TroeBatch* batchP = (TroeBatch*) calloc(1, sizeof(TroeBatch));
+
+  if (batchP == NULL)
+    LM_RE(NULL, ("Out of memory (unable to allocate a TRoE batch)"));
+
+  batchP->dbName  = strdup(dbName);
+  batchP->firstAt = troeWriterNow();
+
+  // Appended to the end of the list, so, the oldest batches are flushed first
+  if (lastP == NULL)
+    troeBatchList = batchP;
+  else
+    lastP->next = batchP;
+
+  return batchP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterEnqueue -
+//
+// The buffers are the ones that pgCommands would have executed - INSERTs (or binary COPY rows) for the entities,
+// attributes and subAttributes tables.
+//
+void troeWriterEnqueue(const char* dbName, PgAppendBuffer* bufferV[], int buffers)
+{
+  static const int entityStartLen       = sizeof(PG_ENTITY_INSERT_START) - 1;
+  static const int attributeStartLen    = sizeof(PG_ATTRIBUTE_INSERT_START) - 1;
+  static const int subAttributeStartLen = sizeof(PG_SUB_ATTRIBUTE_INSERT_START) - 1;
+
+  if (dbName == NULL)
+    dbName = "";
+
+  pthread_mutex_lock(&troeWriterMutex);
+
+  // Backpressure - wait until the writers have made room
+  while ((troeWriterMetrics.queuedBytes >= (long long) troeQueueSize * 1024) && (troeWriterStop == false))
+  {
+    troeWriterMetrics.waits += 1;
+    pthread_cond_wait(&troeWriterRoomCond, &troeWriterMutex);
+  }
+
+  TroeBatch* batchP = batchLookup(dbName);
+
+  if (batchP == NULL)
+  {
+    pthread_mutex_unlock(&troeWriterMutex);
+    return;
+  }
+
+  bool newBatch = (batchP->requests == 0);
+  int  bytes    = 0;
+
+  for (int ix = 0; ix < buffers; ix++)
+  {
+    PgAppendBuffer*  bufP    = bufferV[ix];
+    const char*      sql     = bufP->buf;
+    bool             copy    = bufP->copy;
+    int              rowsLen;
+
+    if (strncmp(sql, PG_ENTITY_INSERT_START, entityStartLen) == 0)
+    {
+      rowsLen = (copy == true)? bufP->currentIx - bufP->copyStart : bufP->currentIx - entityStartLen;
+      bytes  += sqlAppend(&batchP->entities, PG_ENTITY_INSERT_START, entityStartLen, (copy == true)? &sql[bufP->copyStart] : &sql[entityStartLen], rowsLen, copy);
+    }
+    else if (strncmp(sql, PG_ATTRIBUTE_INSERT_START, attributeStartLen) == 0)
+    {
+      rowsLen = (copy == true)? bufP->currentIx - bufP->copyStart : bufP->currentIx - attributeStartLen;
+      bytes  += sqlAppend(&batchP->attributes, PG_ATTRIBUTE_INSERT_START, attributeStartLen, (copy == true)? &sql[bufP->copyStart] : &sql[attributeStartLen], rowsLen, copy);
+    }
+    else if (strncmp(sql, PG_SUB_ATTRIBUTE_INSERT_START, subAttributeStartLen) == 0)
+    {
+      rowsLen = (copy == true)? bufP->currentIx - bufP->copyStart : bufP->currentIx - subAttributeStartLen;
+      bytes  += sqlAppend(&batchP->subAttributes, PG_SUB_ATTRIBUTE_INSERT_START, subAttributeStartLen, (copy == true)? &sql[bufP->copyStart] : &sql[subAttributeStartLen], rowsLen, copy);
+    }
+    else
+      LM_E(("Internal Error (not a TRoE INSERT command: '%s')", sql));
+  }
+
+  batchP->bytes    += bytes;
+  batchP->requests += 1;
+
+  troeWriterMetrics.requests    += 1;
+  troeWriterMetrics.queuedBytes += bytes;
+
+  if (troeWriterMetrics.queuedBytes > troeWriterMetrics.maxQueuedBytes)
+    troeWriterMetrics.maxQueuedBytes = troeWriterMetrics.queuedBytes;
+
+  // A writer must know about a new batch (for its delay) and about a full batch
+  if ((newBatch == true) || (batchP->bytes >= troeBatchSize * 1024))
+    pthread_cond_signal(&troeWriterWorkCond);
+
+  pthread_mutex_unlock(&troeWriterMutex);
+}
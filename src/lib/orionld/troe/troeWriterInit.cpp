@@ -0,0 +1,56 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strerror, bzero
+#include <stdlib.h>                                              // calloc
+#include <pthread.h>                                             // pthread_create
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/troe/troeWriter.h"                             // troeWriter, troeWriterThreadV, ...
+#include "orionld/troe/troeWriterInit.h"                         // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterInit -
+//
+bool troeWriterInit(int writers)
+{
+  bzero(&troeWriterMetrics, sizeof(troeWriterMetrics));
+
+  troeWriterThreadV = (pthread_t*) calloc(writers, sizeof(pthread_t));
+  if (troeWriterThreadV == NULL)
+    LM_RE(false, ("Out of memory (unable to allocate room for %d TRoE writer threads)", writers));
+
+  for (int ix = 0; ix < writers; ix++)
+  {
+    if (pthread_create(&troeWriterThreadV[ix], NULL, troeWriter, NULL) != 0)
+      LM_RE(false, ("Internal Error (unable to start TRoE writer thread %d: %s)", ix, strerror(errno)));
+  }
+
+  return true;
+}
@@ -0,0 +1,58 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+#include <pthread.h>                                             // pthread_join
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/troe/troeWriter.h"                             // troeWriterStop, troeWriterThreadV, ...
+#include "orionld/troe/troeWriterRelease.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterRelease -
+//
+void troeWriterRelease(int writers)
+{
+  if (troeWriterThreadV == NULL)
+    return;
+
+  pthread_mutex_lock(&troeWriterMutex);
+  troeWriterStop = true;
+  pthread_cond_broadcast(&troeWriterWorkCond);
+  pthread_cond_broadcast(&troeWriterRoomCond);
+  pthread_mutex_unlock(&troeWriterMutex);
+
+  for (int ix = 0; ix < writers; ix++)
+  {
+    pthread_join(troeWriterThreadV[ix], NULL);
+  }
+
+  free(troeWriterThreadV);
+  troeWriterThreadV = NULL;
+}
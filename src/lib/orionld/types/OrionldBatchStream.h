@@ -0,0 +1,84 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_ORIONLDBATCHSTREAM_H_
+#define SRC_LIB_ORIONLD_TYPES_ORIONLDBATCHSTREAM_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                     // KAlloc
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// BATCH_GROUP_KALLOC_SIZE - size of the buffers of the allocation buffer of the group being read
+//
+#define BATCH_GROUP_KALLOC_SIZE  (64 * 1024)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldBatchStream - state of a batch operation that is served in groups of entities (CLI option -batchGroupSize)
+//
+// The payload of BATCH Create/Upsert/Update is parsed while it is read, one entity at a time, see orionldBatchStreamFeed.
+// As soon as -batchGroupSize entities have been read, they are served (orionldBatchGroupServe) and released, while the rest
+// of the payload is still arriving.
+// The payload is never kept in one piece - only the entity that is being read right now is buffered ('buf'), and only the
+// entities of the group being read are kept ('arrayP', in the allocation buffer 'kalloc').
+//
+// The per-entity results of all groups are gathered in 'successP' and 'errorsP' - the response of the request.
+// Those are also used when the payload is served in groups after having been read in its entirety (request workers).
+//
+typedef struct OrionldBatchStream
+{
+  bool     active;        // The payload of this request is parsed while being read
+  bool     prepared;      // The request has been checked (orionldMhdConnectionPrepare), on the first chunk of payload
+  KjNode*  arrayP;        // The entities of the group being read
+  int      entities;      // Number of entities in arrayP
+  int      total;         // Number of entities read so far
+  KAlloc   kalloc;        // Allocation buffer for the entities of the group being read - reset after serving the group
+  char*    kallocBuffer;  // The initial buffer of 'kalloc' - malloc'd, freed by orionldBatchStreamRelease
+  char*    buf;           // The entity currently being read (the unparsed tail of the payload) - malloc'd, freed by orionldBatchStreamRelease
+  int      bufSize;       // Size of 'buf'
+  int      bufLen;        // Number of bytes in 'buf'
+  int      scanIx;        // Index in 'buf' where the scan continues
+  int      depth;         // JSON nesting level - 0: outside the toplevel array, 1: between entities, 2 and up: inside an entity
+  bool     inString;      // Inside a JSON string
+  bool     escaped;       // The previous char was a backslash inside a JSON string
+  bool     started;       // The opening '[' of the toplevel array has been read
+  bool     ended;         // The closing ']' of the toplevel array has been read
+  bool     afterEntity;   // An entity has just been read - a comma or the closing ']' must follow
+  char*    error;         // Parse error, if any
+  int      groups;        // Number of groups served so far
+  KjNode*  successP;      // The "success" array of the response - the entities of all groups served so far
+  KjNode*  errorsP;       // The "errors" array of the response
+  bool     notCreated;    // Some group didn't respond 201 - the response can't be 201
+  bool     notUpdated;    // Some group didn't respond 204 - the response can't be 204
+} OrionldBatchStream;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_ORIONLDBATCHSTREAM_H_
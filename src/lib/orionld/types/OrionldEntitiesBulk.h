@@ -0,0 +1,70 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_ORIONLDENTITIESBULK_H_
+#define SRC_LIB_ORIONLD_TYPES_ORIONLDENTITIESBULK_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <mongoc/mongoc.h>                                     // bson_t
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldBulkOp - one entity write of a BATCH operation, waiting for the bulk write
+//
+// mongoBackend (createEntity, updateEntity) appends one of these per entity instead of writing the entity right away,
+// when orionldState.entitiesBulkP is set. mongocEntitiesBulkWrite sends them all to the database in one single
+// unordered bulk write and sets 'error' for those writes that failed.
+//
+typedef struct OrionldBulkOp
+{
+  char*                  entityId;   // To map a write error back to its entity
+  bson_t*                selectorP;  // The filter of an update - NULL for an insert
+  bson_t*                docP;       // The entity to insert, or the update ($set, $unset, $addToSet, ...)
+  char*                  error;      // Error message if the write failed, set by mongocEntitiesBulkWrite
+  KjNode*                catalogP;   // Entity catalog delta of the write - added to orionldState.catalogDeltaP if the write succeeds
+  void*                  notifyP;    // Notifications of the write (mongoBackend) - sent only if the write succeeds
+  struct OrionldBulkOp*  next;
+} OrionldBulkOp;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldEntitiesBulk - the entity writes of a BATCH operation (or of one group of entities, see -batchGroupSize)
+//
+typedef struct OrionldEntitiesBulk
+{
+  OrionldBulkOp*  first;
+  OrionldBulkOp*  last;
+  int             ops;
+  int             errors;    // Number of failed writes, set by mongocEntitiesBulkWrite
+} OrionldEntitiesBulk;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_ORIONLDENTITIESBULK_H_
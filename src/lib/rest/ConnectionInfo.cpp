@@ -72,7 +72,13 @@ ConnectionInfo::ConnectionInfo():
   transactionStart       { 0, 0 },
   inCompoundValue        (false),
   compoundValueP         (NULL),
-  compoundValueRoot      (NULL)
+  compoundValueRoot      (NULL),
+  connection             (NULL),
+  url                    (NULL),
+  method                 (NULL),
+  version                (NULL),
+  payloadInArena         (false),
+  workerNextP            (NULL)
 {
 }
 
@@ -89,7 +95,13 @@ ConnectionInfo::ConnectionInfo(MHD_Connection* _connection):
   transactionStart       { 0, 0 },
   inCompoundValue        (false),
   compoundValueP         (NULL),
-  compoundValueRoot      (NULL)
+  compoundValueRoot      (NULL),
+  connection             (_connection),
+  url                    (NULL),
+  method                 (NULL),
+  version                (NULL),
+  payloadInArena         (false),
+  workerNextP            (NULL)
 {
   orionldState.mhdConnection = _connection;
 
@@ -98,6 +98,14 @@ public:
   // Timing
   struct timespec           reqStartTime;
 
+  // Request workers (-httpWorkers) - the request is read by an event loop and served by a request worker
+  MHD_Connection*           connection;
+  const char*               url;
+  const char*               method;
+  const char*               version;
+  bool                      payloadInArena;  // The payload is an arena buffer (orionldArenaAlloc) - not to be freed
+  ConnectionInfo*           workerNextP;   // Next in the queue of the request workers
+
 #ifdef ORIONLD
 #endif  
 };
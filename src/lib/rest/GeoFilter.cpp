@@ -0,0 +1,1017 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <math.h>                                          // cos, sin, asin, sqrt, fabs
+#include <string>
+#include <vector>
+
+#include "mongo/client/dbclient.h"
+
+#include "logMsg/logMsg.h"
+
+#include "common/globals.h"                                // V2, EARTH_RADIUS_METERS
+#include "ngsi/Scope.h"                                    // Scope
+#include "rest/GeoFilter.h"                                // Own interface
+
+
+
+/* ****************************************************************************
+*
+* GEO_EPSILON - tolerance for collinearity and 'on the boundary' checks, in degrees squared
+*/
+#define GEO_EPSILON  1e-12
+
+
+
+/* ****************************************************************************
+*
+* GEO_PLANAR_MAX_SPAN - max size, in degrees, of a shape with edges for the plane of lon/lat to give the same result as mongo
+*
+* The edges of the shapes of mongo are great-circle arcs. An edge of 0.1 degrees departs from the straight
+* line in lon/lat by a couple of meters at most.
+*/
+#define GEO_PLANAR_MAX_SPAN  0.1
+
+
+
+/* ****************************************************************************
+*
+* positionGet - GeoJSON position [ lon, lat ]
+*/
+static bool positionGet(const mongo::BSONElement& position, GeoFilterPoint* pointP)
+{
+  if (position.type() != mongo::Array)
+    return false;
+
+  std::vector<mongo::BSONElement> coordV = position.Array();
+
+  if ((coordV.size() < 2) || !coordV[0].isNumber() || !coordV[1].isNumber())
+    return false;
+
+  pointP->lon = coordV[0].Number();
+  pointP->lat = coordV[1].Number();
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* ringGet - array of positions (MultiPoint, LineString or linear ring)
+*/
+static bool ringGet(const mongo::BSONElement& positions, GeoFilterRing* ringP)
+{
+  if (positions.type() != mongo::Array)
+    return false;
+
+  std::vector<mongo::BSONElement> positionV = positions.Array();
+
+  for (unsigned int ix = 0; ix < positionV.size(); ++ix)
+  {
+    GeoFilterPoint point;
+
+    if (positionGet(positionV[ix], &point) == false)
+      return false;
+
+    ringP->push_back(point);
+  }
+
+  return ringP->size() > 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* ringsGet - array of arrays of positions (MultiLineString or Polygon)
+*/
+static bool ringsGet(const mongo::BSONElement& rings, std::vector<GeoFilterRing>* ringsP)
+{
+  if (rings.type() != mongo::Array)
+    return false;
+
+  std::vector<mongo::BSONElement> ringV = rings.Array();
+
+  for (unsigned int ix = 0; ix < ringV.size(); ++ix)
+  {
+    GeoFilterRing ring;
+
+    if (ringGet(ringV[ix], &ring) == false)
+      return false;
+
+    ringsP->push_back(ring);
+  }
+
+  return ringsP->size() > 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterShape::fill - from the GeoJSON geometry of an entity location
+*
+* Returns false for anything that isn't a valid Point, MultiPoint, LineString, MultiLineString,
+* Polygon or MultiPolygon.
+*/
+bool GeoFilterShape::fill(const mongo::BSONObj* geoJsonP)
+{
+  mongo::BSONElement  typeElement   = geoJsonP->getField("type");
+  mongo::BSONElement  coordinates   = geoJsonP->getField("coordinates");
+  bool                ok            = false;
+
+  pointV.clear();
+  lineV.clear();
+  polygonV.clear();
+
+  if (typeElement.type() != mongo::String)
+    return false;
+
+  type = typeElement.String();
+
+  if (type == "Point")
+  {
+    GeoFilterPoint point;
+
+    if ((ok = positionGet(coordinates, &point)) == true)
+      pointV.push_back(point);
+  }
+  else if (type == "MultiPoint")
+    ok = ringGet(coordinates, &pointV);
+  else if (type == "LineString")
+  {
+    GeoFilterRing line;
+
+    if ((ok = ringGet(coordinates, &line)) == true)
+      lineV.push_back(line);
+  }
+  else if (type == "MultiLineString")
+    ok = ringsGet(coordinates, &lineV);
+  else if (type == "Polygon")
+  {
+    std::vector<GeoFilterRing> polygon;
+
+    if ((ok = ringsGet(coordinates, &polygon)) == true)
+      polygonV.push_back(polygon);
+  }
+  else if ((type == "MultiPolygon") && (coordinates.type() == mongo::Array))
+  {
+    std::vector<mongo::BSONElement> polygonElementV = coordinates.Array();
+
+    ok = (polygonElementV.size() > 0);
+    for (unsigned int ix = 0; (ok == true) && (ix < polygonElementV.size()); ++ix)
+    {
+      std::vector<GeoFilterRing> polygon;
+
+      if ((ok = ringsGet(polygonElementV[ix], &polygon)) == true)
+        polygonV.push_back(polygon);
+    }
+  }
+
+  if (ok == false)
+    return false;
+
+  bboxCompute();
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* bboxExtend -
+*/
+static void bboxExtend(GeoFilterBox* bboxP, const GeoFilterRing& ring)
+{
+  for (unsigned int ix = 0; ix < ring.size(); ++ix)
+  {
+    if (ring[ix].lon < bboxP->minLon)  bboxP->minLon = ring[ix].lon;
+    if (ring[ix].lon > bboxP->maxLon)  bboxP->maxLon = ring[ix].lon;
+    if (ring[ix].lat < bboxP->minLat)  bboxP->minLat = ring[ix].lat;
+    if (ring[ix].lat > bboxP->maxLat)  bboxP->maxLat = ring[ix].lat;
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterShape::bboxCompute -
+*
+* The holes of the polygons are inside the outer rings, so they don't need to be looked at
+*/
+void GeoFilterShape::bboxCompute(void)
+{
+  bbox.minLon = HUGE_VAL;
+  bbox.minLat = HUGE_VAL;
+  bbox.maxLon = -HUGE_VAL;
+  bbox.maxLat = -HUGE_VAL;
+
+  bboxExtend(&bbox, pointV);
+
+  for (unsigned int ix = 0; ix < lineV.size(); ++ix)
+  {
+    bboxExtend(&bbox, lineV[ix]);
+  }
+
+  for (unsigned int ix = 0; ix < polygonV.size(); ++ix)
+  {
+    bboxExtend(&bbox, polygonV[ix][0]);
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterShape::planar - are the plane of lon/lat and the sphere (mongo's 2dsphere) the same for this shape?
+*
+* Points are the same anywhere. Lines and polygons only if they're small - which also rules out shapes that cross
+* the antimeridian, as their longitudes span almost 360 degrees.
+*/
+bool GeoFilterShape::planar(void) const
+{
+  if ((lineV.size() == 0) && (polygonV.size() == 0))
+    return true;
+
+  return ((bbox.maxLon - bbox.minLon <= GEO_PLANAR_MAX_SPAN) && (bbox.maxLat - bbox.minLat <= GEO_PLANAR_MAX_SPAN));
+}
+
+
+
+/* ****************************************************************************
+*
+* orientation - twice the signed area of the triangle a-b-c (positive if counter-clockwise)
+*/
+static inline double orientation(const GeoFilterPoint& a, const GeoFilterPoint& b, const GeoFilterPoint& c)
+{
+  return (b.lon - a.lon) * (c.lat - a.lat) - (b.lat - a.lat) * (c.lon - a.lon);
+}
+
+
+
+/* ****************************************************************************
+*
+* onSegment - is the point p on the segment a-b?
+*/
+static bool onSegment(const GeoFilterPoint& p, const GeoFilterPoint& a, const GeoFilterPoint& b)
+{
+  if (fabs(orientation(a, b, p)) > GEO_EPSILON)
+    return false;
+
+  return (p.lon >= fmin(a.lon, b.lon) - GEO_EPSILON) && (p.lon <= fmax(a.lon, b.lon) + GEO_EPSILON) &&
+         (p.lat >= fmin(a.lat, b.lat) - GEO_EPSILON) && (p.lat <= fmax(a.lat, b.lat) + GEO_EPSILON);
+}
+
+
+
+/* ****************************************************************************
+*
+* segmentsCross - do the segments a-b and c-d cross each other (touching not included)?
+*/
+static bool segmentsCross(const GeoFilterPoint& a, const GeoFilterPoint& b, const GeoFilterPoint& c, const GeoFilterPoint& d)
+{
+  double o1 = orientation(c, d, a);
+  double o2 = orientation(c, d, b);
+  double o3 = orientation(a, b, c);
+  double o4 = orientation(a, b, d);
+
+  return (((o1 > GEO_EPSILON) && (o2 < -GEO_EPSILON)) || ((o1 < -GEO_EPSILON) && (o2 > GEO_EPSILON))) &&
+         (((o3 > GEO_EPSILON) && (o4 < -GEO_EPSILON)) || ((o3 < -GEO_EPSILON) && (o4 > GEO_EPSILON)));
+}
+
+
+
+/* ****************************************************************************
+*
+* segmentsIntersect - do the segments a-b and c-d have any point in common?
+*/
+static bool segmentsIntersect(const GeoFilterPoint& a, const GeoFilterPoint& b, const GeoFilterPoint& c, const GeoFilterPoint& d)
+{
+  if (segmentsCross(a, b, c, d))
+    return true;
+
+  return onSegment(a, c, d) || onSegment(b, c, d) || onSegment(c, a, b) || onSegment(d, a, b);
+}
+
+
+
+/* ****************************************************************************
+*
+* onRing - is the point p on the ring (or line)?
+*/
+static bool onRing(const GeoFilterPoint& p, const GeoFilterRing& ring)
+{
+  if (ring.size() == 1)
+    return (p.lon == ring[0].lon) && (p.lat == ring[0].lat);
+
+  for (unsigned int ix = 0; ix + 1 < ring.size(); ++ix)
+  {
+    if (onSegment(p, ring[ix], ring[ix + 1]))
+      return true;
+  }
+
+  return false;
+}
+
+
+
+/* ****************************************************************************
+*
+* insideRing - is the point p strictly inside the ring? (ray casting)
+*/
+static bool insideRing(const GeoFilterPoint& p, const GeoFilterRing& ring)
+{
+  bool         inside = false;
+  unsigned int n      = ring.size();
+
+  for (unsigned int ix = 0, jx = n - 1; ix < n; jx = ix++)
+  {
+    const GeoFilterPoint& a = ring[ix];
+    const GeoFilterPoint& b = ring[jx];
+
+    if (((a.lat > p.lat) != (b.lat > p.lat)) && (p.lon < (b.lon - a.lon) * (p.lat - a.lat) / (b.lat - a.lat) + a.lon))
+      inside = !inside;
+  }
+
+  return inside;
+}
+
+
+
+/* ****************************************************************************
+*
+* insidePolygon - is the point p inside the polygon (boundary included)?
+*/
+static bool insidePolygon(const GeoFilterPoint& p, const std::vector<GeoFilterRing>& polygon)
+{
+  if (onRing(p, polygon[0]))
+    return true;
+
+  if (insideRing(p, polygon[0]) == false)
+    return false;
+
+  for (unsigned int ix = 1; ix < polygon.size(); ++ix)
+  {
+    if (onRing(p, polygon[ix]))
+      return true;
+
+    if (insideRing(p, polygon[ix]))
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* pointInShape - has the point p anything in common with the shape?
+*/
+static bool pointInShape(const GeoFilterPoint& p, const GeoFilterShape* shapeP)
+{
+  if ((p.lon < shapeP->bbox.minLon - GEO_EPSILON) || (p.lon > shapeP->bbox.maxLon + GEO_EPSILON) ||
+      (p.lat < shapeP->bbox.minLat - GEO_EPSILON) || (p.lat > shapeP->bbox.maxLat + GEO_EPSILON))
+    return false;
+
+  for (unsigned int ix = 0; ix < shapeP->pointV.size(); ++ix)
+  {
+    if ((p.lon == shapeP->pointV[ix].lon) && (p.lat == shapeP->pointV[ix].lat))
+      return true;
+  }
+
+  for (unsigned int ix = 0; ix < shapeP->lineV.size(); ++ix)
+  {
+    if (onRing(p, shapeP->lineV[ix]))
+      return true;
+  }
+
+  for (unsigned int ix = 0; ix < shapeP->polygonV.size(); ++ix)
+  {
+    if (insidePolygon(p, shapeP->polygonV[ix]))
+      return true;
+  }
+
+  return false;
+}
+
+
+
+/* ****************************************************************************
+*
+* verticesGet - all the vertices of a shape
+*/
+static void verticesGet(const GeoFilterShape* shapeP, GeoFilterRing* verticesP)
+{
+  verticesP->insert(verticesP->end(), shapeP->pointV.begin(), shapeP->pointV.end());
+
+  for (unsigned int ix = 0; ix < shapeP->lineV.size(); ++ix)
+  {
+    verticesP->insert(verticesP->end(), shapeP->lineV[ix].begin(), shapeP->lineV[ix].end());
+  }
+
+  for (unsigned int ix = 0; ix < shapeP->polygonV.size(); ++ix)
+  {
+    for (unsigned int rIx = 0; rIx < shapeP->polygonV[ix].size(); ++rIx)
+    {
+      verticesP->insert(verticesP->end(), shapeP->polygonV[ix][rIx].begin(), shapeP->polygonV[ix][rIx].end());
+    }
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* segmentsGet - all the segments of a shape, as pairs of consecutive points
+*/
+static void segmentsGet(const GeoFilterShape* shapeP, GeoFilterRing* segmentsP)
+{
+  for (unsigned int ix = 0; ix < shapeP->lineV.size(); ++ix)
+  {
+    const GeoFilterRing& line = shapeP->lineV[ix];
+
+    for (unsigned int pIx = 0; pIx + 1 < line.size(); ++pIx)
+    {
+      segmentsP->push_back(line[pIx]);
+      segmentsP->push_back(line[pIx + 1]);
+    }
+  }
+
+  for (unsigned int ix = 0; ix < shapeP->polygonV.size(); ++ix)
+  {
+    for (unsigned int rIx = 0; rIx < shapeP->polygonV[ix].size(); ++rIx)
+    {
+      const GeoFilterRing& ring = shapeP->polygonV[ix][rIx];
+
+      for (unsigned int pIx = 0; pIx + 1 < ring.size(); ++pIx)
+      {
+        segmentsP->push_back(ring[pIx]);
+        segmentsP->push_back(ring[pIx + 1]);
+      }
+    }
+  }
+}
+
+
+
+/* ****************************************************************************
+*
+* bboxOverlap -
+*/
+static bool bboxOverlap(const GeoFilterBox& a, const GeoFilterBox& b)
+{
+  return (a.minLon <= b.maxLon + GEO_EPSILON) && (b.minLon <= a.maxLon + GEO_EPSILON) &&
+         (a.minLat <= b.maxLat + GEO_EPSILON) && (b.minLat <= a.maxLat + GEO_EPSILON);
+}
+
+
+
+/* ****************************************************************************
+*
+* shapesIntersect - have the two shapes any point in common?
+*
+* Either a vertex of one shape is in the other shape, or an edge of one shape intersects an edge of the other.
+*/
+static bool shapesIntersect(const GeoFilterShape* aP, const GeoFilterShape* bP)
+{
+  GeoFilterRing  verticesA;
+  GeoFilterRing  verticesB;
+
+  if (bboxOverlap(aP->bbox, bP->bbox) == false)
+    return false;
+
+  // The usual case - a point entity
+  if ((aP->lineV.size() == 0) && (aP->polygonV.size() == 0) && (aP->pointV.size() == 1))
+    return pointInShape(aP->pointV[0], bP);
+
+  verticesGet(aP, &verticesA);
+  for (unsigned int ix = 0; ix < verticesA.size(); ++ix)
+  {
+    if (pointInShape(verticesA[ix], bP))
+      return true;
+  }
+
+  verticesGet(bP, &verticesB);
+  for (unsigned int ix = 0; ix < verticesB.size(); ++ix)
+  {
+    if (pointInShape(verticesB[ix], aP))
+      return true;
+  }
+
+  GeoFilterRing  segmentsA;
+  GeoFilterRing  segmentsB;
+
+  segmentsGet(aP, &segmentsA);
+  segmentsGet(bP, &segmentsB);
+
+  for (unsigned int aIx = 0; aIx < segmentsA.size(); aIx += 2)
+  {
+    for (unsigned int bIx = 0; bIx < segmentsB.size(); bIx += 2)
+    {
+      if (segmentsIntersect(segmentsA[aIx], segmentsA[aIx + 1], segmentsB[bIx], segmentsB[bIx + 1]))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+
+
+/* ****************************************************************************
+*
+* shapeCoveredBy - is the shape entirely inside the polygons of the area?
+*
+* All its vertices must be inside the area and none of its edges may cross the border of the area.
+*/
+static bool shapeCoveredBy(const GeoFilterShape* shapeP, const GeoFilterShape* areaP)
+{
+  if (areaP->polygonV.size() == 0)  // Just like mongo, only polygons can cover anything
+    return false;
+
+  if ((shapeP->bbox.minLon < areaP->bbox.minLon - GEO_EPSILON) || (shapeP->bbox.maxLon > areaP->bbox.maxLon + GEO_EPSILON) ||
+      (shapeP->bbox.minLat < areaP->bbox.minLat - GEO_EPSILON) || (shapeP->bbox.maxLat > areaP->bbox.maxLat + GEO_EPSILON))
+    return false;
+
+  GeoFilterRing vertices;
+
+  verticesGet(shapeP, &vertices);
+  for (unsigned int ix = 0; ix < vertices.size(); ++ix)
+  {
+    if (pointInShape(vertices[ix], areaP) == false)
+      return false;
+  }
+
+  GeoFilterRing  segments;
+  GeoFilterRing  borders;
+
+  segmentsGet(shapeP, &segments);
+  segmentsGet(areaP,  &borders);
+
+  for (unsigned int sIx = 0; sIx < segments.size(); sIx += 2)
+  {
+    for (unsigned int bIx = 0; bIx < borders.size(); bIx += 2)
+    {
+      if (segmentsCross(segments[sIx], segments[sIx + 1], borders[bIx], borders[bIx + 1]))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* haversine - great-circle distance in meters
+*/
+static double haversine(const GeoFilterPoint& a, const GeoFilterPoint& b)
+{
+  double lat1 = a.lat * M_PI / 180;
+  double lat2 = b.lat * M_PI / 180;
+  double dLat = lat2 - lat1;
+  double dLon = (b.lon - a.lon) * M_PI / 180;
+  double h    = sin(dLat / 2) * sin(dLat / 2) + cos(lat1) * cos(lat2) * sin(dLon / 2) * sin(dLon / 2);
+
+  return 2 * EARTH_RADIUS_METERS * asin(sqrt(fmin(1.0, h)));
+}
+
+
+
+/* ****************************************************************************
+*
+* segmentDistance - distance in meters from p to the segment a-b
+*
+* The ends are measured as great-circle distances, the inner part of the segment in a local
+* equirectangular projection around p - plenty for geofences.
+*/
+static double segmentDistance(const GeoFilterPoint& p, const GeoFilterPoint& a, const GeoFilterPoint& b)
+{
+  double distance = fmin(haversine(p, a), haversine(p, b));
+  double kLat     = EARTH_RADIUS_METERS * M_PI / 180;
+  double kLon     = kLat * cos(p.lat * M_PI / 180);
+  double ax       = (a.lon - p.lon) * kLon;
+  double ay       = (a.lat - p.lat) * kLat;
+  double bx       = (b.lon - p.lon) * kLon;
+  double by       = (b.lat - p.lat) * kLat;
+  double dx       = bx - ax;
+  double dy       = by - ay;
+  double len2     = dx * dx + dy * dy;
+
+  if (len2 > 0)
+  {
+    double t = -(ax * dx + ay * dy) / len2;
+
+    if ((t > 0) && (t < 1))
+    {
+      double x = ax + t * dx;
+      double y = ay + t * dy;
+
+      distance = fmin(distance, sqrt(x * x + y * y));
+    }
+  }
+
+  return distance;
+}
+
+
+
+/* ****************************************************************************
+*
+* shapeDistance - distance in meters from p to the nearest point of the shape
+*/
+static double shapeDistance(const GeoFilterPoint& p, const GeoFilterShape* shapeP)
+{
+  double distance = HUGE_VAL;
+
+  for (unsigned int ix = 0; ix < shapeP->pointV.size(); ++ix)
+  {
+    distance = fmin(distance, haversine(p, shapeP->pointV[ix]));
+  }
+
+  for (unsigned int ix = 0; ix < shapeP->polygonV.size(); ++ix)
+  {
+    if (insidePolygon(p, shapeP->polygonV[ix]))
+      return 0;
+  }
+
+  GeoFilterRing segments;
+
+  segmentsGet(shapeP, &segments);
+  for (unsigned int ix = 0; ix < segments.size(); ix += 2)
+  {
+    distance = fmin(distance, segmentDistance(p, segments[ix], segments[ix + 1]));
+  }
+
+  // A line of one single position
+  for (unsigned int ix = 0; ix < shapeP->lineV.size(); ++ix)
+  {
+    if (shapeP->lineV[ix].size() == 1)
+      distance = fmin(distance, haversine(p, shapeP->lineV[ix][0]));
+  }
+
+  return distance;
+}
+
+
+
+/* ****************************************************************************
+*
+* ringsEqual -
+*/
+static bool ringsEqual(const GeoFilterRing& r1, const GeoFilterRing& r2)
+{
+  if (r1.size() != r2.size())
+    return false;
+
+  for (unsigned int ix = 0; ix < r1.size(); ++ix)
+  {
+    if ((r1[ix].lon != r2[ix].lon) || (r1[ix].lat != r2[ix].lat))
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* shapesEqual - same GeoJSON type and exactly the same coordinates
+*/
+static bool shapesEqual(const GeoFilterShape* aP, const GeoFilterShape* bP)
+{
+  if ((aP->type != bP->type) || (aP->lineV.size() != bP->lineV.size()) || (aP->polygonV.size() != bP->polygonV.size()))
+    return false;
+
+  if (ringsEqual(aP->pointV, bP->pointV) == false)
+    return false;
+
+  for (unsigned int ix = 0; ix < aP->lineV.size(); ++ix)
+  {
+    if (ringsEqual(aP->lineV[ix], bP->lineV[ix]) == false)
+      return false;
+  }
+
+  for (unsigned int ix = 0; ix < aP->polygonV.size(); ++ix)
+  {
+    if (aP->polygonV[ix].size() != bP->polygonV[ix].size())
+      return false;
+
+    for (unsigned int rIx = 0; rIx < aP->polygonV[ix].size(); ++rIx)
+    {
+      if (ringsEqual(aP->polygonV[ix][rIx], bP->polygonV[ix][rIx]) == false)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::GeoFilter -
+*/
+GeoFilter::GeoFilter(): rel(GfrNone), maxDistance(-1), minDistance(-1)
+{
+  area.bbox.minLon = 0;
+  area.bbox.minLat = 0;
+  area.bbox.maxLon = 0;
+  area.bbox.maxLat = 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* geoPoint -
+*/
+static inline GeoFilterPoint geoPoint(double lon, double lat)
+{
+  GeoFilterPoint point;
+
+  point.lon = lon;
+  point.lat = lat;
+
+  return point;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::fill - compile georel, geometry and coords
+*
+* The strings are parsed by Scope::fill, just like for the mongo query, and the area is then
+* stored exactly as processAreaScopeV2 would send it to mongo.
+*/
+bool GeoFilter::fill(const std::string& geometry, const std::string& coords, const std::string& georel, std::string* errorStringP)
+{
+  Scope geoScope;
+
+  rel = GfrNone;
+
+  if (geoScope.fill(V2, geometry, coords, georel, errorStringP) != 0)
+  {
+    geoScope.release();
+    return false;
+  }
+
+  if      (geoScope.georel.type == "near")        rel = GfrNear;
+  else if (geoScope.georel.type == "coveredBy")   rel = GfrCoveredBy;
+  else if (geoScope.georel.type == "intersects")  rel = GfrIntersects;
+  else if (geoScope.georel.type == "disjoint")    rel = GfrDisjoint;
+  else if (geoScope.georel.type == "equals")      rel = GfrEquals;
+  else
+  {
+    *errorStringP = "unknown georel type: '" + geoScope.georel.type + "'";
+    geoScope.release();
+    return false;
+  }
+
+  maxDistance = geoScope.georel.maxDistance;
+  minDistance = geoScope.georel.minDistance;
+
+  area.pointV.clear();
+  area.lineV.clear();
+  area.polygonV.clear();
+
+  GeoFilterRing ring;
+
+  if (geoScope.areaType == orion::PointType)
+  {
+    area.type = "Point";
+    area.pointV.push_back(geoPoint(geoScope.point.longitude(), geoScope.point.latitude()));
+  }
+  else if (geoScope.areaType == orion::LineType)
+  {
+    for (unsigned int ix = 0; ix < geoScope.line.pointList.size(); ++ix)
+    {
+      orion::Point* pointP = geoScope.line.pointList[ix];
+
+      ring.push_back(geoPoint(pointP->longitude(), pointP->latitude()));
+    }
+
+    area.type = "LineString";
+    area.lineV.push_back(ring);
+  }
+  else if (geoScope.areaType == orion::BoxType)
+  {
+    orion::Box* boxP = &geoScope.box;
+
+    ring.push_back(geoPoint(boxP->lowerLeft.longitude(),  boxP->lowerLeft.latitude()));
+    ring.push_back(geoPoint(boxP->upperRight.longitude(), boxP->lowerLeft.latitude()));
+    ring.push_back(geoPoint(boxP->upperRight.longitude(), boxP->upperRight.latitude()));
+    ring.push_back(geoPoint(boxP->lowerLeft.longitude(),  boxP->upperRight.latitude()));
+    ring.push_back(geoPoint(boxP->lowerLeft.longitude(),  boxP->lowerLeft.latitude()));
+
+    area.type = "Polygon";
+    area.polygonV.push_back(std::vector<GeoFilterRing>(1, ring));
+  }
+  else if (geoScope.areaType == orion::PolygonType)
+  {
+    for (unsigned int ix = 0; ix < geoScope.polygon.vertexList.size(); ++ix)
+    {
+      orion::Point* pointP = geoScope.polygon.vertexList[ix];
+
+      ring.push_back(geoPoint(pointP->longitude(), pointP->latitude()));
+    }
+
+    area.type = "Polygon";
+    area.polygonV.push_back(std::vector<GeoFilterRing>(1, ring));
+  }
+  else
+  {
+    *errorStringP = "unsupported geometry";
+    rel           = GfrNone;
+    geoScope.release();
+    return false;
+  }
+
+  area.bboxCompute();
+  geoScope.release();
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::clone -
+*/
+GeoFilter* GeoFilter::clone(void) const
+{
+  return new GeoFilter(*this);
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::bboxGet - a box that the location of every matching entity overlaps
+*
+* Used to index the geo-filters of the subscriptions spatially. Returns false if there is no such
+* box: 'disjoint' and 'near' without maxDistance match entities anywhere, and the great-circle edges
+* of an area that isn't planar may bulge out of its box in lon/lat.
+*
+* For 'near', the box of the point is widened by maxDistance - in longitude as seen from the
+* latitude of the box closest to a pole, so the box is never too small. Distances are great-circle
+* distances, so, a box that crosses the antimeridian (or gets close to a pole) spans all longitudes.
+*/
+bool GeoFilter::bboxGet(GeoFilterBox* bboxP) const
+{
+  if ((rel == GfrNone) || (rel == GfrDisjoint) || (area.planar() == false))
+    return false;
+
+  *bboxP = area.bbox;
+
+  if (rel == GfrNear)
+  {
+    if (maxDistance < 0)
+      return false;
+
+    double dLat   = maxDistance / EARTH_RADIUS_METERS * 180 / M_PI;
+    double maxLat = fmax(fabs(bboxP->minLat), fabs(bboxP->maxLat)) + dLat;
+
+    bboxP->minLat -= dLat;
+    bboxP->maxLat += dLat;
+
+    if (maxLat >= 89)
+    {
+      bboxP->minLon = -180;
+      bboxP->maxLon = 180;
+    }
+    else
+    {
+      double dLon = dLat / cos(maxLat * M_PI / 180);
+
+      bboxP->minLon -= dLon;
+      bboxP->maxLon += dLon;
+
+      if ((bboxP->minLon < -180) || (bboxP->maxLon > 180))
+      {
+        bboxP->minLon = -180;
+        bboxP->maxLon = 180;
+      }
+    }
+  }
+
+  // Same tolerance as for the 'on the boundary' checks
+  bboxP->minLon -= GEO_EPSILON;
+  bboxP->minLat -= GEO_EPSILON;
+  bboxP->maxLon += GEO_EPSILON;
+  bboxP->maxLat += GEO_EPSILON;
+
+  return true;
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::exact - does match() give the same result as mongo's 2dsphere, for this location?
+*
+* Only if both the area of the filter and the location of the entity are planar (see GeoFilterShape::planar).
+* An entity without location (or with an invalid one) has nothing for the database to find either.
+*/
+bool GeoFilter::exact(const mongo::BSONObj* geoJsonP) const
+{
+  GeoFilterShape shape;
+
+  if (area.planar() == false)
+    return false;
+
+  if ((geoJsonP == NULL) || (geoJsonP->isEmpty()) || (shape.fill(geoJsonP) == false))
+    return true;
+
+  return shape.planar();
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::match - does the location of an entity (its GeoJSON geometry) pass the filter?
+*
+* An entity without location (geoJsonP == NULL) matches only 'disjoint', just like the mongo query for 'disjoint'
+* ({ "$not": { "$geoIntersects": ... } }) matches the entities without location.
+*/
+bool GeoFilter::match(const mongo::BSONObj* geoJsonP) const
+{
+  GeoFilterShape shape;
+
+  if ((geoJsonP == NULL) || (geoJsonP->isEmpty()))
+    return (rel == GfrDisjoint);
+
+  if (shape.fill(geoJsonP) == false)
+  {
+    LM_W(("Bad Input (invalid GeoJSON geometry for entity location: %s)", geoJsonP->toString().c_str()));
+    return false;
+  }
+
+  return match(&shape);
+}
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter::match -
+*/
+bool GeoFilter::match(const GeoFilterShape* shapeP) const
+{
+  switch (rel)
+  {
+  case GfrNear:
+    if (area.pointV.size() != 1)
+      return false;
+    else
+    {
+      double distance = shapeDistance(area.pointV[0], shapeP);
+
+      if ((maxDistance >= 0) && (distance > maxDistance))
+        return false;
+
+      if ((minDistance >= 0) && (distance < minDistance))
+        return false;
+
+      return true;
+    }
+
+  case GfrCoveredBy:    return shapeCoveredBy(shapeP, &area);
+  case GfrIntersects:   return shapesIntersect(shapeP, &area);
+  case GfrDisjoint:     return !shapesIntersect(shapeP, &area);
+  case GfrEquals:       return shapesEqual(shapeP, &area);
+  case GfrNone:         break;
+  }
+
+  return false;
+}
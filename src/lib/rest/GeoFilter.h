@@ -0,0 +1,134 @@
+#ifndef SRC_LIB_REST_GEOFILTER_H_
+#define SRC_LIB_REST_GEOFILTER_H_
+
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string>
+#include <vector>
+
+#include "mongo/client/dbclient.h"
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterRel - the georel of a geo-filter
+*/
+typedef enum GeoFilterRel
+{
+  GfrNone,
+  GfrNear,
+  GfrCoveredBy,
+  GfrIntersects,
+  GfrDisjoint,
+  GfrEquals
+} GeoFilterRel;
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterPoint - longitude and latitude, in the order of GeoJSON
+*/
+typedef struct GeoFilterPoint
+{
+  double lon;
+  double lat;
+} GeoFilterPoint;
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterBox - bounding box of a shape
+*/
+typedef struct GeoFilterBox
+{
+  double minLon;
+  double minLat;
+  double maxLon;
+  double maxLat;
+} GeoFilterBox;
+
+
+
+/* ****************************************************************************
+*
+* GeoFilterShape - in-memory form of a GeoJSON geometry
+*
+* Points, lines and polygons - a polygon is its outer ring followed by its holes.
+* A 'Multi' geometry is simply more than one item in the corresponding vector.
+*/
+typedef std::vector<GeoFilterPoint> GeoFilterRing;
+
+typedef struct GeoFilterShape
+{
+  std::string                               type;      // GeoJSON type
+  std::vector<GeoFilterPoint>               pointV;
+  std::vector<GeoFilterRing>                lineV;
+  std::vector<std::vector<GeoFilterRing> >  polygonV;
+  GeoFilterBox                              bbox;
+
+  bool  fill(const mongo::BSONObj* geoJsonP);
+  void  bboxCompute(void);
+  bool  planar(void) const;
+} GeoFilterShape;
+
+
+
+/* ****************************************************************************
+*
+* GeoFilter - the geo-filter (georel, geometry and coords) of a subscription, compiled
+*
+* The filter is compiled once (when the subscription enters the subscription cache) and then
+* evaluated in memory against the location of the entity of each update - instead of asking the
+* database whether the updated entity is inside the area.
+*
+* The geometric tests are done in the plane of longitude/latitude, while distances (for 'near') are
+* great-circle distances in meters, like in mongo.
+* The edges of mongo's 2dsphere shapes are great-circle arcs though, so the plane only gives the same result
+* for small shapes (see GeoFilterShape::planar). For anything else, exact() returns false and the caller is to
+* ask the database instead.
+*/
+class GeoFilter
+{
+public:
+  GeoFilter();
+
+  bool          fill(const std::string& geometry, const std::string& coords, const std::string& georel, std::string* errorStringP);
+  GeoFilter*    clone(void) const;
+  bool          isSet(void) const { return rel != GfrNone; }
+  bool          bboxGet(GeoFilterBox* bboxP) const;
+  bool          exact(const mongo::BSONObj* geoJsonP) const;
+  bool          match(const mongo::BSONObj* geoJsonP) const;
+  bool          match(const GeoFilterShape* shapeP) const;
+
+  GeoFilterRel    rel;
+  double          maxDistance;   // -1 if not set
+  double          minDistance;   // -1 if not set
+  GeoFilterShape  area;
+};
+
+#endif  // SRC_LIB_REST_GEOFILTER_H_
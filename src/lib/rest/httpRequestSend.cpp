@@ -218,18 +218,18 @@ static int contentLenParse(char* s)
 
 /* ****************************************************************************
 *
-* httpRequestSendWithCurl -
+* httpRequestPrepare -
 *
-* The waitForResponse arguments specifies if the method has to wait for response
-* before return. If this argument is false, the return string is ""
+* Checks the input and sets up the curl handle for the request: URL, verb, HTTP headers, payload,
+* response buffer and timeout, without performing the request.
+* The request is performed by the caller (curl_easy_perform or a curl multi handle) and then
+* finished with httpRequestComplete, that frees the resources kept in 'reqP'.
 *
-* NOTE
-* We are using a hybrid approach, consisting of a static thread-local buffer of a
-* small size that copes with most notifications to avoid expensive
-* calloc/free syscalls if the notification payload is not very large.
+* The payload ('content') is not copied by libcurl, so it must be kept alive until the request
+* has been completed.
 *
 * RETURN VALUES
-*   httpRequestSendWithCurl returns 0 on success and a negative number on failure:
+*   httpRequestPrepare returns 0 on success and a negative number on failure:
 *     -1: Invalid port
 *     -2: Invalid IP
 *     -3: Invalid verb
@@ -237,9 +237,10 @@ static int contentLenParse(char* s)
 *     -5: No Content-Type BUT content present
 *     -6: Content-Type present but there is no content
 *     -7: Total outgoing message size is too big
-*     -9: Error making HTTP request
+*
+*   On failure, there is nothing left to be completed.
 */
-int httpRequestSendWithCurl
+int httpRequestPrepare
 (
    CURL*                                      curl,
    const std::string&                         _ip,
@@ -254,12 +255,11 @@ int httpRequestSendWithCurl
    const std::string&                         content,
    const std::string&                         fiwareCorrelation,
    const std::string&                         ngsiv2AttrFormat,
-   bool                                       waitForResponse,
-   std::string*                               outP,
    const std::map<std::string, std::string>&  extraHeaders,
    const std::string&                         acceptFormat,
    long                                       timeoutInMilliseconds,
-   const char*                                subscriptionId
+   const char*                                subscriptionId,
+   HttpRequest*                               reqP
 )
 {
   char                            portAsString[STRING_SIZE_FOR_INT];
@@ -267,17 +267,21 @@ int httpRequestSendWithCurl
   std::string                     ip                 = _ip;
   struct curl_slist*              headers            = NULL;
   MemoryStruct*                   httpResponse       = NULL;
-  CURLcode                        res;
   int                             outgoingMsgSize    = 0;
   std::string                     content_type(orig_content_type);
   std::map<std::string, bool>     usedExtraHeaders;
-  char                            servicePath0[SERVICE_PATH_MAX_COMPONENT_LEN + 1];  // +1 for zero termination
+  char*                           servicePath0       = reqP->servicePath0;
+
+  reqP->curl     = curl;
+  reqP->headers  = NULL;
+  reqP->response = NULL;
+  reqP->tenant   = tenant;
 
-  firstServicePath(servicePath.c_str(), servicePath0, sizeof(servicePath0));
+  firstServicePath(servicePath.c_str(), servicePath0, sizeof(reqP->servicePath0));
   if (metricsMgr.isOn())
     metricsMgr.add(tenant, servicePath0, METRIC_TRANS_OUT, 1);
 
-  ++sendReqNo;
+  reqP->sendReqNo = ++sendReqNo;
 
   // For content-type application/json we add charset=utf-8
   if ((orig_content_type == "application/json") || (orig_content_type == "text/plain"))
@@ -301,7 +305,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (port is ZERO)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -1;
   }
 
@@ -312,7 +315,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (ip is empty)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -2;
   }
 
@@ -323,7 +325,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (verb is empty)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -3;
   }
 
@@ -334,7 +335,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (resource is empty)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -4;
   }
 
@@ -345,7 +345,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (Content-Type is empty but there is actual content)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -5;
   }
 
@@ -356,7 +355,6 @@ int httpRequestSendWithCurl
     LM_E(("Runtime Error (Content-Type non-empty but there is no content)"));
     lmTransactionEnd();
 
-    *outP = "error";
     return -6;
   }
 
@@ -433,8 +431,8 @@ int httpRequestSendWithCurl
   // including HTTP headers etc, while 'payloadSize' is the size of just
   // the payload of the message.
   //
-  unsigned long long payloadSize = content.size();
-  outgoingMsgSize += payloadSize;
+  reqP->payloadSize = content.size();
+  outgoingMsgSize  += reqP->payloadSize;
 
   // ----- Content-type
   std::string contentTypeHeaderValue = content_type;
@@ -490,7 +488,6 @@ int httpRequestSendWithCurl
     delete httpResponse;
 
     lmTransactionEnd();
-    *outP = "error";
     return -7;
   }
 
@@ -499,7 +496,7 @@ int httpRequestSendWithCurl
   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, (u_int8_t*) payload);
 
   // Set up URL
-  std::string url;
+  std::string& url = reqP->url;
   if (isIPv6(ip))
   {
     url = "[" + ip + "]";
@@ -555,15 +552,32 @@ int httpRequestSendWithCurl
   }
 
 
-  //
-  // Synchronous HTTP request
   //
   // This was previously an LM_T trace, but we have "promoted" it to INFO due to it is needed
   // to check logs in a .test case (case 000 notification_different_sizes.test)
   //
-  LM_K(("Sending message %lu to HTTP server: sending message of %d bytes to HTTP server", sendReqNo, outgoingMsgSize));
+  LM_K(("Sending message %lu to HTTP server: sending message of %d bytes to HTTP server", reqP->sendReqNo, outgoingMsgSize));
 
-  res = curl_easy_perform(curl);
+  reqP->headers  = headers;
+  reqP->response = httpResponse;
+
+  return 0;
+}
+
+
+
+/* ****************************************************************************
+*
+* httpRequestComplete -
+*
+* Finishes a request prepared by httpRequestPrepare, once libcurl is done with it, 'res' being the
+* result of the transfer: logs, metrics, the response in 'outP' and cleanup of 'reqP'.
+*
+* RETURN VALUES
+*   httpRequestComplete returns 0 on success and -9 on failure (error making HTTP request)
+*/
+int httpRequestComplete(HttpRequest* reqP, CURLcode res, std::string* outP)
+{
   if (res != CURLE_OK)
   {
     //
@@ -571,38 +585,41 @@ int httpRequestSendWithCurl
     //       So, this line should not be removed/altered, at least not without also modifying the functests.
     //
     LM_E(("curl_easy_perform failed: %d", res));
-    alarmMgr.notificationError(url, "(curl_easy_perform failed: " + std::string(curl_easy_strerror(res)) + ")");
+    alarmMgr.notificationError(reqP->url, "(curl_easy_perform failed: " + std::string(curl_easy_strerror(res)) + ")");
     *outP = "notification failure";
 
     if (metricsMgr.isOn())
-      metricsMgr.add(tenant, servicePath0, METRIC_TRANS_OUT_ERRORS, 1);
+      metricsMgr.add(reqP->tenant, reqP->servicePath0, METRIC_TRANS_OUT_ERRORS, 1);
   }
   else
   {
     //
     // The Response is here
     //
-    int   payloadLen  = contentLenParse(httpResponse->memory);
+    int   payloadLen  = contentLenParse(reqP->response->memory);
 
-    LM_I(("Notification Successfully Sent to %s", url.c_str()));
-    outP->assign(httpResponse->memory, httpResponse->size);
+    LM_I(("Notification Successfully Sent to %s", reqP->url.c_str()));
+    outP->assign(reqP->response->memory, reqP->response->size);
 
     if (metricsMgr.isOn())
-      metricsMgr.add(tenant, servicePath0, METRIC_TRANS_OUT_RESP_SIZE, payloadLen);
+      metricsMgr.add(reqP->tenant, reqP->servicePath0, METRIC_TRANS_OUT_RESP_SIZE, payloadLen);
   }
 
-  if (payloadSize > 0)
+  if (reqP->payloadSize > 0)
   {
     if (metricsMgr.isOn())
-      metricsMgr.add(tenant, servicePath0, METRIC_TRANS_OUT_REQ_SIZE, payloadSize);
+      metricsMgr.add(reqP->tenant, reqP->servicePath0, METRIC_TRANS_OUT_REQ_SIZE, reqP->payloadSize);
   }
 
   // Cleanup curl environment
 
-  curl_slist_free_all(headers);
+  curl_slist_free_all(reqP->headers);
+
+  free(reqP->response->memory);
+  delete reqP->response;
 
-  free(httpResponse->memory);
-  delete httpResponse;
+  reqP->headers  = NULL;
+  reqP->response = NULL;
 
   lmTransactionEnd();
 
@@ -611,6 +628,80 @@ int httpRequestSendWithCurl
 
 
 
+/* ****************************************************************************
+*
+* httpRequestSendWithCurl -
+*
+* The waitForResponse arguments specifies if the method has to wait for response
+* before return. If this argument is false, the return string is ""
+*
+* RETURN VALUES
+*   httpRequestSendWithCurl returns 0 on success and a negative number on failure:
+*     -1: Invalid port
+*     -2: Invalid IP
+*     -3: Invalid verb
+*     -4: Invalid resource
+*     -5: No Content-Type BUT content present
+*     -6: Content-Type present but there is no content
+*     -7: Total outgoing message size is too big
+*     -9: Error making HTTP request
+*/
+int httpRequestSendWithCurl
+(
+   CURL*                                      curl,
+   const std::string&                         _ip,
+   unsigned short                             port,
+   const std::string&                         _protocol,
+   const std::string&                         verb,
+   const char*                                tenant,
+   const std::string&                         servicePath,
+   const char*                                xauthToken,
+   const std::string&                         resource,
+   const std::string&                         orig_content_type,
+   const std::string&                         content,
+   const std::string&                         fiwareCorrelation,
+   const std::string&                         ngsiv2AttrFormat,
+   bool                                       waitForResponse,
+   std::string*                               outP,
+   const std::map<std::string, std::string>&  extraHeaders,
+   const std::string&                         acceptFormat,
+   long                                       timeoutInMilliseconds,
+   const char*                                subscriptionId
+)
+{
+  HttpRequest  req;
+  int          r;
+
+  r = httpRequestPrepare(curl,
+                         _ip,
+                         port,
+                         _protocol,
+                         verb,
+                         tenant,
+                         servicePath,
+                         xauthToken,
+                         resource,
+                         orig_content_type,
+                         content,
+                         fiwareCorrelation,
+                         ngsiv2AttrFormat,
+                         extraHeaders,
+                         acceptFormat,
+                         timeoutInMilliseconds,
+                         subscriptionId,
+                         &req);
+
+  if (r != 0)
+  {
+    *outP = "error";
+    return r;
+  }
+
+  return httpRequestComplete(&req, curl_easy_perform(curl), outP);
+}
+
+
+
 /* ****************************************************************************
 *
 * httpRequestSend -
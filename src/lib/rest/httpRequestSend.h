@@ -27,7 +27,11 @@
 */
 #include <string>
 #include <vector>
+#include <map>
 
+#include <curl/curl.h>
+
+#include "common/limits.h"
 #include "ConnectionInfo.h"
 
 #define URI_BUF          (256)
@@ -79,6 +83,61 @@ extern int httpRequestSend
 
 
 
+/* ****************************************************************************
+*
+* HttpRequest - an outgoing request, between httpRequestPrepare and httpRequestComplete
+*/
+struct MemoryStruct;
+typedef struct HttpRequest
+{
+  CURL*                curl;
+  struct curl_slist*   headers;
+  MemoryStruct*        response;
+  std::string          url;
+  const char*          tenant;
+  char                 servicePath0[SERVICE_PATH_MAX_COMPONENT_LEN + 1];  // +1 for zero termination
+  unsigned long long   sendReqNo;
+  unsigned long long   payloadSize;
+} HttpRequest;
+
+
+
+/* ****************************************************************************
+*
+* httpRequestPrepare -
+*/
+extern int httpRequestPrepare
+(
+  CURL*                                      curl,
+  const std::string&                         ip,
+  unsigned short                             port,
+  const std::string&                         protocol,
+  const std::string&                         verb,
+  const char*                                tenant,
+  const std::string&                         servicePath,
+  const char*                                xauthToken,
+  const std::string&                         resource,
+  const std::string&                         content_type,
+  const std::string&                         content,
+  const std::string&                         fiwareCorrelation,
+  const std::string&                         ngisv2AttrFormat,
+  const std::map<std::string, std::string>&  extraHeaders,
+  const std::string&                         acceptFormat,
+  long                                       timeoutInMilliseconds,
+  const char*                                subscriptionId,
+  HttpRequest*                               reqP
+);
+
+
+
+/* ****************************************************************************
+*
+* httpRequestComplete -
+*/
+extern int httpRequestComplete(HttpRequest* reqP, CURLcode res, std::string* outP);
+
+
+
 /* ****************************************************************************
 *
 * httpRequestSendWithCurl -
@@ -27,7 +27,9 @@
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <unistd.h>
 #include <uuid/uuid.h>
+#include <stddef.h>                                              // offsetof
 
 #include <string>
 #include <map>
@@ -62,10 +64,17 @@ extern "C"
 #include "orionld/common/orionldErrorResponse.h"                 // orionldErrorResponseCreate
 #include "orionld/common/orionldTenantGet.h"                     // orionldTenantGet
 #include "orionld/common/tenantList.h"                           // tenant0
+#include "orionld/common/orionldArenaRelease.h"                  // orionldArenaRelease
+#include "orionld/mongoc/mongocCatalogUpdate.h"                  // mongocCatalogUpdate
 #include "orionld/rest/orionldMhdConnectionInit.h"               // orionldMhdConnectionInit
 #include "orionld/rest/orionldMhdConnectionPayloadRead.h"        // orionldMhdConnectionPayloadRead
 #include "orionld/rest/orionldMhdConnectionTreat.h"              // orionldMhdConnectionTreat
+#include "orionld/rest/orionldRequestWorkerConnectionInit.h"     // orionldRequestWorkerConnectionInit
+#include "orionld/rest/orionldRequestWorkerEnqueue.h"            // orionldRequestWorkerEnqueue
+#include "orionld/rest/orionldRequestWorkerInit.h"               // orionldRequestWorkerInit
+#include "orionld/rest/orionldBatchStreamRelease.h"              // orionldBatchStreamRelease
 #include "orionld/serviceRoutines/orionldNotify.h"               // orionldNotify
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheReadBegin, orionldContextCacheReadEnd
 
 #include "rest/Verb.h"
 #include "rest/HttpHeaders.h"
@@ -107,6 +116,8 @@ char                             corsOrigin[64];
 int                              corsMaxAge;
 static MHD_Daemon*               mhdDaemon             = NULL;
 static MHD_Daemon*               mhdDaemon_v6          = NULL;
+static MHD_Daemon**              mhdEventLoopV         = NULL;
+static int                       mhdEventLoops         = 0;
 static struct sockaddr_in        sad;
 static struct sockaddr_in6       sad_v6;
 __thread char                    static_buffer[STATIC_BUFFER_SIZE + 1];
@@ -697,20 +708,16 @@ MHD_Result httpHeaderGet(void* cbDataP, MHD_ValueKind kind, const char* key, con
 
 /* ****************************************************************************
 *
-* requestCompleted -
+* requestFinish - notifications, statistics and cleanup, once the response has been queued
+*
+* Called by requestCompleted, in the thread that served the request, or, with request workers (-httpWorkers),
+* by the request worker, as the state of the request (orionldState) lives in the thread that served it.
 */
-static void requestCompleted
-(
-  void*                       cls,
-  MHD_Connection*             connection,
-  void**                      con_cls,
-  MHD_RequestTerminationCode  toe
-)
+void requestFinish(ConnectionInfo* ciP)
 {
   PERFORMANCE(requestCompletedStart);
 
   LM_TMP(("orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
-  ConnectionInfo*  ciP      = (ConnectionInfo*) *con_cls;
   const char*      spath    = (ciP->servicePathV.size() > 0)? ciP->servicePathV[0].c_str() : "";
   struct timespec  reqEndTime;
 
@@ -721,12 +728,33 @@ static void requestCompleted
     PERFORMANCE(notifEnd);
   }
 
-  if ((ciP->payload != NULL) && (ciP->payload != static_buffer))
+  if ((ciP->payload != NULL) && (ciP->payload != static_buffer) && (ciP->payloadInArena == false))
   {
     free(ciP->payload);
     ciP->payload = NULL;
   }
 
+  //
+  // A streamed response renders from the request state until it has been entirely sent - its release is delayed until now
+  //
+  if (orionldState.responseStreamed == true)
+    orionldStateRelease();
+
+  //
+  // The buffers of a batch payload that is parsed while being read - still here if the request never got to orionldBatchStreamEnd
+  //
+  if (orionldState.batchStream.active == true)
+    orionldBatchStreamRelease();
+
+  //
+  // No more use of contexts of the context cache - the end of the read section that started in orionldMhdConnectionInit
+  //
+  if (orionldState.contextCacheReading == true)
+  {
+    orionldContextCacheReadEnd(orionldState.contextCachePhase);
+    orionldState.contextCacheReading = false;
+  }
+
 
   lmTransactionEnd();  // Incoming REST request ends
 
@@ -810,12 +838,11 @@ static void requestCompleted
   delete(ciP);
 
   kaBufferReset(&orionldState.kalloc, false);  // 'false': it's reused, but in a different thread ...
+  orionldArenaRelease();                        // Request buffers back to the arena of the thread (incl. the payload, if big)
 
   if ((orionldState.responseTree != NULL) && (orionldState.kjsonP == NULL))
     kjFree(orionldState.responseTree);
 
-  *con_cls = NULL;
-
   ++reqNo;
   if (reqNo % 1000 == 0)
     LM_TMP(("reqNo: %d", reqNo));
@@ -842,7 +869,7 @@ static void requestCompleted
 
     for (int ix = 0; ix < 50; ix++)
     {
-      if (timestamps.srDesc[ix] != NULL)
+      if ((timestamps.srMask & (1ULL << ix)) != 0)
         TIME_REPORT(timestamps.srStart[ix], timestamps.srEnd[ix], timestamps.srDesc[ix]);
     }
 
@@ -866,6 +893,43 @@ static void requestCompleted
 
 
 
+/* ****************************************************************************
+*
+* requestCompleted -
+*/
+static void requestCompleted
+(
+  void*                       cls,
+  MHD_Connection*             connection,
+  void**                      con_cls,
+  MHD_RequestTerminationCode  toe
+)
+{
+  ConnectionInfo* ciP = (ConnectionInfo*) *con_cls;
+
+  *con_cls = NULL;
+
+  if (ciP == NULL)
+    return;
+
+  //
+  // Requests read by an event loop for the request workers (ciP->url is set only then).
+  // Once handed over to a request worker, *con_cls is NULL - the worker finishes the request and frees ciP.
+  // So, if ciP is still here, it was never handed over (e.g. the client closed the connection while sending the payload)
+  // and there is no request state to finish.
+  //
+  if (ciP->url != NULL)
+  {
+    free(ciP->payload);
+    delete ciP;
+    return;
+  }
+
+  requestFinish(ciP);
+}
+
+
+
 /* ****************************************************************************
 *
 * servicePathCheck - check vector of service paths
@@ -1672,9 +1736,12 @@ static MHD_Result connectionTreat
       if (*con_cls == NULL)
       {
 #ifdef REQUEST_PERFORMANCE
-        bzero(&timestamps, sizeof(timestamps));
+        bzero(&timestamps, offsetof(Timestamps, srStart));  // The samples are only valid if set in srMask
         kTimeGet(&timestamps.reqStart);
 #endif
+        if (httpWorkers > 0)
+          return orionldRequestWorkerConnectionInit(connection, url, method, version, con_cls);
+
         return orionldMhdConnectionInit(connection, url, method, version, con_cls);
       }
       else if (*upload_data_size != 0)
@@ -1692,6 +1759,18 @@ static MHD_Result connectionTreat
       // Mark the request as "finished", by setting upload_data_size to 0
       *upload_data_size = 0;
 
+      //
+      // With request workers, the request is treated by one of them.
+      // From here on, ciP belongs to the request worker only - MHD forgets about it, so requestCompleted never sees it
+      //
+      if (httpWorkers > 0)
+      {
+        ConnectionInfo* ciP = (ConnectionInfo*) *con_cls;
+
+        *con_cls = NULL;
+        return orionldRequestWorkerEnqueue(ciP);
+      }
+
       // Then treat the request
       return orionldMhdConnectionTreat((ConnectionInfo*) *con_cls);
     }
@@ -1728,6 +1807,14 @@ static MHD_Result connectionTreat
     LM_TMP(("KZ: After orionldUriArgumentGet: orionldState.httpStatusCode == %d", orionldState.httpStatusCode));
 
     *con_cls = connectionTreatInit(connection, url, method, version, &retVal);
+
+    // Notifications of NGSI-LD subscriptions use contexts of the context cache - see orionldMhdConnectionInit
+    if (*con_cls != NULL)
+    {
+      orionldState.contextCachePhase   = orionldContextCacheReadBegin();
+      orionldState.contextCacheReading = true;
+    }
+
     return retVal;
   }
 
@@ -1881,6 +1968,13 @@ static MHD_Result connectionTreat
   {
     // All is good. The request can be served.
     orion::requestServe(ciP);
+
+    // NGSIv2 entities are part of the entity catalog as well
+    if (orionldState.catalogDeltaP != NULL)
+    {
+      mongocCatalogUpdate(orionldState.tenantP, orionldState.catalogDeltaP);
+      orionldState.catalogDeltaP = NULL;
+    }
   }
 
   return MHD_YES;
@@ -1888,6 +1982,137 @@ static MHD_Result connectionTreat
 
 
 
+/* ****************************************************************************
+*
+* eventLoopStart - start an MHD daemon with its own epoll event loop thread and its own listening socket
+*/
+static MHD_Daemon* eventLoopStart
+(
+  int               serverMode,
+  struct sockaddr*  sockAddrP,
+  size_t            memoryLimit,
+  unsigned int      connections,
+  const char*       httpsKey,
+  const char*       httpsCertificate
+)
+{
+  struct MHD_OptionItem  optionV[10];
+  int                    ix = 0;
+
+  optionV[ix++] = { MHD_OPTION_CONNECTION_MEMORY_LIMIT,  (intptr_t) memoryLimit,           NULL      };
+  optionV[ix++] = { MHD_OPTION_CONNECTION_LIMIT,         (intptr_t) connections,           NULL      };
+  optionV[ix++] = { MHD_OPTION_SOCK_ADDR,                0,                                sockAddrP };
+  optionV[ix++] = { MHD_OPTION_NOTIFY_COMPLETED,         (intptr_t) requestCompleted,      NULL      };
+  optionV[ix++] = { MHD_OPTION_CONNECTION_TIMEOUT,       (intptr_t) mhdConnectionTimeout,  NULL      };
+  optionV[ix++] = { MHD_OPTION_LISTENING_ADDRESS_REUSE,  1,                                NULL      };  // SO_REUSEPORT
+
+  if ((httpsKey != NULL) && (httpsCertificate != NULL))
+  {
+    serverMode |= MHD_USE_SSL;
+    optionV[ix++] = { MHD_OPTION_HTTPS_MEM_KEY,          0,                                (void*) httpsKey         };
+    optionV[ix++] = { MHD_OPTION_HTTPS_MEM_CERT,         0,                                (void*) httpsCertificate };
+  }
+
+  optionV[ix++] = { MHD_OPTION_END, 0, NULL };
+
+  return MHD_start_daemon(serverMode, port, NULL, NULL, connectionTreat, NULL, MHD_OPTION_ARRAY, optionV, MHD_OPTION_END);
+}
+
+
+
+/* ****************************************************************************
+*
+* restStartEventLoops -
+*
+* With request workers (-httpWorkers), the REST interface consists of -httpLoops MHD daemons (one per core by default),
+* each with its own epoll event loop thread and its own listening socket, all bound to the same address and port (SO_REUSEPORT),
+* so that the kernel distributes the incoming connections over the event loops.
+*
+* The event loops only read the requests, the requests are served by the fixed pool of request workers
+* (see orionld/rest/orionldRequestWorker.h) - a connection costs a socket and its MHD connection memory, not a thread.
+*
+* -maxConnections is the limit for the entire broker, it is divided among the event loops.
+*/
+static int restStartEventLoops(IpVersion ipVersion, const char* httpsKey, const char* httpsCertificate)
+{
+  size_t  memoryLimit = connMemory * 1024;  // Connection memory is expressed in kilobytes
+  int     loops       = (httpLoops != 0)? httpLoops : sysconf(_SC_NPROCESSORS_ONLN);
+  int     serverMode  = MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_ERROR_LOG;
+
+  if (loops < 1)
+    loops = 1;
+
+#if defined(MHD_USE_EPOLL) || MHD_VERSION >= 0x00095100
+  serverMode |= MHD_USE_EPOLL;
+#else
+  serverMode |= MHD_USE_EPOLL_LINUX_ONLY;
+#endif
+
+#if MHD_VERSION >= 0x00095900
+  serverMode |= MHD_ALLOW_SUSPEND_RESUME;
+#else
+  serverMode |= MHD_USE_SUSPEND_RESUME;
+#endif
+
+  if (threadPoolSize != 0)
+    LM_W(("-reqPoolSize is ignored when request workers are used (-httpWorkers)"));
+
+  if (orionldRequestWorkerInit(httpWorkers) == false)
+    LM_X(1, ("Fatal Error (unable to start %d request workers)", httpWorkers));
+
+  unsigned int connections = (maxConns + loops - 1) / loops;
+
+  mhdEventLoopV = (MHD_Daemon**) calloc(2 * loops, sizeof(MHD_Daemon*));
+  if (mhdEventLoopV == NULL)
+    LM_X(1, ("Out of memory (allocating room for %d event loops)", loops));
+
+  if ((ipVersion == IPV4) || (ipVersion == IPDUAL))
+  {
+    memset(&sad, 0, sizeof(sad));
+    if (inet_pton(AF_INET, bindIp, &(sad.sin_addr.s_addr)) != 1)
+      LM_X(2, ("Fatal Error (V4 inet_pton fail for %s)", bindIp));
+
+    sad.sin_family = AF_INET;
+    sad.sin_port   = htons(port);
+
+    for (int ix = 0; ix < loops; ix++)
+    {
+      MHD_Daemon* daemonP = eventLoopStart(serverMode, (struct sockaddr*) &sad, memoryLimit, connections, httpsKey, httpsCertificate);
+
+      if (daemonP == NULL)
+        LM_X(5, ("Fatal Error (error starting IPv4 event loop %d of the REST interface)", ix));
+
+      mhdEventLoopV[mhdEventLoops++] = daemonP;
+    }
+  }
+
+  if ((ipVersion == IPV6) || (ipVersion == IPDUAL))
+  {
+    memset(&sad_v6, 0, sizeof(sad_v6));
+    if (inet_pton(AF_INET6, bindIPv6, &(sad_v6.sin6_addr.s6_addr)) != 1)
+      LM_X(4, ("Fatal Error (V6 inet_pton fail for %s)", bindIPv6));
+
+    sad_v6.sin6_family = AF_INET6;
+    sad_v6.sin6_port   = htons(port);
+
+    for (int ix = 0; ix < loops; ix++)
+    {
+      MHD_Daemon* daemonP = eventLoopStart(serverMode | MHD_USE_IPv6, (struct sockaddr*) &sad_v6, memoryLimit, connections, httpsKey, httpsCertificate);
+
+      if (daemonP == NULL)
+        LM_X(5, ("Fatal Error (error starting IPv6 event loop %d of the REST interface)", ix));
+
+      mhdEventLoopV[mhdEventLoops++] = daemonP;
+    }
+  }
+
+  LM_I(("REST interface: %d event loops per IP version, %d request workers", loops, httpWorkers));
+
+  return 0;
+}
+
+
+
 /* ****************************************************************************
 *
 * restStart -
@@ -1920,6 +2145,9 @@ static int restStart(IpVersion ipVersion, const char* httpsKey = NULL, const cha
     LM_X(1, ("Fatal Error (please call restInit before starting the REST service)"));
   }
 
+  if (httpWorkers > 0)
+    return restStartEventLoops(ipVersion, httpsKey, httpsCertificate);
+
   if (threadPoolSize != 0)
   {
     //
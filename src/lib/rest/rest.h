@@ -122,6 +122,14 @@ extern void restInit
 
 
 
+/* ****************************************************************************
+*
+* requestFinish - notifications, statistics and cleanup, once the response has been queued
+*/
+extern void requestFinish(ConnectionInfo* ciP);
+
+
+
 /* ****************************************************************************
 *
 * servicePathCheck -
@@ -71,56 +71,16 @@ static int replyIx = 0;
 
 /* ****************************************************************************
 *
-* restReply -
+* responseHeadersAdd - add the HTTP headers of the response
 */
-void restReply(ConnectionInfo* ciP, const std::string& answer)
+static void responseHeadersAdd(ConnectionInfo* ciP, MHD_Response* response, bool payload)
 {
-  MHD_Response*  response;
-
-  uint64_t     answerLen = answer.length();
-  const char*  spath     = (ciP->servicePathV.size() > 0)? ciP->servicePathV[0].c_str() : "";
-
-  ++replyIx;
-  // LM_TMP(("Response %d: responding with %d bytes, Status Code %d: %s", replyIx, answerLen, orionldState.httpStatusCode, answer.c_str()));
-  // LM_TMP(("Response %d: responding with %d bytes, Status Code %d", replyIx, answerLen, orionldState.httpStatusCode));
-
-  response = MHD_create_response_from_buffer(answerLen, (void*) answer.c_str(), MHD_RESPMEM_MUST_COPY);
-  if (!response)
-  {
-    if (orionldState.apiVersion != NGSI_LD_V1)
-    {
-      if (metricsMgr.isOn())
-        metricsMgr.add(orionldState.tenantP->tenant, spath, METRIC_TRANS_IN_ERRORS, 1);
-    }
-
-    LM_E(("Runtime Error (MHD_create_response_from_buffer FAILED)"));
-
-#ifdef ORIONLD
-    if (orionldState.responsePayloadAllocated == true)
-    {
-      free(orionldState.responsePayload);
-      orionldState.responsePayload = NULL;
-    }
-#endif
-
-    return;
-  }
-
-  if (answerLen > 0)
-  {
-    if (orionldState.apiVersion != NGSI_LD_V1)
-    {
-      if (metricsMgr.isOn())
-        metricsMgr.add(orionldState.tenantP->tenant, spath, METRIC_TRANS_IN_RESP_SIZE, answerLen);
-    }
-  }
-
   for (unsigned int hIx = 0; hIx < ciP->httpHeader.size(); ++hIx)
   {
     MHD_add_response_header(response, ciP->httpHeader[hIx].c_str(), ciP->httpHeaderValue[hIx].c_str());
   }
 
-  if (answer != "")
+  if (payload == true)
   {
     //
     // For error-responses, never respond with application/ld+json
@@ -191,6 +151,57 @@ void restReply(ConnectionInfo* ciP, const std::string& answer)
       }
     }
   }
+}
+
+
+
+/* ****************************************************************************
+*
+* restReply -
+*/
+void restReply(ConnectionInfo* ciP, const std::string& answer)
+{
+  MHD_Response*  response;
+
+  uint64_t     answerLen = answer.length();
+  const char*  spath     = (ciP->servicePathV.size() > 0)? ciP->servicePathV[0].c_str() : "";
+
+  ++replyIx;
+  // LM_TMP(("Response %d: responding with %d bytes, Status Code %d: %s", replyIx, answerLen, orionldState.httpStatusCode, answer.c_str()));
+  // LM_TMP(("Response %d: responding with %d bytes, Status Code %d", replyIx, answerLen, orionldState.httpStatusCode));
+
+  response = MHD_create_response_from_buffer(answerLen, (void*) answer.c_str(), MHD_RESPMEM_MUST_COPY);
+  if (!response)
+  {
+    if (orionldState.apiVersion != NGSI_LD_V1)
+    {
+      if (metricsMgr.isOn())
+        metricsMgr.add(orionldState.tenantP->tenant, spath, METRIC_TRANS_IN_ERRORS, 1);
+    }
+
+    LM_E(("Runtime Error (MHD_create_response_from_buffer FAILED)"));
+
+#ifdef ORIONLD
+    if (orionldState.responsePayloadAllocated == true)
+    {
+      free(orionldState.responsePayload);
+      orionldState.responsePayload = NULL;
+    }
+#endif
+
+    return;
+  }
+
+  if (answerLen > 0)
+  {
+    if (orionldState.apiVersion != NGSI_LD_V1)
+    {
+      if (metricsMgr.isOn())
+        metricsMgr.add(orionldState.tenantP->tenant, spath, METRIC_TRANS_IN_RESP_SIZE, answerLen);
+    }
+  }
+
+  responseHeadersAdd(ciP, response, answer != "");
 
   MHD_queue_response(orionldState.mhdConnection, orionldState.httpStatusCode, response);
   MHD_destroy_response(response);
@@ -206,6 +217,35 @@ void restReply(ConnectionInfo* ciP, const std::string& answer)
 
 
 
+/* ****************************************************************************
+*
+* restReplyStream - respond with a payload that is produced while it is being sent
+*
+* The response has no Content-Length, so MHD sends it with chunked transfer-encoding (HTTP/1.1).
+* MHD calls 'reader' for every chunk of at most 'blockSize' bytes, and 'release' once the response is done with.
+*/
+bool restReplyStream(ConnectionInfo* ciP, size_t blockSize, MHD_ContentReaderCallback reader, void* cls, MHD_ContentReaderFreeCallback release)
+{
+  MHD_Response* response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, blockSize, reader, cls, release);
+
+  ++replyIx;
+
+  if (response == NULL)
+  {
+    LM_E(("Runtime Error (MHD_create_response_from_callback FAILED)"));
+    return false;
+  }
+
+  responseHeadersAdd(ciP, response, true);
+
+  MHD_queue_response(orionldState.mhdConnection, orionldState.httpStatusCode, response);
+  MHD_destroy_response(response);
+
+  return true;
+}
+
+
+
 /* ****************************************************************************
 *
 * restErrorReplyGet -
@@ -29,6 +29,7 @@
 
 #include "rest/ConnectionInfo.h"
 #include "rest/HttpStatusCode.h"
+#include "rest/mhd.h"
 
 
 
@@ -40,6 +41,14 @@ extern void restReply(ConnectionInfo* ciP, const std::string& answer);
 
 
 
+/* ****************************************************************************
+*
+* restReplyStream - 
+*/
+extern bool restReplyStream(ConnectionInfo* ciP, size_t blockSize, MHD_ContentReaderCallback reader, void* cls, MHD_ContentReaderFreeCallback release);
+
+
+
 /* ****************************************************************************
 *
 * restErrorReplyGet - 
@@ -281,6 +281,27 @@ std::string renderNotifQueueStats(void)
   jh.addNumber ("avgTimeInQueue", out==0 ? 0.0f : (timeInQ/out));
   jh.addNumber("size",           (long long)QueueStatistics::getQSize());
 
+  std::vector<NotifSubQueueInfo> subQueueV;
+  QueueStatistics::getSubQueues(&subQueueV);
+
+  if (subQueueV.size() > 0)
+  {
+    JsonHelper subQueues;
+
+    for (unsigned int ix = 0; ix < subQueueV.size(); ++ix)
+    {
+      JsonHelper subQueue;
+
+      subQueue.addNumber("in",     (long long) subQueueV[ix].in);
+      subQueue.addNumber("reject", (long long) subQueueV[ix].reject);
+      subQueue.addNumber("size",   (long long) subQueueV[ix].size);
+
+      subQueues.addRaw(subQueueV[ix].endpoint, subQueue.str());
+    }
+
+    jh.addRaw("subQueues", subQueues.str());
+  }
+
   return jh.str();
 }
 
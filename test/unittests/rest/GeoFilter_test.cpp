@@ -0,0 +1,229 @@
+/*
+*
+* Copyright 2021 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string>
+
+#include "gtest/gtest.h"
+#include "mongo/client/dbclient.h"
+
+#include "rest/GeoFilter.h"
+
+using mongo::BSONObj;
+
+
+
+/* ****************************************************************************
+*
+* point -
+*/
+static BSONObj point(double lon, double lat)
+{
+  return BSON("type" << "Point" << "coordinates" << BSON_ARRAY(lon << lat));
+}
+
+
+
+/* ****************************************************************************
+*
+* coveredBy -
+*/
+TEST(GeoFilter, coveredBy)
+{
+  GeoFilter    filter;
+  std::string  err;
+
+  // coords are lat,lon
+  EXPECT_TRUE(filter.fill("polygon", "0,0;0,10;10,10;10,0;0,0", "coveredBy", &err));
+
+  BSONObj inside  = point(5, 5);
+  BSONObj outside = point(11, 5);
+  BSONObj line    = BSON("type" << "LineString" << "coordinates" << BSON_ARRAY(BSON_ARRAY(-5 << 5) << BSON_ARRAY(15 << 5)));
+
+  EXPECT_TRUE(filter.match(&inside));
+  EXPECT_FALSE(filter.match(&outside));
+  EXPECT_FALSE(filter.match(&line));
+  EXPECT_FALSE(filter.match(NULL));
+}
+
+
+
+/* ****************************************************************************
+*
+* intersectsAndDisjoint -
+*/
+TEST(GeoFilter, intersectsAndDisjoint)
+{
+  GeoFilter    intersects;
+  GeoFilter    disjoint;
+  std::string  err;
+
+  EXPECT_TRUE(intersects.fill("box", "0,0;10,10", "intersects", &err));
+  EXPECT_TRUE(disjoint.fill("box", "0,0;10,10", "disjoint", &err));
+
+  BSONObj inside = point(5, 5);
+  BSONObj far    = point(50, 50);
+  BSONObj line   = BSON("type" << "LineString" << "coordinates" << BSON_ARRAY(BSON_ARRAY(-5 << 5) << BSON_ARRAY(15 << 5)));
+
+  EXPECT_TRUE(intersects.match(&inside));
+  EXPECT_TRUE(intersects.match(&line));
+  EXPECT_FALSE(intersects.match(&far));
+
+  EXPECT_FALSE(disjoint.match(&inside));
+  EXPECT_TRUE(disjoint.match(&far));
+
+  // No location - a match only for 'disjoint', like the mongo query { "$not": { "$geoIntersects": ... } }
+  EXPECT_TRUE(disjoint.match(NULL));
+  EXPECT_FALSE(intersects.match(NULL));
+}
+
+
+
+/* ****************************************************************************
+*
+* near -
+*/
+TEST(GeoFilter, near)
+{
+  GeoFilter    filter;
+  std::string  err;
+
+  EXPECT_TRUE(filter.fill("point", "40.4168,-3.7038", "near;maxDistance:1000", &err));
+
+  BSONObj close = point(-3.7038, 40.4208);   // some 445 meters to the north
+  BSONObj far   = point(-3.7038, 40.4368);   // more than 2 km
+
+  EXPECT_TRUE(filter.match(&close));
+  EXPECT_FALSE(filter.match(&far));
+
+  EXPECT_TRUE(filter.fill("point", "40.4168,-3.7038", "near;minDistance:1000", &err));
+  EXPECT_FALSE(filter.match(&close));
+  EXPECT_TRUE(filter.match(&far));
+}
+
+
+
+/* ****************************************************************************
+*
+* equals -
+*/
+TEST(GeoFilter, equals)
+{
+  GeoFilter    filter;
+  std::string  err;
+
+  EXPECT_TRUE(filter.fill("point", "40,-3", "equals", &err));
+
+  BSONObj same  = point(-3, 40);
+  BSONObj other = point(-3, 40.0001);
+
+  EXPECT_TRUE(filter.match(&same));
+  EXPECT_FALSE(filter.match(&other));
+}
+
+
+
+/* ****************************************************************************
+*
+* bboxGet -
+*/
+TEST(GeoFilter, bboxGet)
+{
+  GeoFilter     filter;
+  GeoFilterBox  bbox;
+  std::string   err;
+
+  EXPECT_TRUE(filter.fill("box", "0,0;0.05,0.08", "coveredBy", &err));
+  EXPECT_TRUE(filter.bboxGet(&bbox));
+  EXPECT_TRUE((bbox.minLon <= 0) && (bbox.minLon > -0.001) && (bbox.maxLon >= 0.08) && (bbox.maxLon < 0.081));
+  EXPECT_TRUE((bbox.minLat <= 0) && (bbox.minLat > -0.001) && (bbox.maxLat >= 0.05) && (bbox.maxLat < 0.051));
+
+  // Too big for the plane of lon/lat - the great-circle edges may go outside the box
+  EXPECT_TRUE(filter.fill("box", "0,0;10,20", "coveredBy", &err));
+  EXPECT_FALSE(filter.bboxGet(&bbox));
+
+  // 1000 meters is some 0.009 degrees of latitude, and some 0.012 degrees of longitude at 40 degrees of latitude
+  EXPECT_TRUE(filter.fill("point", "40.4168,-3.7038", "near;maxDistance:1000", &err));
+  EXPECT_TRUE(filter.bboxGet(&bbox));
+  EXPECT_TRUE((bbox.minLat < 40.4168 - 0.0089) && (bbox.maxLat > 40.4168 + 0.0089));
+  EXPECT_TRUE((bbox.minLon < -3.7038 - 0.0117) && (bbox.maxLon > -3.7038 + 0.0117));
+  EXPECT_TRUE((bbox.minLat > 40.4) && (bbox.maxLon < -3.6));
+
+  // Matching entities can be anywhere
+  EXPECT_TRUE(filter.fill("point", "40.4168,-3.7038", "near;minDistance:1000", &err));
+  EXPECT_FALSE(filter.bboxGet(&bbox));
+
+  EXPECT_TRUE(filter.fill("box", "0,0;10,20", "disjoint", &err));
+  EXPECT_FALSE(filter.bboxGet(&bbox));
+}
+
+
+
+/* ****************************************************************************
+*
+* exact - is the in-memory match the same as mongo's?
+*/
+TEST(GeoFilter, exact)
+{
+  GeoFilter    filter;
+  std::string  err;
+
+  BSONObj pointLocation = point(0.02, 0.02);
+  BSONObj smallLine     = BSON("type" << "LineString" << "coordinates" << BSON_ARRAY(BSON_ARRAY(0.01 << 0.01) << BSON_ARRAY(0.03 << 0.02)));
+  BSONObj bigLine       = BSON("type" << "LineString" << "coordinates" << BSON_ARRAY(BSON_ARRAY(0 << 60) << BSON_ARRAY(90 << 60)));
+
+  // Small area
+  EXPECT_TRUE(filter.fill("box", "0,0;0.05,0.05", "intersects", &err));
+  EXPECT_TRUE(filter.exact(&pointLocation));
+  EXPECT_TRUE(filter.exact(&smallLine));
+  EXPECT_TRUE(filter.exact(NULL));
+  EXPECT_FALSE(filter.exact(&bigLine));
+
+  // Big area
+  EXPECT_TRUE(filter.fill("box", "0,0;10,10", "intersects", &err));
+  EXPECT_FALSE(filter.exact(&pointLocation));
+
+  // Crossing the antimeridian
+  EXPECT_TRUE(filter.fill("polygon", "0,179.99;0.01,-179.99;0.02,179.99;0,179.99", "intersects", &err));
+  EXPECT_FALSE(filter.exact(&pointLocation));
+
+  // A point is the same in the plane and on the sphere, and distances are great-circle distances
+  EXPECT_TRUE(filter.fill("point", "60,0", "near;maxDistance:1000", &err));
+  EXPECT_TRUE(filter.exact(&pointLocation));
+  EXPECT_FALSE(filter.exact(&bigLine));
+}
+
+
+
+/* ****************************************************************************
+*
+* badInput -
+*/
+TEST(GeoFilter, badInput)
+{
+  GeoFilter    filter;
+  std::string  err;
+
+  EXPECT_FALSE(filter.fill("polygon", "0,0;0,10", "coveredBy", &err));
+  EXPECT_FALSE(filter.isSet());
+}